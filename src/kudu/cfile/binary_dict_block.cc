@@ -251,10 +251,17 @@ Status BinaryDictBlockDecoder::CopyNextDecodeStrings(size_t* n, ColumnDataView*
   BShufBlockDecoder<UINT32>* d_bptr = down_cast<BShufBlockDecoder<UINT32>*>(data_decoder_.get());
   RETURN_NOT_OK(d_bptr->CopyNextValuesToArray(n, codeword_buf_.data()));
 
+  // If the caller has retained the dictionary block for the lifetime of the
+  // batch, the cells can point directly into it.
+  bool copy = !dst->source_retained();
   for (int i = 0; i < *n; i++) {
     uint32_t codeword = *reinterpret_cast<uint32_t*>(&codeword_buf_[i*sizeof(uint32_t)]);
     Slice elem = dict_decoder_->string_at_index(codeword);
-    CHECK(out_arena->RelocateSlice(elem, out));
+    if (copy) {
+      CHECK(out_arena->RelocateSlice(elem, out));
+    } else {
+      *out = elem;
+    }
     out++;
   }
   return Status::OK();
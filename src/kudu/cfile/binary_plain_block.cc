@@ -271,15 +271,19 @@ Status BinaryPlainBlockDecoder::CopyNextValues(size_t *n, ColumnDataView *dst) {
 
   Slice *out = reinterpret_cast<Slice *>(dst->data());
   size_t i;
-  for (i = 0; i < max_fetch; i++) {
-    Slice elem(string_at_index(cur_idx_));
-
-    // TODO: in a lot of cases, we might be able to get away with the decoder
-    // owning it and not truly copying. But, we should extend the CopyNextValues
-    // API so that the caller can specify if they truly _need_ copies or not.
-    CHECK(out_arena->RelocateSlice(elem, out));
-    out++;
-    cur_idx_++;
+  if (dst->source_retained()) {
+    // The caller holds on to our block data for the lifetime of the batch,
+    // so the cells can point directly into it.
+    for (i = 0; i < max_fetch; i++) {
+      *out++ = string_at_index(cur_idx_++);
+    }
+  } else {
+    for (i = 0; i < max_fetch; i++) {
+      Slice elem(string_at_index(cur_idx_));
+      CHECK(out_arena->RelocateSlice(elem, out));
+      out++;
+      cur_idx_++;
+    }
   }
 
   *n = i;
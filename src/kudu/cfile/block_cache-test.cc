@@ -15,11 +15,20 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
+#include <string>
 
 #include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/ssd_block_cache.h"
 #include "kudu/util/cache.h"
+#include "kudu/util/env.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_int64(block_cache_ssd_admission_history_size);
+
+using std::string;
 
 namespace kudu {
 namespace cfile {
@@ -44,7 +53,7 @@ TEST(TestBlockCache, TestBasics) {
 
   // Insert and re-lookup
   BlockCacheHandle inserted_handle;
-  cache.Insert(&data, &inserted_handle);
+  cache.Insert(&data, &inserted_handle, Cache::NORMAL_PRIORITY);
   ASSERT_FALSE(data.valid());
   ASSERT_TRUE(inserted_handle.valid());
 
@@ -60,6 +69,101 @@ TEST(TestBlockCache, TestBasics) {
   ASSERT_FALSE(cache.Lookup(key1, Cache::EXPECT_IN_CACHE, &retrieved_handle));
 }
 
+class SsdBlockCacheTest : public KuduTest {
+ protected:
+  // Create a block cache with a small in-memory tier, so that blocks are
+  // evicted quickly, and an SSD tier.
+  void CreateCache(int64_t ssd_capacity) {
+    gscoped_ptr<SsdBlockCache> ssd;
+    ASSERT_OK(SsdBlockCache::Create(env_.get(), GetTestPath("ssd_cache"), ssd_capacity, &ssd));
+    ssd_ = ssd.get();
+    cache_.reset(new BlockCache(64 * 1024, std::move(ssd)));
+  }
+
+  void InsertBlock(uint64_t offset, const string& data) {
+    BlockCache::CacheKey key(BlockCache::FileId(1234), offset);
+    BlockCache::PendingEntry entry = cache_->Allocate(key, data.size());
+    ASSERT_TRUE(entry.valid());
+    memcpy(entry.val_ptr(), data.data(), data.size());
+    BlockCacheHandle handle;
+    cache_->Insert(&entry, &handle, Cache::NORMAL_PRIORITY);
+  }
+
+  // Insert enough blocks at other offsets to evict everything else.
+  void EvictAll(uint64_t first_offset) {
+    for (int i = 0; i < 1000; i++) {
+      ASSERT_NO_FATAL_FAILURE(InsertBlock(first_offset + i, string(1024, 'x')));
+    }
+  }
+
+  bool LookupBlock(uint64_t offset, string* data) {
+    BlockCache::CacheKey key(BlockCache::FileId(1234), offset);
+    BlockCacheHandle handle;
+    if (!cache_->Lookup(key, Cache::EXPECT_IN_CACHE, &handle)) {
+      return false;
+    }
+    *data = handle.data().ToString();
+    return true;
+  }
+
+  gscoped_ptr<BlockCache> cache_;
+  SsdBlockCache* ssd_;
+};
+
+TEST_F(SsdBlockCacheTest, TestFallThroughToSsd) {
+  FLAGS_block_cache_ssd_admission_history_size = 0;
+  ASSERT_NO_FATAL_FAILURE(CreateCache(16 * 1024 * 1024));
+
+  ASSERT_NO_FATAL_FAILURE(InsertBlock(1, DATA_TO_CACHE));
+  ASSERT_NO_FATAL_FAILURE(EvictAll(1000000));
+  ssd_->WaitForPendingWrites();
+
+  // The block is no longer in memory, but is read back from the SSD tier.
+  string data;
+  ASSERT_TRUE(LookupBlock(1, &data));
+  ASSERT_EQ(DATA_TO_CACHE, data);
+
+  // A block which was never inserted misses in both tiers.
+  ASSERT_FALSE(LookupBlock(2, &data));
+}
+
+TEST_F(SsdBlockCacheTest, TestAdmitOnReReference) {
+  FLAGS_block_cache_ssd_admission_history_size = 10000;
+  ASSERT_NO_FATAL_FAILURE(CreateCache(16 * 1024 * 1024));
+  string data;
+
+  // The first time the block is evicted, it is only remembered.
+  ASSERT_NO_FATAL_FAILURE(InsertBlock(1, DATA_TO_CACHE));
+  ASSERT_NO_FATAL_FAILURE(EvictAll(1000000));
+  ssd_->WaitForPendingWrites();
+  ASSERT_FALSE(LookupBlock(1, &data));
+
+  // After being read back in and evicted again, it is admitted.
+  ASSERT_NO_FATAL_FAILURE(InsertBlock(1, DATA_TO_CACHE));
+  ASSERT_NO_FATAL_FAILURE(EvictAll(2000000));
+  ssd_->WaitForPendingWrites();
+  ASSERT_TRUE(LookupBlock(1, &data));
+  ASSERT_EQ(DATA_TO_CACHE, data);
+}
+
+TEST_F(SsdBlockCacheTest, TestWrapAround) {
+  FLAGS_block_cache_ssd_admission_history_size = 0;
+  // Room for only a few hundred of the evicted blocks.
+  ASSERT_NO_FATAL_FAILURE(CreateCache(256 * 1024));
+
+  ASSERT_NO_FATAL_FAILURE(InsertBlock(1, DATA_TO_CACHE));
+  for (int i = 0; i < 5; i++) {
+    ASSERT_NO_FATAL_FAILURE(EvictAll(1000000 * (i + 1)));
+    ssd_->WaitForPendingWrites();
+  }
+
+  // The oldest block has been overwritten as the log wrapped around, while
+  // the most recent ones are still readable.
+  string data;
+  ASSERT_FALSE(LookupBlock(1, &data));
+  ASSERT_TRUE(LookupBlock(5000000 + 800, &data));
+  ASSERT_EQ(string(1024, 'x'), data);
+}
 
 } // namespace cfile
 } // namespace kudu
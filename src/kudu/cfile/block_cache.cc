@@ -18,10 +18,13 @@
 #include <gflags/gflags.h>
 
 #include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/ssd_block_cache.h"
 #include "kudu/gutil/port.h"
 #include "kudu/util/cache.h"
+#include "kudu/util/env.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/string_case.h"
 
@@ -35,6 +38,47 @@ DEFINE_string(block_cache_type, "DRAM",
               "in a memory-mapped file using the NVML library.");
 TAG_FLAG(block_cache_type, experimental);
 
+DEFINE_double(block_cache_high_priority_pool_ratio, 0.2,
+              "Fraction of the block cache capacity reserved for index, bloom filter "
+              "and dictionary blocks. Blocks in this pool are only evicted by other "
+              "blocks of these types, so that large scans do not push them out of the "
+              "cache. Only supported by the DRAM block cache.");
+TAG_FLAG(block_cache_high_priority_pool_ratio, advanced);
+TAG_FLAG(block_cache_high_priority_pool_ratio, experimental);
+
+static bool ValidateHighPriorityPoolRatio(const char* flagname, double value) {
+  if (value < 0 || value > 1) {
+    LOG(ERROR) << "Invalid value for " << flagname << ": " << value
+               << " (must be between 0 and 1)";
+    return false;
+  }
+  return true;
+}
+static bool dummy = google::RegisterFlagValidator(
+    &FLAGS_block_cache_high_priority_pool_ratio, &ValidateHighPriorityPoolRatio);
+
+DEFINE_string(block_cache_ssd_path, "",
+              "Path of a file on a local SSD to use as a secondary tier of the block "
+              "cache. Blocks evicted from the in-memory block cache which are read "
+              "repeatedly are written to this file, and later lookups which miss in "
+              "memory are served from it instead of from the data directories. "
+              "The file is recreated on startup. If empty, no SSD tier is used.");
+TAG_FLAG(block_cache_ssd_path, experimental);
+
+DEFINE_int64(block_cache_ssd_capacity_mb, 10 * 1024,
+             "Size of the SSD tier of the block cache in MB. Only used if "
+             "--block_cache_ssd_path is set.");
+TAG_FLAG(block_cache_ssd_capacity_mb, experimental);
+
+METRIC_DEFINE_histogram(server, block_cache_dram_lookup_latency,
+                        "Block Cache Lookup Latency",
+                        kudu::MetricUnit::kNanoseconds,
+                        "Time taken to look a block up in the in-memory block cache, "
+                        "whether or not it was found",
+                        1000000000, 2);
+
+using std::vector;
+
 namespace kudu {
 
 class MetricEntity;
@@ -54,17 +98,42 @@ Cache* CreateCache(int64_t capacity) {
     LOG(FATAL) << "Unknown block cache type: '" << FLAGS_block_cache_type
                << "' (expected 'DRAM' or 'NVM')";
   }
-  return NewLRUCache(t, capacity, "block_cache");
+  return NewLRUCache(t, capacity, "block_cache", FLAGS_block_cache_high_priority_pool_ratio);
+}
+
+gscoped_ptr<SsdBlockCache> CreateSsdCache() {
+  gscoped_ptr<SsdBlockCache> ssd_cache;
+  if (!FLAGS_block_cache_ssd_path.empty()) {
+    Status s = SsdBlockCache::Create(Env::Default(), FLAGS_block_cache_ssd_path,
+                                     FLAGS_block_cache_ssd_capacity_mb * 1024 * 1024,
+                                     &ssd_cache);
+    if (!s.ok()) {
+      LOG(WARNING) << "Unable to create SSD block cache tier, continuing without it: "
+                   << s.ToString();
+    }
+  }
+  return ssd_cache.Pass();
 }
 
 } // anonymous namespace
 
 BlockCache::BlockCache()
-  : BlockCache(FLAGS_block_cache_capacity_mb * 1024 * 1024) {
+  : BlockCache(FLAGS_block_cache_capacity_mb * 1024 * 1024, CreateSsdCache()) {
 }
 
+__thread bool ScopedScanDiskReads::in_scan_ = false;
+
 BlockCache::BlockCache(size_t capacity)
-  : cache_(CreateCache(capacity)) {
+  : BlockCache(capacity, gscoped_ptr<SsdBlockCache>()) {
+}
+
+BlockCache::BlockCache(size_t capacity, gscoped_ptr<SsdBlockCache> ssd_cache)
+  : ssd_cache_(std::move(ssd_cache)),
+    cache_(CreateCache(capacity)),
+    scan_disk_reads_(0) {
+}
+
+BlockCache::~BlockCache() {
 }
 
 BlockCache::PendingEntry BlockCache::Allocate(const CacheKey& key, size_t val_size) {
@@ -75,22 +144,72 @@ BlockCache::PendingEntry BlockCache::Allocate(const CacheKey& key, size_t val_si
 
 bool BlockCache::Lookup(const CacheKey& key, Cache::CacheBehavior behavior,
                         BlockCacheHandle *handle) {
+  MonoTime start;
+  if (dram_lookup_latency_) {
+    start = MonoTime::Now(MonoTime::FINE);
+  }
   Cache::Handle *h = cache_->Lookup(Slice(reinterpret_cast<const uint8_t*>(&key),
                                           sizeof(key)), behavior);
+  if (dram_lookup_latency_) {
+    dram_lookup_latency_->Increment(
+        MonoTime::Now(MonoTime::FINE).GetDeltaSince(start).ToNanoseconds());
+  }
   if (h != nullptr) {
     handle->SetHandle(cache_.get(), h);
+    return true;
+  }
+  if (ssd_cache_ && behavior == Cache::EXPECT_IN_CACHE) {
+    return LookupInSsdTier(key, handle);
+  }
+  return false;
+}
+
+bool BlockCache::LookupInSsdTier(const CacheKey& key, BlockCacheHandle* handle) {
+  PendingEntry entry;
+  bool found = ssd_cache_->Lookup(
+      Slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key)),
+      [&](size_t size) -> uint8_t* {
+        entry = Allocate(key, size);
+        return entry.valid() ? entry.val_ptr() : nullptr;
+      });
+  if (!found) {
+    return false;
   }
-  return h != nullptr;
+  // The priority class of the block isn't known here, so it is promoted as a
+  // normal block. If it is a high-priority block, the next read which misses
+  // in the cache will re-insert it at its own priority.
+  Insert(&entry, handle, Cache::NORMAL_PRIORITY);
+  return true;
 }
 
-void BlockCache::Insert(BlockCache::PendingEntry* entry, BlockCacheHandle* inserted) {
-  Cache::Handle *h = cache_->Insert(entry->handle_, /* eviction_callback= */ nullptr);
+void BlockCache::Insert(BlockCache::PendingEntry* entry, BlockCacheHandle* inserted,
+                        Cache::Priority priority) {
+  Cache::Handle *h = cache_->Insert(entry->handle_, ssd_cache_.get(), priority);
   entry->handle_ = nullptr;
   inserted->SetHandle(cache_.get(), h);
 }
 
+void BlockCache::GetRecentlyUsedBlocks(size_t max_blocks,
+                                       vector<CachedBlockInfo>* blocks) {
+  vector<Cache::EntryInfo> entries;
+  cache_->GetRecentlyUsedEntries(max_blocks, &entries);
+  for (const Cache::EntryInfo& entry : entries) {
+    if (PREDICT_FALSE(entry.key.size() != sizeof(CacheKey))) {
+      LOG(DFATAL) << "Unexpected block cache key of size " << entry.key.size();
+      continue;
+    }
+    CacheKey key(FileId(0), 0);
+    memcpy(&key, entry.key.data(), sizeof(key));
+    blocks->push_back({ FileId(key.file_id_), key.offset_, entry.value_size, entry.priority });
+  }
+}
+
 void BlockCache::StartInstrumentation(const scoped_refptr<MetricEntity>& metric_entity) {
   cache_->SetMetrics(metric_entity);
+  dram_lookup_latency_ = METRIC_block_cache_dram_lookup_latency.Instantiate(metric_entity);
+  if (ssd_cache_) {
+    ssd_cache_->StartInstrumentation(metric_entity);
+  }
 }
 
 } // namespace cfile
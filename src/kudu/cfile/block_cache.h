@@ -19,25 +19,35 @@
 
 #include <algorithm>
 #include <glog/logging.h>
+#include <vector>
 
 #include "kudu/fs/block_id.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/singleton.h"
+#include "kudu/util/atomic.h"
 #include "kudu/util/cache.h"
 
 DECLARE_string(block_cache_type);
 
 namespace kudu {
 
+class Histogram;
 class MetricRegistry;
 
 namespace cfile {
 
 class BlockCacheHandle;
+class SsdBlockCache;
 
 // Wrapper around kudu::Cache specifically for caching blocks of CFiles.
 // Provides a singleton and LRU cache for CFile blocks.
+//
+// If --block_cache_ssd_path is set, blocks evicted from the in-memory cache
+// may be written to a secondary tier on local SSD (see SsdBlockCache).
+// Lookups which miss the in-memory cache then fall through to the SSD tier
+// before the caller reads the block from its file.
 class BlockCache {
  public:
   // BlockId refers to the unique identifier for a Kudu block, that is, for an
@@ -111,8 +121,16 @@ class BlockCache {
 
   explicit BlockCache(size_t capacity);
 
+  // Create a block cache with an SSD tier. 'ssd_cache' may be NULL.
+  BlockCache(size_t capacity, gscoped_ptr<SsdBlockCache> ssd_cache);
+
+  ~BlockCache();
+
   // Lookup the given block in the cache.
   //
+  // If the block isn't in memory but is in the SSD tier, and the caller
+  // expects it to be cached, it is read back into memory.
+  //
   // If the entry is found, then sets *handle to refer to the entry.
   // This object's destructor will release the cache entry so it may be freed again.
   // Alternatively,  handle->Release() may be used to explicitly release it.
@@ -143,14 +161,42 @@ class BlockCache {
   //   RETURN_NOT_OK(ReadDataFromDiskIntoBuffer(entry.val_ptr()));
   //   // "Commit" the entry to the cache
   //   BlockCacheHandle bch;
-  //   cache->Insert(&entry, &bch);
+  //   cache->Insert(&entry, &bch, Cache::NORMAL_PRIORITY);
 
   // Allocate a new entry to be inserted into the cache.
   PendingEntry Allocate(const CacheKey& key, size_t block_size);
 
+  // Description of a block in the cache. See GetRecentlyUsedBlocks().
+  struct CachedBlockInfo {
+    FileId file_id;
+    uint64_t offset;
+    // The size of the block's data in the cache, after decompression.
+    size_t size;
+    Cache::Priority priority;
+  };
+
+  // Appends to 'blocks' the descriptions of up to 'max_blocks' of the most
+  // recently used blocks in the in-memory cache, most recently used first.
+  void GetRecentlyUsedBlocks(size_t max_blocks, std::vector<CachedBlockInfo>* blocks);
+
+  // Records that a block was read from disk by a client scan, rather than by
+  // a write, a flush, a compaction or the cache warm-up.
+  void RecordScanDiskRead() {
+    scan_disk_reads_.Increment();
+  }
+
+  // Returns the number of blocks read from disk by client scans since the
+  // cache was created.
+  int64_t scan_disk_reads() const {
+    return scan_disk_reads_.Load();
+  }
+
   // Insert the given block into the cache. 'inserted' is set to refer to the
   // entry in the cache.
-  void Insert(PendingEntry* entry, BlockCacheHandle* inserted);
+  //
+  // 'priority' is the priority class of the block: see
+  // --block_cache_high_priority_pool_ratio.
+  void Insert(PendingEntry* entry, BlockCacheHandle* inserted, Cache::Priority priority);
 
  private:
   friend class Singleton<BlockCache>;
@@ -158,7 +204,46 @@ class BlockCache {
 
   DISALLOW_COPY_AND_ASSIGN(BlockCache);
 
+  // Look up the given block in the SSD tier, and if found, insert it into the
+  // in-memory cache and set 'handle' to refer to it.
+  bool LookupInSsdTier(const CacheKey& key, BlockCacheHandle* handle);
+
+  // Declared before 'cache_' so that it outlives it, since 'cache_' calls
+  // back into it as entries are evicted on destruction.
+  gscoped_ptr<SsdBlockCache> ssd_cache_;
+
   gscoped_ptr<Cache> cache_;
+
+  // Time taken by lookups in the in-memory cache. Set by
+  // StartInstrumentation().
+  scoped_refptr<Histogram> dram_lookup_latency_;
+
+  AtomicInt<int64_t> scan_disk_reads_;
+};
+
+// While in scope, the blocks which the current thread reads from disk are
+// counted as read by a client scan: see BlockCache::RecordScanDiskRead().
+class ScopedScanDiskReads {
+ public:
+  ScopedScanDiskReads() : outer_in_scan_(in_scan_) {
+    in_scan_ = true;
+  }
+
+  ~ScopedScanDiskReads() {
+    in_scan_ = outer_in_scan_;
+  }
+
+  // Returns true if the current thread is within a scan.
+  static bool InScan() {
+    return in_scan_;
+  }
+
+ private:
+  static __thread bool in_scan_;
+
+  const bool outer_in_scan_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedScanDiskReads);
 };
 
 // Scoped reference to a block from the block cache.
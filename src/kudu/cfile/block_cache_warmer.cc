@@ -0,0 +1,299 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/block_cache_warmer.h"
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/cfile.pb.h"
+#include "kudu/cfile/cfile_reader.h"
+#include "kudu/fs/block_manager.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/env.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/pb_util.h"
+#include "kudu/util/thread.h"
+
+DEFINE_int32(block_cache_warmup_max_blocks, 100000,
+             "Maximum number of the most recently used blocks of the block cache "
+             "whose location is saved, to be read back into the cache after a restart.");
+TAG_FLAG(block_cache_warmup_max_blocks, advanced);
+
+DEFINE_int32(block_cache_warmup_save_interval_secs, 300,
+             "Interval at which the locations of the most recently used blocks of the "
+             "block cache are saved.");
+TAG_FLAG(block_cache_warmup_save_interval_secs, advanced);
+
+DEFINE_int32(block_cache_warmup_max_mb_per_sec, 20,
+             "Maximum rate at which blocks are read from disk to warm the block cache "
+             "up after a restart. 0 disables the limit.");
+TAG_FLAG(block_cache_warmup_max_mb_per_sec, advanced);
+
+DEFINE_int32(block_cache_warmup_cancel_scan_reads_per_sec, 200,
+             "The block cache warm-up is cancelled if client scans read more than "
+             "this many blocks per second from disk, so that it does not compete "
+             "with them for I/O. 0 disables cancellation.");
+TAG_FLAG(block_cache_warmup_cancel_scan_reads_per_sec, advanced);
+
+using kudu::fs::ReadableBlock;
+using std::string;
+using std::unordered_map;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+const char* BlockCacheWarmer::StateToString(State state) {
+  switch (state) {
+    case NOT_STARTED: return "not started";
+    case RUNNING: return "running";
+    case FINISHED: return "finished";
+    case CANCELLED: return "cancelled";
+  }
+  LOG(FATAL) << "Unknown state: " << state;
+  return "";
+}
+
+BlockCacheWarmer::BlockCacheWarmer(fs::BlockManager* block_manager, Env* env, string path)
+  : block_manager_(block_manager),
+    env_(env),
+    path_(std::move(path)),
+    shutdown_cv_(&lock_),
+    shutdown_(false),
+    progress_({ NOT_STARTED, 0, 0, 0, 0, MonoDelta::FromSeconds(0) }) {
+}
+
+BlockCacheWarmer::~BlockCacheWarmer() {
+  Shutdown();
+}
+
+Status BlockCacheWarmer::Start() {
+  return Thread::Create("cfile", "block-cache-warmer",
+                        &BlockCacheWarmer::RunThread, this, &thread_);
+}
+
+void BlockCacheWarmer::Shutdown() {
+  {
+    MutexLock l(lock_);
+    if (shutdown_) {
+      return;
+    }
+    shutdown_ = true;
+    shutdown_cv_.Broadcast();
+  }
+  if (thread_) {
+    CHECK_OK(ThreadJoiner(thread_.get()).Join());
+  }
+}
+
+void BlockCacheWarmer::RunThread() {
+  WARN_NOT_OK(WarmUp(), "Unable to warm the block cache up");
+  while (true) {
+    MonoTime next_save = MonoTime::Now(MonoTime::FINE);
+    next_save.AddDelta(MonoDelta::FromSeconds(FLAGS_block_cache_warmup_save_interval_secs));
+    if (!WaitUntil(next_save)) {
+      break;
+    }
+    WARN_NOT_OK(SaveRecentlyUsedBlocks(), "Unable to save the block cache contents");
+  }
+
+  // Don't replace the list of blocks with the contents of a cache which was
+  // only partially warmed up.
+  if (GetProgress().state != RUNNING) {
+    WARN_NOT_OK(SaveRecentlyUsedBlocks(), "Unable to save the block cache contents");
+  }
+}
+
+bool BlockCacheWarmer::WaitUntil(const MonoTime& deadline) {
+  MutexLock l(lock_);
+  while (!shutdown_) {
+    MonoDelta remaining = deadline.GetDeltaSince(MonoTime::Now(MonoTime::FINE));
+    if (remaining.ToMicroseconds() <= 0) {
+      return true;
+    }
+    shutdown_cv_.TimedWait(remaining);
+  }
+  return false;
+}
+
+Status BlockCacheWarmer::WarmUp() {
+  BlockCacheWarmupPB pb;
+  Status s = pb_util::ReadPBContainerFromPath(env_, path_, &pb);
+  if (s.IsNotFound()) {
+    return Status::OK();
+  }
+  RETURN_NOT_OK_PREPEND(s, Substitute("Unable to read block cache warm-up file $0", path_));
+
+  // Read the blocks file by file, so that each file is only opened once,
+  // starting with the file of the most recently used block.
+  vector<uint64_t> file_order;
+  unordered_map<uint64_t, vector<const BlockCacheWarmupPB::EntryPB*>> entries_by_file;
+  for (const BlockCacheWarmupPB::EntryPB& entry : pb.entries()) {
+    vector<const BlockCacheWarmupPB::EntryPB*>& entries = entries_by_file[entry.block_id()];
+    if (entries.empty()) {
+      file_order.push_back(entry.block_id());
+    }
+    entries.push_back(&entry);
+  }
+
+  {
+    MutexLock l(lock_);
+    progress_.state = RUNNING;
+    progress_.blocks_total = pb.entries_size();
+    start_time_ = MonoTime::Now(MonoTime::FINE);
+  }
+  LOG(INFO) << Substitute("Warming the block cache up with $0 blocks from $1 files",
+                          pb.entries_size(), file_order.size());
+
+  BlockCache* cache = BlockCache::GetSingleton();
+  const int64_t max_bytes_per_sec =
+      static_cast<int64_t>(FLAGS_block_cache_warmup_max_mb_per_sec) * 1024 * 1024;
+  MonoTime start = MonoTime::Now(MonoTime::FINE);
+  int64_t bytes_read = 0;
+  MonoTime window_start = start;
+  int64_t window_start_scan_reads = cache->scan_disk_reads();
+  State final_state = FINISHED;
+
+  for (uint64_t file_id : file_order) {
+    const vector<const BlockCacheWarmupPB::EntryPB*>& entries =
+        FindOrDie(entries_by_file, file_id);
+
+    gscoped_ptr<ReadableBlock> block;
+    gscoped_ptr<CFileReader> reader;
+    s = block_manager_->OpenBlock(BlockId(file_id), &block);
+    if (s.ok()) {
+      s = CFileReader::Open(std::move(block), ReaderOptions(), &reader);
+    }
+    if (!s.ok()) {
+      // The file was most likely deleted by a compaction since the list was
+      // saved.
+      VLOG(1) << "Skipping block cache warm-up of " << BlockId(file_id).ToString()
+              << ": " << s.ToString();
+      MutexLock l(lock_);
+      progress_.blocks_skipped += entries.size();
+      continue;
+    }
+
+    for (const BlockCacheWarmupPB::EntryPB* entry : entries) {
+      MonoTime now = MonoTime::Now(MonoTime::FINE);
+
+      // Give way to client scans reading from disk.
+      MonoDelta window = now.GetDeltaSince(window_start);
+      if (window.ToSeconds() >= 1) {
+        int64_t scan_reads = cache->scan_disk_reads();
+        if (FLAGS_block_cache_warmup_cancel_scan_reads_per_sec > 0 &&
+            (scan_reads - window_start_scan_reads) / window.ToSeconds() >
+            FLAGS_block_cache_warmup_cancel_scan_reads_per_sec) {
+          final_state = CANCELLED;
+          break;
+        }
+        window_start = now;
+        window_start_scan_reads = scan_reads;
+      }
+
+      // Throttle the reads to the configured bandwidth.
+      if (max_bytes_per_sec > 0) {
+        MonoTime next_read = start;
+        next_read.AddDelta(
+            MonoDelta::FromMicroseconds(bytes_read * 1000000 / max_bytes_per_sec));
+        if (!WaitUntil(next_read)) {
+          return Status::Aborted("Block cache warm-up interrupted by shutdown");
+        }
+      } else {
+        MutexLock l(lock_);
+        if (shutdown_) {
+          return Status::Aborted("Block cache warm-up interrupted by shutdown");
+        }
+      }
+
+      size_t block_bytes_read;
+      s = reader->PrefetchBlock(entry->offset(), entry->cached_size(),
+                                entry->high_priority() ? Cache::HIGH_PRIORITY :
+                                                         Cache::NORMAL_PRIORITY,
+                                &block_bytes_read);
+      bytes_read += block_bytes_read;
+      MutexLock l(lock_);
+      progress_.bytes_read = bytes_read;
+      if (s.ok()) {
+        progress_.blocks_warmed++;
+      } else {
+        VLOG(1) << "Skipping block cache warm-up of block at offset " << entry->offset()
+                << " of " << reader->ToString() << ": " << s.ToString();
+        progress_.blocks_skipped++;
+      }
+    }
+    if (final_state == CANCELLED) {
+      break;
+    }
+  }
+
+  Progress progress;
+  {
+    MutexLock l(lock_);
+    progress_.state = final_state;
+    end_time_ = MonoTime::Now(MonoTime::FINE);
+    progress_.elapsed = end_time_.GetDeltaSince(start_time_);
+    progress = progress_;
+  }
+  LOG(INFO) << Substitute("Block cache warm-up $0 after $1: read $2 blocks ($3 bytes), "
+                          "skipped $4 blocks",
+                          StateToString(progress.state), progress.elapsed.ToString(),
+                          progress.blocks_warmed, progress.bytes_read,
+                          progress.blocks_skipped);
+  return Status::OK();
+}
+
+Status BlockCacheWarmer::SaveRecentlyUsedBlocks() {
+  vector<BlockCache::CachedBlockInfo> blocks;
+  BlockCache::GetSingleton()->GetRecentlyUsedBlocks(FLAGS_block_cache_warmup_max_blocks,
+                                                    &blocks);
+  BlockCacheWarmupPB pb;
+  for (const BlockCache::CachedBlockInfo& block : blocks) {
+    BlockCacheWarmupPB::EntryPB* entry = pb.add_entries();
+    entry->set_block_id(block.file_id.id());
+    entry->set_offset(block.offset);
+    entry->set_cached_size(block.size);
+    if (block.priority == Cache::HIGH_PRIORITY) {
+      entry->set_high_priority(true);
+    }
+  }
+  RETURN_NOT_OK_PREPEND(pb_util::WritePBContainerToPath(env_, path_, pb,
+                                                        pb_util::OVERWRITE,
+                                                        pb_util::NO_SYNC),
+                        Substitute("Unable to write block cache warm-up file $0", path_));
+  VLOG(1) << "Saved the locations of " << blocks.size() << " cached blocks to " << path_;
+  return Status::OK();
+}
+
+BlockCacheWarmer::Progress BlockCacheWarmer::GetProgress() const {
+  MutexLock l(lock_);
+  Progress progress = progress_;
+  if (progress.state == RUNNING) {
+    progress.elapsed = MonoTime::Now(MonoTime::FINE).GetDeltaSince(start_time_);
+  }
+  return progress;
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,137 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CFILE_BLOCK_CACHE_WARMER_H
+#define KUDU_CFILE_BLOCK_CACHE_WARMER_H
+
+#include <string>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Env;
+class Thread;
+
+namespace fs {
+class BlockManager;
+} // namespace fs
+
+namespace cfile {
+
+// Warms the block cache up after a restart.
+//
+// While the server runs, the ids and offsets of the most recently used
+// blocks of the block cache are periodically written to a file (and once
+// more at shutdown). When the warmer is next started, it reads the blocks
+// listed in this file back into the cache in the background, through the
+// block manager, before resuming the periodic saves.
+//
+// The warm-up reads at most --block_cache_warmup_max_mb_per_sec, and is
+// cancelled as soon as client scans read blocks from disk at more than
+// --block_cache_warmup_cancel_scan_reads_per_sec, so that it doesn't
+// compete with real traffic for I/O.
+class BlockCacheWarmer {
+ public:
+  enum State {
+    NOT_STARTED,
+    RUNNING,
+    FINISHED,
+    CANCELLED
+  };
+
+  static const char* StateToString(State state);
+
+  // Progress of the warm-up, as shown in the web UI.
+  struct Progress {
+    State state;
+
+    // Number of blocks listed in the warm-up file.
+    int64_t blocks_total;
+
+    // Number of blocks which were read into the cache, or found already
+    // there.
+    int64_t blocks_warmed;
+
+    // Number of blocks which could not be read, e.g. because their file has
+    // since been deleted.
+    int64_t blocks_skipped;
+
+    int64_t bytes_read;
+
+    // Time since the warm-up started, or its duration once it has ended.
+    MonoDelta elapsed;
+  };
+
+  // Create a warmer which reads blocks through 'block_manager', and keeps
+  // the list of blocks to warm up in the file at 'path'.
+  BlockCacheWarmer(fs::BlockManager* block_manager, Env* env, std::string path);
+
+  ~BlockCacheWarmer();
+
+  // Start the background thread, which first warms the cache up and then
+  // periodically saves the most recently used blocks.
+  Status Start();
+
+  // Stop the background thread, saving the most recently used blocks one
+  // last time unless the warm-up was interrupted.
+  void Shutdown();
+
+  // Read the blocks listed in the warm-up file into the block cache. Returns
+  // OK if there is no warm-up file. Called by the background thread, and
+  // directly by tests.
+  Status WarmUp();
+
+  // Write the most recently used blocks of the block cache to the warm-up
+  // file. Called by the background thread, and directly by tests.
+  Status SaveRecentlyUsedBlocks();
+
+  Progress GetProgress() const;
+
+ private:
+  void RunThread();
+
+  // Wait until 'deadline' or until the warmer is shut down. Returns false if
+  // the warmer is shut down.
+  bool WaitUntil(const MonoTime& deadline);
+
+  fs::BlockManager* const block_manager_;
+  Env* const env_;
+  const std::string path_;
+
+  // Protects all of the fields below.
+  mutable Mutex lock_;
+  ConditionVariable shutdown_cv_;
+  bool shutdown_;
+
+  Progress progress_;
+  MonoTime start_time_;
+  MonoTime end_time_;
+
+  scoped_refptr<Thread> thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockCacheWarmer);
+};
+
+} // namespace cfile
+} // namespace kudu
+
+#endif
@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <list>
 
+#include "kudu/cfile/block_cache_warmer.h"
 #include "kudu/cfile/cfile-test-base.h"
 #include "kudu/cfile/cfile_reader.h"
 #include "kudu/cfile/cfile_writer.h"
@@ -31,9 +32,12 @@
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/pb_util.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/stopwatch.h"
 
+DECLARE_int32(block_cache_warmup_cancel_scan_reads_per_sec);
+DECLARE_int32(block_cache_warmup_max_mb_per_sec);
 DECLARE_string(block_cache_type);
 DECLARE_string(cfile_do_on_finish);
 
@@ -245,7 +249,8 @@ class TestCFile : public CFileTestBase {
     do {
       BlockHandle dblk_data;
       BlockPointer blk_ptr = iter->GetCurrentBlockPointer();
-      ASSERT_OK(reader->ReadBlock(blk_ptr, CFileReader::CACHE_BLOCK, &dblk_data));
+      ASSERT_OK(reader->ReadBlock(blk_ptr, CFileReader::CACHE_BLOCK,
+                                  CFileReader::DATA_BLOCK, &dblk_data));
 
       memcpy(data + 12, &count, 4);
       ASSERT_EQ(expected_data, dblk_data.data());
@@ -619,6 +624,47 @@ TEST_P(TestCFileBothCacheTypes, TestReadWriteLargeStrings) {
 #endif
 
 // Test that metadata entries stored in the cfile are persisted.
+// Test that string cells scanned into a block which can retain references
+// point into the retained source blocks rather than the arena, and remain
+// valid after the iterator which produced them is gone.
+TEST_P(TestCFileBothCacheTypes, TestZeroCopyStringScan) {
+  for (EncodingType encoding : { PLAIN_ENCODING, DICT_ENCODING }) {
+    SCOPED_TRACE(encoding);
+    const int nrows = 1000;
+    BlockId block_id;
+    StringDataGenerator<false> generator("hello %04d");
+    WriteTestFile(&generator, encoding, NO_COMPRESSION, nrows, SMALL_BLOCKSIZE, &block_id);
+
+    gscoped_ptr<ReadableBlock> block;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+    gscoped_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+    gscoped_ptr<CFileIterator> iter;
+    ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK));
+    ASSERT_OK(iter->SeekToFirst());
+
+    Arena arena(1024, 1024 * 1024);
+    RowBlockRefs refs;
+    gscoped_ptr<Slice[]> cells(new Slice[nrows]);
+    ColumnBlock cb(GetTypeInfo(STRING), nullptr, cells.get(), nrows, &arena, &refs);
+    size_t arena_footprint = arena.memory_footprint();
+    size_t n = nrows;
+    ASSERT_OK(iter->CopyNextValues(&n, &cb));
+    ASSERT_EQ(nrows, n);
+    ASSERT_GT(refs.size(), 0);
+
+    // Nothing should have been copied into the arena, and the cells should
+    // still be readable with the iterator and reader gone.
+    iter.reset();
+    reader.reset();
+    for (int i = 0; i < nrows; i++) {
+      ASSERT_EQ(StringPrintf("hello %04d", i), cells[i].ToString());
+    }
+    ASSERT_EQ(arena_footprint, arena.memory_footprint());
+    refs.Reset();
+  }
+}
+
 TEST_P(TestCFileBothCacheTypes, TestMetadata) {
   BlockId block_id;
 
@@ -847,6 +893,7 @@ TEST_P(TestCFileBothCacheTypes, TestCacheKeysAreStable) {
     BlockHandle bh;
     ASSERT_OK(reader->ReadBlock(iter->GetCurrentBlockPointer(),
                                 CFileReader::CACHE_BLOCK,
+                                CFileReader::INDEX_BLOCK,
                                 &bh));
 
     // The first time through, we miss in the seek and in the ReadBlock().
@@ -857,6 +904,80 @@ TEST_P(TestCFileBothCacheTypes, TestCacheKeysAreStable) {
   }
 }
 
+// Tests that the block cache warmer reads the blocks listed in its file into
+// the cache, and saves the most recently used blocks.
+TEST_P(TestCFileBothCacheTypes, TestBlockCacheWarmUp) {
+  FLAGS_block_cache_warmup_max_mb_per_sec = 0;
+  FLAGS_block_cache_warmup_cancel_scan_reads_per_sec = 0;
+  BlockCache* cache = BlockCache::GetSingleton();
+  const string path = GetTestPath("block_cache_warmup");
+
+  for (CompressionType compression : { NO_COMPRESSION, SNAPPY }) {
+    BlockId block_id;
+    UInt32DataGenerator<false> generator;
+    WriteTestFile(&generator, PLAIN_ENCODING, compression, 10000, SMALL_BLOCKSIZE, &block_id);
+
+    // List the file's data blocks without caching them.
+    gscoped_ptr<ReadableBlock> source;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+    gscoped_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+    gscoped_ptr<IndexTreeIterator> iter(
+        IndexTreeIterator::Create(reader.get(), reader->posidx_root()));
+    ASSERT_OK(iter->SeekToFirst());
+    BlockCacheWarmupPB pb;
+    vector<string> block_data;
+    do {
+      BlockHandle bh;
+      BlockPointer ptr = iter->GetCurrentBlockPointer();
+      ASSERT_OK(reader->ReadBlock(ptr, CFileReader::DONT_CACHE_BLOCK,
+                                  CFileReader::DATA_BLOCK, &bh));
+      BlockCacheWarmupPB::EntryPB* entry = pb.add_entries();
+      entry->set_block_id(block_id.id());
+      entry->set_offset(ptr.offset());
+      entry->set_cached_size(bh.data().size());
+      block_data.push_back(bh.data().ToString());
+    } while (iter->Next().ok());
+    ASSERT_GT(pb.entries_size(), 1);
+
+    // A block whose file no longer exists is skipped.
+    BlockCacheWarmupPB::EntryPB* missing = pb.add_entries();
+    missing->set_block_id(block_id.id() + 1000);
+    missing->set_offset(100);
+    missing->set_cached_size(100);
+    ASSERT_OK(pb_util::WritePBContainerToPath(env_.get(), path, pb,
+                                              pb_util::OVERWRITE, pb_util::NO_SYNC));
+
+    BlockCacheWarmer warmer(fs_manager_->block_manager(), env_.get(), path);
+    ASSERT_OK(warmer.WarmUp());
+    BlockCacheWarmer::Progress progress = warmer.GetProgress();
+    ASSERT_EQ(BlockCacheWarmer::FINISHED, progress.state);
+    ASSERT_EQ(pb.entries_size(), progress.blocks_total);
+    ASSERT_EQ(pb.entries_size() - 1, progress.blocks_warmed);
+    ASSERT_EQ(1, progress.blocks_skipped);
+    ASSERT_GT(progress.bytes_read, 0);
+
+    for (int i = 0; i < block_data.size(); i++) {
+      BlockCacheHandle handle;
+      ASSERT_TRUE(cache->Lookup(BlockCache::CacheKey(block_id, pb.entries(i).offset()),
+                                Cache::NO_EXPECT_IN_CACHE, &handle));
+      ASSERT_EQ(block_data[i], handle.data().ToString());
+    }
+
+    // The warmed up blocks are now among the most recently used ones.
+    ASSERT_OK(warmer.SaveRecentlyUsedBlocks());
+    BlockCacheWarmupPB saved;
+    ASSERT_OK(pb_util::ReadPBContainerFromPath(env_.get(), path, &saved));
+    int num_found = 0;
+    for (const BlockCacheWarmupPB::EntryPB& entry : saved.entries()) {
+      if (entry.block_id() == block_id.id()) {
+        num_found++;
+      }
+    }
+    ASSERT_EQ(block_data.size(), num_found);
+  }
+}
+
 #if defined(__linux__)
 // Inject failures in nvm allocation and ensure that we can still read a file.
 TEST_P(TestCFileBothCacheTypes, TestNvmAllocationFailure) {
@@ -48,6 +48,13 @@ DEFINE_bool(cfile_lazy_open, true,
             "Allow lazily opening of cfiles");
 TAG_FLAG(cfile_lazy_open, hidden);
 
+DEFINE_bool(cfile_zero_copy_string_scans, true,
+            "Whether scans of string columns may return cells which point directly "
+            "into the decoded data block, which is then kept pinned in the block cache "
+            "for the lifetime of the batch, rather than copying each cell into the "
+            "batch's arena.");
+TAG_FLAG(cfile_zero_copy_string_scans, advanced);
+
 using kudu::fs::ReadableBlock;
 using strings::Substitute;
 
@@ -305,7 +312,61 @@ class ScratchMemory {
 } // anonymous namespace
 
 Status CFileReader::ReadBlock(const BlockPointer &ptr, CacheControl cache_control,
-                              BlockHandle *ret) const {
+                              BlockType block_type, BlockHandle *ret) const {
+  Cache::Priority priority = block_type == DATA_BLOCK ?
+      Cache::NORMAL_PRIORITY : Cache::HIGH_PRIORITY;
+  return ReadBlockWithPriority(ptr, cache_control, priority, ScopedScanDiskReads::InScan(), ret);
+}
+
+Status CFileReader::PrefetchBlock(uint64_t offset, uint32_t cached_size,
+                                  Cache::Priority priority, size_t* bytes_read) const {
+  DCHECK(init_once_.initted());
+  *bytes_read = 0;
+  BlockCache* cache = BlockCache::GetSingleton();
+  BlockCacheHandle bc_handle;
+  if (cache->Lookup(BlockCache::CacheKey(block_->id(), offset),
+                    Cache::NO_EXPECT_IN_CACHE, &bc_handle)) {
+    return Status::OK();
+  }
+
+  // The on-disk size of an uncompressed block is its cached size. A
+  // compressed block starts with a header which holds its compressed size.
+  uint64_t size = cached_size;
+  if (block_uncompressor_ != nullptr) {
+    if (offset + CompressedBlockBuilder::kHeaderReservedLength >= file_size_) {
+      return Status::Corruption(Substitute("Block header at offset $0 is past the end of $1",
+                                           offset, ToString()));
+    }
+    uint8_t header_buf[CompressedBlockBuilder::kHeaderReservedLength];
+    Slice header;
+    RETURN_NOT_OK(block_->Read(offset, sizeof(header_buf), &header, header_buf));
+    *bytes_read += header.size();
+    if (header.size() != sizeof(header_buf)) {
+      return Status::IOError("Could not read full block header");
+    }
+    uint32_t uncompressed_size = DecodeFixed32(header.data() + 4);
+    if (uncompressed_size != cached_size) {
+      return Status::Corruption(Substitute(
+          "Block at offset $0 of $1 has uncompressed size $2, expected $3",
+          offset, ToString(), uncompressed_size, cached_size));
+    }
+    size = CompressedBlockBuilder::kHeaderReservedLength + DecodeFixed32(header.data());
+  }
+  if (offset == 0 || offset + size >= file_size_) {
+    return Status::Corruption(Substitute("Block at offset $0 of size $1 does not fit in $2",
+                                         offset, size, ToString()));
+  }
+
+  BlockHandle handle;
+  RETURN_NOT_OK(ReadBlockWithPriority(BlockPointer(offset, size), CACHE_BLOCK, priority,
+                                      false, &handle));
+  *bytes_read += size;
+  return Status::OK();
+}
+
+Status CFileReader::ReadBlockWithPriority(const BlockPointer &ptr, CacheControl cache_control,
+                                          Cache::Priority priority, bool scan_read,
+                                          BlockHandle *ret) const {
   DCHECK(init_once_.initted());
   CHECK(ptr.offset() > 0 &&
         ptr.offset() + ptr.size() < file_size_) <<
@@ -332,6 +393,9 @@ Status CFileReader::ReadBlock(const BlockPointer &ptr, CacheControl cache_contro
                "cfile", ToString());
   TRACE_COUNTER_INCREMENT("cfile_cache_miss", 1);
   TRACE_COUNTER_INCREMENT("cfile_cache_miss_bytes", ptr.size());
+  if (scan_read) {
+    cache->RecordScanDiskRead();
+  }
   ScratchMemory scratch;
 
   // If we are reading uncompressed data and plan to cache the result,
@@ -398,7 +462,7 @@ Status CFileReader::ReadBlock(const BlockPointer &ptr, CacheControl cache_contro
   // of what the user requested. The scratch memory includes both the
   // generated key and the data read from disk.
   if (cache_control == CACHE_BLOCK && scratch.IsFromCache()) {
-    cache->Insert(scratch.mutable_pending_entry(), &bc_handle);
+    cache->Insert(scratch.mutable_pending_entry(), &bc_handle, priority);
     *ret = BlockHandle::WithDataFromCache(&bc_handle);
   } else {
     // We get here by either not intending to cache the block or
@@ -512,6 +576,7 @@ CFileIterator::CFileIterator(CFileReader* reader,
                              CFileReader::CacheControl cache_control)
   : reader_(reader),
     seeked_(nullptr),
+    block_seeked_(false),
     prepared_(false),
     cache_control_(cache_control),
     last_prepare_idx_(-1),
@@ -678,6 +743,38 @@ Status CFileIterator::SeekAtOrAfter(const EncodedKey &key,
   return Status::OK();
 }
 
+Status CFileIterator::SeekAtOrAfterInBlock(const BlockPointer &dblk_ptr,
+                                           const EncodedKey &key,
+                                           bool *exact_match) {
+  RETURN_NOT_OK(PrepareForNewSeek());
+  DCHECK_EQ(reader_->is_nullable(), false);
+
+  pblock_pool_scoped_ptr b = prepared_block_pool_.make_scoped_ptr(
+    prepared_block_pool_.Construct());
+  RETURN_NOT_OK(ReadDataBlock(dblk_ptr, b.get()));
+
+  Status s;
+  if (key.num_key_columns() > 1) {
+    Slice slice = key.encoded_key();
+    s = b->dblk_->SeekAtOrAfterValue(&slice, exact_match);
+  } else {
+    s = b->dblk_->SeekAtOrAfterValue(key.raw_keys()[0], exact_match);
+  }
+  if (PREDICT_FALSE(s.IsNotFound())) {
+    *exact_match = false;
+    return Status::NotFound("key after last value in block",
+                            key.encoded_key().ToDebugString());
+  }
+  RETURN_NOT_OK(s);
+
+  last_prepare_idx_ = b->first_row_idx() + b->dblk_->GetCurrentIndex();
+  last_prepare_count_ = 0;
+  block_seeked_ = true;
+  // The block isn't kept in prepared_blocks_: the iterator can't continue
+  // scanning from here since the value index wasn't positioned.
+  return Status::OK();
+}
+
 Status CFileIterator::PrepareForNewSeek() {
   // Fully open the CFileReader if it was lazily opened earlier.
   //
@@ -700,14 +797,18 @@ Status CFileIterator::PrepareForNewSeek() {
     BlockPointer bp(reader_->footer().dict_block_ptr());
 
     // Cache the dictionary for performance
-    RETURN_NOT_OK_PREPEND(reader_->ReadBlock(bp, CFileReader::CACHE_BLOCK, &dict_block_handle_),
+    dict_block_handle_ = std::make_shared<BlockHandle>();
+    RETURN_NOT_OK_PREPEND(reader_->ReadBlock(bp, CFileReader::CACHE_BLOCK,
+                                             CFileReader::DICTIONARY_BLOCK,
+                                             dict_block_handle_.get()),
                           "Couldn't read dictionary block");
 
-    dict_decoder_.reset(new BinaryPlainBlockDecoder(dict_block_handle_.data()));
+    dict_decoder_.reset(new BinaryPlainBlockDecoder(dict_block_handle_->data()));
     RETURN_NOT_OK_PREPEND(dict_decoder_->ParseHeader(), "Couldn't parse dictionary block header");
   }
 
   seeked_ = nullptr;
+  block_seeked_ = false;
   for (PreparedBlock *pb : prepared_blocks_) {
     prepared_block_pool_.Destroy(pb);
   }
@@ -716,8 +817,23 @@ Status CFileIterator::PrepareForNewSeek() {
   return Status::OK();
 }
 
+void CFileIterator::ReleaseBlocks() {
+  DCHECK(!prepared_) << "Cannot release blocks while a batch is prepared";
+  seeked_ = nullptr;
+  block_seeked_ = false;
+  for (PreparedBlock *pb : prepared_blocks_) {
+    prepared_block_pool_.Destroy(pb);
+  }
+  prepared_blocks_.clear();
+
+  // The index iterators hold the index blocks they were seeked through.
+  // They're created again by the next seek.
+  posidx_iter_.reset();
+  validx_iter_.reset();
+}
+
 rowid_t CFileIterator::GetCurrentOrdinal() const {
-  CHECK(seeked_) << "not seeked";
+  CHECK(seeked_ || block_seeked_) << "not seeked";
   return last_prepare_idx_;
 }
 
@@ -746,11 +862,21 @@ Status DecodeNullInfo(Slice *data_block, uint32_t *num_rows_in_block, Slice *nul
 
 Status CFileIterator::ReadCurrentDataBlock(const IndexTreeIterator &idx_iter,
                                            PreparedBlock *prep_block) {
-  prep_block->dblk_ptr_ = idx_iter.GetCurrentBlockPointer();
-  RETURN_NOT_OK(reader_->ReadBlock(prep_block->dblk_ptr_, cache_control_, &prep_block->dblk_data_));
+  return ReadDataBlock(idx_iter.GetCurrentBlockPointer(), prep_block);
+}
+
+Status CFileIterator::ReadDataBlock(const BlockPointer &dblk_ptr,
+                                    PreparedBlock *prep_block) {
+  prep_block->dblk_ptr_ = dblk_ptr;
+  // Always use a new handle, since the previous one may still be retained
+  // by a batch which references its data.
+  prep_block->dblk_data_ = std::make_shared<BlockHandle>();
+  RETURN_NOT_OK(reader_->ReadBlock(prep_block->dblk_ptr_, cache_control_,
+                                   CFileReader::DATA_BLOCK,
+                                   prep_block->dblk_data_.get()));
 
   uint32_t num_rows_in_block = 0;
-  Slice data_block = prep_block->dblk_data_.data();
+  Slice data_block = prep_block->dblk_data_->data();
   if (reader_->is_nullable()) {
     RETURN_NOT_OK(DecodeNullInfo(&data_block, &num_rows_in_block, &(prep_block->rle_bitmap)));
     prep_block->rle_decoder_ = RleDecoder<bool>(prep_block->rle_bitmap.data(),
@@ -900,7 +1026,25 @@ Status CFileIterator::Scan(ColumnBlock *dst) {
   uint32_t rem = last_prepare_count_;
   DCHECK_LE(rem, dst->nrows());
 
+  // For string columns, if the destination can hold references, pin the
+  // source blocks (and the dictionary, if any) for the lifetime of the batch
+  // so that the decoders can return cells pointing directly into them instead
+  // of copying every value into the arena.
+  bool retain_source = FLAGS_cfile_zero_copy_string_scans &&
+      dst->refs() != nullptr &&
+      reader_->type_info()->physical_type() == BINARY;
+  if (retain_source) {
+    remaining_dst.set_source_retained(true);
+    if (dict_block_handle_) {
+      dst->refs()->Retain(dict_block_handle_);
+    }
+  }
+
   for (PreparedBlock *pb : prepared_blocks_) {
+    if (retain_source) {
+      dst->refs()->Retain(pb->dblk_data_);
+    }
+
     if (pb->needs_rewind_) {
       // Seek back to the saved position.
       SeekToPositionInBlock(pb, pb->rewind_idx_);
@@ -18,6 +18,7 @@
 #ifndef KUDU_CFILE_CFILE_READER_H
 #define KUDU_CFILE_CFILE_READER_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -84,6 +85,16 @@ class CFileReader {
     DONT_CACHE_BLOCK
   };
 
+  // The kind of block being read. Index, bloom filter and dictionary blocks
+  // are used by many reads of data blocks, so they are cached with a higher
+  // priority than data blocks.
+  enum BlockType {
+    DATA_BLOCK,
+    INDEX_BLOCK,
+    BLOOM_BLOCK,
+    DICTIONARY_BLOCK
+  };
+
   Status NewIterator(CFileIterator **iter, CacheControl cache_control);
   Status NewIterator(gscoped_ptr<CFileIterator> *iter,
                      CacheControl cache_control) {
@@ -96,7 +107,19 @@ class CFileReader {
   // TODO: make this private? should only be used
   // by the iterator and index tree readers, I think.
   Status ReadBlock(const BlockPointer &ptr, CacheControl cache_control,
-                   BlockHandle *ret) const;
+                   BlockType block_type, BlockHandle *ret) const;
+
+  // Read the block which starts at 'offset' into the block cache with the
+  // given priority, unless it is already cached. 'cached_size' is the size of
+  // the block's data once decompressed, as previously reported by the block
+  // cache; it is used to find the size of the block on disk. Sets
+  // 'bytes_read' to the number of bytes read from disk.
+  //
+  // Returns Corruption if the block doesn't fit within the file.
+  //
+  // Used to warm the block cache up after a restart: see BlockCacheWarmer.
+  Status PrefetchBlock(uint64_t offset, uint32_t cached_size, Cache::Priority priority,
+                       size_t* bytes_read) const;
 
   // Return the number of rows in this cfile.
   // This is assumed to be reasonably fast (i.e does not scan
@@ -177,6 +200,13 @@ class CFileReader {
   Status ReadAndParseHeader();
   Status ReadAndParseFooter();
 
+  // Like ReadBlock(), but inserts the block into the cache with 'priority'.
+  // If 'scan_read' is true and the block is read from disk, it is recorded
+  // as a read by a client scan: see BlockCache::RecordScanDiskRead().
+  Status ReadBlockWithPriority(const BlockPointer &ptr, CacheControl cache_control,
+                               Cache::Priority priority, bool scan_read,
+                               BlockHandle *ret) const;
+
   // Returns the memory usage of the object including the object itself.
   size_t memory_footprint() const;
 
@@ -317,6 +347,24 @@ class CFileIterator : public ColumnIterator {
   Status SeekAtOrAfter(const EncodedKey &encoded_key,
                        bool *exact_match);
 
+  // Seek directly to the given key within the data block at 'dblk_ptr',
+  // skipping the value index. The caller is responsible for passing the
+  // data block whose key range would contain 'encoded_key' (e.g. as found
+  // from an in-memory copy of the value index). Returns NotFound if the
+  // key falls after the last value in the block.
+  //
+  // This is intended for point lookups: after a successful seek, only
+  // GetCurrentOrdinal() may be called. The iterator may not be used to
+  // scan until it is re-seeked with one of the other Seek*() functions.
+  Status SeekAtOrAfterInBlock(const BlockPointer &dblk_ptr,
+                              const EncodedKey &encoded_key,
+                              bool *exact_match);
+
+  // Drop the iterator's seek position, and release the data and index blocks
+  // it holds, so that an idle iterator doesn't keep them pinned in the block
+  // cache. The iterator must be seeked again before any further use.
+  void ReleaseBlocks();
+
   // Return true if this reader is currently seeked.
   // If the iterator is not seeked, it is an error to call any functions except
   // for seek (including GetCurrentOrdinal).
@@ -373,7 +421,9 @@ class CFileIterator : public ColumnIterator {
 
   struct PreparedBlock {
     BlockPointer dblk_ptr_;
-    BlockHandle dblk_data_;
+    // Shared so that scanned cells may continue to reference the block's
+    // data after this PreparedBlock is recycled. See CFileIterator::Scan().
+    std::shared_ptr<BlockHandle> dblk_data_;
     gscoped_ptr<BlockDecoder> dblk_;
 
     // The rowid of the first row in this block.
@@ -421,6 +471,9 @@ class CFileIterator : public ColumnIterator {
   Status ReadCurrentDataBlock(const IndexTreeIterator &idx_iter,
                               PreparedBlock *prep_block);
 
+  // Read the data block at 'dblk_ptr' into the given PreparedBlock structure.
+  Status ReadDataBlock(const BlockPointer &dblk_ptr, PreparedBlock *prep_block);
+
   // Read the data block currently pointed to by idx_iter_, and enqueue
   // it onto the end of the prepared_blocks_ deque.
   Status QueueCurrentDataBlock(const IndexTreeIterator &idx_iter);
@@ -436,12 +489,16 @@ class CFileIterator : public ColumnIterator {
 
   // Decoder for the dictionary block
   gscoped_ptr<BinaryPlainBlockDecoder> dict_decoder_;
-  BlockHandle dict_block_handle_;
+  std::shared_ptr<BlockHandle> dict_block_handle_;
 
   // The currently in-use index iterator. This is equal to either
   // posidx_iter_.get(), validx_iter_.get(), or NULL if not seeked.
   IndexTreeIterator *seeked_;
 
+  // True if the last seek was a SeekAtOrAfterInBlock(), in which case
+  // seeked_ is NULL but the current ordinal is valid.
+  bool block_seeked_;
+
   // Data blocks that contain data relevant to the currently Prepared
   // batch of rows.
   // These pointers are allocated from the prepared_block_pool_ below.
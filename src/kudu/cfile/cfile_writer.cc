@@ -17,6 +17,7 @@
 
 #include "kudu/cfile/cfile_writer.h"
 
+#include <algorithm>
 #include <glog/logging.h>
 #include <string>
 #include <utility>
@@ -61,6 +62,7 @@ namespace kudu {
 namespace cfile {
 
 const char kMagicString[] = "kuducfil";
+const char kMaxTimestampMetadataKey[] = "max_timestamp";
 
 static const size_t kBlockSizeLimit = 16 * 1024 * 1024; // 16MB
 static const size_t kMinBlockSize = 512;
@@ -96,6 +98,8 @@ CFileWriter::CFileWriter(const WriterOptions &options,
     is_nullable_(is_nullable),
     typeinfo_(typeinfo),
     key_encoder_(nullptr),
+    has_max_timestamp_(false),
+    max_timestamp_(0),
     state_(kWriterInitialized) {
   EncodingType encoding = options_.storage_attributes.encoding;
   Status s = TypeEncodingInfo::Get(typeinfo_, encoding, &type_encoding_info_);
@@ -199,6 +203,12 @@ Status CFileWriter::FinishAndReleaseBlock(ScopedWritableBlockCloser* closer) {
   // Write out any pending values as the last data block.
   RETURN_NOT_OK(FinishCurDataBlock());
 
+  if (has_max_timestamp_) {
+    faststring buf;
+    PutFixed64(&buf, max_timestamp_);
+    AddMetadataPair(kMaxTimestampMetadataKey, Slice(buf));
+  }
+
   state_ = kWriterFinished;
 
   // Start preparing the footer.
@@ -288,6 +298,17 @@ Status CFileWriter::AppendEntries(const void *entries, size_t count) {
 
   const uint8_t *ptr = reinterpret_cast<const uint8_t *>(entries);
 
+  // Keep track of the largest timestamp, which lets readers skip files whose
+  // values are all too old, e.g. for row expiry.
+  if (typeinfo_->type() == TIMESTAMP && count > 0) {
+    const int64_t* values = reinterpret_cast<const int64_t*>(entries);
+    int64_t max_value = *std::max_element(values, values + count);
+    if (!has_max_timestamp_ || max_value > max_timestamp_) {
+      max_timestamp_ = max_value;
+      has_max_timestamp_ = true;
+    }
+  }
+
   while (rem > 0) {
     int n = data_block_->Add(ptr, rem);
     DCHECK_GE(n, 0);
@@ -56,6 +56,11 @@ class IndexTreeBuilder;
 // Magic used in header/footer
 extern const char kMagicString[];
 
+// Key of the footer metadata entry which holds the largest value of a file of
+// non-nullable TIMESTAMP values, encoded as a fixed64. Absent if the file is
+// empty or of another type.
+extern const char kMaxTimestampMetadataKey[];
+
 const int kCFileMajorVersion = 1;
 const int kCFileMinorVersion = 0;
 
@@ -212,6 +217,11 @@ class CFileWriter {
   // Metadata which has been added to the writer but not yet flushed.
   vector<pair<string, string> > unflushed_metadata_;
 
+  // The largest value appended so far, if the file is of non-nullable
+  // TIMESTAMP values. See kMaxTimestampMetadataKey.
+  bool has_max_timestamp_;
+  int64_t max_timestamp_;
+
   gscoped_ptr<BlockBuilder> data_block_;
   gscoped_ptr<IndexTreeBuilder> posidx_builder_;
   gscoped_ptr<IndexTreeBuilder> validx_builder_;
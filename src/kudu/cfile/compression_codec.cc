@@ -128,8 +128,21 @@ class SnappyCodec : public CompressionCodec {
   Status Uncompress(const Slice& compressed,
                     uint8_t *uncompressed,
                     size_t uncompressed_length) const OVERRIDE {
-    bool success = snappy::RawUncompress(reinterpret_cast<const char *>(compressed.data()),
-                                         compressed.size(), reinterpret_cast<char *>(uncompressed));
+    // RawUncompress() trusts the length encoded in the compressed stream, so
+    // check it against the size of the output buffer first: the input may come
+    // from the network.
+    const char* data = reinterpret_cast<const char *>(compressed.data());
+    size_t actual_length;
+    if (!snappy::GetUncompressedLength(data, compressed.size(), &actual_length)) {
+      return Status::Corruption("unable to read the uncompressed length of the buffer");
+    }
+    if (actual_length != uncompressed_length) {
+      return Status::Corruption(
+          StringPrintf("buffer uncompresses to %zu bytes, expected %zu",
+                       actual_length, uncompressed_length));
+    }
+    bool success = snappy::RawUncompress(data, compressed.size(),
+                                         reinterpret_cast<char *>(uncompressed));
     return success ? Status::OK() : Status::Corruption("unable to uncompress the buffer");
   }
 
@@ -167,9 +180,13 @@ class Lz4Codec : public CompressionCodec {
   Status Uncompress(const Slice& compressed,
                     uint8_t *uncompressed,
                     size_t uncompressed_length) const OVERRIDE {
-    int n = LZ4_decompress_fast(reinterpret_cast<const char *>(compressed.data()),
-                                reinterpret_cast<char *>(uncompressed), uncompressed_length);
-    if (n != compressed.size()) {
+    // The safe variant never reads or writes out of bounds, even on corrupt
+    // input, which matters now that the codec also decodes data received from
+    // the network.
+    int n = LZ4_decompress_safe(reinterpret_cast<const char *>(compressed.data()),
+                                reinterpret_cast<char *>(uncompressed),
+                                compressed.size(), uncompressed_length);
+    if (n != uncompressed_length) {
       return Status::Corruption(
         StringPrintf("unable to uncompress the buffer. error near %d, buffer", -n),
           compressed.ToDebugString(100));
@@ -267,7 +267,8 @@ Status IndexTreeIterator::LoadBlock(const BlockPointer &block, int depth) {
     seeked = seeked_indexes_.back().get();
   }
 
-  RETURN_NOT_OK(reader_->ReadBlock(block, CFileReader::CACHE_BLOCK, &seeked->data));
+  RETURN_NOT_OK(reader_->ReadBlock(block, CFileReader::CACHE_BLOCK,
+                                   CFileReader::INDEX_BLOCK, &seeked->data));
   seeked->block_ptr = block;
 
   // Parse the new block.
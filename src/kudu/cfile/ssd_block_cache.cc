@@ -0,0 +1,368 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/ssd_block_cache.h"
+
+#include <algorithm>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <utility>
+
+#include "kudu/gutil/hash/city.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/coding-inl.h"
+#include "kudu/util/crc.h"
+#include "kudu/util/env.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/thread.h"
+
+DEFINE_int64(block_cache_ssd_admission_history_size, 256 * 1024,
+             "Number of keys of blocks evicted from the in-memory block cache to "
+             "remember. A block is only written to the SSD block cache tier if it is "
+             "evicted again while its key is remembered. If 0, all evicted blocks "
+             "are admitted.");
+TAG_FLAG(block_cache_ssd_admission_history_size, experimental);
+
+DEFINE_int64(block_cache_ssd_max_pending_write_mb, 64,
+             "Maximum amount of evicted block data waiting to be written to the SSD "
+             "block cache tier. Blocks evicted while the limit is reached are not "
+             "written.");
+TAG_FLAG(block_cache_ssd_max_pending_write_mb, experimental);
+
+METRIC_DEFINE_counter(server, block_cache_ssd_hits,
+                      "SSD Block Cache Hits", kudu::MetricUnit::kBlocks,
+                      "Number of lookups which missed the in-memory block cache and "
+                      "found the block in the SSD tier");
+METRIC_DEFINE_counter(server, block_cache_ssd_misses,
+                      "SSD Block Cache Misses", kudu::MetricUnit::kBlocks,
+                      "Number of lookups which missed both the in-memory block cache and "
+                      "the SSD tier");
+METRIC_DEFINE_counter(server, block_cache_ssd_inserts,
+                      "SSD Block Cache Inserts", kudu::MetricUnit::kBlocks,
+                      "Number of blocks written to the SSD block cache tier");
+METRIC_DEFINE_counter(server, block_cache_ssd_dropped_inserts,
+                      "SSD Block Cache Dropped Inserts", kudu::MetricUnit::kBlocks,
+                      "Number of admitted blocks which were not written to the SSD "
+                      "block cache tier because too many writes were already pending");
+METRIC_DEFINE_counter(server, block_cache_ssd_checksum_failures,
+                      "SSD Block Cache Checksum Failures", kudu::MetricUnit::kBlocks,
+                      "Number of blocks read from the SSD block cache tier which failed "
+                      "checksum verification, and were treated as misses");
+METRIC_DEFINE_histogram(server, block_cache_ssd_lookup_latency,
+                        "SSD Block Cache Lookup Latency",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Time taken to read a block from the SSD block cache tier",
+                        10000000, 2);
+METRIC_DEFINE_gauge_uint64(server, block_cache_ssd_usage, "SSD Block Cache Usage",
+                           kudu::MetricUnit::kBytes,
+                           "Space used by the blocks in the SSD block cache tier");
+
+using std::string;
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+namespace {
+
+// Each entry in the file is laid out as:
+//   magic (fixed32)
+//   key size (fixed32)
+//   data size (fixed32)
+//   CRC32C of the data (fixed32)
+//   key
+//   data
+const uint32_t kEntryMagic = 0x4b534243; // "KSBC"
+const size_t kEntryHeaderSize = 4 * sizeof(uint32_t);
+
+// The largest block which will be written to the cache, as a fraction of its
+// capacity.
+const int kMaxEntryFractionOfCapacity = 8;
+
+} // anonymous namespace
+
+SsdBlockCache::Metrics::Metrics(const scoped_refptr<MetricEntity>& entity)
+  : hits(METRIC_block_cache_ssd_hits.Instantiate(entity)),
+    misses(METRIC_block_cache_ssd_misses.Instantiate(entity)),
+    inserts(METRIC_block_cache_ssd_inserts.Instantiate(entity)),
+    dropped_inserts(METRIC_block_cache_ssd_dropped_inserts.Instantiate(entity)),
+    checksum_failures(METRIC_block_cache_ssd_checksum_failures.Instantiate(entity)),
+    lookup_latency(METRIC_block_cache_ssd_lookup_latency.Instantiate(entity)),
+    usage(METRIC_block_cache_ssd_usage.Instantiate(entity, 0)) {
+}
+
+Status SsdBlockCache::Create(Env* env, const string& path, int64_t capacity,
+                             gscoped_ptr<SsdBlockCache>* cache) {
+  if (capacity <= 0) {
+    return Status::InvalidArgument("SSD block cache capacity must be positive");
+  }
+  RWFileOptions opts;
+  opts.mode = Env::CREATE_IF_NON_EXISTING_TRUNCATE;
+  gscoped_ptr<RWFile> file;
+  RETURN_NOT_OK_PREPEND(env->NewRWFile(opts, path, &file),
+                        Substitute("Unable to create SSD block cache file $0", path));
+  Status s = file->PreAllocate(0, capacity);
+  if (!s.ok()) {
+    LOG(WARNING) << "Unable to preallocate SSD block cache file " << path << ": "
+                 << s.ToString();
+  }
+
+  gscoped_ptr<SsdBlockCache> c(new SsdBlockCache(capacity, std::move(file)));
+  RETURN_NOT_OK(Thread::Create("cfile", "ssd-block-cache-writer",
+                               &SsdBlockCache::WriterThread, c.get(),
+                               &c->writer_thread_));
+  LOG(INFO) << "Opened SSD block cache tier at " << path << " with capacity "
+            << capacity << " bytes";
+  *cache = std::move(c);
+  return Status::OK();
+}
+
+SsdBlockCache::SsdBlockCache(int64_t capacity, gscoped_ptr<RWFile> file)
+  : capacity_(capacity),
+    file_(std::move(file)),
+    cond_(&lock_),
+    write_offset_(0),
+    bytes_used_(0),
+    pending_bytes_(0),
+    writing_(false),
+    shutting_down_(false) {
+}
+
+SsdBlockCache::~SsdBlockCache() {
+  {
+    MutexLock l(lock_);
+    shutting_down_ = true;
+    cond_.Broadcast();
+  }
+  if (writer_thread_) {
+    writer_thread_->Join();
+  }
+  WARN_NOT_OK(file_->Close(), "Unable to close SSD block cache file");
+}
+
+void SsdBlockCache::StartInstrumentation(const scoped_refptr<MetricEntity>& metric_entity) {
+  gscoped_ptr<Metrics> metrics(new Metrics(metric_entity));
+  MutexLock l(lock_);
+  metrics->usage->set_value(bytes_used_);
+  metrics_ = std::move(metrics);
+}
+
+bool SsdBlockCache::Lookup(const Slice& key,
+                           const std::function<uint8_t*(size_t)>& allocate) {
+  string key_str = key.ToString();
+  IndexEntry entry;
+  {
+    MutexLock l(lock_);
+    const IndexEntry* e = FindOrNull(index_, key_str);
+    if (e == nullptr) {
+      if (metrics_) metrics_->misses->Increment();
+      return false;
+    }
+    entry = *e;
+  }
+
+  uint8_t* buf = allocate(entry.data_size);
+  if (buf == nullptr) {
+    return false;
+  }
+
+  MonoTime start = MonoTime::Now(MonoTime::FINE);
+  uint64_t data_offset = entry.offset + kEntryHeaderSize + key.size();
+  Slice result;
+  Status s = file_->Read(data_offset, entry.data_size, &result, buf);
+  if (s.ok() && result.data() != buf) {
+    memcpy(buf, result.data(), result.size());
+  }
+  bool valid = s.ok() && crc::Crc32c(buf, entry.data_size) == entry.crc;
+  MonoDelta elapsed = MonoTime::Now(MonoTime::FINE).GetDeltaSince(start);
+
+  MutexLock l(lock_);
+  if (metrics_) {
+    metrics_->lookup_latency->Increment(elapsed.ToMicroseconds());
+  }
+  if (!valid) {
+    if (!s.ok()) {
+      LOG(WARNING) << "Unable to read from SSD block cache: " << s.ToString();
+    }
+    if (metrics_) {
+      metrics_->checksum_failures->Increment();
+      metrics_->misses->Increment();
+    }
+    // Drop the entry, unless it has already been replaced.
+    const IndexEntry* e = FindOrNull(index_, key_str);
+    if (e != nullptr && e->offset == entry.offset) {
+      DropEntriesInRangeUnlocked(entry.offset, entry.offset + 1);
+    }
+    return false;
+  }
+  if (metrics_) metrics_->hits->Increment();
+  return true;
+}
+
+void SsdBlockCache::EvictedEntry(Slice key, Slice value) {
+  if (value.size() > capacity_ / kMaxEntryFractionOfCapacity || !ShouldAdmit(key)) {
+    return;
+  }
+  string key_str = key.ToString();
+  {
+    MutexLock l(lock_);
+    if (shutting_down_ || ContainsKey(index_, key_str)) {
+      return;
+    }
+  }
+
+  // Copy the data outside of the lock.
+  PendingWrite write;
+  write.key = std::move(key_str);
+  write.data.assign(reinterpret_cast<const char*>(value.data()), value.size());
+
+  MutexLock l(lock_);
+  if (pending_bytes_ + value.size() > FLAGS_block_cache_ssd_max_pending_write_mb * 1024 * 1024) {
+    if (metrics_) metrics_->dropped_inserts->Increment();
+    return;
+  }
+  pending_bytes_ += value.size();
+  pending_writes_.emplace_back(std::move(write));
+  cond_.Signal();
+}
+
+bool SsdBlockCache::ShouldAdmit(const Slice& key) {
+  if (FLAGS_block_cache_ssd_admission_history_size <= 0) {
+    return true;
+  }
+  // A hash collision only admits a block one eviction early.
+  uint64_t hash = util_hash::CityHash64(reinterpret_cast<const char*>(key.data()), key.size());
+  AdmissionHistoryShard* shard =
+      &admission_history_[hash >> (64 - kNumAdmissionHistoryShardBits)];
+  int64_t max_shard_size = std::max<int64_t>(
+      1, FLAGS_block_cache_ssd_admission_history_size / kNumAdmissionHistoryShards);
+
+  lock_guard<simple_spinlock> l(&shard->lock);
+  // If the key was remembered from a previous eviction, the block has been
+  // read again since then: admit it. The hash is left in the FIFO, and is
+  // simply skipped when it reaches the front.
+  if (shard->hashes.erase(hash) > 0) {
+    return true;
+  }
+  shard->hashes.insert(hash);
+  shard->order.push_back(hash);
+  while (static_cast<int64_t>(shard->order.size()) > max_shard_size) {
+    shard->hashes.erase(shard->order.front());
+    shard->order.pop_front();
+  }
+  return false;
+}
+
+void SsdBlockCache::WriterThread() {
+  while (true) {
+    PendingWrite write;
+    {
+      MutexLock l(lock_);
+      while (pending_writes_.empty() && !shutting_down_) {
+        cond_.Wait();
+      }
+      if (shutting_down_) {
+        return;
+      }
+      write = std::move(pending_writes_.front());
+      pending_writes_.pop_front();
+      pending_bytes_ -= write.data.size();
+      writing_ = true;
+    }
+
+    Status s = AppendEntry(write);
+    if (!s.ok()) {
+      KLOG_EVERY_N_SECS(WARNING, 60) << "Unable to write to SSD block cache: "
+                                     << s.ToString();
+    }
+
+    MutexLock l(lock_);
+    writing_ = false;
+    cond_.Broadcast();
+  }
+}
+
+Status SsdBlockCache::AppendEntry(const PendingWrite& write) {
+  uint64_t entry_size = kEntryHeaderSize + write.key.size() + write.data.size();
+  uint64_t offset;
+  {
+    MutexLock l(lock_);
+    if (ContainsKey(index_, write.key)) {
+      return Status::OK();
+    }
+    // Wrap around to the start of the file if the entry doesn't fit at the end.
+    if (write_offset_ + entry_size > capacity_) {
+      write_offset_ = 0;
+    }
+    offset = write_offset_;
+    write_offset_ += entry_size;
+    DropEntriesInRangeUnlocked(offset, offset + entry_size);
+  }
+
+  uint32_t crc = crc::Crc32c(write.data.data(), write.data.size());
+  string buf;
+  buf.resize(kEntryHeaderSize);
+  uint8_t* hdr = reinterpret_cast<uint8_t*>(&buf[0]);
+  InlineEncodeFixed32(hdr, kEntryMagic);
+  InlineEncodeFixed32(hdr + 4, write.key.size());
+  InlineEncodeFixed32(hdr + 8, write.data.size());
+  InlineEncodeFixed32(hdr + 12, crc);
+  buf.append(write.key);
+  buf.append(write.data);
+  RETURN_NOT_OK(file_->Write(offset, Slice(buf)));
+
+  MutexLock l(lock_);
+  IndexEntry entry = { offset, static_cast<uint32_t>(write.data.size()), crc };
+  index_[write.key] = entry;
+  keys_by_offset_[offset] = write.key;
+  bytes_used_ += entry_size;
+  if (metrics_) {
+    metrics_->inserts->Increment();
+    metrics_->usage->set_value(bytes_used_);
+  }
+  return Status::OK();
+}
+
+void SsdBlockCache::DropEntriesInRangeUnlocked(uint64_t begin, uint64_t end) {
+  lock_.AssertAcquired();
+  auto it = keys_by_offset_.lower_bound(begin);
+  while (it != keys_by_offset_.end() && it->first < end) {
+    auto idx_it = index_.find(it->second);
+    DCHECK(idx_it != index_.end());
+    bytes_used_ -= kEntryHeaderSize + it->second.size() + idx_it->second.data_size;
+    index_.erase(idx_it);
+    it = keys_by_offset_.erase(it);
+  }
+  if (metrics_) {
+    metrics_->usage->set_value(bytes_used_);
+  }
+}
+
+void SsdBlockCache::WaitForPendingWrites() {
+  MutexLock l(lock_);
+  while (!pending_writes_.empty() || writing_) {
+    cond_.Wait();
+  }
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,192 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CFILE_SSD_BLOCK_CACHE_H
+#define KUDU_CFILE_SSD_BLOCK_CACHE_H
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/cache.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Counter;
+class Env;
+class Histogram;
+class MetricEntity;
+class RWFile;
+class Thread;
+
+template<class T>
+class AtomicGauge;
+
+namespace cfile {
+
+// A secondary tier for the block cache, backed by a regular file on a local
+// (typically solid-state) disk.
+//
+// Blocks evicted from the in-memory cache are passed to this tier through
+// the Cache::EvictionCallback interface. To avoid filling the file with blocks
+// which are only ever read once (e.g. by a large scan), a block is only
+// admitted the second time it is evicted, i.e. once it has been re-read from
+// disk after a previous eviction. Admitted blocks are queued and appended to
+// the file by a background thread.
+//
+// Most evicted blocks are only remembered, and the in-memory cache evicts
+// blocks from all of its shards concurrently, so the history of evicted blocks
+// is sharded by key hash and only holds the hashes. Only admitted blocks take
+// the lock of the tier itself.
+//
+// The file is used as a circular log: writes always go to the current tail,
+// wrapping around to the start when the end of the file is reached, and any
+// entries overwritten by the write are dropped from the in-memory index.
+// Each entry on disk is stored with its key and a CRC32C checksum, which is
+// verified on every read. A read which races with the entry being
+// overwritten therefore fails the checksum and is treated as a miss.
+//
+// The contents of the file are not preserved across restarts.
+class SsdBlockCache : public Cache::EvictionCallback {
+ public:
+  // Create a new cache file at 'path' of 'capacity' bytes, replacing any
+  // existing file, and start the background writer thread.
+  static Status Create(Env* env, const std::string& path, int64_t capacity,
+                       gscoped_ptr<SsdBlockCache>* cache);
+
+  virtual ~SsdBlockCache();
+
+  // Look up the entry for 'key'. On a hit, calls 'allocate' with the size of
+  // the block to get a buffer to read it into, and then reads and verifies
+  // the block. 'allocate' may return NULL to abandon the lookup.
+  //
+  // Returns true if the block was read into the buffer successfully.
+  bool Lookup(const Slice& key, const std::function<uint8_t*(size_t)>& allocate);
+
+  // Cache::EvictionCallback implementation. Called when a block is evicted
+  // from the in-memory cache; may queue it to be written to this tier.
+  virtual void EvictedEntry(Slice key, Slice value) OVERRIDE;
+
+  // Start recording metrics for this tier under the given entity.
+  void StartInstrumentation(const scoped_refptr<MetricEntity>& metric_entity);
+
+  // Block until all queued writes have been written to the file.
+  // Used by tests.
+  void WaitForPendingWrites();
+
+ private:
+  struct IndexEntry {
+    uint64_t offset;
+    uint32_t data_size;
+    uint32_t crc;
+  };
+
+  struct PendingWrite {
+    std::string key;
+    std::string data;
+  };
+
+  // The hashes of the keys which were evicted from the in-memory cache but not
+  // admitted, in order of eviction, for one shard of the key hash space.
+  struct AdmissionHistoryShard {
+    simple_spinlock lock;
+    std::unordered_set<uint64_t> hashes;
+    std::deque<uint64_t> order;
+  };
+
+  static const int kNumAdmissionHistoryShardBits = 4;
+  static const int kNumAdmissionHistoryShards = 1 << kNumAdmissionHistoryShardBits;
+
+  struct Metrics {
+    explicit Metrics(const scoped_refptr<MetricEntity>& metric_entity);
+
+    scoped_refptr<Counter> hits;
+    scoped_refptr<Counter> misses;
+    scoped_refptr<Counter> inserts;
+    scoped_refptr<Counter> dropped_inserts;
+    scoped_refptr<Counter> checksum_failures;
+    scoped_refptr<Histogram> lookup_latency;
+    scoped_refptr<AtomicGauge<uint64_t>> usage;
+  };
+
+  SsdBlockCache(int64_t capacity, gscoped_ptr<RWFile> file);
+
+  // Body of the background writer thread.
+  void WriterThread();
+
+  // Append one entry to the log, dropping any entries it overwrites.
+  Status AppendEntry(const PendingWrite& write);
+
+  // Remove entries whose data lies within [begin, end) of the file.
+  // Requires that lock_ is held.
+  void DropEntriesInRangeUnlocked(uint64_t begin, uint64_t end);
+
+  // Returns true if an evicted block with the given key should be admitted,
+  // and otherwise remembers its key so that it is admitted the next time.
+  bool ShouldAdmit(const Slice& key);
+
+  const int64_t capacity_;
+  gscoped_ptr<RWFile> file_;
+
+  // Protects all of the fields below.
+  mutable Mutex lock_;
+  ConditionVariable cond_;
+
+  // Index of the entries in the file, by key.
+  std::unordered_map<std::string, IndexEntry> index_;
+
+  // The keys of the entries in the file, by offset, so that the entries
+  // overwritten by an append can be found.
+  std::map<uint64_t, std::string> keys_by_offset_;
+
+  // The offset in the file at which the next entry will be written.
+  uint64_t write_offset_;
+
+  // Total number of bytes of the entries in the index.
+  int64_t bytes_used_;
+
+  // Entries waiting to be written by the writer thread.
+  std::deque<PendingWrite> pending_writes_;
+  int64_t pending_bytes_;
+  bool writing_;
+  bool shutting_down_;
+
+  gscoped_ptr<Metrics> metrics_;
+
+  // Not protected by lock_: each shard has its own lock. Bounded to
+  // --block_cache_ssd_admission_history_size keys in total.
+  AdmissionHistoryShard admission_history_[kNumAdmissionHistoryShards];
+
+  scoped_refptr<Thread> writer_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(SsdBlockCache);
+};
+
+} // namespace cfile
+} // namespace kudu
+
+#endif
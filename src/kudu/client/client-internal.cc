@@ -471,6 +471,9 @@ Status KuduClient::Data::AlterTable(KuduClient* client,
   if (resp.has_error()) {
     return StatusFromPB(resp.error().status());
   }
+  if (resp.has_table_id()) {
+    meta_cache_->ClearCacheForTable(resp.table_id());
+  }
   return Status::OK();
 }
 
@@ -753,6 +753,37 @@ TEST_F(ClientTest, TestScanEmptyProjection) {
   }
 }
 
+TEST_F(ClientTest, TestMultiGet) {
+  ASSERT_NO_FATAL_FAILURE(InsertTestRows(client_table_.get(),
+                                         FLAGS_test_scan_num_rows));
+  DeleteTestRows(client_table_.get(), 5, 6);
+
+  KuduMultiGetter getter(client_table_.get());
+  ASSERT_OK(getter.SetProjectedColumnNames({ "key", "int_val" }));
+  // Add keys out of order, spanning both tablets, including a deleted key
+  // and one which was never inserted.
+  for (int key : { 15, 2, 5, 1000000, 7 }) {
+    gscoped_ptr<KuduPartialRow> row(client_table_->schema().NewRow());
+    ASSERT_OK(row->SetInt32("key", key));
+    ASSERT_OK(getter.AddKey(*row));
+  }
+
+  vector<KuduScanBatch::RowPtr> rows;
+  ASSERT_OK(getter.Execute(&rows));
+  ASSERT_EQ(3, rows.size());
+  vector<int32_t> keys;
+  for (const KuduScanBatch::RowPtr& row : rows) {
+    int32_t key;
+    ASSERT_OK(row.GetInt32("key", &key));
+    keys.push_back(key);
+  }
+  ASSERT_EQ((vector<int32_t>{ 15, 2, 7 }), keys);
+
+  // A second Execute() with no keys returns no rows.
+  ASSERT_OK(getter.Execute(&rows));
+  ASSERT_TRUE(rows.empty());
+}
+
 TEST_F(ClientTest, TestProjectInvalidColumn) {
   KuduScanner scanner(client_table_.get());
   Status s = scanner.SetProjectedColumns({ "column-doesnt-exist" });
@@ -2098,6 +2129,85 @@ TEST_F(ClientTest, TestBasicAlterOperations) {
   }
 }
 
+TEST_F(ClientTest, TestAddAndDropRangePartitions) {
+  // Two tablets: (<start>, 10) and [10, <end>).
+  KuduPartialRow* split = schema_.NewRow();
+  ASSERT_OK(split->SetInt32(0, 10));
+  shared_ptr<KuduTable> table;
+  NO_FATALS(CreateTable("TestAddAndDropRangePartitions", 1, { split }, &table));
+  NO_FATALS(InsertTestRows(table.get(), 20));
+  ASSERT_EQ(20, CountRowsFromClient(table.get()));
+
+  // Returns a bound on 'key', or an unbounded bound if 'key' is kNoBound.
+  auto bound = [&](int32_t key) {
+    KuduPartialRow* row = schema_.NewRow();
+    if (key != kNoBound) {
+      CHECK_OK(row->SetInt32(0, key));
+    }
+    return row;
+  };
+
+  // Drop the first range partition along with its rows.
+  {
+    gscoped_ptr<KuduTableAlterer> table_alterer(client_->NewTableAlterer(table->name()));
+    ASSERT_OK(table_alterer->DropRangePartition(bound(kNoBound), bound(10))->Alter());
+  }
+  ASSERT_EQ(10, CountRowsFromClient(table.get()));
+  ASSERT_EQ(5, CountRowsFromClient(table.get(), kNoBound, 15));
+
+  // Writes to the dropped range fail.
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::MANUAL_FLUSH));
+  session->SetTimeoutMillis(10000);
+  ASSERT_OK(session->Apply(BuildTestRow(table.get(), 5).release()));
+  ASSERT_FALSE(session->Flush().ok());
+  gscoped_ptr<KuduError> error = GetSingleErrorFromSession(session.get());
+  ASSERT_TRUE(error->status().IsNotFound()) << error->status().ToString();
+
+  // Replace the unbounded last range partition with two bounded ones, leaving
+  // a hole between them.
+  {
+    gscoped_ptr<KuduTableAlterer> table_alterer(client_->NewTableAlterer(table->name()));
+    ASSERT_OK(table_alterer->DropRangePartition(bound(10), bound(kNoBound))
+              ->AddRangePartition(bound(10), bound(20))
+              ->AddRangePartition(bound(30), bound(40))
+              ->Alter());
+  }
+  ASSERT_EQ(0, CountRowsFromClient(table.get()));
+  NO_FATALS(InsertTestRows(table.get(), 10, 10));
+  NO_FATALS(InsertTestRows(table.get(), 10, 30));
+  ASSERT_EQ(20, CountRowsFromClient(table.get()));
+  ASSERT_EQ(10, CountRowsFromClient(table.get(), 15, 35));
+  ASSERT_EQ(0, CountRowsFromClient(table.get(), 20, 30));
+  ASSERT_EQ(0, CountRowsFromClient(table.get(), 40, kNoBound));
+
+  // Scan tokens skip the hole.
+  {
+    vector<KuduScanToken*> tokens;
+    ElementDeleter deleter(&tokens);
+    KuduScanTokenBuilder builder(table.get());
+    ASSERT_OK(builder.Build(&tokens));
+    ASSERT_EQ(2, tokens.size());
+  }
+
+  // A new range partition may not overlap an existing one.
+  {
+    gscoped_ptr<KuduTableAlterer> table_alterer(client_->NewTableAlterer(table->name()));
+    Status s = table_alterer->AddRangePartition(bound(15), bound(35))->Alter();
+    ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+    ASSERT_STR_CONTAINS(s.ToString(), "conflicts with an existing range partition");
+  }
+
+  // A dropped range partition must match an existing one exactly.
+  {
+    gscoped_ptr<KuduTableAlterer> table_alterer(client_->NewTableAlterer(table->name()));
+    Status s = table_alterer->DropRangePartition(bound(10), bound(15))->Alter();
+    ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+    ASSERT_STR_CONTAINS(s.ToString(), "No range partition found");
+  }
+  ASSERT_EQ(20, CountRowsFromClient(table.get()));
+}
+
 TEST_F(ClientTest, TestDeleteTable) {
   // Open the table before deleting it.
   ASSERT_OK(client_->OpenTable(kTableName, &client_table_));
@@ -31,6 +31,7 @@
 #include "kudu/client/error-internal.h"
 #include "kudu/client/error_collector.h"
 #include "kudu/client/meta_cache.h"
+#include "kudu/client/multi_get-internal.h"
 #include "kudu/client/row_result.h"
 #include "kudu/client/scan_predicate-internal.h"
 #include "kudu/client/scan_token-internal.h"
@@ -473,6 +474,12 @@ KuduTableCreator& KuduTableCreator::num_replicas(int num_replicas) {
   return *this;
 }
 
+KuduTableCreator& KuduTableCreator::row_ttl(const string& column_name, int64_t ttl_secs) {
+  data_->row_ttl_.set_column_name(column_name);
+  data_->row_ttl_.set_ttl_secs(ttl_secs);
+  return *this;
+}
+
 KuduTableCreator& KuduTableCreator::timeout(const MonoDelta& timeout) {
   data_->timeout_ = timeout;
   return *this;
@@ -497,6 +504,9 @@ Status KuduTableCreator::Create() {
   if (data_->num_replicas_ >= 1) {
     req.set_num_replicas(data_->num_replicas_);
   }
+  if (data_->row_ttl_.has_column_name()) {
+    req.mutable_row_ttl()->CopyFrom(data_->row_ttl_);
+  }
   RETURN_NOT_OK_PREPEND(SchemaToPB(*data_->schema_->schema_, req.mutable_schema()),
                         "Invalid schema");
 
@@ -786,6 +796,25 @@ KuduTableAlterer* KuduTableAlterer::RenameTo(const string& new_name) {
   return this;
 }
 
+KuduTableAlterer* KuduTableAlterer::SetRowTtl(const string& column_name, int64_t ttl_secs) {
+  if (ttl_secs <= 0) {
+    data_->status_ = Status::InvalidArgument("row TTL must be positive");
+    return this;
+  }
+  RowTtlPB row_ttl;
+  row_ttl.set_column_name(column_name);
+  row_ttl.set_ttl_secs(ttl_secs);
+  data_->new_row_ttl_ = row_ttl;
+  return this;
+}
+
+KuduTableAlterer* KuduTableAlterer::ClearRowTtl() {
+  RowTtlPB row_ttl;
+  row_ttl.set_ttl_secs(0);
+  data_->new_row_ttl_ = row_ttl;
+  return this;
+}
+
 KuduColumnSpec* KuduTableAlterer::AddColumn(const string& name) {
   Data::Step s = {AlterTableRequestPB::ADD_COLUMN,
                   new KuduColumnSpec(name)};
@@ -807,6 +836,26 @@ KuduTableAlterer* KuduTableAlterer::DropColumn(const string& name) {
   return this;
 }
 
+KuduTableAlterer* KuduTableAlterer::AddRangePartition(KuduPartialRow* lower_bound,
+                                                      KuduPartialRow* upper_bound) {
+  Data::Step s = {AlterTableRequestPB::ADD_RANGE_PARTITION,
+                  nullptr,
+                  lower_bound,
+                  upper_bound};
+  data_->steps_.push_back(s);
+  return this;
+}
+
+KuduTableAlterer* KuduTableAlterer::DropRangePartition(KuduPartialRow* lower_bound,
+                                                       KuduPartialRow* upper_bound) {
+  Data::Step s = {AlterTableRequestPB::DROP_RANGE_PARTITION,
+                  nullptr,
+                  lower_bound,
+                  upper_bound};
+  data_->steps_.push_back(s);
+  return this;
+}
+
 KuduTableAlterer* KuduTableAlterer::timeout(const MonoDelta& timeout) {
   data_->timeout_ = timeout;
   return this;
@@ -1078,13 +1127,13 @@ Status KuduScanner::NextBatch(KuduScanBatch* batch) {
   // need to do some swapping of the response objects around to avoid
   // stomping on the memory the user is looking at.
   CHECK(data_->open_);
-  CHECK(data_->proxy_);
 
   batch->data_->Clear();
 
   if (data_->short_circuit_) {
     return Status::OK();
   }
+  CHECK(data_->proxy_);
 
   if (data_->data_in_open_) {
     // We have data from a previous scan.
@@ -1279,6 +1328,55 @@ Status KuduScanTokenBuilder::Build(vector<KuduScanToken*>* tokens) {
   return data_->Build(tokens);
 }
 
+////////////////////////////////////////////////////////////
+// KuduMultiGetter
+////////////////////////////////////////////////////////////
+
+KuduMultiGetter::KuduMultiGetter(KuduTable* table)
+    : data_(new KuduMultiGetter::Data(table)) {
+}
+
+KuduMultiGetter::~KuduMultiGetter() {
+  delete data_;
+}
+
+Status KuduMultiGetter::SetProjectedColumnNames(const vector<string>& col_names) {
+  return data_->mutable_configuration()->SetProjectedColumnNames(col_names);
+}
+
+Status KuduMultiGetter::SetProjectedColumnIndexes(const vector<int>& col_indexes) {
+  return data_->mutable_configuration()->SetProjectedColumnIndexes(col_indexes);
+}
+
+Status KuduMultiGetter::SetSelection(KuduClient::ReplicaSelection selection) {
+  return data_->mutable_configuration()->SetSelection(selection);
+}
+
+Status KuduMultiGetter::SetReadMode(KuduScanner::ReadMode read_mode) {
+  if (!tight_enum_test<KuduScanner::ReadMode>(read_mode)) {
+    return Status::InvalidArgument("Bad read mode");
+  }
+  return data_->mutable_configuration()->SetReadMode(read_mode);
+}
+
+Status KuduMultiGetter::SetSnapshotMicros(uint64_t snapshot_timestamp_micros) {
+  data_->mutable_configuration()->SetSnapshotMicros(snapshot_timestamp_micros);
+  return Status::OK();
+}
+
+Status KuduMultiGetter::SetTimeoutMillis(int millis) {
+  data_->mutable_configuration()->SetTimeoutMillis(millis);
+  return Status::OK();
+}
+
+Status KuduMultiGetter::AddKey(const KuduPartialRow& key) {
+  return data_->AddKey(key);
+}
+
+Status KuduMultiGetter::Execute(vector<KuduScanBatch::RowPtr>* rows) {
+  return data_->Execute(rows);
+}
+
 ////////////////////////////////////////////////////////////
 // KuduTabletServer
 ////////////////////////////////////////////////////////////
@@ -69,6 +69,7 @@ class Batcher;
 class GetTableSchemaRpc;
 class LookupRpc;
 class MetaCache;
+class MultiGetRpc;
 class RemoteTablet;
 class RemoteTabletServer;
 class WriteRpc;
@@ -276,10 +277,12 @@ class KUDU_EXPORT KuduClient : public sp::enable_shared_from_this<KuduClient> {
   friend class internal::GetTableSchemaRpc;
   friend class internal::LookupRpc;
   friend class internal::MetaCache;
+  friend class internal::MultiGetRpc;
   friend class internal::RemoteTablet;
   friend class internal::RemoteTabletServer;
   friend class internal::WriteRpc;
   friend class KuduClientBuilder;
+  friend class KuduMultiGetter;
   friend class KuduScanner;
   friend class KuduScanTokenBuilder;
   friend class KuduTable;
@@ -363,6 +366,14 @@ class KUDU_EXPORT KuduTableCreator {
   // If not provided (or if <= 0), falls back to the server-side default.
   KuduTableCreator& num_replicas(int n_replicas);
 
+  // Sets a time-to-live on the table's rows: a row expires 'ttl_secs' seconds
+  // after the time stored in its 'column_name' column, which must be a
+  // non-nullable TIMESTAMP column. Expired rows are hidden from reads, and
+  // are eventually deleted from disk. Optional.
+  //
+  // If not provided, rows never expire.
+  KuduTableCreator& row_ttl(const std::string& column_name, int64_t ttl_secs);
+
   // Set the timeout for the operation. This includes any waiting
   // after the create has been submitted (i.e if the create is slow
   // to be performed for a large table, it may time out and then
@@ -483,6 +494,12 @@ class KUDU_EXPORT KuduTableAlterer {
   // Renames the table.
   KuduTableAlterer* RenameTo(const std::string& new_name);
 
+  // Sets the time-to-live of the table's rows. See KuduTableCreator::row_ttl().
+  KuduTableAlterer* SetRowTtl(const std::string& column_name, int64_t ttl_secs);
+
+  // Removes the time-to-live of the table's rows, if any.
+  KuduTableAlterer* ClearRowTtl();
+
   // Adds a new column to the table.
   //
   // When adding a column, you must specify the default value of the new
@@ -495,6 +512,27 @@ class KUDU_EXPORT KuduTableAlterer {
   // Drops an existing column from the table.
   KuduTableAlterer* DropColumn(const std::string& name);
 
+  // Adds a new range partition to the table, covering the range
+  // [lower_bound, upper_bound). A bound with no columns set is unbounded.
+  //
+  // The new range partition must not overlap any existing range partition of
+  // the table. If the table is hash partitioned, a tablet is created for each
+  // combination of hash buckets within the new range.
+  //
+  // The bounds must be created from the table's schema. The table alterer
+  // takes ownership of the rows.
+  KuduTableAlterer* AddRangePartition(KuduPartialRow* lower_bound,
+                                      KuduPartialRow* upper_bound);
+
+  // Drops an existing range partition from the table, deleting its tablets
+  // and all of the rows they contain. The bounds must exactly match those of
+  // an existing range partition.
+  //
+  // The bounds must be created from the table's schema. The table alterer
+  // takes ownership of the rows.
+  KuduTableAlterer* DropRangePartition(KuduPartialRow* lower_bound,
+                                       KuduPartialRow* upper_bound);
+
   // Set the timeout for the operation. This includes any waiting
   // after the alter has been submitted (i.e if the alter is slow
   // to be performed on a large table, it may time out and then
@@ -1230,6 +1268,68 @@ class KUDU_EXPORT KuduScanTokenBuilder {
   DISALLOW_COPY_AND_ASSIGN(KuduScanTokenBuilder);
 };
 
+// A batch of lookups of rows by primary key.
+//
+// Unlike a KuduScanner, no scanner is opened on the tablet servers: the keys
+// which belong to each tablet are sent in a single MultiGet RPC, and the rows
+// which are found are returned in its response. This is considerably cheaper
+// than a scan per key for point-read workloads.
+//
+// This class is not thread-safe.
+class KUDU_EXPORT KuduMultiGetter {
+ public:
+  // Initialize the getter. The given 'table' object must remain valid
+  // for the lifetime of this object.
+  explicit KuduMultiGetter(KuduTable* table);
+  ~KuduMultiGetter();
+
+  // Set the projection by passing the column names to read. By default,
+  // all columns are read.
+  Status SetProjectedColumnNames(const std::vector<std::string>& col_names)
+    WARN_UNUSED_RESULT;
+
+  // Set the projection by passing the indexes of the columns to read.
+  Status SetProjectedColumnIndexes(const std::vector<int>& col_indexes)
+    WARN_UNUSED_RESULT;
+
+  // Sets the replica selection policy. See KuduScanner::SetSelection().
+  Status SetSelection(KuduClient::ReplicaSelection selection) WARN_UNUSED_RESULT;
+
+  // Sets the ReadMode. Default is READ_LATEST.
+  //
+  // In READ_AT_SNAPSHOT mode without an explicit snapshot timestamp, the
+  // timestamp chosen by the first tablet server is used for all other
+  // tablets in the same call to Execute().
+  Status SetReadMode(KuduScanner::ReadMode read_mode) WARN_UNUSED_RESULT;
+
+  // Sets the snapshot timestamp, in microseconds since the epoch, for
+  // lookups in READ_AT_SNAPSHOT mode.
+  Status SetSnapshotMicros(uint64_t snapshot_timestamp_micros) WARN_UNUSED_RESULT;
+
+  // Sets the maximum time that Execute() is allowed to take.
+  Status SetTimeoutMillis(int millis) WARN_UNUSED_RESULT;
+
+  // Add the primary key of a row to look up. All of the key columns of 'key'
+  // must be set; other columns are ignored.
+  Status AddKey(const KuduPartialRow& key) WARN_UNUSED_RESULT;
+
+  // Look up all of the keys added since the previous call to Execute().
+  //
+  // The rows which were found are returned in 'rows', in the order in which
+  // their keys were added. Keys which do not exist are skipped. The returned
+  // rows remain valid until the next call to Execute() or until this object
+  // is destroyed.
+  Status Execute(std::vector<KuduScanBatch::RowPtr>* rows) WARN_UNUSED_RESULT;
+
+ private:
+  class KUDU_NO_EXPORT Data;
+
+  // Owned.
+  Data* data_;
+
+  DISALLOW_COPY_AND_ASSIGN(KuduMultiGetter);
+};
+
 // In-memory representation of a remote tablet server.
 class KUDU_EXPORT KuduTabletServer {
  public:
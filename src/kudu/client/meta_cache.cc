@@ -317,7 +317,8 @@ class LookupRpc : public Rpc {
             string partition_key,
             scoped_refptr<RemoteTablet>* remote_tablet,
             const MonoTime& deadline,
-            const shared_ptr<Messenger>& messenger);
+            const shared_ptr<Messenger>& messenger,
+            LookupType lookup_type);
   virtual ~LookupRpc();
   virtual void SendRpc() OVERRIDE;
   virtual string ToString() const OVERRIDE;
@@ -325,6 +326,8 @@ class LookupRpc : public Rpc {
   const GetTableLocationsResponsePB& resp() const { return resp_; }
   const string& table_name() const { return table_->name(); }
   const string& table_id() const { return table_->id(); }
+  const string& partition_key() const { return partition_key_; }
+  LookupType lookup_type() const { return lookup_type_; }
 
  private:
   virtual void SendRpcCb(const Status& status) OVERRIDE;
@@ -367,6 +370,9 @@ class LookupRpc : public Rpc {
 
   // Whether this lookup has acquired a master lookup permit.
   bool has_permit_;
+
+  // How to resolve a key that is not covered by any tablet.
+  const LookupType lookup_type_;
 };
 
 LookupRpc::LookupRpc(const scoped_refptr<MetaCache>& meta_cache,
@@ -374,14 +380,16 @@ LookupRpc::LookupRpc(const scoped_refptr<MetaCache>& meta_cache,
                      string partition_key,
                      scoped_refptr<RemoteTablet>* remote_tablet,
                      const MonoTime& deadline,
-                     const shared_ptr<Messenger>& messenger)
+                     const shared_ptr<Messenger>& messenger,
+                     LookupType lookup_type)
     : Rpc(deadline, messenger),
       meta_cache_(meta_cache),
       user_cb_(std::move(user_cb)),
       table_(table),
       partition_key_(std::move(partition_key)),
       remote_tablet_(remote_tablet),
-      has_permit_(false) {
+      has_permit_(false),
+      lookup_type_(lookup_type) {
   DCHECK(deadline.Initialized());
 }
 
@@ -536,19 +544,17 @@ void LookupRpc::SendRpcCb(const Status& status) {
   }
 
   if (new_status.ok()) {
-    const scoped_refptr<RemoteTablet>& result =
-        meta_cache_->ProcessLookupResponse(*this);
-    if (remote_tablet_) {
-      *remote_tablet_ = result;
-    }
-  } else {
+    new_status = meta_cache_->ProcessLookupResponse(*this, remote_tablet_);
+  }
+  if (!new_status.ok()) {
     new_status = new_status.CloneAndPrepend(Substitute("$0 failed", ToString()));
     LOG(WARNING) << new_status.ToString();
   }
   user_cb_.Run(new_status);
 }
 
-const scoped_refptr<RemoteTablet>& MetaCache::ProcessLookupResponse(const LookupRpc& rpc) {
+Status MetaCache::ProcessLookupResponse(const LookupRpc& rpc,
+                                        scoped_refptr<RemoteTablet>* remote_tablet) {
   VLOG(2) << "Processing master response for " << rpc.ToString()
           << ". Response: " << rpc.resp().ShortDebugString();
 
@@ -583,12 +589,49 @@ const scoped_refptr<RemoteTablet>& MetaCache::ProcessLookupResponse(const Lookup
     remote = new RemoteTablet(tablet_id, partition);
     remote->Refresh(ts_cache_, loc.replicas());
 
+    // Evict cached tablets whose partitions overlap the new tablet's. They
+    // belong to range partitions which have since been dropped.
+    auto it = tablets_by_key.upper_bound(partition.partition_key_start());
+    if (it != tablets_by_key.begin()) {
+      --it;
+    }
+    while (it != tablets_by_key.end() &&
+           (partition.partition_key_end().empty() ||
+            it->first < partition.partition_key_end())) {
+      const Partition& cached = it->second->partition();
+      if (cached.partition_key_end().empty() ||
+          cached.partition_key_end() > partition.partition_key_start()) {
+        VLOG(3) << "Evicting tablet " << it->second->tablet_id() << " for ("
+                << rpc.table_name() << "): overlaps new tablet " << tablet_id;
+        it = tablets_by_key.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
     InsertOrDie(&tablets_by_id_, tablet_id, remote);
     InsertOrDie(&tablets_by_key, partition.partition_key_start(), remote);
   }
 
-  // Always return the first tablet.
-  return FindOrDie(tablets_by_id_, rpc.resp().tablet_locations(0).tablet_id());
+  // Return the first tablet which covers the key or, for lower bound lookups,
+  // which follows it. The locations are sorted by partition key.
+  for (const TabletLocationsPB& loc : rpc.resp().tablet_locations()) {
+    const scoped_refptr<RemoteTablet>& remote = FindOrDie(tablets_by_id_, loc.tablet_id());
+    const Partition& partition = remote->partition();
+    if (!partition.partition_key_end().empty() &&
+        partition.partition_key_end() <= rpc.partition_key()) {
+      continue;
+    }
+    if (partition.partition_key_start() > rpc.partition_key() &&
+        rpc.lookup_type() == LookupType::kPoint) {
+      break;
+    }
+    if (remote_tablet) {
+      *remote_tablet = remote;
+    }
+    return Status::OK();
+  }
+  return Status::NotFound("No tablet covering the requested partition key");
 }
 
 bool MetaCache::LookupTabletByKeyFastPath(const KuduTable* table,
@@ -626,14 +669,16 @@ void MetaCache::LookupTabletByKey(const KuduTable* table,
                                   const string& partition_key,
                                   const MonoTime& deadline,
                                   scoped_refptr<RemoteTablet>* remote_tablet,
-                                  const StatusCallback& callback) {
+                                  const StatusCallback& callback,
+                                  LookupType lookup_type) {
   LookupRpc* rpc = new LookupRpc(this,
                                  callback,
                                  table,
                                  partition_key,
                                  remote_tablet,
                                  deadline,
-                                 client_->data_->messenger_);
+                                 client_->data_->messenger_,
+                                 lookup_type);
   rpc->SendRpc();
 }
 
@@ -652,6 +697,17 @@ void MetaCache::MarkTSFailed(RemoteTabletServer* ts,
   }
 }
 
+void MetaCache::ClearCacheForTable(const string& table_id) {
+  shared_lock<rw_spinlock> l(&lock_);
+  const TabletMap* tablets = FindOrNull(tablets_by_table_and_key_, table_id);
+  if (!tablets) {
+    return;
+  }
+  for (const TabletMap::value_type& tablet : *tablets) {
+    tablet.second->MarkStale();
+  }
+}
+
 bool MetaCache::AcquireMasterLookupPermit() {
   return master_lookup_sem_.TryAcquire();
 }
@@ -198,6 +198,18 @@ class RemoteTablet : public RefCountedThreadSafe<RemoteTablet> {
   DISALLOW_COPY_AND_ASSIGN(RemoteTablet);
 };
 
+// How a partition key lookup is resolved when no tablet covers the key, which
+// happens when the key falls in a range partition that was never added or has
+// been dropped.
+enum class LookupType {
+  // The lookup fails with NotFound.
+  kPoint,
+  // The lookup returns the first tablet after the key, and fails with
+  // NotFound only if there is none. Used by scans, which visit every tablet
+  // at or after a key.
+  kLowerBound,
+};
+
 // Manager of RemoteTablets and RemoteTabletServers. The client consults
 // this class to look up a given tablet or server.
 //
@@ -211,6 +223,7 @@ class MetaCache : public RefCountedThreadSafe<MetaCache> {
   // Look up which tablet hosts the given partition key for a table. When it is
   // available, the tablet is stored in 'remote_tablet' (if not NULL) and the
   // callback is fired. Only tablets with non-failed LEADERs are considered.
+  // See LookupType for what happens when no tablet hosts the key.
   //
   // NOTE: the callback may be called from an IO thread or inline with this
   // call if the cached data is already available.
@@ -221,12 +234,18 @@ class MetaCache : public RefCountedThreadSafe<MetaCache> {
                          const std::string& partition_key,
                          const MonoTime& deadline,
                          scoped_refptr<RemoteTablet>* remote_tablet,
-                         const StatusCallback& callback);
+                         const StatusCallback& callback,
+                         LookupType lookup_type = LookupType::kPoint);
 
   // Mark any replicas of any tablets hosted by 'ts' as failed. They will
   // not be returned in future cache lookups.
   void MarkTSFailed(RemoteTabletServer* ts, const Status& status);
 
+  // Mark all cached tablets of the table with ID 'table_id' as stale, so that
+  // the next lookup of any of its partition keys goes to the master. Used
+  // after the table's partitioning may have changed.
+  void ClearCacheForTable(const std::string& table_id);
+
   // Acquire or release a permit to perform a (slow) master lookup.
   //
   // If acquisition fails, caller may still do the lookup, but is first
@@ -240,8 +259,11 @@ class MetaCache : public RefCountedThreadSafe<MetaCache> {
   FRIEND_TEST(client::ClientTest, TestMasterLookupPermits);
 
   // Called on the slow LookupTablet path when the master responds. Populates
-  // the tablet caches and returns a reference to the first one.
-  const scoped_refptr<RemoteTablet>& ProcessLookupResponse(const LookupRpc& rpc);
+  // the tablet caches, evicting cached tablets whose partitions overlap the
+  // returned ones, and stores the tablet matching the lookup in
+  // 'remote_tablet' (if not NULL).
+  Status ProcessLookupResponse(const LookupRpc& rpc,
+                               scoped_refptr<RemoteTablet>* remote_tablet);
 
   // Lookup the given tablet by key, only consulting local information.
   // Returns true and sets *remote_tablet if successful.
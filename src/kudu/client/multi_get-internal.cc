@@ -0,0 +1,442 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/client/multi_get-internal.h"
+
+#include <boost/bind.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "kudu/client/client-internal.h"
+#include "kudu/client/meta_cache.h"
+#include "kudu/client/scanner-internal.h"
+#include "kudu/common/partition.h"
+#include "kudu/common/wire_protocol.h"
+#include "kudu/gutil/bind.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/rpc.h"
+#include "kudu/rpc/rpc_controller.h"
+#include "kudu/tserver/tserver_service.proxy.h"
+#include "kudu/util/async_util.h"
+
+using std::map;
+using std::set;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+
+using rpc::Messenger;
+using rpc::Rpc;
+using rpc::RpcController;
+using strings::Substitute;
+using tserver::MultiGetRequestPB;
+using tserver::MultiGetResponsePB;
+using tserver::TabletServerErrorPB;
+using tserver::TabletServerFeatures;
+
+namespace client {
+
+using internal::MetaCache;
+using internal::RemoteTablet;
+using internal::RemoteTabletServer;
+
+namespace internal {
+
+// A MultiGet RPC to one tablet. It is sent to a replica picked according to
+// the replica selection, and retried on another replica if that one can't
+// serve it, or on the same one after a delay if the server is too busy.
+//
+// 'callback' is called once the RPC has succeeded, or failed for good.
+class MultiGetRpc : public Rpc {
+ public:
+  MultiGetRpc(KuduClient* client,
+              const KuduTable* table,
+              scoped_refptr<RemoteTablet> tablet,
+              KuduClient::ReplicaSelection selection,
+              MultiGetRequestPB req,
+              const MonoTime& deadline,
+              const shared_ptr<Messenger>& messenger,
+              StatusCallback callback);
+  virtual ~MultiGetRpc() {}
+
+  virtual void SendRpc() OVERRIDE;
+  virtual string ToString() const OVERRIDE;
+
+  MultiGetResponsePB* mutable_resp() { return &resp_; }
+  RpcController* mutable_controller() { return mutable_retrier()->mutable_controller(); }
+
+ private:
+  virtual void SendRpcCb(const Status& status) OVERRIDE;
+
+  // Called once the stale tablet's locations have been looked up again.
+  void LookupTabletCb(const Status& status);
+
+  // Picks a replica and resolves its address.
+  void PickReplica();
+
+  // Called once the address of 'ts' has been resolved.
+  void InitProxyCb(RemoteTabletServer* ts, const Status& status);
+
+  // Retries the RPC on another replica than the current one, which failed
+  // with 'status'.
+  void RetryOnOtherReplica(const Status& status);
+
+  void Finish(const Status& status);
+
+  KuduClient* const client_;
+  const KuduTable* const table_;
+  scoped_refptr<RemoteTablet> tablet_;
+  const KuduClient::ReplicaSelection selection_;
+  const MultiGetRequestPB req_;
+  MultiGetResponsePB resp_;
+  const StatusCallback callback_;
+
+  // Replicas which failed to serve the RPC, and the one it was last sent to.
+  set<string> blacklist_;
+  RemoteTabletServer* current_ts_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiGetRpc);
+};
+
+MultiGetRpc::MultiGetRpc(KuduClient* client,
+                         const KuduTable* table,
+                         scoped_refptr<RemoteTablet> tablet,
+                         KuduClient::ReplicaSelection selection,
+                         MultiGetRequestPB req,
+                         const MonoTime& deadline,
+                         const shared_ptr<Messenger>& messenger,
+                         StatusCallback callback)
+    : Rpc(deadline, messenger),
+      client_(client),
+      table_(table),
+      tablet_(std::move(tablet)),
+      selection_(selection),
+      req_(std::move(req)),
+      callback_(std::move(callback)),
+      current_ts_(nullptr) {
+  mutable_controller()->RequireServerFeature(TabletServerFeatures::MULTI_GET);
+}
+
+string MultiGetRpc::ToString() const {
+  return Substitute("MultiGet(tablet: $0, num_keys: $1, num_attempts: $2)",
+                    tablet_->tablet_id(), req_.encoded_keys_size(), num_attempts());
+}
+
+void MultiGetRpc::SendRpc() {
+  if (tablet_->stale()) {
+    // The tablet moved, or its replicas changed: find it again.
+    client_->data_->meta_cache_->LookupTabletByKey(
+        table_, tablet_->partition().partition_key_start(), retrier().deadline(), &tablet_,
+        Bind(&MultiGetRpc::LookupTabletCb, Unretained(this)));
+    return;
+  }
+  PickReplica();
+}
+
+void MultiGetRpc::LookupTabletCb(const Status& status) {
+  if (!status.ok()) {
+    Finish(status);
+    return;
+  }
+  PickReplica();
+}
+
+void MultiGetRpc::PickReplica() {
+  vector<RemoteTabletServer*> candidates;
+  RemoteTabletServer* ts = client_->data_->SelectTServer(tablet_, selection_, blacklist_,
+                                                         &candidates);
+  if (ts == nullptr) {
+    // As in KuduScanner, every candidate has been blacklisted, or there is
+    // no known leader: cycle through the replicas again after a delay.
+    Status s = Status::ServiceUnavailable(Substitute("No $0 for tablet $1",
+                                                     selection_ == KuduClient::LEADER_ONLY ?
+                                                     "LEADER" : "replicas",
+                                                     tablet_->tablet_id()));
+    blacklist_.clear();
+    mutable_retrier()->DelayedRetry(this, s);
+    return;
+  }
+  ts->InitProxy(client_, Bind(&MultiGetRpc::InitProxyCb, Unretained(this), ts));
+}
+
+void MultiGetRpc::InitProxyCb(RemoteTabletServer* ts, const Status& status) {
+  current_ts_ = ts;
+  if (!status.ok()) {
+    RetryOnOtherReplica(status);
+    return;
+  }
+  MonoTime rpc_deadline = MonoTime::Now(MonoTime::FINE);
+  rpc_deadline.AddDelta(client_->default_rpc_timeout());
+  mutable_controller()->set_deadline(MonoTime::Earliest(retrier().deadline(), rpc_deadline));
+  resp_.Clear();
+  ts->proxy()->MultiGetAsync(req_, &resp_, mutable_controller(),
+                             boost::bind(&MultiGetRpc::SendRpcCb, this, Status::OK()));
+}
+
+void MultiGetRpc::SendRpcCb(const Status& status) {
+  if (!status.ok()) {
+    // The RPC passed its deadline while waiting to be retried.
+    Finish(status);
+    return;
+  }
+
+  // Retries ERROR_SERVER_TOO_BUSY, after as long as the server asked for.
+  Status s;
+  if (mutable_retrier()->HandleResponse(this, &s)) {
+    return;
+  }
+  if (!s.ok()) {
+    if (s.IsRemoteError()) {
+      // The server rejected the call itself, e.g. because it doesn't support
+      // MultiGet. Other replicas would do the same.
+      Finish(s);
+      return;
+    }
+    // The server could not be reached.
+    client_->data_->meta_cache_->MarkTSFailed(current_ts_, s);
+    RetryOnOtherReplica(s);
+    return;
+  }
+
+  if (resp_.has_error()) {
+    s = StatusFromPB(resp_.error().status());
+    switch (resp_.error().code()) {
+      case TabletServerErrorPB::TABLET_NOT_FOUND:
+        tablet_->MarkStale();
+        RetryOnOtherReplica(s);
+        return;
+      case TabletServerErrorPB::TABLET_NOT_RUNNING:
+        RetryOnOtherReplica(s);
+        return;
+      default:
+        Finish(s);
+        return;
+    }
+  }
+  Finish(Status::OK());
+}
+
+void MultiGetRpc::RetryOnOtherReplica(const Status& status) {
+  blacklist_.insert(current_ts_->permanent_uuid());
+  mutable_retrier()->DelayedRetry(this, status);
+}
+
+void MultiGetRpc::Finish(const Status& status) {
+  Status s = status;
+  if (!s.ok()) {
+    s = s.CloneAndPrepend(Substitute("MultiGet on tablet $0 $1 failed after $2 attempt(s)",
+                                     tablet_->tablet_id(),
+                                     current_ts_ ?
+                                     Substitute("at $0", current_ts_->ToString()) :
+                                     "(no tablet server available)",
+                                     num_attempts()));
+  }
+  // The callback may destroy this RPC.
+  StatusCallback callback = callback_;
+  callback.Run(s);
+}
+
+} // namespace internal
+
+using internal::MultiGetRpc;
+
+KuduMultiGetter::Data::Data(KuduTable* table)
+    : configuration_(table),
+      table_(DCHECK_NOTNULL(table)),
+      snapshot_timestamp_(ScanConfiguration::kNoTimestamp) {
+}
+
+KuduMultiGetter::Data::~Data() {
+}
+
+Status KuduMultiGetter::Data::AddKey(const KuduPartialRow& key) {
+  PendingKey pending;
+  RETURN_NOT_OK(key.EncodeRowKey(&pending.encoded_key));
+  RETURN_NOT_OK(table_->partition_schema().EncodeKey(key, &pending.partition_key));
+  keys_.emplace_back(std::move(pending));
+  return Status::OK();
+}
+
+Status KuduMultiGetter::Data::Execute(vector<KuduScanBatch::RowPtr>* rows) {
+  rows->clear();
+  batches_.clear();
+  snapshot_timestamp_ = configuration_.snapshot_timestamp();
+
+  // Whatever the outcome, the keys are consumed by this call.
+  vector<PendingKey> keys;
+  keys.swap(keys_);
+
+  MonoTime deadline = MonoTime::Now(MonoTime::FINE);
+  deadline.AddDelta(configuration_.timeout());
+
+  // Look up the tablets of all the keys at once. The lookups which aren't
+  // answered from the cache go to the master.
+  MetaCache* meta_cache = table_->client()->data_->meta_cache_.get();
+  vector<scoped_refptr<RemoteTablet>> key_tablets(keys.size());
+  vector<unique_ptr<Synchronizer>> lookups;
+  for (int i = 0; i < keys.size(); i++) {
+    lookups.emplace_back(new Synchronizer());
+    meta_cache->LookupTabletByKey(table_, keys[i].partition_key, deadline, &key_tablets[i],
+                                  lookups.back()->AsStatusCallback());
+  }
+  vector<Status> lookup_statuses;
+  for (const auto& lookup : lookups) {
+    lookup_statuses.push_back(lookup->Wait());
+  }
+
+  // Group the keys by the tablet which holds them.
+  vector<TabletKeys> tablets;
+  map<string, int> tablet_idxs;
+  for (int i = 0; i < keys.size(); i++) {
+    const Status& s = lookup_statuses[i];
+    if (s.IsNotFound()) {
+      // The key falls in a range which isn't covered by any tablet, so the
+      // row can't exist.
+      continue;
+    }
+    RETURN_NOT_OK(s);
+    auto ins = tablet_idxs.emplace(key_tablets[i]->tablet_id(), tablets.size());
+    if (ins.second) {
+      tablets.emplace_back();
+      tablets.back().tablet = key_tablets[i];
+    }
+    tablets[ins.first->second].key_idxs.push_back(i);
+  }
+
+  vector<KuduScanBatch::RowPtr> results(keys.size());
+  vector<bool> found(keys.size(), false);
+  if (configuration_.read_mode() == KuduScanner::READ_AT_SNAPSHOT &&
+      snapshot_timestamp_ == ScanConfiguration::kNoTimestamp &&
+      tablets.size() > 1) {
+    // Let the first tablet pick the snapshot, so that the others can be read
+    // at the same one.
+    vector<TabletKeys> first(tablets.begin(), tablets.begin() + 1);
+    RETURN_NOT_OK(GetFromTablets(first, keys, deadline, &results, &found));
+    tablets.erase(tablets.begin());
+  }
+  RETURN_NOT_OK(GetFromTablets(tablets, keys, deadline, &results, &found));
+
+  for (int i = 0; i < keys.size(); i++) {
+    if (found[i]) {
+      rows->push_back(results[i]);
+    }
+  }
+  return Status::OK();
+}
+
+Status KuduMultiGetter::Data::GetFromTablets(const vector<TabletKeys>& tablets,
+                                             const vector<PendingKey>& keys,
+                                             const MonoTime& deadline,
+                                             vector<KuduScanBatch::RowPtr>* rows,
+                                             vector<bool>* found) {
+  KuduClient* client = table_->client();
+
+  // Declared before the RPCs, whose callbacks refer to them.
+  vector<unique_ptr<Synchronizer>> syncs;
+  vector<unique_ptr<MultiGetRpc>> rpcs;
+  for (const TabletKeys& tablet_keys : tablets) {
+    MultiGetRequestPB req;
+    RETURN_NOT_OK(BuildRequest(*tablet_keys.tablet.get(), keys, tablet_keys.key_idxs, &req));
+    syncs.emplace_back(new Synchronizer());
+    rpcs.emplace_back(new MultiGetRpc(client, table_, tablet_keys.tablet,
+                                      configuration_.selection(), std::move(req), deadline,
+                                      client->data_->messenger_,
+                                      syncs.back()->AsStatusCallback()));
+  }
+  for (const auto& rpc : rpcs) {
+    rpc->SendRpc();
+  }
+
+  // Wait for every RPC, even once one has failed, since they refer to 'keys'.
+  Status first_error;
+  for (int i = 0; i < rpcs.size(); i++) {
+    Status s = syncs[i]->Wait();
+    if (s.ok()) {
+      s = ProcessResponse(rpcs[i].get(), tablets[i].key_idxs, rows, found);
+    }
+    if (!s.ok() && first_error.ok()) {
+      first_error = s;
+    }
+  }
+  return first_error;
+}
+
+Status KuduMultiGetter::Data::BuildRequest(const RemoteTablet& tablet,
+                                           const vector<PendingKey>& keys,
+                                           const vector<int>& key_idxs,
+                                           MultiGetRequestPB* req) const {
+  req->set_tablet_id(tablet.tablet_id());
+  for (int idx : key_idxs) {
+    req->add_encoded_keys(keys[idx].encoded_key);
+  }
+  RETURN_NOT_OK(SchemaToColumnPBs(*configuration_.projection(), req->mutable_projected_columns(),
+                                  SCHEMA_PB_WITHOUT_STORAGE_ATTRIBUTES | SCHEMA_PB_WITHOUT_IDS));
+  switch (configuration_.read_mode()) {
+    case KuduScanner::READ_LATEST: req->set_read_mode(kudu::READ_LATEST); break;
+    case KuduScanner::READ_AT_SNAPSHOT: req->set_read_mode(kudu::READ_AT_SNAPSHOT); break;
+    default: LOG(FATAL) << "Unexpected read mode.";
+  }
+  if (configuration_.read_mode() == KuduScanner::READ_AT_SNAPSHOT &&
+      snapshot_timestamp_ != ScanConfiguration::kNoTimestamp) {
+    req->set_snap_timestamp(snapshot_timestamp_);
+  }
+  return Status::OK();
+}
+
+Status KuduMultiGetter::Data::ProcessResponse(MultiGetRpc* rpc,
+                                              const vector<int>& key_idxs,
+                                              vector<KuduScanBatch::RowPtr>* rows,
+                                              vector<bool>* found) {
+  MultiGetResponsePB* resp = rpc->mutable_resp();
+  if (resp->has_snap_timestamp()) {
+    // Read the remaining tablets at the same snapshot as this one.
+    snapshot_timestamp_ = resp->snap_timestamp();
+    table_->client()->data_->UpdateLatestObservedTimestamp(resp->snap_timestamp());
+  }
+
+  if (resp->key_indexes_size() == 0) {
+    return Status::OK();
+  }
+  unique_ptr<KuduScanBatch> batch(new KuduScanBatch());
+  RETURN_NOT_OK(batch->data_->Reset(rpc->mutable_controller(),
+                                    configuration_.projection(),
+                                    configuration_.client_projection(),
+                                    make_gscoped_ptr(resp->release_data())));
+  if (PREDICT_FALSE(batch->data_->num_rows() != resp->key_indexes_size())) {
+    return Status::Corruption(Substitute("Server sent invalid response: $0 rows for $1 keys",
+                                         batch->data_->num_rows(), resp->key_indexes_size()));
+  }
+  for (int i = 0; i < resp->key_indexes_size(); i++) {
+    int key_idx = resp->key_indexes(i);
+    if (PREDICT_FALSE(key_idx >= key_idxs.size())) {
+      return Status::Corruption(Substitute("Server sent invalid response: key index $0",
+                                           key_idx));
+    }
+    (*rows)[key_idxs[key_idx]] = batch->data_->row(i);
+    (*found)[key_idxs[key_idx]] = true;
+  }
+  batches_.emplace_back(std::move(batch));
+  return Status::OK();
+}
+
+} // namespace client
+} // namespace kudu
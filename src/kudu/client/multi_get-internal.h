@@ -0,0 +1,116 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef KUDU_CLIENT_MULTI_GET_INTERNAL_H
+#define KUDU_CLIENT_MULTI_GET_INTERNAL_H
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "kudu/client/client.h"
+#include "kudu/client/scan_configuration.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/monotime.h"
+
+namespace kudu {
+
+namespace tserver {
+class MultiGetRequestPB;
+} // namespace tserver
+
+namespace client {
+
+namespace internal {
+class MultiGetRpc;
+class RemoteTablet;
+} // namespace internal
+
+class KuduMultiGetter::Data {
+ public:
+  explicit Data(KuduTable* table);
+  ~Data();
+
+  Status AddKey(const KuduPartialRow& key);
+
+  Status Execute(std::vector<KuduScanBatch::RowPtr>* rows);
+
+  ScanConfiguration* mutable_configuration() { return &configuration_; }
+
+ private:
+  // A key which has been added but not yet looked up.
+  struct PendingKey {
+    // The encoded primary key, as sent to the tablet server.
+    std::string encoded_key;
+    // The encoded partition key, used to find the tablet.
+    std::string partition_key;
+  };
+
+  // The keys which belong to one tablet.
+  struct TabletKeys {
+    scoped_refptr<internal::RemoteTablet> tablet;
+    // Indexes of the tablet's keys among the keys being looked up.
+    std::vector<int> key_idxs;
+  };
+
+  // Send the keys of each tablet in 'tablets' in a single MultiGet RPC per
+  // tablet, all at once, and wait for all of them to complete. For each key
+  // which was found, the row is stored in 'rows' and 'found' is set at the
+  // key's index. Returns the first error, if any.
+  Status GetFromTablets(const std::vector<TabletKeys>& tablets,
+                        const std::vector<PendingKey>& keys,
+                        const MonoTime& deadline,
+                        std::vector<KuduScanBatch::RowPtr>* rows,
+                        std::vector<bool>* found);
+
+  // Build the MultiGet request for the keys at 'key_idxs' in 'keys'.
+  Status BuildRequest(const internal::RemoteTablet& tablet,
+                      const std::vector<PendingKey>& keys,
+                      const std::vector<int>& key_idxs,
+                      tserver::MultiGetRequestPB* req) const;
+
+  // Store the rows returned by a successful 'rpc' for the keys at 'key_idxs'.
+  Status ProcessResponse(internal::MultiGetRpc* rpc,
+                         const std::vector<int>& key_idxs,
+                         std::vector<KuduScanBatch::RowPtr>* rows,
+                         std::vector<bool>* found);
+
+  ScanConfiguration configuration_;
+
+  // The table we're reading from.
+  KuduTable* const table_;
+
+  // The keys added since the last call to Execute(), in order.
+  std::vector<PendingKey> keys_;
+
+  // The snapshot timestamp used by the current call to Execute(), or
+  // ScanConfiguration::kNoTimestamp if it has not been chosen yet.
+  int64_t snapshot_timestamp_;
+
+  // The batches returned by the last call to Execute(). These own the
+  // memory which backs the rows returned to the user.
+  std::vector<std::unique_ptr<KuduScanBatch>> batches_;
+
+  DISALLOW_COPY_AND_ASSIGN(Data);
+};
+
+} // namespace client
+} // namespace kudu
+
+#endif
@@ -85,6 +85,7 @@ class KUDU_EXPORT KuduScanBatch {
 
  private:
   class KUDU_NO_EXPORT Data;
+  friend class KuduMultiGetter;
   friend class KuduScanner;
   friend class kudu::tools::TsAdminClient;
 
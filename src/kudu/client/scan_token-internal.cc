@@ -218,14 +218,28 @@ Status KuduScanTokenBuilder::Data::Build(vector<KuduScanToken*>* tokens) {
   while (pruner.HasMorePartitionKeyRanges()) {
     scoped_refptr<internal::RemoteTablet> tablet;
     Synchronizer sync;
+    const string partition_key = pruner.NextPartitionKey();
     client->data_->meta_cache_->LookupTabletByKey(table,
-                                                  pruner.NextPartitionKey(),
+                                                  partition_key,
                                                   deadline,
                                                   &tablet,
-                                                  sync.AsStatusCallback());
-    RETURN_NOT_OK(sync.Wait());
+                                                  sync.AsStatusCallback(),
+                                                  internal::LookupType::kLowerBound);
+    Status s = sync.Wait();
+    if (s.IsNotFound()) {
+      // No tablet covers or follows the partition key.
+      break;
+    }
+    RETURN_NOT_OK(s);
     CHECK(tablet);
 
+    if (tablet->partition().partition_key_start() > partition_key) {
+      // The partition key falls in a range which isn't covered by any tablet;
+      // skip ahead to the next tablet, which may itself be pruned.
+      pruner.RemovePartitionKeyRange(tablet->partition().partition_key_start());
+      continue;
+    }
+
     vector<internal::RemoteTabletServer*> remote_tablet_servers;
     tablet->GetRemoteTabletServers(&remote_tablet_servers);
 
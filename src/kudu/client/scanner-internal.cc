@@ -194,6 +194,38 @@ ScanRpcStatus KuduScanner::Data::AnalyzeResponse(const Status& rpc_status,
 
 Status KuduScanner::Data::OpenNextTablet(const MonoTime& deadline,
                                          std::set<std::string>* blacklist) {
+  while (true) {
+    if (!partition_pruner_.HasMorePartitionKeyRanges()) {
+      VLOG(1) << "No tablets left to scan, short circuiting";
+      short_circuit_ = true;
+      return Status::OK();
+    }
+    const string partition_key = partition_pruner_.NextPartitionKey();
+
+    scoped_refptr<internal::RemoteTablet> tablet;
+    Synchronizer sync;
+    table_->client()->data_->meta_cache_->LookupTabletByKey(table_.get(),
+                                                            partition_key,
+                                                            deadline,
+                                                            &tablet,
+                                                            sync.AsStatusCallback(),
+                                                            internal::LookupType::kLowerBound);
+    Status s = sync.Wait();
+    if (s.IsNotFound()) {
+      // No tablet covers or follows the partition key.
+      partition_pruner_.RemovePartitionKeyRange("");
+      continue;
+    }
+    RETURN_NOT_OK(s);
+
+    if (tablet->partition().partition_key_start() <= partition_key) {
+      break;
+    }
+    // The partition key falls in a range which isn't covered by any tablet;
+    // skip ahead to the next tablet.
+    partition_pruner_.RemovePartitionKeyRange(tablet->partition().partition_key_start());
+  }
+
   return OpenTablet(partition_pruner_.NextPartitionKey(),
                     deadline,
                     blacklist);
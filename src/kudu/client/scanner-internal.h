@@ -107,6 +107,10 @@ class KuduScanner::Data {
   // The deadline is the time budget for this operation.
   // The blacklist is used to temporarily filter out nodes that are experiencing transient errors.
   // This blacklist may be modified by the callee.
+  //
+  // Ranges of the partition key space which are not covered by any tablet
+  // (dropped range partitions) are skipped. If no tablets remain, the scan is
+  // short circuited and no tablet is opened.
   Status OpenNextTablet(const MonoTime& deadline, std::set<std::string>* blacklist);
 
   // Open the current tablet in the scan again.
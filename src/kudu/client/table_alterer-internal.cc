@@ -21,6 +21,8 @@
 
 #include "kudu/client/schema.h"
 #include "kudu/client/schema-internal.h"
+#include "kudu/common/partial_row.h"
+#include "kudu/common/row_operations.h"
 #include "kudu/common/wire_protocol.h"
 #include "kudu/master/master.pb.h"
 
@@ -41,6 +43,8 @@ KuduTableAlterer::Data::Data(KuduClient* client, string name)
 KuduTableAlterer::Data::~Data() {
   for (Step& s : steps_) {
     delete s.spec;
+    delete s.lower_bound;
+    delete s.upper_bound;
   }
 }
 
@@ -50,6 +54,7 @@ Status KuduTableAlterer::Data::ToRequest(AlterTableRequestPB* req) {
   }
 
   if (!rename_to_.is_initialized() &&
+      !new_row_ttl_.is_initialized() &&
       steps_.empty()) {
     return Status::InvalidArgument("No alter steps provided");
   }
@@ -59,6 +64,9 @@ Status KuduTableAlterer::Data::ToRequest(AlterTableRequestPB* req) {
   if (rename_to_.is_initialized()) {
     req->set_new_table_name(rename_to_.get());
   }
+  if (new_row_ttl_.is_initialized()) {
+    req->mutable_new_row_ttl()->CopyFrom(new_row_ttl_.get());
+  }
 
   for (const Step& s : steps_) {
     AlterTableRequestPB::Step* pb_step = req->add_alter_schema_steps();
@@ -102,6 +110,28 @@ Status KuduTableAlterer::Data::ToRequest(AlterTableRequestPB* req) {
         pb_step->mutable_rename_column()->set_new_name(s.spec->data_->rename_to);
         pb_step->set_type(AlterTableRequestPB::RENAME_COLUMN);
         break;
+      case AlterTableRequestPB::ADD_RANGE_PARTITION:
+      case AlterTableRequestPB::DROP_RANGE_PARTITION:
+      {
+        if (!s.lower_bound->schema()->Equals(*s.upper_bound->schema())) {
+          return Status::InvalidArgument("range partition bounds must have the same schema");
+        }
+        // The bounds are encoded with the schema they were created from; the
+        // master decodes them using the schema sent with the request.
+        if (!req->has_schema()) {
+          RETURN_NOT_OK(SchemaToPB(*s.lower_bound->schema(), req->mutable_schema(),
+                                   SCHEMA_PB_WITHOUT_STORAGE_ATTRIBUTES |
+                                   SCHEMA_PB_WITHOUT_IDS));
+        }
+        RowOperationsPB* range_bounds =
+            s.step_type == AlterTableRequestPB::ADD_RANGE_PARTITION ?
+            pb_step->mutable_add_range_partition()->mutable_range_bounds() :
+            pb_step->mutable_drop_range_partition()->mutable_range_bounds();
+        RowOperationsPBEncoder encoder(range_bounds);
+        encoder.Add(RowOperationsPB::RANGE_LOWER_BOUND, *s.lower_bound);
+        encoder.Add(RowOperationsPB::RANGE_UPPER_BOUND, *s.upper_bound);
+        break;
+      }
       default:
         LOG(FATAL) << "unknown step type " << s.step_type;
     }
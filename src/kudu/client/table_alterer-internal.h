@@ -50,6 +50,11 @@ class KuduTableAlterer::Data {
 
     // Owned by KuduTableAlterer::Data.
     KuduColumnSpec *spec;
+
+    // The range partition bounds of ADD_RANGE_PARTITION and
+    // DROP_RANGE_PARTITION steps. Owned by KuduTableAlterer::Data.
+    KuduPartialRow* lower_bound;
+    KuduPartialRow* upper_bound;
   };
   std::vector<Step> steps_;
 
@@ -59,6 +64,9 @@ class KuduTableAlterer::Data {
 
   boost::optional<std::string> rename_to_;
 
+  // A 'ttl_secs' of 0 removes the row TTL.
+  boost::optional<RowTtlPB> new_row_ttl_;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(Data);
 };
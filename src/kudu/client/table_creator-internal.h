@@ -44,6 +44,8 @@ class KuduTableCreator::Data {
 
   int num_replicas_;
 
+  RowTtlPB row_ttl_;
+
   MonoDelta timeout_;
 
   bool wait_;
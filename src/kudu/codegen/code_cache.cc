@@ -79,7 +79,8 @@ Status CodeCache::AddEntry(const scoped_refptr<JITWrapper>& value) {
   value->AddRef();
 
   // Insert into cache and release the handle (we have a local copy of a refptr).
-  Cache::Handle* inserted = DCHECK_NOTNULL(cache_->Insert(pending, eviction_callback_.get()));
+  Cache::Handle* inserted = DCHECK_NOTNULL(cache_->Insert(pending, eviction_callback_.get(),
+                                                            Cache::NORMAL_PRIORITY));
   cache_->Release(inserted);
   return Status::OK();
 }
@@ -17,9 +17,13 @@
 #ifndef KUDU_COMMON_COLUMNBLOCK_H
 #define KUDU_COMMON_COLUMNBLOCK_H
 
+#include <memory>
+#include <vector>
+
 #include "kudu/common/types.h"
 #include "kudu/common/row.h"
 #include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/macros.h"
 #include "kudu/util/bitmap.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/memory/overwrite.h"
@@ -29,6 +33,34 @@ namespace kudu {
 
 class ColumnBlockCell;
 
+// References to memory which is not owned by a block's arena, but which the
+// cells of the block may point into. For example, string cells read from a
+// cfile may point directly into the decoded data block, which is kept pinned
+// in the block cache by holding a reference here.
+//
+// The references must be held at least as long as the arena's contents are,
+// so they are released at the same points where the block's arena is reset
+// to start a new batch.
+class RowBlockRefs {
+ public:
+  RowBlockRefs() {}
+
+  void Retain(std::shared_ptr<const void> ref) {
+    refs_.emplace_back(std::move(ref));
+  }
+
+  void Reset() {
+    refs_.clear();
+  }
+
+  size_t size() const { return refs_.size(); }
+
+ private:
+  std::vector<std::shared_ptr<const void>> refs_;
+
+  DISALLOW_COPY_AND_ASSIGN(RowBlockRefs);
+};
+
 // A block of data all belonging to a single column.
 // This is simply a view into a buffer - it does not have any associated
 // storage in and of itself. It does, however, maintain its type
@@ -41,12 +73,14 @@ class ColumnBlock {
               uint8_t *null_bitmap,
               void *data,
               size_t nrows,
-              Arena *arena)
+              Arena *arena,
+              RowBlockRefs *refs = NULL)
     : type_(type),
       null_bitmap_(null_bitmap),
       data_(reinterpret_cast<uint8_t *>(data)),
       nrows_(nrows),
-      arena_(arena) {
+      arena_(arena),
+      refs_(refs) {
     DCHECK(data_) << "null data";
   }
 
@@ -100,6 +134,11 @@ class ColumnBlock {
 
   Arena *arena() { return arena_; }
 
+  // Returns the references retained for the lifetime of the block's data,
+  // or NULL if this block can't retain references (in which case all indirect
+  // data must be copied into the arena).
+  RowBlockRefs *refs() { return refs_; }
+
   const TypeInfo* type_info() const {
     return type_;
   }
@@ -121,6 +160,8 @@ class ColumnBlock {
   size_t nrows_;
 
   Arena *arena_;
+
+  RowBlockRefs *refs_;
 };
 
 // One of the cells in a ColumnBlock.
@@ -153,7 +194,7 @@ inline ColumnBlockCell ColumnBlock::cell(size_t idx) const {
 class ColumnDataView {
  public:
   explicit ColumnDataView(ColumnBlock *column_block, size_t first_row_idx = 0)
-    : column_block_(column_block), row_offset_(0) {
+    : column_block_(column_block), row_offset_(0), source_retained_(false) {
     Advance(first_row_idx);
   }
 
@@ -184,6 +225,18 @@ class ColumnDataView {
 
   Arena *arena() { return column_block_->arena(); }
 
+  RowBlockRefs *refs() { return column_block_->refs(); }
+
+  // Indicate that the caller has retained the source data being decoded into
+  // this view in refs(), so decoders may store pointers into the source data
+  // rather than copying indirect (e.g. string) values into the arena.
+  void set_source_retained(bool retained) {
+    DCHECK(!retained || refs() != NULL);
+    source_retained_ = retained;
+  }
+
+  bool source_retained() const { return source_retained_; }
+
   size_t nrows() const {
     return column_block_->nrows() - row_offset_;
   }
@@ -199,6 +252,7 @@ class ColumnDataView {
  private:
   ColumnBlock *column_block_;
   size_t row_offset_;
+  bool source_retained_;
 };
 
 // Utility class which allocates temporary storage for a
@@ -221,6 +221,7 @@ void MergeIterator::PrepareBatch(RowBlock* dst) {
   if (dst->arena()) {
     dst->arena()->Reset();
   }
+  dst->ReleaseRetainedRefs();
 
   // We can always provide at least as many rows as are remaining
   // in the currently queued up blocks.
@@ -495,6 +496,7 @@ Status MaterializingIterator::NextBlock(RowBlock* dst) {
   if (dst->arena()) {
     dst->arena()->Reset();
   }
+  dst->ReleaseRetainedRefs();
 
   RETURN_NOT_OK(iter_->PrepareBatch(&n));
   dst->Resize(n);
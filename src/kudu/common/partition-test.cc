@@ -447,4 +447,74 @@ TEST(PartitionTest, TestCreatePartitions) {
             partition_schema.PartitionDebugString(partitions[11], schema));
 }
 
+TEST(PartitionTest, TestCreateRangePartitionsFromBounds) {
+  // CREATE TABLE t (a VARCHAR, b VARCHAR, PRIMARY KEY (a, b))
+  // PARITITION BY [HASH BUCKET (a), RANGE (b)];
+  Schema schema({ ColumnSchema("a", STRING),
+                  ColumnSchema("b", STRING) },
+                { ColumnId(0), ColumnId(1) }, 2);
+
+  PartitionSchemaPB schema_builder;
+  SetRangePartitionComponent(&schema_builder, { "b" });
+  AddHashBucketComponent(&schema_builder, { "a" }, 2, 0);
+  PartitionSchema partition_schema;
+  ASSERT_OK(PartitionSchema::FromPB(schema_builder, schema, &partition_schema));
+
+  // Bounded range partition [("1"), ("2")):
+  //
+  // [ (0, "1"), (0, "2") )
+  // [ (1, "1"), (1, "2") )
+  KuduPartialRow lower(&schema);
+  ASSERT_OK(lower.SetStringCopy("b", "1"));
+  KuduPartialRow upper(&schema);
+  ASSERT_OK(upper.SetStringCopy("b", "2"));
+
+  vector<Partition> partitions;
+  ASSERT_OK(partition_schema.CreateRangePartitions(lower, upper, schema, &partitions));
+  ASSERT_EQ(2, partitions.size());
+
+  EXPECT_EQ(0, partitions[0].hash_buckets()[0]);
+  EXPECT_EQ("1", partitions[0].range_key_start());
+  EXPECT_EQ("2", partitions[0].range_key_end());
+  EXPECT_EQ(string("\0\0\0\0" "1", 5), partitions[0].partition_key_start());
+  EXPECT_EQ(string("\0\0\0\0" "2", 5), partitions[0].partition_key_end());
+
+  EXPECT_EQ(1, partitions[1].hash_buckets()[0]);
+  EXPECT_EQ("1", partitions[1].range_key_start());
+  EXPECT_EQ("2", partitions[1].range_key_end());
+  EXPECT_EQ(string("\0\0\0\1" "1", 5), partitions[1].partition_key_start());
+  EXPECT_EQ(string("\0\0\0\1" "2", 5), partitions[1].partition_key_end());
+
+  // Range partition [("2"), <end>), which is extended to cover the key space
+  // between the hash buckets:
+  //
+  // [ (0, "2"), (1, _) )
+  // [ (1, "2"), (_, _) )
+  KuduPartialRow unbounded(&schema);
+  ASSERT_OK(partition_schema.CreateRangePartitions(upper, unbounded, schema, &partitions));
+  ASSERT_EQ(2, partitions.size());
+
+  EXPECT_EQ("2", partitions[0].range_key_start());
+  EXPECT_EQ("", partitions[0].range_key_end());
+  EXPECT_EQ(string("\0\0\0\0" "2", 5), partitions[0].partition_key_start());
+  EXPECT_EQ(string("\0\0\0\1", 4), partitions[0].partition_key_end());
+
+  EXPECT_EQ("2", partitions[1].range_key_start());
+  EXPECT_EQ("", partitions[1].range_key_end());
+  EXPECT_EQ(string("\0\0\0\1" "2", 5), partitions[1].partition_key_start());
+  EXPECT_EQ(string("", 0), partitions[1].partition_key_end());
+
+  // The lower bound must be less than the upper bound.
+  Status s = partition_schema.CreateRangePartitions(upper, lower, schema, &partitions);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), "lower bound must be less than the upper bound");
+
+  // Bounds may only set range partition columns.
+  KuduPartialRow non_range(&schema);
+  ASSERT_OK(non_range.SetStringCopy("a", "1"));
+  s = partition_schema.CreateRangePartitions(non_range, upper, schema, &partitions);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), "may only contain values for range partitioned columns");
+}
+
 } // namespace kudu
@@ -195,25 +195,8 @@ Status PartitionSchema::EncodeKey(const ConstContiguousRow& row, string* buf) co
 Status PartitionSchema::CreatePartitions(const vector<KuduPartialRow>& split_rows,
                                          const Schema& schema,
                                          vector<Partition>* partitions) const {
-  const KeyEncoder<string>& hash_encoder = GetKeyEncoder<string>(GetTypeInfo(UINT32));
-
   // Create a partition per hash bucket combination.
-  *partitions = vector<Partition>(1);
-  for (const HashBucketSchema& bucket_schema : hash_bucket_schemas_) {
-    vector<Partition> new_partitions;
-    // For each of the partitions created so far, replicate it
-    // by the number of buckets in the next hash bucketing component
-    for (const Partition& base_partition : *partitions) {
-      for (int32_t bucket = 0; bucket < bucket_schema.num_buckets; bucket++) {
-        Partition partition = base_partition;
-        partition.hash_buckets_.push_back(bucket);
-        hash_encoder.Encode(&bucket, &partition.partition_key_start_);
-        hash_encoder.Encode(&bucket, &partition.partition_key_end_);
-        new_partitions.push_back(partition);
-      }
-    }
-    partitions->swap(new_partitions);
-  }
+  *partitions = CreateHashPartitions();
 
   unordered_set<int> range_column_idxs;
   for (ColumnId column_id : range_schema_.column_ids) {
@@ -280,6 +263,84 @@ Status PartitionSchema::CreatePartitions(const vector<KuduPartialRow>& split_row
   }
   partitions->swap(new_partitions);
 
+  ExtendPartitionsToKeySpaceBounds(partitions);
+  return Status::OK();
+}
+
+Status PartitionSchema::CreateRangePartitions(const KuduPartialRow& lower_bound,
+                                              const KuduPartialRow& upper_bound,
+                                              const Schema& schema,
+                                              vector<Partition>* partitions) const {
+  string lower_key;
+  string upper_key;
+  RETURN_NOT_OK(EncodeRangeBound(lower_bound, schema, &lower_key));
+  RETURN_NOT_OK(EncodeRangeBound(upper_bound, schema, &upper_key));
+  if (!upper_key.empty() && lower_key >= upper_key) {
+    return Status::InvalidArgument(
+        "Range partition lower bound must be less than the upper bound",
+        Substitute("lower bound: ($0), upper bound: ($1)",
+                   lower_bound.ToString(), upper_bound.ToString()));
+  }
+
+  *partitions = CreateHashPartitions();
+  for (Partition& partition : *partitions) {
+    partition.partition_key_start_.append(lower_key);
+    partition.partition_key_end_.append(upper_key);
+  }
+  ExtendPartitionsToKeySpaceBounds(partitions);
+  return Status::OK();
+}
+
+Status PartitionSchema::EncodeRangeBound(const KuduPartialRow& row,
+                                         const Schema& schema,
+                                         string* range_key) const {
+  int column_count = 0;
+  for (int column_idx = 0; column_idx < schema.num_columns(); column_idx++) {
+    if (!row.IsColumnSet(column_idx)) {
+      continue;
+    }
+    if (std::find(range_schema_.column_ids.begin(), range_schema_.column_ids.end(),
+                  schema.column_id(column_idx)) == range_schema_.column_ids.end()) {
+      return Status::InvalidArgument("Range partition bounds may only contain values for "
+                                     "range partitioned columns",
+                                     schema.column(column_idx).name());
+    }
+    column_count++;
+  }
+
+  range_key->clear();
+  if (column_count == 0) {
+    // An empty bound is unbounded.
+    return Status::OK();
+  }
+  return EncodeColumns(row, range_schema_.column_ids, range_key);
+}
+
+vector<Partition> PartitionSchema::CreateHashPartitions() const {
+  const KeyEncoder<string>& hash_encoder = GetKeyEncoder<string>(GetTypeInfo(UINT32));
+
+  vector<Partition> partitions(1);
+  for (const HashBucketSchema& bucket_schema : hash_bucket_schemas_) {
+    vector<Partition> new_partitions;
+    // For each of the partitions created so far, replicate it
+    // by the number of buckets in the next hash bucketing component
+    for (const Partition& base_partition : partitions) {
+      for (int32_t bucket = 0; bucket < bucket_schema.num_buckets; bucket++) {
+        Partition partition = base_partition;
+        partition.hash_buckets_.push_back(bucket);
+        hash_encoder.Encode(&bucket, &partition.partition_key_start_);
+        hash_encoder.Encode(&bucket, &partition.partition_key_end_);
+        new_partitions.push_back(partition);
+      }
+    }
+    partitions.swap(new_partitions);
+  }
+  return partitions;
+}
+
+void PartitionSchema::ExtendPartitionsToKeySpaceBounds(vector<Partition>* partitions) const {
+  const KeyEncoder<string>& hash_encoder = GetKeyEncoder<string>(GetTypeInfo(UINT32));
+
   // Note: the following discussion and logic only takes effect when the table's
   // partition schema includes at least one hash bucket component.
   //
@@ -317,8 +378,6 @@ Status PartitionSchema::CreatePartitions(const vector<KuduPartialRow>& split_row
       }
     }
   }
-
-  return Status::OK();
 }
 
 template<typename Row>
@@ -151,6 +151,17 @@ class PartitionSchema {
                           const Schema& schema,
                           std::vector<Partition>* partitions) const WARN_UNUSED_RESULT;
 
+  // Creates the set of partitions for a single range partition spanning
+  // [lower_bound, upper_bound). A bound with no columns set is unbounded.
+  //
+  // The number of resulting partitions is the product of the number of hash
+  // buckets for each hash bucket component. Every resulting partition has the
+  // same range key start and end.
+  Status CreateRangePartitions(const KuduPartialRow& lower_bound,
+                               const KuduPartialRow& upper_bound,
+                               const Schema& schema,
+                               std::vector<Partition>* partitions) const WARN_UNUSED_RESULT;
+
   // Tests if the partition contains the row.
   Status PartitionContainsRow(const Partition& partition,
                               const KuduPartialRow& row,
@@ -208,6 +219,21 @@ class PartitionSchema {
                               const std::vector<ColumnId>& column_ids,
                               std::string* buf);
 
+  // Encodes a range partition bound into a range key, checking that it only
+  // sets range partition columns. A row with no columns set is encoded as the
+  // empty (unbounded) key.
+  Status EncodeRangeBound(const KuduPartialRow& row,
+                          const Schema& schema,
+                          std::string* range_key) const;
+
+  // Creates one partition, with empty range keys, per combination of hash
+  // buckets.
+  std::vector<Partition> CreateHashPartitions() const;
+
+  // Extends partitions with an unbounded range key start or end to cover the
+  // partition key space between hash bucket components.
+  void ExtendPartitionsToKeySpaceBounds(std::vector<Partition>* partitions) const;
+
   // Returns the hash bucket of the encoded hash column. The encoded columns must match the
   // columns of the hash bucket schema.
   static int32_t BucketForEncodedColumns(const std::string& encoded_hash_columns,
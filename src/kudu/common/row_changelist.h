@@ -174,6 +174,17 @@ class RowChangeListEncoder {
                        int col_id,
                        const void* cell_ptr);
 
+  // Add a column update by a raw value. This allows copying RCLs
+  // from one file to another without having any awareness of schema.
+  //
+  // If 'is_null' is set, then encodes a SET [col_id]=NULL update.
+  // Otherwise, SET [col_id] = 'new_val'.
+  //
+  // 'new_val' is the encoded form of the new value. In the case of
+  // a STRING, this is the actual user-provided STRING. Otherwise,
+  // it is the fixed-length representation of the type.
+  void AddRawColumnUpdate(int col_id, bool is_null, Slice new_val);
+
 
   RowChangeList as_changelist() {
     DCHECK_GT(dst_->size(), 0);
@@ -199,18 +210,6 @@ class RowChangeListEncoder {
     dst_->push_back(type);
   }
 
-  // Add a column update by a raw value. This allows copying RCLs
-  // from one file to another without having any awareness of schema.
-  //
-  // If 'is_null' is set, then encodes a SET [col_id]=NULL update.
-  // Otherwise, SET [col_id] = 'new_val'.
-  //
-  // 'new_val' is the encoded form of the new value. In the case of
-  // a STRING, this is the actual user-provided STRING. Otherwise,
-  // it is the fixed-length representation of the type.
-  void AddRawColumnUpdate(int col_id, bool is_null, Slice new_val);
-
-
   RowChangeList::ChangeType type_;
   faststring *dst_;
 };
@@ -63,7 +63,8 @@ struct DecodedRowOperation {
   // For UPDATE and DELETE types, the changelist
   RowChangeList changelist;
 
-  // For SPLIT_ROW, the partial row to split on.
+  // For SPLIT_ROW, the partial row to split on. For RANGE_LOWER_BOUND and
+  // RANGE_UPPER_BOUND, the partial row holding the range partition bound.
   std::shared_ptr<KuduPartialRow> split_row;
 
   std::string ToString(const Schema& schema) const;
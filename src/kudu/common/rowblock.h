@@ -153,6 +153,11 @@ class RowBlock {
   const Schema &schema() const { return schema_; }
   Arena *arena() const { return arena_; }
 
+  // Release the references retained by the cells of this block (see
+  // RowBlockRefs). This should be called wherever the block's arena is reset
+  // to start a new batch.
+  void ReleaseRetainedRefs() { refs_.Reset(); }
+
   ColumnBlock column_block(size_t col_idx) const {
     return column_block(col_idx, nrows_);
   }
@@ -164,7 +169,7 @@ class RowBlock {
     uint8_t *col_data = columns_data_[col_idx];
     uint8_t *nulls_bitmap = column_null_bitmaps_[col_idx];
 
-    return ColumnBlock(col_schema.type_info(), nulls_bitmap, col_data, nrows, arena_);
+    return ColumnBlock(col_schema.type_info(), nulls_bitmap, col_data, nrows, arena_, &refs_);
   }
 
   // Return the base pointer for the given column's data.
@@ -240,6 +245,11 @@ class RowBlock {
 
   Arena *arena_;
 
+  // References to data outside of the arena which is pointed to by cells in
+  // this block. Mutable since ColumnBlocks handed out by const accessors may
+  // retain references into it.
+  mutable RowBlockRefs refs_;
+
   // The bitmap indicating which rows are valid in this block.
   // Deleted rows or rows which have failed to pass predicates will be zeroed
   // in the bitmap, and thus not returned to the end user.
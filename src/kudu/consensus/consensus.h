@@ -314,10 +314,29 @@ class Consensus : public RefCountedThreadSafe<Consensus> {
 // - Once Apply() completes the ReplicaTransactionFactory is responsible for logging
 //   a CommitMsg to the log to ensure that the operation can be properly restored
 //   on a restart.
+//
+// The factory also provides and consumes the "safe timestamps" which let
+// followers serve snapshot scans: see ConsensusRequestPB.safe_timestamp.
 class ReplicaTransactionFactory {
  public:
   virtual Status StartReplicaTransaction(const scoped_refptr<ConsensusRound>& context) = 0;
 
+  // Called on the leader. Sets 'safe_timestamp' to a timestamp such that every
+  // operation with a lower or equal timestamp has already been appended to
+  // the queue, and returns true. Returns false if there is none to propagate.
+  virtual bool GetSafeTimestampForFollowers(uint64_t* safe_timestamp) {
+    return false;
+  }
+
+  // Called on the leader, about once per heartbeat period, so that the safe
+  // timestamp keeps advancing while no operation commits.
+  virtual void AdvanceSafeTimestampForFollowers() {}
+
+  // Called on followers with a safe timestamp received from the leader, once
+  // StartReplicaTransaction() has been called for every operation the leader
+  // had appended when it computed it.
+  virtual void AdvanceFollowerSafeTimestamp(uint64_t safe_timestamp) {}
+
   virtual ~ReplicaTransactionFactory() {}
 };
 
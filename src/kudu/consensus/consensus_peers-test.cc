@@ -44,6 +44,36 @@ const char* kTabletId = "test-peers-tablet";
 const char* kLeaderUuid = "peer-0";
 const char* kFollowerUuid = "peer-1";
 
+// A NoOpTestPeerProxy which, like RpcPeerProxy, serializes the requests it
+// sends: the remote endpoint sees what it would parse off the wire.
+class SerializingNoOpTestPeerProxy : public NoOpTestPeerProxy {
+ public:
+  SerializingNoOpTestPeerProxy(ThreadPool* pool, const RaftPeerPB& peer_pb)
+      : NoOpTestPeerProxy(pool, peer_pb),
+        num_ops_received_(0) {
+  }
+
+  virtual bool SerializesRequests() const OVERRIDE { return true; }
+
+  virtual void UpdateAsync(const ConsensusRequestPB* request,
+                           ConsensusResponsePB* response,
+                           rpc::RpcController* controller,
+                           const rpc::ResponseCallback& callback) OVERRIDE {
+    std::string wire;
+    CHECK(request->SerializeToString(&wire));
+    CHECK(received_.ParseFromString(wire));
+    CHECK_EQ(0, received_.unknown_fields().field_count());
+    for (const ReplicateMsg& op : received_.ops()) {
+      CHECK_EQ(++num_ops_received_, op.id().index());
+    }
+    return NoOpTestPeerProxy::UpdateAsync(&received_, response, controller, callback);
+  }
+
+ private:
+  ConsensusRequestPB received_;
+  int64_t num_ops_received_;
+};
+
 class ConsensusPeersTest : public KuduTest {
  public:
   ConsensusPeersTest()
@@ -172,6 +202,36 @@ TEST_F(ConsensusPeersTest, TestRemotePeer) {
   CheckLastRemoteEntry(proxy, 2, 20);
 }
 
+// Tests that the ops which a peer sends through a serializing proxy are
+// received intact and in order.
+TEST_F(ConsensusPeersTest, TestRemotePeerWithSerializedOps) {
+  message_queue_->Init(MinimumOpId());
+  message_queue_->SetLeaderMode(MinimumOpId(),
+                                MinimumOpId().term(),
+                                BuildRaftConfigPBForTests(3));
+
+  RaftPeerPB peer_pb;
+  peer_pb.set_permanent_uuid(kFollowerUuid);
+  auto proxy = new SerializingNoOpTestPeerProxy(pool_.get(), peer_pb);
+  gscoped_ptr<Peer> remote_peer;
+  ASSERT_OK(Peer::NewRemotePeer(peer_pb,
+                                kTabletId,
+                                kLeaderUuid,
+                                message_queue_.get(),
+                                pool_.get(),
+                                gscoped_ptr<PeerProxy>(proxy),
+                                &remote_peer));
+
+  AppendReplicateMessagesToQueue(message_queue_.get(), clock_, 1, 20);
+  remote_peer->SetTermForTest(2);
+  remote_peer->SignalRequest();
+  WaitForMajorityReplicatedIndex(20);
+
+  OpId last_received = proxy->last_received();
+  ASSERT_EQ(2, last_received.term());
+  ASSERT_EQ(20, last_received.index());
+}
+
 TEST_F(ConsensusPeersTest, TestRemotePeers) {
   message_queue_->Init(MinimumOpId());
   message_queue_->SetLeaderMode(MinimumOpId(),
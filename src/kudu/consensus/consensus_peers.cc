@@ -219,10 +219,31 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
       << request_.ShortDebugString();
   controller_.Reset();
 
-  proxy_->UpdateAsync(&request_, &response_, &controller_,
+  // Heartbeats must get through even when the connection to the peer is busy
+  // with large transfers, or the peer would start an election.
+  controller_.set_high_priority(request_.ops_size() == 0);
+
+  const ConsensusRequestPB* request = &request_;
+  if (proxy_->SerializesRequests() && request_.ops_size() > 0) {
+    BuildWireRequest();
+    request = &wire_request_;
+  }
+  proxy_->UpdateAsync(request, &response_, &controller_,
                       boost::bind(&Peer::ProcessResponse, this));
 }
 
+void Peer::BuildWireRequest() {
+  DCHECK_EQ(request_.ops_size(), replicate_msg_refs_.size());
+  // Copy everything but the ops, which the queue owns.
+  request_.mutable_ops()->ExtractSubrange(0, request_.ops_size(), nullptr);
+  wire_request_.CopyFrom(request_);
+  for (const ReplicateRefPtr& msg : replicate_msg_refs_) {
+    request_.mutable_ops()->AddAllocated(msg->get());
+    wire_request_.mutable_unknown_fields()->AddLengthDelimited(
+        ConsensusRequestPB::kOpsFieldNumber, msg->serialized());
+  }
+}
+
 void Peer::ProcessResponse() {
   // Note: This method runs on the reactor thread.
 
@@ -177,6 +177,18 @@ class Peer {
 
   const std::string& tablet_id() const { return tablet_id_; }
 
+  // Sets 'wire_request_' to a copy of 'request_' whose ops are attached
+  // as pre-serialized length-delimited fields with the field number of
+  // ConsensusRequestPB.ops, which is the same encoding as the messages
+  // themselves. This way each op is serialized only once, however many
+  // peers it is sent to, and the receiver parses 'ops' as usual.
+  //
+  // The serialized bytes are still copied twice per peer: here, and when the
+  // RPC layer serializes 'wire_request_'. Sending them straight from the log
+  // cache would need the RPC layer to support request sidecars, or more
+  // payload slices than OutboundTransfer::kMaxPayloadSlices.
+  void BuildWireRequest();
+
   const std::string tablet_id_;
   const std::string leader_uuid_;
 
@@ -191,6 +203,11 @@ class Peer {
   ConsensusRequestPB request_;
   ConsensusResponsePB response_;
 
+  // The latest consensus update request as sent by a proxy which serializes
+  // requests: a copy of 'request_' carrying its ops in the serialized form
+  // cached in 'replicate_msg_refs_'. See BuildWireRequest().
+  ConsensusRequestPB wire_request_;
+
   // The latest remote bootstrap request and response.
   StartRemoteBootstrapRequestPB rb_request_;
   StartRemoteBootstrapResponsePB rb_response_;
@@ -257,6 +274,10 @@ class PeerProxy {
     LOG(DFATAL) << "Not implemented";
   }
 
+  // Returns true if UpdateAsync() serializes the request, in which case the
+  // peer sends its ops in their cached serialized form.
+  virtual bool SerializesRequests() const { return false; }
+
   virtual ~PeerProxy() {}
 };
 
@@ -292,6 +313,8 @@ class RpcPeerProxy : public PeerProxy {
                                     rpc::RpcController* controller,
                                     const rpc::ResponseCallback& callback) OVERRIDE;
 
+  virtual bool SerializesRequests() const OVERRIDE { return true; }
+
   virtual ~RpcPeerProxy();
 
  private:
@@ -45,6 +45,21 @@ static const char* kLeaderUuid = "peer-0";
 static const char* kPeerUuid = "peer-1";
 static const char* kTestTablet = "test-tablet";
 
+static const uint64_t kSafeTimestamp = 12345;
+
+// Hands out a fixed safe timestamp.
+class FixedSafeTimestampSource : public ReplicaTransactionFactory {
+ public:
+  Status StartReplicaTransaction(const scoped_refptr<ConsensusRound>& round) OVERRIDE {
+    return Status::NotSupported("no replica transactions");
+  }
+
+  bool GetSafeTimestampForFollowers(uint64_t* safe_timestamp) OVERRIDE {
+    *safe_timestamp = kSafeTimestamp;
+    return true;
+  }
+};
+
 class ConsensusQueueTest : public KuduTest {
  public:
   ConsensusQueueTest()
@@ -191,6 +206,7 @@ class ConsensusQueueTest : public KuduTest {
   MetricRegistry metric_registry_;
   scoped_refptr<MetricEntity> metric_entity_;
   scoped_refptr<log::Log> log_;
+  FixedSafeTimestampSource safe_timestamp_source_;
   gscoped_ptr<PeerMessageQueue> queue_;
   scoped_refptr<log::LogAnchorRegistry> registry_;
   scoped_refptr<server::Clock> clock_;
@@ -305,6 +321,52 @@ TEST_F(ConsensusQueueTest, TestGetPagedMessages) {
   request.mutable_ops()->ExtractSubrange(0, request.ops_size(), nullptr);
 }
 
+// Only a request which brings the peer up to date with the queue carries the
+// leader's safe timestamp.
+TEST_F(ConsensusQueueTest, TestSafeTimestampOnlySentToCaughtUpPeers) {
+  queue_->SetSafeTimestampSource(&safe_timestamp_source_);
+  queue_->Init(MinimumOpId());
+  queue_->SetLeaderMode(MinimumOpId(), MinimumOpId().term(), BuildRaftConfigPBForTests(2));
+
+  ConsensusRequestPB request;
+  ConsensusResponsePB response;
+  response.set_responder_uuid(kPeerUuid);
+  bool more_pending = false;
+  UpdatePeerWatermarkToOp(&request, &response, MinimumOpId(), MinimumOpId(), &more_pending);
+
+  // Make the 100 ops take several requests.
+  google::FlagSaver saver;
+  FLAGS_consensus_max_batch_size_bytes = 4096;
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 1, 100, 100);
+
+  int num_requests = 0;
+  do {
+    vector<ReplicateRefPtr> refs;
+    bool needs_remote_bootstrap;
+    ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_remote_bootstrap));
+    ASSERT_FALSE(needs_remote_bootstrap);
+    ASSERT_GT(request.ops_size(), 0);
+    OpId last = request.ops(request.ops_size() - 1).id();
+    if (last.index() < 100) {
+      ASSERT_FALSE(request.has_safe_timestamp());
+    } else {
+      ASSERT_EQ(kSafeTimestamp, request.safe_timestamp());
+    }
+    SetLastReceivedAndLastCommitted(&response, last);
+    queue_->ResponseFromPeer(response.responder_uuid(), response, &more_pending);
+    request.mutable_ops()->ExtractSubrange(0, request.ops_size(), nullptr);
+    num_requests++;
+  } while (more_pending);
+  ASSERT_GT(num_requests, 1);
+
+  // A heartbeat to the caught up peer carries it too.
+  vector<ReplicateRefPtr> refs;
+  bool needs_remote_bootstrap;
+  ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_remote_bootstrap));
+  ASSERT_EQ(0, request.ops_size());
+  ASSERT_EQ(kSafeTimestamp, request.safe_timestamp());
+}
+
 TEST_F(ConsensusQueueTest, TestPeersDontAckBeyondWatermarks) {
   queue_->Init(MinimumOpId());
   queue_->SetLeaderMode(MinimumOpId(), MinimumOpId().term(), BuildRaftConfigPBForTests(3));
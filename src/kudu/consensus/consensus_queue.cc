@@ -63,6 +63,8 @@ DEFINE_int32(consensus_inject_latency_ms_in_notifications, 0,
 TAG_FLAG(consensus_inject_latency_ms_in_notifications, hidden);
 TAG_FLAG(consensus_inject_latency_ms_in_notifications, unsafe);
 
+DECLARE_int32(raft_heartbeat_interval_ms);
+
 namespace kudu {
 namespace consensus {
 
@@ -104,6 +106,7 @@ PeerMessageQueue::PeerMessageQueue(const scoped_refptr<MetricEntity>& metric_ent
                                    const string& tablet_id)
     : local_peer_pb_(local_peer_pb),
       tablet_id_(tablet_id),
+      safe_timestamp_source_(nullptr),
       log_cache_(metric_entity, log, local_peer_pb.permanent_uuid(), tablet_id),
       metrics_(metric_entity) {
   DCHECK(local_peer_pb_.has_permanent_uuid());
@@ -118,6 +121,10 @@ PeerMessageQueue::PeerMessageQueue(const scoped_refptr<MetricEntity>& metric_ent
   CHECK_OK(ThreadPoolBuilder("queue-observers-pool").set_max_threads(1).Build(&observers_pool_));
 }
 
+void PeerMessageQueue::SetSafeTimestampSource(ReplicaTransactionFactory* source) {
+  safe_timestamp_source_ = source;
+}
+
 void PeerMessageQueue::Init(const OpId& last_locally_replicated) {
   boost::lock_guard<simple_spinlock> lock(queue_lock_);
   CHECK_EQ(queue_state_.state, kQueueConstructed);
@@ -271,12 +278,36 @@ Status PeerMessageQueue::AppendOperations(const vector<ReplicateRefPtr>& msgs,
   return Status::OK();
 }
 
+void PeerMessageQueue::MaybeAdvanceSafeTimestamp() {
+  MonoTime now = MonoTime::Now(MonoTime::FINE);
+  {
+    lock_guard<simple_spinlock> lock(&queue_lock_);
+    if (last_safe_timestamp_advance_.Initialized() &&
+        now.GetDeltaSince(last_safe_timestamp_advance_).ToMilliseconds() <
+        FLAGS_raft_heartbeat_interval_ms) {
+      return;
+    }
+    last_safe_timestamp_advance_ = now;
+  }
+  safe_timestamp_source_->AdvanceSafeTimestampForFollowers();
+}
+
 Status PeerMessageQueue::RequestForPeer(const string& uuid,
                                         ConsensusRequestPB* request,
                                         vector<ReplicateRefPtr>* msg_refs,
                                         bool* needs_remote_bootstrap) {
+  // The safe timestamp must be computed before reading the last appended op:
+  // every op at or below it has been appended by then.
+  if (safe_timestamp_source_ != nullptr) {
+    MaybeAdvanceSafeTimestamp();
+  }
+  uint64_t safe_timestamp;
+  bool has_safe_timestamp = safe_timestamp_source_ != nullptr &&
+      safe_timestamp_source_->GetSafeTimestampForFollowers(&safe_timestamp);
+
   TrackedPeer* peer = nullptr;
   OpId preceding_id;
+  int64_t last_appended_index;
   {
     lock_guard<simple_spinlock> lock(&queue_lock_);
     DCHECK_EQ(queue_state_.state, kQueueOpen);
@@ -293,6 +324,7 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
     // This is initialized to the queue's last appended op but gets set to the id of the
     // log entry preceding the first one in 'messages' if messages are found for the peer.
     preceding_id = queue_state_.last_appended;
+    last_appended_index = queue_state_.last_appended.index();
     request->mutable_committed_index()->CopyFrom(queue_state_.committed_index);
     request->set_caller_term(queue_state_.current_term);
   }
@@ -371,6 +403,16 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
   DCHECK(preceding_id.IsInitialized());
   request->mutable_preceding_id()->CopyFrom(preceding_id);
 
+  // The safe timestamp only holds for a peer which will have received every
+  // op appended before it was computed.
+  int64_t last_index_sent = request->ops_size() > 0 ?
+      request->ops(request->ops_size() - 1).id().index() : preceding_id.index();
+  if (has_safe_timestamp && last_index_sent >= last_appended_index) {
+    request->set_safe_timestamp(safe_timestamp);
+  } else {
+    request->clear_safe_timestamp();
+  }
+
   if (PREDICT_FALSE(VLOG_IS_ON(2))) {
     if (request->ops_size() > 0) {
       VLOG_WITH_PREFIX_UNLOCKED(2) << "Sending request with operations to Peer: " << uuid
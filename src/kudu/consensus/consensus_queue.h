@@ -48,6 +48,7 @@ class AsyncLogReader;
 
 namespace consensus {
 class PeerMessageQueueObserver;
+class ReplicaTransactionFactory;
 
 // The id for the server-wide consensus queue MemTracker.
 extern const char kConsensusQueueParentTrackerId[];
@@ -130,6 +131,11 @@ class PeerMessageQueue {
   // Initialize the queue.
   virtual void Init(const OpId& last_locally_replicated);
 
+  // Sets the source of the safe timestamps attached to the requests sent to
+  // peers. Must be called before the queue is put in leader mode; 'source'
+  // must outlive the queue.
+  void SetSafeTimestampSource(ReplicaTransactionFactory* source);
+
   // Changes the queue to leader mode, meaning it tracks majority replicated
   // operations and notifies observers when those change.
   // 'committed_index' corresponds to the id of the last committed operation,
@@ -344,6 +350,12 @@ class PeerMessageQueue {
   // Updates the metrics based on index math.
   void UpdateMetrics();
 
+  // Asks the safe timestamp source to advance its safe timestamp, unless it
+  // already did so within the last heartbeat period. On a busy tablet the
+  // safe timestamp advances as operations commit; this only matters to idle
+  // ones, and keeps every request to a peer from having to advance it.
+  void MaybeAdvanceSafeTimestamp();
+
   void ClearUnlocked();
 
   // Returns the last operation in the message queue, or
@@ -382,6 +394,13 @@ class PeerMessageQueue {
   // The id of the tablet.
   const std::string tablet_id_;
 
+  // The source of the safe timestamps sent to peers, or NULL.
+  ReplicaTransactionFactory* safe_timestamp_source_;
+
+  // When the safe timestamp source was last asked to advance its safe
+  // timestamp. Protected by 'queue_lock_'.
+  MonoTime last_safe_timestamp_advance_;
+
   QueueState queue_state_;
 
   // The currently tracked peers.
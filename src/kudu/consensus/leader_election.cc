@@ -221,6 +221,7 @@ void LeaderElection::Run() {
     // Send the RPC request.
     LOG_WITH_PREFIX(INFO) << "Requesting vote from peer " << voter_uuid;
     state->rpc.set_timeout(timeout_);
+    state->rpc.set_high_priority(true);
 
     state->request = request_;
     state->request.set_dest_uuid(voter_uuid);
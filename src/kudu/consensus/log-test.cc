@@ -536,6 +536,62 @@ TEST_F(LogTest, TestGCWithLogRunning) {
   }
 }
 
+// Tests that GCed segment files are reused for new segments, and that the
+// stale data left behind in a recycled file is never read back as part of
+// the segment that now occupies it.
+TEST_F(LogTest, TestRecycledSegmentIgnoresStaleData) {
+  options_.max_recycled_segments = 1;
+  BuildLog();
+
+  vector<LogAnchor*> anchors;
+  ElementDeleter deleter(&anchors);
+
+  OpId op_id = MakeOpId(1, 1);
+  int num_gced_segments;
+  int64_t anchored_index = -1;
+  ASSERT_OK(AppendMultiSegmentSequence(4, 5, &op_id, &anchors));
+
+  ASSERT_OK(log_anchor_registry_->Unregister(anchors[0]));
+  ASSERT_OK(log_anchor_registry_->Unregister(anchors[1]));
+  ASSERT_OK(log_anchor_registry_->GetEarliestRegisteredLogIndex(&anchored_index));
+  ASSERT_OK(log_->GC(anchored_index, &num_gced_segments));
+  ASSERT_EQ(2, num_gced_segments);
+
+  // Only one of the two GCed segment files is kept for reuse.
+  vector<string> files;
+  ASSERT_OK(env_->GetChildren(JoinPathSegments(fs_manager_->GetWalsRootDir(), kTestTablet),
+                              &files));
+  int num_recycled = 0;
+  for (const string& f : files) {
+    if (HasPrefixString(f, ".recycled-")) {
+      num_recycled++;
+    }
+  }
+  ASSERT_EQ(1, num_recycled);
+
+  // Roll onto the recycled file and write a single op to it, leaving most of
+  // the older segment's entries and its footer after the new data.
+  ASSERT_OK(RollLog());
+  ASSERT_TRUE(log_->active_segment_->header().has_epoch());
+  ASSERT_OK(AppendNoOps(&op_id, 1));
+
+  // Read the segment the way bootstrap would after a crash, i.e. before the
+  // stale tail is truncated away by closing the segment.
+  scoped_refptr<ReadableLogSegment> segment;
+  ASSERT_OK(ReadableLogSegment::Open(env_.get(), log_->active_segment_->path(), &segment));
+  ASSERT_FALSE(segment->HasFooter());
+  ASSERT_OK(segment->RebuildFooterByScanning());
+  ASSERT_EQ(1, segment->footer().num_entries());
+  ASSERT_EQ(op_id.index() - 1, segment->footer().max_replicate_index());
+
+  ASSERT_OK(log_->Close());
+  CheckRightNumberOfSegmentFiles(3);
+
+  for (int i = 2; i < anchors.size(); i++) {
+    ASSERT_OK(log_anchor_registry_->Unregister(anchors[i]));
+  }
+}
+
 // Test that, when we are set to retain a given number of log segments,
 // we also retain any relevant log index chunks, even if those operations
 // are not necessary for recovery.
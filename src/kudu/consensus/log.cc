@@ -29,6 +29,7 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/strings/util.h"
 #include "kudu/gutil/walltime.h"
 #include "kudu/util/coding.h"
 #include "kudu/util/countdown_latch.h"
@@ -42,6 +43,7 @@
 #include "kudu/util/path_util.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/random.h"
+#include "kudu/util/random_util.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/thread.h"
 #include "kudu/util/threadpool.h"
@@ -106,6 +108,7 @@ static bool dummy = google::RegisterFlagValidator(
     &FLAGS_log_min_segments_to_retain, &ValidateLogsToRetain);
 
 static const char kSegmentPlaceholderFileTemplate[] = ".tmp.newsegmentXXXXXX";
+static const char kRecycledSegmentFilePrefix[] = ".recycled-";
 
 namespace kudu {
 namespace log {
@@ -292,6 +295,7 @@ Log::Log(LogOptions options, FsManager* fs_manager, string log_path,
       append_thread_(new AppendThread(this)),
       force_sync_all_(options_.force_fsync_all),
       sync_disabled_(false),
+      next_segment_recycled_(false),
       allocation_state_(kAllocationNotStarted),
       metric_entity_(metric_entity) {
   CHECK_OK(ThreadPoolBuilder("log-alloc").set_max_threads(1).Build(&allocation_pool_));
@@ -326,6 +330,8 @@ Status Log::Init() {
     active_segment_sequence_number_ = segments.back()->header().sequence_number();
   }
 
+  RETURN_NOT_OK(LoadRecycledSegments());
+
   if (force_sync_all_) {
     KLOG_FIRST_N(INFO, 1) << "Log is configured to fsync() on all Append() calls";
   } else {
@@ -467,6 +473,26 @@ Status Log::AsyncAppendCommit(gscoped_ptr<consensus::CommitMsg> commit_msg,
   return Status::OK();
 }
 
+Status Log::AsyncAppendCommits(vector<consensus::CommitMsg*>* commit_msgs,
+                               const StatusCallback& callback) {
+  MAYBE_FAULT(FLAGS_fault_crash_before_append_commit);
+
+  gscoped_ptr<LogEntryBatchPB> batch(new LogEntryBatchPB);
+  batch->mutable_entry()->Reserve(commit_msgs->size());
+  for (consensus::CommitMsg* commit_msg : *commit_msgs) {
+    LogEntryPB* entry = batch->add_entry();
+    entry->set_type(COMMIT);
+    entry->set_allocated_commit(commit_msg);
+  }
+  commit_msgs->clear();
+
+  LogEntryBatch* reserved_entry_batch;
+  RETURN_NOT_OK(Reserve(COMMIT, std::move(batch), &reserved_entry_batch));
+
+  RETURN_NOT_OK(AsyncAppend(reserved_entry_batch, callback));
+  return Status::OK();
+}
+
 Status Log::DoAppend(LogEntryBatch* entry_batch, bool caller_owns_operation) {
   size_t num_entries = entry_batch->count();
   DCHECK_GT(num_entries, 0) << "Cannot call DoAppend() with zero entries reserved";
@@ -722,12 +748,14 @@ Status Log::GC(int64_t min_op_idx, int32_t* num_gced) {
           segments_to_delete[segments_to_delete.size() - 1]->header().sequence_number()));
     }
 
-    // Now that they are no longer referenced by the Log, delete the files.
+    // Now that they are no longer referenced by the Log, recycle or delete
+    // the files.
     *num_gced = 0;
-    for (const scoped_refptr<ReadableLogSegment>& segment : segments_to_delete) {
-      LOG(INFO) << "Deleting log segment in path: " << segment->path()
+    for (scoped_refptr<ReadableLogSegment>& segment : segments_to_delete) {
+      LOG(INFO) << "GCing log segment in path: " << segment->path()
                 << " (GCed ops < " << min_op_idx << ")";
-      RETURN_NOT_OK(fs_manager_->env()->DeleteFile(segment->path()));
+      RETURN_NOT_OK(RecycleOrDeleteSegment(segment));
+      segment.reset();
       (*num_gced)++;
     }
 
@@ -834,15 +862,28 @@ Status Log::PreAllocateNewSegment() {
   TRACE_EVENT1("log", "PreAllocateNewSegment", "file", next_segment_path_);
   CHECK_EQ(allocation_state(), kAllocationInProgress);
 
-  WritableFileOptions opts;
-  opts.sync_on_close = force_sync_all_;
-  RETURN_NOT_OK(CreatePlaceholderSegment(opts, &next_segment_path_, &next_segment_file_));
-
-  if (options_.preallocate_segments) {
-    TRACE("Preallocating $0 byte segment in $1", max_segment_size_, next_segment_path_);
-    // TODO (perf) zero the new segments -- this could result in
-    // additional performance improvements.
-    RETURN_NOT_OK(next_segment_file_->PreAllocate(max_segment_size_));
+  next_segment_recycled_ = TakeRecycledSegment(&next_segment_path_, &next_segment_file_);
+  if (next_segment_recycled_) {
+    // The recycled file already owns the blocks of the segment it used to
+    // hold; only allocate whatever is missing to reach a full segment.
+    uint64_t existing_size;
+    RETURN_NOT_OK(fs_manager_->env()->GetFileSize(next_segment_path_, &existing_size));
+    if (options_.preallocate_segments && existing_size < max_segment_size_) {
+      TRACE("Preallocating $0 more bytes for recycled segment $1",
+            max_segment_size_ - existing_size, next_segment_path_);
+      RETURN_NOT_OK(next_segment_file_->PreAllocate(max_segment_size_ - existing_size));
+    }
+  } else {
+    WritableFileOptions opts;
+    opts.sync_on_close = force_sync_all_;
+    RETURN_NOT_OK(CreatePlaceholderSegment(opts, &next_segment_path_, &next_segment_file_));
+
+    if (options_.preallocate_segments) {
+      TRACE("Preallocating $0 byte segment in $1", max_segment_size_, next_segment_path_);
+      // TODO (perf) zero the new segments -- this could result in
+      // additional performance improvements.
+      RETURN_NOT_OK(next_segment_file_->PreAllocate(max_segment_size_));
+    }
   }
 
   {
@@ -861,11 +902,6 @@ Status Log::SwitchToAllocatedSegment() {
   string new_segment_path = fs_manager_->GetWalSegmentFileName(tablet_id_,
                                                                active_segment_sequence_number_);
 
-  RETURN_NOT_OK(fs_manager_->env()->RenameFile(next_segment_path_, new_segment_path));
-  if (force_sync_all_) {
-    RETURN_NOT_OK(fs_manager_->env()->SyncDir(log_dir_));
-  }
-
   // Create a new segment.
   gscoped_ptr<WritableLogSegment> new_segment(
       new WritableLogSegment(new_segment_path, next_segment_file_));
@@ -881,6 +917,14 @@ Status Log::SwitchToAllocatedSegment() {
   footer_builder_.Clear();
   footer_builder_.set_num_entries(0);
 
+  // A recycled file still holds an older segment's entries and footer past
+  // the point we will have written. Give the segment a fresh epoch so that
+  // none of them validate as part of this segment.
+  if (next_segment_recycled_) {
+    uint64_t epoch = Random(GetRandomSeed32()).Next64();
+    header.set_epoch(epoch);
+    footer_builder_.set_epoch(epoch);
+  }
 
   // Set the new segment's schema.
   {
@@ -889,7 +933,19 @@ Status Log::SwitchToAllocatedSegment() {
     header.set_schema_version(schema_version_);
   }
 
+  // Write the header before giving the file its segment name. A recycled
+  // file's header is also synced first: otherwise a crash right after the
+  // rename could leave the older segment's header, and all of its entries,
+  // under the new name.
   RETURN_NOT_OK(new_segment->WriteHeaderAndOpen(header));
+  if (next_segment_recycled_) {
+    RETURN_NOT_OK(new_segment->Sync());
+  }
+
+  RETURN_NOT_OK(fs_manager_->env()->RenameFile(next_segment_path_, new_segment_path));
+  if (force_sync_all_) {
+    RETURN_NOT_OK(fs_manager_->env()->SyncDir(log_dir_));
+  }
 
   // Transform the currently-active segment into a readable one, since we
   // need to be able to replay the segments for other peers.
@@ -951,6 +1007,80 @@ Status Log::CreatePlaceholderSegment(const WritableFileOptions& opts,
   return Status::OK();
 }
 
+bool Log::TakeRecycledSegment(string* result_path, shared_ptr<WritableFile>* out) {
+  while (true) {
+    string path;
+    {
+      boost::lock_guard<simple_spinlock> l(recycled_segments_lock_);
+      if (recycled_segment_paths_.empty()) {
+        return false;
+      }
+      path = recycled_segment_paths_.front();
+      recycled_segment_paths_.pop_front();
+    }
+
+    WritableFileOptions opts;
+    opts.sync_on_close = force_sync_all_;
+    opts.mode = Env::OPEN_EXISTING;
+    opts.overwrite_existing = true;
+    gscoped_ptr<WritableFile> segment_file;
+    Status s = fs_manager_->env()->NewWritableFile(opts, path, &segment_file);
+    if (!s.ok()) {
+      LOG(WARNING) << "Unable to reuse recycled log segment " << path << ": " << s.ToString();
+      WARN_NOT_OK(fs_manager_->env()->DeleteFile(path),
+                  "Unable to delete recycled log segment");
+      continue;
+    }
+    VLOG(1) << "Reusing recycled WAL segment: " << path;
+    *result_path = path;
+    out->reset(segment_file.release());
+    return true;
+  }
+}
+
+Status Log::RecycleOrDeleteSegment(const scoped_refptr<ReadableLogSegment>& segment) {
+  // A segment still referenced elsewhere (e.g. by a reader serving a lagging
+  // peer) may be read after this point. Deleting it keeps the open file's
+  // contents intact; overwriting it would not.
+  bool recycle = false;
+  if (segment->HasOneRef()) {
+    boost::lock_guard<simple_spinlock> l(recycled_segments_lock_);
+    recycle = recycled_segment_paths_.size() < options_.max_recycled_segments;
+  }
+  if (!recycle) {
+    return fs_manager_->env()->DeleteFile(segment->path());
+  }
+
+  string recycled_path = JoinPathSegments(
+      log_dir_, Substitute("$0$1", kRecycledSegmentFilePrefix, BaseName(segment->path())));
+  RETURN_NOT_OK(fs_manager_->env()->RenameFile(segment->path(), recycled_path));
+  boost::lock_guard<simple_spinlock> l(recycled_segments_lock_);
+  recycled_segment_paths_.push_back(recycled_path);
+  return Status::OK();
+}
+
+Status Log::LoadRecycledSegments() {
+  vector<string> children;
+  RETURN_NOT_OK_PREPEND(fs_manager_->env()->GetChildren(log_dir_, &children),
+                        "Unable to list WAL directory");
+  std::sort(children.begin(), children.end());
+  std::deque<string> recycled;
+  for (const string& child : children) {
+    if (!HasPrefixString(child, kRecycledSegmentFilePrefix)) {
+      continue;
+    }
+    string path = JoinPathSegments(log_dir_, child);
+    if (recycled.size() < options_.max_recycled_segments) {
+      recycled.push_back(path);
+    } else {
+      RETURN_NOT_OK(fs_manager_->env()->DeleteFile(path));
+    }
+  }
+  boost::lock_guard<simple_spinlock> l(recycled_segments_lock_);
+  recycled_segment_paths_.swap(recycled);
+  return Status::OK();
+}
+
 Log::~Log() {
   WARN_NOT_OK(Close(), "Error closing log");
 }
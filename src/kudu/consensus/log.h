@@ -19,6 +19,7 @@
 #define KUDU_CONSENSUS_LOG_H_
 
 #include <boost/thread/shared_mutex.hpp>
+#include <deque>
 #include <map>
 #include <memory>
 #include <string>
@@ -131,6 +132,13 @@ class Log : public RefCountedThreadSafe<Log> {
   Status AsyncAppendCommit(gscoped_ptr<consensus::CommitMsg> commit_msg,
                            const StatusCallback& callback);
 
+  // Append the given commit messages as a single entry batch, asynchronously.
+  // Takes ownership of the messages and clears 'commit_msgs'.
+  //
+  // Returns a bad status if the log is already shut down.
+  Status AsyncAppendCommits(vector<consensus::CommitMsg*>* commit_msgs,
+                            const StatusCallback& callback);
+
 
   // Blocks the current thread until all the entries in the log queue
   // are flushed and fsynced (if fsync of log entries is enabled).
@@ -233,6 +241,7 @@ class Log : public RefCountedThreadSafe<Log> {
   friend class LogTestBase;
   FRIEND_TEST(LogTest, TestMultipleEntriesInABatch);
   FRIEND_TEST(LogTest, TestReadLogWithReplacedReplicates);
+  FRIEND_TEST(LogTest, TestRecycledSegmentIgnoresStaleData);
   FRIEND_TEST(LogTest, TestWriteAndReadToAndFromInProgressSegment);
 
   class AppendThread;
@@ -279,6 +288,22 @@ class Log : public RefCountedThreadSafe<Log> {
   // Preallocates the space for a new segment.
   Status PreAllocateNewSegment();
 
+  // Tries to open a file from the recycled segment pool for overwriting.
+  // Sets 'result_path' and 'out' and returns true on success. Returns false
+  // if the pool is empty or the file could not be reopened, in which case a
+  // fresh placeholder segment should be created instead.
+  bool TakeRecycledSegment(std::string* result_path,
+                           std::shared_ptr<WritableFile>* out);
+
+  // Moves the file of a garbage-collected segment into the recycled segment
+  // pool, or deletes it if the pool is full or the segment is still
+  // referenced by a reader.
+  Status RecycleOrDeleteSegment(const scoped_refptr<ReadableLogSegment>& segment);
+
+  // Adds recycled segment files left in the log directory by a previous
+  // instance of this log to the pool, deleting any beyond the pool's limit.
+  Status LoadRecycledSegments();
+
   // Writes serialized contents of 'entry' to the log. Called inside
   // AppenderThread. If 'caller_owns_operation' is true, then the
   // 'operation' field of the entry will be released after the entry
@@ -341,6 +366,18 @@ class Log : public RefCountedThreadSafe<Log> {
   // The path for the next allocated segment.
   std::string next_segment_path_;
 
+  // Whether the next allocated segment was taken from the recycled segment
+  // pool and may still contain data from an older segment.
+  bool next_segment_recycled_;
+
+  // Paths of garbage-collected segment files available for reuse, oldest
+  // first. At most options_.max_recycled_segments are kept.
+  std::deque<std::string> recycled_segment_paths_;
+
+  // Protects 'recycled_segment_paths_', which is filled by GC and drained by
+  // the allocation thread.
+  simple_spinlock recycled_segments_lock_;
+
   // Lock to protect mutations to log_state_ and other shared state variables.
   mutable percpu_rwlock state_lock_;
 
@@ -264,6 +264,37 @@ TEST_F(LogCacheTest, TestMemoryLimit) {
   ASSERT_EQ(cache_->BytesUsed(), 0);
 }
 
+// Test that the serialized copy of an op, made when the op is sent to a
+// peer, is charged to the cache's MemTracker and released along with the op.
+TEST_F(LogCacheTest, TestSerializedCopyIsTracked) {
+  const int kPayloadSize = 128 * 1024;
+  shared_ptr<MemTracker> tracker = cache_->tracker_;
+  ASSERT_OK(AppendReplicateMessagesToCache(1, 1, kPayloadSize));
+  log_->WaitUntilAllFlushed();
+  int64_t size_unserialized = tracker->consumption();
+
+  {
+    vector<ReplicateRefPtr> messages;
+    OpId preceding;
+    ASSERT_OK(cache_->ReadOps(0, 8 * 1024 * 1024, &messages, &preceding));
+    ASSERT_EQ(1, messages.size());
+    int64_t serialized_size = messages[0]->serialized().size();
+    ASSERT_GT(serialized_size, kPayloadSize);
+    ASSERT_EQ(size_unserialized + serialized_size, tracker->consumption());
+    ASSERT_EQ(tracker->consumption(), cache_->metrics_.log_cache_size->value());
+
+    // Reading the op again doesn't charge for it twice.
+    messages.clear();
+    ASSERT_OK(cache_->ReadOps(0, 8 * 1024 * 1024, &messages, &preceding));
+    ASSERT_EQ(size_unserialized + serialized_size, tracker->consumption());
+  }
+
+  cache_->EvictThroughOp(1);
+  ASSERT_EQ(0, cache_->num_cached_ops());
+  ASSERT_EQ(0, tracker->consumption());
+  ASSERT_EQ(0, cache_->metrics_.log_cache_size->value());
+}
+
 TEST_F(LogCacheTest, TestGlobalMemoryLimit) {
   FLAGS_global_log_cache_size_limit_mb = 4;
   CloseAndReopenCache(MinimumOpId());
@@ -97,7 +97,7 @@ LogCache::LogCache(const scoped_refptr<MetricEntity>& metric_entity,
   // code paths elsewhere.
   auto zero_op = new ReplicateMsg();
   *zero_op->mutable_id() = MinimumOpId();
-  InsertOrDie(&cache_, 0, make_scoped_refptr_replicate(zero_op));
+  InsertOrDie(&cache_, 0, { make_scoped_refptr_replicate(zero_op), 0, false });
 }
 
 LogCache::~LogCache() {
@@ -136,17 +136,21 @@ Status LogCache::AppendOperations(const vector<ReplicateRefPtr>& msgs,
 
     // Now remove the overwritten operations.
     for (int64_t i = first_idx_in_batch; i < next_sequential_op_index_; ++i) {
-      ReplicateRefPtr msg = EraseKeyReturnValuePtr(&cache_, i);
-      if (msg != nullptr) {
-        AccountForMessageRemovalUnlocked(msg);
+      auto iter = cache_.find(i);
+      if (iter != cache_.end()) {
+        AccountForMessageRemovalUnlocked(iter->second);
+        cache_.erase(iter);
       }
     }
   }
 
 
   int64_t mem_required = 0;
+  vector<int64_t> mem_usages;
+  mem_usages.reserve(msgs.size());
   for (const auto& msg : msgs) {
-    mem_required += msg->get()->SpaceUsed();
+    mem_usages.push_back(msg->get()->SpaceUsed());
+    mem_required += mem_usages.back();
   }
 
   // Try to consume the memory. If it can't be consumed, we may need to evict.
@@ -173,8 +177,8 @@ Status LogCache::AppendOperations(const vector<ReplicateRefPtr>& msgs,
     borrowed_memory = parent_tracker_->LimitExceeded();
   }
 
-  for (const auto& msg : msgs) {
-    InsertOrDie(&cache_,  msg->get()->id().index(), msg);
+  for (int i = 0; i < msgs.size(); i++) {
+    InsertOrDie(&cache_, msgs[i]->get()->id().index(), { msgs[i], mem_usages[i], false });
   }
 
   // We drop the lock during the AsyncAppendReplicates call, since it may block
@@ -247,7 +251,7 @@ Status LogCache::LookupOpId(int64_t op_index, OpId* op_id) const {
     }
     auto iter = cache_.find(op_index);
     if (iter != cache_.end()) {
-      *op_id = iter->second->get()->id();
+      *op_id = iter->second.msg->get()->id();
       return Status::OK();
     }
   }
@@ -284,7 +288,7 @@ Status LogCache::ReadOps(int64_t after_op_index,
 
     // If the messages the peer needs haven't been loaded into the queue yet,
     // load them.
-    MessageCache::const_iterator iter = cache_.lower_bound(next_index);
+    auto iter = cache_.lower_bound(next_index);
     if (iter == cache_.end() || iter->first != next_index) {
       int64_t up_to;
       if (iter == cache_.end()) {
@@ -321,7 +325,8 @@ Status LogCache::ReadOps(int64_t after_op_index,
     } else {
       // Pull contiguous messages from the cache until the size limit is achieved.
       for (; iter != cache_.end(); ++iter) {
-        const ReplicateRefPtr& msg = iter->second;
+        CacheEntry& entry = iter->second;
+        const ReplicateRefPtr& msg = entry.msg;
         int64_t index = msg->get()->id().index();
         if (index != next_index) {
           continue;
@@ -333,6 +338,9 @@ Status LogCache::ReadOps(int64_t after_op_index,
         }
 
         messages->push_back(msg);
+        if (!entry.serialized_charged) {
+          ChargeForSerializationUnlocked(&entry);
+        }
         next_index++;
       }
     }
@@ -356,7 +364,8 @@ void LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evic
 
   int64_t bytes_evicted = 0;
   for (auto iter = cache_.begin(); iter != cache_.end();) {
-    const ReplicateRefPtr& msg = (*iter).second;
+    const CacheEntry& entry = iter->second;
+    const ReplicateRefPtr& msg = entry.msg;
     VLOG_WITH_PREFIX_UNLOCKED(2) << "considering for eviction: " << msg->get()->id();
     int64_t msg_index = msg->get()->id().index();
     if (msg_index == 0) {
@@ -377,8 +386,8 @@ void LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evic
     }
 
     VLOG_WITH_PREFIX_UNLOCKED(2) << "Evicting cache. Removing: " << msg->get()->id();
-    AccountForMessageRemovalUnlocked(msg);
-    bytes_evicted += msg->get()->SpaceUsed();
+    AccountForMessageRemovalUnlocked(entry);
+    bytes_evicted += entry.mem_usage;
     cache_.erase(iter++);
 
     if (bytes_evicted >= bytes_to_evict) {
@@ -388,9 +397,19 @@ void LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evic
   VLOG_WITH_PREFIX_UNLOCKED(1) << "Evicting log cache: after state: " << ToStringUnlocked();
 }
 
-void LogCache::AccountForMessageRemovalUnlocked(const ReplicateRefPtr& msg) {
-  tracker_->Release(msg->get()->SpaceUsed());
-  metrics_.log_cache_size->DecrementBy(msg->get()->SpaceUsed());
+void LogCache::ChargeForSerializationUnlocked(CacheEntry* entry) {
+  // The message is serialized once and the copy lives as long as the message,
+  // so charge for it now rather than refuse a peer the op if over the limit.
+  int64_t serialized_size = entry->msg->get()->ByteSize();
+  tracker_->Consume(serialized_size);
+  metrics_.log_cache_size->IncrementBy(serialized_size);
+  entry->mem_usage += serialized_size;
+  entry->serialized_charged = true;
+}
+
+void LogCache::AccountForMessageRemovalUnlocked(const CacheEntry& entry) {
+  tracker_->Release(entry.mem_usage);
+  metrics_.log_cache_size->DecrementBy(entry.mem_usage);
   metrics_.log_cache_num_ops->Decrement();
 }
 
@@ -440,7 +459,7 @@ void LogCache::DumpToStrings(vector<string>* lines) const {
   lines->push_back(ToStringUnlocked());
   lines->push_back("Messages:");
   for (const MessageCache::value_type& entry : cache_) {
-    const ReplicateMsg* msg = entry.second->get();
+    const ReplicateMsg* msg = entry.second.msg->get();
     lines->push_back(
       Substitute("Message[$0] $1.$2 : REPLICATE. Type: $3, Size: $4",
                  counter++, msg->id().term(), msg->id().index(),
@@ -459,7 +478,7 @@ void LogCache::DumpToHtml(std::ostream& out) const {
 
   int counter = 0;
   for (const MessageCache::value_type& entry : cache_) {
-    const ReplicateMsg* msg = entry.second->get();
+    const ReplicateMsg* msg = entry.second.msg->get();
     out << Substitute("<tr><th>$0</th><th>$1.$2</th><td>REPLICATE $3</td>"
                       "<td>$4</td><td>$5</td></tr>",
                       counter++, msg->id().term(), msg->id().index(),
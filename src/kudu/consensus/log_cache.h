@@ -137,6 +137,7 @@ class LogCache {
   FRIEND_TEST(LogCacheTest, TestAppendAndGetMessages);
   FRIEND_TEST(LogCacheTest, TestGlobalMemoryLimit);
   FRIEND_TEST(LogCacheTest, TestReplaceMessages);
+  FRIEND_TEST(LogCacheTest, TestSerializedCopyIsTracked);
   friend class LogCacheTest;
 
   // Try to evict the oldest operations from the queue, stopping either when
@@ -144,9 +145,22 @@ class LogCache {
   // 'stop_after_index' has been evicted, whichever comes first.
   void EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evict);
 
+  // A cached message, along with the number of bytes charged for it.
+  struct CacheEntry {
+    ReplicateRefPtr msg;
+    // The in-memory size of 'msg', plus the size of its serialized form once
+    // it has been handed out to be sent to a peer.
+    int64_t mem_usage;
+    bool serialized_charged;
+  };
+
+  // Charge the MemTracker and metrics for the serialized copy of the entry's
+  // message, which the peer that reads it caches alongside the message.
+  void ChargeForSerializationUnlocked(CacheEntry* entry);
+
   // Update metrics and MemTracker to account for the removal of the
-  // given message.
-  void AccountForMessageRemovalUnlocked(const ReplicateRefPtr& msg);
+  // given entry.
+  void AccountForMessageRemovalUnlocked(const CacheEntry& entry);
 
   // Return a string with stats
   std::string StatsStringUnlocked() const;
@@ -172,7 +186,7 @@ class LogCache {
 
   // An ordered map that serves as the buffer for the cached messages.
   // Maps from log index -> ReplicateMsg
-  typedef std::map<uint64_t, ReplicateRefPtr> MessageCache;
+  typedef std::map<uint64_t, CacheEntry> MessageCache;
   MessageCache cache_;
 
   // The next log index to append. Each append operation must either
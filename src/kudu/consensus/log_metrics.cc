@@ -31,7 +31,7 @@ METRIC_DEFINE_histogram(tablet, log_sync_latency, "Log Sync Latency",
 METRIC_DEFINE_histogram(tablet, log_append_latency, "Log Append Latency",
                         kudu::MetricUnit::kMicroseconds,
                         "Microseconds spent on appending to the log segment file",
-                        60000000LU, 2);
+                        60000000LU, 2, kudu::STRIPED_HISTOGRAM);
 
 METRIC_DEFINE_histogram(tablet, log_group_commit_latency, "Log Group Commit Latency",
                         kudu::MetricUnit::kMicroseconds,
@@ -58,6 +58,13 @@ DEFINE_bool(log_async_preallocate_segments, true,
             "Whether the WAL segments preallocation should happen asynchronously");
 TAG_FLAG(log_async_preallocate_segments, advanced);
 
+DEFINE_int32(log_max_recycled_segments, 0,
+             "The maximum number of garbage-collected WAL segment files to keep per "
+             "tablet for reuse as future segments. Overwriting a recycled file in place "
+             "avoids the filesystem metadata work of allocating a fresh one. "
+             "Set to 0 to always delete garbage-collected segments.");
+TAG_FLAG(log_max_recycled_segments, advanced);
+
 namespace kudu {
 namespace log {
 
@@ -96,9 +103,28 @@ LogOptions::LogOptions()
 : segment_size_mb(FLAGS_log_segment_size_mb),
   force_fsync_all(FLAGS_log_force_fsync_all),
   preallocate_segments(FLAGS_log_preallocate_segments),
-  async_preallocate_segments(FLAGS_log_async_preallocate_segments) {
+  async_preallocate_segments(FLAGS_log_async_preallocate_segments),
+  max_recycled_segments(std::max(FLAGS_log_max_recycled_segments, 0)) {
+}
+
+namespace {
+
+// Computes the CRC of the first 8 bytes of an entry header. If the segment
+// has an epoch, it is mixed into the CRC so that headers left behind by an
+// older segment in a recycled file never validate.
+uint32_t ComputeEntryHeaderCrc(const uint8_t* header_buf,
+                               const LogSegmentHeaderPB& segment_header) {
+  if (!segment_header.has_epoch()) {
+    return crc::Crc32c(header_buf, 8);
+  }
+  uint8_t salted[16];
+  memcpy(salted, header_buf, 8);
+  InlineEncodeFixed64(&salted[8], segment_header.epoch());
+  return crc::Crc32c(salted, sizeof(salted));
 }
 
+} // anonymous namespace
+
 ////////////////////////////////////////////////////////////
 // LogEntryReader
 ////////////////////////////////////////////////////////////
@@ -351,6 +377,9 @@ Status ReadableLogSegment::RebuildFooterByScanning() {
   }
 
   new_footer.set_num_entries(num_entries);
+  if (header_.has_epoch()) {
+    new_footer.set_epoch(header_.epoch());
+  }
   footer_ = new_footer;
   DCHECK(footer_.IsInitialized());
   footer_was_rebuilt_ = true;
@@ -514,6 +543,14 @@ Status ReadableLogSegment::ReadFooter() {
                                                 footer_size),
                         "Unable to parse protobuf");
 
+  // A recycled file may still end with the footer of the segment that
+  // previously occupied it. Only accept a footer written for this segment.
+  if (header_.has_epoch() && (!footer.has_epoch() || footer.epoch() != header_.epoch())) {
+    return Status::NotFound(
+        Substitute("Footer not found. Found a stale footer with epoch $0 in a segment "
+                   "with epoch $1", footer.epoch(), header_.epoch()));
+  }
+
   footer_.Swap(&footer);
   return Status::OK();
 }
@@ -596,6 +633,19 @@ Status ReadableLogSegment::ScanForValidEntryHeaders(int64_t offset, bool* has_va
 
       EntryHeader header;
       if (DecodeEntryHeader(potential_header, &header)) {
+        // A recycled segment is followed by the non-zero remains of an older
+        // segment, so scanning it byte by byte is likely to find spurious
+        // header CRC matches. Require the whole batch to check out as well.
+        if (header_.has_epoch()) {
+          int64_t batch_offset = offset + off_in_chunk + kEntryHeaderSize;
+          faststring tmp_buf;
+          gscoped_ptr<LogEntryBatchPB> batch;
+          Status s = ReadEntryBatch(&batch_offset, header, &tmp_buf, &batch);
+          if (s.IsCorruption()) {
+            continue;
+          }
+          RETURN_NOT_OK(s);
+        }
         LOG(INFO) << "Found a valid entry header at offset " << (offset + off_in_chunk);
         *has_valid_entries = true;
         return Status::OK();
@@ -639,7 +689,7 @@ bool ReadableLogSegment::DecodeEntryHeader(const Slice& data, EntryHeader* heade
   header->header_crc = DecodeFixed32(&data[8]);
 
   // Verify the header.
-  uint32_t computed_crc = crc::Crc32c(&data[0], 8);
+  uint32_t computed_crc = ComputeEntryHeaderCrc(&data[0], header_);
   return computed_crc == header->header_crc;
 }
 
@@ -775,7 +825,7 @@ Status WritableLogSegment::WriteEntryBatch(const Slice& data) {
   InlineEncodeFixed32(&header_buf[4], msg_crc);
 
   // Then the CRC of the header
-  uint32_t header_crc = crc::Crc32c(&header_buf, 8);
+  uint32_t header_crc = ComputeEntryHeaderCrc(header_buf, header_);
   InlineEncodeFixed32(&header_buf[8], header_crc);
 
   // Write the header to the file, followed by the batch data itself.
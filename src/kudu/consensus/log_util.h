@@ -73,6 +73,10 @@ struct LogOptions {
   // Whether the allocation should happen asynchronously.
   bool async_preallocate_segments;
 
+  // The maximum number of garbage-collected segment files to keep around
+  // for reuse as new segments.
+  size_t max_recycled_segments;
+
   LogOptions();
 };
 
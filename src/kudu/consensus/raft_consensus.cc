@@ -167,6 +167,7 @@ scoped_refptr<RaftConsensus> RaftConsensus::Create(
                                                            log,
                                                            local_peer_pb,
                                                            options.tablet_id));
+  queue->SetSafeTimestampSource(txn_factory);
 
   gscoped_ptr<ThreadPool> thread_pool;
   CHECK_OK(ThreadPoolBuilder(Substitute("$0-raft", options.tablet_id.substr(0, 6)))
@@ -1179,6 +1180,17 @@ Status RaftConsensus::UpdateReplica(const ConsensusRequestPB* request,
     TRACE(Substitute("Marking committed up to $0", apply_up_to.ShortDebugString()));
     CHECK_OK(state_->AdvanceCommittedIndexUnlocked(apply_up_to, &committed_index_changed));
 
+    // If every op in the request was started, every op at or below the
+    // leader's safe timestamp was, so the tablet may serve snapshots up to it.
+    if (request->has_safe_timestamp()) {
+      int64_t last_index_in_request = request->ops_size() > 0 ?
+          request->ops(request->ops_size() - 1).id().index() : request->preceding_id().index();
+      if (last_from_leader.index() >= last_index_in_request) {
+        state_->GetReplicaTransactionFactoryUnlocked()->AdvanceFollowerSafeTimestamp(
+            request->safe_timestamp());
+      }
+    }
+
     // We can now update the last received watermark.
     //
     // We do it here (and before we actually hear back from the wal whether things
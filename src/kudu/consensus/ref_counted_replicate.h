@@ -18,24 +18,50 @@
 #ifndef KUDU_CONSENSUS_REF_COUNTED_REPLICATE_H_
 #define KUDU_CONSENSUS_REF_COUNTED_REPLICATE_H_
 
+#include <glog/logging.h>
+#include <string>
+
 #include "kudu/consensus/consensus.pb.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/util/locks.h"
 
 namespace kudu {
 namespace consensus {
 
 // A simple ref-counted wrapper around ReplicateMsg.
+//
+// It also caches the message in serialized form, so that a leader sending
+// the same operation to several peers only serializes it once.
 class RefCountedReplicate : public RefCountedThreadSafe<RefCountedReplicate> {
  public:
-  explicit RefCountedReplicate(ReplicateMsg* msg) : msg_(msg) {}
+  explicit RefCountedReplicate(ReplicateMsg* msg)
+      : msg_(msg),
+        serialized_(false) {
+  }
 
   ReplicateMsg* get() {
     return msg_.get();
   }
 
+  // Returns the message in serialized form, serializing it on the first call.
+  // The message must not be modified once this has been called.
+  const std::string& serialized() {
+    lock_guard<simple_spinlock> l(&lock_);
+    if (!serialized_) {
+      CHECK(msg_->SerializeToString(&serialized_msg_));
+      serialized_ = true;
+    }
+    return serialized_msg_;
+  }
+
  private:
   gscoped_ptr<ReplicateMsg> msg_;
+
+  // Protects 'serialized_' and 'serialized_msg_'.
+  simple_spinlock lock_;
+  bool serialized_;
+  std::string serialized_msg_;
 };
 
 typedef scoped_refptr<RefCountedReplicate> ReplicateRefPtr;
@@ -96,6 +96,7 @@ const char *FsManager::kDataDirName = "data";
 const char *FsManager::kCorruptedSuffix = ".corrupted";
 const char *FsManager::kInstanceMetadataFileName = "instance";
 const char *FsManager::kConsensusMetadataDirName = "consensus-meta";
+const char *FsManager::kBlockCacheWarmupFileName = "block-cache-warmup";
 
 static const char* const kTmpInfix = ".tmp";
 
@@ -388,6 +389,11 @@ string FsManager::GetTabletMetadataPath(const string& tablet_id) const {
   return JoinPathSegments(GetTabletMetadataDir(), tablet_id);
 }
 
+string FsManager::GetBlockCacheWarmupPath() const {
+  DCHECK(initted_);
+  return JoinPathSegments(canonicalized_metadata_fs_root_, kBlockCacheWarmupFileName);
+}
+
 namespace {
 // Return true if 'fname' is a valid tablet ID.
 bool IsValidTabletId(const std::string& fname) {
@@ -159,6 +159,9 @@ class FsManager {
   // Return the path for a specific tablet's superblock.
   std::string GetTabletMetadataPath(const std::string& tablet_id) const;
 
+  // Return the path where the block cache warm-up list is stored.
+  std::string GetBlockCacheWarmupPath() const;
+
   // List the tablet IDs in the metadata directory.
   Status ListTabletIds(std::vector<std::string>* tablet_ids);
 
@@ -238,6 +241,7 @@ class FsManager {
   static const char *kWalDirName;
   static const char *kCorruptedSuffix;
   static const char *kInstanceMetadataFileName;
+  static const char *kBlockCacheWarmupFileName;
   static const char *kInstanceMetadataMagicNumber;
   static const char *kTabletSuperBlockMagicNumber;
   static const char *kConsensusMetadataDirName;
@@ -48,9 +48,11 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "kudu/cfile/type_encodings.h"
@@ -738,6 +740,41 @@ void CatalogManager::Shutdown() {
   }
 }
 
+// Validates the row TTL 'requested' by a client against 'schema', which must
+// have column IDs, and sets 'resolved' to the same TTL with its column
+// identified by ID.
+static Status ResolveRowTtl(const RowTtlPB& requested,
+                            const Schema& schema,
+                            RowTtlPB* resolved) {
+  DCHECK(schema.has_column_ids());
+  if (requested.ttl_secs() <= 0) {
+    return Status::InvalidArgument("row TTL must be positive",
+                                   requested.ShortDebugString());
+  }
+  int col_idx = Schema::kColumnNotFound;
+  if (requested.has_column_name()) {
+    col_idx = schema.find_column(requested.column_name());
+  } else if (requested.has_column_id()) {
+    col_idx = schema.find_column_by_id(ColumnId(requested.column_id()));
+  }
+  if (col_idx == Schema::kColumnNotFound) {
+    return Status::InvalidArgument("row TTL column not found",
+                                   requested.ShortDebugString());
+  }
+  const ColumnSchema& col = schema.column(col_idx);
+  if (col.type_info()->type() != TIMESTAMP || col.is_nullable()) {
+    return Status::InvalidArgument(
+        Substitute("row TTL column `$0` must be a non-nullable TIMESTAMP column",
+                   col.name()));
+  }
+  // 'requested' and 'resolved' may be the same message.
+  int64_t ttl_secs = requested.ttl_secs();
+  resolved->Clear();
+  resolved->set_column_id(schema.column_id(col_idx));
+  resolved->set_ttl_secs(ttl_secs);
+  return Status::OK();
+}
+
 static void SetupError(MasterErrorPB* error,
                        MasterErrorPB::Code code,
                        const Status& s) {
@@ -798,6 +835,15 @@ Status CatalogManager::CreateTable(const CreateTableRequestPB* orig_req,
     return s;
   }
 
+  // Identify the row TTL column, if any, by ID from now on.
+  if (req.has_row_ttl()) {
+    s = ResolveRowTtl(req.row_ttl(), schema, req.mutable_row_ttl());
+    if (!s.ok()) {
+      SetupError(resp->mutable_error(), MasterErrorPB::INVALID_SCHEMA, s);
+      return s;
+    }
+  }
+
   // Decode split rows.
   vector<KuduPartialRow> split_rows;
 
@@ -982,6 +1028,9 @@ TableInfo *CatalogManager::CreateTableInfo(const CreateTableRequestPB& req,
   // whereas the user request PB does not.
   CHECK_OK(SchemaToPB(schema, metadata->mutable_schema()));
   partition_schema.ToPB(metadata->mutable_partition_schema());
+  if (req.has_row_ttl()) {
+    metadata->mutable_row_ttl()->CopyFrom(req.row_ttl());
+  }
   return table;
 }
 
@@ -1102,7 +1151,7 @@ Status CatalogManager::DeleteTable(const DeleteTableRequestPB* req,
 }
 
 static Status ApplyAlterSteps(const SysTablesEntryPB& current_pb,
-                              const AlterTableRequestPB* req,
+                              const vector<AlterTableRequestPB::Step>& steps,
                               Schema* new_schema,
                               ColumnId* next_col_id) {
   const SchemaPB& current_schema_pb = current_pb.schema();
@@ -1114,7 +1163,7 @@ static Status ApplyAlterSteps(const SysTablesEntryPB& current_pb,
     builder.set_next_column_id(ColumnId(current_pb.next_column_id()));
   }
 
-  for (const AlterTableRequestPB::Step& step : req->alter_schema_steps()) {
+  for (const AlterTableRequestPB::Step& step : steps) {
     switch (step.type()) {
       case AlterTableRequestPB::ADD_COLUMN: {
         if (!step.has_add_column()) {
@@ -1186,6 +1235,130 @@ static Status ApplyAlterSteps(const SysTablesEntryPB& current_pb,
   return Status::OK();
 }
 
+namespace {
+
+// The bounds of a range partition, as encoded range keys. An empty key is
+// unbounded.
+typedef std::pair<string, string> RangeBounds;
+
+bool RangesOverlap(const RangeBounds& a, const RangeBounds& b) {
+  return (a.second.empty() || b.first < a.second) &&
+         (b.second.empty() || a.first < b.second);
+}
+
+} // anonymous namespace
+
+Status CatalogManager::ApplyAlterPartitioningSteps(
+    const TableMetadataLock& l,
+    TableInfo* table,
+    const Schema& client_schema,
+    const vector<AlterTableRequestPB::Step>& steps,
+    vector<scoped_refptr<TabletInfo>>* tablets_to_add,
+    vector<scoped_refptr<TabletInfo>>* tablets_to_drop) {
+  Schema schema;
+  RETURN_NOT_OK(SchemaFromPB(l.data().pb.schema(), &schema));
+  PartitionSchema partition_schema;
+  RETURN_NOT_OK(PartitionSchema::FromPB(l.data().pb.partition_schema(), schema,
+                                        &partition_schema));
+
+  // The live tablets of the table, indexed by the range partition they
+  // belong to. With hash bucketing, each range partition has one tablet per
+  // combination of hash buckets.
+  std::multimap<RangeBounds, scoped_refptr<TabletInfo>> existing_tablets;
+  vector<scoped_refptr<TabletInfo>> tablets;
+  table->GetAllTablets(&tablets);
+  for (const auto& tablet : tablets) {
+    TabletMetadataLock tablet_lock(tablet.get(), TabletMetadataLock::READ);
+    Partition partition;
+    Partition::FromPB(tablet_lock.data().pb.partition(), &partition);
+    existing_tablets.emplace(RangeBounds(partition.range_key_start().ToString(),
+                                         partition.range_key_end().ToString()),
+                             tablet);
+  }
+
+  // The partitions of the range partitions added by this request.
+  std::map<RangeBounds, vector<Partition>> new_partitions;
+
+  for (const AlterTableRequestPB::Step& step : steps) {
+    const RowOperationsPB* range_bounds_pb;
+    if (step.type() == AlterTableRequestPB::ADD_RANGE_PARTITION) {
+      if (!step.has_add_range_partition()) {
+        return Status::InvalidArgument("ADD_RANGE_PARTITION missing range bounds");
+      }
+      range_bounds_pb = &step.add_range_partition().range_bounds();
+    } else {
+      DCHECK_EQ(AlterTableRequestPB::DROP_RANGE_PARTITION, step.type());
+      if (!step.has_drop_range_partition()) {
+        return Status::InvalidArgument("DROP_RANGE_PARTITION missing range bounds");
+      }
+      range_bounds_pb = &step.drop_range_partition().range_bounds();
+    }
+
+    RowOperationsPBDecoder decoder(range_bounds_pb, &client_schema, &schema, nullptr);
+    vector<DecodedRowOperation> ops;
+    RETURN_NOT_OK(decoder.DecodeOperations(&ops));
+    if (ops.size() != 2 ||
+        ops[0].type != RowOperationsPB::RANGE_LOWER_BOUND ||
+        ops[1].type != RowOperationsPB::RANGE_UPPER_BOUND) {
+      return Status::InvalidArgument(
+          "Range partition bounds must be specified as a RowOperationsPB::RANGE_LOWER_BOUND "
+          "followed by a RowOperationsPB::RANGE_UPPER_BOUND");
+    }
+    const KuduPartialRow& lower_bound = *ops[0].split_row;
+    const KuduPartialRow& upper_bound = *ops[1].split_row;
+    string range_string = Substitute("[($0), ($1))",
+                                     lower_bound.ToString(), upper_bound.ToString());
+
+    vector<Partition> partitions;
+    RETURN_NOT_OK(partition_schema.CreateRangePartitions(lower_bound, upper_bound,
+                                                         schema, &partitions));
+    RangeBounds range(partitions[0].range_key_start().ToString(),
+                      partitions[0].range_key_end().ToString());
+
+    if (step.type() == AlterTableRequestPB::ADD_RANGE_PARTITION) {
+      for (const auto& e : existing_tablets) {
+        if (RangesOverlap(e.first, range)) {
+          return Status::InvalidArgument(
+              "New range partition conflicts with an existing range partition",
+              range_string);
+        }
+      }
+      for (const auto& e : new_partitions) {
+        if (RangesOverlap(e.first, range)) {
+          return Status::InvalidArgument(
+              "New range partition conflicts with another new range partition",
+              range_string);
+        }
+      }
+      new_partitions.emplace(std::move(range), std::move(partitions));
+    } else {
+      // Dropping a range partition added earlier in the same request simply
+      // cancels the addition.
+      if (new_partitions.erase(range) > 0) {
+        continue;
+      }
+      auto dropped = existing_tablets.equal_range(range);
+      if (dropped.first == dropped.second) {
+        return Status::InvalidArgument(
+            "No range partition found for drop range partition step", range_string);
+      }
+      for (auto it = dropped.first; it != dropped.second; ++it) {
+        tablets_to_drop->push_back(it->second);
+      }
+      existing_tablets.erase(dropped.first, dropped.second);
+    }
+  }
+
+  for (const auto& e : new_partitions) {
+    for (const Partition& partition : e.second) {
+      PartitionPB partition_pb;
+      partition.ToPB(&partition_pb);
+      tablets_to_add->push_back(CreateTabletInfo(table, partition_pb));
+    }
+  }
+  return Status::OK();
+}
+
 Status CatalogManager::AlterTable(const AlterTableRequestPB* req,
                                   AlterTableResponsePB* resp,
                                   rpc::RpcContext* rpc) {
@@ -1215,12 +1388,27 @@ Status CatalogManager::AlterTable(const AlterTableRequestPB* req,
   bool has_changes = false;
   string table_name = l.data().name();
 
+  // Split the steps into schema steps and range partitioning steps.
+  vector<AlterTableRequestPB::Step> alter_schema_steps;
+  vector<AlterTableRequestPB::Step> alter_partitioning_steps;
+  for (const AlterTableRequestPB::Step& step : req->alter_schema_steps()) {
+    switch (step.type()) {
+      case AlterTableRequestPB::ADD_RANGE_PARTITION:
+      case AlterTableRequestPB::DROP_RANGE_PARTITION:
+        alter_partitioning_steps.push_back(step);
+        break;
+      default:
+        alter_schema_steps.push_back(step);
+        break;
+    }
+  }
+
   // 2. Calculate new schema for the on-disk state, not persisted yet
   Schema new_schema;
   ColumnId next_col_id = ColumnId(l.data().pb.next_column_id());
-  if (req->alter_schema_steps_size()) {
+  if (!alter_schema_steps.empty()) {
     TRACE("Apply alter schema");
-    Status s = ApplyAlterSteps(l.data().pb, req, &new_schema, &next_col_id);
+    Status s = ApplyAlterSteps(l.data().pb, alter_schema_steps, &new_schema, &next_col_id);
     if (!s.ok()) {
       SetupError(resp->mutable_error(), MasterErrorPB::INVALID_SCHEMA, s);
       return s;
@@ -1231,7 +1419,64 @@ Status CatalogManager::AlterTable(const AlterTableRequestPB* req,
     has_changes = true;
   }
 
-  // 3. Try to acquire the new table name
+  // 2b. Calculate the new row TTL. The TTL column can't be dropped while the
+  //     table has a row TTL.
+  bool has_row_ttl = l.data().pb.has_row_ttl();
+  RowTtlPB new_row_ttl = l.data().pb.row_ttl();
+  if (req->has_new_row_ttl()) {
+    if (req->new_row_ttl().ttl_secs() == 0) {
+      has_row_ttl = false;
+      new_row_ttl.Clear();
+    } else {
+      Schema ttl_schema = new_schema;
+      Status s;
+      if (!ttl_schema.initialized()) {
+        s = SchemaFromPB(l.data().pb.schema(), &ttl_schema);
+      }
+      if (s.ok()) {
+        s = ResolveRowTtl(req->new_row_ttl(), ttl_schema, &new_row_ttl);
+      }
+      if (!s.ok()) {
+        SetupError(resp->mutable_error(), MasterErrorPB::INVALID_SCHEMA, s);
+        return s;
+      }
+      has_row_ttl = true;
+    }
+    has_changes = true;
+  }
+  if (has_row_ttl && new_schema.initialized() &&
+      new_schema.find_column_by_id(ColumnId(new_row_ttl.column_id())) ==
+          Schema::kColumnNotFound) {
+    Status s = Status::InvalidArgument("cannot drop the row TTL column");
+    SetupError(resp->mutable_error(), MasterErrorPB::INVALID_SCHEMA, s);
+    return s;
+  }
+
+  // 3. Calculate the tablets to add and drop for range partition changes.
+  //    The new tablets are left write locked by ApplyAlterPartitioningSteps.
+  vector<scoped_refptr<TabletInfo>> tablets_to_add;
+  vector<scoped_refptr<TabletInfo>> tablets_to_drop;
+  if (!alter_partitioning_steps.empty()) {
+    TRACE("Apply alter partitioning");
+    Schema client_schema;
+    Status s = SchemaFromPB(req->schema(), &client_schema);
+    if (s.ok() && client_schema.has_column_ids()) {
+      s = Status::InvalidArgument("User requests should not have Column IDs");
+    }
+    if (!s.ok()) {
+      SetupError(resp->mutable_error(), MasterErrorPB::INVALID_SCHEMA, s);
+      return s;
+    }
+    s = ApplyAlterPartitioningSteps(l, table.get(), client_schema, alter_partitioning_steps,
+                                    &tablets_to_add, &tablets_to_drop);
+    if (!s.ok()) {
+      SetupError(resp->mutable_error(), MasterErrorPB::UNKNOWN_ERROR, s);
+      return s;
+    }
+    has_changes = true;
+  }
+
+  // 4. Try to acquire the new table name
   if (req->has_new_table_name()) {
     boost::lock_guard<LockType> catalog_lock(lock_);
 
@@ -1257,13 +1502,18 @@ Status CatalogManager::AlterTable(const AlterTableRequestPB* req,
     return Status::OK();
   }
 
-  // 4. Serialize the schema Increment the version number
+  // 5. Serialize the schema Increment the version number
   if (new_schema.initialized()) {
     if (!l.data().pb.has_fully_applied_schema()) {
       l.mutable_data()->pb.mutable_fully_applied_schema()->CopyFrom(l.data().pb.schema());
     }
     CHECK_OK(SchemaToPB(new_schema, l.mutable_data()->pb.mutable_schema()));
   }
+  if (has_row_ttl) {
+    l.mutable_data()->pb.mutable_row_ttl()->CopyFrom(new_row_ttl);
+  } else {
+    l.mutable_data()->pb.clear_row_ttl();
+  }
   l.mutable_data()->pb.set_version(l.mutable_data()->pb.version() + 1);
   l.mutable_data()->pb.set_next_column_id(next_col_id);
   l.mutable_data()->set_state(SysTablesEntryPB::ALTERING,
@@ -1271,10 +1521,34 @@ Status CatalogManager::AlterTable(const AlterTableRequestPB* req,
                                          l.mutable_data()->pb.version(),
                                          LocalTimeAsString()));
 
-  // 5. Update sys-catalog with the new table schema.
+  // 6. Lock the tablets of dropped range partitions and mark them as deleted.
+  //    The new tablets are invisible to other threads, so their locks don't
+  //    participate in the tablet ID lock ordering.
+  ScopedTabletInfoCommitter tablets_to_add_committer(ScopedTabletInfoCommitter::LOCKED);
+  ScopedTabletInfoCommitter tablets_to_drop_committer(ScopedTabletInfoCommitter::UNLOCKED);
+  tablets_to_add_committer.AddTablets(tablets_to_add);
+  tablets_to_drop_committer.AddTablets(tablets_to_drop);
+  tablets_to_drop_committer.LockTabletsForWriting();
+
+  string deletion_msg = "Range partition dropped at " + LocalTimeAsString();
+  vector<string> dropped_partition_key_starts;
+  for (const auto& tablet : tablets_to_drop_committer) {
+    tablet->mutable_metadata()->mutable_dirty()->set_state(
+        SysTabletsEntryPB::DELETED, deletion_msg);
+    dropped_partition_key_starts.push_back(
+        tablet->metadata().dirty().pb.partition().partition_key_start());
+  }
+
+  // 7. Update sys-catalog with the new table schema and tablets.
   TRACE("Updating metadata on disk");
   SysCatalogTable::Actions actions;
   actions.table_to_update = table.get();
+  for (const auto& tablet : tablets_to_add) {
+    actions.tablets_to_add.push_back(tablet.get());
+  }
+  for (const auto& tablet : tablets_to_drop) {
+    actions.tablets_to_update.push_back(tablet.get());
+  }
   Status s = sys_catalog_->Write(actions);
   if (!s.ok()) {
     s = s.CloneAndPrepend(
@@ -1286,10 +1560,12 @@ Status CatalogManager::AlterTable(const AlterTableRequestPB* req,
       CHECK_EQ(table_names_map_.erase(req->new_table_name()), 1);
     }
     CheckIfNoLongerLeaderAndSetupError(s, resp);
+    tablets_to_add_committer.Abort();
+    tablets_to_drop_committer.Abort();
     return s;
   }
 
-  // 6. Remove the old name
+  // 8. Remove the old name
   if (req->has_new_table_name()) {
     TRACE("Removing old-name $0 from by-name map", table_name);
     boost::lock_guard<LockType> l_map(lock_);
@@ -1298,11 +1574,47 @@ Status CatalogManager::AlterTable(const AlterTableRequestPB* req,
     }
   }
 
-  // 7. Update the in-memory state
+  // 9. Update the in-memory state. The tablets are committed before the
+  //    table, as required by the locking rules, and the table's tablet map is
+  //    updated while the table is still write locked so that concurrent
+  //    partitioning changes see it.
   TRACE("Committing in-memory state");
+  tablets_to_add_committer.Commit();
+  tablets_to_drop_committer.Commit();
+  for (const string& partition_key_start : dropped_partition_key_starts) {
+    table->RemoveTablet(partition_key_start);
+  }
+
+  // The new tablets have no replicas yet; they are brought up to the latest
+  // schema version once they report in. Only the tablets that existed before
+  // this alter are sent the new schema now.
+  vector<scoped_refptr<TabletInfo>> tablets_to_alter;
+  table->GetAllTablets(&tablets_to_alter);
+
+  vector<TabletInfo*> tablets_to_add_raw;
+  for (const auto& tablet : tablets_to_add) {
+    tablets_to_add_raw.push_back(tablet.get());
+  }
+  table->AddTablets(tablets_to_add_raw);
   l.Commit();
 
-  SendAlterTableRequest(table);
+  if (!tablets_to_add.empty()) {
+    boost::lock_guard<LockType> l_map(lock_);
+    for (const auto& tablet : tablets_to_add) {
+      InsertOrDie(&tablet_map_, tablet->tablet_id(), tablet);
+    }
+  }
+
+  for (const auto& tablet : tablets_to_alter) {
+    SendAlterTabletRequest(tablet);
+  }
+  for (const auto& tablet : tablets_to_drop) {
+    SendDeleteTabletRequest(tablet, deletion_msg);
+  }
+  if (!tablets_to_add.empty()) {
+    background_tasks_->Wake();
+  }
+  resp->set_table_id(table->id());
   return Status::OK();
 }
 
@@ -2138,6 +2450,9 @@ class AsyncCreateReplica : public RetrySpecificTSRpcTask {
     req_.set_table_name(table_lock.data().pb.name());
     req_.mutable_schema()->CopyFrom(table_lock.data().pb.schema());
     req_.mutable_partition_schema()->CopyFrom(table_lock.data().pb.partition_schema());
+    if (table_lock.data().pb.has_row_ttl()) {
+      req_.mutable_row_ttl()->CopyFrom(table_lock.data().pb.row_ttl());
+    }
     req_.mutable_config()->CopyFrom(tablet_pb.committed_consensus_state().config());
   }
 
@@ -2340,6 +2655,9 @@ class AsyncAlterTable : public RetryingTSRpcTask {
     req.set_new_table_name(l.data().pb.name());
     req.set_schema_version(l.data().pb.version());
     req.mutable_schema()->CopyFrom(l.data().pb.schema());
+    if (l.data().pb.has_row_ttl()) {
+      req.mutable_row_ttl()->CopyFrom(l.data().pb.row_ttl());
+    }
     schema_version_ = l.data().pb.version();
 
     l.Unlock();
@@ -479,6 +479,20 @@ class CatalogManager : public tserver::TabletPeerLookupIf {
   scoped_refptr<TabletInfo> CreateTabletInfo(TableInfo* table,
                                              const PartitionPB& partition);
 
+  // Applies the ADD_RANGE_PARTITION and DROP_RANGE_PARTITION steps of an
+  // alter table request to 'table', whose write lock is held in 'l'. Range
+  // partition bounds are decoded using 'client_schema'.
+  //
+  // Tablets for added range partitions are created in the PREPARING state and
+  // left "write locked" (see CreateTabletInfo). Tablets belonging to dropped
+  // range partitions are returned, unlocked, in 'tablets_to_drop'.
+  Status ApplyAlterPartitioningSteps(const TableMetadataLock& l,
+                                     TableInfo* table,
+                                     const Schema& client_schema,
+                                     const std::vector<AlterTableRequestPB::Step>& steps,
+                                     std::vector<scoped_refptr<TabletInfo>>* tablets_to_add,
+                                     std::vector<scoped_refptr<TabletInfo>>* tablets_to_drop);
+
   // Builds the TabletLocationsPB for a tablet based on the provided TabletInfo.
   // Populates locs_pb and returns true on success.
   // Returns Status::ServiceUnavailable if tablet is not running.
@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/rpc/compression.h"
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <string>
+
+#include "kudu/cfile/compression_codec.h"
+#include "kudu/gutil/strings/util.h"
+#include "kudu/util/flag_tags.h"
+
+DEFINE_string(rpc_compression_codec, "none",
+              "Codec with which to compress the messages exchanged with peers "
+              "which are configured with the same codec: 'lz4', 'snappy' or "
+              "'none'. Compression trades CPU on both ends of a connection for "
+              "network bandwidth.");
+TAG_FLAG(rpc_compression_codec, experimental);
+
+DEFINE_int32(rpc_compression_min_size_bytes, 4096,
+             "Messages smaller than this are sent uncompressed on compressed "
+             "connections, since compressing them saves little bandwidth for "
+             "the CPU it costs.");
+TAG_FLAG(rpc_compression_min_size_bytes, experimental);
+TAG_FLAG(rpc_compression_min_size_bytes, runtime);
+
+using std::string;
+
+namespace kudu {
+namespace rpc {
+
+static bool ParseRpcCompressionCodec(const string& name, RpcCompressionCodec* codec) {
+  if (strcasecmp(name.c_str(), "none") == 0) {
+    *codec = RPC_COMPRESSION_UNKNOWN;
+  } else if (strcasecmp(name.c_str(), "lz4") == 0) {
+    *codec = RPC_COMPRESSION_LZ4;
+  } else if (strcasecmp(name.c_str(), "snappy") == 0) {
+    *codec = RPC_COMPRESSION_SNAPPY;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool ValidateRpcCompressionCodec(const char* flagname, const string& value) {
+  RpcCompressionCodec codec;
+  if (!ParseRpcCompressionCodec(value, &codec)) {
+    LOG(ERROR) << "Unknown value for " << flagname << ": " << value;
+    return false;
+  }
+  return true;
+}
+static bool dummy = google::RegisterFlagValidator(
+    &FLAGS_rpc_compression_codec, &ValidateRpcCompressionCodec);
+
+RpcCompressionCodec GetLocalRpcCompressionCodec() {
+  RpcCompressionCodec codec;
+  CHECK(ParseRpcCompressionCodec(FLAGS_rpc_compression_codec, &codec));
+  return codec;
+}
+
+Status GetRpcCompressionCodec(RpcCompressionCodec rpc_codec,
+                              const cfile::CompressionCodec** codec) {
+  switch (rpc_codec) {
+    case RPC_COMPRESSION_LZ4:
+      return cfile::GetCompressionCodec(LZ4, codec);
+    case RPC_COMPRESSION_SNAPPY:
+      return cfile::GetCompressionCodec(SNAPPY, codec);
+    default:
+      return Status::InvalidArgument("Unknown RPC compression codec",
+                                     RpcCompressionCodec_Name(rpc_codec));
+  }
+}
+
+} // namespace rpc
+} // namespace kudu
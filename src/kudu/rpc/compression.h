@@ -0,0 +1,53 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_RPC_COMPRESSION_H
+#define KUDU_RPC_COMPRESSION_H
+
+#include <gflags/gflags_declare.h>
+
+#include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/util/status.h"
+
+DECLARE_int32(rpc_compression_min_size_bytes);
+
+namespace kudu {
+
+namespace cfile {
+class CompressionCodec;
+} // namespace cfile
+
+namespace rpc {
+
+// Returns the codec which this process compresses its connections with, as
+// configured by --rpc_compression_codec, or RPC_COMPRESSION_UNKNOWN if
+// compression is disabled.
+//
+// A connection is compressed only if both peers are configured with the same
+// codec: the client offers its codec during negotiation, and the server
+// accepts it if it matches its own.
+RpcCompressionCodec GetLocalRpcCompressionCodec();
+
+// Sets 'codec' to the implementation of 'rpc_codec'.
+//
+// The returned codec is a singleton and should not be destroyed.
+Status GetRpcCompressionCodec(RpcCompressionCodec rpc_codec,
+                              const cfile::CompressionCodec** codec);
+
+} // namespace rpc
+} // namespace kudu
+
+#endif // KUDU_RPC_COMPRESSION_H
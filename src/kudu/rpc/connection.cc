@@ -31,6 +31,7 @@
 #include "kudu/gutil/strings/human_readable.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/auth_store.h"
+#include "kudu/rpc/compression.h"
 #include "kudu/rpc/rpc_introspection.pb.h"
 #include "kudu/rpc/constants.h"
 #include "kudu/rpc/messenger.h"
@@ -39,6 +40,7 @@
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/sasl_client.h"
 #include "kudu/rpc/sasl_server.h"
+#include "kudu/rpc/serialization.h"
 #include "kudu/rpc/transfer.h"
 #include "kudu/util/debug-util.h"
 #include "kudu/util/net/sockaddr.h"
@@ -63,13 +65,15 @@ Connection::Connection(ReactorThread *reactor_thread, Sockaddr remote,
     : reactor_thread_(reactor_thread),
       socket_(socket),
       remote_(std::move(remote)),
+      idx_(0),
       direction_(direction),
       last_activity_time_(MonoTime::Now(MonoTime::FINE)),
       is_epoll_registered_(false),
       next_call_id_(1),
       sasl_client_(kSaslAppName, socket),
       sasl_server_(kSaslAppName, socket),
-      negotiation_complete_(false) {}
+      negotiation_complete_(false),
+      compression_codec_(nullptr) {}
 
 Status Connection::SetNonBlocking(bool enabled) {
   return socket_.SetNonBlocking(enabled);
@@ -154,6 +158,12 @@ void Connection::Shutdown(const Status &status) {
   }
   awaiting_response_.clear();
 
+  // The responses to the calls being handled can no longer be sent, so there
+  // is no point in finishing them.
+  for (const inbound_call_map_t::value_type &v : calls_being_handled_) {
+    v.second->Cancel();
+  }
+
   // Clear any outbound transfers.
   while (!outbound_transfers_.empty()) {
     OutboundTransfer *t = &outbound_transfers_.front();
@@ -189,6 +199,27 @@ void Connection::QueueOutbound(gscoped_ptr<OutboundTransfer> transfer) {
   }
 }
 
+void Connection::MaybeCompress(OutboundTransfer* transfer) {
+  if (compression_codec_ == nullptr) {
+    return;
+  }
+  int32_t uncompressed_length = transfer->TotalLength();
+  if (uncompressed_length < FLAGS_rpc_compression_min_size_bytes) {
+    return;
+  }
+  Status s = transfer->Compress(compression_codec_);
+  if (PREDICT_FALSE(!s.ok())) {
+    // The transfer is still intact, so send it uncompressed.
+    LOG(WARNING) << ToString() << ": unable to compress RPC frame: " << s.ToString();
+    return;
+  }
+  int32_t compressed_length = transfer->TotalLength();
+  if (compressed_length < uncompressed_length) {
+    reactor_thread_->reactor()->messenger()->RecordCompressedFrame(uncompressed_length,
+                                                                   compressed_length);
+  }
+}
+
 Connection::CallAwaitingResponse::~CallAwaitingResponse() {
   DCHECK(conn->reactor_thread_->IsCurrentThread());
 }
@@ -221,6 +252,9 @@ void Connection::HandleOutboundCallTimeout(CallAwaitingResponse *car) {
   // Mark the call object as failed.
   car->call->SetTimedOut();
 
+  // The server may still be working on the call, which is now useless.
+  QueueCallCancellation(car->call->call_id());
+
   // Drop the reference to the call. If the original caller has moved on after
   // seeing the timeout, we no longer need to hold onto the allocated memory
   // from the request.
@@ -246,7 +280,7 @@ struct CallTransferCallbacks : public TransferCallbacks {
     // timed out before the transfer started, but there is still a race in the case of
     // a partial send that we have to handle here
     if (call_->IsFinished()) {
-      DCHECK(call_->IsTimedOut());
+      DCHECK(call_->IsTimedOut() || call_->IsCancelled());
     } else {
       call_->SetSent();
     }
@@ -346,6 +380,64 @@ void Connection::QueueOutboundCall(const shared_ptr<OutboundCall> &call) {
       OutboundTransfer::CreateForCallRequest(call_id, slices_tmp_, cb)));
 }
 
+void Connection::CancelOutboundCall(const shared_ptr<OutboundCall> &call) {
+  DCHECK_EQ(direction_, CLIENT);
+  DCHECK(reactor_thread_->IsCurrentThread());
+
+  CallAwaitingResponse* car = FindPtrOrNull(awaiting_response_, call->call_id());
+  if (car == nullptr || car->call != call) {
+    // The call already finished or timed out.
+    return;
+  }
+  DCHECK(!call->IsFinished());
+
+  car->timeout_timer.stop();
+  call->SetCancelled();
+
+  // As for a timeout, the CallAwaitingResponse stays in the map until the
+  // server responds, and the request is not sent if it is still queued.
+  car->call.reset();
+
+  QueueCallCancellation(call->call_id());
+}
+
+// Callbacks for sending a call cancellation, which own its serialized bytes.
+struct CancellationTransferCallbacks : public TransferCallbacks {
+ public:
+  virtual void NotifyTransferFinished() OVERRIDE {
+    delete this;
+  }
+
+  virtual void NotifyTransferAborted(const Status &status) OVERRIDE {
+    VLOG(1) << "Transfer of call cancellation aborted: " << status.ToString();
+    delete this;
+  }
+
+  faststring buf;
+};
+
+void Connection::QueueCallCancellation(int32_t call_id) {
+  DCHECK_EQ(direction_, CLIENT);
+  DCHECK(reactor_thread_->IsCurrentThread());
+
+  // Nothing was sent before negotiation completes.
+  if (!negotiation_complete_ ||
+      !ContainsKey(sasl_client_.server_features(), CALL_CANCELLATION)) {
+    return;
+  }
+
+  RequestHeader header;
+  header.set_call_id(kCancellationCallId);
+  header.set_cancelled_call_id(call_id);
+
+  // The main message is empty, so it only consists of its length.
+  CancellationTransferCallbacks* cb = new CancellationTransferCallbacks();
+  serialization::SerializeHeader(header, 1, &cb->buf);
+  cb->buf.push_back(0);
+  QueueOutbound(gscoped_ptr<OutboundTransfer>(
+      OutboundTransfer::CreateForCallCancellation({ Slice(cb->buf) }, cb)));
+}
+
 // Callbacks for sending an RPC call response from the server.
 // This takes ownership of the InboundCall object so that, once it has
 // been responded to, we can free up all of the associated memory.
@@ -423,6 +515,10 @@ void Connection::QueueResponseForCall(gscoped_ptr<InboundCall> call) {
   // when sending responses.
   gscoped_ptr<OutboundTransfer> t(OutboundTransfer::CreateForCallResponse(slices, cb));
 
+  // Compress the response here rather than on the reactor thread. Since the
+  // call was received, negotiation has completed.
+  MaybeCompress(t.get());
+
   QueueTransferTask *task = new QueueTransferTask(std::move(t), this);
   reactor_thread_->reactor()->ScheduleReactorTask(task);
 }
@@ -466,6 +562,18 @@ void Connection::ReadHandler(ev::io &watcher, int revents) {
     }
     DVLOG(3) << ToString() << ": finished reading " << inbound_->data().size() << " bytes";
 
+    if (inbound_->is_compressed()) {
+      int64_t compressed_length = inbound_->data().size();
+      status = inbound_->Uncompress(compression_codec_);
+      if (PREDICT_FALSE(!status.ok())) {
+        LOG(WARNING) << ToString() << " received bad data: " << status.ToString();
+        reactor_thread_->DestroyConnection(this, status);
+        return;
+      }
+      reactor_thread_->reactor()->messenger()->RecordCompressedFrame(inbound_->data().size(),
+                                                                     compressed_length);
+    }
+
     if (direction_ == CLIENT) {
       HandleCallResponse(std::move(inbound_));
     } else if (direction_ == SERVER) {
@@ -497,6 +605,11 @@ void Connection::HandleIncomingCall(gscoped_ptr<InboundTransfer> transfer) {
     return;
   }
 
+  if (PREDICT_FALSE(call->header().call_id() == kCancellationCallId)) {
+    HandleCallCancellation(call->header().cancelled_call_id());
+    return;
+  }
+
   if (!InsertIfNotPresent(&calls_being_handled_, call->call_id(), call.get())) {
     LOG(WARNING) << ToString() << ": received call ID " << call->call_id() <<
       " but was already processing this ID! Ignoring";
@@ -509,6 +622,17 @@ void Connection::HandleIncomingCall(gscoped_ptr<InboundTransfer> transfer) {
   reactor_thread_->reactor()->messenger()->QueueInboundCall(std::move(call));
 }
 
+void Connection::HandleCallCancellation(int32_t call_id) {
+  DCHECK(reactor_thread_->IsCurrentThread());
+
+  // The call may have been responded to already.
+  InboundCall* call = FindPtrOrNull(calls_being_handled_, call_id);
+  if (call != nullptr) {
+    VLOG(2) << ToString() << ": client cancelled call ID " << call_id;
+    call->Cancel();
+  }
+}
+
 void Connection::HandleCallResponse(gscoped_ptr<InboundTransfer> transfer) {
   DCHECK(reactor_thread_->IsCurrentThread());
   gscoped_ptr<CallResponse> resp(new CallResponse);
@@ -584,6 +708,10 @@ void Connection::WriteHandler(ev::io &watcher, int revents) {
           delete transfer;
           continue;
         }
+
+        // Requests may be queued before negotiation completes, so they are
+        // compressed just before they are sent.
+        MaybeCompress(transfer);
       }
     }
 
@@ -671,6 +799,12 @@ void Connection::CompleteNegotiation(const Status& negotiation_status) {
 void Connection::MarkNegotiationComplete() {
   DCHECK(reactor_thread_->IsCurrentThread());
   negotiation_complete_ = true;
+
+  RpcCompressionCodec codec = direction_ == CLIENT ? sasl_client_.compression_codec()
+                                                   : sasl_server_.compression_codec();
+  if (codec != RPC_COMPRESSION_UNKNOWN) {
+    CHECK_OK(GetRpcCompressionCodec(codec, &compression_codec_));
+  }
 }
 
 Status Connection::DumpPB(const DumpRunningRpcsRequestPB& req,
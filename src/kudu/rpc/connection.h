@@ -42,6 +42,11 @@
 #include "kudu/util/status.h"
 
 namespace kudu {
+
+namespace cfile {
+class CompressionCodec;
+} // namespace cfile
+
 namespace rpc {
 
 class DumpRunningRpcsRequestPB;
@@ -111,6 +116,12 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // This may be called from a non-reactor thread.
   void QueueOutboundCall(const std::shared_ptr<OutboundCall> &call);
 
+  // Cancel a call which was queued on this connection, if it is not finished
+  // yet. The call is marked cancelled, and the server is told to stop
+  // handling it if it supports cancellation.
+  // This must be called from the reactor thread.
+  void CancelOutboundCall(const std::shared_ptr<OutboundCall> &call);
+
   // Queue a call response back to the client on the server side.
   //
   // This may be called from a non-reactor thread.
@@ -128,6 +139,11 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // Get the user credentials which will be used to log in.
   const UserCredentials &user_credentials() const { return user_credentials_; }
 
+  // The index of a client connection among those to the same remote with the
+  // same credentials. See ConnectionId.
+  void set_idx(int idx) { idx_ = idx; }
+  int idx() const { return idx_; }
+
   RpczStore* rpcz_store();
 
   // libev callback when data is available to read.
@@ -217,11 +233,23 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // Set it to Failed.
   void HandleOutboundCallTimeout(CallAwaitingResponse *car);
 
+  // Tell the server to stop handling the call with ID 'call_id', which the
+  // client no longer waits for. Does nothing if the server doesn't support
+  // cancellation.
+  void QueueCallCancellation(int32_t call_id);
+
+  // The client cancelled the call with ID 'call_id' on the server side.
+  void HandleCallCancellation(int32_t call_id);
+
   // Queue a transfer for sending on this connection.
   // We will take ownership of the transfer.
   // This must be called from the reactor thread.
   void QueueOutbound(gscoped_ptr<OutboundTransfer> transfer);
 
+  // Compress 'transfer' if the connection negotiated compression and the
+  // transfer is large enough to be worth it.
+  void MaybeCompress(OutboundTransfer* transfer);
+
   // The reactor thread that created this connection.
   ReactorThread * const reactor_thread_;
 
@@ -234,6 +262,9 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // The credentials of the user operating on this connection (if a client user).
   UserCredentials user_credentials_;
 
+  // See ConnectionId::idx().
+  int idx_;
+
   // whether we are client or server
   Direction direction_;
 
@@ -287,6 +318,10 @@ class Connection : public RefCountedThreadSafe<Connection> {
 
   // Whether we completed connection negotiation.
   bool negotiation_complete_;
+
+  // The codec which frames are compressed with, or NULL if negotiation
+  // didn't enable compression. Set when negotiation completes.
+  const cfile::CompressionCodec* compression_codec_;
 };
 
 } // namespace rpc
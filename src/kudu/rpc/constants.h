@@ -41,6 +41,7 @@ static const uint32_t kCurrentRpcVersion = 9;
 // From Hadoop.
 static const int32_t kInvalidCallId = -2;
 static const int32_t kConnectionContextCallId = -3;
+static const int32_t kCancellationCallId = -4;
 static const int32_t kSaslCallId = -33;
 
 static const uint8_t kMagicNumberLength = 4;
@@ -49,6 +50,12 @@ static const uint8_t kHeaderFlagsLength = 3;
 // There is a 4-byte length prefix before any packet.
 static const uint8_t kMsgLengthPrefixLength = 4;
 
+// Bit set in the length prefix of a frame which is compressed with the codec
+// negotiated for the connection. The prefix of a compressed frame is
+// followed by the length of the uncompressed frame, also on 4 bytes.
+static const uint32_t kCompressedFrameBit = 1U << 31;
+static const uint8_t kUncompressedLengthLength = 4;
+
 // The set of RPC features that this server build supports.
 // Non-const for testing.
 extern std::set<RpcFeatureFlag> kSupportedServerRpcFeatureFlags;
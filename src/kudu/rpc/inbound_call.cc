@@ -17,11 +17,13 @@
 
 #include "kudu/rpc/inbound_call.h"
 
+#include <algorithm>
 #include <glog/stl_logging.h>
 #include <memory>
 
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/connection.h"
+#include "kudu/rpc/constants.h"
 #include "kudu/rpc/rpc_introspection.pb.h"
 #include "kudu/rpc/rpc_sidecar.h"
 #include "kudu/rpc/rpcz_store.h"
@@ -46,7 +48,8 @@ InboundCall::InboundCall(Connection* conn)
   : conn_(conn),
     sidecars_deleter_(&sidecars_),
     trace_(new Trace),
-    method_info_(nullptr) {
+    method_info_(nullptr),
+    cancelled_(false) {
   RecordCallReceived();
 }
 
@@ -57,6 +60,14 @@ Status InboundCall::ParseFrom(gscoped_ptr<InboundTransfer> transfer) {
   TRACE_EVENT0("rpc", "InboundCall::ParseFrom");
   RETURN_NOT_OK(serialization::ParseMessage(transfer->data(), &header_, &serialized_request_));
 
+  // Cancellations are handled by the connection, and have no method.
+  if (PREDICT_FALSE(header_.call_id() == kCancellationCallId)) {
+    if (PREDICT_FALSE(!header_.has_cancelled_call_id())) {
+      return Status::Corruption("Call cancellation must specify cancelled_call_id");
+    }
+    return Status::OK();
+  }
+
   // Adopt the service/method info from the header as soon as it's available.
   if (PREDICT_FALSE(!header_.has_remote_method())) {
     return Status::Corruption("Non-connection context request header must specify remote_method");
@@ -99,6 +110,16 @@ void InboundCall::RespondFailure(ErrorStatusPB::RpcErrorCodePB error_code,
   Respond(err, false);
 }
 
+void InboundCall::RespondServerTooBusy(const Status& status, const MonoDelta& retry_after) {
+  TRACE_EVENT0("rpc", "InboundCall::RespondServerTooBusy");
+  ErrorStatusPB err;
+  err.set_message(status.ToString());
+  err.set_code(ErrorStatusPB::ERROR_SERVER_TOO_BUSY);
+  err.set_retry_after_ms(std::max<int64_t>(0, retry_after.ToMilliseconds()));
+
+  Respond(err, false);
+}
+
 void InboundCall::RespondApplicationError(int error_ext_id, const std::string& message,
                                           const MessageLite& app_error_pb) {
   ErrorStatusPB err;
@@ -29,6 +29,7 @@
 #include "kudu/rpc/service_if.h"
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/transfer.h"
+#include "kudu/util/atomic.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/slice.h"
@@ -108,6 +109,10 @@ class InboundCall {
   void RespondFailure(ErrorStatusPB::RpcErrorCodePB error_code,
                       const Status &status);
 
+  // Like RespondFailure(ERROR_SERVER_TOO_BUSY, status), but also asks the
+  // client to wait at least 'retry_after' before retrying.
+  void RespondServerTooBusy(const Status& status, const MonoDelta& retry_after);
+
   void RespondUnsupportedFeature(const std::vector<uint32_t>& unsupported_features);
 
   void RespondApplicationError(int error_ext_id, const std::string& message,
@@ -175,6 +180,20 @@ class InboundCall {
   // call response will be ignored anyway.
   bool ClientTimedOut() const;
 
+  // Mark the call as cancelled, because the client cancelled it or
+  // disconnected. May be called from the reactor thread while the call is
+  // being handled.
+  void Cancel() {
+    cancelled_.Store(true);
+  }
+
+  // Return true if the client no longer waits for the response to this
+  // call. As when the client timed out, the server may stop processing the
+  // call, since the response will be dropped.
+  bool cancelled() const {
+    return cancelled_.Load();
+  }
+
   // Return an upper bound on the client timeout deadline. This does not
   // account for transmission delays between the client and the server.
   // If the client did not specify a deadline, returns MonoTime::Max().
@@ -245,6 +264,9 @@ class InboundCall {
   // per-method info such as tracing.
   scoped_refptr<RpcMethodInfo> method_info_;
 
+  // Set by Cancel().
+  AtomicBool cancelled_;
+
   DISALLOW_COPY_AND_ASSIGN(InboundCall);
 };
 
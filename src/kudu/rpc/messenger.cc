@@ -59,6 +59,37 @@ DEFINE_int32(rpc_default_keepalive_time_ms, 65000,
              "will disconnect the client.");
 TAG_FLAG(rpc_default_keepalive_time_ms, advanced);
 
+METRIC_DEFINE_counter(server, rpc_bytes_before_compression,
+                      "RPC Bytes Before Compression",
+                      kudu::MetricUnit::kBytes,
+                      "Number of bytes of the RPC frames sent or received compressed, "
+                      "before compression");
+METRIC_DEFINE_counter(server, rpc_bytes_after_compression,
+                      "RPC Bytes After Compression",
+                      kudu::MetricUnit::kBytes,
+                      "Number of bytes of the RPC frames sent or received compressed, "
+                      "after compression");
+
+DEFINE_int32(rpc_num_connections_per_server, 1,
+             "Number of connections a messenger opens to each server it sends calls to. "
+             "With more than one, high priority calls such as consensus heartbeats are "
+             "sent on a connection of their own, so that they aren't delayed behind "
+             "large transfers such as scan responses, and the other calls are spread "
+             "across the remaining connections, which are handled by different reactor "
+             "threads where possible.");
+TAG_FLAG(rpc_num_connections_per_server, advanced);
+TAG_FLAG(rpc_num_connections_per_server, experimental);
+
+static bool ValidateNumConnectionsPerServer(const char* flagname, int32_t value) {
+  if (value < 1) {
+    LOG(ERROR) << flagname << " must be at least 1.";
+    return false;
+  }
+  return true;
+}
+static bool dummy = google::RegisterFlagValidator(
+    &FLAGS_rpc_num_connections_per_server, &ValidateNumConnectionsPerServer);
+
 namespace kudu {
 namespace rpc {
 
@@ -203,10 +234,28 @@ Status Messenger::UnregisterService(const string& service_name) {
 }
 
 void Messenger::QueueOutboundCall(const shared_ptr<OutboundCall> &call) {
-  Reactor *reactor = RemoteToReactor(call->conn_id().remote());
+  int idx = ConnectionIdxForCall(*call);
+  call->set_conn_idx(idx);
+  Reactor *reactor = RemoteToReactor(call->conn_id().remote(), idx);
   reactor->QueueOutboundCall(call);
 }
 
+void Messenger::QueueCancellation(const shared_ptr<OutboundCall> &call) {
+  // The cancellation goes to the reactor which the call was queued on.
+  Reactor *reactor = RemoteToReactor(call->conn_id().remote(), call->conn_id().idx());
+  reactor->QueueCancellation(call);
+}
+
+int Messenger::ConnectionIdxForCall(const OutboundCall& call) {
+  // The first connection is reserved for high priority calls, if there are
+  // several.
+  int num_conns = FLAGS_rpc_num_connections_per_server;
+  if (num_conns == 1 || call.controller()->high_priority()) {
+    return 0;
+  }
+  return 1 + next_bulk_conn_idx_.Increment() % (num_conns - 1);
+}
+
 void Messenger::QueueInboundCall(gscoped_ptr<InboundCall> call) {
   shared_lock<rw_spinlock> guard(&lock_.get_lock());
   scoped_refptr<RpcService>* service = FindOrNull(rpc_services_,
@@ -226,7 +275,7 @@ void Messenger::QueueInboundCall(gscoped_ptr<InboundCall> call) {
 }
 
 void Messenger::RegisterInboundSocket(Socket *new_socket, const Sockaddr &remote) {
-  Reactor *reactor = RemoteToReactor(remote);
+  Reactor *reactor = RemoteToReactor(remote, 0);
   reactor->RegisterInboundSocket(new_socket, remote);
 }
 
@@ -235,7 +284,12 @@ Messenger::Messenger(const MessengerBuilder &bld)
     closing_(false),
     rpcz_store_(new RpczStore()),
     metric_entity_(bld.metric_entity_),
+    next_bulk_conn_idx_(0),
     retain_self_(this) {
+  if (metric_entity_) {
+    bytes_before_compression_ = METRIC_rpc_bytes_before_compression.Instantiate(metric_entity_);
+    bytes_after_compression_ = METRIC_rpc_bytes_after_compression.Instantiate(metric_entity_);
+  }
   for (int i = 0; i < bld.num_reactors_; i++) {
     reactors_.push_back(new Reactor(retain_self_, i, bld));
   }
@@ -250,9 +304,16 @@ Messenger::~Messenger() {
   STLDeleteElements(&reactors_);
 }
 
-Reactor* Messenger::RemoteToReactor(const Sockaddr &remote) {
+void Messenger::RecordCompressedFrame(int64_t uncompressed_bytes, int64_t compressed_bytes) {
+  if (bytes_before_compression_) {
+    bytes_before_compression_->IncrementBy(uncompressed_bytes);
+    bytes_after_compression_->IncrementBy(compressed_bytes);
+  }
+}
+
+Reactor* Messenger::RemoteToReactor(const Sockaddr &remote, int idx) {
   uint32_t hashCode = remote.HashCode();
-  int reactor_idx = hashCode % reactors_.size();
+  int reactor_idx = (hashCode + idx) % reactors_.size();
   // This is just a static partitioning; we could get a lot
   // fancier with assigning Sockaddrs to Reactors.
   return reactors_[reactor_idx];
@@ -30,6 +30,7 @@
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/rpc/response_callback.h"
+#include "kudu/util/atomic.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
@@ -156,6 +157,10 @@ class Messenger {
   // and enqueue a task on that reactor to assign and send the call.
   void QueueOutboundCall(const std::shared_ptr<OutboundCall> &call);
 
+  // Queue the cancellation of a call which was queued with
+  // QueueOutboundCall(). See RpcController::Cancel().
+  void QueueCancellation(const std::shared_ptr<OutboundCall> &call);
+
   // Enqueue a call for processing on the server.
   void QueueInboundCall(gscoped_ptr<InboundCall> call);
 
@@ -177,6 +182,10 @@ class Messenger {
 
   RpczStore* rpcz_store() { return rpcz_store_.get(); }
 
+  // Account for a frame of 'uncompressed_bytes' which was sent or received
+  // compressed to 'compressed_bytes'.
+  void RecordCompressedFrame(int64_t uncompressed_bytes, int64_t compressed_bytes);
+
   int num_reactors() const { return reactors_.size(); }
 
   std::string name() const {
@@ -197,7 +206,12 @@ class Messenger {
 
   explicit Messenger(const MessengerBuilder &bld);
 
-  Reactor* RemoteToReactor(const Sockaddr &remote);
+  // Returns the reactor which handles the 'idx'-th connection to or from
+  // 'remote'. The connections to a remote are spread across reactors.
+  Reactor* RemoteToReactor(const Sockaddr &remote, int idx);
+
+  // Returns which of the connections to its remote 'call' should be sent on.
+  int ConnectionIdxForCall(const OutboundCall& call);
   Status Init();
   void RunTimeoutThread();
   void UpdateCurTime();
@@ -230,6 +244,13 @@ class Messenger {
 
   scoped_refptr<MetricEntity> metric_entity_;
 
+  // Compression metrics. NULL if the messenger has no metric entity.
+  scoped_refptr<Counter> bytes_before_compression_;
+  scoped_refptr<Counter> bytes_after_compression_;
+
+  // Used to spread the calls which aren't high priority across connections.
+  AtomicInt<uint32_t> next_bulk_conn_idx_;
+
   // The ownership of the Messenger object is somewhat subtle. The pointer graph
   // looks like this:
   //
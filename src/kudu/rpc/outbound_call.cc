@@ -136,6 +136,8 @@ string OutboundCall::StateName(State state) {
       return "FINISHED_ERROR";
     case FINISHED_SUCCESS:
       return "FINISHED_SUCCESS";
+    case CANCELLED:
+      return "CANCELLED";
     default:
       LOG(DFATAL) << "Unknown state in OutboundCall: " << state;
       return StringPrintf("UNKNOWN(%d)", state);
@@ -164,6 +166,7 @@ void OutboundCall::set_state_unlocked(State new_state) {
       DCHECK_EQ(state_, ON_OUTBOUND_QUEUE);
       break;
     case TIMED_OUT:
+    case CANCELLED:
       DCHECK(state_ == SENT || state_ == ON_OUTBOUND_QUEUE);
       break;
     case FINISHED_SUCCESS:
@@ -283,6 +286,23 @@ bool OutboundCall::IsTimedOut() const {
   return state_ == TIMED_OUT;
 }
 
+void OutboundCall::SetCancelled() {
+  {
+    lock_guard<simple_spinlock> l(&lock_);
+    status_ = Status::Aborted(Substitute(
+        "$0 RPC to $1 was cancelled",
+        remote_method_.method_name(),
+        conn_id_.remote().ToString()));
+    set_state_unlocked(CANCELLED);
+  }
+  CallCallback();
+}
+
+bool OutboundCall::IsCancelled() const {
+  lock_guard<simple_spinlock> l(&lock_);
+  return state_ == CANCELLED;
+}
+
 bool OutboundCall::IsFinished() const {
   lock_guard<simple_spinlock> l(&lock_);
   switch (state_) {
@@ -293,6 +313,7 @@ bool OutboundCall::IsFinished() const {
     case TIMED_OUT:
     case FINISHED_ERROR:
     case FINISHED_SUCCESS:
+    case CANCELLED:
       return true;
     default:
       LOG(FATAL) << "Unknown call state: " << state_;
@@ -377,13 +398,16 @@ bool UserCredentials::Equals(const UserCredentials& other) const {
 /// ConnectionId
 ///
 
-ConnectionId::ConnectionId() {}
+ConnectionId::ConnectionId()
+    : idx_(0) {
+}
 
 ConnectionId::ConnectionId(const ConnectionId& other) {
   DoCopyFrom(other);
 }
 
-ConnectionId::ConnectionId(const Sockaddr& remote, const UserCredentials& user_credentials) {
+ConnectionId::ConnectionId(const Sockaddr& remote, const UserCredentials& user_credentials)
+    : idx_(0) {
   remote_ = remote;
   user_credentials_.CopyFrom(user_credentials);
 }
@@ -402,26 +426,30 @@ void ConnectionId::CopyFrom(const ConnectionId& other) {
 
 string ConnectionId::ToString() const {
   // Does not print the password.
-  return StringPrintf("{remote=%s, user_credentials=%s}",
+  return StringPrintf("{remote=%s, user_credentials=%s, idx=%d}",
       remote_.ToString().c_str(),
-      user_credentials_.ToString().c_str());
+      user_credentials_.ToString().c_str(),
+      idx_);
 }
 
 void ConnectionId::DoCopyFrom(const ConnectionId& other) {
   remote_ = other.remote_;
   user_credentials_.CopyFrom(other.user_credentials_);
+  idx_ = other.idx_;
 }
 
 size_t ConnectionId::HashCode() const {
   size_t seed = 0;
   boost::hash_combine(seed, remote_.HashCode());
   boost::hash_combine(seed, user_credentials_.HashCode());
+  boost::hash_combine(seed, idx_);
   return seed;
 }
 
 bool ConnectionId::Equals(const ConnectionId& other) const {
   return (remote() == other.remote()
-       && user_credentials().Equals(other.user_credentials()));
+       && user_credentials().Equals(other.user_credentials())
+       && idx() == other.idx());
 }
 
 size_t ConnectionIdHash::operator() (const ConnectionId& conn_id) const {
@@ -117,6 +117,11 @@ class ConnectionId {
   const UserCredentials& user_credentials() const { return user_credentials_; }
   UserCredentials* mutable_user_credentials() { return &user_credentials_; }
 
+  // The index of the connection among those to the same remote with the same
+  // credentials. See Messenger::QueueOutboundCall().
+  void set_idx(int idx) { idx_ = idx; }
+  int idx() const { return idx_; }
+
   // Copy state from another object to this one.
   void CopyFrom(const ConnectionId& other);
 
@@ -130,6 +135,7 @@ class ConnectionId {
   // Remember to update HashCode() and Equals() when new fields are added.
   Sockaddr remote_;
   UserCredentials user_credentials_;
+  int idx_;
 
   // Implementation of CopyFrom that can be shared with copy constructor.
   void DoCopyFrom(const ConnectionId& other);
@@ -200,6 +206,11 @@ class OutboundCall {
   void SetTimedOut();
   bool IsTimedOut() const;
 
+  // Mark the call as cancelled by the caller. This also triggers the
+  // callback to notify the caller.
+  void SetCancelled();
+  bool IsCancelled() const;
+
   // Is the call finished?
   bool IsFinished() const;
 
@@ -219,6 +230,10 @@ class OutboundCall {
   ////////////////////////////////////////////////////////////
 
   const ConnectionId& conn_id() const { return conn_id_; }
+
+  // Pick which of the connections to the remote the call is sent on. Must be
+  // called before the call is queued.
+  void set_conn_idx(int idx) { conn_id_.set_idx(idx); }
   const RemoteMethod& remote_method() const { return remote_method_; }
   const ResponseCallback &callback() const { return callback_; }
   RpcController* controller() { return controller_; }
@@ -246,7 +261,8 @@ class OutboundCall {
     SENT = 2,
     TIMED_OUT = 3,
     FINISHED_ERROR = 4,
-    FINISHED_SUCCESS = 5
+    FINISHED_SUCCESS = 5,
+    CANCELLED = 6
   };
 
   static std::string StateName(State state);
@@ -420,7 +420,7 @@ class CodeGenerator : public ::google::protobuf::compiler::CodeGenerator {
           "  \"$rpc_full_name$ RPC Time\",\n"
           "  kudu::MetricUnit::kMicroseconds,\n"
           "  \"Microseconds spent handling $rpc_full_name$() RPC requests\",\n"
-          "  60000000LU, 2);\n"
+          "  60000000LU, 2, kudu::STRIPED_HISTOGRAM);\n"
           "\n");
         subs->Pop();
       }
@@ -79,6 +79,7 @@ void Proxy::AsyncRequest(const string& method,
   RemoteMethod remote_method(service_name_, method);
   OutboundCall* call = new OutboundCall(conn_id_, remote_method, response, controller, callback);
   controller->call_.reset(call);
+  controller->messenger_ = messenger_.get();
   call->SetRequestParam(req);
 
   // If this fails to queue, the callback will get called immediately
@@ -30,6 +30,7 @@
 
 #include <glog/logging.h>
 
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/rpc/connection.h"
@@ -225,6 +226,21 @@ void ReactorThread::AssignOutboundCall(const shared_ptr<OutboundCall> &call) {
   conn->QueueOutboundCall(call);
 }
 
+void ReactorThread::CancelOutboundCall(const shared_ptr<OutboundCall> &call) {
+  DCHECK(IsCurrentThread());
+  if (call->IsFinished()) {
+    return;
+  }
+
+  // An unfinished call which was assigned is on its connection, unless the
+  // connection is being torn down.
+  scoped_refptr<Connection> conn = FindWithDefault(client_conns_, call->conn_id(),
+                                                   scoped_refptr<Connection>());
+  if (conn) {
+    conn->CancelOutboundCall(call);
+  }
+}
+
 //
 // Handles timer events.  The periodic timer:
 //
@@ -334,6 +350,7 @@ Status ReactorThread::FindOrStartConnection(const ConnectionId &conn_id,
   // Register the new connection in our map.
   *conn = new Connection(this, conn_id.remote(), sock.Release(), Connection::CLIENT);
   (*conn)->set_user_credentials(conn_id.user_credentials());
+  (*conn)->set_idx(conn_id.idx());
 
   // Kick off blocking client connection negotiation.
   Status s = StartConnectionNegotiation(*conn);
@@ -425,6 +442,7 @@ void ReactorThread::DestroyConnection(Connection *conn,
   // Unlink connection from lists.
   if (conn->direction() == Connection::CLIENT) {
     ConnectionId conn_id(conn->remote(), conn->user_credentials());
+    conn_id.set_idx(conn->idx());
     auto it = client_conns_.find(conn_id);
     CHECK(it != client_conns_.end()) << "Couldn't find connection " << conn->ToString();
     client_conns_.erase(it);
@@ -625,6 +643,32 @@ void Reactor::QueueOutboundCall(const shared_ptr<OutboundCall> &call) {
   ScheduleReactorTask(task);
 }
 
+// Task which runs in the reactor thread to cancel an outbound call.
+class CancelOutboundCallTask : public ReactorTask {
+ public:
+  explicit CancelOutboundCallTask(shared_ptr<OutboundCall> call)
+      : call_(std::move(call)) {}
+
+  virtual void Run(ReactorThread *reactor) OVERRIDE {
+    reactor->CancelOutboundCall(call_);
+    delete this;
+  }
+
+  virtual void Abort(const Status &status) OVERRIDE {
+    // The call is failed by the reactor shutdown.
+    delete this;
+  }
+
+ private:
+  shared_ptr<OutboundCall> call_;
+};
+
+void Reactor::QueueCancellation(const shared_ptr<OutboundCall> &call) {
+  DVLOG(3) << name_ << ": queueing cancellation of call " << call->ToString();
+  CancelOutboundCallTask *task = new CancelOutboundCallTask(call);
+  ScheduleReactorTask(task);
+}
+
 void Reactor::ScheduleReactorTask(ReactorTask *task) {
   {
     unique_lock<LockType> l(&lock_);
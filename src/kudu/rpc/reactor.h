@@ -180,6 +180,7 @@ class ReactorThread {
 
  private:
   friend class AssignOutboundCallTask;
+  friend class CancelOutboundCallTask;
   friend class RegisterConnectionTask;
   friend class DelayedTask;
 
@@ -216,6 +217,10 @@ class ReactorThread {
   // If this fails, the call is marked failed and completed.
   void AssignOutboundCall(const std::shared_ptr<OutboundCall> &call);
 
+  // Cancel an outbound call which was assigned to a connection, if it is
+  // not finished yet.
+  void CancelOutboundCall(const std::shared_ptr<OutboundCall> &call);
+
   // Register a new connection.
   void RegisterConnection(const scoped_refptr<Connection>& conn);
 
@@ -292,6 +297,10 @@ class Reactor {
   // the call as failed.
   void QueueOutboundCall(const std::shared_ptr<OutboundCall> &call);
 
+  // Queue the cancellation of a call which was queued on this reactor. The
+  // cancellation runs after the call is assigned to its connection.
+  void QueueCancellation(const std::shared_ptr<OutboundCall> &call);
+
   // Schedule the given task's Run() method to be called on the
   // reactor thread.
   // If the reactor shuts down before it is run, the Abort method will be
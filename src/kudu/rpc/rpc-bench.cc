@@ -24,6 +24,7 @@
 #include <string>
 
 #include "kudu/gutil/atomicops.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/rpc-test-base.h"
 #include "kudu/rpc/rtest.proxy.h"
 #include "kudu/util/countdown_latch.h"
@@ -52,6 +53,14 @@ DEFINE_int32(server_reactors, 4,
 
 DEFINE_int32(run_seconds, 1, "Seconds to run the test");
 
+DEFINE_int32(echo_payload_bytes, 64 * 1024,
+             "Size of the compressible payload echoed by the compression benchmark");
+
+DECLARE_string(rpc_compression_codec);
+
+METRIC_DECLARE_counter(rpc_bytes_before_compression);
+METRIC_DECLARE_counter(rpc_bytes_after_compression);
+
 namespace kudu {
 namespace rpc {
 
@@ -96,6 +105,26 @@ class RpcBench : public RpcTestBase {
 
   }
 
+  // Logs how much the RPC frames were compressed since the last call.
+  void SummarizeCompression() {
+    scoped_refptr<Counter> before = METRIC_rpc_bytes_before_compression.Instantiate(
+        server_messenger_->metric_entity());
+    scoped_refptr<Counter> after = METRIC_rpc_bytes_after_compression.Instantiate(
+        server_messenger_->metric_entity());
+    int64_t before_bytes = before->value() - last_bytes_before_compression_;
+    int64_t after_bytes = after->value() - last_bytes_after_compression_;
+    last_bytes_before_compression_ = before->value();
+    last_bytes_after_compression_ = after->value();
+
+    LOG(INFO) << "Codec:            " << FLAGS_rpc_compression_codec;
+    LOG(INFO) << "Bytes before compression: " << before_bytes;
+    LOG(INFO) << "Bytes after compression:  " << after_bytes;
+    if (after_bytes > 0) {
+      LOG(INFO) << "Compression ratio:        "
+                << static_cast<double>(before_bytes) / after_bytes;
+    }
+  }
+
  protected:
   friend class ClientThread;
   friend class ClientAsyncWorkload;
@@ -103,6 +132,12 @@ class RpcBench : public RpcTestBase {
   Sockaddr server_addr_;
   Atomic32 should_run_;
   CountDownLatch stop_;
+
+  // If not empty, clients echo this payload rather than adding numbers.
+  string echo_payload_;
+
+  int64_t last_bytes_before_compression_ = 0;
+  int64_t last_bytes_after_compression_ = 0;
 };
 
 class ClientThread {
@@ -125,6 +160,11 @@ class ClientThread {
 
     CalculatorServiceProxy p(client_messenger, bench_->server_addr_);
 
+    if (!bench_->echo_payload_.empty()) {
+      RunEcho(&p);
+      return;
+    }
+
     AddRequestPB req;
     AddResponsePB resp;
     while (Acquire_Load(&bench_->should_run_)) {
@@ -138,6 +178,19 @@ class ClientThread {
     }
   }
 
+  void RunEcho(CalculatorServiceProxy* p) {
+    EchoRequestPB req;
+    req.set_data(bench_->echo_payload_);
+    EchoResponsePB resp;
+    while (Acquire_Load(&bench_->should_run_)) {
+      RpcController controller;
+      controller.set_timeout(MonoDelta::FromSeconds(10));
+      CHECK_OK(p->Echo(req, &resp, &controller));
+      CHECK_EQ(req.data().size(), resp.data().size());
+      request_count_++;
+    }
+  }
+
   gscoped_ptr<boost::thread> thread_;
   RpcBench *bench_;
   int request_count_;
@@ -170,6 +223,49 @@ TEST_F(RpcBench, BenchmarkCalls) {
   SummarizePerf(sw.elapsed(), total_reqs, true);
 }
 
+// Measure the CPU cost and the bandwidth savings of each compression codec,
+// by echoing a compressible payload.
+TEST_F(RpcBench, BenchmarkCompression) {
+  // A payload which compresses about as well as rows of a typical table.
+  while (echo_payload_.size() < static_cast<size_t>(FLAGS_echo_payload_bytes)) {
+    echo_payload_.append(strings::Substitute("$0,host-$1.example.com,$2;",
+                                             echo_payload_.size(),
+                                             echo_payload_.size() % 97,
+                                             echo_payload_.size() * 7919 % 10007));
+  }
+  echo_payload_.resize(FLAGS_echo_payload_bytes);
+
+  for (const char* codec : { "none", "lz4", "snappy" }) {
+    // The codec is negotiated when the clients connect, so each round uses
+    // new client messengers.
+    FLAGS_rpc_compression_codec = codec;
+    Release_Store(&should_run_, true);
+
+    Stopwatch sw(Stopwatch::ALL_THREADS);
+    sw.start();
+
+    boost::ptr_vector<ClientThread> threads;
+    for (int i = 0; i < FLAGS_client_threads; i++) {
+      auto thr = new ClientThread(this);
+      thr->Start();
+      threads.push_back(thr);
+    }
+
+    SleepFor(MonoDelta::FromSeconds(FLAGS_run_seconds));
+    Release_Store(&should_run_, false);
+
+    int total_reqs = 0;
+    for (ClientThread &thr : threads) {
+      thr.Join();
+      total_reqs += thr.request_count_;
+    }
+    sw.stop();
+
+    SummarizePerf(sw.elapsed(), total_reqs, true);
+    SummarizeCompression();
+  }
+}
+
 class ClientAsyncWorkload {
  public:
   ClientAsyncWorkload(RpcBench *bench, shared_ptr<Messenger> messenger)
@@ -26,7 +26,9 @@
 
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/join.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/constants.h"
+#include "kudu/rpc/rpc_introspection.pb.h"
 #include "kudu/rpc/serialization.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/env.h"
@@ -35,8 +37,13 @@
 
 METRIC_DECLARE_histogram(handler_latency_kudu_rpc_test_CalculatorService_Sleep);
 METRIC_DECLARE_histogram(rpc_incoming_queue_time);
+METRIC_DECLARE_counter(rpc_bytes_before_compression);
+METRIC_DECLARE_counter(rpc_bytes_after_compression);
 
+DECLARE_bool(rpc_inject_compressed_length_mismatch);
 DECLARE_int32(rpc_negotiation_inject_delay_ms);
+DECLARE_int32(rpc_num_connections_per_server);
+DECLARE_string(rpc_compression_codec);
 
 using std::string;
 using std::shared_ptr;
@@ -266,6 +273,43 @@ TEST_F(TestRpc, TestCallLongerThanKeepalive) {
                                  req, &resp, &controller));
 }
 
+// Test that calls are spread across several connections to the same server,
+// with high priority calls on a connection of their own.
+TEST_F(TestRpc, TestMultipleConnectionsPerServer) {
+  FLAGS_rpc_num_connections_per_server = 3;
+
+  // Set up server.
+  Sockaddr server_addr;
+  StartTestServer(&server_addr);
+
+  // Set up client.
+  shared_ptr<Messenger> client_messenger(CreateMessenger("Client", 3));
+  Proxy p(client_messenger, server_addr, GenericCalculatorService::static_service_name());
+
+  // Calls which aren't high priority go round robin over two connections.
+  for (int i = 0; i < 4; i++) {
+    ASSERT_OK(DoTestSyncCall(p, GenericCalculatorService::kAddMethodName));
+  }
+  DumpRunningRpcsRequestPB dump_req;
+  DumpRunningRpcsResponsePB dump_resp;
+  ASSERT_OK(client_messenger->DumpRunningRpcs(dump_req, &dump_resp));
+  ASSERT_EQ(2, dump_resp.outbound_connections_size());
+
+  // A high priority call gets the third one.
+  AddRequestPB req;
+  req.set_x(1);
+  req.set_y(2);
+  AddResponsePB resp;
+  RpcController controller;
+  controller.set_high_priority(true);
+  ASSERT_OK(p.SyncRequest(GenericCalculatorService::kAddMethodName, req, &resp, &controller));
+  ASSERT_EQ(3, resp.result());
+
+  dump_resp.Clear();
+  ASSERT_OK(client_messenger->DumpRunningRpcs(dump_req, &dump_resp));
+  ASSERT_EQ(3, dump_resp.outbound_connections_size());
+}
+
 // Test that the RpcSidecar transfers the expected messages.
 TEST_F(TestRpc, TestRpcSidecar) {
   // Set up server.
@@ -284,6 +328,113 @@ TEST_F(TestRpc, TestRpcSidecar) {
   DoTestSidecar(p, 3000 * 1024, 2000 * 1024);
 }
 
+// Test that calls go through on compressed connections, and that large
+// messages are actually compressed.
+TEST_F(TestRpc, TestCompression) {
+  FLAGS_rpc_compression_codec = "lz4";
+
+  // Set up server.
+  Sockaddr server_addr;
+  StartTestServerWithGeneratedCode(&server_addr);
+
+  // Set up client.
+  shared_ptr<Messenger> client_messenger(CreateMessenger("Client"));
+  CalculatorServiceProxy p(client_messenger, server_addr);
+
+  // The client and the server share the same metric entity, so each
+  // compressed frame is accounted for twice: when sent and when received.
+  scoped_refptr<Counter> before = METRIC_rpc_bytes_before_compression.Instantiate(
+      server_messenger_->metric_entity());
+  scoped_refptr<Counter> after = METRIC_rpc_bytes_after_compression.Instantiate(
+      server_messenger_->metric_entity());
+
+  // Small messages are sent uncompressed.
+  {
+    AddRequestPB req;
+    req.set_x(10);
+    req.set_y(20);
+    AddResponsePB resp;
+    RpcController controller;
+    ASSERT_OK(p.Add(req, &resp, &controller));
+    ASSERT_EQ(30, resp.result());
+    ASSERT_EQ(0, before->value());
+  }
+
+  // Both the request and the response of a large, compressible echo are
+  // compressed.
+  {
+    string data;
+    for (int i = 0; i < 10000; i++) {
+      data.append(strings::Substitute("row $0,", i % 100));
+    }
+    EchoRequestPB req;
+    req.set_data(data);
+    EchoResponsePB resp;
+    RpcController controller;
+    ASSERT_OK(p.Echo(req, &resp, &controller));
+    ASSERT_EQ(data, resp.data());
+    ASSERT_GT(before->value(), 4 * data.size());
+    ASSERT_LT(after->value(), before->value() / 4);
+  }
+}
+
+// Test that sidecars, which are compressed along with the rest of their
+// frame, make it through compressed connections.
+TEST_F(TestRpc, TestCompressionWithSidecars) {
+  FLAGS_rpc_compression_codec = "snappy";
+
+  // Set up server.
+  Sockaddr server_addr;
+  StartTestServer(&server_addr);
+
+  // Set up client.
+  shared_ptr<Messenger> client_messenger(CreateMessenger("Client"));
+  Proxy p(client_messenger, server_addr, GenericCalculatorService::static_service_name());
+
+  DoTestSidecar(p, 123, 456);
+  DoTestSidecar(p, 3000 * 1024, 2000 * 1024);
+}
+
+// Test that a compressed frame whose declared uncompressed length doesn't
+// match its contents gets its connection torn down, rather than overrunning
+// the receive buffer.
+TEST_F(TestRpc, TestCompressedFrameLengthMismatch) {
+  FLAGS_rpc_compression_codec = "snappy";
+  n_server_reactor_threads_ = 1;
+
+  // Set up server.
+  Sockaddr server_addr;
+  StartTestServerWithGeneratedCode(&server_addr);
+
+  // Set up client.
+  shared_ptr<Messenger> client_messenger(CreateMessenger("Client"));
+  CalculatorServiceProxy p(client_messenger, server_addr);
+
+  EchoRequestPB req;
+  req.set_data(string(100 * 1024, 'x'));
+  EchoResponsePB resp;
+  {
+    FLAGS_rpc_inject_compressed_length_mismatch = true;
+    RpcController controller;
+    Status s = p.Echo(req, &resp, &controller);
+    ASSERT_TRUE(s.IsNetworkError()) << s.ToString();
+  }
+  ReactorMetrics metrics;
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(server_messenger_->reactors_[0]->GetMetrics(&metrics));
+    if (metrics.num_server_connections_ == 0) break;
+    SleepFor(MonoDelta::FromMilliseconds(10));
+  }
+  ASSERT_EQ(0, metrics.num_server_connections_) << "Server should have torn the connection down";
+
+  // The server is still healthy, and serves well-formed frames on a new
+  // connection.
+  FLAGS_rpc_inject_compressed_length_mismatch = false;
+  RpcController controller;
+  ASSERT_OK(p.Echo(req, &resp, &controller));
+  ASSERT_EQ(req.data(), resp.data());
+}
+
 // Test that timeouts are properly handled.
 TEST_F(TestRpc, TestCallTimeout) {
   Sockaddr server_addr;
@@ -305,6 +456,55 @@ TEST_F(TestRpc, TestCallTimeout) {
   ASSERT_NO_FATAL_FAILURE(DoTestExpectTimeout(p, MonoDelta::FromMilliseconds(1500)));
 }
 
+// Test that a cancelled call fails on the client right away, and is dropped
+// by the server while it waits in the service queue.
+TEST_F(TestRpc, TestCancellation) {
+  n_worker_threads_ = 1;
+  Sockaddr server_addr;
+  StartTestServer(&server_addr);
+  shared_ptr<Messenger> client_messenger(CreateMessenger("Client"));
+  Proxy p(client_messenger, server_addr, GenericCalculatorService::static_service_name());
+
+  // Keep the only worker thread busy.
+  SleepRequestPB busy_req;
+  busy_req.set_sleep_micros(500 * 1000);
+  SleepResponsePB busy_resp;
+  RpcController busy_controller;
+  CountDownLatch busy_latch(1);
+  p.AsyncRequest(GenericCalculatorService::kSleepMethodName, busy_req, &busy_resp,
+                 &busy_controller,
+                 boost::bind(&CountDownLatch::CountDown, boost::ref(busy_latch)));
+
+  // Queue a second call behind it, and cancel it.
+  SleepRequestPB req;
+  req.set_sleep_micros(1);
+  SleepResponsePB resp;
+  RpcController controller;
+  CountDownLatch latch(1);
+  p.AsyncRequest(GenericCalculatorService::kSleepMethodName, req, &resp,
+                 &controller, boost::bind(&CountDownLatch::CountDown, boost::ref(latch)));
+  SleepFor(MonoDelta::FromMilliseconds(100));
+  controller.Cancel();
+  latch.Wait();
+  ASSERT_TRUE(controller.status().IsAborted()) << controller.status().ToString();
+
+  // The first call is unaffected, and the cancelled one is skipped once the
+  // worker thread is free.
+  busy_latch.Wait();
+  ASSERT_OK(busy_controller.status());
+  for (int i = 0; i < 100; i++) {
+    if (service_pool_->RpcsCancelledInQueueMetricForTests()->value() == 1) {
+      break;
+    }
+    SleepFor(MonoDelta::FromMilliseconds(10));
+  }
+  ASSERT_EQ(1, service_pool_->RpcsCancelledInQueueMetricForTests()->value());
+
+  // Cancelling a finished call has no effect.
+  controller.Cancel();
+  ASSERT_TRUE(controller.status().IsAborted());
+}
+
 // Inject 500ms delay in negotiation, and send a call with a short timeout, followed by
 // one with a long timeout. The call with the long timeout should succeed even though
 // the previous one failed.
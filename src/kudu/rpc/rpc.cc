@@ -17,6 +17,7 @@
 
 #include "kudu/rpc/rpc.h"
 
+#include <algorithm>
 #include <boost/bind.hpp>
 #include <string>
 
@@ -62,6 +63,12 @@ void RpcRetrier::DelayedRetry(Rpc* rpc, const Status& why_status) {
   // If the delay causes us to miss our deadline, RetryCb will fail the
   // RPC on our behalf.
   int num_ms = ++attempt_num_ + ((rand() % 5));
+
+  // Wait at least as long as the server asked us to, if it did.
+  const ErrorStatusPB* err = controller_.error_response();
+  if (err && err->has_retry_after_ms()) {
+    num_ms = std::max<int>(num_ms, err->retry_after_ms());
+  }
   messenger_->ScheduleOnReactor(boost::bind(&RpcRetrier::DelayedRetryCb,
                                             this,
                                             rpc, _1),
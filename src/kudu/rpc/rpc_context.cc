@@ -114,6 +114,17 @@ void RpcContext::RespondRpcFailure(ErrorStatusPB_RpcErrorCodePB err, const Statu
   delete this;
 }
 
+void RpcContext::RespondServerTooBusy(const Status& status, const MonoDelta& retry_after) {
+  VLOG(4) << call_->remote_method().service_name() << ": Sending server too busy response for "
+          << call_->ToString() << ": " << status.ToString()
+          << " (retry after " << retry_after.ToString() << ")";
+  TRACE_EVENT_ASYNC_END2("rpc_call", "RPC", this,
+                         "status", status.ToString(),
+                         "trace", trace()->DumpToString());
+  call_->RespondServerTooBusy(status, retry_after);
+  delete this;
+}
+
 void RpcContext::RespondApplicationError(int error_ext_id, const std::string& message,
                                          const Message& app_error_pb) {
   if (VLOG_IS_ON(4)) {
@@ -150,6 +161,10 @@ MonoTime RpcContext::GetClientDeadline() const {
   return call_->GetClientDeadline();
 }
 
+bool RpcContext::cancelled() const {
+  return call_->cancelled();
+}
+
 Trace* RpcContext::trace() {
   return call_->trace();
 }
@@ -101,6 +101,13 @@ class RpcContext {
   // and response protobufs are also destroyed.
   void RespondRpcFailure(ErrorStatusPB_RpcErrorCodePB err, const Status& status);
 
+  // Respond with ERROR_SERVER_TOO_BUSY, asking the client to wait at least
+  // 'retry_after' before retrying the RPC.
+  //
+  // After this method returns, this RpcContext object is destroyed. The request
+  // and response protobufs are also destroyed.
+  void RespondServerTooBusy(const Status& status, const MonoDelta& retry_after);
+
   // Respond with an application-level error. This causes the caller to get a
   // RemoteError status with the provided string message. Additionally, a
   // service-specific error extension is passed back to the client. The
@@ -166,6 +173,11 @@ class RpcContext {
   // If the client did not specify a deadline, returns MonoTime::Max().
   MonoTime GetClientDeadline() const;
 
+  // Return true if the client cancelled the call or disconnected. Since the
+  // response will not reach the client, long-running handlers should check
+  // this periodically and give up early.
+  bool cancelled() const;
+
   // Panic the server. This logs a fatal error with the given message, and
   // also includes the current RPC request, requestor, trace information, etc,
   // to make it easier to debug.
@@ -19,11 +19,14 @@
 #include <glog/logging.h>
 
 #include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/messenger.h"
 #include "kudu/rpc/outbound_call.h"
 
 namespace kudu { namespace rpc {
 
-RpcController::RpcController() {
+RpcController::RpcController()
+    : high_priority_(false),
+      messenger_(nullptr) {
   DVLOG(4) << "RpcController " << this << " constructed";
 }
 
@@ -41,6 +44,8 @@ void RpcController::Swap(RpcController* other) {
   }
 
   std::swap(timeout_, other->timeout_);
+  std::swap(high_priority_, other->high_priority_);
+  std::swap(messenger_, other->messenger_);
   std::swap(call_, other->call_);
 }
 
@@ -97,5 +102,29 @@ MonoDelta RpcController::timeout() const {
   return timeout_;
 }
 
+void RpcController::set_high_priority(bool high_priority) {
+  lock_guard<simple_spinlock> l(&lock_);
+  DCHECK(!call_ || call_->state() == OutboundCall::READY);
+  high_priority_ = high_priority;
+}
+
+bool RpcController::high_priority() const {
+  lock_guard<simple_spinlock> l(&lock_);
+  return high_priority_;
+}
+
+void RpcController::Cancel() {
+  std::shared_ptr<OutboundCall> call;
+  {
+    lock_guard<simple_spinlock> l(&lock_);
+    call = call_;
+  }
+  if (!call || call->IsFinished()) {
+    return;
+  }
+  DCHECK(messenger_);
+  messenger_->QueueCancellation(call);
+}
+
 } // namespace rpc
 } // namespace kudu
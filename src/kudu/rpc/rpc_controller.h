@@ -32,6 +32,7 @@ namespace kudu {
 namespace rpc {
 
 class ErrorStatusPB;
+class Messenger;
 class OutboundCall;
 
 // Controller for managing properties of a single RPC call, on the client side.
@@ -155,6 +156,24 @@ class RpcController {
   // Return the configured timeout.
   MonoDelta timeout() const;
 
+  // Mark the call as latency-sensitive, such as a consensus heartbeat. When
+  // the messenger opens several connections to each server (see
+  // --rpc_num_connections_per_server), such calls are sent on a connection of
+  // their own, so that they don't queue up behind bulk transfers like large
+  // scan responses.
+  void set_high_priority(bool high_priority);
+  bool high_priority() const;
+
+  // Cancel the call, if it was sent and has not finished yet. The call's
+  // callback is then run with an Aborted status, and the server is told to
+  // stop handling the call if it supports it. The server may still have
+  // executed the call, partly or fully.
+  //
+  // Unlike the other methods, this may be called from any thread while the
+  // call is in flight. The cancellation is asynchronous: the call may still
+  // finish otherwise in the meantime.
+  void Cancel();
+
   // Fills the 'sidecar' parameter with the slice pointing to the i-th
   // sidecar upon success.
   //
@@ -170,6 +189,10 @@ class RpcController {
 
   MonoDelta timeout_;
   std::unordered_set<uint32_t> required_server_features_;
+  bool high_priority_;
+
+  // The messenger which the call was sent with. Set by Proxy.
+  Messenger* messenger_;
 
   mutable simple_spinlock lock_;
 
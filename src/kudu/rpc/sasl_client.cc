@@ -30,6 +30,7 @@
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/rpc/blocking_ops.h"
+#include "kudu/rpc/compression.h"
 #include "kudu/rpc/constants.h"
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/sasl_common.h"
@@ -84,6 +85,7 @@ SaslClient::SaslClient(string app_name, int fd)
     : app_name_(std::move(app_name)),
       sock_(fd),
       helper_(SaslHelper::CLIENT),
+      compression_codec_(RPC_COMPRESSION_UNKNOWN),
       client_state_(SaslNegotiationState::NEW),
       negotiated_mech_(SaslMechanism::INVALID),
       deadline_(MonoTime::Max()) {
@@ -262,6 +264,12 @@ Status SaslClient::SendNegotiateMessage() {
     msg.add_supported_features(feature);
   }
 
+  // Offer to compress the connection, if configured to.
+  RpcCompressionCodec codec = GetLocalRpcCompressionCodec();
+  if (codec != RPC_COMPRESSION_UNKNOWN) {
+    msg.add_compression_codecs(codec);
+  }
+
   TRACE("SASL Client: Sending NEGOTIATE request to server.");
   RETURN_NOT_OK(SendSaslMessage(msg));
   nego_response_expected_ = true;
@@ -318,6 +326,17 @@ Status SaslClient::HandleNegotiateResponse(const SaslMessagePB& response) {
     }
   }
 
+  // The server picks at most one of the compression codecs we offered.
+  if (response.compression_codecs_size() > 0) {
+    int codec = response.compression_codecs(0);
+    if (PREDICT_FALSE(response.compression_codecs_size() > 1 ||
+                      codec != GetLocalRpcCompressionCodec())) {
+      return Status::IllegalState("Server picked a compression codec which wasn't offered",
+                                  response.ShortDebugString());
+    }
+    compression_codec_ = static_cast<RpcCompressionCodec>(codec);
+  }
+
   // Build the list of SASL mechanisms requested by the client, and a map
   // back to to the SaslAuth PBs.
   string mech_list;
@@ -67,6 +67,13 @@ class SaslClient {
     return server_features_;
   }
 
+  // Returns the codec which the connection's messages may be compressed with,
+  // or RPC_COMPRESSION_UNKNOWN if the server didn't accept any.
+  // Must be called after Negotiate().
+  RpcCompressionCodec compression_codec() const {
+    return compression_codec_;
+  }
+
   // Specify IP:port of local side of connection.
   // Must be called before Init(). Required for some mechanisms.
   void set_local_addr(const Sockaddr& addr);
@@ -156,6 +163,9 @@ class SaslClient {
   // The set of features supported by the server.
   std::set<RpcFeatureFlag> server_features_;
 
+  // The compression codec accepted by the server.
+  RpcCompressionCodec compression_codec_;
+
   SaslNegotiationState::Type client_state_;
 
   // The mechanism we negotiated with the server.
@@ -30,6 +30,7 @@
 #include "kudu/gutil/strings/split.h"
 #include "kudu/rpc/blocking_ops.h"
 #include "kudu/rpc/auth_store.h"
+#include "kudu/rpc/compression.h"
 #include "kudu/rpc/constants.h"
 #include "kudu/rpc/serialization.h"
 #include "kudu/util/net/sockaddr.h"
@@ -55,6 +56,7 @@ SaslServer::SaslServer(string app_name, int fd)
     : app_name_(std::move(app_name)),
       sock_(fd),
       helper_(SaslHelper::SERVER),
+      compression_codec_(RPC_COMPRESSION_UNKNOWN),
       server_state_(SaslNegotiationState::NEW),
       negotiated_mech_(SaslMechanism::INVALID),
       deadline_(MonoTime::Max()) {
@@ -283,6 +285,16 @@ Status SaslServer::HandleNegotiateRequest(const SaslMessagePB& request) {
     }
   }
 
+  // Pick the first compression codec offered by the client which we are
+  // configured to use ourselves.
+  RpcCompressionCodec local_codec = GetLocalRpcCompressionCodec();
+  for (int codec : request.compression_codecs()) {
+    if (local_codec != RPC_COMPRESSION_UNKNOWN && codec == local_codec) {
+      compression_codec_ = local_codec;
+      break;
+    }
+  }
+
   set<string> server_mechs = helper_.LocalMechs();
   if (PREDICT_FALSE(server_mechs.empty())) {
     // This will happen if no mechanisms are enabled before calling Init()
@@ -316,6 +328,11 @@ Status SaslServer::SendNegotiateResponse(const set<string>& server_mechs) {
     response.add_supported_features(feature);
   }
 
+  // Tell the client which compression codec we picked, if any.
+  if (compression_codec_ != RPC_COMPRESSION_UNKNOWN) {
+    response.add_compression_codecs(compression_codec_);
+  }
+
   RETURN_NOT_OK(SendSaslMessage(response));
   TRACE("Sent NEGOTIATE response");
   return Status::OK();
@@ -67,6 +67,13 @@ class SaslServer {
     return client_features_;
   }
 
+  // Returns the codec which the connection's messages may be compressed with,
+  // or RPC_COMPRESSION_UNKNOWN if none of the client's codecs were accepted.
+  // Must be called after Negotiate().
+  RpcCompressionCodec compression_codec() const {
+    return compression_codec_;
+  }
+
   // Name of the user that authenticated using plain auth.
   // Must be called after Negotiate() only if the negotiated mechanism was PLAIN.
   const std::string& plain_auth_user() const;
@@ -154,6 +161,9 @@ class SaslServer {
   // after we receive the NEGOTIATE request from the client.
   std::set<RpcFeatureFlag> client_features_;
 
+  // The compression codec picked among the ones offered by the client.
+  RpcCompressionCodec compression_codec_;
+
   // The successfully-authenticated user, if applicable.
   string plain_auth_user_;
 
@@ -49,6 +49,13 @@ METRIC_DEFINE_counter(server, rpcs_timed_out_in_queue,
                       "Number of RPCs whose timeout elapsed while waiting "
                       "in the service queue, and thus were not processed.");
 
+METRIC_DEFINE_counter(server, rpcs_cancelled_in_queue,
+                      "RPC Queue Cancellations",
+                      kudu::MetricUnit::kRequests,
+                      "Number of RPCs which the client cancelled or disconnected "
+                      "from while they waited in the service queue, and thus "
+                      "were not processed.");
+
 METRIC_DEFINE_counter(server, rpcs_queue_overflow,
                       "RPC Queue Overflows",
                       kudu::MetricUnit::kRequests,
@@ -65,6 +72,7 @@ ServicePool::ServicePool(gscoped_ptr<ServiceIf> service,
     service_queue_(service_queue_length),
     incoming_queue_time_(METRIC_rpc_incoming_queue_time.Instantiate(entity)),
     rpcs_timed_out_in_queue_(METRIC_rpcs_timed_out_in_queue.Instantiate(entity)),
+    rpcs_cancelled_in_queue_(METRIC_rpcs_cancelled_in_queue.Instantiate(entity)),
     rpcs_queue_overflow_(METRIC_rpcs_queue_overflow.Instantiate(entity)),
     closing_(false) {
 }
@@ -198,6 +206,19 @@ void ServicePool::RunThread() {
       continue;
     }
 
+    if (PREDICT_FALSE(incoming->cancelled())) {
+      TRACE_TO(incoming->trace(), "Skipping call since client cancelled it");
+      rpcs_cancelled_in_queue_->Increment();
+
+      // The response is dropped, either by the client or because the
+      // connection is gone.
+      incoming->RespondFailure(
+        ErrorStatusPB::ERROR_SERVER_TOO_BUSY,
+        Status::Aborted("Call was cancelled while waiting in the queue"));
+      ignore_result(incoming.release());
+      continue;
+    }
+
     TRACE_TO(incoming->trace(), "Handling call");
 
     // Release the InboundCall pointer -- when the call is responded to,
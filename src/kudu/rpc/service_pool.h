@@ -65,6 +65,10 @@ class ServicePool : public RpcService {
     return rpcs_timed_out_in_queue_.get();
   }
 
+  const Counter* RpcsCancelledInQueueMetricForTests() const {
+    return rpcs_cancelled_in_queue_.get();
+  }
+
   const Histogram* IncomingQueueTimeMetricForTests() const {
     return incoming_queue_time_.get();
   }
@@ -84,6 +88,7 @@ class ServicePool : public RpcService {
   LifoServiceQueue service_queue_;
   scoped_refptr<Histogram> incoming_queue_time_;
   scoped_refptr<Counter> rpcs_timed_out_in_queue_;
+  scoped_refptr<Counter> rpcs_cancelled_in_queue_;
   scoped_refptr<Counter> rpcs_queue_overflow_;
 
   mutable Mutex shutdown_lock_;
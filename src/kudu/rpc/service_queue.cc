@@ -16,6 +16,9 @@
 // under the License.
 
 #include "kudu/rpc/service_queue.h"
+
+#include <algorithm>
+
 #include "kudu/util/logging.h"
 
 namespace kudu {
@@ -90,10 +93,13 @@ QueueStatus LifoServiceQueue::Put(InboundCall* call,
   if (PREDICT_FALSE(queue_.size() >= max_queue_size_)) {
     // eviction
     DCHECK_EQ(queue_.size(), max_queue_size_);
-    auto it = queue_.end();
-    --it;
-    if (DeadlineLess(*it, call)) {
-      return QUEUE_FULL;
+    auto it = std::find_if(queue_.begin(), queue_.end(),
+                           [](const InboundCall* c) { return c->cancelled(); });
+    if (it == queue_.end()) {
+      --it;
+      if (DeadlineLess(*it, call)) {
+        return QUEUE_FULL;
+      }
     }
 
     *evicted = *it;
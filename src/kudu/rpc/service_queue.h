@@ -39,8 +39,8 @@ enum QueueStatus {
 
 // Blocking queue used for passing inbound RPC calls to the service handler pool.
 // Calls are dequeued in 'earliest-deadline first' order. The queue also maintains a
-// bounded number of calls. If the queue overflows, then calls with deadlines farthest
-// in the future are evicted.
+// bounded number of calls. If the queue overflows, then calls which the client
+// cancelled are evicted first, and then calls with deadlines farthest in the future.
 //
 // When calls do not provide deadlines, the RPC layer considers their deadline to
 // be infinitely in the future. This means that any call that does have a deadline
@@ -24,6 +24,7 @@
 
 #include <glog/logging.h>
 
+#include "kudu/cfile/compression_codec.h"
 #include "kudu/gutil/endian.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/constants.h"
@@ -38,6 +39,12 @@ DEFINE_int32(rpc_max_message_size, (50 * 1024 * 1024),
 TAG_FLAG(rpc_max_message_size, advanced);
 TAG_FLAG(rpc_max_message_size, runtime);
 
+DEFINE_bool(rpc_inject_compressed_length_mismatch, false,
+            "If true, understate the uncompressed length of every compressed "
+            "RPC frame sent. For testing only!");
+TAG_FLAG(rpc_inject_compressed_length_mismatch, unsafe);
+TAG_FLAG(rpc_inject_compressed_length_mismatch, hidden);
+
 static bool ValidateMaxMessageSize(const char* flagname, int32_t value) {
   if (value < 1 * 1024 * 1024) {
     LOG(ERROR) << flagname << " must be at least 1MB.";
@@ -54,6 +61,7 @@ namespace rpc {
 using std::ostringstream;
 using std::set;
 using std::string;
+using std::vector;
 using strings::Substitute;
 
 #define RETURN_ON_ERROR_OR_SOCKET_NOT_READY(status) \
@@ -69,7 +77,8 @@ TransferCallbacks::~TransferCallbacks()
 
 InboundTransfer::InboundTransfer()
   : total_length_(kMsgLengthPrefixLength),
-    cur_offset_(0) {
+    cur_offset_(0),
+    compressed_(false) {
   buf_.resize(kMsgLengthPrefixLength);
 }
 
@@ -95,8 +104,10 @@ Status InboundTransfer::ReceiveBuffer(Socket &socket) {
     DCHECK_EQ(cur_offset_, kMsgLengthPrefixLength);
 
     // The length prefix doesn't include its own 4 bytes, so we have to
-    // add that back in.
-    total_length_ = NetworkByteOrder::Load32(&buf_[0]) + kMsgLengthPrefixLength;
+    // add that back in. Its top bit flags compressed frames.
+    uint32_t prefix = NetworkByteOrder::Load32(&buf_[0]);
+    compressed_ = prefix & kCompressedFrameBit;
+    total_length_ = (prefix & ~kCompressedFrameBit) + kMsgLengthPrefixLength;
     if (total_length_ > FLAGS_rpc_max_message_size) {
       return Status::NetworkError(Substitute(
           "RPC frame had a length of $0, but we only support messages up to $1 bytes "
@@ -130,6 +141,39 @@ bool InboundTransfer::TransferFinished() const {
   return cur_offset_ == total_length_;
 }
 
+Status InboundTransfer::Uncompress(const cfile::CompressionCodec* codec) {
+  DCHECK(TransferFinished());
+  DCHECK(compressed_);
+  if (PREDICT_FALSE(codec == nullptr)) {
+    return Status::NetworkError("Received a compressed RPC frame on a connection "
+                                "which didn't negotiate compression");
+  }
+  const int32_t kCompressedHeaderLength = kMsgLengthPrefixLength + kUncompressedLengthLength;
+  if (PREDICT_FALSE(total_length_ < kCompressedHeaderLength)) {
+    return Status::NetworkError(Substitute("Compressed RPC frame had invalid length of $0",
+                                           total_length_));
+  }
+  int64_t uncompressed_length = NetworkByteOrder::Load32(&buf_[kMsgLengthPrefixLength]);
+  if (uncompressed_length + kMsgLengthPrefixLength > FLAGS_rpc_max_message_size) {
+    return Status::NetworkError(Substitute(
+        "Compressed RPC frame had an uncompressed length of $0, but we only support "
+        "messages up to $1 bytes long.", uncompressed_length + kMsgLengthPrefixLength,
+        FLAGS_rpc_max_message_size));
+  }
+
+  // Uncompress the frame back into 'buf_', in place of its compressed form.
+  faststring compressed;
+  compressed.append(&buf_[kCompressedHeaderLength], total_length_ - kCompressedHeaderLength);
+  buf_.resize(kMsgLengthPrefixLength + uncompressed_length);
+  RETURN_NOT_OK_PREPEND(codec->Uncompress(Slice(compressed), &buf_[kMsgLengthPrefixLength],
+                                          uncompressed_length),
+                        "Unable to uncompress RPC frame");
+  NetworkByteOrder::Store32(&buf_[0], uncompressed_length);
+  total_length_ = cur_offset_ = buf_.size();
+  compressed_ = false;
+  return Status::OK();
+}
+
 string InboundTransfer::StatusAsString() const {
   return Substitute("$0/$1 bytes received", cur_offset_, total_length_);
 }
@@ -146,6 +190,12 @@ OutboundTransfer* OutboundTransfer::CreateForCallResponse(const std::vector<Slic
   return new OutboundTransfer(kInvalidCallId, payload, callbacks);
 }
 
+OutboundTransfer* OutboundTransfer::CreateForCallCancellation(
+    const std::vector<Slice> &payload,
+    TransferCallbacks *callbacks) {
+  return new OutboundTransfer(kInvalidCallId, payload, callbacks);
+}
+
 
 OutboundTransfer::OutboundTransfer(int32_t call_id,
                                    const std::vector<Slice> &payload,
@@ -255,5 +305,37 @@ int32_t OutboundTransfer::TotalLength() const {
   return ret;
 }
 
+Status OutboundTransfer::Compress(const cfile::CompressionCodec* codec) {
+  DCHECK(!TransferStarted());
+  DCHECK_GE(payload_slices_[0].size(), kMsgLengthPrefixLength);
+
+  // Compress everything but the length prefix: the header, the main message
+  // and its sidecars.
+  vector<Slice> frame(payload_slices_, payload_slices_ + n_payload_slices_);
+  frame[0].remove_prefix(kMsgLengthPrefixLength);
+  size_t uncompressed_length = TotalLength() - kMsgLengthPrefixLength;
+
+  const size_t kCompressedHeaderLength = kMsgLengthPrefixLength + kUncompressedLengthLength;
+  compressed_buf_.resize(kCompressedHeaderLength + codec->MaxCompressedLength(uncompressed_length));
+  size_t compressed_length;
+  RETURN_NOT_OK(codec->Compress(frame, &compressed_buf_[kCompressedHeaderLength],
+                                &compressed_length));
+  if (compressed_length + kUncompressedLengthLength >= uncompressed_length) {
+    compressed_buf_.clear();
+    return Status::OK();
+  }
+  compressed_buf_.resize(kCompressedHeaderLength + compressed_length);
+  NetworkByteOrder::Store32(&compressed_buf_[0],
+                            (compressed_length + kUncompressedLengthLength) | kCompressedFrameBit);
+  if (PREDICT_FALSE(FLAGS_rpc_inject_compressed_length_mismatch)) {
+    uncompressed_length /= 2;
+  }
+  NetworkByteOrder::Store32(&compressed_buf_[kMsgLengthPrefixLength], uncompressed_length);
+
+  payload_slices_[0] = Slice(compressed_buf_);
+  n_payload_slices_ = 1;
+  return Status::OK();
+}
+
 } // namespace rpc
 } // namespace kudu
@@ -28,6 +28,7 @@
 #include <vector>
 
 #include "kudu/rpc/constants.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/status.h"
 
@@ -43,6 +44,10 @@ namespace kudu {
 
 class Socket;
 
+namespace cfile {
+class CompressionCodec;
+} // namespace cfile
+
 namespace rpc {
 
 class Messenger;
@@ -68,6 +73,17 @@ class InboundTransfer {
   // Return true if the entire transfer has been sent.
   bool TransferFinished() const;
 
+  // Return true if the received frame is compressed, in which case it must
+  // be uncompressed before its data is parsed.
+  bool is_compressed() const {
+    return compressed_;
+  }
+
+  // Uncompress the received frame with 'codec', the codec negotiated for the
+  // connection (NULL if none was). Afterwards, data() returns the frame as
+  // it was before it was compressed.
+  Status Uncompress(const cfile::CompressionCodec* codec);
+
   Slice data() const {
     return Slice(buf_);
   }
@@ -85,6 +101,8 @@ class InboundTransfer {
   int32_t total_length_;
   int32_t cur_offset_;
 
+  bool compressed_;
+
   DISALLOW_COPY_AND_ASSIGN(InboundTransfer);
 };
 
@@ -121,6 +139,11 @@ class OutboundTransfer : public boost::intrusive::list_base_hook<> {
   static OutboundTransfer* CreateForCallResponse(const std::vector<Slice> &payload,
                                                  TransferCallbacks *callbacks);
 
+  // Create an outbound transfer for a call cancellation, which the server
+  // does not respond to.
+  static OutboundTransfer* CreateForCallCancellation(const std::vector<Slice> &payload,
+                                                     TransferCallbacks *callbacks);
+
   // Destruct the transfer. A transfer object should never be deallocated
   // before it has either (a) finished transferring, or (b) been Abort()ed.
   ~OutboundTransfer();
@@ -141,6 +164,11 @@ class OutboundTransfer : public boost::intrusive::list_base_hook<> {
   // Return the total number of bytes to be sent (including those already sent)
   int32_t TotalLength() const;
 
+  // Compress the frame with 'codec', the codec negotiated for the connection.
+  // The transfer is left as is if compressing it doesn't make it smaller.
+  // Must be called before the transfer starts.
+  Status Compress(const cfile::CompressionCodec* codec);
+
   std::string HexDump() const;
 
   bool is_for_outbound_call() const {
@@ -171,6 +199,10 @@ class OutboundTransfer : public boost::intrusive::list_base_hook<> {
 
   TransferCallbacks *callbacks_;
 
+  // The compressed frame, which payload_slices_ is pointed at once the
+  // transfer is compressed.
+  faststring compressed_buf_;
+
   // In the case of outbound calls, the associated call ID.
   // In the case of call responses, kInvalidCallId
   int32_t call_id_;
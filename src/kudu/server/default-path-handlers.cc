@@ -29,6 +29,7 @@
 
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/human_readable.h"
+#include "kudu/gutil/strings/numbers.h"
 #include "kudu/gutil/strings/split.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/server/pprof-path-handlers.h"
@@ -39,6 +40,7 @@
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/jsonwriter.h"
+#include "kudu/util/prometheus_writer.h"
 
 using boost::replace_all;
 using google::CommandlineFlagsIntoString;
@@ -168,11 +170,41 @@ void AddDefaultPathHandlers(Webserver* webserver) {
 }
 
 
-static void WriteMetricsAsJson(const MetricRegistry* const metrics,
-                               const Webserver::WebRequest& req, std::stringstream* output) {
+// Parse the parameters of a metrics request which select the metrics to write.
+static void ParseMetricsFilters(const Webserver::WebRequest& req,
+                                vector<string>* requested_metrics,
+                                MetricJsonOptions* opts) {
   const string* requested_metrics_param = FindOrNull(req.parsed_args, "metrics");
+  if (requested_metrics_param != nullptr) {
+    SplitStringUsing(*requested_metrics_param, ",", requested_metrics);
+  } else {
+    // Default to including all metrics.
+    requested_metrics->push_back("*");
+  }
+
+  const string* types_param = FindOrNull(req.parsed_args, "types");
+  if (types_param != nullptr) {
+    SplitStringUsing(*types_param, ",", &opts->entity_types);
+  }
+  const string* prefixes_param = FindOrNull(req.parsed_args, "metric_prefixes");
+  if (prefixes_param != nullptr) {
+    SplitStringUsing(*prefixes_param, ",", &opts->metric_name_prefixes);
+  }
+}
+
+// Writes the metrics as JSON. If the 'since_epoch' parameter is set, only
+// the metrics modified in or after that epoch are written, and the output is
+// wrapped in an object along with the epoch to pass on the next such scrape:
+//
+// {
+//   "epoch": 12,
+//   "entities": [ ... ]
+// }
+static void WriteMetricsAsJson(const MetricRegistry* const metrics,
+                               const Webserver::WebRequest& req, std::ostream* output) {
   vector<string> requested_metrics;
   MetricJsonOptions opts;
+  ParseMetricsFilters(req, &requested_metrics, &opts);
 
   {
     string arg = FindWithDefault(req.parsed_args, "include_raw_histograms", "false");
@@ -188,30 +220,52 @@ static void WriteMetricsAsJson(const MetricRegistry* const metrics,
     json_mode = ParseLeadingBoolValue(arg.c_str(), false) ?
       JsonWriter::COMPACT : JsonWriter::PRETTY;
   }
+  const string* since_epoch_param = FindOrNull(req.parsed_args, "since_epoch");
 
   JsonWriter writer(output, json_mode);
 
-  if (requested_metrics_param != nullptr) {
-    SplitStringUsing(*requested_metrics_param, ",", &requested_metrics);
-  } else {
-    // Default to including all metrics.
-    requested_metrics.push_back("*");
+  if (since_epoch_param != nullptr) {
+    opts.only_modified_in_or_after_epoch = ParseLeadingInt64Value(*since_epoch_param, 0);
+    writer.StartObject();
+    writer.String("epoch");
+    writer.Int64(Metric::IncrementEpoch());
+    writer.String("entities");
   }
-
   WARN_NOT_OK(metrics->WriteAsJson(&writer, requested_metrics, opts),
               "Couldn't write JSON metrics over HTTP");
+  if (since_epoch_param != nullptr) {
+    writer.EndObject();
+  }
+}
+
+// Writes the metrics in the Prometheus text format. Since Prometheus
+// considers the series missing from a scrape to be stale, there is no
+// equivalent to the 'since_epoch' parameter of the JSON output.
+static void WriteMetricsAsPrometheus(const MetricRegistry* const metrics,
+                                     const Webserver::WebRequest& req, std::ostream* output) {
+  vector<string> requested_metrics;
+  MetricJsonOptions opts;
+  ParseMetricsFilters(req, &requested_metrics, &opts);
+
+  PrometheusWriter writer(output);
+  WARN_NOT_OK(metrics->WriteAsPrometheus(&writer, requested_metrics, opts),
+              "Couldn't write Prometheus metrics over HTTP");
 }
 
 void RegisterMetricsJsonHandler(Webserver* webserver, const MetricRegistry* const metrics) {
-  Webserver::PathHandlerCallback callback = boost::bind(WriteMetricsAsJson, metrics, _1, _2);
-  bool not_styled = false;
+  Webserver::StreamingPathHandlerCallback callback =
+      boost::bind(WriteMetricsAsJson, metrics, _1, _2);
   bool not_on_nav_bar = false;
   bool is_on_nav_bar = true;
-  webserver->RegisterPathHandler("/metrics", "Metrics", callback, not_styled, is_on_nav_bar);
+  webserver->RegisterStreamingPathHandler("/metrics", "Metrics", callback, is_on_nav_bar);
 
   // The old name -- this is preserved for compatibility with older releases of
   // monitoring software which expects the old name.
-  webserver->RegisterPathHandler("/jsonmetricz", "Metrics", callback, not_styled, not_on_nav_bar);
+  webserver->RegisterStreamingPathHandler("/jsonmetricz", "Metrics", callback, not_on_nav_bar);
+
+  webserver->RegisterStreamingPathHandler(
+      "/metrics_prometheus", "Metrics (Prometheus)",
+      boost::bind(WriteMetricsAsPrometheus, metrics, _1, _2), not_on_nav_bar);
 }
 
 } // namespace kudu
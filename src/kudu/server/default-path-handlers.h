@@ -29,7 +29,8 @@ class Webserver;
 // logs and configuration flags.
 void AddDefaultPathHandlers(Webserver* webserver);
 
-// Adds an endpoint to get metrics in JSON format.
+// Adds endpoints to get metrics in JSON and Prometheus formats. The metrics
+// are streamed to the client as they are written.
 void RegisterMetricsJsonHandler(Webserver* webserver, const MetricRegistry* const metrics);
 
 } // namespace kudu
@@ -15,6 +15,7 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <boost/bind.hpp>
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
 #include <string>
@@ -160,4 +161,24 @@ TEST_F(WebserverTest, TestStaticFiles) {
   ASSERT_EQ("Remote error: HTTP 403", s.ToString());
 }
 
+static void StreamLines(int num_lines, const Webserver::WebRequest& req, std::ostream* output) {
+  for (int i = 0; i < num_lines; i++) {
+    *output << StringPrintf("line %08d\n", i);
+  }
+}
+
+// Test a page which is larger than the chunks it is streamed in.
+TEST_F(WebserverTest, TestStreamingPathHandler) {
+  const int kNumLines = 100000;
+  server_->RegisterStreamingPathHandler("/stream", "Stream",
+                                        boost::bind(StreamLines, kNumLines, _1, _2),
+                                        false /* is_on_nav_bar */);
+  ASSERT_OK(curl_.FetchURL(strings::Substitute("http://$0/stream", addr_.ToString()),
+                           &buf_));
+  ASSERT_EQ(kNumLines * strlen("line 00000000\n"), buf_.size());
+  ASSERT_TRUE(HasPrefixString(buf_.ToString(), "line 00000000\nline 00000001\n"));
+  ASSERT_TRUE(HasSuffixString(buf_.ToString(),
+                              StringPrintf("line %08d\n", kNumLines - 1)));
+}
+
 } // namespace kudu
@@ -19,8 +19,11 @@
 #include <algorithm>
 #include <stdio.h>
 #include <signal.h>
-#include <string>
+#include <string.h>
 #include <map>
+#include <ostream>
+#include <streambuf>
+#include <string>
 #include <vector>
 #include <boost/lexical_cast.hpp>
 #include <boost/bind.hpp>
@@ -30,6 +33,7 @@
 #include <glog/logging.h>
 #include <squeasel.h>
 
+#include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/stringprintf.h"
@@ -47,6 +51,7 @@
 typedef sig_t sighandler_t;
 #endif
 
+using std::ostream;
 using std::string;
 using std::stringstream;
 using std::vector;
@@ -60,6 +65,72 @@ TAG_FLAG(webserver_max_post_length_bytes, runtime);
 
 namespace kudu {
 
+namespace {
+
+// A stream buffer which sends what is written to it to a connection, using
+// the chunked transfer encoding of HTTP/1.1 so that the length of the page
+// needn't be known in advance. Only up to 'kChunkSize' bytes of the page are
+// buffered at any time.
+class ChunkedOutputBuffer : public std::streambuf {
+ public:
+  explicit ChunkedOutputBuffer(struct sq_connection* connection)
+    : connection_(connection),
+      buf_(kChunkSize),
+      failed_(false) {
+    setp(&buf_[0], &buf_[0] + buf_.size());
+  }
+
+  // Send the buffered output and the final empty chunk.
+  void Finish() {
+    if (SendChunk()) {
+      sq_write(connection_, "0\r\n\r\n", 5);
+    }
+  }
+
+ protected:
+  virtual int overflow(int c) OVERRIDE {
+    if (!SendChunk()) {
+      return traits_type::eof();
+    }
+    if (c != traits_type::eof()) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  virtual int sync() OVERRIDE {
+    return SendChunk() ? 0 : -1;
+  }
+
+ private:
+  static const size_t kChunkSize = 64 * 1024;
+
+  // Send the buffered output as a chunk, and reset the buffer. Once writing
+  // to the connection failed (e.g. the client went away), the output is
+  // discarded.
+  bool SendChunk() {
+    int len = pptr() - pbase();
+    if (len > 0 && !failed_) {
+      string header = StringPrintf("%x\r\n", len);
+      int header_len = header.size();
+      failed_ = sq_write(connection_, header.data(), header_len) != header_len ||
+                sq_write(connection_, pbase(), len) != len ||
+                sq_write(connection_, "\r\n", 2) != 2;
+    }
+    setp(&buf_[0], &buf_[0] + buf_.size());
+    return !failed_;
+  }
+
+  struct sq_connection* const connection_;
+  vector<char> buf_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChunkedOutputBuffer);
+};
+
+} // anonymous namespace
+
 Webserver::Webserver(const WebserverOptions& opts)
   : opts_(opts),
     context_(nullptr) {
@@ -333,6 +404,11 @@ int Webserver::RunPathHandler(const PathHandler& handler,
     }
   }
 
+  if (!handler.streaming_callback().empty()) {
+    RunStreamingPathHandler(handler, req, connection, request_info);
+    return 1;
+  }
+
   if (!handler.is_styled() || ContainsKey(req.parsed_args, "raw")) {
     use_style = false;
   }
@@ -363,6 +439,35 @@ int Webserver::RunPathHandler(const PathHandler& handler,
   return 1;
 }
 
+void Webserver::RunStreamingPathHandler(const PathHandler& handler,
+                                        const WebRequest& req,
+                                        struct sq_connection* connection,
+                                        struct sq_request_info* request_info) {
+  // Chunked transfers are only understood by HTTP/1.1 clients. Others get the
+  // page buffered, like any other.
+  if (request_info->http_version == nullptr ||
+      strcmp(request_info->http_version, "1.1") != 0) {
+    stringstream output;
+    handler.streaming_callback()(req, &output);
+    string str = output.str();
+    sq_printf(connection, "HTTP/1.1 200 OK\r\n"
+              "Content-Type: text/plain\r\n"
+              "Content-Length: %zd\r\n"
+              "\r\n", str.length());
+    sq_write(connection, str.c_str(), str.length());
+    return;
+  }
+
+  sq_printf(connection, "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/plain\r\n"
+            "Transfer-Encoding: chunked\r\n"
+            "\r\n");
+  ChunkedOutputBuffer buf(connection);
+  ostream output(&buf);
+  handler.streaming_callback()(req, &output);
+  buf.Finish();
+}
+
 void Webserver::RegisterPathHandler(const string& path, const string& alias,
     const PathHandlerCallback& callback, bool is_styled, bool is_on_nav_bar) {
   boost::lock_guard<boost::shared_mutex> lock(lock_);
@@ -371,9 +476,22 @@ void Webserver::RegisterPathHandler(const string& path, const string& alias,
     it = path_handlers_.insert(
         make_pair(path, new PathHandler(is_styled, is_on_nav_bar, alias))).first;
   }
+  CHECK(it->second->streaming_callback().empty())
+      << "Path " << path << " already has a streaming handler";
   it->second->AddCallback(callback);
 }
 
+void Webserver::RegisterStreamingPathHandler(const string& path, const string& alias,
+    const StreamingPathHandlerCallback& callback, bool is_on_nav_bar) {
+  boost::lock_guard<boost::shared_mutex> lock(lock_);
+  bool is_styled = false;
+  gscoped_ptr<PathHandler> handler(new PathHandler(is_styled, is_on_nav_bar, alias));
+  handler->set_streaming_callback(callback);
+  CHECK(InsertIfNotPresent(&path_handlers_, path, handler.get()))
+      << "Path " << path << " already has a handler";
+  ignore_result(handler.release());
+}
+
 const char* const PAGE_HEADER = "<!DOCTYPE html>"
 " <html>"
 "   <head><title>Kudu</title>"
@@ -59,6 +59,10 @@ class Webserver : public WebCallbackRegistry {
                                    const PathHandlerCallback& callback,
                                    bool is_styled = true, bool is_on_nav_bar = true) OVERRIDE;
 
+  virtual void RegisterStreamingPathHandler(const std::string& path, const std::string& alias,
+                                            const StreamingPathHandlerCallback& callback,
+                                            bool is_on_nav_bar) OVERRIDE;
+
   // Change the footer HTML to be displayed at the bottom of all styled web pages.
   void set_footer_html(const std::string& html);
 
@@ -77,10 +81,17 @@ class Webserver : public WebCallbackRegistry {
       callbacks_.push_back(callback);
     }
 
+    void set_streaming_callback(const StreamingPathHandlerCallback& callback) {
+      streaming_callback_ = callback;
+    }
+
     bool is_styled() const { return is_styled_; }
     bool is_on_nav_bar() const { return is_on_nav_bar_; }
     const std::string& alias() const { return alias_; }
     const std::vector<PathHandlerCallback>& callbacks() const { return callbacks_; }
+    const StreamingPathHandlerCallback& streaming_callback() const {
+      return streaming_callback_;
+    }
 
    private:
     // If true, the page appears is rendered styled.
@@ -94,6 +105,9 @@ class Webserver : public WebCallbackRegistry {
 
     // List of callbacks to render output for this page, called in order.
     std::vector<PathHandlerCallback> callbacks_;
+
+    // If set, the only callback, whose output is sent as it is written.
+    StreamingPathHandlerCallback streaming_callback_;
   };
 
   bool static_pages_available() const;
@@ -118,6 +132,13 @@ class Webserver : public WebCallbackRegistry {
                      struct sq_connection* connection,
                      struct sq_request_info* request_info);
 
+  // Run the streaming callback of 'handler', sending its output to the client
+  // in chunks as it is written.
+  void RunStreamingPathHandler(const PathHandler& handler,
+                               const WebRequest& req,
+                               struct sq_connection* connection,
+                               struct sq_request_info* request_info);
+
   // Callback to funnel mongoose logs through glog.
   static int LogMessageCallbackStatic(const struct sq_connection* connection,
                                       const char* message);
@@ -23,9 +23,12 @@
 #include "kudu/tablet/cfile_set.h"
 #include "kudu/tablet/diskrowset-test-base.h"
 #include "kudu/tablet/tablet-test-base.h"
+#include "kudu/util/mem_tracker.h"
+#include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/test_util.h"
 
 DECLARE_int32(cfile_default_block_size);
+DECLARE_int64(sparse_key_index_memory_budget_mb);
 
 using std::shared_ptr;
 
@@ -282,6 +285,81 @@ TEST_F(TestCFileSet, TestRangeScan) {
   EXPECT_EQ(stats[2].data_blocks_read_from_disk, 1);
 }
 
+// Test point lookups of keys, which go through the sparse in-memory key index
+// and the pool of key iterators.
+TEST_F(TestCFileSet, TestFindRow) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset(new CFileSet(rowset_meta_));
+  ASSERT_OK(fileset->Open());
+
+  Schema key_schema = schema_.CreateKeyProjection();
+  RowBuilder rb(key_schema);
+  ProbeStats stats;
+  // Probe every possible key in the range, plus a few past either end.
+  // Only the even keys are present, at ordinal key / 2.
+  for (uint32_t key = 0; key < kNumRows * 2 + 10; key++) {
+    rb.Reset();
+    rb.AddUint32(key);
+    RowSetKeyProbe probe(rb.row());
+    bool present;
+    rowid_t idx;
+    ASSERT_OK(fileset->CheckRowPresent(probe, &present, &idx, &stats));
+    bool expected = key % 2 == 0 && key < kNumRows * 2;
+    ASSERT_EQ(expected, present) << key;
+    if (present) {
+      ASSERT_EQ(key / 2, idx);
+    }
+  }
+
+  // The rowset has many data blocks, so the sparse index should have one
+  // entry per block.
+  ASSERT_GT(fileset->sparse_key_index_.block_ptrs.size(), 1);
+  ASSERT_LE(fileset->key_iter_pool_.size(), 1);
+}
+
+// Test point lookups of keys in a rowset whose sparse key index doesn't fit
+// in the memory budget, which seek through the on-disk key index instead.
+TEST_F(TestCFileSet, TestFindRowWithoutSparseKeyIndex) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  // Use up whatever is left of the budget.
+  shared_ptr<MemTracker> tracker = MemTracker::FindOrCreateTracker(
+      FLAGS_sparse_key_index_memory_budget_mb * 1024 * 1024, "sparse_key_index");
+  int64_t remaining = tracker->limit() - tracker->consumption();
+  tracker->Consume(remaining);
+  auto release_budget = MakeScopedCleanup([&]() {
+      tracker->Release(remaining);
+    });
+
+  shared_ptr<CFileSet> fileset(new CFileSet(rowset_meta_));
+  ASSERT_OK(fileset->Open());
+
+  Schema key_schema = schema_.CreateKeyProjection();
+  RowBuilder rb(key_schema);
+  ProbeStats stats;
+  for (uint32_t key = 0; key < kNumRows * 2 + 10; key++) {
+    rb.Reset();
+    rb.AddUint32(key);
+    RowSetKeyProbe probe(rb.row());
+    bool present;
+    rowid_t idx;
+    ASSERT_OK(fileset->CheckRowPresent(probe, &present, &idx, &stats));
+    bool expected = key % 2 == 0 && key < kNumRows * 2;
+    ASSERT_EQ(expected, present) << key;
+    if (present) {
+      ASSERT_EQ(key / 2, idx);
+    }
+  }
+  ASSERT_TRUE(fileset->sparse_key_index_.block_ptrs.empty());
+
+  // The pooled iterator was reset, rather than left seeked to the last key.
+  ASSERT_EQ(1, fileset->key_iter_pool_.size());
+  ASSERT_FALSE(fileset->key_iter_pool_[0]->seeked());
+}
+
 // Several other black-box tests for range scans. These are similar to
 // TestRangeScan above, except don't inspect internal state.
 TEST_F(TestCFileSet, TestRangePredicates2) {
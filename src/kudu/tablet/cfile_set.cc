@@ -22,6 +22,7 @@
 #include "kudu/cfile/bloomfile.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/cfile_writer.h"
+#include "kudu/cfile/index_btree.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/gutil/dynamic_annotations.h"
 #include "kudu/gutil/map-util.h"
@@ -29,16 +30,30 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/diskrowset.h"
 #include "kudu/tablet/cfile_set.h"
+#include "kudu/util/coding.h"
 #include "kudu/util/flag_tags.h"
+#include "kudu/util/scoped_cleanup.h"
 
 DEFINE_bool(consult_bloom_filters, true, "Whether to consult bloom filters on row presence checks");
 TAG_FLAG(consult_bloom_filters, hidden);
 
+DEFINE_int64(sparse_key_index_memory_budget_mb, 256,
+             "Maximum amount of memory used across all rowsets for the in-memory "
+             "sparse indexes of rowset keys. Rowsets whose index doesn't fit in the "
+             "remaining budget probe the on-disk key index instead.");
+TAG_FLAG(sparse_key_index_memory_budget_mb, advanced);
+
+DEFINE_int32(max_pooled_key_iterators_per_rowset, 8,
+             "Maximum number of idle key iterators to keep per rowset for reuse by "
+             "row presence checks.");
+TAG_FLAG(max_pooled_key_iterators_per_rowset, advanced);
+
 namespace kudu {
 namespace tablet {
 
-using cfile::ReaderOptions;
 using cfile::DefaultColumnValueIterator;
+using cfile::IndexTreeIterator;
+using cfile::ReaderOptions;
 using fs::ReadableBlock;
 using std::shared_ptr;
 using strings::Substitute;
@@ -64,10 +79,20 @@ static Status OpenReader(const shared_ptr<RowSetMetadata>& rowset_metadata,
 // CFile Base
 ////////////////////////////////////////////////////////////
 
+static shared_ptr<MemTracker> GetSparseKeyIndexTracker() {
+  return MemTracker::FindOrCreateTracker(FLAGS_sparse_key_index_memory_budget_mb * 1024 * 1024,
+                                         "sparse_key_index");
+}
+
 CFileSet::CFileSet(shared_ptr<RowSetMetadata> rowset_metadata)
-    : rowset_metadata_(std::move(rowset_metadata)) {}
+    : rowset_metadata_(std::move(rowset_metadata)),
+      sparse_key_index_consumption_(0) {}
 
 CFileSet::~CFileSet() {
+  if (sparse_key_index_consumption_ > 0) {
+    sparse_key_index_tracker_->Release(sparse_key_index_consumption_);
+  }
+  STLDeleteElements(&key_iter_pool_);
 }
 
 
@@ -194,6 +219,25 @@ uint64_t CFileSet::EstimateOnDiskSize() const {
   return ret;
 }
 
+Status CFileSet::GetMaxTimestamp(ColumnId col_id, int64_t* max_value) const {
+  const shared_ptr<CFileReader>* reader = FindOrNull(readers_by_col_id_, col_id);
+  if (reader == nullptr) {
+    return Status::NotFound(Substitute("no data for column $0", col_id));
+  }
+  // Fully open the reader if it was lazily opened earlier.
+  RETURN_NOT_OK((*reader)->Init());
+  string value;
+  if (!(*reader)->GetMetadataEntry(cfile::kMaxTimestampMetadataKey, &value)) {
+    return Status::NotFound("no max timestamp recorded", (*reader)->ToString());
+  }
+  if (value.size() != sizeof(uint64_t)) {
+    return Status::Corruption("bad max timestamp entry", (*reader)->ToString());
+  }
+  *max_value = static_cast<int64_t>(DecodeFixed64(reinterpret_cast<const uint8_t*>(
+      value.data())));
+  return Status::OK();
+}
+
 Status CFileSet::FindRow(const RowSetKeyProbe &probe, rowid_t *idx,
                          ProbeStats* stats) const {
   if (bloom_reader_ != nullptr && FLAGS_consult_bloom_filters) {
@@ -216,13 +260,25 @@ Status CFileSet::FindRow(const RowSetKeyProbe &probe, rowid_t *idx,
   }
 
   stats->keys_consulted++;
-  CFileIterator *key_iter = nullptr;
-  RETURN_NOT_OK(NewKeyIterator(&key_iter));
+  RETURN_NOT_OK(sparse_key_index_once_.Init(&CFileSet::LoadSparseKeyIndex,
+                                            const_cast<CFileSet*>(this)));
 
-  gscoped_ptr<CFileIterator> key_iter_scoped(key_iter); // free on return
+  gscoped_ptr<CFileIterator> key_iter;
+  RETURN_NOT_OK(GetPooledKeyIterator(&key_iter));
+  auto release_iter = MakeScopedCleanup([&]() {
+      ReleasePooledKeyIterator(std::move(key_iter));
+    });
 
   bool exact;
-  RETURN_NOT_OK(key_iter->SeekAtOrAfter(probe.encoded_key(), &exact));
+  if (!sparse_key_index_.block_ptrs.empty()) {
+    BlockPointer block_ptr;
+    if (!FindBlockInSparseKeyIndex(probe.encoded_key().encoded_key(), &block_ptr)) {
+      return Status::NotFound("not present in storefile (before first key)");
+    }
+    RETURN_NOT_OK(key_iter->SeekAtOrAfterInBlock(block_ptr, probe.encoded_key(), &exact));
+  } else {
+    RETURN_NOT_OK(key_iter->SeekAtOrAfter(probe.encoded_key(), &exact));
+  }
   if (!exact) {
     return Status::NotFound("not present in storefile (failed seek)");
   }
@@ -231,6 +287,92 @@ Status CFileSet::FindRow(const RowSetKeyProbe &probe, rowid_t *idx,
   return Status::OK();
 }
 
+bool CFileSet::FindBlockInSparseKeyIndex(const Slice& encoded_key,
+                                         BlockPointer* block_ptr) const {
+  const SparseKeyIndex& idx = sparse_key_index_;
+  int n = idx.key_offsets.size();
+  auto key_at = [&](int i) {
+    uint32_t end = i + 1 < n ? idx.key_offsets[i + 1] : idx.keys.size();
+    return Slice(&idx.keys[idx.key_offsets[i]], end - idx.key_offsets[i]);
+  };
+
+  // Find the last block whose first key is <= 'encoded_key'.
+  int lo = 0;
+  int hi = n;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (key_at(mid).compare(encoded_key) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == 0) {
+    return false;
+  }
+  *block_ptr = idx.block_ptrs[lo - 1];
+  return true;
+}
+
+Status CFileSet::LoadSparseKeyIndex() {
+  CFileReader* reader = key_index_reader();
+  RETURN_NOT_OK(reader->Init());
+  if (!reader->has_validx()) {
+    return Status::OK();
+  }
+
+  SparseKeyIndex idx;
+  gscoped_ptr<IndexTreeIterator> iter(IndexTreeIterator::Create(reader, reader->validx_root()));
+  RETURN_NOT_OK(iter->SeekToFirst());
+  while (true) {
+    Slice key = iter->GetCurrentKey();
+    idx.key_offsets.push_back(idx.keys.size());
+    idx.keys.append(reinterpret_cast<const char*>(key.data()), key.size());
+    idx.block_ptrs.push_back(iter->GetCurrentBlockPointer());
+    if (!iter->HasNext()) break;
+    RETURN_NOT_OK(iter->Next());
+  }
+
+  int64_t consumption = idx.keys.capacity() +
+      idx.key_offsets.capacity() * sizeof(uint32_t) +
+      idx.block_ptrs.capacity() * sizeof(BlockPointer);
+  shared_ptr<MemTracker> tracker = GetSparseKeyIndexTracker();
+  if (!tracker->TryConsume(consumption)) {
+    VLOG(1) << "Not enough memory budget to keep the sparse key index of "
+            << rowset_metadata_->ToString() << " (" << consumption << " bytes)";
+    return Status::OK();
+  }
+  sparse_key_index_ = std::move(idx);
+  sparse_key_index_tracker_ = std::move(tracker);
+  sparse_key_index_consumption_ = consumption;
+  return Status::OK();
+}
+
+Status CFileSet::GetPooledKeyIterator(gscoped_ptr<CFileIterator>* iter) const {
+  {
+    lock_guard<simple_spinlock> l(&key_iter_pool_lock_);
+    if (!key_iter_pool_.empty()) {
+      iter->reset(key_iter_pool_.back());
+      key_iter_pool_.pop_back();
+      return Status::OK();
+    }
+  }
+  CFileIterator* key_iter = nullptr;
+  RETURN_NOT_OK(NewKeyIterator(&key_iter));
+  iter->reset(key_iter);
+  return Status::OK();
+}
+
+void CFileSet::ReleasePooledKeyIterator(gscoped_ptr<CFileIterator> iter) const {
+  // An idle iterator must not keep the blocks of its last seek pinned in the
+  // block cache.
+  iter->ReleaseBlocks();
+  lock_guard<simple_spinlock> l(&key_iter_pool_lock_);
+  if (static_cast<int>(key_iter_pool_.size()) < FLAGS_max_pooled_key_iterators_per_rowset) {
+    key_iter_pool_.push_back(iter.release());
+  }
+}
+
 Status CFileSet::CheckRowPresent(const RowSetKeyProbe &probe, bool *present,
                                  rowid_t *rowid, ProbeStats* stats) const {
 
@@ -381,6 +523,17 @@ Status CFileSet::Iterator::PushdownRangeScanPredicate(ScanSpec *spec) {
   return Status::OK();
 }
 
+void CFileSet::Iterator::SetOrdinalRange(rowid_t lower_bound_idx,
+                                         rowid_t upper_bound_idx) {
+  DCHECK(initted_);
+  DCHECK_EQ(prepared_count_, 0) << "Already prepared";
+  DCHECK_LE(lower_bound_idx, upper_bound_idx);
+  DCHECK_LE(upper_bound_idx, row_count_);
+  lower_bound_idx_ = lower_bound_idx;
+  upper_bound_idx_ = upper_bound_idx;
+  cur_idx_ = lower_bound_idx_;
+}
+
 void CFileSet::Iterator::Unprepare() {
   prepared_count_ = 0;
   cols_prepared_.assign(col_iters_.size(), false);
@@ -23,6 +23,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "kudu/cfile/block_pointer.h"
 #include "kudu/cfile/bloomfile.h"
 #include "kudu/cfile/cfile_reader.h"
 
@@ -33,7 +34,10 @@
 #include "kudu/tablet/memrowset.h"
 #include "kudu/tablet/rowset_metadata.h"
 #include "kudu/util/env.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/mem_tracker.h"
 #include "kudu/util/memory/arena.h"
+#include "kudu/util/once.h"
 #include "kudu/util/slice.h"
 
 namespace kudu {
@@ -44,6 +48,7 @@ class RowSetMetadata;
 
 namespace tablet {
 
+using kudu::cfile::BlockPointer;
 using kudu::cfile::BloomFileReader;
 using kudu::cfile::CFileIterator;
 using kudu::cfile::CFileReader;
@@ -90,11 +95,19 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
     return ContainsKey(readers_by_col_id_, col_id);
   }
 
+  // Sets 'max_value' to the largest value of the given non-nullable
+  // TIMESTAMP column, as recorded in its CFile's footer. Returns NotFound if
+  // there is no CFile for the column, or if it doesn't record its largest
+  // value, e.g. because it's empty or was written by an older version.
+  Status GetMaxTimestamp(ColumnId col_id, int64_t* max_value) const;
+
   virtual ~CFileSet();
 
  private:
   friend class Iterator;
   friend class CFileSetIteratorProjector;
+  FRIEND_TEST(TestCFileSet, TestFindRow);
+  FRIEND_TEST(TestCFileSet, TestFindRowWithoutSparseKeyIndex);
 
   DISALLOW_COPY_AND_ASSIGN(CFileSet);
 
@@ -106,6 +119,21 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
                            CFileIterator **iter) const;
   Status NewKeyIterator(CFileIterator **iter) const;
 
+  // Take a key iterator from the pool for a point lookup, creating a new one
+  // if the pool is empty. The iterator should be returned with
+  // ReleasePooledKeyIterator() once the lookup is finished.
+  Status GetPooledKeyIterator(gscoped_ptr<CFileIterator>* iter) const;
+  void ReleasePooledKeyIterator(gscoped_ptr<CFileIterator> iter) const;
+
+  // Load the first key of each data block of the key index into
+  // sparse_key_index_, if it fits in the memory budget.
+  Status LoadSparseKeyIndex();
+
+  // Find the data block whose key range may contain 'encoded_key' using the
+  // sparse key index. Returns false if the key sorts before the first key in
+  // the rowset.
+  bool FindBlockInSparseKeyIndex(const Slice& encoded_key, BlockPointer* block_ptr) const;
+
   // Return the CFileReader responsible for reading the key index.
   // (the ad-hoc reader for composite keys, otherwise the key column reader)
   CFileReader* key_index_reader() const;
@@ -126,6 +154,29 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
   // index pertains to more than one column, as in the case of composite keys.
   gscoped_ptr<CFileReader> ad_hoc_idx_reader_;
   gscoped_ptr<BloomFileReader> bloom_reader_;
+
+  // In-memory sparse index over the key index: the encoded first key of each
+  // data block, concatenated into 'keys', along with the pointer to each
+  // block. Probes binary-search this to go straight to the right data block
+  // instead of walking the on-disk index B-tree through the block cache.
+  //
+  // Loaded lazily by the first probe. Left empty if the key index has no
+  // value index or if the memory budget is exhausted, in which case probes
+  // fall back to seeking through the on-disk index.
+  struct SparseKeyIndex {
+    std::string keys;
+    std::vector<uint32_t> key_offsets;
+    std::vector<BlockPointer> block_ptrs;
+  };
+  SparseKeyIndex sparse_key_index_;
+  mutable KuduOnceDynamic sparse_key_index_once_;
+  std::shared_ptr<MemTracker> sparse_key_index_tracker_;
+  int64_t sparse_key_index_consumption_;
+
+  // Key iterators which are not currently in use, so that probes don't need
+  // to allocate a new iterator each time.
+  mutable simple_spinlock key_iter_pool_lock_;
+  mutable std::vector<CFileIterator*> key_iter_pool_;
 };
 
 
@@ -170,6 +221,11 @@ class CFileSet::Iterator : public ColumnwiseIterator {
   // Collect the IO statistics for each of the underlying columns.
   virtual void GetIteratorStats(vector<IteratorStats> *stats) const OVERRIDE;
 
+  // Restrict the iterator to the ordinal range [lower_bound_idx, upper_bound_idx).
+  // This may only be called after Init() and before the first batch is prepared.
+  // Used for point lookups, where the ordinal of the row is already known.
+  void SetOrdinalRange(rowid_t lower_bound_idx, rowid_t upper_bound_idx);
+
   virtual ~Iterator();
  private:
   DISALLOW_COPY_AND_ASSIGN(Iterator);
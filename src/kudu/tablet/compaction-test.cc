@@ -623,6 +623,79 @@ TEST_F(TestCompaction, TestOneToOne) {
   DoFlushAndReopen(compact_input.get(), schema_, snap3, kLargeRollThreshold, nullptr);
 }
 
+// Test that flushes don't carry UNDOs older than the ancient history mark.
+TEST_F(TestCompaction, TestAncientUndosAreNotFlushed) {
+  shared_ptr<MemRowSet> mrs(new MemRowSet(0, schema_, log_anchor_registry_.get()));
+  InsertRows(mrs.get(), 1000, 0);
+  UpdateRows(mrs.get(), 1000, 0, 1);
+  MvccSnapshot snap(mvcc_);
+
+  // The inserts happened at @1-@1000 and the updates at @1001-@2000. Only the
+  // UNDOs of the updates are newer than the mark.
+  RollingDiskRowSetWriter rsw(tablet()->metadata(), schema_,
+                              BloomFilterSizing::BySizeAndFPRate(32*1024, 0.01f),
+                              kLargeRollThreshold);
+  ASSERT_OK(rsw.Open());
+  gscoped_ptr<CompactionInput> input(CompactionInput::Create(*mrs, &schema_, snap));
+  ASSERT_OK(FlushCompactionInput(input.get(), snap, &rsw, Timestamp(1001)));
+  ASSERT_OK(rsw.Finish());
+
+  vector<shared_ptr<RowSetMetadata> > metas;
+  rsw.GetWrittenRowSetMetadata(&metas);
+  ASSERT_EQ(1, metas.size());
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(DiskRowSet::Open(metas[0], log_anchor_registry_.get(), &rs));
+
+  vector<string> out;
+  ASSERT_OK(CompactionInput::Create(*rs, &schema_, MvccSnapshot(mvcc_), &input));
+  IterateInput(input.get(), &out);
+  ASSERT_EQ(1000, out.size());
+  EXPECT_EQ("(string key=hello 00000000, int32 val=1, int32 nullable_val=1) "
+            "Undos: [@1001(SET val=0, nullable_val=0)] Redos: []", out[0]);
+  EXPECT_EQ("(string key=hello 00009990, int32 val=1, int32 nullable_val=1) "
+            "Undos: [@2000(SET val=999, nullable_val=NULL)] Redos: []", out[999]);
+}
+
+// Test that a DiskRowSet deletes its UNDO delta blocks once all of their
+// deltas are older than the ancient history mark.
+TEST_F(TestCompaction, TestDeleteAncientUndoDeltas) {
+  shared_ptr<MemRowSet> mrs(new MemRowSet(0, schema_, log_anchor_registry_.get()));
+  InsertRows(mrs.get(), 1000, 0);
+  UpdateRows(mrs.get(), 1000, 0, 1);
+  shared_ptr<DiskRowSet> rs;
+  FlushMRSAndReopenNoRoll(*mrs, schema_, &rs);
+  ASSERT_NO_FATAL_FAILURE();
+  ASSERT_EQ(1, rs->metadata()->undo_delta_blocks().size());
+
+  // The UNDO file hasn't been read yet, so it may be ancient.
+  ASSERT_GT(rs->EstimateBytesInPotentiallyAncientUndoDeltas(Timestamp(2000)), 0);
+
+  // The newest UNDO is @2000, so nothing is deleted at that mark.
+  int64_t blocks_deleted = 0;
+  int64_t bytes_deleted = 0;
+  ASSERT_OK(rs->DeleteAncientUndoDeltas(Timestamp(2000), &blocks_deleted, &bytes_deleted));
+  ASSERT_EQ(0, blocks_deleted);
+  ASSERT_EQ(0, bytes_deleted);
+  ASSERT_EQ(0, rs->EstimateBytesInPotentiallyAncientUndoDeltas(Timestamp(2000)));
+  int64_t ancient_bytes = rs->EstimateBytesInPotentiallyAncientUndoDeltas(Timestamp(2001));
+  ASSERT_GT(ancient_bytes, 0);
+
+  ASSERT_OK(rs->DeleteAncientUndoDeltas(Timestamp(2001), &blocks_deleted, &bytes_deleted));
+  ASSERT_EQ(1, blocks_deleted);
+  ASSERT_EQ(ancient_bytes, bytes_deleted);
+  ASSERT_TRUE(rs->metadata()->undo_delta_blocks().empty());
+  ASSERT_EQ(0, rs->EstimateBytesInPotentiallyAncientUndoDeltas(Timestamp(2001)));
+
+  // The current data is still readable, without any history.
+  vector<string> out;
+  gscoped_ptr<CompactionInput> input;
+  ASSERT_OK(CompactionInput::Create(*rs, &schema_, MvccSnapshot(mvcc_), &input));
+  IterateInput(input.get(), &out);
+  ASSERT_EQ(1000, out.size());
+  EXPECT_EQ("(string key=hello 00000000, int32 val=1, int32 nullable_val=1) "
+            "Undos: [] Redos: []", out[0]);
+}
+
 // Test merging two row sets and the second one has updates, KUDU-102
 // We re-create the conditions by providing two DRS that are both the input and the
 // output of a compaction, and trying to merge two MRS.
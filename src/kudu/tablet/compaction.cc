@@ -514,6 +514,46 @@ class MergeCompactionInput : public CompactionInput {
   Arena* prepared_block_arena_;
 };
 
+// Return a list of the UNDOs in 'undo_head' that are not older than
+// 'ancient_history_mark'. Such ancient UNDOs would only ever be applied by
+// snapshot reads before the mark, which the tablet no longer allows.
+//
+// The source list may be shared with the compaction input, so if anything
+// needs to be dropped the surviving mutations are copied into 'arena'
+// rather than relinked in place.
+Mutation* RemoveAncientUndos(Mutation* undo_head,
+                             Timestamp ancient_history_mark,
+                             Arena* arena,
+                             uint64_t* num_undos_gced) {
+  bool any_ancient = false;
+  for (const Mutation* m = undo_head; m != nullptr; m = m->next()) {
+    if (m->timestamp().CompareTo(ancient_history_mark) < 0) {
+      any_ancient = true;
+      break;
+    }
+  }
+  if (!any_ancient) {
+    return undo_head;
+  }
+
+  Mutation* new_head = nullptr;
+  Mutation* new_tail = nullptr;
+  for (const Mutation* m = undo_head; m != nullptr; m = m->next()) {
+    if (m->timestamp().CompareTo(ancient_history_mark) < 0) {
+      (*num_undos_gced)++;
+      continue;
+    }
+    Mutation* copy = Mutation::CreateInArena(arena, m->timestamp(), m->changelist());
+    if (new_tail == nullptr) {
+      new_head = copy;
+    } else {
+      new_tail->set_next(copy);
+    }
+    new_tail = copy;
+  }
+  return new_head;
+}
+
 } // anonymous namespace
 
 ////////////////////////////////////////////////////////////
@@ -592,6 +632,8 @@ void RowSetsInCompaction::DumpToLog() const {
 
 
 Status ApplyMutationsAndGenerateUndos(const MvccSnapshot& snap,
+                                      Timestamp ancient_history_mark,
+                                      const RowExpiry& row_expiry,
                                       const CompactionInputRow& src_row,
                                       const Schema* base_schema,
                                       Mutation** new_undo_head,
@@ -599,9 +641,8 @@ Status ApplyMutationsAndGenerateUndos(const MvccSnapshot& snap,
                                       Arena* arena,
                                       RowBlockRow* dst_row,
                                       bool* is_garbage_collected,
-                                      uint64_t* num_rows_history_truncated) {
-  // TODO actually perform garbage collection (KUDU-236).
-  // Right now we persist all mutations.
+                                      uint64_t* num_rows_history_truncated,
+                                      uint64_t* num_undos_gced) {
   *is_garbage_collected = false;
 
   const Schema* dst_schema = dst_row->schema();
@@ -727,6 +768,22 @@ Status ApplyMutationsAndGenerateUndos(const MvccSnapshot& snap,
     }
   }
 
+  // Don't carry history older than the retention window forward.
+  if (ancient_history_mark != Timestamp::kMin) {
+    undo_head = RemoveAncientUndos(undo_head, ancient_history_mark, arena, num_undos_gced);
+  }
+
+  // Drop the row altogether if it has expired, unless it was inserted or
+  // mutated within the retention window: until then, some snapshots may
+  // still see it.
+  if (row_expiry.col_idx != Schema::kColumnNotFound && !is_deleted &&
+      ancient_history_mark != Timestamp::kMin && undo_head == nullptr &&
+      *reinterpret_cast<const int64_t*>(dst_row->cell_ptr(row_expiry.col_idx)) <
+          row_expiry.cutoff_micros) {
+    *is_garbage_collected = true;
+    return Status::OK();
+  }
+
   *new_undo_head = undo_head;
   *new_redo_head = redo_head;
 
@@ -737,7 +794,10 @@ Status ApplyMutationsAndGenerateUndos(const MvccSnapshot& snap,
 
 Status FlushCompactionInput(CompactionInput* input,
                             const MvccSnapshot& snap,
-                            RollingDiskRowSetWriter* out) {
+                            RollingDiskRowSetWriter* out,
+                            Timestamp ancient_history_mark,
+                            const RowExpiry& row_expiry,
+                            vector<bool>* gced_rows) {
   RETURN_NOT_OK(input->Init());
   vector<CompactionInputRow> rows;
 
@@ -746,6 +806,8 @@ Status FlushCompactionInput(CompactionInput* input,
   RowBlock block(out->schema(), 100, nullptr);
 
   uint64_t num_rows_history_truncated = 0;
+  uint64_t num_undos_gced = 0;
+  uint64_t num_rows_expired = 0;
 
   while (input->HasMoreBlocks()) {
     RETURN_NOT_OK(input->PrepareBlock(&rows));
@@ -772,6 +834,8 @@ Status FlushCompactionInput(CompactionInput* input,
 
       bool is_garbage_collected;
       RETURN_NOT_OK(ApplyMutationsAndGenerateUndos(snap,
+                                                   ancient_history_mark,
+                                                   row_expiry,
                                                    input_row,
                                                    schema,
                                                    &new_undos_head,
@@ -779,20 +843,26 @@ Status FlushCompactionInput(CompactionInput* input,
                                                    input->PreparedBlockArena(),
                                                    &dst_row,
                                                    &is_garbage_collected,
-                                                   &num_rows_history_truncated));
+                                                   &num_rows_history_truncated,
+                                                   &num_undos_gced));
+      if (gced_rows != nullptr) {
+        gced_rows->push_back(is_garbage_collected);
+      }
 
       // Whether this row was garbage collected
       if (is_garbage_collected) {
         DVLOG(2) << "Garbage Collected!";
+        num_rows_expired++;
         // Don't flush the row.
         continue;
       }
 
       rowid_t index_in_current_drs_;
 
-      // We should always have UNDO deltas, until we implement delta GC. For now,
-      // this is a convenient assertion to catch bugs like KUDU-632.
-      CHECK(new_undos_head != nullptr) <<
+      // We should always have UNDO deltas unless the row's whole history
+      // is older than the retention window. This is a convenient assertion
+      // to catch bugs like KUDU-632.
+      CHECK(new_undos_head != nullptr || ancient_history_mark != Timestamp::kMin) <<
         "Writing an output row with no UNDOs: "
         "Input Row: " << dst_row.schema()->DebugRow(dst_row) <<
         " RowId: " << input_row.row.row_index() <<
@@ -828,6 +898,13 @@ Status FlushCompactionInput(CompactionInput* input,
     LOG(WARNING) << "Total " << num_rows_history_truncated
         << " rows lost some history due to REINSERT after DELETE";
   }
+  if (num_undos_gced > 0) {
+    VLOG(1) << "Dropped " << num_undos_gced << " UNDO mutations older than "
+            << ancient_history_mark.ToString();
+  }
+  if (num_rows_expired > 0) {
+    VLOG(1) << "Dropped " << num_rows_expired << " expired rows";
+  }
   return Status::OK();
 }
 
@@ -835,7 +912,8 @@ Status ReupdateMissedDeltas(const string &tablet_name,
                             CompactionInput *input,
                             const MvccSnapshot &snap_to_exclude,
                             const MvccSnapshot &snap_to_include,
-                            const RowSetVector &output_rowsets) {
+                            const RowSetVector &output_rowsets,
+                            const vector<bool>* gced_rows) {
   TRACE_EVENT0("tablet", "ReupdateMissedDeltas");
   RETURN_NOT_OK(input->Init());
 
@@ -870,11 +948,21 @@ Status ReupdateMissedDeltas(const string &tablet_name,
   RETURN_NOT_OK(key_projector.Init());
   faststring buf;
 
+  // 'row_idx' is the index of the row in the output, and 'input_row_idx' its
+  // index in the input, which also counts the rows that weren't written out.
   rowid_t row_idx = 0;
+  size_t input_row_idx = 0;
   while (input->HasMoreBlocks()) {
     RETURN_NOT_OK(input->PrepareBlock(&rows));
 
     for (const CompactionInputRow &row : rows) {
+      if (gced_rows != nullptr) {
+        DCHECK_LT(input_row_idx, gced_rows->size());
+        if (input_row_idx < gced_rows->size() && (*gced_rows)[input_row_idx++]) {
+          continue;
+        }
+      }
+
       DVLOG(2) << "Revisiting row: " << schema->DebugRow(row.row) <<
           " Redo Mutations: " << Mutation::StringifyMutationList(*schema, row.redo_head) <<
           " Undo Mutations: " << Mutation::StringifyMutationList(*schema, row.undo_head);
@@ -960,8 +1048,6 @@ Status ReupdateMissedDeltas(const string &tablet_name,
         }
       }
 
-      // TODO when garbage collection kicks in we need to take care that
-      // CGed rows do not increment this.
       row_idx++;
     }
 
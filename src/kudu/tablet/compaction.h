@@ -120,6 +120,19 @@ struct CompactionInputRow {
   const Mutation* undo_head;
 };
 
+// Identifies the rows which have expired according to the table's row TTL,
+// as of the ancient history mark.
+struct RowExpiry {
+  RowExpiry() : col_idx(Schema::kColumnNotFound), cutoff_micros(0) {}
+
+  // The index of the TTL column in the output schema, or kColumnNotFound if
+  // no rows expire.
+  int col_idx;
+
+  // Rows whose TTL column value is lower than this have expired.
+  int64_t cutoff_micros;
+};
+
 // Function shared by flushes, compactions and major delta compactions. Applies all the REDO
 // mutations from 'src_row' to the 'dst_row', and generates the related UNDO mutations. Some
 // handling depends on the nature of the operation being performed:
@@ -129,8 +142,17 @@ struct CompactionInputRow {
 //                            belonging to 'dst_row'. Those that don't belong to that schema are
 //                            ignored.
 //
-// Currently, 'is_garbage_collected' is always false (KUDU-236).
+// UNDOs older than 'ancient_history_mark' are dropped from the output and
+// counted in 'num_undos_gced'; pass Timestamp::kMin to retain all history.
+//
+// 'is_garbage_collected' is set if the row, once the REDOs are applied, has
+// expired according to 'row_expiry' and has no history left once the ancient
+// UNDOs are dropped, in which case it should not be written out. Deleted rows
+// are never garbage collected, and neither is any row if
+// 'ancient_history_mark' is Timestamp::kMin.
 Status ApplyMutationsAndGenerateUndos(const MvccSnapshot& snap,
+                                      Timestamp ancient_history_mark,
+                                      const RowExpiry& row_expiry,
                                       const CompactionInputRow& src_row,
                                       const Schema* base_schema,
                                       Mutation** new_undo_head,
@@ -138,17 +160,26 @@ Status ApplyMutationsAndGenerateUndos(const MvccSnapshot& snap,
                                       Arena* arena,
                                       RowBlockRow* dst_row,
                                       bool* is_garbage_collected,
-                                      uint64_t* num_rows_history_truncated);
+                                      uint64_t* num_rows_history_truncated,
+                                      uint64_t* num_undos_gced);
 
 
 // Iterate through this compaction input, flushing all rows to the given RollingDiskRowSetWriter.
 // The 'snap' argument should match the MvccSnapshot used to create the compaction input.
 //
+// UNDOs older than 'ancient_history_mark' are not written to the output, and
+// neither are the rows which have expired according to 'row_expiry'. If
+// 'gced_rows' is not NULL, an entry is appended to it for each input row,
+// set to true if the row was not written out.
+//
 // After return of this function, this CompactionInput object is "used up" and will
 // no longer be useful.
 Status FlushCompactionInput(CompactionInput *input,
                             const MvccSnapshot &snap,
-                            RollingDiskRowSetWriter *out);
+                            RollingDiskRowSetWriter *out,
+                            Timestamp ancient_history_mark = Timestamp::kMin,
+                            const RowExpiry& row_expiry = RowExpiry(),
+                            std::vector<bool>* gced_rows = nullptr);
 
 // Iterate through this compaction input, finding any mutations which came between
 // snap_to_exclude and snap_to_include (ie those transactions that were not yet
@@ -158,13 +189,17 @@ Status FlushCompactionInput(CompactionInput *input,
 // The output rowsets passed in must be non-overlapping and in ascending key order:
 // typically they are the resulting rowsets from a RollingDiskRowSetWriter.
 //
+// 'gced_rows', if not NULL, holds the rows which FlushCompactionInput() didn't
+// write out. Their mutations are not propagated.
+//
 // After return of this function, this CompactionInput object is "used up" and will
 // yield no further rows.
 Status ReupdateMissedDeltas(const string &tablet_name,
                             CompactionInput *input,
                             const MvccSnapshot &snap_to_exclude,
                             const MvccSnapshot &snap_to_include,
-                            const RowSetVector &output_rowsets);
+                            const RowSetVector &output_rowsets,
+                            const std::vector<bool>* gced_rows = nullptr);
 
 // Dump the given compaction input to 'lines' or LOG(INFO) if it is NULL.
 // This consumes all of the input in the compaction input.
@@ -58,12 +58,14 @@ const size_t kRowsPerBlock = 100; // Number of rows per block of columns
 // TODO: can you major-delta-compact a new column after an alter table in order
 // to materialize it? should write a test for this.
 MajorDeltaCompaction::MajorDeltaCompaction(
-    FsManager* fs_manager, const Schema& base_schema, CFileSet* base_data,
+    FsManager* fs_manager, const Schema& base_schema,
+    unique_ptr<Schema> partial_schema, CFileSet* base_data,
     unique_ptr<DeltaIterator> delta_iter,
     vector<shared_ptr<DeltaStore> > included_stores,
     const vector<ColumnId>& col_ids)
     : fs_manager_(fs_manager),
       base_schema_(base_schema),
+      partial_schema_(std::move(partial_schema)),
       column_ids_(col_ids),
       base_data_(base_data),
       included_stores_(std::move(included_stores)),
@@ -93,22 +95,23 @@ string MajorDeltaCompaction::ColumnNamesToString() const {
 Status MajorDeltaCompaction::FlushRowSetAndDeltas() {
   CHECK_EQ(state_, kInitialized);
 
-  shared_ptr<ColumnwiseIterator> old_base_data_cwise(base_data_->NewIterator(&partial_schema_));
+  shared_ptr<ColumnwiseIterator> old_base_data_cwise(
+      base_data_->NewIterator(partial_schema_.get()));
   gscoped_ptr<RowwiseIterator> old_base_data_rwise(new MaterializingIterator(old_base_data_cwise));
 
   ScanSpec spec;
   spec.set_cache_blocks(false);
   RETURN_NOT_OK_PREPEND(
       old_base_data_rwise->Init(&spec),
-      "Unable to open iterator for specified columns (" + partial_schema_.ToString() + ")");
+      "Unable to open iterator for specified columns (" + partial_schema_->ToString() + ")");
 
   RETURN_NOT_OK(delta_iter_->Init(&spec));
   RETURN_NOT_OK(delta_iter_->SeekToOrdinal(0));
 
   Arena arena(32 * 1024, 128 * 1024);
-  RowBlock block(partial_schema_, kRowsPerBlock, &arena);
+  RowBlock block(*partial_schema_, kRowsPerBlock, &arena);
 
-  DVLOG(1) << "Applying deltas and rewriting columns (" << partial_schema_.ToString() << ")";
+  DVLOG(1) << "Applying deltas and rewriting columns (" << partial_schema_->ToString() << ")";
   DeltaStats redo_stats;
   DeltaStats undo_stats;
   uint64_t num_rows_history_truncated = 0;
@@ -146,7 +149,14 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas() {
 
       bool is_garbage_collected;
 
+      // The UNDOs generated here are all newer than the base data's history,
+      // so we don't try to drop ancient ones; once they age out, the whole
+      // file is removed by the UNDO delta GC op. Expired rows aren't dropped
+      // either, since the rewritten columns must keep the base data's row IDs.
+      uint64_t num_undos_gced = 0;
       RETURN_NOT_OK(ApplyMutationsAndGenerateUndos(snap,
+                                                   Timestamp::kMin,
+                                                   RowExpiry(),
                                                    input_row,
                                                    &base_schema_,
                                                    &new_undos_head,
@@ -154,11 +164,12 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas() {
                                                    &arena,
                                                    &dst_row,
                                                    &is_garbage_collected,
-                                                   &num_rows_history_truncated));
+                                                   &num_rows_history_truncated,
+                                                   &num_undos_gced));
 
       VLOG(2) << "Output Row: " << dst_row.schema()->DebugRow(dst_row)
-        << " Undo Mutations: " << Mutation::StringifyMutationList(partial_schema_, new_undos_head)
-        << " Redo Mutations: " << Mutation::StringifyMutationList(partial_schema_, new_redos_head);
+        << " Undo Mutations: " << Mutation::StringifyMutationList(*partial_schema_, new_undos_head)
+        << " Redo Mutations: " << Mutation::StringifyMutationList(*partial_schema_, new_redos_head);
 
       // We only create a new undo delta file if we need to.
       if (new_undos_head != nullptr && !new_undo_delta_writer_) {
@@ -211,7 +222,7 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas() {
   }
 
   DVLOG(1) << "Applied all outstanding deltas for columns "
-           << partial_schema_.ToString()
+           << partial_schema_->ToString()
            << ", and flushed the resulting rowsets and a total of "
            << redo_delta_mutations_written_
            << " REDO delta mutations and "
@@ -225,7 +236,7 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas() {
 Status MajorDeltaCompaction::OpenBaseDataWriter() {
   CHECK(!base_data_writer_);
 
-  gscoped_ptr<MultiColumnWriter> w(new MultiColumnWriter(fs_manager_, &partial_schema_));
+  gscoped_ptr<MultiColumnWriter> w(new MultiColumnWriter(fs_manager_, partial_schema_.get()));
   RETURN_NOT_OK(w->Open());
   base_data_writer_.swap(w);
   return Status::OK();
@@ -253,7 +264,6 @@ Status MajorDeltaCompaction::Compact() {
   CHECK_EQ(state_, kInitialized);
 
   LOG(INFO) << "Starting major delta compaction for columns " << ColumnNamesToString();
-  RETURN_NOT_OK(base_schema_.CreateProjectionByIdsIgnoreMissing(column_ids_, &partial_schema_));
 
   for (const shared_ptr<DeltaStore>& ds : included_stores_) {
     LOG(INFO) << "Preparing to major compact delta file: " << ds->ToString();
@@ -48,12 +48,16 @@ class MajorDeltaCompaction {
   // Creates a new major delta compaction. The given 'base_data' should already
   // be open and must remain valid for the lifetime of this object.
   // 'delta_iter' must not be initialized.
-  // 'col_ids' determines which columns of 'base_schema' should be compacted.
+  // 'col_ids' determines which columns of 'base_schema' should be compacted,
+  // and 'partial_schema' must be the projection of 'base_schema' onto them.
+  // 'delta_iter' should use 'partial_schema' as its projection, so that it
+  // only collects the updates to the compacted columns where it can.
   //
   // TODO: is base_schema supposed to be the same as base_data->schema()? how about
   // in an ALTER scenario?
   MajorDeltaCompaction(
-      FsManager* fs_manager, const Schema& base_schema, CFileSet* base_data,
+      FsManager* fs_manager, const Schema& base_schema,
+      std::unique_ptr<Schema> partial_schema, CFileSet* base_data,
       std::unique_ptr<DeltaIterator> delta_iter,
       std::vector<std::shared_ptr<DeltaStore> > included_stores,
       const std::vector<ColumnId>& col_ids);
@@ -98,7 +102,7 @@ class MajorDeltaCompaction {
 
   // The computed partial schema which includes only the columns being
   // compacted.
-  Schema partial_schema_;
+  const std::unique_ptr<Schema> partial_schema_;
 
   // The column ids to compact.
   const std::vector<ColumnId> column_ids_;
@@ -33,7 +33,8 @@ namespace tablet {
 DeltaStats::DeltaStats()
     : delete_count_(0),
       max_timestamp_(Timestamp::kMin),
-      min_timestamp_(Timestamp::kMax) {
+      min_timestamp_(Timestamp::kMax),
+      columnar_layout_(false) {
 }
 
 void DeltaStats::IncrUpdateCount(ColumnId col_id, int64_t update_count) {
@@ -81,6 +82,9 @@ string DeltaStats::ToString() const {
                                        update_counts_by_col_id_.end(),
                                        ":", ","));
   ret.append(")");
+  if (columnar_layout_) {
+    ret.append(", columnar layout");
+  }
   return ret;
 }
 
@@ -97,6 +101,9 @@ void DeltaStats::ToPB(DeltaStatsPB* pb) const {
 
   pb->set_max_timestamp(max_timestamp_.ToUint64());
   pb->set_min_timestamp(min_timestamp_.ToUint64());
+  if (columnar_layout_) {
+    pb->set_layout(DeltaStatsPB::COLUMNAR_LAYOUT);
+  }
 }
 
 Status DeltaStats::InitFromPB(const DeltaStatsPB& pb) {
@@ -107,6 +114,7 @@ Status DeltaStats::InitFromPB(const DeltaStatsPB& pb) {
   }
   RETURN_NOT_OK(max_timestamp_.FromUint64(pb.max_timestamp()));
   RETURN_NOT_OK(min_timestamp_.FromUint64(pb.min_timestamp()));
+  columnar_layout_ = pb.layout() == DeltaStatsPB::COLUMNAR_LAYOUT;
   return Status::OK();
 }
 
@@ -80,6 +80,16 @@ class DeltaStats {
     min_timestamp_ = timestamp;
   }
 
+  // Returns true if the deltas of the delta file are grouped by column
+  // within each block. See DeltaFileWriter.
+  bool columnar_layout() const {
+    return columnar_layout_;
+  }
+
+  void set_columnar_layout(bool columnar_layout) {
+    columnar_layout_ = columnar_layout;
+  }
+
   std::string ToString() const;
 
   // Convert this object to the protobuf which is stored in the DeltaFile footer.
@@ -97,6 +107,7 @@ class DeltaStats {
   uint64_t delete_count_;
   Timestamp max_timestamp_;
   Timestamp min_timestamp_;
+  bool columnar_layout_;
 };
 
 
@@ -17,6 +17,7 @@
 
 #include "kudu/tablet/delta_tracker.h"
 
+#include <algorithm>
 #include <set>
 
 #include "kudu/gutil/strings/join.h"
@@ -189,6 +190,80 @@ Status DeltaTracker::AtomicUpdateStores(const SharedDeltaStoreVector& to_remove,
   return Status::OK();
 }
 
+int64_t DeltaTracker::EstimateBytesInPotentiallyAncientUndoDeltas(
+    Timestamp ancient_history_mark) const {
+  shared_lock<rw_spinlock> lock(&component_lock_);
+  int64_t bytes = 0;
+  for (const shared_ptr<DeltaStore>& ds : undo_delta_stores_) {
+    if (ds->Initted() &&
+        ds->delta_stats().max_timestamp().CompareTo(ancient_history_mark) >= 0) {
+      continue;
+    }
+    bytes += ds->EstimateSize();
+  }
+  return bytes;
+}
+
+Status DeltaTracker::DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
+                                             int64_t* blocks_deleted,
+                                             int64_t* bytes_deleted) {
+  // Prevent a concurrent flush or compaction from swapping stores under us.
+  lock_guard<Mutex> l(&compact_flush_lock_);
+  CHECK(open_);
+
+  SharedDeltaStoreVector undos;
+  {
+    shared_lock<rw_spinlock> lock(&component_lock_);
+    undos = undo_delta_stores_;
+  }
+
+  SharedDeltaStoreVector ancient_stores;
+  vector<BlockId> ancient_blocks;
+  int64_t ancient_bytes = 0;
+  for (const shared_ptr<DeltaStore>& ds : undos) {
+    // The stats of lazily opened stores are only available after Init().
+    RETURN_NOT_OK_PREPEND(ds->Init(), "Unable to initialize UNDO delta store");
+    if (ds->delta_stats().max_timestamp().CompareTo(ancient_history_mark) >= 0) {
+      continue;
+    }
+    ancient_stores.push_back(ds);
+    ancient_blocks.push_back(down_cast<DeltaFileReader*>(ds.get())->block_id());
+    ancient_bytes += ds->EstimateSize();
+  }
+
+  if (ancient_stores.empty()) {
+    return Status::OK();
+  }
+
+  {
+    lock_guard<rw_spinlock> lock(&component_lock_);
+    for (const shared_ptr<DeltaStore>& ds : ancient_stores) {
+      auto it = std::find(undo_delta_stores_.begin(), undo_delta_stores_.end(), ds);
+      CHECK(it != undo_delta_stores_.end())
+          << "Another thread modified the UNDO store list during GC";
+      undo_delta_stores_.erase(it);
+    }
+  }
+
+  RowSetMetadataUpdate update;
+  update.RemoveUndoDeltaBlocks(ancient_blocks);
+  // As in CompactStores(), the stores have already been swapped out, so a
+  // failure to persist the metadata here would leave us inconsistent.
+  CHECK_OK(rowset_metadata_->CommitUpdate(update));
+  Status s = rowset_metadata_->Flush();
+  if (!s.ok()) {
+    LOG(FATAL) << "Unable to commit removal of ancient UNDO delta blocks "
+               << BlockId::JoinStrings(ancient_blocks) << ": " << s.ToString();
+    return s;
+  }
+
+  VLOG(1) << "Deleted ancient UNDO delta blocks " << BlockId::JoinStrings(ancient_blocks)
+          << " older than " << ancient_history_mark.ToString();
+  *blocks_deleted += ancient_blocks.size();
+  *bytes_deleted += ancient_bytes;
+  return Status::OK();
+}
+
 Status DeltaTracker::Compact() {
   return CompactStores(0, -1);
 }
@@ -513,5 +588,41 @@ void DeltaTracker::GetColumnIdsWithUpdates(std::vector<ColumnId>* col_ids) const
   col_ids->assign(column_ids_with_updates.begin(), column_ids_with_updates.end());
 }
 
+bool DeltaTracker::MayHaveUpdatesToColumn(ColumnId col_id) const {
+  if (!DeltaMemStoreEmpty()) {
+    return true;
+  }
+  shared_lock<rw_spinlock> lock(&component_lock_);
+  for (const shared_ptr<DeltaStore>& ds : redo_delta_stores_) {
+    // As above, don't force open files just to read their stats.
+    if (!ds->Initted() || ds->delta_stats().update_count_for_col_id(col_id) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Status DeltaTracker::CheckAllDeltasOlderThan(Timestamp timestamp, bool* all_older) const {
+  *all_older = false;
+  if (!DeltaMemStoreEmpty()) {
+    return Status::OK();
+  }
+  SharedDeltaStoreVector stores;
+  {
+    shared_lock<rw_spinlock> lock(&component_lock_);
+    stores = undo_delta_stores_;
+    stores.insert(stores.end(), redo_delta_stores_.begin(), redo_delta_stores_.end());
+  }
+  for (const shared_ptr<DeltaStore>& ds : stores) {
+    // As in DeleteAncientUndoDeltas(), the stats are only available after Init().
+    RETURN_NOT_OK_PREPEND(ds->Init(), "Unable to initialize delta store");
+    if (ds->delta_stats().max_timestamp().CompareTo(timestamp) >= 0) {
+      return Status::OK();
+    }
+  }
+  *all_older = true;
+  return Status::OK();
+}
+
 } // namespace tablet
 } // namespace kudu
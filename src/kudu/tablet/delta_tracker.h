@@ -159,6 +159,22 @@ class DeltaTracker {
                             const std::vector<BlockId>& new_delta_blocks,
                             DeltaType type);
 
+  // Estimate the number of bytes in UNDO delta stores which may only hold
+  // history older than 'ancient_history_mark'. Stores which have been lazily
+  // opened and whose stats haven't been loaded yet are counted too, since
+  // we can't tell whether they're ancient without reading them.
+  int64_t EstimateBytesInPotentiallyAncientUndoDeltas(Timestamp ancient_history_mark) const;
+
+  // Remove and orphan every UNDO delta store whose deltas are all older than
+  // 'ancient_history_mark', then flush the rowset metadata. No snapshot read
+  // at or after the mark can need those deltas.
+  //
+  // The number of blocks and bytes deleted are added to '*blocks_deleted' and
+  // '*bytes_deleted'.
+  Status DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
+                                 int64_t* blocks_deleted,
+                                 int64_t* bytes_deleted);
+
   // Return the number of rows encompassed by this DeltaTracker. Note that
   // this is _not_ the number of updated rows, but rather the number of rows
   // in the associated CFileSet base data. All updates must have a rowid
@@ -184,6 +200,16 @@ class DeltaTracker {
   // Retrieves the list of column indexes that currently have updates.
   void GetColumnIdsWithUpdates(std::vector<ColumnId>* col_ids) const;
 
+  // Returns false if the given column is known not to have any REDO updates.
+  // The DeltaMemStore doesn't keep per-column stats, so this is only known if
+  // it's empty and every REDO delta file's stats have been loaded.
+  bool MayHaveUpdatesToColumn(ColumnId col_id) const;
+
+  // Sets 'all_older' to true if the DeltaMemStore is empty and every UNDO and
+  // REDO delta file only holds deltas older than 'timestamp'. Lazily opened
+  // delta files are initialized to read their stats.
+  Status CheckAllDeltasOlderThan(Timestamp timestamp, bool* all_older) const;
+
   Mutex* compact_flush_lock() {
     return &compact_flush_lock_;
   }
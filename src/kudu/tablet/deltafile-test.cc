@@ -28,6 +28,7 @@
 #include "kudu/util/memenv/memenv.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_bool(deltafile_columnar_layout);
 DECLARE_int32(deltafile_default_block_size);
 DECLARE_bool(log_block_manager_test_hole_punching);
 DEFINE_int32(first_row_to_update, 10000, "the first row to update");
@@ -265,6 +266,106 @@ TEST_F(TestDeltaFile, TestRoundTrip) {
   DoTestRoundTrip();
 }
 
+TEST_F(TestDeltaFile, TestRoundTripColumnarLayout) {
+  google::FlagSaver saver;
+  FLAGS_deltafile_columnar_layout = true;
+  DoTestRoundTrip();
+
+  shared_ptr<DeltaFileReader> reader;
+  ASSERT_OK(OpenDeltaFileReader(test_block_, &reader));
+  ASSERT_TRUE(reader->delta_stats().columnar_layout());
+}
+
+TEST_F(TestDeltaFile, TestRoundTripTinyColumnarDeltaBlocks) {
+  google::FlagSaver saver;
+  FLAGS_deltafile_columnar_layout = true;
+  FLAGS_deltafile_default_block_size = 256;
+  DoTestRoundTrip();
+}
+
+// Check that the deltas read back from files with the row and the columnar
+// layouts are the same.
+TEST_F(TestDeltaFile, TestColumnarLayoutMatchesRowLayout) {
+  google::FlagSaver saver;
+  FLAGS_deltafile_default_block_size = 256;
+  vector<string> contents[2];
+  for (int columnar = 0; columnar < 2; columnar++) {
+    FLAGS_deltafile_columnar_layout = columnar;
+    WriteTestFile(10, 12);
+
+    gscoped_ptr<DeltaIterator> it;
+    ASSERT_OK(OpenDeltaFileIterator(test_block_, &it));
+    ASSERT_OK(DebugDumpDeltaIterator(REDO, it.get(), schema_, ITERATE_OVER_ALL_ROWS,
+                                     &contents[columnar]));
+  }
+  ASSERT_EQ(3 * ((FLAGS_last_row_to_update - FLAGS_first_row_to_update) / 2 + 1),
+            contents[0].size());
+  ASSERT_EQ(contents[0], contents[1]);
+}
+
+TEST_F(TestDeltaFile, TestColumnarLayoutDeletes) {
+  google::FlagSaver saver;
+  FLAGS_deltafile_columnar_layout = true;
+
+  gscoped_ptr<WritableBlock> block;
+  ASSERT_OK(fs_manager_->CreateNewBlock(&block));
+  test_block_ = block->id();
+  DeltaFileWriter dfw(std::move(block));
+  ASSERT_OK(dfw.Start());
+
+  // Update row 1, then update and delete row 2.
+  faststring buf;
+  DeltaStats stats;
+  for (int i = 0; i < 3; i++) {
+    buf.clear();
+    RowChangeListEncoder enc(&buf);
+    uint32_t new_val = 100 + i;
+    if (i < 2) {
+      enc.AddColumnUpdate(schema_.column(0), schema_.column_id(0), &new_val);
+    } else {
+      enc.SetToDelete();
+    }
+    DeltaKey key(i == 0 ? 1 : 2, Timestamp(i + 1));
+    RowChangeList rcl(buf);
+    ASSERT_OK(dfw.AppendDelta<REDO>(key, rcl));
+    ASSERT_OK(stats.UpdateStats(key.timestamp(), rcl));
+  }
+  ASSERT_OK(dfw.WriteDeltaStats(stats));
+  ASSERT_OK(dfw.Finish());
+
+  shared_ptr<DeltaFileReader> reader;
+  ASSERT_OK(OpenDeltaFileReader(test_block_, &reader));
+  ASSERT_EQ(1, reader->delta_stats().delete_count());
+  bool deleted;
+  ASSERT_OK(reader->CheckRowDeleted(1, &deleted));
+  ASSERT_FALSE(deleted);
+  ASSERT_OK(reader->CheckRowDeleted(2, &deleted));
+  ASSERT_TRUE(deleted);
+
+  // Row 2's update is still applied, and its delete is collected.
+  gscoped_ptr<DeltaIterator> it;
+  ASSERT_OK(OpenDeltaFileIteratorFromReader(REDO, reader, &it));
+  ASSERT_OK(it->Init(nullptr));
+  ASSERT_OK(it->SeekToOrdinal(0));
+  RowBlock row_block(schema_, 3, &arena_);
+  row_block.ZeroMemory();
+  ASSERT_OK(it->PrepareBatch(3, DeltaIterator::PREPARE_FOR_APPLY));
+  ColumnBlock dst_col = row_block.column_block(0);
+  ASSERT_OK(it->ApplyUpdates(0, &dst_col));
+  ASSERT_EQ(0U, *schema_.ExtractColumnFromRow<UINT32>(row_block.row(0), 0));
+  ASSERT_EQ(100U, *schema_.ExtractColumnFromRow<UINT32>(row_block.row(1), 0));
+  ASSERT_EQ(101U, *schema_.ExtractColumnFromRow<UINT32>(row_block.row(2), 0));
+
+  ASSERT_OK(it->SeekToOrdinal(0));
+  vector<Mutation *> mutations(3, reinterpret_cast<Mutation *>(NULL));
+  ASSERT_OK(it->PrepareBatch(3, DeltaIterator::PREPARE_FOR_COLLECT));
+  ASSERT_OK(it->CollectMutations(&mutations, &arena_));
+  ASSERT_TRUE(mutations[0] == nullptr);
+  ASSERT_EQ("[@1(SET val=100)]", Mutation::StringifyMutationList(schema_, mutations[1]));
+  ASSERT_EQ("[@2(SET val=101), @3(DELETE)]",
+            Mutation::StringifyMutationList(schema_, mutations[2]));
+}
+
 TEST_F(TestDeltaFile, TestCollectMutations) {
   WriteTestFile();
 
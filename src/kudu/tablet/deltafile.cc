@@ -18,9 +18,11 @@
 #include "kudu/tablet/deltafile.h"
 
 #include <arpa/inet.h>
+#include <algorithm>
 #include <memory>
 #include <string>
 
+#include "kudu/common/row.h"
 #include "kudu/common/wire_protocol.h"
 #include "kudu/cfile/binary_plain_block.h"
 #include "kudu/cfile/block_encodings.h"
@@ -31,6 +33,7 @@
 #include "kudu/gutil/mathlimits.h"
 #include "kudu/tablet/mutation.h"
 #include "kudu/tablet/mvcc.h"
+#include "kudu/util/coding.h"
 #include "kudu/util/coding-inl.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/hexdump.h"
@@ -43,7 +46,15 @@ DEFINE_int32(deltafile_default_block_size, 32*1024,
              "on a per-table basis.");
 TAG_FLAG(deltafile_default_block_size, experimental);
 
+DEFINE_bool(deltafile_columnar_layout, false,
+            "Whether new delta files group the updates of each block by column, "
+            "so that scans and major delta compactions which only need some of the "
+            "columns don't have to decode the updates to the others.");
+TAG_FLAG(deltafile_columnar_layout, experimental);
+
 using std::shared_ptr;
+using std::unique_ptr;
+using std::vector;
 
 namespace kudu {
 
@@ -62,11 +73,38 @@ const char * const DeltaFileReader::kDeltaStatsEntryName = "deltafilestats";
 
 namespace {
 
+// Decode the next update from the updates to a column of a block with the
+// columnar layout: the ordinal of its delta, followed by the new value.
+Status DecodeColumnUpdate(Slice* data, uint32_t* ordinal,
+                          RowChangeListDecoder::DecodedUpdate* update) {
+  uint32_t size_plus_one;
+  if (PREDICT_FALSE(!GetVarint32(data, ordinal) ||
+                    !GetVarint32(data, &size_plus_one))) {
+    return Status::Corruption("truncated column updates in delta block");
+  }
+  if (size_plus_one == 0) {
+    update->null = true;
+    update->raw_value = Slice();
+    return Status::OK();
+  }
+  uint32_t size = size_plus_one - 1;
+  if (PREDICT_FALSE(data->size() < size)) {
+    return Status::Corruption("truncated column update value in delta block");
+  }
+  update->null = false;
+  update->raw_value = Slice(data->data(), size);
+  data->remove_prefix(size);
+  return Status::OK();
+}
+
 } // namespace
 
 DeltaFileWriter::DeltaFileWriter(gscoped_ptr<WritableBlock> block)
+  : columnar_(FLAGS_deltafile_columnar_layout),
+    deltas_appended_(0),
+    pending_size_(0)
 #ifndef NDEBUG
- : has_appended_(false)
+  , has_appended_(false)
 #endif
 { // NOLINT(*)
   cfile::WriterOptions opts;
@@ -88,10 +126,11 @@ Status DeltaFileWriter::Finish() {
 }
 
 Status DeltaFileWriter::FinishAndReleaseBlock(ScopedWritableBlockCloser* closer) {
-  if (writer_->written_value_count() == 0) {
+  if (deltas_appended_ == 0) {
     LOG(WARNING) << "no deltas written, off=" << writer_->written_size();
     return Status::Aborted("no deltas written");
   }
+  RETURN_NOT_OK(FlushColumnarBlock());
   return writer_->FinishAndReleaseBlock(closer);
 }
 
@@ -104,6 +143,11 @@ Status DeltaFileWriter::DoAppendDelta(const DeltaKey &key,
     << "TODO: REINSERT deltas cannot currently be written to disk "
     << "since they don't have a standalone encoded form.";
 
+  deltas_appended_++;
+  if (columnar_) {
+    return BufferColumnarDelta(key, delta);
+  }
+
   tmp_buf_.clear();
 
   // Write the encoded form of the key to the file.
@@ -115,6 +159,83 @@ Status DeltaFileWriter::DoAppendDelta(const DeltaKey &key,
   return writer_->AppendEntries(&tmp_buf_slice, 1);
 }
 
+Status DeltaFileWriter::BufferColumnarDelta(const DeltaKey &key,
+                                            const RowChangeList &delta) {
+  RowChangeListDecoder decoder(delta);
+  RETURN_NOT_OK(decoder.Init());
+
+  uint32_t ordinal = pending_keys_.size();
+  pending_keys_.push_back(key);
+  pending_types_.push_back(delta.slice()[0]);
+  if (decoder.is_update()) {
+    while (decoder.HasNext()) {
+      RowChangeListDecoder::DecodedUpdate update;
+      RETURN_NOT_OK(decoder.DecodeNext(&update));
+      PendingColumn* col = &pending_columns_[update.col_id];
+      col->count++;
+      PutVarint32(&col->data, ordinal);
+      if (update.null) {
+        PutVarint32(&col->data, 0);
+      } else {
+        PutVarint32(&col->data, update.raw_value.size() + 1);
+        col->data.append(update.raw_value.data(), update.raw_value.size());
+      }
+    }
+  }
+
+  // The key takes up to 15 bytes, and each update takes a couple of bytes
+  // more than in the RowChangeList.
+  pending_size_ += 16 + delta.slice().size();
+  if (pending_size_ >= static_cast<size_t>(FLAGS_deltafile_default_block_size)) {
+    return FlushColumnarBlock();
+  }
+  return Status::OK();
+}
+
+Status DeltaFileWriter::FlushColumnarBlock() {
+  if (pending_keys_.empty()) {
+    return Status::OK();
+  }
+
+  // The block starts with the keys of its deltas: the row index as a
+  // difference from the previous one, the timestamp and the type.
+  tmp_buf_.clear();
+  PutVarint32(&tmp_buf_, pending_keys_.size());
+  rowid_t prev_row_idx = 0;
+  for (size_t i = 0; i < pending_keys_.size(); i++) {
+    const DeltaKey& key = pending_keys_[i];
+    PutVarint32(&tmp_buf_, key.row_idx() - prev_row_idx);
+    PutVarint64(&tmp_buf_, key.timestamp().ToUint64());
+    tmp_buf_.push_back(pending_types_[i]);
+    prev_row_idx = key.row_idx();
+  }
+
+  // Then come the updates to each column.
+  PutVarint32(&tmp_buf_, pending_columns_.size());
+  for (const auto& entry : pending_columns_) {
+    PutVarint32(&tmp_buf_, entry.first);
+    PutVarint32(&tmp_buf_, entry.second.count);
+    PutVarint32(&tmp_buf_, entry.second.data.size());
+    tmp_buf_.append(entry.second.data.data(), entry.second.data.size());
+  }
+
+  // Index the block by the key of its first delta, like blocks with the row
+  // layout, so that the iterators can seek the same way in both layouts.
+  faststring first_key;
+  pending_keys_.front().EncodeTo(&first_key);
+  Slice first_key_slice(first_key);
+  vector<Slice> slices;
+  slices.push_back(Slice(tmp_buf_));
+  RETURN_NOT_OK(writer_->AppendRawBlock(slices, deltas_appended_ - pending_keys_.size(),
+                                        &first_key_slice, "delta block"));
+
+  pending_keys_.clear();
+  pending_types_.clear();
+  pending_columns_.clear();
+  pending_size_ = 0;
+  return Status::OK();
+}
+
 template<>
 Status DeltaFileWriter::AppendDelta<REDO>(
   const DeltaKey &key, const RowChangeList &delta) {
@@ -154,8 +275,10 @@ Status DeltaFileWriter::AppendDelta<UNDO>(
 }
 
 Status DeltaFileWriter::WriteDeltaStats(const DeltaStats& stats) {
+  DeltaStats file_stats(stats);
+  file_stats.set_columnar_layout(columnar_);
   DeltaStatsPB delta_stats_pb;
-  stats.ToPB(&delta_stats_pb);
+  file_stats.ToPB(&delta_stats_pb);
 
   faststring buf;
   if (!pb_util::SerializeToString(delta_stats_pb, &buf)) {
@@ -351,6 +474,7 @@ DeltaFileIterator::DeltaFileIterator(shared_ptr<DeltaFileReader> dfr,
     : dfr_(std::move(dfr)),
       projection_(projection),
       mvcc_snap_(std::move(snap)),
+      columnar_(false),
       prepared_idx_(0xdeadbeef),
       prepared_count_(0),
       prepared_(false),
@@ -367,6 +491,14 @@ Status DeltaFileIterator::Init(ScanSpec *spec) {
                                            CFileReader::DONT_CACHE_BLOCK;
   }
 
+  projected_columns_.exclude = false;
+  if (projection_->has_column_ids()) {
+    for (int i = 0; i < projection_->num_columns(); i++) {
+      projected_columns_.col_ids.push_back(projection_->column_id(i));
+    }
+    std::sort(projected_columns_.col_ids.begin(), projected_columns_.col_ids.end());
+  }
+
   initted_ = true;
   return Status::OK();
 }
@@ -376,6 +508,7 @@ Status DeltaFileIterator::SeekToOrdinal(rowid_t idx) {
 
   // Finish the initialization of any lazily-initialized state.
   RETURN_NOT_OK(dfr_->Init());
+  columnar_ = dfr_->delta_stats().columnar_layout();
 
   // Check again whether this delta file is relevant given the snapshot
   // that we are querying. We did this already before creating the
@@ -423,18 +556,23 @@ Status DeltaFileIterator::ReadCurrentBlockOntoQueue() {
   gscoped_ptr<PreparedDeltaBlock> pdb(new PreparedDeltaBlock());
   BlockPointer dblk_ptr = index_iter_->GetCurrentBlockPointer();
   RETURN_NOT_OK(dfr_->cfile_reader()->ReadBlock(
-      dblk_ptr, cache_blocks_, &pdb->block_));
+      dblk_ptr, cache_blocks_, CFileReader::DATA_BLOCK, &pdb->block_));
 
   // The data has been successfully read. Finish creating the decoder.
   pdb->prepared_block_start_idx_ = 0;
   pdb->block_ptr_ = dblk_ptr;
 
-  // Decode the block.
-  pdb->decoder_.reset(new BinaryPlainBlockDecoder(pdb->block_.data()));
-  RETURN_NOT_OK(pdb->decoder_->ParseHeader());
-
   RETURN_NOT_OK(GetFirstRowIndexInCurrentBlock(&pdb->first_updated_idx_));
-  RETURN_NOT_OK(GetLastRowIndexInDecodedBlock(*pdb->decoder_, &pdb->last_updated_idx_));
+
+  // Decode the block.
+  if (columnar_) {
+    RETURN_NOT_OK(ParseColumnarBlock(pdb.get()));
+    pdb->last_updated_idx_ = pdb->keys_.back().row_idx();
+  } else {
+    pdb->decoder_.reset(new BinaryPlainBlockDecoder(pdb->block_.data()));
+    RETURN_NOT_OK(pdb->decoder_->ParseHeader());
+    RETURN_NOT_OK(GetLastRowIndexInDecodedBlock(*pdb->decoder_, &pdb->last_updated_idx_));
+  }
 
   #ifndef NDEBUG
   VLOG(2) << "Read delta block which updates " <<
@@ -467,6 +605,157 @@ Status DeltaFileIterator::GetLastRowIndexInDecodedBlock(const BinaryPlainBlockDe
 }
 
 
+Status DeltaFileIterator::ParseColumnarBlock(PreparedDeltaBlock* pdb) {
+  Slice data = pdb->block_.data();
+  uint32_t num_deltas;
+  if (PREDICT_FALSE(!GetVarint32(&data, &num_deltas) || num_deltas == 0)) {
+    return Status::Corruption("bad delta count in delta block",
+                              pdb->block_ptr_.ToString());
+  }
+
+  pdb->keys_.reserve(num_deltas);
+  pdb->types_.reserve(num_deltas);
+  rowid_t row_idx = 0;
+  for (uint32_t i = 0; i < num_deltas; i++) {
+    uint32_t row_idx_delta;
+    uint64_t timestamp;
+    if (PREDICT_FALSE(!GetVarint32(&data, &row_idx_delta) ||
+                      !GetVarint64(&data, &timestamp) ||
+                      data.empty())) {
+      return Status::Corruption("truncated delta keys in delta block",
+                                pdb->block_ptr_.ToString());
+    }
+    if (PREDICT_FALSE(data[0] != RowChangeList::kUpdate &&
+                      data[0] != RowChangeList::kDelete)) {
+      return Status::Corruption("bad delta type in delta block",
+                                pdb->block_ptr_.ToString());
+    }
+    row_idx += row_idx_delta;
+    pdb->keys_.push_back(DeltaKey(row_idx, Timestamp(timestamp)));
+    pdb->types_.push_back(data[0]);
+    data.remove_prefix(1);
+  }
+
+  uint32_t num_columns;
+  if (PREDICT_FALSE(!GetVarint32(&data, &num_columns))) {
+    return Status::Corruption("bad column count in delta block",
+                              pdb->block_ptr_.ToString());
+  }
+  pdb->columns_.resize(num_columns);
+  for (ColumnUpdates& col : pdb->columns_) {
+    uint32_t col_id;
+    uint32_t size;
+    if (PREDICT_FALSE(!GetVarint32(&data, &col_id) ||
+                      !GetVarint32(&data, &col.count) ||
+                      !GetVarint32(&data, &size) ||
+                      data.size() < size)) {
+      return Status::Corruption("truncated column updates in delta block",
+                                pdb->block_ptr_.ToString());
+    }
+    col.col_id = ColumnId(col_id);
+    col.data = Slice(data.data(), size);
+    data.remove_prefix(size);
+  }
+  return Status::OK();
+}
+
+size_t DeltaFileIterator::PreparedDeltaBlock::num_deltas() const {
+  return decoder_ ? decoder_->Count() : keys_.size();
+}
+
+Status DeltaFileIterator::PreparedDeltaBlock::GetKey(size_t idx, DeltaKey* key) const {
+  if (!decoder_) {
+    *key = keys_[idx];
+    return Status::OK();
+  }
+  Slice s(decoder_->string_at_index(idx));
+  return key->DecodeFrom(&s);
+}
+
+const DeltaFileIterator::ColumnUpdates* DeltaFileIterator::PreparedDeltaBlock::FindColumn(
+    ColumnId col_id) const {
+  for (const ColumnUpdates& col : columns_) {
+    if (col.col_id == col_id) {
+      return &col;
+    }
+  }
+  return nullptr;
+}
+
+bool DeltaFileIterator::ColumnSelection::Includes(ColumnId col_id) const {
+  return std::binary_search(col_ids.begin(), col_ids.end(), col_id) != exclude;
+}
+
+Status DeltaFileIterator::GetRebuiltChangeLists(const ColumnSelection& selection,
+                                                PreparedDeltaBlock* block,
+                                                const vector<Slice>** rcls) {
+  for (const unique_ptr<RebuiltChangeLists>& rebuilt : block->rebuilt_) {
+    if (rebuilt->selection.exclude == selection.exclude &&
+        rebuilt->selection.col_ids == selection.col_ids) {
+      *rcls = &rebuilt->rcls;
+      return Status::OK();
+    }
+  }
+
+  // Gather the selected updates, then order them by delta. The sort is
+  // stable so that the updates of each delta stay in column order.
+  struct Update {
+    uint32_t ordinal;
+    RowChangeListDecoder::DecodedUpdate update;
+  };
+  vector<Update> updates;
+  for (const ColumnUpdates& col : block->columns_) {
+    if (!selection.Includes(col.col_id)) {
+      continue;
+    }
+    Slice data = col.data;
+    for (uint32_t i = 0; i < col.count; i++) {
+      Update u;
+      u.update.col_id = col.col_id;
+      RETURN_NOT_OK(DecodeColumnUpdate(&data, &u.ordinal, &u.update));
+      if (PREDICT_FALSE(u.ordinal >= block->keys_.size())) {
+        return Status::Corruption("bad delta ordinal in delta block",
+                                  block->block_ptr_.ToString());
+      }
+      updates.push_back(u);
+    }
+  }
+  std::stable_sort(updates.begin(), updates.end(),
+                   [](const Update& a, const Update& b) { return a.ordinal < b.ordinal; });
+
+  // Encode all of the RowChangeLists into a single buffer, and only take
+  // slices of it once it has stopped growing.
+  unique_ptr<RebuiltChangeLists> rebuilt(new RebuiltChangeLists());
+  rebuilt->selection = selection;
+  vector<size_t> offsets;
+  offsets.reserve(block->keys_.size() + 1);
+  auto it = updates.begin();
+  for (uint32_t ordinal = 0; ordinal < block->keys_.size(); ordinal++) {
+    offsets.push_back(rebuilt->buf.size());
+    RowChangeListEncoder enc(&rebuilt->buf);
+    if (block->types_[ordinal] == RowChangeList::kDelete) {
+      enc.SetToDelete();
+    }
+    for (; it != updates.end() && it->ordinal == ordinal; ++it) {
+      if (PREDICT_FALSE(block->types_[ordinal] != RowChangeList::kUpdate)) {
+        return Status::Corruption("column update for a non-UPDATE delta in delta block",
+                                  block->block_ptr_.ToString());
+      }
+      enc.AddRawColumnUpdate(it->update.col_id, it->update.null, it->update.raw_value);
+    }
+  }
+  offsets.push_back(rebuilt->buf.size());
+
+  rebuilt->rcls.reserve(block->keys_.size());
+  for (size_t i = 0; i < block->keys_.size(); i++) {
+    rebuilt->rcls.push_back(Slice(rebuilt->buf.data() + offsets[i],
+                                  offsets[i + 1] - offsets[i]));
+  }
+  *rcls = &rebuilt->rcls;
+  block->rebuilt_.push_back(std::move(rebuilt));
+  return Status::OK();
+}
+
 string DeltaFileIterator::PreparedDeltaBlock::ToString() const {
   return StringPrintf("%d-%d (%s)", first_updated_idx_, last_updated_idx_,
                       block_ptr_.ToString().c_str());
@@ -511,11 +800,10 @@ Status DeltaFileIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
     PreparedDeltaBlock &block = delta_blocks_.front();
     int i = 0;
     for (i = block.prepared_block_start_idx_;
-         i < block.decoder_->Count();
+         i < block.num_deltas();
          i++) {
-      Slice s(block.decoder_->string_at_index(i));
       DeltaKey key;
-      RETURN_NOT_OK(key.DecodeFrom(&s));
+      RETURN_NOT_OK(block.GetKey(i, &key));
       if (key.row_idx() >= start_row) break;
     }
     block.prepared_block_start_idx_ = i;
@@ -532,13 +820,12 @@ Status DeltaFileIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
 }
 
 template<class Visitor>
-Status DeltaFileIterator::VisitMutations(Visitor *visitor) {
+Status DeltaFileIterator::VisitMutations(Visitor *visitor, const ColumnSelection& selection) {
   DCHECK(prepared_) << "must Prepare";
 
   rowid_t start_row = prepared_idx_;
 
   for (PreparedDeltaBlock &block : delta_blocks_) {
-    BinaryPlainBlockDecoder &bpd = *block.decoder_;
     DVLOG(2) << "Visiting delta block " << block.first_updated_idx_ << "-"
       << block.last_updated_idx_ << " for row block starting at " << start_row;
 
@@ -552,14 +839,24 @@ Status DeltaFileIterator::VisitMutations(Visitor *visitor) {
       continue;
     }
 
+    const vector<Slice>* rcls = nullptr;
+    if (columnar_) {
+      RETURN_NOT_OK(GetRebuiltChangeLists(selection, &block, &rcls));
+    }
+
     rowid_t previous_rowidx = MathLimits<rowid_t>::kMax;
     bool continue_visit = true;
-    for (int i = block.prepared_block_start_idx_; i < bpd.Count(); i++) {
-      Slice slice = bpd.string_at_index(i);
-
-      // Decode and check the ID of the row we're going to update.
+    for (int i = block.prepared_block_start_idx_; i < block.num_deltas(); i++) {
+      Slice slice;
       DeltaKey key;
-      RETURN_NOT_OK(key.DecodeFrom(&slice));
+      if (columnar_) {
+        key = block.keys_[i];
+        slice = (*rcls)[i];
+      } else {
+        // Decode and check the ID of the row we're going to update.
+        slice = block.decoder_->string_at_index(i);
+        RETURN_NOT_OK(key.DecodeFrom(&slice));
+      }
       rowid_t row_idx = key.row_idx();
 
       // Check if the previous visitor notified us we don't need to apply more
@@ -578,6 +875,9 @@ Status DeltaFileIterator::VisitMutations(Visitor *visitor) {
       } else if (row_idx < start_row) {
         // Delta is for a row which comes before the block we're processing.
         continue;
+      } else if (slice.empty()) {
+        // Delta only updates columns which weren't selected.
+        continue;
       }
       RETURN_NOT_OK(visitor->Visit(key, slice, &continue_visit));
       if (VLOG_IS_ON(3)) {
@@ -679,17 +979,104 @@ inline Status ApplyingVisitor<UNDO>::Visit(const DeltaKey& key,
   return Status::OK();
 }
 
+template<DeltaType Type>
+inline bool IsRelevant(const MvccSnapshot& snap,
+                       const Timestamp& timestamp,
+                       bool* continue_visit);
+
+template<>
+inline bool IsRelevant<REDO>(const MvccSnapshot& snap,
+                             const Timestamp& timestamp,
+                             bool* continue_visit) {
+  return IsRedoRelevant(snap, timestamp, continue_visit);
+}
+
+template<>
+inline bool IsRelevant<UNDO>(const MvccSnapshot& snap,
+                             const Timestamp& timestamp,
+                             bool* continue_visit) {
+  return IsUndoRelevant(snap, timestamp, continue_visit);
+}
+
+template<DeltaType Type>
+Status DeltaFileIterator::ApplyColumnarUpdates(size_t col_to_apply, ColumnBlock *dst) {
+  DCHECK(prepared_) << "must Prepare";
+
+  const ColumnSchema& col_schema = projection_->column(col_to_apply);
+  ColumnId col_id = projection_->column_id(col_to_apply);
+  rowid_t start_row = prepared_idx_;
+
+  for (PreparedDeltaBlock &block : delta_blocks_) {
+    if (PREDICT_FALSE(start_row > block.last_updated_idx_)) {
+      // See VisitMutations().
+      continue;
+    }
+    const ColumnUpdates* col = block.FindColumn(col_id);
+    if (col == nullptr) {
+      continue;
+    }
+
+    // The updates to the column are in (row, timestamp) order, like the
+    // deltas themselves, so they are applied in the same order as when
+    // visiting the whole RowChangeLists.
+    Slice data = col->data;
+    for (uint32_t i = 0; i < col->count; i++) {
+      uint32_t ordinal;
+      RowChangeListDecoder::DecodedUpdate update;
+      update.col_id = col_id;
+      RETURN_NOT_OK(DecodeColumnUpdate(&data, &ordinal, &update));
+      if (ordinal < block.prepared_block_start_idx_) {
+        continue;
+      }
+      if (PREDICT_FALSE(ordinal >= block.keys_.size())) {
+        return Status::Corruption("bad delta ordinal in delta block",
+                                  block.block_ptr_.ToString());
+      }
+
+      const DeltaKey& key = block.keys_[ordinal];
+      if (key.row_idx() >= start_row + prepared_count_) {
+        // Delta is for a row which comes after the block we're processing.
+        return Status::OK();
+      } else if (key.row_idx() < start_row) {
+        continue;
+      }
+
+      // Unlike VisitMutations(), this doesn't skip the remaining deltas of a
+      // row once one is found to be irrelevant: they are irrelevant as well.
+      bool continue_visit;
+      if (!IsRelevant<Type>(mvcc_snap_, key.timestamp(), &continue_visit)) {
+        continue;
+      }
+
+      int col_idx;
+      const void* new_val;
+      RETURN_NOT_OK(update.Validate(*projection_, &col_idx, &new_val));
+      DCHECK_EQ(col_idx, static_cast<int>(col_to_apply));
+      SimpleConstCell src(&col_schema, new_val);
+      ColumnBlock::Cell dst_cell = dst->cell(key.row_idx() - prepared_idx_);
+      RETURN_NOT_OK(CopyCell(src, &dst_cell, dst->arena()));
+    }
+  }
+  return Status::OK();
+}
+
 Status DeltaFileIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) {
   DCHECK_LE(prepared_count_, dst->nrows());
 
   if (delta_type_ == REDO) {
     DVLOG(3) << "Applying REDO mutations to " << col_to_apply;
+    if (columnar_) {
+      return ApplyColumnarUpdates<REDO>(col_to_apply, dst);
+    }
     ApplyingVisitor<REDO> visitor = {this, col_to_apply, dst};
-    return VisitMutations(&visitor);
+    return VisitMutations(&visitor, projected_columns_);
   } else {
     DVLOG(3) << "Applying UNDO mutations to " << col_to_apply;
+    if (columnar_) {
+      return ApplyColumnarUpdates<UNDO>(col_to_apply, dst);
+    }
     ApplyingVisitor<UNDO> visitor = {this, col_to_apply, dst};
-    return VisitMutations(&visitor);
+    return VisitMutations(&visitor, projected_columns_);
   }
 }
 
@@ -746,14 +1133,16 @@ inline Status DeletingVisitor<UNDO>::Visit(const DeltaKey& key,
 
 Status DeltaFileIterator::ApplyDeletes(SelectionVector *sel_vec) {
   DCHECK_LE(prepared_count_, sel_vec->nrows());
+  // Deletes don't need any column updates.
+  ColumnSelection no_columns = { vector<ColumnId>(), false };
   if (delta_type_ == REDO) {
     DVLOG(3) << "Applying REDO deletes";
     DeletingVisitor<REDO> visitor = { this, sel_vec};
-    return VisitMutations(&visitor);
+    return VisitMutations(&visitor, no_columns);
   } else {
     DVLOG(3) << "Applying UNDO deletes";
     DeletingVisitor<UNDO> visitor = { this, sel_vec};
-    return VisitMutations(&visitor);
+    return VisitMutations(&visitor, no_columns);
   }
 }
 
@@ -805,10 +1194,10 @@ Status DeltaFileIterator::CollectMutations(vector<Mutation *> *dst, Arena *dst_a
   DCHECK_LE(prepared_count_, dst->size());
   if (delta_type_ == REDO) {
     CollectingVisitor<REDO> visitor = {this, dst, dst_arena};
-    return VisitMutations(&visitor);
+    return VisitMutations(&visitor, projected_columns_);
   } else {
     CollectingVisitor<UNDO> visitor = {this, dst, dst_arena};
-    return VisitMutations(&visitor);
+    return VisitMutations(&visitor, projected_columns_);
   }
 }
 
@@ -856,7 +1245,8 @@ Status DeltaFileIterator::FilterColumnIdsAndCollectDeltas(
     vector<DeltaKeyAndUpdate>* out,
     Arena* arena) {
   FilterAndAppendVisitor visitor = {this, col_ids, out, arena};
-  return VisitMutations(&visitor);
+  ColumnSelection other_columns = { col_ids, true };
+  return VisitMutations(&visitor, other_columns);
 }
 
 void DeltaFileIterator::FatalUnexpectedDelta(const DeltaKey &key, const Slice &deltas,
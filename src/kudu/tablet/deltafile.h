@@ -18,6 +18,7 @@
 #define KUDU_TABLET_DELTAFILE_H
 
 #include <boost/ptr_container/ptr_deque.hpp>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -55,6 +56,15 @@ struct CollectingVisitor;
 template<DeltaType Type>
 struct DeletingVisitor;
 
+// Writes deltas to a delta file.
+//
+// By default, each entry of the underlying cfile is an encoded DeltaKey
+// followed by the RowChangeList of the delta. If --deltafile_columnar_layout
+// is set, the deltas are instead buffered until they fill a block, which is
+// written with the keys of its deltas first, followed by the updates of
+// each column grouped together. Readers which only need some of the columns
+// can then skip the updates to the others without decoding them. The layout
+// is recorded in the DeltaStats of the file.
 class DeltaFileWriter {
  public:
   // Construct a new delta file writer.
@@ -83,10 +93,45 @@ class DeltaFileWriter {
   Status WriteDeltaStats(const DeltaStats& stats);
 
  private:
+  // The updates to one column of the deltas buffered for the next block,
+  // when writing the columnar layout.
+  struct PendingColumn {
+    PendingColumn() : count(0) {}
+
+    // The number of updates.
+    uint32_t count;
+
+    // For each update, the ordinal of its delta within the block, followed
+    // by the new value, encoded as in a RowChangeList.
+    faststring data;
+  };
+
   Status DoAppendDelta(const DeltaKey &key, const RowChangeList &delta);
 
+  // Buffer 'delta' into the next block of a file with the columnar layout,
+  // writing the block out once it is full.
+  Status BufferColumnarDelta(const DeltaKey &key, const RowChangeList &delta);
+
+  // Write out the deltas buffered for the next block of a file with the
+  // columnar layout, if any.
+  Status FlushColumnarBlock();
+
   gscoped_ptr<cfile::CFileWriter> writer_;
 
+  // Whether the deltas are grouped by column within each block.
+  const bool columnar_;
+
+  // The number of deltas appended so far.
+  int64_t deltas_appended_;
+
+  // The deltas buffered for the next block, when writing the columnar
+  // layout: their keys, their types, the updates to each column, and the
+  // approximate encoded size of all of these.
+  std::vector<DeltaKey> pending_keys_;
+  std::vector<uint8_t> pending_types_;
+  std::map<ColumnId, PendingColumn> pending_columns_;
+  size_t pending_size_;
+
   // Buffer used as a temporary for storing the serialized form
   // of the deltas
   faststring tmp_buf_;
@@ -215,6 +260,37 @@ class DeltaFileIterator : public DeltaIterator {
 
   DISALLOW_COPY_AND_ASSIGN(DeltaFileIterator);
 
+  // The columns whose updates are kept when rebuilding the RowChangeLists of
+  // a block with the columnar layout: only 'col_ids', or all of the columns
+  // but 'col_ids' if 'exclude' is set. 'col_ids' is sorted.
+  struct ColumnSelection {
+    std::vector<ColumnId> col_ids;
+    bool exclude;
+
+    bool Includes(ColumnId col_id) const;
+  };
+
+  // The updates to one column of a block with the columnar layout.
+  struct ColumnUpdates {
+    ColumnId col_id;
+
+    // The number of updates.
+    uint32_t count;
+
+    // For each update, the ordinal of its delta within the block, followed
+    // by the new value, encoded as in a RowChangeList.
+    Slice data;
+  };
+
+  // The RowChangeLists of the deltas of a block with the columnar layout,
+  // rebuilt with the updates to the columns in 'selection'. Deltas which
+  // don't update any of these columns have an empty RowChangeList.
+  struct RebuiltChangeLists {
+    ColumnSelection selection;
+    faststring buf;
+    std::vector<Slice> rcls;
+  };
+
   // PrepareBatch() will read forward all blocks from the deltafile
   // which overlap with the block being prepared, enqueueing them onto
   // the 'delta_blocks_' deque. The prepared blocks are then used to
@@ -247,6 +323,27 @@ class DeltaFileIterator : public DeltaIterator {
     // which we know don't apply to the prepared row block.
     rowid_t prepared_block_start_idx_;
 
+    // Only set for files with the columnar layout: the keys of the deltas
+    // in this block, their RowChangeList types, and the updates to each
+    // column, which are only decoded when that column is needed.
+    std::vector<DeltaKey> keys_;
+    std::vector<uint8_t> types_;
+    std::vector<ColumnUpdates> columns_;
+
+    // Only set for files with the columnar layout: the RowChangeLists
+    // rebuilt so far, for each of the column selections they were needed
+    // for.
+    std::vector<std::unique_ptr<RebuiltChangeLists>> rebuilt_;
+
+    // Return the number of deltas in this block.
+    size_t num_deltas() const;
+
+    // Decode the key of the delta at 'idx' within this block.
+    Status GetKey(size_t idx, DeltaKey* key) const;
+
+    // Return the updates to 'col_id', or NULL if there are none in this block.
+    const ColumnUpdates* FindColumn(ColumnId col_id) const;
+
     // Return a string description of this prepared block, for logging.
     string ToString() const;
   };
@@ -270,10 +367,29 @@ class DeltaFileIterator : public DeltaIterator {
   // onto the end of the delta_blocks_ queue.
   Status ReadCurrentBlockOntoQueue();
 
+  // Parse the keys and the column offsets of a block with the columnar
+  // layout into 'pdb'.
+  static Status ParseColumnarBlock(PreparedDeltaBlock* pdb);
+
+  // Return the RowChangeLists of the deltas of 'block', a block with the
+  // columnar layout, with only the updates to the columns in 'selection',
+  // rebuilding them if they haven't yet been.
+  static Status GetRebuiltChangeLists(const ColumnSelection& selection,
+                                      PreparedDeltaBlock* block,
+                                      const std::vector<Slice>** rcls);
+
   // Visit all mutations in the currently prepared row range with the specified
   // visitor class.
+  //
+  // For files with the columnar layout, the visited RowChangeLists only
+  // include the updates to the columns in 'selection'.
   template<class Visitor>
-  Status VisitMutations(Visitor *visitor);
+  Status VisitMutations(Visitor *visitor, const ColumnSelection& selection);
+
+  // ApplyUpdates() for files with the columnar layout: only the updates to
+  // the column being applied are decoded.
+  template<DeltaType Type>
+  Status ApplyColumnarUpdates(size_t col_to_apply, ColumnBlock *dst);
 
   // Log a FATAL error message about a bad delta.
   void FatalUnexpectedDelta(const DeltaKey &key, const Slice &deltas, const string &msg);
@@ -286,6 +402,14 @@ class DeltaFileIterator : public DeltaIterator {
   // The MVCC state which determines which deltas should be applied.
   const MvccSnapshot mvcc_snap_;
 
+  // Whether the file has the columnar layout. Only valid after
+  // SeekToOrdinal().
+  bool columnar_;
+
+  // The columns of the projection. CollectMutations() only collects the
+  // updates to these columns from files with the columnar layout.
+  ColumnSelection projected_columns_;
+
   gscoped_ptr<cfile::IndexTreeIterator> index_iter_;
 
   // TODO: add better comments here.
@@ -507,6 +507,53 @@ Status DiskRowSet::MinorCompactDeltaStores() {
   return delta_tracker_->Compact();
 }
 
+int64_t DiskRowSet::EstimateBytesInPotentiallyAncientUndoDeltas(
+    Timestamp ancient_history_mark) const {
+  DCHECK(open_);
+  return delta_tracker_->EstimateBytesInPotentiallyAncientUndoDeltas(ancient_history_mark);
+}
+
+Status DiskRowSet::DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
+                                           int64_t* blocks_deleted,
+                                           int64_t* bytes_deleted) {
+  TRACE_EVENT0("tablet", "DiskRowSet::DeleteAncientUndoDeltas");
+  DCHECK(open_);
+  return delta_tracker_->DeleteAncientUndoDeltas(ancient_history_mark,
+                                                 blocks_deleted, bytes_deleted);
+}
+
+Status DiskRowSet::CheckAllRowsExpired(ColumnId col_id,
+                                       int64_t cutoff_micros,
+                                       Timestamp ancient_history_mark,
+                                       bool* all_expired) const {
+  DCHECK(open_);
+  *all_expired = false;
+  int64_t max_value;
+  Status s;
+  {
+    boost::shared_lock<rw_spinlock> lock(component_lock_.get_lock());
+    s = base_data_->GetMaxTimestamp(col_id, &max_value);
+  }
+  if (s.IsNotFound()) {
+    // The column was added after this rowset was written, or the rowset
+    // predates the stat: fall back to compactions.
+    return Status::OK();
+  }
+  RETURN_NOT_OK(s);
+  if (max_value >= cutoff_micros) {
+    return Status::OK();
+  }
+
+  // Rows inserted or mutated at or after the ancient history mark are still
+  // visible to some snapshot reads, even if they have expired since. Each
+  // row's insertion time is kept in an UNDO, unless it was GCed as ancient.
+  bool all_deltas_ancient;
+  RETURN_NOT_OK(delta_tracker_->CheckAllDeltasOlderThan(ancient_history_mark,
+                                                        &all_deltas_ancient));
+  *all_expired = all_deltas_ancient && !delta_tracker_->MayHaveUpdatesToColumn(col_id);
+  return Status::OK();
+}
+
 Status DiskRowSet::MajorCompactDeltaStores() {
   vector<ColumnId> col_ids;
   delta_tracker_->GetColumnIdsWithUpdates(&col_ids);
@@ -552,11 +599,15 @@ Status DiskRowSet::NewMajorDeltaCompaction(const vector<ColumnId>& col_ids,
   boost::shared_lock<rw_spinlock> lock(component_lock_.get_lock());
 
   const Schema* schema = &rowset_metadata_->tablet_schema();
+  unique_ptr<Schema> partial_schema(new Schema());
+  RETURN_NOT_OK(schema->CreateProjectionByIdsIgnoreMissing(col_ids, partial_schema.get()));
 
+  // The deltas are collected with the compacted columns as projection, so
+  // that delta files with the columnar layout only decode their updates.
   vector<shared_ptr<DeltaStore> > included_stores;
   unique_ptr<DeltaIterator> delta_iter;
   RETURN_NOT_OK(delta_tracker_->NewDeltaFileIterator(
-    schema,
+    partial_schema.get(),
     MvccSnapshot::CreateSnapshotIncludingAllTransactions(),
     REDO,
     &included_stores,
@@ -564,6 +615,7 @@ Status DiskRowSet::NewMajorDeltaCompaction(const vector<ColumnId>& col_ids,
 
   out->reset(new MajorDeltaCompaction(rowset_metadata_->fs_manager(),
                                       *schema,
+                                      std::move(partial_schema),
                                       base_data_.get(),
                                       std::move(delta_iter),
                                       included_stores,
@@ -637,6 +689,38 @@ Status DiskRowSet::CheckRowPresent(const RowSetKeyProbe &probe,
   return Status::OK();
 }
 
+Status DiskRowSet::GetRow(const RowSetKeyProbe &probe,
+                          const MvccSnapshot &snap,
+                          RowBlock* dst,
+                          bool* present,
+                          ProbeStats* stats) const {
+  DCHECK(open_);
+  DCHECK_EQ(1, dst->row_capacity());
+  boost::shared_lock<rw_spinlock> lock(component_lock_.get_lock());
+
+  rowid_t row_idx;
+  RETURN_NOT_OK(base_data_->CheckRowPresent(probe, present, &row_idx, stats));
+  if (!*present) {
+    return Status::OK();
+  }
+
+  // Rather than scanning with a key range predicate, restrict the base data
+  // iterator to the single ordinal found above. The delta iterator seeks to
+  // the same ordinal on the first batch, so only deltas for this row are
+  // applied.
+  shared_ptr<CFileSet::Iterator> base_iter(base_data_->NewIterator(&dst->schema()));
+  gscoped_ptr<ColumnwiseIterator> col_iter;
+  RETURN_NOT_OK(delta_tracker_->WrapIterator(base_iter, snap, &col_iter));
+  MaterializingIterator iter(shared_ptr<ColumnwiseIterator>(col_iter.release()));
+  RETURN_NOT_OK(iter.Init(nullptr));
+  base_iter->SetOrdinalRange(row_idx, row_idx + 1);
+
+  RETURN_NOT_OK(iter.NextBlock(dst));
+  DCHECK_EQ(1, dst->nrows());
+  *present = dst->selection_vector()->IsRowSelected(0);
+  return Status::OK();
+}
+
 Status DiskRowSet::CountRows(rowid_t *count) const {
   DCHECK(open_);
   boost::shared_lock<rw_spinlock> lock(component_lock_.get_lock());
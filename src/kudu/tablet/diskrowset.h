@@ -307,6 +307,12 @@ class DiskRowSet : public RowSet {
                          bool *present,
                          ProbeStats* stats) const OVERRIDE;
 
+  Status GetRow(const RowSetKeyProbe &probe,
+                const MvccSnapshot &snap,
+                RowBlock* dst,
+                bool* present,
+                ProbeStats* stats) const OVERRIDE;
+
   ////////////////////
   // Read functions.
   ////////////////////
@@ -348,6 +354,21 @@ class DiskRowSet : public RowSet {
   // Major compacts all the delta files for all the columns.
   Status MajorCompactDeltaStores();
 
+  int64_t EstimateBytesInPotentiallyAncientUndoDeltas(
+      Timestamp ancient_history_mark) const OVERRIDE;
+
+  Status DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
+                                 int64_t* blocks_deleted,
+                                 int64_t* bytes_deleted) OVERRIDE;
+
+  // All rows have expired if the largest base value of the column is older
+  // than the cutoff, the column may not have been updated since, and no
+  // delta store holds history at or after the ancient history mark.
+  Status CheckAllRowsExpired(ColumnId col_id,
+                             int64_t cutoff_micros,
+                             Timestamp ancient_history_mark,
+                             bool* all_expired) const OVERRIDE;
+
   boost::mutex *compact_flush_lock() OVERRIDE {
     return &compact_flush_lock_;
   }
@@ -29,6 +29,7 @@
 #include "kudu/util/test_util.h"
 #include "kudu/util/thread.h"
 
+using std::string;
 using std::vector;
 using std::shared_ptr;
 
@@ -49,6 +50,13 @@ class LockManagerTest : public KuduTest {
               lock_manager_.TryLock(key, kFakeTransaction, LockManager::LOCK_EXCLUSIVE, &entry));
   }
 
+  void VerifyNotLocked(const Slice& key) {
+    LockEntry *entry;
+    ASSERT_EQ(LockManager::LOCK_ACQUIRED,
+              lock_manager_.TryLock(key, kFakeTransaction, LockManager::LOCK_EXCLUSIVE, &entry));
+    lock_manager_.Release(entry, LockManager::LOCK_ACQUIRED);
+  }
+
   LockManager lock_manager_;
 };
 
@@ -104,6 +112,56 @@ TEST_F(LockManagerTest, TestMoveLock) {
   ASSERT_FALSE(row_lock.acquired());
 }
 
+TEST_F(LockManagerTest, TestLockBatch) {
+  vector<Slice> keys = { Slice("a"), Slice("b"), Slice("c"), Slice("b") };
+  {
+    vector<ScopedRowLock> locks;
+    lock_manager_.LockBatch(keys, kFakeTransaction, LockManager::LOCK_EXCLUSIVE, &locks);
+    ASSERT_EQ(keys.size(), locks.size());
+    for (const Slice& key : keys) {
+      VerifyAlreadyLocked(key);
+    }
+
+    // Releasing one of the duplicates leaves the row locked.
+    locks[1].Release();
+    VerifyAlreadyLocked(keys[1]);
+    locks[3].Release();
+    VerifyNotLocked(keys[1]);
+  }
+
+  // All of the locks were released when going out of scope.
+  for (const Slice& key : keys) {
+    VerifyNotLocked(key);
+  }
+}
+
+// Concurrent batches over overlapping keys, given in different orders, must
+// not deadlock.
+TEST_F(LockManagerTest, TestConcurrentLockBatches) {
+  const int kNumKeys = 100;
+  vector<string> key_strs;
+  for (int i = 0; i < kNumKeys; i++) {
+    key_strs.push_back(StringPrintf("key%03d", i));
+  }
+  vector<boost::thread> threads;
+  for (int t = 0; t < FLAGS_num_test_threads; t++) {
+    threads.emplace_back([&, t]() {
+        vector<Slice> keys;
+        for (int i = 0; i < kNumKeys; i++) {
+          keys.push_back(key_strs[(i * (t + 1)) % kNumKeys]);
+        }
+        for (int i = 0; i < FLAGS_num_iterations / 10; i++) {
+          vector<ScopedRowLock> locks;
+          lock_manager_.LockBatch(keys, reinterpret_cast<TransactionState*>(t + 1),
+                                  LockManager::LOCK_EXCLUSIVE, &locks);
+        }
+      });
+  }
+  for (boost::thread& thread : threads) {
+    thread.join();
+  }
+}
+
 class LmTestResource {
  public:
   explicit LmTestResource(const Slice* id)
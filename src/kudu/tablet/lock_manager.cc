@@ -15,11 +15,13 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <algorithm>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
 #include <glog/logging.h>
 #include <string>
 #include <semaphore.h>
+#include <vector>
 
 #include "kudu/gutil/dynamic_annotations.h"
 #include "kudu/gutil/gscoped_ptr.h"
@@ -30,11 +32,31 @@
 #include "kudu/util/semaphore.h"
 #include "kudu/util/trace.h"
 
+using std::vector;
+
 namespace kudu {
 namespace tablet {
 
 class TransactionState;
 
+namespace {
+
+uint64_t HashKey(const Slice& key) {
+  return util_hash::CityHash64(reinterpret_cast<const char *>(key.data()), key.size());
+}
+
+// Orders hashes by their bits from least to most significant, i.e. as if
+// they were bit-reversed. Since the hash table picks buckets with the low
+// bits of the hash, hashes which map to the same bucket are contiguous in
+// this order, whatever the current table size.
+bool BucketOrderLess(uint64_t a, uint64_t b) {
+  uint64_t diff = a ^ b;
+  uint64_t lowest_diff_bit = diff & (~diff + 1);
+  return (a & lowest_diff_bit) < (b & lowest_diff_bit);
+}
+
+} // anonymous namespace
+
 // ============================================================================
 //  LockTable
 // ============================================================================
@@ -44,9 +66,13 @@ class TransactionState;
 class LockEntry {
  public:
   explicit LockEntry(const Slice& key)
+    : LockEntry(key, HashKey(key)) {
+  }
+
+  LockEntry(const Slice& key, uint64_t hash)
   : sem(1),
     recursion_(0) {
-    key_hash_ = util_hash::CityHash64(reinterpret_cast<const char *>(key.data()), key.size());
+    key_hash_ = hash;
     key_ = key;
     refs_ = 1;
   }
@@ -118,6 +144,16 @@ class LockTable {
   LockEntry *GetLockEntry(const Slice &key);
   void ReleaseLockEntry(LockEntry *entry);
 
+  // Looks up (or inserts) the entries for all of 'keys', whose hashes are
+  // given in 'hashes'. 'order' indexes 'keys' sorted by BucketOrderLess() on
+  // their hashes, so that each bucket is locked once per group of keys.
+  // The entry for keys[i] is stored in (*entries)[i]; each occurrence of a
+  // key takes its own reference on the shared entry.
+  void GetLockEntries(const vector<Slice>& keys,
+                      const vector<uint64_t>& hashes,
+                      const vector<int>& order,
+                      vector<LockEntry*>* entries);
+
  private:
   Bucket *FindBucket(uint64_t hash) const {
     return &(buckets_[hash & mask_]);
@@ -199,6 +235,50 @@ LockEntry *LockTable::GetLockEntry(const Slice& key) {
   return new_entry;
 }
 
+void LockTable::GetLockEntries(const vector<Slice>& keys,
+                               const vector<uint64_t>& hashes,
+                               const vector<int>& order,
+                               vector<LockEntry*>* entries) {
+  DCHECK_EQ(keys.size(), hashes.size());
+  DCHECK_EQ(keys.size(), order.size());
+  entries->resize(keys.size());
+  int num_new_entries = 0;
+
+  {
+    boost::shared_lock<rw_spinlock> table_rdlock(lock_.get_lock());
+    auto it = order.begin();
+    while (it != order.end()) {
+      Bucket *bucket = FindBucket(hashes[*it]);
+      boost::lock_guard<simple_spinlock> bucket_lock(bucket->lock);
+      for (; it != order.end() && FindBucket(hashes[*it]) == bucket; ++it) {
+        int i = *it;
+        LockEntry **node = FindSlot(bucket, keys[i], hashes[i]);
+        if (*node != nullptr) {
+          (*node)->refs_++;
+        } else {
+          // Unlike GetLockEntry(), only allocate on a miss. Entries are not
+          // allocated from the transaction's arena, since other transactions
+          // waiting on the same row share them and may outlive this one.
+          auto new_entry = new LockEntry(keys[i], hashes[i]);
+          new_entry->ht_next_ = nullptr;
+          new_entry->CopyKey();
+          *node = new_entry;
+          num_new_entries++;
+        }
+        (*entries)[i] = *node;
+      }
+    }
+  }
+
+  if (num_new_entries > 0 &&
+      base::subtle::NoBarrier_AtomicIncrement(&item_count_, num_new_entries) > size_) {
+    boost::unique_lock<percpu_rwlock> table_wrlock(lock_, boost::try_to_lock);
+    if (table_wrlock.owns_lock()) {
+      Resize();
+    }
+  }
+}
+
 void LockTable::ReleaseLockEntry(LockEntry *entry) {
   bool removed = false;
   {
@@ -280,6 +360,13 @@ ScopedRowLock::ScopedRowLock(LockManager *manager,
   }
 }
 
+ScopedRowLock::ScopedRowLock(LockManager* manager, LockEntry* entry)
+  : manager_(DCHECK_NOTNULL(manager)),
+    acquired_(true),
+    entry_(DCHECK_NOTNULL(entry)),
+    ls_(LockManager::LOCK_ACQUIRED) {
+}
+
 ScopedRowLock::ScopedRowLock(ScopedRowLock&& other) {
   TakeState(&other);
 }
@@ -328,11 +415,17 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
                                           LockManager::LockMode mode,
                                           LockEntry** entry) {
   *entry = locks_->GetLockEntry(key);
+  AcquireEntry(*entry, key, tx);
+  return LOCK_ACQUIRED;
+}
 
+void LockManager::AcquireEntry(LockEntry* entry,
+                               const Slice& key,
+                               const TransactionState* tx) {
   // We expect low contention, so just try to try_lock first. This is faster
   // than a timed_lock, since we don't have to do a syscall to get the current
   // time.
-  if (!(*entry)->sem.TryAcquire()) {
+  if (!entry->sem.TryAcquire()) {
     // If the current holder of this lock is the same transaction just return
     // a LOCK_ALREADY_ACQUIRED status without actually acquiring the mutex.
     //
@@ -342,9 +435,9 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     // obtained and released at the same time). If at any time in the future
     // we opt to perform more fine grained locking, possibly letting transactions
     // release a portion of the locks they no longer need, this no longer is OK.
-    if (ANNOTATE_UNPROTECTED_READ((*entry)->holder_) == tx) {
-      (*entry)->recursion_++;
-      return LOCK_ACQUIRED;
+    if (ANNOTATE_UNPROTECTED_READ(entry->holder_) == tx) {
+      entry->recursion_++;
+      return;
     }
 
     // If we couldn't immediately acquire the lock, do a timed lock so we can
@@ -354,8 +447,8 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     TRACE_COUNTER_INCREMENT("row_lock_wait_count", 1);
     MicrosecondsInt64 start_wait_us = GetMonoTimeMicros();
     int waited_seconds = 0;
-    while (!(*entry)->sem.TimedAcquire(MonoDelta::FromSeconds(1))) {
-      const TransactionState* cur_holder = ANNOTATE_UNPROTECTED_READ((*entry)->holder_);
+    while (!entry->sem.TimedAcquire(MonoDelta::FromSeconds(1))) {
+      const TransactionState* cur_holder = ANNOTATE_UNPROTECTED_READ(entry->holder_);
       LOG(WARNING) << "Waited " << (++waited_seconds) << " seconds to obtain row lock on key "
                    << key.ToDebugString() << " cur holder: " << cur_holder;
       // TODO: would be nice to also include some info about the blocking transaction,
@@ -369,8 +462,48 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     }
   }
 
-  (*entry)->holder_ = tx;
-  return LOCK_ACQUIRED;
+  entry->holder_ = tx;
+}
+
+void LockManager::LockBatch(const vector<Slice>& keys,
+                            const TransactionState* tx,
+                            LockManager::LockMode mode,
+                            vector<ScopedRowLock>* locks) {
+  vector<uint64_t> hashes(keys.size());
+  vector<int> order(keys.size());
+  for (int i = 0; i < keys.size(); i++) {
+    hashes[i] = HashKey(keys[i]);
+    order[i] = i;
+  }
+  // Sort by bucket, then by key so that duplicate keys are adjacent. This is
+  // also the order in which the locks are acquired.
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+      if (hashes[a] != hashes[b]) {
+        return BucketOrderLess(hashes[a], hashes[b]);
+      }
+      return keys[a].compare(keys[b]) < 0;
+    });
+
+  vector<LockEntry*> entries;
+  locks_->GetLockEntries(keys, hashes, order, &entries);
+
+  LockEntry* prev_entry = nullptr;
+  for (int i : order) {
+    LockEntry* entry = entries[i];
+    if (entry == prev_entry) {
+      // A duplicate key within the batch: we hold the lock already, so just
+      // count the recursion as Lock() would.
+      entry->recursion_++;
+      continue;
+    }
+    AcquireEntry(entry, keys[i], tx);
+    prev_entry = entry;
+  }
+
+  locks->reserve(locks->size() + keys.size());
+  for (LockEntry* entry : entries) {
+    locks->push_back(ScopedRowLock(this, entry));
+  }
 }
 
 LockManager::LockStatus LockManager::TryLock(const Slice& key,
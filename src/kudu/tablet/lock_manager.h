@@ -17,6 +17,8 @@
 #ifndef KUDU_TABLET_LOCK_MANAGER_H
 #define KUDU_TABLET_LOCK_MANAGER_H
 
+#include <vector>
+
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/move.h"
 #include "kudu/util/slice.h"
@@ -26,6 +28,7 @@ namespace kudu { namespace tablet {
 class LockManager;
 class LockTable;
 class LockEntry;
+class ScopedRowLock;
 class TransactionState;
 
 // Super-simple lock manager implementation. This only supports exclusive
@@ -49,6 +52,19 @@ class LockManager {
     LOCK_EXCLUSIVE
   };
 
+  // Locks all of the given keys on behalf of 'tx', blocking until every lock
+  // is held, and appends one ScopedRowLock per key to 'locks', in the same
+  // order as 'keys'. The 'keys' slices must remain valid and un-changed for
+  // the lifetime of the returned locks.
+  //
+  // This is equivalent to constructing a ScopedRowLock per key, but the keys
+  // are hashed and sorted up front so that the hash table lock is taken once
+  // and each bucket lock once per group of keys hashing to it. Since every
+  // batch acquires its locks in the same global order, concurrent batches
+  // cannot deadlock against each other. A key may appear more than once.
+  void LockBatch(const std::vector<Slice>& keys, const TransactionState* tx,
+                 LockMode mode, std::vector<ScopedRowLock>* locks);
+
  private:
   friend class ScopedRowLock;
   friend class LockManagerTest;
@@ -59,6 +75,10 @@ class LockManager {
                      LockMode mode, LockEntry **entry);
   void Release(LockEntry *lock, LockStatus ls);
 
+  // Blocks until the lock on 'entry' (whose key is 'key') is acquired on
+  // behalf of 'tx', or returns immediately if 'tx' already holds it.
+  void AcquireEntry(LockEntry* entry, const Slice& key, const TransactionState* tx);
+
   LockTable *locks_;
 
   DISALLOW_COPY_AND_ASSIGN(LockManager);
@@ -116,6 +136,11 @@ class ScopedRowLock {
   ~ScopedRowLock();
 
  private:
+  friend class LockManager;
+
+  // Adopt an entry which has already been locked by LockManager::LockBatch().
+  ScopedRowLock(LockManager* manager, LockEntry* entry);
+
   void TakeState(ScopedRowLock* other);
 
   LockManager *manager_;
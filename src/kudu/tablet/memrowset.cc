@@ -273,6 +273,32 @@ Status MemRowSet::CheckRowPresent(const RowSetKeyProbe &probe, bool *present,
   return Status::OK();
 }
 
+Status MemRowSet::GetRow(const RowSetKeyProbe &probe,
+                         const MvccSnapshot &snap,
+                         RowBlock* dst,
+                         bool* present,
+                         ProbeStats* stats) const {
+  DCHECK_EQ(1, dst->row_capacity());
+  stats->mrs_consulted++;
+
+  gscoped_ptr<Iterator> iter(NewIterator(&dst->schema(), snap));
+  RETURN_NOT_OK(iter->Init(nullptr));
+
+  // Seek the underlying tree iterator directly with the already-encoded key.
+  bool exact;
+  if (!iter->iter_->SeekAtOrAfter(probe.encoded_key_slice(), &exact) || !exact) {
+    *present = false;
+    return Status::OK();
+  }
+
+  // Rows which are uncommitted in 'snap' or deleted are returned unselected
+  // rather than skipped.
+  RETURN_NOT_OK(iter->NextBlock(dst));
+  DCHECK_EQ(1, dst->nrows());
+  *present = dst->selection_vector()->IsRowSelected(0);
+  return Status::OK();
+}
+
 MemRowSet::Iterator *MemRowSet::NewIterator(const Schema *projection,
                                             const MvccSnapshot &snap) const {
   return new MemRowSet::Iterator(shared_from_this(), tree_.NewIterator(),
@@ -458,6 +484,7 @@ Status MemRowSet::Iterator::NextBlock(RowBlock *dst) {
   if (dst->arena()) {
     dst->arena()->Reset();
   }
+  dst->ReleaseRetainedRefs();
 
   // Fill
   dst->selection_vector()->SetAllTrue();
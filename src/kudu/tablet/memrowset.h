@@ -245,6 +245,12 @@ class MemRowSet : public RowSet,
   Status CheckRowPresent(const RowSetKeyProbe &probe, bool *present,
                          ProbeStats* stats) const OVERRIDE;
 
+  Status GetRow(const RowSetKeyProbe &probe,
+                const MvccSnapshot &snap,
+                RowBlock* dst,
+                bool* present,
+                ProbeStats* stats) const OVERRIDE;
+
   // Return the memory footprint of this memrowset.
   // Note that this may be larger than the sum of the data
   // inserted into the memrowset, due to arena and data structure
@@ -331,6 +337,26 @@ class MemRowSet : public RowSet,
 
   Status MinorCompactDeltaStores() OVERRIDE { return Status::OK(); }
 
+  int64_t EstimateBytesInPotentiallyAncientUndoDeltas(
+      Timestamp ancient_history_mark) const OVERRIDE {
+    return 0;
+  }
+
+  Status DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
+                                 int64_t* blocks_deleted,
+                                 int64_t* bytes_deleted) OVERRIDE {
+    return Status::OK();
+  }
+
+  // Expired rows are dropped when the MemRowSet is flushed instead.
+  Status CheckAllRowsExpired(ColumnId col_id,
+                             int64_t cutoff_micros,
+                             Timestamp ancient_history_mark,
+                             bool* all_expired) const OVERRIDE {
+    *all_expired = false;
+    return Status::OK();
+  }
+
  private:
   friend class Iterator;
 
@@ -36,6 +36,14 @@ class MockRowSet : public RowSet {
     LOG(FATAL) << "Unimplemented";
     return Status::OK();
   }
+  virtual Status GetRow(const RowSetKeyProbe &probe,
+                        const MvccSnapshot &snap,
+                        RowBlock* dst,
+                        bool* present,
+                        ProbeStats* stats) const OVERRIDE {
+    LOG(FATAL) << "Unimplemented";
+    return Status::OK();
+  }
   virtual Status MutateRow(Timestamp timestamp,
                            const RowSetKeyProbe &probe,
                            const RowChangeList &update,
@@ -116,6 +124,27 @@ class MockRowSet : public RowSet {
     return Status::OK();
   }
 
+  virtual int64_t EstimateBytesInPotentiallyAncientUndoDeltas(
+      Timestamp ancient_history_mark) const OVERRIDE {
+    LOG(FATAL) << "Unimplemented";
+    return 0;
+  }
+
+  virtual Status DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
+                                         int64_t* blocks_deleted,
+                                         int64_t* bytes_deleted) OVERRIDE {
+    LOG(FATAL) << "Unimplemented";
+    return Status::OK();
+  }
+
+  virtual Status CheckAllRowsExpired(ColumnId col_id,
+                                     int64_t cutoff_micros,
+                                     Timestamp ancient_history_mark,
+                                     bool* all_expired) const OVERRIDE {
+    LOG(FATAL) << "Unimplemented";
+    return Status::OK();
+  }
+
   virtual bool IsAvailableForCompaction() OVERRIDE {
     return true;
   }
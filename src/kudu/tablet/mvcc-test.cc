@@ -15,16 +15,23 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <algorithm>
 #include <boost/thread/thread.hpp>
 #include <gtest/gtest.h>
 #include <glog/logging.h>
+#include <vector>
 
 #include "kudu/server/hybrid_clock.h"
 #include "kudu/server/logical_clock.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/stopwatch.h"
 #include "kudu/util/test_util.h"
 
+DEFINE_int32(mvcc_bench_num_txns, 100000,
+             "Number of transactions in the mvcc benchmark");
+
 namespace kudu {
 namespace tablet {
 
@@ -265,6 +272,29 @@ TEST_F(MvccTest, TestScopedTransaction) {
   ASSERT_FALSE(snap.IsCommitted(Timestamp(2)));
 }
 
+// Committing a run of transactions at once makes all of them visible and
+// advances the clean time.
+TEST_F(MvccTest, TestCommitAll) {
+  MvccManager mgr(clock_.get());
+  MvccSnapshot snap;
+
+  ScopedTransaction t1(&mgr);
+  ScopedTransaction t2(&mgr);
+  ScopedTransaction t3(&mgr);
+  t1.StartApplying();
+  t2.StartApplying();
+  ScopedTransaction::CommitAll({ &t1, &t2 });
+
+  // Committing again is a no-op.
+  t1.Commit();
+
+  mgr.TakeSnapshot(&snap);
+  ASSERT_TRUE(snap.IsCommitted(t1.timestamp()));
+  ASSERT_TRUE(snap.IsCommitted(t2.timestamp()));
+  ASSERT_FALSE(snap.IsCommitted(t3.timestamp()));
+  ASSERT_EQ(t2.timestamp(), mgr.GetCleanTimestamp());
+}
+
 TEST_F(MvccTest, TestPointInTimeSnapshot) {
   MvccSnapshot snap(Timestamp(10));
 
@@ -277,8 +307,8 @@ TEST_F(MvccTest, TestPointInTimeSnapshot) {
 TEST_F(MvccTest, TestMayHaveCommittedTransactionsAtOrAfter) {
   MvccSnapshot snap;
   snap.all_committed_before_ = Timestamp(10);
-  snap.committed_timestamps_.push_back(11);
-  snap.committed_timestamps_.push_back(13);
+  snap.mutable_committed_timestamps()->push_back(11);
+  snap.mutable_committed_timestamps()->push_back(13);
   snap.none_committed_at_or_after_ = Timestamp(14);
 
   ASSERT_TRUE(snap.MayHaveCommittedTransactionsAtOrAfter(Timestamp(9)));
@@ -313,8 +343,8 @@ TEST_F(MvccTest, TestMayHaveCommittedTransactionsAtOrAfter) {
 TEST_F(MvccTest, TestMayHaveUncommittedTransactionsBefore) {
   MvccSnapshot snap;
   snap.all_committed_before_ = Timestamp(10);
-  snap.committed_timestamps_.push_back(11);
-  snap.committed_timestamps_.push_back(13);
+  snap.mutable_committed_timestamps()->push_back(11);
+  snap.mutable_committed_timestamps()->push_back(13);
   snap.none_committed_at_or_after_ = Timestamp(14);
 
   ASSERT_FALSE(snap.MayHaveUncommittedTransactionsAtOrBefore(Timestamp(9)));
@@ -353,7 +383,7 @@ TEST_F(MvccTest, TestMayHaveUncommittedTransactionsBefore) {
   // still report that there can't be any uncommitted transactions before.
   MvccSnapshot snap2;
   snap2.all_committed_before_ = Timestamp(10);
-  snap2.committed_timestamps_.push_back(10);
+  snap2.mutable_committed_timestamps()->push_back(10);
 
   ASSERT_FALSE(snap2.MayHaveUncommittedTransactionsAtOrBefore(Timestamp(10)));
 }
@@ -615,5 +645,148 @@ TEST_F(MvccTest, TestWaitUntilCleanDeadline) {
   ASSERT_TRUE(s.IsTimedOut()) << s.ToString();
 }
 
+// The leader's safe time stays below its in-flight transactions, and no new
+// transaction may start at or below it.
+TEST_F(MvccTest, TestGetSafeTimeForFollowers) {
+  MvccManager mgr(clock_.get());
+  mgr.AdvanceLeaderSafeTime();
+  Timestamp tx1 = mgr.StartTransaction();
+  Timestamp safe_time = mgr.GetSafeTimeForFollowers();
+  ASSERT_LT(safe_time.value(), tx1.value());
+
+  // The safe time can't pass the in-flight transaction.
+  mgr.AdvanceLeaderSafeTime();
+  safe_time = mgr.GetSafeTimeForFollowers();
+  ASSERT_EQ(tx1.value() - 1, safe_time.value());
+
+  // Committing the transaction moves the safe time up to it.
+  mgr.StartApplyingTransaction(tx1);
+  mgr.CommitTransaction(tx1);
+  safe_time = mgr.GetSafeTimeForFollowers();
+  ASSERT_EQ(tx1.value(), safe_time.value());
+
+  // Reading the safe time doesn't move it.
+  ASSERT_EQ(safe_time.value(), mgr.GetSafeTimeForFollowers().value());
+
+  mgr.AdvanceLeaderSafeTime();
+  safe_time = mgr.GetSafeTimeForFollowers();
+  ASSERT_GT(safe_time.value(), tx1.value());
+  ASSERT_TRUE(mgr.StartTransactionAtTimestamp(safe_time).IsIllegalState());
+  ASSERT_GT(mgr.StartTransaction().value(), safe_time.value());
+}
+
+// A follower snapshot waits for both the safe time sent by the leader and
+// the transactions started below it.
+TEST_F(MvccTest, TestWaitForFollowerSnapshot) {
+  MvccManager mgr(clock_.get());
+  Timestamp tx1 = clock_->Now();
+  ASSERT_OK(mgr.StartTransactionAtTimestamp(tx1));
+  Timestamp snap_ts = clock_->Now();
+
+  MonoTime deadline = MonoTime::Now(MonoTime::FINE);
+  deadline.AddDelta(MonoDelta::FromMilliseconds(10));
+  MvccSnapshot snap;
+  Status s = mgr.WaitForFollowerSnapshotAtTimestamp(snap_ts, &snap, deadline);
+  ASSERT_TRUE(s.IsTimedOut()) << s.ToString();
+
+  // Even with the safe time past 'snap_ts', 'tx1' is still in flight.
+  mgr.AdvanceFollowerSafeTime(snap_ts);
+  deadline = MonoTime::Now(MonoTime::FINE);
+  deadline.AddDelta(MonoDelta::FromMilliseconds(10));
+  s = mgr.WaitForFollowerSnapshotAtTimestamp(snap_ts, &snap, deadline);
+  ASSERT_TRUE(s.IsTimedOut()) << s.ToString();
+
+  mgr.StartApplyingTransaction(tx1);
+  mgr.OfflineAdjustSafeTime(tx1);
+  mgr.OfflineCommitTransaction(tx1);
+  ASSERT_OK(mgr.WaitForFollowerSnapshotAtTimestamp(snap_ts, &snap, MonoTime::Max()));
+  ASSERT_TRUE(snap.IsCommitted(tx1));
+  ASSERT_FALSE(snap.IsCommitted(snap_ts));
+}
+
+// Snapshots share their committed set with the manager until it changes.
+TEST_F(MvccTest, TestSnapshotCopyOnWrite) {
+  MvccManager mgr(clock_.get());
+  Timestamp tx1 = mgr.StartTransaction();
+  Timestamp tx2 = mgr.StartTransaction();
+  mgr.StartApplyingTransaction(tx2);
+  mgr.CommitTransaction(tx2);
+
+  MvccSnapshot snap(mgr);
+  ASSERT_EQ(mgr.cur_snap_.committed_timestamps_.get(), snap.committed_timestamps_.get());
+  ASSERT_TRUE(snap.IsCommitted(tx2));
+
+  // Committing tx1 modifies the manager's set, but not the snapshot's.
+  mgr.StartApplyingTransaction(tx1);
+  mgr.CommitTransaction(tx1);
+  ASSERT_FALSE(snap.IsCommitted(tx1));
+  ASSERT_TRUE(snap.IsCommitted(tx2));
+  ASSERT_TRUE(mgr.cur_snap_.IsCommitted(tx1));
+}
+
+// Measures the operations whose cost depends on how many transactions are
+// in flight or committed out of order: committing the earliest of many
+// in-flight transactions, taking snapshots while a long-running transaction
+// holds back the clean time, and committing while such snapshots are alive.
+TEST_F(MvccTest, BenchmarkWithManyTransactions) {
+  OverrideFlagForSlowTests("mvcc_bench_num_txns",
+                           strings::Substitute("$0", FLAGS_mvcc_bench_num_txns * 10));
+  const int num_txns = FLAGS_mvcc_bench_num_txns;
+  MvccManager mgr(clock_.get());
+
+  // Every commit is of the earliest in-flight transaction, and advances the
+  // clean time to the next one.
+  std::vector<Timestamp> txns;
+  for (int i = 0; i < num_txns; i++) {
+    txns.push_back(mgr.StartTransaction());
+  }
+  LOG_TIMING(INFO, strings::Substitute("committing $0 in-flight transactions in order",
+                                       num_txns)) {
+    for (Timestamp txn : txns) {
+      mgr.StartApplyingTransaction(txn);
+      mgr.CommitTransaction(txn);
+    }
+  }
+  ASSERT_EQ(0, mgr.CountTransactionsInFlight());
+  ASSERT_TRUE(MvccSnapshot(mgr).IsCommitted(txns.back()));
+
+  // Behind a long-running transaction, every commit is kept in the committed
+  // set, which snapshots share.
+  Timestamp long_txn = mgr.StartTransaction();
+  txns.clear();
+  for (int i = 0; i < num_txns; i++) {
+    ScopedTransaction txn(&mgr);
+    txn.StartApplying();
+    txn.Commit();
+    txns.push_back(txn.timestamp());
+  }
+  LOG_TIMING(INFO, strings::Substitute("taking $0 snapshots of $1 committed transactions",
+                                       num_txns, num_txns)) {
+    for (int i = 0; i < num_txns; i++) {
+      MvccSnapshot snap(mgr);
+    }
+  }
+
+  // A commit made while a snapshot is alive copies the committed set.
+  const int num_copying_commits = std::min(num_txns, 1000);
+  LOG_TIMING(INFO, strings::Substitute("committing $0 transactions, each with a live snapshot",
+                                       num_copying_commits)) {
+    for (int i = 0; i < num_copying_commits; i++) {
+      MvccSnapshot snap(mgr);
+      ScopedTransaction txn(&mgr);
+      txn.StartApplying();
+      txn.Commit();
+    }
+  }
+
+  MvccSnapshot snap(mgr);
+  ASSERT_FALSE(snap.IsCommitted(long_txn));
+  ASSERT_TRUE(snap.IsCommitted(txns.front()));
+  ASSERT_TRUE(snap.IsCommitted(txns.back()));
+  mgr.StartApplyingTransaction(long_txn);
+  mgr.CommitTransaction(long_txn);
+  ASSERT_EQ(0, mgr.CountTransactionsInFlight());
+}
+
 } // namespace tablet
 } // namespace kudu
@@ -16,6 +16,7 @@
 // under the License.
 
 #include <algorithm>
+#include <atomic>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
 #include <glog/logging.h>
@@ -37,6 +38,8 @@ namespace kudu { namespace tablet {
 MvccManager::MvccManager(const scoped_refptr<server::Clock>& clock)
   : no_new_transactions_at_or_before_(Timestamp::kMin),
     earliest_in_flight_(Timestamp::kMax),
+    follower_safe_time_(Timestamp::kMin),
+    clean_time_(Timestamp::kInitialTimestamp.value()),
     clock_(clock) {
   cur_snap_.all_committed_before_ = Timestamp::kInitialTimestamp;
   cur_snap_.none_committed_at_or_after_ = Timestamp::kInitialTimestamp;
@@ -66,8 +69,7 @@ Timestamp MvccManager::StartTransactionAtLatest() {
   // timestamps at all times
 #ifndef NDEBUG
   if (!timestamps_in_flight_.empty()) {
-    Timestamp max(std::max_element(timestamps_in_flight_.begin(),
-                                   timestamps_in_flight_.end())->first);
+    Timestamp max(timestamps_in_flight_.rbegin()->first);
     CHECK_EQ(max.value(), now_latest.value());
   }
 #endif
@@ -179,6 +181,28 @@ void MvccManager::OfflineCommitTransaction(Timestamp timestamp) {
   }
 }
 
+void MvccManager::CommitTransactions(const std::vector<Timestamp>& timestamps, bool offline) {
+  if (timestamps.empty()) return;
+  boost::lock_guard<LockType> l(lock_);
+
+  bool any_was_earliest = false;
+  for (Timestamp timestamp : timestamps) {
+    bool was_earliest = false;
+    CommitTransactionUnlocked(timestamp, &was_earliest);
+    any_was_earliest |= was_earliest;
+    if (!offline && no_new_transactions_at_or_before_.CompareTo(timestamp) < 0) {
+      no_new_transactions_at_or_before_ = timestamp;
+    }
+  }
+
+  // See OfflineCommitTransaction(): offline commits only adjust the clean time
+  // once the safe time has caught up with them.
+  if (any_was_earliest &&
+      (!offline || no_new_transactions_at_or_before_.CompareTo(timestamps.front()) >= 0)) {
+    AdjustCleanTime();
+  }
+}
+
 MvccManager::TxnState MvccManager::RemoveInFlightAndGetStateUnlocked(Timestamp ts) {
   DCHECK(lock_.is_locked());
 
@@ -220,11 +244,15 @@ void MvccManager::AdvanceEarliestInFlightTimestamp() {
   if (timestamps_in_flight_.empty()) {
     earliest_in_flight_ = Timestamp::kMax;
   } else {
-    earliest_in_flight_ = Timestamp(std::min_element(timestamps_in_flight_.begin(),
-                                                     timestamps_in_flight_.end())->first);
+    earliest_in_flight_ = Timestamp(timestamps_in_flight_.begin()->first);
   }
 }
 
+void MvccManager::SetCleanTimeUnlocked(Timestamp clean_time) {
+  cur_snap_.all_committed_before_ = clean_time;
+  clean_time_.Store(clean_time.value(), kMemOrderRelease);
+}
+
 void MvccManager::OfflineAdjustSafeTime(Timestamp safe_time) {
   boost::lock_guard<LockType> l(lock_);
 
@@ -237,6 +265,34 @@ void MvccManager::OfflineAdjustSafeTime(Timestamp safe_time) {
   AdjustCleanTime();
 }
 
+Timestamp MvccManager::GetSafeTimeForFollowers() const {
+  boost::lock_guard<LockType> l(lock_);
+  Timestamp safe_time = no_new_transactions_at_or_before_;
+  if (earliest_in_flight_.CompareTo(safe_time) <= 0) {
+    safe_time = Timestamp(earliest_in_flight_.value() - 1);
+  }
+  return safe_time;
+}
+
+void MvccManager::AdvanceLeaderSafeTime() {
+  Timestamp now = clock_->Now();
+  boost::lock_guard<LockType> l(lock_);
+
+  // Transactions which read the clock before we did but haven't registered
+  // yet must not start at or below 'now': they'll retry with a newer timestamp.
+  if (no_new_transactions_at_or_before_.CompareTo(now) < 0) {
+    no_new_transactions_at_or_before_ = now;
+  }
+}
+
+void MvccManager::AdvanceFollowerSafeTime(Timestamp safe_time) {
+  boost::lock_guard<LockType> l(lock_);
+  if (follower_safe_time_.CompareTo(safe_time) < 0) {
+    follower_safe_time_ = safe_time;
+    WakeWaitersUnlocked();
+  }
+}
+
 // Remove any elements from 'v' which are < the given watermark.
 static void FilterTimestamps(std::vector<Timestamp::val_type>* v,
                              Timestamp::val_type watermark) {
@@ -265,15 +321,22 @@ void MvccManager::AdjustCleanTime() {
   // than the new watermark.
 
   if (earliest_in_flight_.CompareTo(no_new_transactions_at_or_before_) < 0) {
-    cur_snap_.all_committed_before_ = earliest_in_flight_;
+    SetCleanTimeUnlocked(earliest_in_flight_);
   } else {
-    cur_snap_.all_committed_before_ = no_new_transactions_at_or_before_;
+    SetCleanTimeUnlocked(no_new_transactions_at_or_before_);
   }
 
   // Filter out any committed timestamps that now fall below the watermark
-  FilterTimestamps(&cur_snap_.committed_timestamps_, cur_snap_.all_committed_before_.value());
+  if (!cur_snap_.is_clean()) {
+    FilterTimestamps(cur_snap_.mutable_committed_timestamps(),
+                     cur_snap_.all_committed_before_.value());
+  }
 
   // it may also have unblocked some waiters.
+  WakeWaitersUnlocked();
+}
+
+void MvccManager::WakeWaitersUnlocked() {
   // Check if someone is waiting for transactions to be committed.
   if (PREDICT_FALSE(!waiters_.empty())) {
     auto iter = waiters_.begin();
@@ -292,7 +355,8 @@ void MvccManager::AdjustCleanTime() {
 Status MvccManager::WaitUntil(WaitFor wait_for, Timestamp ts,
                               const MonoTime& deadline) const {
   TRACE_EVENT2("tablet", "MvccManager::WaitUntil",
-               "wait_for", wait_for == ALL_COMMITTED ? "all_committed" : "none_applying",
+               "wait_for", wait_for == ALL_COMMITTED ? "all_committed" :
+                           wait_for == NONE_APPLYING ? "none_applying" : "follower_safe",
                "ts", ts.ToUint64())
 
   CountDownLatch latch(1);
@@ -322,7 +386,7 @@ Status MvccManager::WaitUntil(WaitFor wait_for, Timestamp ts,
   return Status::TimedOut(strings::Substitute(
       "Timed out waiting for all transactions with ts < $0 to $1",
       clock_->Stringify(ts),
-      wait_for == ALL_COMMITTED ? "commit" : "finish applying"));
+      wait_for == NONE_APPLYING ? "finish applying" : "commit"));
 }
 
 bool MvccManager::IsDoneWaitingUnlocked(const WaitingState& waiter) const {
@@ -331,6 +395,8 @@ bool MvccManager::IsDoneWaitingUnlocked(const WaitingState& waiter) const {
       return AreAllTransactionsCommittedUnlocked(waiter.timestamp);
     case NONE_APPLYING:
       return !AnyApplyingAtOrBeforeUnlocked(waiter.timestamp);
+    case FOLLOWER_SAFE:
+      return IsFollowerSafeUnlocked(waiter.timestamp);
   }
   LOG(FATAL); // unreachable
 }
@@ -345,16 +411,18 @@ bool MvccManager::AreAllTransactionsCommittedUnlocked(Timestamp ts) const {
   return !cur_snap_.MayHaveUncommittedTransactionsAtOrBefore(ts);
 }
 
+bool MvccManager::IsFollowerSafeUnlocked(Timestamp ts) const {
+  return follower_safe_time_.CompareTo(ts) >= 0 &&
+      earliest_in_flight_.CompareTo(ts) >= 0;
+}
+
 bool MvccManager::AnyApplyingAtOrBeforeUnlocked(Timestamp ts) const {
-  for (const InFlightMap::value_type entry : timestamps_in_flight_) {
-    if (entry.first <= ts.value()) {
-      return true;
-    }
-  }
-  return false;
+  return !timestamps_in_flight_.empty() &&
+      timestamps_in_flight_.begin()->first <= ts.value();
 }
 
 void MvccManager::TakeSnapshot(MvccSnapshot *snap) const {
+  // Copying the snapshot only takes a reference on its committed set.
   boost::lock_guard<LockType> l(lock_);
   *snap = cur_snap_;
 }
@@ -369,6 +437,15 @@ Status MvccManager::WaitForCleanSnapshotAtTimestamp(Timestamp timestamp,
   return Status::OK();
 }
 
+Status MvccManager::WaitForFollowerSnapshotAtTimestamp(Timestamp timestamp,
+                                                       MvccSnapshot *snap,
+                                                       const MonoTime& deadline) const {
+  TRACE_EVENT0("tablet", "MvccManager::WaitForFollowerSnapshotAtTimestamp");
+  RETURN_NOT_OK(WaitUntil(FOLLOWER_SAFE, timestamp, deadline));
+  *snap = MvccSnapshot(timestamp);
+  return Status::OK();
+}
+
 void MvccManager::WaitForCleanSnapshot(MvccSnapshot* snap) const {
   CHECK_OK(WaitForCleanSnapshotAtTimestamp(clock_->Now(), snap, MonoTime::Max()));
 }
@@ -380,9 +457,10 @@ void MvccManager::WaitForApplyingTransactionsToCommit() const {
   Timestamp wait_for = Timestamp::kMin;
   {
     boost::lock_guard<LockType> l(lock_);
-    for (const InFlightMap::value_type entry : timestamps_in_flight_) {
-      if (entry.second == APPLYING) {
-        wait_for = Timestamp(std::max(entry.first, wait_for.value()));
+    for (auto it = timestamps_in_flight_.rbegin(); it != timestamps_in_flight_.rend(); ++it) {
+      if (it->second == APPLYING) {
+        wait_for = Timestamp(it->first);
+        break;
       }
     }
   }
@@ -409,8 +487,7 @@ int MvccManager::CountTransactionsInFlight() const {
 }
 
 Timestamp MvccManager::GetCleanTimestamp() const {
-  boost::lock_guard<LockType> l(lock_);
-  return cur_snap_.all_committed_before_;
+  return Timestamp(clean_time_.Load(kMemOrderAcquire));
 }
 
 void MvccManager::GetApplyingTransactionsTimestamps(std::vector<Timestamp>* timestamps) const {
@@ -454,7 +531,8 @@ MvccSnapshot MvccSnapshot::CreateSnapshotIncludingNoTransactions() {
 }
 
 bool MvccSnapshot::IsCommittedFallback(const Timestamp& timestamp) const {
-  for (const Timestamp::val_type& v : committed_timestamps_) {
+  if (!committed_timestamps_) return false;
+  for (const Timestamp::val_type& v : *committed_timestamps_) {
     if (v == timestamp.value()) return true;
   }
 
@@ -477,7 +555,7 @@ bool MvccSnapshot::MayHaveUncommittedTransactionsAtOrBefore(const Timestamp& tim
 std::string MvccSnapshot::ToString() const {
   string ret("MvccSnapshot[committed={T|");
 
-  if (committed_timestamps_.size() == 0) {
+  if (is_clean()) {
     StrAppend(&ret, "T < ", all_committed_before_.ToString(),"}]");
     return ret;
   }
@@ -485,7 +563,7 @@ std::string MvccSnapshot::ToString() const {
             " or (T in {");
 
   bool first = true;
-  for (Timestamp::val_type t : committed_timestamps_) {
+  for (Timestamp::val_type t : *committed_timestamps_) {
     if (!first) {
       ret.push_back(',');
     }
@@ -505,7 +583,7 @@ void MvccSnapshot::AddCommittedTimestamps(const std::vector<Timestamp>& timestam
 void MvccSnapshot::AddCommittedTimestamp(Timestamp timestamp) {
   if (IsCommitted(timestamp)) return;
 
-  committed_timestamps_.push_back(timestamp.value());
+  mutable_committed_timestamps()->push_back(timestamp.value());
 
   // If this is a new upper bound commit mark, update it.
   if (none_committed_at_or_after_.CompareTo(timestamp) <= 0) {
@@ -513,6 +591,20 @@ void MvccSnapshot::AddCommittedTimestamp(Timestamp timestamp) {
   }
 }
 
+std::vector<Timestamp::val_type>* MvccSnapshot::mutable_committed_timestamps() {
+  if (!committed_timestamps_) {
+    committed_timestamps_ = std::make_shared<std::vector<Timestamp::val_type>>();
+  } else if (!committed_timestamps_.unique()) {
+    committed_timestamps_ = std::make_shared<std::vector<Timestamp::val_type>>(
+        *committed_timestamps_);
+  } else {
+    // Another snapshot may have just dropped its reference; make sure its
+    // reads of the vector happen before our writes.
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+  return committed_timestamps_.get();
+}
+
 ////////////////////////////////////////////////////////////
 // ScopedTransaction
 ////////////////////////////////////////////////////////////
@@ -556,6 +648,10 @@ void ScopedTransaction::StartApplying() {
 }
 
 void ScopedTransaction::Commit() {
+  if (done_) {
+    // Already committed by CommitAll().
+    return;
+  }
   switch (assignment_type_) {
     case NOW:
     case NOW_LATEST: {
@@ -574,6 +670,25 @@ void ScopedTransaction::Commit() {
   done_ = true;
 }
 
+void ScopedTransaction::CommitAll(const std::vector<ScopedTransaction*>& txns) {
+  if (txns.empty()) return;
+  MvccManager* manager = txns.front()->manager_;
+  std::vector<Timestamp> online;
+  std::vector<Timestamp> offline;
+  for (ScopedTransaction* txn : txns) {
+    DCHECK_EQ(manager, txn->manager_);
+    DCHECK(!txn->done_);
+    if (txn->assignment_type_ == PRE_ASSIGNED) {
+      offline.push_back(txn->timestamp_);
+    } else {
+      online.push_back(txn->timestamp_);
+    }
+    txn->done_ = true;
+  }
+  manager->CommitTransactions(online, false);
+  manager->CommitTransactions(offline, true);
+}
+
 void ScopedTransaction::Abort() {
   manager_->AbortTransaction(timestamp_);
   done_ = true;
@@ -18,12 +18,14 @@
 #define KUDU_TABLET_MVCC_H
 
 #include <gtest/gtest_prod.h>
+#include <map>
+#include <memory>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/server/clock.h"
+#include "kudu/util/atomic.h"
 #include "kudu/util/locks.h"
 
 namespace kudu {
@@ -96,7 +98,13 @@ class MvccSnapshot {
   // transactions with timestamps less than some timestamp to be committed,
   // and all other transactions to be uncommitted.
   bool is_clean() const {
-    return committed_timestamps_.empty();
+    return !committed_timestamps_ || committed_timestamps_->empty();
+  }
+
+  // Return the timestamp at and after which no transactions are considered
+  // committed. For a snapshot at a specific Timestamp, this is that timestamp.
+  Timestamp none_committed_at_or_after() const {
+    return none_committed_at_or_after_;
   }
 
   // Consider the given list of timestamps to be committed in this snapshot,
@@ -111,11 +119,16 @@ class MvccSnapshot {
   FRIEND_TEST(MvccTest, TestMayHaveCommittedTransactionsAtOrAfter);
   FRIEND_TEST(MvccTest, TestMayHaveUncommittedTransactionsBefore);
   FRIEND_TEST(MvccTest, TestWaitUntilAllCommitted_SnapAtTimestampWithInFlights);
+  FRIEND_TEST(MvccTest, TestSnapshotCopyOnWrite);
 
   bool IsCommittedFallback(const Timestamp& timestamp) const;
 
   void AddCommittedTimestamp(Timestamp timestamp);
 
+  // Returns a mutable 'committed_timestamps_', first copying it if it is
+  // shared with another snapshot.
+  std::vector<Timestamp::val_type>* mutable_committed_timestamps();
+
   // Summary rule:
   //   A transaction T is committed if and only if:
   //      T < all_committed_before_ or
@@ -147,7 +160,11 @@ class MvccSnapshot {
   // rarely consulted (most data will be culled by 'all_committed_before_'
   // or none_committed_at_or_after_. So, using the compact vector structure fits
   // the whole thing on one or two cache lines, and it ends up going faster.
-  std::vector<Timestamp::val_type> committed_timestamps_;
+  //
+  // The vector is shared by copies of the snapshot and copied only when a
+  // shared instance is modified, so that taking a snapshot of the
+  // MvccManager's current state doesn't copy it. NULL if empty.
+  std::shared_ptr<std::vector<Timestamp::val_type>> committed_timestamps_;
 
 };
 
@@ -239,10 +256,37 @@ class MvccManager {
   // StartApplyingTransaction(), or else this logs a FATAL error.
   void OfflineCommitTransaction(Timestamp timestamp);
 
+  // Like calling CommitTransaction() (or OfflineCommitTransaction() if
+  // 'offline' is true) on each of 'timestamps', but takes the lock and
+  // adjusts the clean time only once. Used to commit a run of transactions
+  // which were applied together.
+  void CommitTransactions(const std::vector<Timestamp>& timestamps, bool offline);
+
   // Used in conjunction with OfflineCommitTransaction() so that the mvcc
   // manager can trim state.
   void OfflineAdjustSafeTime(Timestamp safe_time);
 
+  // Returns a timestamp at or below which every transaction started by this
+  // (leader) replica has committed, and at or below which no new transaction
+  // will start. Used by the leader to compute the safe time it propagates to
+  // its followers.
+  //
+  // The safe time only moves forward as transactions commit, or when
+  // AdvanceLeaderSafeTime() is called.
+  Timestamp GetSafeTimeForFollowers() const;
+
+  // Prevents new transactions from starting at or below the current time,
+  // so that the safe time returned by GetSafeTimeForFollowers() keeps moving
+  // forward while no transaction commits. Called periodically by the leader.
+  void AdvanceLeaderSafeTime();
+
+  // Advances the follower safe time, i.e. the timestamp at or below which,
+  // according to the leader, every transaction has been started on this
+  // replica. Unlike OfflineAdjustSafeTime(), this doesn't prevent
+  // transactions with lower timestamps from starting: it only unblocks
+  // WaitForFollowerSnapshotAtTimestamp().
+  void AdvanceFollowerSafeTime(Timestamp safe_time);
+
   // Take a snapshot of the current MVCC state, which indicates which
   // transactions have been committed at the time of this call.
   void TakeSnapshot(MvccSnapshot *snapshot) const;
@@ -263,6 +307,14 @@ class MvccManager {
                                          MvccSnapshot* snapshot,
                                          const MonoTime& deadline) const WARN_UNUSED_RESULT;
 
+  // Like WaitForCleanSnapshotAtTimestamp(), but for replicas which are not
+  // the leader. The local clock doesn't tell a follower which transactions
+  // the leader has yet to send it, so this also waits for the follower safe
+  // time to reach 'timestamp'.
+  Status WaitForFollowerSnapshotAtTimestamp(Timestamp timestamp,
+                                            MvccSnapshot* snapshot,
+                                            const MonoTime& deadline) const WARN_UNUSED_RESULT;
+
   // Take a snapshot at the current timestamp, and then wait for any
   // currently running transactions at an earlier timestamp to finish.
   //
@@ -309,6 +361,7 @@ class MvccManager {
   FRIEND_TEST(MvccTest, TestTxnAbort);
   FRIEND_TEST(MvccTest, TestCleanTimeCoalescingOnOfflineTransactions);
   FRIEND_TEST(MvccTest, TestWaitForApplyingTransactionsToCommit);
+  FRIEND_TEST(MvccTest, TestSnapshotCopyOnWrite);
 
   enum TxnState {
     RESERVED,
@@ -319,7 +372,8 @@ class MvccManager {
 
   enum WaitFor {
     ALL_COMMITTED,
-    NONE_APPLYING
+    NONE_APPLYING,
+    FOLLOWER_SAFE
   };
 
   struct WaitingState {
@@ -338,6 +392,10 @@ class MvccManager {
   // less than or equal to 'ts'.
   bool AnyApplyingAtOrBeforeUnlocked(Timestamp ts) const;
 
+  // Return true if the follower safe time has reached 'ts' and all the
+  // transactions before 'ts' which were started are committed.
+  bool IsFollowerSafeUnlocked(Timestamp ts) const;
+
   // Waits until all transactions before the given time are committed.
   Status WaitUntil(WaitFor wait_for, Timestamp ts,
                    const MonoTime& deadline) const WARN_UNUSED_RESULT;
@@ -361,23 +419,37 @@ class MvccManager {
   // currently in flight and on what is the latest value of 'no_new_transactions_at_or_before_'.
   void AdjustCleanTime();
 
+  // Wakes up the waiters whose condition has been achieved.
+  void WakeWaitersUnlocked();
+
   // Advances the earliest in-flight timestamp, based on which transactions are
   // currently in-flight. Usually called when the previous earliest transaction
   // commits or aborts.
   void AdvanceEarliestInFlightTimestamp();
 
+  // Sets 'cur_snap_.all_committed_before_', also publishing it for lock-free
+  // readers of GetCleanTimestamp().
+  void SetCleanTimeUnlocked(Timestamp clean_time);
+
   int GetNumWaitersForTests() const {
     lock_guard<simple_spinlock> l(&lock_);
     return waiters_.size();
   }
 
+  // Protects all of the state below except 'clean_time_'. Every transaction
+  // takes it when it starts, starts applying and commits, and so do
+  // snapshots: the critical sections are kept short instead of sharding it.
   typedef simple_spinlock LockType;
   mutable LockType lock_;
 
   MvccSnapshot cur_snap_;
 
   // The set of timestamps corresponding to currently in-flight transactions.
-  typedef std::unordered_map<Timestamp::val_type, TxnState> InFlightMap;
+  //
+  // Ordered, so that the earliest in-flight transaction and the applying
+  // transactions at or before a given timestamp can be found without
+  // scanning every transaction in flight.
+  typedef std::map<Timestamp::val_type, TxnState> InFlightMap;
   InFlightMap timestamps_in_flight_;
 
   // A transaction ID below which all transactions are either committed or in-flight,
@@ -390,6 +462,13 @@ class MvccManager {
   // over timestamps_in_flight_ on every commit.
   Timestamp earliest_in_flight_;
 
+  // The safe time last received from the leader. See AdvanceFollowerSafeTime().
+  Timestamp follower_safe_time_;
+
+  // A copy of 'cur_snap_.all_committed_before_' which may be read without
+  // holding 'lock_'.
+  AtomicInt<Timestamp::val_type> clean_time_;
+
   scoped_refptr<server::Clock> clock_;
   mutable std::vector<WaitingState*> waiters_;
 
@@ -450,6 +529,11 @@ class ScopedTransaction {
   // Requires that StartApplying() has NOT been called.
   void Abort();
 
+  // Commits all of 'txns', which must belong to the same MvccManager, with a
+  // single call to MvccManager::CommitTransactions() per assignment type.
+  // Later calls to Commit() on any of them are no-ops.
+  static void CommitAll(const std::vector<ScopedTransaction*>& txns);
+
  private:
   bool done_;
   MvccManager * const manager_;
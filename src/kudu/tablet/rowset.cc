@@ -34,9 +34,11 @@ using strings::Substitute;
 namespace kudu { namespace tablet {
 
 DuplicatingRowSet::DuplicatingRowSet(RowSetVector old_rowsets,
-                                     RowSetVector new_rowsets)
+                                     RowSetVector new_rowsets,
+                                     bool output_may_omit_rows)
     : old_rowsets_(std::move(old_rowsets)),
-      new_rowsets_(std::move(new_rowsets)) {
+      new_rowsets_(std::move(new_rowsets)),
+      output_may_omit_rows_(output_may_omit_rows) {
   CHECK_GT(old_rowsets_.size(), 0);
   CHECK_GT(new_rowsets_.size(), 0);
 }
@@ -153,6 +155,10 @@ Status DuplicatingRowSet::MutateRow(Timestamp timestamp,
     }
     // IsNotFound is OK - it might be in a different one.
   }
+  if (mirrored_count == 0 && output_may_omit_rows_) {
+    // The row was dropped from the output by the compaction.
+    return Status::OK();
+  }
   CHECK_EQ(mirrored_count, 1)
     << "Updated row in compaction input, but didn't mirror in exactly 1 new rowset: "
     << probe.schema()->CreateKeyProjection().DebugRow(probe.row_key());
@@ -171,6 +177,23 @@ Status DuplicatingRowSet::CheckRowPresent(const RowSetKeyProbe &probe,
   return Status::OK();
 }
 
+Status DuplicatingRowSet::GetRow(const RowSetKeyProbe &probe,
+                                 const MvccSnapshot &snap,
+                                 RowBlock* dst,
+                                 bool* present,
+                                 ProbeStats* stats) const {
+  // Like NewRowIterator(), reads go to the old rowsets, which remain
+  // authoritative until the flush or compaction is complete.
+  *present = false;
+  for (const shared_ptr<RowSet> &rowset : old_rowsets_) {
+    RETURN_NOT_OK(rowset->GetRow(probe, snap, dst, present, stats));
+    if (*present) {
+      return Status::OK();
+    }
+  }
+  return Status::OK();
+}
+
 Status DuplicatingRowSet::CountRows(rowid_t *count) const {
   int64_t accumulated_count = 0;
   for (const shared_ptr<RowSet> &rs : new_rowsets_) {
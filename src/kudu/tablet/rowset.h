@@ -67,6 +67,20 @@ class RowSet {
   virtual Status CheckRowPresent(const RowSetKeyProbe &probe, bool *present,
                                  ProbeStats* stats) const = 0;
 
+  // Read the single row identified by 'probe' as of 'snap', projected into
+  // 'dst'. 'dst' must be a single-row block whose schema is a projection
+  // mapped to this rowset's schema (see Tablet::GetMappedReadProjection()).
+  //
+  // Sets *present to true if the row exists and is visible in 'snap'. This
+  // avoids building a full scan iterator when only one key is needed.
+  //
+  // NOTE: 'dst' and its arena are reset by this call.
+  virtual Status GetRow(const RowSetKeyProbe &probe,
+                        const MvccSnapshot &snap,
+                        RowBlock* dst,
+                        bool* present,
+                        ProbeStats* stats) const = 0;
+
   // Update/delete a row in this rowset.
   // The 'update_schema' is the client schema used to encode the 'update' RowChangeList.
   //
@@ -142,6 +156,28 @@ class RowSet {
   // Compact delta stores if more than one.
   virtual Status MinorCompactDeltaStores() = 0;
 
+  // Estimate the number of bytes in UNDO delta stores which may only hold
+  // history older than 'ancient_history_mark'.
+  virtual int64_t EstimateBytesInPotentiallyAncientUndoDeltas(
+      Timestamp ancient_history_mark) const = 0;
+
+  // Delete the UNDO delta stores which only hold history older than
+  // 'ancient_history_mark'. The number of blocks and bytes deleted are
+  // added to the output parameters.
+  virtual Status DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
+                                         int64_t* blocks_deleted,
+                                         int64_t* bytes_deleted) = 0;
+
+  // Sets 'all_expired' to true if every row of this rowset is known to have a
+  // value lower than 'cutoff_micros' in the TIMESTAMP column 'col_id', i.e.
+  // every row has expired according to the table's row TTL, and to have no
+  // history at or after 'ancient_history_mark'. This is decided without
+  // reading the rows, so it may be false even if all rows expired.
+  virtual Status CheckAllRowsExpired(ColumnId col_id,
+                                     int64_t cutoff_micros,
+                                     Timestamp ancient_history_mark,
+                                     bool* all_expired) const = 0;
+
   virtual ~RowSet() {}
 
   // Return true if this RowSet is available for compaction, based on
@@ -249,7 +285,11 @@ struct ProbeStats {
 // See compaction.txt for a little more detail on how this is used.
 class DuplicatingRowSet : public RowSet {
  public:
-  DuplicatingRowSet(RowSetVector old_rowsets, RowSetVector new_rowsets);
+  // If 'output_may_omit_rows' is true, rows of the old rowsets may be missing
+  // from the new ones, e.g. because they expired and were dropped by the
+  // compaction. Mutations of such rows are only applied to the old rowsets.
+  DuplicatingRowSet(RowSetVector old_rowsets, RowSetVector new_rowsets,
+                    bool output_may_omit_rows);
 
   virtual Status MutateRow(Timestamp timestamp,
                            const RowSetKeyProbe &probe,
@@ -261,6 +301,12 @@ class DuplicatingRowSet : public RowSet {
   Status CheckRowPresent(const RowSetKeyProbe &probe, bool *present,
                          ProbeStats* stats) const OVERRIDE;
 
+  Status GetRow(const RowSetKeyProbe &probe,
+                const MvccSnapshot &snap,
+                RowBlock* dst,
+                bool* present,
+                ProbeStats* stats) const OVERRIDE;
+
   virtual Status NewRowIterator(const Schema *projection,
                                 const MvccSnapshot &snap,
                                 gscoped_ptr<RowwiseIterator>* out) const OVERRIDE;
@@ -313,6 +359,25 @@ class DuplicatingRowSet : public RowSet {
 
   Status MinorCompactDeltaStores() OVERRIDE { return Status::OK(); }
 
+  int64_t EstimateBytesInPotentiallyAncientUndoDeltas(
+      Timestamp ancient_history_mark) const OVERRIDE {
+    return 0;
+  }
+
+  Status DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
+                                 int64_t* blocks_deleted,
+                                 int64_t* bytes_deleted) OVERRIDE {
+    return Status::OK();
+  }
+
+  Status CheckAllRowsExpired(ColumnId col_id,
+                             int64_t cutoff_micros,
+                             Timestamp ancient_history_mark,
+                             bool* all_expired) const OVERRIDE {
+    *all_expired = false;
+    return Status::OK();
+  }
+
  private:
   friend class Tablet;
 
@@ -320,6 +385,7 @@ class DuplicatingRowSet : public RowSet {
 
   RowSetVector old_rowsets_;
   RowSetVector new_rowsets_;
+  const bool output_may_omit_rows_;
 };
 
 
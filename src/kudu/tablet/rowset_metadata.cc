@@ -190,6 +190,18 @@ Status RowSetMetadata::CommitUpdate(const RowSetMetadataUpdate& update) {
       undo_delta_blocks_.insert(undo_delta_blocks_.begin(), update.new_undo_block_);
     }
 
+    for (const BlockId& b : update.undo_blocks_to_remove_) {
+      auto it = std::find(undo_delta_blocks_.begin(), undo_delta_blocks_.end(), b);
+      if (it == undo_delta_blocks_.end()) {
+        return Status::InvalidArgument(
+            Substitute("Cannot find UNDO delta block $0 in <$1>",
+                       b.ToString(),
+                       BlockId::JoinStrings(undo_delta_blocks_)));
+      }
+      undo_delta_blocks_.erase(it);
+      removed.push_back(b);
+    }
+
     for (const ColumnIdToBlockIdMap::value_type& e : update.cols_to_replace_) {
       // If we are major-compacting deltas into a column which previously had no
       // base-data (e.g. because it was newly added), then there will be no original
@@ -263,5 +275,12 @@ RowSetMetadataUpdate& RowSetMetadataUpdate::SetNewUndoBlock(const BlockId& undo_
   return *this;
 }
 
+RowSetMetadataUpdate& RowSetMetadataUpdate::RemoveUndoDeltaBlocks(
+    const std::vector<BlockId>& to_remove) {
+  undo_blocks_to_remove_.insert(undo_blocks_to_remove_.end(),
+                                to_remove.begin(), to_remove.end());
+  return *this;
+}
+
 } // namespace tablet
 } // namespace kudu
@@ -241,9 +241,12 @@ class RowSetMetadataUpdate {
   RowSetMetadataUpdate& RemoveColumnId(ColumnId col_id);
 
   // Add a new UNDO delta block to the list of UNDO files.
-  // We'll need to replace them instead when we start GCing.
   RowSetMetadataUpdate& SetNewUndoBlock(const BlockId& undo_block);
 
+  // Remove the given UNDO delta blocks, e.g. because they only contain
+  // history older than the tablet's history retention window.
+  RowSetMetadataUpdate& RemoveUndoDeltaBlocks(const std::vector<BlockId>& to_remove);
+
  private:
   friend class RowSetMetadata;
   RowSetMetadata::ColumnIdToBlockIdMap cols_to_replace_;
@@ -256,6 +259,7 @@ class RowSetMetadataUpdate {
   };
   std::vector<ReplaceDeltaBlocks> replace_redo_blocks_;
   BlockId new_undo_block_;
+  std::vector<BlockId> undo_blocks_to_remove_;
 
   DISALLOW_COPY_AND_ASSIGN(RowSetMetadataUpdate);
 };
@@ -104,6 +104,30 @@ TEST_F(TestRowSetTree, TestTree) {
   ASSERT_EQ(vec[2].get(), out[3]);
 }
 
+TEST_F(TestRowSetTree, TestKeyAboveAllBounds) {
+  RowSetVector vec;
+  vec.push_back(shared_ptr<RowSet>(new MockMemRowSet()));
+
+  // With no bounded rowsets, every key is above all bounds.
+  {
+    RowSetTree tree;
+    ASSERT_OK(tree.Reset(vec));
+    ASSERT_TRUE(tree.KeyAboveAllBounds(""));
+    ASSERT_EQ(1, tree.unbounded_rowsets().size());
+  }
+
+  vec.push_back(shared_ptr<RowSet>(new MockDiskRowSet("0", "5")));
+  vec.push_back(shared_ptr<RowSet>(new MockDiskRowSet("3", "7")));
+  RowSetTree tree;
+  ASSERT_OK(tree.Reset(vec));
+  ASSERT_FALSE(tree.KeyAboveAllBounds("4"));
+  ASSERT_FALSE(tree.KeyAboveAllBounds("7"));
+  ASSERT_TRUE(tree.KeyAboveAllBounds("70"));
+  ASSERT_TRUE(tree.KeyAboveAllBounds("8"));
+  ASSERT_EQ(1, tree.unbounded_rowsets().size());
+  ASSERT_EQ(vec[0].get(), tree.unbounded_rowsets()[0].get());
+}
+
 TEST_F(TestRowSetTree, TestPerformance) {
   const int kNumRowSets = 200;
   const int kNumQueries = AllowSlowTests() ? 1000000 : 10000;
@@ -77,6 +77,21 @@ class RowSetTree {
                                        const Slice &upper_bound,
                                        std::vector<RowSet *> *rowsets) const;
 
+  // Return true if the given encoded key is greater than the upper bound of
+  // every rowset with known bounds, i.e. no DiskRowSet can contain it.
+  //
+  // This is the common case for inserts into tables whose keys increase
+  // monotonically (e.g. time series), which can then skip the interval tree
+  // and bloom filter probes entirely.
+  bool KeyAboveAllBounds(const Slice &encoded_key) const {
+    DCHECK(initted_);
+    return key_endpoints_.empty() || encoded_key.compare(key_endpoints_.back().slice_) > 0;
+  }
+
+  // Return the RowSets with unknown bounds (e.g. MemRowSets being flushed),
+  // which may contain any key.
+  const RowSetVector &unbounded_rowsets() const { return unbounded_rowsets_; }
+
   const RowSetVector &all_rowsets() const { return all_rowsets_; }
 
   RowSet* drs_by_id(int64_t drs_id) const {
@@ -16,6 +16,7 @@
 // under the License.
 
 #include <boost/lexical_cast.hpp>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -23,13 +24,18 @@
 #include <vector>
 
 #include "kudu/common/schema.h"
+#include "kudu/gutil/casts.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/server/hybrid_clock.h"
 #include "kudu/tablet/transactions/alter_schema_transaction.h"
 #include "kudu/tablet/tablet.h"
 #include "kudu/tablet/tablet-test-base.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(use_mock_wall_clock);
+DECLARE_int32(tablet_history_max_age_sec);
+
 using strings::Substitute;
 
 namespace kudu {
@@ -295,5 +301,182 @@ TEST_F(TestTabletSchema, TestModifyEmptyMemRowSet) {
   EXPECT_EQ("(int32 key=2, int32 c1=4, int32 c2=3)", rows[0]);
 }
 
+// Row expiry is evaluated at hybrid times, so these tests use a HybridClock
+// whose wall clock they control.
+class TestTabletRowTtl : public KuduTabletTest {
+ public:
+  TestTabletRowTtl()
+    : KuduTabletTest(Schema({ ColumnSchema("key", INT32),
+                              ColumnSchema("ts", TIMESTAMP) }, 1),
+                     TabletHarness::Options::HYBRID_CLOCK),
+      now_micros_(1000000000L * 1000000L) {
+    FLAGS_use_mock_wall_clock = true;
+    FLAGS_tablet_history_max_age_sec = 60;
+  }
+
+  virtual void SetUp() OVERRIDE {
+    KuduTabletTest::SetUp();
+    AdvanceClock(0);
+  }
+
+  void AdvanceClock(int64_t secs) {
+    now_micros_ += secs * 1000000L;
+    down_cast<server::HybridClock*>(clock())->SetMockClockWallTimeForTests(now_micros_);
+  }
+
+  void SetRowTtl(int64_t ttl_secs) {
+    RowTtlPB row_ttl;
+    row_ttl.set_column_id(schema_.column_id(1));
+    row_ttl.set_ttl_secs(ttl_secs);
+    tablet()->metadata()->SetRowTtl(row_ttl);
+  }
+
+  Status WriteRow(RowOperationsPB::Type type, int32_t key, int64_t ts_micros) {
+    LocalTabletWriter writer(tablet().get(), &client_schema_);
+    KuduPartialRow row(&client_schema_);
+    CHECK_OK(row.SetInt32(0, key));
+    if (type != RowOperationsPB::DELETE) {
+      CHECK_OK(row.SetTimestamp(1, ts_micros));
+    }
+    return writer.Write(type, row);
+  }
+
+  void InsertRow(int32_t key, int64_t ts_micros) {
+    ASSERT_OK(WriteRow(RowOperationsPB::INSERT, key, ts_micros));
+  }
+
+ protected:
+  // The mock wall clock time.
+  int64_t now_micros_;
+};
+
+// Expired rows are hidden from readers, and dropped when flushed once they
+// have expired for longer than the history retention window.
+TEST_F(TestTabletRowTtl, TestExpiredRowsHiddenAndDroppedOnFlush) {
+  SetRowTtl(3600);
+  int64_t now = now_micros_;
+  for (int32_t i = 0; i < 10; i++) {
+    // Even rows are two hours old, and thus expired.
+    NO_FATALS(InsertRow(i, i % 2 == 0 ? now - 7200 * 1000000L : now));
+  }
+
+  vector<string> rows;
+  ASSERT_OK(DumpTablet(*tablet(), client_schema_, &rows));
+  ASSERT_EQ(5, rows.size());
+
+  uint64_t count;
+  ASSERT_OK(tablet()->CountRows(&count));
+  ASSERT_EQ(10, count);
+
+  // Snapshots within the retention window may still see the expired rows as
+  // of when they were inserted, so the flush keeps them.
+  ASSERT_OK(tablet()->Flush());
+  ASSERT_OK(tablet()->CountRows(&count));
+  ASSERT_EQ(10, count);
+
+  AdvanceClock(120);
+  ASSERT_OK(tablet()->Compact(Tablet::FORCE_COMPACT_ALL));
+  ASSERT_OK(tablet()->CountRows(&count));
+  ASSERT_EQ(5, count);
+  ASSERT_OK(DumpTablet(*tablet(), client_schema_, &rows));
+  ASSERT_EQ(5, rows.size());
+}
+
+// Rowsets whose rows have all expired since they were flushed are deleted
+// without being compacted.
+TEST_F(TestTabletRowTtl, TestDeleteExpiredRowSets) {
+  SetRowTtl(3600);
+  int64_t now = now_micros_;
+  for (int32_t i = 0; i < 10; i++) {
+    NO_FATALS(InsertRow(i, now - 1800 * 1000000L));
+  }
+  ASSERT_OK(tablet()->Flush());
+  for (int32_t i = 10; i < 20; i++) {
+    NO_FATALS(InsertRow(i, now));
+  }
+  ASSERT_OK(tablet()->Flush());
+  ASSERT_EQ(2, tablet()->num_rowsets());
+  ASSERT_EQ(0, tablet()->EstimateBytesInExpiredRowSets());
+
+  // Shorten the TTL so that the first rowset's rows expire. They were
+  // inserted within the retention window, so they are kept for now.
+  SetRowTtl(600);
+  ASSERT_EQ(0, tablet()->EstimateBytesInExpiredRowSets());
+
+  AdvanceClock(120);
+  ASSERT_GT(tablet()->EstimateBytesInExpiredRowSets(), 0);
+
+  int64_t rows_deleted;
+  int64_t bytes_deleted;
+  ASSERT_OK(tablet()->DeleteExpiredRowSets(&rows_deleted, &bytes_deleted));
+  ASSERT_EQ(10, rows_deleted);
+  ASSERT_GT(bytes_deleted, 0);
+  ASSERT_EQ(1, tablet()->num_rowsets());
+  ASSERT_EQ(0, tablet()->EstimateBytesInExpiredRowSets());
+
+  vector<string> rows;
+  ASSERT_OK(DumpTablet(*tablet(), client_schema_, &rows));
+  ASSERT_EQ(10, rows.size());
+}
+
+// Writes treat rows which had expired as of their timestamp as absent,
+// whether the expired rows are in the MemRowSet or in a DiskRowSet.
+TEST_F(TestTabletRowTtl, TestWritesTreatExpiredRowsAsAbsent) {
+  SetRowTtl(3600);
+  int64_t now = now_micros_;
+  int64_t expired = now - 7200 * 1000000L;
+  NO_FATALS(InsertRow(1, expired));
+  ASSERT_OK(tablet()->Flush());
+  NO_FATALS(InsertRow(2, expired));
+
+  for (int32_t key = 1; key <= 2; key++) {
+    SCOPED_TRACE(key);
+    Status s = WriteRow(RowOperationsPB::UPDATE, key, now);
+    ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+    s = WriteRow(RowOperationsPB::DELETE, key, now);
+    ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+
+    NO_FATALS(InsertRow(key, now));
+    s = WriteRow(RowOperationsPB::INSERT, key, now);
+    ASSERT_TRUE(s.IsAlreadyPresent()) << s.ToString();
+    ASSERT_OK(WriteRow(RowOperationsPB::UPDATE, key, now + 1));
+  }
+
+  // An UPSERT replaces an expired row too.
+  NO_FATALS(InsertRow(3, expired));
+  ASSERT_OK(WriteRow(RowOperationsPB::UPSERT, 3, now));
+
+  vector<string> rows;
+  ASSERT_OK(DumpTablet(*tablet(), client_schema_, &rows));
+  ASSERT_EQ(3, rows.size());
+
+  // Each key has a single live version, which flushes and compactions rely on.
+  AdvanceClock(120);
+  ASSERT_OK(tablet()->Flush());
+  ASSERT_OK(tablet()->Compact(Tablet::FORCE_COMPACT_ALL));
+  ASSERT_OK(DumpTablet(*tablet(), client_schema_, &rows));
+  ASSERT_EQ(3, rows.size());
+}
+
+// Snapshot reads evaluate expiry as of the snapshot's timestamp, rather than
+// as of the current time.
+TEST_F(TestTabletRowTtl, TestSnapshotReadsEvaluateExpiryAtSnapshot) {
+  SetRowTtl(3600);
+  NO_FATALS(InsertRow(1, now_micros_ - 3000 * 1000000L));
+  Timestamp before_expiry = clock()->Now();
+
+  AdvanceClock(1200);
+  vector<string> rows;
+  ASSERT_OK(DumpTablet(*tablet(), client_schema_, &rows));
+  ASSERT_EQ(0, rows.size());
+
+  gscoped_ptr<RowwiseIterator> iter;
+  ASSERT_OK(tablet()->NewRowIterator(client_schema_, MvccSnapshot(before_expiry),
+                                     Tablet::UNORDERED, &iter));
+  ASSERT_OK(iter->Init(nullptr));
+  ASSERT_OK(IterateToStringList(iter.get(), &rows));
+  ASSERT_EQ(1, rows.size());
+}
+
 } // namespace tablet
 } // namespace kudu
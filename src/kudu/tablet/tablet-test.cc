@@ -933,6 +933,69 @@ TYPED_TEST(TestTablet, TestCompactionWithConcurrentMutation) {
   }
 }
 
+// Look up rows via Tablet::GetRow(), the point-lookup path which bypasses
+// scan iterators, for rows in the MemRowSet and in DiskRowSets with deltas.
+TYPED_TEST(TestTablet, TestGetRow) {
+  LocalTabletWriter writer(this->tablet().get(), &this->client_schema_);
+
+  // Rows [0, 10) are flushed to disk, rows [10, 15) stay in the MemRowSet.
+  this->InsertTestRows(0, 10, 0);
+  ASSERT_OK(this->tablet()->Flush());
+  this->InsertTestRows(10, 5, 0);
+  MvccSnapshot before_mutations(*this->tablet()->mvcc_manager());
+
+  ASSERT_OK(this->UpdateTestRow(&writer, 3, 30));
+  ASSERT_OK(this->UpdateTestRow(&writer, 12, 120));
+  ASSERT_OK(this->DeleteTestRow(&writer, 5));
+  ASSERT_OK(this->DeleteTestRow(&writer, 11));
+  MvccSnapshot after_mutations(*this->tablet()->mvcc_manager());
+
+  Schema projection;
+  ASSERT_OK(this->tablet()->GetMappedReadProjection(this->client_schema_, &projection));
+  Arena arena(1024, 1024 * 1024);
+  RowBlock block(projection, 1, &arena);
+
+  // Returns the stringified row for 'key_idx', or "" if it is not present.
+  auto get_row = [&](int64_t key_idx, const MvccSnapshot& snap) {
+    KuduPartialRow row(&this->client_schema_);
+    this->setup_.BuildRowKey(&row, key_idx);
+    string encoded_key;
+    CHECK_OK(row.EncodeRowKey(&encoded_key));
+    gscoped_ptr<uint8_t[]> key_buf(new uint8_t[this->schema_.key_byte_size()]);
+    CHECK_OK(this->schema_.DecodeRowKey(encoded_key, key_buf.get(), &arena));
+    RowSetKeyProbe probe(ConstContiguousRow(&this->tablet()->key_schema(), key_buf.get()));
+    bool present;
+    CHECK_OK(this->tablet()->GetRow(probe, snap, this->clock()->Now(), &block, &present));
+    return present ? this->schema_.DebugRow(block.row(0)) : "";
+  };
+
+  // Unmodified rows in a DiskRowSet and the MemRowSet.
+  ASSERT_EQ(this->setup_.FormatDebugRow(0, 0, false), get_row(0, after_mutations));
+  ASSERT_EQ(this->setup_.FormatDebugRow(14, 0, false), get_row(14, after_mutations));
+
+  // Updated rows reflect the update only in snapshots which include it.
+  ASSERT_EQ(this->setup_.FormatDebugRow(3, 30, true), get_row(3, after_mutations));
+  ASSERT_EQ(this->setup_.FormatDebugRow(3, 0, false), get_row(3, before_mutations));
+  ASSERT_EQ(this->setup_.FormatDebugRow(12, 120, true), get_row(12, after_mutations));
+  ASSERT_EQ(this->setup_.FormatDebugRow(12, 0, false), get_row(12, before_mutations));
+
+  // Deleted rows are only visible before the deletion.
+  ASSERT_EQ("", get_row(5, after_mutations));
+  ASSERT_EQ(this->setup_.FormatDebugRow(5, 0, false), get_row(5, before_mutations));
+  ASSERT_EQ("", get_row(11, after_mutations));
+  ASSERT_EQ(this->setup_.FormatDebugRow(11, 0, false), get_row(11, before_mutations));
+
+  // Keys which were never inserted.
+  ASSERT_EQ("", get_row(20, after_mutations));
+
+  // Reinsert a deleted on-disk row: the new version lives in the MemRowSet
+  // while the old, deleted version remains on disk.
+  ASSERT_OK(this->InsertTestRow(&writer, 5, 50));
+  MvccSnapshot after_reinsert(*this->tablet()->mvcc_manager());
+  ASSERT_EQ(this->setup_.FormatDebugRow(5, 50, true), get_row(5, after_reinsert));
+  ASSERT_EQ(this->setup_.FormatDebugRow(5, 0, false), get_row(5, before_mutations));
+}
+
 // Test that metrics behave properly during tablet initialization
 TYPED_TEST(TestTablet, TestMetricsInit) {
   // Create a tablet, but do not open it
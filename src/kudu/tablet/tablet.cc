@@ -28,9 +28,11 @@
 #include <vector>
 
 #include "kudu/cfile/cfile_writer.h"
+#include "kudu/common/encoded_key.h"
 #include "kudu/common/iterator.h"
 #include "kudu/common/row_changelist.h"
 #include "kudu/common/row_operations.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/consensus/consensus.pb.h"
@@ -41,6 +43,7 @@
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/numbers.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/server/hybrid_clock.h"
 #include "kudu/tablet/compaction.h"
 #include "kudu/tablet/compaction_policy.h"
 #include "kudu/tablet/delta_compaction.h"
@@ -54,6 +57,7 @@
 #include "kudu/tablet/tablet_metrics.h"
 #include "kudu/tablet/tablet_mm_ops.h"
 #include "kudu/tablet/transactions/alter_schema_transaction.h"
+#include "kudu/tablet/transactions/bulk_ingest_transaction.h"
 #include "kudu/tablet/transactions/write_transaction.h"
 #include "kudu/util/bloom_filter.h"
 #include "kudu/util/debug/trace_event.h"
@@ -62,6 +66,7 @@
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/stopwatch.h"
@@ -109,6 +114,14 @@ DEFINE_double(tablet_throttler_burst_factor, 1.0f,
              "base rate.");
 TAG_FLAG(tablet_throttler_burst_factor, experimental);
 
+DEFINE_int32(tablet_history_max_age_sec, 15 * 60,
+             "Number of seconds of history to retain for snapshot scans. UNDO "
+             "deltas older than this are no longer carried forward by compactions "
+             "and are deleted by the UNDO delta block GC maintenance op, and "
+             "snapshot scans at timestamps older than this are rejected. "
+             "0 or a negative value retains all history.");
+TAG_FLAG(tablet_history_max_age_sec, advanced);
+
 METRIC_DEFINE_entity(tablet);
 METRIC_DEFINE_gauge_size(tablet, memrowset_size, "MemRowSet Memory Usage",
                          kudu::MetricUnit::kBytes,
@@ -129,6 +142,7 @@ using kudu::MaintenanceManager;
 using consensus::OpId;
 using consensus::MaximumOpId;
 using log::LogAnchorRegistry;
+using server::HybridClock;
 using strings::Substitute;
 using base::subtle::Barrier_AtomicIncrement;
 
@@ -144,6 +158,48 @@ TabletComponents::TabletComponents(shared_ptr<MemRowSet> mrs,
                                    shared_ptr<RowSetTree> rs_tree)
     : memrowset(std::move(mrs)), rowsets(std::move(rs_tree)) {}
 
+////////////////////////////////////////////////////////////
+// UndoDeltaBlockGCOp
+////////////////////////////////////////////////////////////
+
+UndoDeltaBlockGCOp::UndoDeltaBlockGCOp(Tablet* tablet)
+  : MaintenanceOp(Substitute("UndoDeltaBlockGCOp($0)", tablet->tablet_id()),
+                  MaintenanceOp::LOW_IO_USAGE),
+    tablet_(tablet) {
+}
+
+void UndoDeltaBlockGCOp::UpdateStats(MaintenanceOpStats* stats) {
+  // Reclaiming a full compaction budget's worth of disk space is considered as
+  // worthwhile as the best possible compaction.
+  const double kBytesForFullImprovement = FLAGS_tablet_compaction_budget_mb * 1024.0 * 1024.0;
+  int64_t bytes = tablet_->EstimateBytesInPotentiallyAncientUndoDeltas();
+  stats->set_perf_improvement(std::min(1.0, bytes / kBytesForFullImprovement));
+  stats->set_runnable(bytes > 0);
+}
+
+bool UndoDeltaBlockGCOp::Prepare() {
+  return true;
+}
+
+void UndoDeltaBlockGCOp::Perform() {
+  int64_t blocks_deleted = 0;
+  int64_t bytes_deleted = 0;
+  WARN_NOT_OK(tablet_->DeleteAncientUndoDeltas(&blocks_deleted, &bytes_deleted),
+              Substitute("UNDO delta block GC failed on $0", tablet_->tablet_id()));
+  if (blocks_deleted > 0) {
+    LOG(INFO) << "T " << tablet_->tablet_id() << ": Deleted " << blocks_deleted
+              << " ancient UNDO delta blocks (" << bytes_deleted << " bytes)";
+  }
+}
+
+scoped_refptr<Histogram> UndoDeltaBlockGCOp::DurationHistogram() const {
+  return tablet_->metrics()->undo_delta_block_gc_duration;
+}
+
+scoped_refptr<AtomicGauge<uint32_t> > UndoDeltaBlockGCOp::RunningGauge() const {
+  return tablet_->metrics()->undo_delta_block_gc_running;
+}
+
 ////////////////////////////////////////////////////////////
 // Tablet
 ////////////////////////////////////////////////////////////
@@ -269,9 +325,10 @@ BloomFilterSizing Tablet::bloom_sizing() const {
 
 Status Tablet::NewRowIterator(const Schema &projection,
                               gscoped_ptr<RowwiseIterator> *iter) const {
-  // Yield current rows.
+  // Yield current rows. The MVCC snapshot only advances as transactions
+  // commit, so take the expiry time from the clock instead.
   MvccSnapshot snap(mvcc_);
-  return NewRowIterator(projection, snap, Tablet::UNORDERED, iter);
+  return NewRowIterator(projection, snap, Tablet::UNORDERED, clock_->Now(), iter);
 }
 
 
@@ -279,12 +336,67 @@ Status Tablet::NewRowIterator(const Schema &projection,
                               const MvccSnapshot &snap,
                               const OrderMode order,
                               gscoped_ptr<RowwiseIterator> *iter) const {
+  // Snapshots which include all transactions aren't bounded by a timestamp.
+  Timestamp expiry_time = clock_->Now();
+  if (snap.none_committed_at_or_after().CompareTo(expiry_time) < 0) {
+    expiry_time = snap.none_committed_at_or_after();
+  }
+  return NewRowIterator(projection, snap, order, expiry_time, iter);
+}
+
+Status Tablet::NewRowIterator(const Schema &projection,
+                              const MvccSnapshot &snap,
+                              const OrderMode order,
+                              Timestamp expiry_time,
+                              gscoped_ptr<RowwiseIterator> *iter) const {
   CHECK_EQ(state_, kOpen);
   if (metrics_) {
     metrics_->scans_started->Increment();
   }
   VLOG_WITH_PREFIX(2) << "Created new Iterator under snap: " << snap.ToString();
-  iter->reset(new Iterator(this, projection, snap, order));
+  iter->reset(new Iterator(this, projection, snap, order, expiry_time));
+  return Status::OK();
+}
+
+Status Tablet::GetRow(const RowSetKeyProbe& probe,
+                      const MvccSnapshot& snap,
+                      Timestamp expiry_time,
+                      RowBlock* dst,
+                      bool* present) const {
+  CHECK_EQ(state_, kOpen);
+  RETURN_NOT_OK(CheckRowInTablet(probe.row_key()));
+
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+
+  ProbeStats stats;
+  RETURN_NOT_OK(comps->memrowset->GetRow(probe, snap, dst, present, &stats));
+
+  // A key may have been deleted from one rowset and reinserted into another,
+  // so keep probing until a version which is visible in 'snap' is found.
+  if (!*present) {
+    vector<RowSet*> to_check;
+    comps->rowsets->FindRowSetsWithKeyInRange(probe.encoded_key_slice(), &to_check);
+    for (const RowSet* rs : to_check) {
+      RETURN_NOT_OK_PREPEND(rs->GetRow(probe, snap, dst, present, &stats),
+                            Substitute("Could not read row from rowset $0",
+                                       rs->ToString()));
+      if (*present) {
+        break;
+      }
+    }
+  }
+
+  // Hide the row if it had expired.
+  ColumnId ttl_col_id;
+  int64_t cutoff_micros;
+  if (*present && GetRowExpiryCutoff(expiry_time, &ttl_col_id, &cutoff_micros)) {
+    int ttl_col_idx = dst->schema().find_column_by_id(ttl_col_id);
+    if (ttl_col_idx != Schema::kColumnNotFound &&
+        *reinterpret_cast<const int64_t*>(dst->row(0).cell_ptr(ttl_col_idx)) < cutoff_micros) {
+      *present = false;
+    }
+  }
   return Status::OK();
 }
 
@@ -330,8 +442,22 @@ Status Tablet::AcquireRowLocks(WriteTransactionState* tx_state) {
   TRACE_EVENT1("tablet", "Tablet::AcquireRowLocks",
                "num_locks", tx_state->row_ops().size());
   TRACE("PREPARE: Acquiring locks for $0 operations", tx_state->row_ops().size());
-  for (RowOp* op : tx_state->row_ops()) {
-    RETURN_NOT_OK(AcquireLockForOp(tx_state, op));
+  const vector<RowOp*>& row_ops = tx_state->row_ops();
+  vector<Slice> keys;
+  keys.reserve(row_ops.size());
+  for (RowOp* op : row_ops) {
+    ConstContiguousRow row_key(&key_schema_, op->decoded_op.row_data);
+    op->key_probe.reset(new tablet::RowSetKeyProbe(row_key));
+    RETURN_NOT_OK(CheckRowInTablet(row_key));
+    keys.push_back(op->key_probe->encoded_key_slice());
+  }
+
+  // Lock the whole batch at once rather than taking the lock manager's
+  // table and bucket locks once per row.
+  vector<ScopedRowLock> locks;
+  lock_manager_.LockBatch(keys, tx_state, LockManager::LOCK_EXCLUSIVE, &locks);
+  for (int i = 0; i < row_ops.size(); i++) {
+    row_ops[i]->row_lock = std::move(locks[i]);
   }
   TRACE("PREPARE: locks acquired");
   return Status::OK();
@@ -353,18 +479,6 @@ Status Tablet::CheckRowInTablet(const ConstContiguousRow& row) const {
   return Status::OK();
 }
 
-Status Tablet::AcquireLockForOp(WriteTransactionState* tx_state, RowOp* op) {
-  ConstContiguousRow row_key(&key_schema_, op->decoded_op.row_data);
-  op->key_probe.reset(new tablet::RowSetKeyProbe(row_key));
-  RETURN_NOT_OK(CheckRowInTablet(row_key));
-
-  op->row_lock = ScopedRowLock(&lock_manager_,
-                               tx_state,
-                               op->key_probe->encoded_key_slice(),
-                               LockManager::LOCK_EXCLUSIVE);
-  return Status::OK();
-}
-
 void Tablet::StartTransaction(WriteTransactionState* tx_state) {
   gscoped_ptr<ScopedTransaction> mvcc_tx;
 
@@ -391,14 +505,32 @@ Status Tablet::InsertOrUpsertUnlocked(WriteTransactionState *tx_state,
   const TabletComponents* comps = DCHECK_NOTNULL(tx_state->tablet_components());
 
   // First, ensure that it is a unique key by checking all the open RowSets.
+  // If the key sorts after every flushed key (as is the case for
+  // monotonically increasing keys), only the rowsets with unknown bounds
+  // need to be checked.
   vector<RowSet *> to_check;
-  comps->rowsets->FindRowSetsWithKeyInRange(op->key_probe->encoded_key_slice(),
-                                            &to_check);
+  const Slice& encoded_key = op->key_probe->encoded_key_slice();
+  if (comps->rowsets->KeyAboveAllBounds(encoded_key)) {
+    for (const shared_ptr<RowSet>& rs : comps->rowsets->unbounded_rowsets()) {
+      to_check.push_back(rs.get());
+    }
+    if (metrics_) {
+      metrics_->insertions_fast_path->Increment();
+    }
+  } else {
+    comps->rowsets->FindRowSetsWithKeyInRange(encoded_key, &to_check);
+  }
 
   for (RowSet *rowset : to_check) {
     bool present = false;
     RETURN_NOT_OK(rowset->CheckRowPresent(*op->key_probe, &present, stats));
     if (present) {
+      // A row which has expired is replaced, as if it were absent.
+      bool expired;
+      RETURN_NOT_OK(CheckRowExpiredUnlocked(tx_state, op, rowset, stats, &expired));
+      if (expired) {
+        return ReplaceExpiredRowUnlocked(tx_state, op, rowset, stats);
+      }
       if (is_upsert) {
         return ApplyUpsertAsUpdate(tx_state, op, rowset, stats);
       }
@@ -424,6 +556,12 @@ Status Tablet::InsertOrUpsertUnlocked(WriteTransactionState *tx_state,
     op->SetInsertSucceeded(comps->memrowset->mrs_id());
   } else {
     if (s.IsAlreadyPresent()) {
+      bool expired;
+      RETURN_NOT_OK(CheckRowExpiredUnlocked(tx_state, op, comps->memrowset.get(), stats,
+                                            &expired));
+      if (expired) {
+        return ReplaceExpiredRowUnlocked(tx_state, op, comps->memrowset.get(), stats);
+      }
       if (is_upsert) {
         return ApplyUpsertAsUpdate(tx_state, op, comps->memrowset.get(), stats);
       }
@@ -474,6 +612,103 @@ Status Tablet::ApplyUpsertAsUpdate(WriteTransactionState* tx_state,
   return s;
 }
 
+Status Tablet::ReplaceExpiredRowUnlocked(WriteTransactionState* tx_state,
+                                         RowOp* op,
+                                         RowSet* rowset,
+                                         ProbeStats* stats) {
+  const TabletComponents* comps = DCHECK_NOTNULL(tx_state->tablet_components());
+  Timestamp ts = tx_state->timestamp();
+
+  // Delete the expired row rather than updating it in place: a flush or
+  // compaction may drop the expired row concurrently, and only loses the
+  // deletion if so. If the expired row is in the MemRowSet, the new row is
+  // reinserted on top of the deleted one.
+  faststring buf;
+  RowChangeListEncoder enc(&buf);
+  enc.SetToDelete();
+  OperationResultPB delete_result;
+  Status s = rowset->MutateRow(ts,
+                               *op->key_probe,
+                               enc.as_changelist(),
+                               tx_state->op_id(),
+                               stats,
+                               &delete_result);
+  CHECK(!s.IsNotFound());
+  if (s.ok()) {
+    ConstContiguousRow row(schema(), op->decoded_op.row_data);
+    s = comps->memrowset->Insert(ts, row, tx_state->op_id());
+  }
+  if (!s.ok()) {
+    op->SetFailed(s);
+    return s;
+  }
+  op->SetInsertSucceeded(comps->memrowset->mrs_id());
+  op->result->mutable_expired_row_stores()->Swap(delete_result.mutable_mutated_stores());
+  return s;
+}
+
+// Return the RowSets which the memory stores 'stores', taken from a COMMIT
+// message being replayed, refer to.
+static vector<RowSet*> FindRowSetsForStores(
+    const google::protobuf::RepeatedPtrField<MemStoreTargetPB>& stores,
+    const TabletComponents* comps) {
+  vector<RowSet*> to_check;
+  for (const auto& store : stores) {
+    if (store.has_mrs_id()) {
+      to_check.push_back(comps->memrowset.get());
+    } else {
+      DCHECK(store.has_rs_id());
+      RowSet* drs = comps->rowsets->drs_by_id(store.rs_id());
+      if (PREDICT_TRUE(drs)) {
+        to_check.push_back(drs);
+      }
+
+      // If for some reason we didn't find any stores that the COMMIT message indicated,
+      // then 'to_check' will be empty at this point. That will result in a NotFound()
+      // status below, which the bootstrap code catches and propagates as a tablet
+      // corruption.
+    }
+  }
+  return to_check;
+}
+
+void Tablet::ReplayExpiredRowDeletion(WriteTransactionState* tx_state,
+                                      RowOp* row_op,
+                                      ProbeStats* stats) {
+  CHECK_EQ(state_, kBootstrapping);
+  DCHECK(row_op->has_row_lock()) << "RowOp must hold the row lock.";
+  const OperationResultPB* orig_result = DCHECK_NOTNULL(row_op->orig_result_from_log_);
+  DCHECK_GT(orig_result->expired_row_stores_size(), 0);
+  const TabletComponents* comps = DCHECK_NOTNULL(tx_state->tablet_components());
+
+  faststring buf;
+  RowChangeListEncoder enc(&buf);
+  enc.SetToDelete();
+  OperationResultPB delete_result;
+  Status s = Status::NotFound("expired row not found");
+  for (RowSet* rs : FindRowSetsForStores(orig_result->expired_row_stores(), comps)) {
+    s = rs->MutateRow(tx_state->timestamp(),
+                      *row_op->key_probe,
+                      enc.as_changelist(),
+                      tx_state->op_id(),
+                      stats,
+                      &delete_result);
+    if (!s.IsNotFound()) {
+      break;
+    }
+  }
+  if (!s.ok()) {
+    row_op->SetFailed(s);
+    return;
+  }
+
+  // The inserted row is already durable, so it keeps its original store.
+  gscoped_ptr<OperationResultPB> result(new OperationResultPB());
+  result->mutable_mutated_stores()->CopyFrom(orig_result->mutated_stores());
+  result->mutable_expired_row_stores()->Swap(delete_result.mutable_mutated_stores());
+  row_op->SetMutateSucceeded(std::move(result));
+}
+
 vector<RowSet*> Tablet::FindRowSetsToCheck(RowOp* mutate,
                                            const TabletComponents* comps) {
   vector<RowSet*> to_check;
@@ -495,23 +730,38 @@ vector<RowSet*> Tablet::FindRowSetsToCheck(RowOp* mutate,
 
   // If we are replaying an operation during bootstrap, then we already have a
   // COMMIT message which tells us specifically which memory store to apply it to.
-  for (const auto& store : mutate->orig_result_from_log_->mutated_stores()) {
-    if (store.has_mrs_id()) {
-      to_check.push_back(comps->memrowset.get());
-    } else {
-      DCHECK(store.has_rs_id());
-      RowSet* drs = comps->rowsets->drs_by_id(store.rs_id());
-      if (PREDICT_TRUE(drs)) {
-        to_check.push_back(drs);
-      }
+  return FindRowSetsForStores(mutate->orig_result_from_log_->mutated_stores(), comps);
+}
 
-      // If for some reason we didn't find any stores that the COMMIT message indicated,
-      // then 'to_check' will be empty at this point. That will result in a NotFound()
-      // status below, which the bootstrap code catches and propagates as a tablet
-      // corruption.
-    }
+Status Tablet::CheckRowExpiredUnlocked(const WriteTransactionState* tx_state,
+                                       const RowOp* op,
+                                       const RowSet* rowset,
+                                       ProbeStats* stats,
+                                       bool* expired) const {
+  if (PREDICT_FALSE(op->orig_result_from_log_ != nullptr)) {
+    *expired = op->orig_result_from_log_->expired_row_stores_size() > 0;
+    return Status::OK();
   }
-  return to_check;
+  *expired = false;
+  ColumnId ttl_col_id;
+  int64_t cutoff_micros;
+  if (PREDICT_TRUE(!GetRowExpiryCutoff(tx_state->timestamp(), &ttl_col_id, &cutoff_micros))) {
+    return Status::OK();
+  }
+
+  // Read the TTL column of the row's latest version. Rows are only written
+  // under their row lock, so no concurrent write to the row is in flight.
+  const ColumnSchema& ttl_col = schema()->column_by_id(ttl_col_id);
+  Schema projection({ ttl_col }, { ttl_col_id }, 0);
+  Arena arena(32, 1024);
+  RowBlock block(projection, 1, &arena);
+  bool present;
+  RETURN_NOT_OK(rowset->GetRow(*op->key_probe,
+                               MvccSnapshot::CreateSnapshotIncludingAllTransactions(),
+                               &block, &present, stats));
+  *expired = present &&
+      *reinterpret_cast<const int64_t*>(block.row(0).cell_ptr(0)) < cutoff_micros;
+  return Status::OK();
 }
 
 Status Tablet::MutateRowUnlocked(WriteTransactionState *tx_state,
@@ -536,18 +786,25 @@ Status Tablet::MutateRowUnlocked(WriteTransactionState *tx_state,
 
   Timestamp ts = tx_state->timestamp();
 
-  // First try to update in memrowset.
-  s = comps->memrowset->MutateRow(ts,
-                            *mutate->key_probe,
-                            mutate->decoded_op.changelist,
-                            tx_state->op_id(),
-                            stats,
-                            result.get());
+  // First try to update in memrowset. A row which has expired is treated as
+  // absent. Since it's the live version of its key, no other rowset holds a
+  // version to update.
+  bool expired = false;
+  s = CheckRowExpiredUnlocked(tx_state, mutate, comps->memrowset.get(), stats, &expired);
+  if (s.ok()) {
+    s = expired ? Status::NotFound("key not found")
+                : comps->memrowset->MutateRow(ts,
+                                              *mutate->key_probe,
+                                              mutate->decoded_op.changelist,
+                                              tx_state->op_id(),
+                                              stats,
+                                              result.get());
+  }
   if (s.ok()) {
     mutate->SetMutateSucceeded(std::move(result));
     return s;
   }
-  if (!s.IsNotFound()) {
+  if (!s.IsNotFound() || expired) {
     mutate->SetFailed(s);
     return s;
   }
@@ -556,17 +813,21 @@ Status Tablet::MutateRowUnlocked(WriteTransactionState *tx_state,
 
   vector<RowSet *> to_check = FindRowSetsToCheck(mutate, comps);
   for (RowSet *rs : to_check) {
-    s = rs->MutateRow(ts,
-                      *mutate->key_probe,
-                      mutate->decoded_op.changelist,
-                      tx_state->op_id(),
-                      stats,
-                      result.get());
+    s = CheckRowExpiredUnlocked(tx_state, mutate, rs, stats, &expired);
+    if (s.ok()) {
+      s = expired ? Status::NotFound("key not found")
+                  : rs->MutateRow(ts,
+                                  *mutate->key_probe,
+                                  mutate->decoded_op.changelist,
+                                  tx_state->op_id(),
+                                  stats,
+                                  result.get());
+    }
     if (s.ok()) {
       mutate->SetMutateSucceeded(std::move(result));
       return s;
     }
-    if (!s.IsNotFound()) {
+    if (!s.IsNotFound() || expired) {
       mutate->SetFailed(s);
       return s;
     }
@@ -838,6 +1099,7 @@ Status Tablet::AlterSchema(AlterSchemaTransactionState *tx_state) {
       metric_entity_->SetAttribute("table_name", tx_state->new_table_name());
     }
   }
+  metadata_->SetRowTtl(tx_state->row_ttl());
 
   // If the current schema and the new one are equal, there is nothing to do.
   if (same_schema) {
@@ -847,6 +1109,183 @@ Status Tablet::AlterSchema(AlterSchemaTransactionState *tx_state) {
   return FlushUnlocked();
 }
 
+Status Tablet::DecodeBulkIngestRows(const Schema* client_schema,
+                                    BulkIngestTransactionState* tx_state) {
+  TRACE_EVENT0("tablet", "Tablet::DecodeBulkIngestRows");
+
+  DCHECK(tx_state->rows().empty());
+
+  // Acquire the schema lock in shared mode, so that the schema doesn't
+  // change while this transaction is in-flight.
+  tx_state->AcquireSchemaLock(&schema_lock_);
+
+  TRACE("PREPARE: Decoding rows");
+  vector<DecodedRowOperation> ops;
+  RowOperationsPBDecoder dec(&tx_state->request()->row_operations(),
+                             client_schema,
+                             schema(),
+                             tx_state->arena());
+  RETURN_NOT_OK(dec.DecodeOperations(&ops));
+  TRACE_COUNTER_INCREMENT("num_rows", ops.size());
+  if (ops.empty()) {
+    return Status::InvalidArgument("Bulk ingest has no rows");
+  }
+
+  vector<const uint8_t*> rows;
+  rows.reserve(ops.size());
+  faststring prev_key;
+  faststring key;
+  for (int i = 0; i < ops.size(); i++) {
+    const DecodedRowOperation& op = ops[i];
+    if (PREDICT_FALSE(op.type != RowOperationsPB::INSERT)) {
+      return Status::InvalidArgument(
+          Substitute("Bulk ingest row $0 is not an insert", i),
+          op.ToString(*schema()));
+    }
+
+    ConstContiguousRow row_key(&key_schema_, op.row_data);
+    RETURN_NOT_OK(CheckRowInTablet(row_key));
+    key_schema_.EncodeComparableKey(row_key, &key);
+    if (PREDICT_FALSE(i > 0 && Slice(key).compare(Slice(prev_key)) <= 0)) {
+      return Status::InvalidArgument(
+          Substitute("Bulk ingest rows are not sorted by strictly increasing key at row $0", i),
+          key_schema_.DebugRowKey(row_key));
+    }
+    prev_key.assign_copy(key.data(), key.size());
+    rows.push_back(op.row_data);
+  }
+
+  tx_state->set_schema_at_decode_time(schema());
+  tx_state->swap_rows(&rows);
+  return Status::OK();
+}
+
+Status Tablet::CheckBulkIngestKeyRangeEmpty(const BulkIngestTransactionState* tx_state) const {
+  TRACE_EVENT0("tablet", "Tablet::CheckBulkIngestKeyRangeEmpty");
+  const vector<const uint8_t*>& rows = tx_state->rows();
+  DCHECK(!rows.empty());
+
+  ConstContiguousRow first_key(&key_schema_, rows.front());
+  ConstContiguousRow last_key(&key_schema_, rows.back());
+  gscoped_ptr<EncodedKey> lower_bound(EncodedKey::FromContiguousRow(first_key));
+  gscoped_ptr<EncodedKey> upper_bound(EncodedKey::FromContiguousRow(last_key));
+
+  Arena arena(1024, 1024 * 1024);
+  ScanSpec spec;
+  spec.SetLowerBoundKey(lower_bound.get());
+  // The last key can't be incremented into an exclusive upper bound if it is
+  // the greatest possible key, in which case the range is left open-ended.
+  if (EncodedKey::IncrementEncodedKey(key_schema_, &upper_bound, &arena).ok()) {
+    spec.SetExclusiveUpperBoundKey(upper_bound.get());
+  }
+
+  // Rows of transactions which are still in flight count as well, and so do
+  // expired rows, which are still stored.
+  Iterator iter(this, key_schema_.CopyWithoutColumnIds(),
+                MvccSnapshot::CreateSnapshotIncludingAllTransactions(), UNORDERED,
+                Timestamp::kMin);
+  RETURN_NOT_OK(iter.Init(&spec));
+  RowBlock block(iter.schema(), 100, &arena);
+  while (iter.HasNext()) {
+    RETURN_NOT_OK(iter.NextBlock(&block));
+    if (block.selection_vector()->AnySelected()) {
+      return Status::AlreadyPresent(
+          Substitute("Tablet already has rows between the first and the last key of the "
+                     "bulk ingest: $0 and $1",
+                     key_schema_.DebugRowKey(first_key), key_schema_.DebugRowKey(last_key)));
+    }
+  }
+  return Status::OK();
+}
+
+void Tablet::StartTransaction(BulkIngestTransactionState* tx_state) {
+  gscoped_ptr<ScopedTransaction> mvcc_tx;
+  if (tx_state->has_timestamp()) {
+    mvcc_tx.reset(new ScopedTransaction(&mvcc_, tx_state->timestamp()));
+  } else {
+    mvcc_tx.reset(new ScopedTransaction(&mvcc_, ScopedTransaction::NOW));
+  }
+  tx_state->SetMvccTxAndTimestamp(std::move(mvcc_tx));
+}
+
+Status Tablet::BulkIngest(BulkIngestTransactionState* tx_state) {
+  TRACE_EVENT1("tablet", "Tablet::BulkIngest",
+               "num_rows", tx_state->rows().size());
+  DCHECK_EQ(tx_state->schema_at_decode_time(), schema());
+  tx_state->StartApplying();
+
+  // If the server restarted after the rowsets were added to the metadata but
+  // before the COMMIT message was logged, the operation is applied again.
+  const int64_t op_index = tx_state->op_id().index();
+  if (op_index <= metadata_->last_bulk_ingest_op_index()) {
+    LOG_WITH_PREFIX(INFO) << "Skipping bulk ingest " << consensus::OpIdToString(tx_state->op_id())
+                          << ": its rowsets are already part of the tablet";
+    return Status::OK();
+  }
+
+  RETURN_NOT_OK(CheckBulkIngestKeyRangeEmpty(tx_state));
+
+  const vector<const uint8_t*>& rows = tx_state->rows();
+  RollingDiskRowSetWriter drsw(metadata_.get(), *schema(), bloom_sizing(),
+                               compaction_policy_->target_rowset_size());
+  RETURN_NOT_OK_PREPEND(drsw.Open(), "Failed to open DiskRowSet for bulk ingest");
+
+  faststring undo_buf;
+  RowChangeListEncoder undo_encoder(&undo_buf);
+  undo_encoder.SetToDelete();
+
+  Arena undo_arena(1024, 1024 * 1024);
+  RowBlock block(*schema(), 100, nullptr);
+  int n = 0;
+  for (const uint8_t* row_data : rows) {
+    RETURN_NOT_OK(drsw.RollIfNecessary());
+
+    ConstContiguousRow row(schema(), row_data);
+    RowBlockRow dst_row = block.row(n);
+    RETURN_NOT_OK(CopyRow(row, &dst_row, reinterpret_cast<Arena*>(NULL)));
+
+    Mutation* undo = Mutation::CreateInArena(&undo_arena, tx_state->timestamp(),
+                                             undo_encoder.as_changelist());
+    rowid_t index_in_current_drs;
+    RETURN_NOT_OK(drsw.AppendUndoDeltas(n, undo, &index_in_current_drs));
+
+    n++;
+    if (n == block.nrows()) {
+      RETURN_NOT_OK(drsw.AppendBlock(block));
+      undo_arena.Reset();
+      n = 0;
+    }
+  }
+  if (n > 0) {
+    block.Resize(n);
+    RETURN_NOT_OK(drsw.AppendBlock(block));
+  }
+  RETURN_NOT_OK_PREPEND(drsw.Finish(), "Failed to finish DRS writer");
+
+  RowSetMetadataVector new_drs_metas;
+  drsw.GetWrittenRowSetMetadata(&new_drs_metas);
+  RowSetVector new_disk_rowsets;
+  for (const shared_ptr<RowSetMetadata>& meta : new_drs_metas) {
+    shared_ptr<DiskRowSet> new_rowset;
+    RETURN_NOT_OK_PREPEND(DiskRowSet::Open(meta, log_anchor_registry_.get(), &new_rowset,
+                                           mem_tracker_),
+                          Substitute("Unable to open bulk ingest results $0", meta->ToString()));
+    new_disk_rowsets.push_back(new_rowset);
+  }
+
+  RETURN_NOT_OK_PREPEND(metadata_->AddBulkIngestRowSetsAndFlush(new_drs_metas, op_index),
+                        "Failed to flush new tablet metadata");
+  AtomicSwapRowSets(RowSetVector(), new_disk_rowsets);
+
+  if (metrics_) {
+    metrics_->rows_bulk_ingested->IncrementBy(rows.size());
+    metrics_->bytes_flushed->IncrementBy(drsw.written_size());
+  }
+  LOG_WITH_PREFIX(INFO) << "Bulk ingested " << rows.size() << " rows into "
+                        << new_disk_rowsets.size() << " new rowsets";
+  return Status::OK();
+}
+
 Status Tablet::RewindSchemaForBootstrap(const Schema& new_schema,
                                         int64_t schema_version) {
   CHECK_EQ(state_, kBootstrapping);
@@ -1113,6 +1552,47 @@ scoped_refptr<AtomicGauge<uint32_t> > MajorDeltaCompactionOp::RunningGauge() con
   return tablet_->metrics()->delta_major_compact_rs_running;
 }
 
+////////////////////////////////////////////////////////////
+// ExpiredRowSetGCOp
+////////////////////////////////////////////////////////////
+
+ExpiredRowSetGCOp::ExpiredRowSetGCOp(Tablet* tablet)
+  : MaintenanceOp(Substitute("ExpiredRowSetGCOp($0)", tablet->tablet_id()),
+                  MaintenanceOp::LOW_IO_USAGE),
+    tablet_(tablet) {
+}
+
+void ExpiredRowSetGCOp::UpdateStats(MaintenanceOpStats* stats) {
+  // Scored like UndoDeltaBlockGCOp.
+  const double kBytesForFullImprovement = FLAGS_tablet_compaction_budget_mb * 1024.0 * 1024.0;
+  int64_t bytes = tablet_->EstimateBytesInExpiredRowSets();
+  stats->set_perf_improvement(std::min(1.0, bytes / kBytesForFullImprovement));
+  stats->set_runnable(bytes > 0);
+}
+
+bool ExpiredRowSetGCOp::Prepare() {
+  return true;
+}
+
+void ExpiredRowSetGCOp::Perform() {
+  int64_t rows_deleted = 0;
+  int64_t bytes_deleted = 0;
+  WARN_NOT_OK(tablet_->DeleteExpiredRowSets(&rows_deleted, &bytes_deleted),
+              Substitute("Expired rowset GC failed on $0", tablet_->tablet_id()));
+  if (rows_deleted > 0) {
+    LOG(INFO) << "T " << tablet_->tablet_id() << ": Deleted rowsets of " << rows_deleted
+              << " expired rows (" << bytes_deleted << " bytes)";
+  }
+}
+
+scoped_refptr<Histogram> ExpiredRowSetGCOp::DurationHistogram() const {
+  return tablet_->metrics()->expired_rowset_gc_duration;
+}
+
+scoped_refptr<AtomicGauge<uint32_t> > ExpiredRowSetGCOp::RunningGauge() const {
+  return tablet_->metrics()->expired_rowset_gc_running;
+}
+
 ////////////////////////////////////////////////////////////
 // Tablet
 ////////////////////////////////////////////////////////////
@@ -1209,6 +1689,14 @@ void Tablet::RegisterMaintenanceOps(MaintenanceManager* maint_mgr) {
   gscoped_ptr<MaintenanceOp> major_delta_compact_op(new MajorDeltaCompactionOp(this));
   maint_mgr->RegisterOp(major_delta_compact_op.get());
   maintenance_ops_.push_back(major_delta_compact_op.release());
+
+  gscoped_ptr<MaintenanceOp> undo_delta_block_gc_op(new UndoDeltaBlockGCOp(this));
+  maint_mgr->RegisterOp(undo_delta_block_gc_op.get());
+  maintenance_ops_.push_back(undo_delta_block_gc_op.release());
+
+  gscoped_ptr<MaintenanceOp> expired_rowset_gc_op(new ExpiredRowSetGCOp(this));
+  maint_mgr->RegisterOp(expired_rowset_gc_op.get());
+  maintenance_ops_.push_back(expired_rowset_gc_op.release());
 }
 
 void Tablet::UnregisterMaintenanceOps() {
@@ -1255,7 +1743,24 @@ Status Tablet::DoCompactionOrFlush(const RowSetsInCompaction &input, int64_t mrs
   RollingDiskRowSetWriter drsw(metadata_.get(), merge->schema(), bloom_sizing(),
                                compaction_policy_->target_rowset_size());
   RETURN_NOT_OK_PREPEND(drsw.Open(), "Failed to open DiskRowSet for flush");
-  RETURN_NOT_OK_PREPEND(FlushCompactionInput(merge.get(), flush_snap, &drsw),
+  // Don't carry UNDOs older than the history retention window into the output.
+  Timestamp ancient_history_mark;
+  if (!GetTabletAncientHistoryMark(&ancient_history_mark)) {
+    ancient_history_mark = Timestamp::kMin;
+  }
+  // Drop the rows which had expired by the ancient history mark, keeping
+  // track of them so that phase 2 can skip them too. No snapshot before the
+  // mark may be read, so every replica agrees on which rows are visible
+  // even though each decides on its own which ones to drop.
+  RowExpiry row_expiry;
+  ColumnId ttl_col_id;
+  if (ancient_history_mark != Timestamp::kMin &&
+      GetRowExpiryCutoff(ancient_history_mark, &ttl_col_id, &row_expiry.cutoff_micros)) {
+    row_expiry.col_idx = merge->schema().find_column_by_id(ttl_col_id);
+  }
+  vector<bool> gced_rows;
+  RETURN_NOT_OK_PREPEND(FlushCompactionInput(merge.get(), flush_snap, &drsw,
+                                             ancient_history_mark, row_expiry, &gced_rows),
                         "Flush to disk failed");
   RETURN_NOT_OK_PREPEND(drsw.Finish(), "Failed to finish DRS writer");
 
@@ -1323,8 +1828,9 @@ Status Tablet::DoCompactionOrFlush(const RowSetsInCompaction &input, int64_t mrs
   // no-op.
   LOG_WITH_PREFIX(INFO) << op_name << ": entering phase 2 (starting to duplicate updates "
                         << "in new rowsets)";
+  bool gced_some_input = std::find(gced_rows.begin(), gced_rows.end(), true) != gced_rows.end();
   shared_ptr<DuplicatingRowSet> inprogress_rowset(
-    new DuplicatingRowSet(input.rowsets(), new_disk_rowsets));
+    new DuplicatingRowSet(input.rowsets(), new_disk_rowsets, gced_some_input));
 
   // The next step is to swap in the DuplicatingRowSet, and at the same time, determine an
   // MVCC snapshot which includes all of the transactions that saw a pre-DuplicatingRowSet
@@ -1391,7 +1897,8 @@ Status Tablet::DoCompactionOrFlush(const RowSetsInCompaction &input, int64_t mrs
                                              merge.get(),
                                              flush_snap,
                                              non_duplicated_txns_snap,
-                                             new_disk_rowsets),
+                                             new_disk_rowsets,
+                                             gced_some_input ? &gced_rows : nullptr),
         Substitute("Failed to re-update deltas missed during $0 phase 1",
                      op_name).c_str());
 
@@ -1755,6 +2262,207 @@ Status Tablet::CompactWorstDeltas(RowSet::DeltaCompactionType type) {
   return Status::OK();
 }
 
+int Tablet::GetRowTtlColumnIndex() const {
+  RowTtlPB row_ttl = metadata_->row_ttl();
+  if (row_ttl.ttl_secs() <= 0) {
+    return Schema::kColumnNotFound;
+  }
+  return schema()->find_column_by_id(ColumnId(row_ttl.column_id()));
+}
+
+bool Tablet::GetRowExpiryCutoff(Timestamp expiry_time, ColumnId* col_id,
+                                int64_t* cutoff_micros) const {
+  RowTtlPB row_ttl = metadata_->row_ttl();
+  if (row_ttl.ttl_secs() <= 0 || expiry_time == Timestamp::kMin) {
+    return false;
+  }
+  // As in GetTabletAncientHistoryMark(), only a HybridClock's timestamps
+  // carry physical time.
+  if (!clock_->SupportsExternalConsistencyMode(COMMIT_WAIT)) {
+    return false;
+  }
+  *col_id = ColumnId(row_ttl.column_id());
+  *cutoff_micros = HybridClock::GetPhysicalValueMicros(expiry_time) -
+      row_ttl.ttl_secs() * 1000000L;
+  return true;
+}
+
+bool Tablet::GetTabletAncientHistoryMark(Timestamp* ancient_history_mark) const {
+  if (FLAGS_tablet_history_max_age_sec <= 0) {
+    return false;
+  }
+  // Only a HybridClock's timestamps carry physical time. The logical clocks
+  // used in tests don't support COMMIT_WAIT, so use that to tell them apart.
+  if (!clock_->SupportsExternalConsistencyMode(COMMIT_WAIT)) {
+    return false;
+  }
+  Timestamp now = clock_->Now();
+  MonoDelta max_age = MonoDelta::FromSeconds(FLAGS_tablet_history_max_age_sec);
+  // Clocks which haven't run for longer than the window (e.g. mock clocks
+  // starting at zero) don't have any ancient history yet.
+  if (static_cast<int64_t>(HybridClock::GetPhysicalValueMicros(now)) <=
+      max_age.ToMicroseconds()) {
+    return false;
+  }
+  max_age = MonoDelta::FromMicroseconds(-max_age.ToMicroseconds());
+  *ancient_history_mark = HybridClock::AddPhysicalTimeToTimestamp(now, max_age);
+  return true;
+}
+
+int64_t Tablet::EstimateBytesInPotentiallyAncientUndoDeltas() const {
+  Timestamp ancient_history_mark;
+  if (!GetTabletAncientHistoryMark(&ancient_history_mark)) {
+    return 0;
+  }
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+  int64_t bytes = 0;
+  for (const shared_ptr<RowSet>& rs : comps->rowsets->all_rowsets()) {
+    bytes += rs->EstimateBytesInPotentiallyAncientUndoDeltas(ancient_history_mark);
+  }
+  return bytes;
+}
+
+Status Tablet::DeleteAncientUndoDeltas(int64_t* blocks_deleted, int64_t* bytes_deleted) {
+  CHECK_EQ(state_, kOpen);
+  Timestamp ancient_history_mark;
+  if (!GetTabletAncientHistoryMark(&ancient_history_mark)) {
+    return Status::OK();
+  }
+
+  // Grab the compact_flush_lock of every rowset with potentially ancient
+  // UNDOs, so that a concurrent compaction doesn't select them while we're
+  // swapping out their delta stores. As in PickRowSetsToCompact(), locking
+  // must be done under compact_select_lock_.
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+  RowSetVector to_gc;
+  vector<shared_ptr<boost::mutex::scoped_try_lock> > locks;
+  {
+    boost::lock_guard<boost::mutex> compact_lock(compact_select_lock_);
+    for (const shared_ptr<RowSet>& rs : comps->rowsets->all_rowsets()) {
+      if (rs->EstimateBytesInPotentiallyAncientUndoDeltas(ancient_history_mark) == 0 ||
+          !rs->IsAvailableForCompaction()) {
+        continue;
+      }
+      shared_ptr<boost::mutex::scoped_try_lock> lock(
+          new boost::mutex::scoped_try_lock(*rs->compact_flush_lock()));
+      CHECK(lock->owns_lock());
+      locks.push_back(lock);
+      to_gc.push_back(rs);
+    }
+  }
+
+  int64_t total_blocks_deleted = 0;
+  int64_t total_bytes_deleted = 0;
+  for (const shared_ptr<RowSet>& rs : to_gc) {
+    RETURN_NOT_OK_PREPEND(rs->DeleteAncientUndoDeltas(ancient_history_mark,
+                                                      &total_blocks_deleted,
+                                                      &total_bytes_deleted),
+                          "Failed to delete ancient UNDO deltas of " + rs->ToString());
+  }
+
+  if (metrics_ && total_bytes_deleted > 0) {
+    metrics_->undo_delta_block_gc_bytes_deleted->IncrementBy(total_bytes_deleted);
+  }
+  if (blocks_deleted) {
+    *blocks_deleted = total_blocks_deleted;
+  }
+  if (bytes_deleted) {
+    *bytes_deleted = total_bytes_deleted;
+  }
+  return Status::OK();
+}
+
+int64_t Tablet::EstimateBytesInExpiredRowSets() const {
+  // As in flushes and compactions, rows only expire as of the ancient
+  // history mark.
+  Timestamp ancient_history_mark;
+  ColumnId ttl_col_id;
+  int64_t cutoff_micros;
+  if (!GetTabletAncientHistoryMark(&ancient_history_mark) ||
+      !GetRowExpiryCutoff(ancient_history_mark, &ttl_col_id, &cutoff_micros)) {
+    return 0;
+  }
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+  int64_t bytes = 0;
+  for (const shared_ptr<RowSet>& rs : comps->rowsets->all_rowsets()) {
+    bool all_expired;
+    if (rs->CheckAllRowsExpired(ttl_col_id, cutoff_micros, ancient_history_mark,
+                                &all_expired).ok() && all_expired) {
+      bytes += rs->EstimateOnDiskSize();
+    }
+  }
+  return bytes;
+}
+
+Status Tablet::DeleteExpiredRowSets(int64_t* rows_deleted, int64_t* bytes_deleted) {
+  CHECK_EQ(state_, kOpen);
+  Timestamp ancient_history_mark;
+  ColumnId ttl_col_id;
+  int64_t cutoff_micros;
+  if (!GetTabletAncientHistoryMark(&ancient_history_mark) ||
+      !GetRowExpiryCutoff(ancient_history_mark, &ttl_col_id, &cutoff_micros)) {
+    return Status::OK();
+  }
+
+  // As in DeleteAncientUndoDeltas(), lock the rowsets to delete so that a
+  // concurrent compaction doesn't select them.
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+  RowSetVector to_delete;
+  vector<shared_ptr<boost::mutex::scoped_try_lock> > locks;
+  {
+    boost::lock_guard<boost::mutex> compact_lock(compact_select_lock_);
+    for (const shared_ptr<RowSet>& rs : comps->rowsets->all_rowsets()) {
+      if (!rs->IsAvailableForCompaction()) {
+        continue;
+      }
+      bool all_expired;
+      RETURN_NOT_OK(rs->CheckAllRowsExpired(ttl_col_id, cutoff_micros, ancient_history_mark,
+                                            &all_expired));
+      if (!all_expired) {
+        continue;
+      }
+      shared_ptr<boost::mutex::scoped_try_lock> lock(
+          new boost::mutex::scoped_try_lock(*rs->compact_flush_lock()));
+      CHECK(lock->owns_lock());
+      locks.push_back(lock);
+      to_delete.push_back(rs);
+    }
+  }
+  if (to_delete.empty()) {
+    return Status::OK();
+  }
+
+  int64_t total_rows_deleted = 0;
+  int64_t total_bytes_deleted = 0;
+  for (const shared_ptr<RowSet>& rs : to_delete) {
+    rowid_t num_rows;
+    RETURN_NOT_OK(rs->CountRows(&num_rows));
+    total_rows_deleted += num_rows;
+    total_bytes_deleted += rs->EstimateOnDiskSize();
+  }
+
+  // Like a compaction whose output is empty: the rowsets' blocks become
+  // orphans once the metadata is flushed.
+  RETURN_NOT_OK(HandleEmptyCompactionOrFlush(to_delete, TabletMetadata::kNoMrsFlushed));
+  LOG_WITH_PREFIX(INFO) << "Deleted " << to_delete.size() << " expired rowsets";
+
+  if (metrics_) {
+    metrics_->expired_rowset_gc_rows_deleted->IncrementBy(total_rows_deleted);
+    metrics_->expired_rowset_gc_bytes_deleted->IncrementBy(total_bytes_deleted);
+  }
+  if (rows_deleted) {
+    *rows_deleted = total_rows_deleted;
+  }
+  if (bytes_deleted) {
+    *bytes_deleted = total_bytes_deleted;
+  }
+  return Status::OK();
+}
+
 double Tablet::GetPerfImprovementForBestDeltaCompact(RowSet::DeltaCompactionType type,
                                                              shared_ptr<RowSet>* rs) const {
   boost::lock_guard<boost::mutex> compact_lock(compact_select_lock_);
@@ -1837,11 +2545,14 @@ string Tablet::LogPrefix() const {
 ////////////////////////////////////////////////////////////
 
 Tablet::Iterator::Iterator(const Tablet* tablet, const Schema& projection,
-                           MvccSnapshot snap, const OrderMode order)
+                           MvccSnapshot snap, const OrderMode order,
+                           Timestamp expiry_time)
     : tablet_(tablet),
       projection_(projection),
       snap_(std::move(snap)),
-      order_(order) {}
+      order_(order),
+      expiry_time_(expiry_time),
+      expiry_cutoff_micros_(0) {}
 
 Tablet::Iterator::~Iterator() {}
 
@@ -1850,6 +2561,20 @@ Status Tablet::Iterator::Init(ScanSpec *spec) {
 
   RETURN_NOT_OK(tablet_->GetMappedReadProjection(projection_, &projection_));
 
+  // Hide expired rows with a predicate on the TTL column, if it's projected.
+  ColumnId ttl_col_id;
+  if (tablet_->GetRowExpiryCutoff(expiry_time_, &ttl_col_id, &expiry_cutoff_micros_)) {
+    int ttl_col_idx = projection_.find_column_by_id(ttl_col_id);
+    if (ttl_col_idx != Schema::kColumnNotFound) {
+      if (spec == nullptr) {
+        owned_spec_.reset(new ScanSpec());
+        spec = owned_spec_.get();
+      }
+      spec->AddPredicate(ColumnPredicate::Range(projection_.column(ttl_col_idx),
+                                                &expiry_cutoff_micros_, nullptr));
+    }
+  }
+
   vector<shared_ptr<RowwiseIterator>> iters;
 
   RETURN_NOT_OK(tablet_->CaptureConsistentIterators(&projection_, snap_, spec, &iters));
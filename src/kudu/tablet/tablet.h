@@ -64,6 +64,7 @@ class MaintenanceOpStats;
 namespace tablet {
 
 class AlterSchemaTransactionState;
+class BulkIngestTransactionState;
 class CompactionPolicy;
 class MemRowSet;
 class MvccSnapshot;
@@ -155,24 +156,6 @@ class Tablet {
   // it's not the first thing in a transaction!
   void StartTransaction(WriteTransactionState* tx_state);
 
-  // Insert a new row into the tablet.
-  //
-  // The provided 'data' slice should have length equivalent to this
-  // tablet's Schema.byte_size().
-  //
-  // After insert, the row and any referred-to memory (eg for strings)
-  // have been copied into internal memory, and thus the provided memory
-  // buffer may safely be re-used or freed.
-  //
-  // Returns Status::AlreadyPresent() if an entry with the same key is already
-  // present in the tablet.
-  // Returns Status::OK unless allocation fails.
-  //
-  // Acquires the row lock for the given operation, setting it in the
-  // RowOp struct. This also sets the row op's RowSetKeyProbe.
-  Status AcquireLockForOp(WriteTransactionState* tx_state,
-                          RowOp* op);
-
   // Signal that the given transaction is about to Apply.
   void StartApplying(WriteTransactionState* tx_state);
 
@@ -185,8 +168,18 @@ class Tablet {
                          RowOp* row_op,
                          ProbeStats* stats);
 
+  // Used during bootstrap to replay an INSERT or UPSERT which replaced an
+  // expired row, when the row it inserted has been flushed but the deletion
+  // of the expired row hasn't. Only the deletion is applied again, to the
+  // stores recorded in the original result. The result is set back into
+  // row_op->result.
+  void ReplayExpiredRowDeletion(WriteTransactionState* tx_state,
+                                RowOp* row_op,
+                                ProbeStats* stats);
+
   // Create a new row iterator which yields the rows as of the current MVCC
-  // state of this tablet.
+  // state of this tablet. Rows which have expired as of the current time are
+  // hidden.
   // The returned iterator is not initialized.
   Status NewRowIterator(const Schema &projection,
                         gscoped_ptr<RowwiseIterator> *iter) const;
@@ -197,12 +190,41 @@ class Tablet {
     ORDERED = 1
   };
 
-  // Create a new row iterator for some historical snapshot.
+  // Create a new row iterator for some historical snapshot. Rows which had
+  // expired as of the snapshot's timestamp (or the current time, if that's
+  // earlier) are hidden.
+  Status NewRowIterator(const Schema &projection,
+                        const MvccSnapshot &snap,
+                        const OrderMode order,
+                        gscoped_ptr<RowwiseIterator> *iter) const;
+
+  // Same as above, but hides the rows which had expired as of 'expiry_time'.
   Status NewRowIterator(const Schema &projection,
                         const MvccSnapshot &snap,
                         const OrderMode order,
+                        Timestamp expiry_time,
                         gscoped_ptr<RowwiseIterator> *iter) const;
 
+  // Convert the specified read client schema (without IDs) to a server schema (with IDs)
+  // This method is used by NewRowIterator() and by callers of GetRow().
+  Status GetMappedReadProjection(const Schema& projection,
+                                 Schema *mapped_projection) const;
+
+  // Look up the single row identified by 'probe' as of 'snap', without
+  // building a full scan iterator. The row is read into 'dst', which must be
+  // a single-row block whose schema has been mapped by GetMappedReadProjection().
+  //
+  // Sets *present to false if no row with the given key is visible in 'snap',
+  // or if the row had expired as of the hybrid time 'expiry_time' and 'dst'
+  // includes the row TTL column. Snapshot reads should pass the snapshot's
+  // timestamp, so that every replica returns the same result.
+  // Returns NotFound if the key does not belong to this tablet's partition.
+  Status GetRow(const RowSetKeyProbe& probe,
+                const MvccSnapshot& snap,
+                Timestamp expiry_time,
+                RowBlock* dst,
+                bool* present) const;
+
   // Flush the current MemRowSet for this tablet to disk. This swaps
   // in a new (initially empty) MemRowSet in its place.
   //
@@ -220,6 +242,30 @@ class Tablet {
   // This operation will trigger a flush on the current MemRowSet.
   Status AlterSchema(AlterSchemaTransactionState* tx_state);
 
+  // Decode the rows of a bulk ingest request, checking that they are all
+  // inserts of rows of this tablet, sorted by strictly increasing key.
+  Status DecodeBulkIngestRows(const Schema* client_schema,
+                              BulkIngestTransactionState* tx_state);
+
+  // Returns AlreadyPresent if the tablet has rows between the first and the
+  // last key of the rows of the bulk ingest, including rows of transactions
+  // which are not yet committed.
+  Status CheckBulkIngestKeyRangeEmpty(const BulkIngestTransactionState* tx_state) const;
+
+  // Assign the bulk ingest a timestamp and start its MVCC transaction.
+  void StartTransaction(BulkIngestTransactionState* tx_state);
+
+  // Write the rows of the bulk ingest into new DiskRowSets, bypassing the
+  // MemRowSet, and add them to the tablet. Each row carries an UNDO which
+  // deletes it as of the ingest's timestamp, as if it had been inserted and
+  // flushed.
+  //
+  // Does nothing if the rowsets of this bulk ingest were already added to
+  // the tablet metadata before a restart. Returns AlreadyPresent, without
+  // writing anything, if the tablet already has rows in the key range of the
+  // ingested rows.
+  Status BulkIngest(BulkIngestTransactionState* tx_state);
+
   // Rewind the schema to an earlier version than is written in the on-disk
   // metadata. This is done during bootstrap to roll the schema back to the
   // point in time where the logs-to-be-replayed begin, so we can then decode
@@ -299,6 +345,61 @@ class Tablet {
   double GetPerfImprovementForBestDeltaCompactUnlocked(RowSet::DeltaCompactionType type,
                                                        std::shared_ptr<RowSet>* rs) const;
 
+  // Return the "ancient history mark": the earliest timestamp at which
+  // snapshot reads are still guaranteed to see accurate history, as configured
+  // by --tablet_history_max_age_sec. UNDO deltas older than the mark may be
+  // garbage collected.
+  //
+  // Returns false if history GC isn't possible for this tablet, e.g. because
+  // its clock doesn't track physical time, in which case all history is kept.
+  bool GetTabletAncientHistoryMark(Timestamp* ancient_history_mark) const;
+
+  // Estimate the number of bytes in UNDO delta blocks which may be deleted
+  // by DeleteAncientUndoDeltas(). Returns 0 if history GC isn't possible.
+  int64_t EstimateBytesInPotentiallyAncientUndoDeltas() const;
+
+  // Delete the UNDO delta blocks of every rowset which only hold history
+  // older than the ancient history mark. Rowsets that are being flushed or
+  // compacted are skipped; their ancient UNDOs are dropped by the compaction.
+  //
+  // The number of blocks and bytes deleted are returned in the output
+  // parameters, which may be NULL.
+  Status DeleteAncientUndoDeltas(int64_t* blocks_deleted, int64_t* bytes_deleted);
+
+  // Returns the index in schema() of the table's row TTL column, or
+  // Schema::kColumnNotFound if the table has no row TTL.
+  //
+  // Readers only hide expired rows if their projection includes the TTL
+  // column, so scans which must honor the TTL should add it to theirs.
+  int GetRowTtlColumnIndex() const;
+
+  // If the table has a row TTL, sets 'col_id' to its TTL column and
+  // 'cutoff_micros' to the time before which rows had expired as of the
+  // hybrid time 'expiry_time', and returns true. Returns false if the table
+  // has no row TTL, if the tablet's clock doesn't carry physical time, or if
+  // 'expiry_time' is Timestamp::kMin, at which no row has expired.
+  //
+  // Expiry is evaluated at replicated timestamps rather than at the local
+  // wall clock time, so that every replica agrees on it: writes at their
+  // transaction's timestamp, snapshot reads at the snapshot's timestamp, and
+  // flushes and compactions, which drop expired rows, at the ancient history
+  // mark, before which no snapshot may be read.
+  bool GetRowExpiryCutoff(Timestamp expiry_time, ColumnId* col_id,
+                          int64_t* cutoff_micros) const;
+
+  // Estimate the number of bytes in rowsets whose rows had all expired by the
+  // ancient history mark, which may be deleted by DeleteExpiredRowSets().
+  int64_t EstimateBytesInExpiredRowSets() const;
+
+  // Delete the rowsets whose rows had all expired by the ancient history
+  // mark, and which hold no history since, without rewriting them.
+  // Rowsets that are being flushed or compacted are skipped; their expired
+  // rows are dropped by the compaction.
+  //
+  // The number of rows and bytes deleted are returned in the output
+  // parameters, which may be NULL.
+  Status DeleteExpiredRowSets(int64_t* rows_deleted, int64_t* bytes_deleted);
+
   // Return the current number of rowsets in the tablet.
   size_t num_rowsets() const;
 
@@ -405,6 +506,28 @@ class Tablet {
                              RowSet* rowset,
                              ProbeStats* stats);
 
+  // In the case of an INSERT or UPSERT against a row which has expired,
+  // deletes the expired row from 'rowset' and inserts the new row into the
+  // MemRowSet in its place, as if the expired row were absent.
+  Status ReplaceExpiredRowUnlocked(WriteTransactionState* tx_state,
+                                   RowOp* op,
+                                   RowSet* rowset,
+                                   ProbeStats* stats);
+
+  // Sets '*expired' to true if the version of the row targeted by 'op' which
+  // 'rowset' holds had expired as of the transaction's timestamp, in which
+  // case writes treat the row as absent. Sets it to false if 'rowset' holds
+  // no live version of the row.
+  //
+  // When replaying the log, the expiry isn't evaluated again, since the row
+  // TTL may have been altered since: the original result tells whether an
+  // expired row was replaced.
+  Status CheckRowExpiredUnlocked(const WriteTransactionState* tx_state,
+                                 const RowOp* op,
+                                 const RowSet* rowset,
+                                 ProbeStats* stats,
+                                 bool* expired) const;
+
   // Return the list of RowSets that need to be consulted when processing the
   // given mutation.
   static std::vector<RowSet*> FindRowSetsToCheck(RowOp* mutate,
@@ -474,11 +597,6 @@ class Tablet {
 
   BloomFilterSizing bloom_sizing() const;
 
-  // Convert the specified read client schema (without IDs) to a server schema (with IDs)
-  // This method is used by NewRowIterator().
-  Status GetMappedReadProjection(const Schema& projection,
-                                 Schema *mapped_projection) const;
-
   Status CheckRowInTablet(const ConstContiguousRow& probe) const;
 
   // Helper method to find the rowset that has the DMS with the highest retention.
@@ -631,13 +749,19 @@ class Tablet::Iterator : public RowwiseIterator {
   DISALLOW_COPY_AND_ASSIGN(Iterator);
 
   Iterator(const Tablet* tablet, const Schema& projection, MvccSnapshot snap,
-           const OrderMode order);
+           const OrderMode order, Timestamp expiry_time);
 
   const Tablet *tablet_;
   Schema projection_;
   const MvccSnapshot snap_;
   const OrderMode order_;
   gscoped_ptr<RowwiseIterator> iter_;
+
+  // The time as of which expired rows are hidden, the bound of the predicate
+  // which hides them, and the spec it's added to if Init() wasn't passed one.
+  const Timestamp expiry_time_;
+  int64_t expiry_cutoff_micros_;
+  gscoped_ptr<ScanSpec> owned_spec_;
 };
 
 // Structure which represents the components of the tablet's storage.
@@ -48,6 +48,7 @@
 #include "kudu/tablet/tablet.h"
 #include "kudu/tablet/tablet_peer.h"
 #include "kudu/tablet/transactions/alter_schema_transaction.h"
+#include "kudu/tablet/transactions/bulk_ingest_transaction.h"
 #include "kudu/tablet/transactions/write_transaction.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/fault_injection.h"
@@ -74,6 +75,7 @@ namespace tablet {
 
 using boost::shared_lock;
 using consensus::ALTER_SCHEMA_OP;
+using consensus::BULK_INGEST_OP;
 using consensus::CHANGE_CONFIG_OP;
 using consensus::ChangeConfigRecordPB;
 using consensus::CommitMsg;
@@ -106,6 +108,7 @@ using std::unique_ptr;
 using std::unordered_map;
 using strings::Substitute;
 using tserver::AlterSchemaRequestPB;
+using tserver::BulkIngestRequestPB;
 using tserver::WriteRequestPB;
 
 struct ReplayState;
@@ -226,6 +229,9 @@ class TabletBootstrap {
   Status PlayAlterSchemaRequest(ReplicateMsg* replicate_msg,
                                 const CommitMsg& commit_msg);
 
+  Status PlayBulkIngestRequest(ReplicateMsg* replicate_msg,
+                               const CommitMsg& commit_msg);
+
   Status PlayChangeConfigRequest(ReplicateMsg* replicate_msg,
                                  const CommitMsg& commit_msg);
 
@@ -258,6 +264,15 @@ class TabletBootstrap {
   Status FilterOperation(const OperationResultPB& op_result,
                          bool* already_flushed);
 
+  // Sets '*any_active' to whether any of 'stores', which a mutation in
+  // 'op_result' was applied to, is still active. There may be two stores if
+  // the mutation was duplicated during a compaction, but they can't both be
+  // active.
+  Status CheckDuplicatedStores(
+      const OperationResultPB& op_result,
+      const google::protobuf::RepeatedPtrField<MemStoreTargetPB>& stores,
+      bool* any_active);
+
   // Returns true if any of the memory stores referenced in 'commit' are still
   // active, in which case the operation needs to be replayed.
   bool AreAnyStoresActive(const CommitMsg& commit);
@@ -878,6 +893,11 @@ bool TabletBootstrap::AreAnyStoresActive(const CommitMsg& commit) {
         return true;
       }
     }
+    for (const MemStoreTargetPB& expired_row_store : op_result.expired_row_stores()) {
+      if (flushed_stores_.IsMemStoreActive(expired_row_store)) {
+        return true;
+      }
+    }
   }
   return false;
 }
@@ -950,6 +970,10 @@ Status TabletBootstrap::HandleEntryPair(LogEntryPB* replicate_entry, LogEntryPB*
       RETURN_NOT_OK_REPLAY(PlayAlterSchemaRequest, replicate, commit);
       break;
 
+    case BULK_INGEST_OP:
+      RETURN_NOT_OK_REPLAY(PlayBulkIngestRequest, replicate, commit);
+      break;
+
     case CHANGE_CONFIG_OP:
       RETURN_NOT_OK_REPLAY(PlayChangeConfigRequest, replicate, commit);
       break;
@@ -1253,6 +1277,38 @@ Status TabletBootstrap::PlayAlterSchemaRequest(ReplicateMsg* replicate_msg,
   return AppendCommitMsg(commit_msg);
 }
 
+Status TabletBootstrap::PlayBulkIngestRequest(ReplicateMsg* replicate_msg,
+                                              const CommitMsg& commit_msg) {
+  DCHECK(replicate_msg->has_timestamp());
+  const BulkIngestRequestPB& bulk_ingest = replicate_msg->bulk_ingest_request();
+
+  // Bulk ingests which were rejected because their key range wasn't empty
+  // had no effect on the tablet.
+  if (commit_msg.result().ops_size() > 0 &&
+      commit_msg.result().ops(0).has_failed_status()) {
+    stats_.ops_ignored++;
+    return AppendCommitMsg(commit_msg);
+  }
+
+  Schema client_schema;
+  RETURN_NOT_OK(SchemaFromPB(bulk_ingest.schema(), &client_schema));
+
+  BulkIngestTransactionState tx_state(nullptr, &bulk_ingest, nullptr);
+  tx_state.mutable_op_id()->CopyFrom(replicate_msg->id());
+  tx_state.set_timestamp(Timestamp(replicate_msg->timestamp()));
+
+  RETURN_NOT_OK(tablet_->DecodeBulkIngestRows(&client_schema, &tx_state));
+
+  // Start the transaction even if its rowsets were already flushed to the
+  // tablet metadata, so that MVCC advances. Tablet::BulkIngest() skips
+  // those itself.
+  tablet_->StartTransaction(&tx_state);
+  RETURN_NOT_OK_PREPEND(tablet_->BulkIngest(&tx_state), "Failed to BulkIngest:");
+  tx_state.CommitOrAbort(Transaction::COMMITTED);
+
+  return AppendCommitMsg(commit_msg);
+}
+
 Status TabletBootstrap::PlayChangeConfigRequest(ReplicateMsg* replicate_msg,
                                                 const CommitMsg& commit_msg) {
   ChangeConfigRecordPB* change_config = replicate_msg->mutable_change_config_record();
@@ -1367,9 +1423,18 @@ Status TabletBootstrap::ApplyOperations(WriteTransactionState* tx_state,
       continue;
     }
 
-    // Actually apply it.
+    // Actually apply it. If the op replaced an expired row and the row it
+    // inserted has already been flushed, only the deletion of the expired
+    // row needs to be applied again.
     ProbeStats stats; // we don't use this, but tablet internals require non-NULL.
-    tablet_->ApplyRowOperation(tx_state, op, &stats);
+    bool any_mutated_store_active;
+    RETURN_NOT_OK(CheckDuplicatedStores(orig_op_result, orig_op_result.mutated_stores(),
+                                        &any_mutated_store_active));
+    if (any_mutated_store_active) {
+      tablet_->ApplyRowOperation(tx_state, op, &stats);
+    } else {
+      tablet_->ReplayExpiredRowDeletion(tx_state, op, &stats);
+    }
     DCHECK(op->result != nullptr);
 
     // We expect that the above Apply() will always succeed, because we're
@@ -1400,22 +1465,38 @@ Status TabletBootstrap::FilterOperation(const OperationResultPB& op_result,
     return Status::Corruption(Substitute("All operations must have one or two mutated_stores: $0",
                                          op_result.ShortDebugString()));
   }
+  if (PREDICT_FALSE(op_result.expired_row_stores_size() > 2)) {
+    return Status::Corruption(Substitute("Operations may have at most two expired_row_stores: $0",
+                                         op_result.ShortDebugString()));
+  }
+
+  // An INSERT or UPSERT which replaced an expired row also needs to be
+  // replayed if only the deletion of the expired row wasn't flushed.
+  bool any_mutated_store_active;
+  RETURN_NOT_OK(CheckDuplicatedStores(op_result, op_result.mutated_stores(),
+                                      &any_mutated_store_active));
+  bool any_expired_row_store_active;
+  RETURN_NOT_OK(CheckDuplicatedStores(op_result, op_result.expired_row_stores(),
+                                      &any_expired_row_store_active));
+
+  // If neither was active, the operation was fully flushed.
+  *already_flushed = !any_mutated_store_active && !any_expired_row_store_active;
+  return Status::OK();
+}
 
+Status TabletBootstrap::CheckDuplicatedStores(
+    const OperationResultPB& op_result,
+    const google::protobuf::RepeatedPtrField<MemStoreTargetPB>& stores,
+    bool* any_active) {
   // The mutation may have been duplicated, so we'll check whether any of the
   // output targets was active.
   int num_active_stores = 0;
-  for (const MemStoreTargetPB& mutated_store : op_result.mutated_stores()) {
-    if (flushed_stores_.IsMemStoreActive(mutated_store)) {
+  for (const MemStoreTargetPB& store : stores) {
+    if (flushed_stores_.IsMemStoreActive(store)) {
       num_active_stores++;
     }
   }
 
-  if (num_active_stores == 0) {
-    // The mutation was fully flushed.
-    *already_flushed = true;
-    return Status::OK();
-  }
-
   if (PREDICT_FALSE(num_active_stores == 2)) {
     // It's not possible for a duplicated mutation to refer to two stores which are still
     // active. Either the mutation arrived before the metadata was flushed, in which case
@@ -1426,7 +1507,7 @@ Status TabletBootstrap::FilterOperation(const OperationResultPB& op_result,
                               op_result.ShortDebugString());
   }
 
-  *already_flushed = false;
+  *any_active = num_active_stores > 0;
   return Status::OK();
 }
 
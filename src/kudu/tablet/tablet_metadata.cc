@@ -217,6 +217,7 @@ TabletMetadata::TabletMetadata(FsManager* fs_manager, string tablet_id,
       fs_manager_(fs_manager),
       next_rowset_idx_(0),
       last_durable_mrs_id_(kNoDurableMemStore),
+      last_bulk_ingest_op_index_(-1),
       schema_(new Schema(schema)),
       schema_version_(0),
       table_name_(std::move(table_name)),
@@ -240,6 +241,7 @@ TabletMetadata::TabletMetadata(FsManager* fs_manager, string tablet_id)
       tablet_id_(std::move(tablet_id)),
       fs_manager_(fs_manager),
       next_rowset_idx_(0),
+      last_bulk_ingest_op_index_(-1),
       schema_(nullptr),
       tombstone_last_logged_opid_(MinimumOpId()),
       num_flush_pins_(0),
@@ -278,8 +280,10 @@ Status TabletMetadata::LoadFromSuperBlock(const TabletSuperBlockPB& superblock)
 
     table_id_ = superblock.table_id();
     last_durable_mrs_id_ = superblock.last_durable_mrs_id();
+    last_bulk_ingest_op_index_ = superblock.last_bulk_ingest_op_index();
 
     table_name_ = superblock.table_name();
+    row_ttl_ = superblock.row_ttl();
 
     uint32_t schema_version = superblock.schema_version();
     gscoped_ptr<Schema> schema(new Schema());
@@ -350,6 +354,22 @@ Status TabletMetadata::UpdateAndFlush(const RowSetMetadataIds& to_remove,
   return Flush();
 }
 
+Status TabletMetadata::AddBulkIngestRowSetsAndFlush(const RowSetMetadataVector& to_add,
+                                                    int64_t op_index) {
+  {
+    boost::lock_guard<LockType> l(data_lock_);
+    DCHECK_GT(op_index, last_bulk_ingest_op_index_);
+    RETURN_NOT_OK(UpdateUnlocked(RowSetMetadataIds(), to_add, kNoMrsFlushed));
+    last_bulk_ingest_op_index_ = op_index;
+  }
+  return Flush();
+}
+
+int64_t TabletMetadata::last_bulk_ingest_op_index() const {
+  boost::lock_guard<LockType> l(data_lock_);
+  return last_bulk_ingest_op_index_;
+}
+
 void TabletMetadata::AddOrphanedBlocks(const vector<BlockId>& blocks) {
   boost::lock_guard<LockType> l(data_lock_);
   AddOrphanedBlocksUnlocked(blocks);
@@ -528,9 +548,15 @@ Status TabletMetadata::ToSuperBlockUnlocked(TabletSuperBlockPB* super_block,
   pb.set_tablet_id(tablet_id_);
   partition_.ToPB(pb.mutable_partition());
   pb.set_last_durable_mrs_id(last_durable_mrs_id_);
+  if (last_bulk_ingest_op_index_ >= 0) {
+    pb.set_last_bulk_ingest_op_index(last_bulk_ingest_op_index_);
+  }
   pb.set_schema_version(schema_version_);
   partition_schema_.ToPB(pb.mutable_partition_schema());
   pb.set_table_name(table_name_);
+  if (row_ttl_.ttl_secs() > 0) {
+    pb.mutable_row_ttl()->CopyFrom(row_ttl_);
+  }
 
   for (const shared_ptr<RowSetMetadata>& meta : rowsets) {
     meta->ToProtobuf(pb.add_rowsets());
@@ -606,6 +632,16 @@ void TabletMetadata::SetTableName(const string& table_name) {
   table_name_ = table_name;
 }
 
+RowTtlPB TabletMetadata::row_ttl() const {
+  boost::lock_guard<LockType> l(data_lock_);
+  return row_ttl_;
+}
+
+void TabletMetadata::SetRowTtl(const RowTtlPB& row_ttl) {
+  boost::lock_guard<LockType> l(data_lock_);
+  row_ttl_ = row_ttl;
+}
+
 string TabletMetadata::table_name() const {
   boost::lock_guard<LockType> l(data_lock_);
   DCHECK_NE(state_, kNotLoadedYet);
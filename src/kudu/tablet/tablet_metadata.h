@@ -116,6 +116,14 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
 
   void SetTableName(const std::string& table_name);
 
+  // Returns the time-to-live of the table's rows. 'ttl_secs' is 0 if the
+  // table has no row TTL.
+  RowTtlPB row_ttl() const;
+
+  // Sets the time-to-live of the table's rows. Like SetSchema(), doesn't
+  // flush the metadata.
+  void SetRowTtl(const RowTtlPB& row_ttl);
+
   // Return a reference to the current schema.
   // This pointer will be valid until the TabletMetadata is destructed,
   // even if the schema is changed.
@@ -158,6 +166,12 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
                         const RowSetMetadataVector& to_add,
                         int64_t last_durable_mrs_id);
 
+  // Adds the rowsets written by the bulk ingest with log index 'op_index'
+  // and flushes the metadata. The index is flushed along with the rowsets,
+  // so that the bulk ingest is not applied again if it is replayed.
+  Status AddBulkIngestRowSetsAndFlush(const RowSetMetadataVector& to_add,
+                                      int64_t op_index);
+
   // Adds the blocks referenced by 'block_ids' to 'orphaned_blocks_'.
   //
   // This set will be written to the on-disk metadata in any subsequent
@@ -201,6 +215,8 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
 
   void SetLastDurableMrsIdForTests(int64_t mrs_id) { last_durable_mrs_id_ = mrs_id; }
 
+  int64_t last_bulk_ingest_op_index() const;
+
   void SetPreFlushCallback(StatusClosure callback) { pre_flush_callback_ = callback; }
 
   consensus::OpId tombstone_last_logged_opid() const { return tombstone_last_logged_opid_; }
@@ -303,6 +319,9 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
 
   int64_t last_durable_mrs_id_;
 
+  // Protected by 'data_lock_'.
+  int64_t last_bulk_ingest_op_index_;
+
   // The current schema version. This is owned by this class.
   // We don't use gscoped_ptr so that we can do an atomic swap.
   Schema* schema_;
@@ -310,6 +329,9 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   std::string table_name_;
   PartitionSchema partition_schema_;
 
+  // Protected by 'data_lock_'.
+  RowTtlPB row_ttl_;
+
   // Previous values of 'schema_'.
   // These are currently kept alive forever, under the assumption that
   // a given tablet won't have thousands of "alter table" calls.
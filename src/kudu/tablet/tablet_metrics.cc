@@ -38,6 +38,10 @@ METRIC_DEFINE_counter(tablet, rows_updated, "Rows Updated",
 METRIC_DEFINE_counter(tablet, rows_deleted, "Rows Deleted",
     kudu::MetricUnit::kRows,
     "Number of row delete operations performed on this tablet since service start");
+METRIC_DEFINE_counter(tablet, rows_bulk_ingested, "Rows Bulk Ingested",
+    kudu::MetricUnit::kRows,
+    "Number of rows written directly to new DiskRowSets by bulk ingests into "
+    "this tablet since service start");
 
 METRIC_DEFINE_counter(tablet, scanner_rows_returned, "Scanner Rows Returned",
                       kudu::MetricUnit::kRows,
@@ -91,9 +95,25 @@ METRIC_DEFINE_counter(tablet, scanner_bytes_scanned_from_disk, "Scanner Bytes Sc
 METRIC_DEFINE_counter(tablet, insertions_failed_dup_key, "Duplicate Key Inserts",
                       kudu::MetricUnit::kRows,
                       "Number of inserts which failed because the key already existed");
+METRIC_DEFINE_counter(tablet, insertions_fast_path, "Fast Path Inserts",
+                      kudu::MetricUnit::kRows,
+                      "Number of inserts and upserts whose key was greater than every "
+                      "flushed key, and which therefore skipped the DiskRowSet presence "
+                      "checks");
 METRIC_DEFINE_counter(tablet, scans_started, "Scans Started",
                       kudu::MetricUnit::kScanners,
                       "Number of scanners which have been started on this tablet");
+METRIC_DEFINE_counter(tablet, multi_get_keys_requested, "MultiGet Keys Requested",
+                      kudu::MetricUnit::kRows,
+                      "Number of primary keys looked up by MultiGet requests on this tablet");
+METRIC_DEFINE_counter(tablet, multi_get_rows_returned, "MultiGet Rows Returned",
+                      kudu::MetricUnit::kRows,
+                      "Number of rows found and returned to clients by MultiGet requests "
+                      "on this tablet");
+METRIC_DEFINE_counter(tablet, follower_snapshot_scans, "Follower Snapshot Scans",
+                      kudu::MetricUnit::kScanners,
+                      "Number of READ_AT_SNAPSHOT scanners which have been started on this "
+                      "tablet while it was not the leader");
 
 METRIC_DEFINE_counter(tablet, bloom_lookups, "Bloom Filter Lookups",
                       kudu::MetricUnit::kProbes,
@@ -182,6 +202,16 @@ METRIC_DEFINE_gauge_uint32(tablet, delta_major_compact_rs_running,
   kudu::MetricUnit::kMaintenanceOperations,
   "Number of delta major compactions currently running.");
 
+METRIC_DEFINE_gauge_uint32(tablet, undo_delta_block_gc_running,
+  "Undo Delta Block GC Running",
+  kudu::MetricUnit::kMaintenanceOperations,
+  "Number of UNDO delta block GC operations currently running.");
+
+METRIC_DEFINE_gauge_uint32(tablet, expired_rowset_gc_running,
+  "Expired RowSet GC Running",
+  kudu::MetricUnit::kMaintenanceOperations,
+  "Number of expired rowset GC operations currently running.");
+
 METRIC_DEFINE_histogram(tablet, flush_dms_duration,
   "DeltaMemStore Flush Duration",
   kudu::MetricUnit::kMilliseconds,
@@ -207,6 +237,34 @@ METRIC_DEFINE_histogram(tablet, delta_major_compact_rs_duration,
   kudu::MetricUnit::kSeconds,
   "Seconds spent major delta compacting.", 60000000LU, 2);
 
+METRIC_DEFINE_histogram(tablet, undo_delta_block_gc_duration,
+  "Undo Delta Block GC Duration",
+  kudu::MetricUnit::kMilliseconds,
+  "Time spent deleting ancient UNDO delta blocks.", 60000LU, 1);
+
+METRIC_DEFINE_counter(tablet, undo_delta_block_gc_bytes_deleted,
+  "Undo Delta Block GC Bytes Deleted",
+  kudu::MetricUnit::kBytes,
+  "Number of bytes deleted by garbage-collecting UNDO delta blocks older than "
+  "the tablet history retention window.");
+
+METRIC_DEFINE_histogram(tablet, expired_rowset_gc_duration,
+  "Expired RowSet GC Duration",
+  kudu::MetricUnit::kMilliseconds,
+  "Time spent deleting rowsets whose rows have all expired.", 60000LU, 1);
+
+METRIC_DEFINE_counter(tablet, expired_rowset_gc_rows_deleted,
+  "Expired RowSet GC Rows Deleted",
+  kudu::MetricUnit::kRows,
+  "Number of rows deleted by garbage-collecting rowsets whose rows have all "
+  "expired according to the table's row TTL.");
+
+METRIC_DEFINE_counter(tablet, expired_rowset_gc_bytes_deleted,
+  "Expired RowSet GC Bytes Deleted",
+  kudu::MetricUnit::kBytes,
+  "Number of bytes deleted by garbage-collecting rowsets whose rows have all "
+  "expired according to the table's row TTL.");
+
 METRIC_DEFINE_counter(tablet, leader_memory_pressure_rejections,
   "Leader Memory Pressure Rejections",
   kudu::MetricUnit::kRequests,
@@ -226,7 +284,9 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(rows_upserted),
     MINIT(rows_updated),
     MINIT(rows_deleted),
+    MINIT(rows_bulk_ingested),
     MINIT(insertions_failed_dup_key),
+    MINIT(insertions_fast_path),
     MINIT(scanner_rows_returned),
     MINIT(scanner_cells_returned),
     MINIT(scanner_bytes_returned),
@@ -234,6 +294,9 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(scanner_cells_scanned_from_disk),
     MINIT(scanner_bytes_scanned_from_disk),
     MINIT(scans_started),
+    MINIT(follower_snapshot_scans),
+    MINIT(multi_get_keys_requested),
+    MINIT(multi_get_rows_returned),
     MINIT(bloom_lookups),
     MINIT(key_file_lookups),
     MINIT(delta_file_lookups),
@@ -251,11 +314,18 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     GINIT(compact_rs_running),
     GINIT(delta_minor_compact_rs_running),
     GINIT(delta_major_compact_rs_running),
+    GINIT(undo_delta_block_gc_running),
+    GINIT(expired_rowset_gc_running),
     MINIT(flush_dms_duration),
     MINIT(flush_mrs_duration),
     MINIT(compact_rs_duration),
     MINIT(delta_minor_compact_rs_duration),
     MINIT(delta_major_compact_rs_duration),
+    MINIT(undo_delta_block_gc_duration),
+    MINIT(undo_delta_block_gc_bytes_deleted),
+    MINIT(expired_rowset_gc_duration),
+    MINIT(expired_rowset_gc_rows_deleted),
+    MINIT(expired_rowset_gc_bytes_deleted),
     MINIT(leader_memory_pressure_rejections) {
 }
 #undef MINIT
@@ -50,7 +50,9 @@ struct TabletMetrics {
   scoped_refptr<Counter> rows_upserted;
   scoped_refptr<Counter> rows_updated;
   scoped_refptr<Counter> rows_deleted;
+  scoped_refptr<Counter> rows_bulk_ingested;
   scoped_refptr<Counter> insertions_failed_dup_key;
+  scoped_refptr<Counter> insertions_fast_path;
   scoped_refptr<Counter> scanner_rows_returned;
   scoped_refptr<Counter> scanner_cells_returned;
   scoped_refptr<Counter> scanner_bytes_returned;
@@ -58,6 +60,9 @@ struct TabletMetrics {
   scoped_refptr<Counter> scanner_cells_scanned_from_disk;
   scoped_refptr<Counter> scanner_bytes_scanned_from_disk;
   scoped_refptr<Counter> scans_started;
+  scoped_refptr<Counter> follower_snapshot_scans;
+  scoped_refptr<Counter> multi_get_keys_requested;
+  scoped_refptr<Counter> multi_get_rows_returned;
 
   // Probe stats
   scoped_refptr<Counter> bloom_lookups;
@@ -80,12 +85,19 @@ struct TabletMetrics {
   scoped_refptr<AtomicGauge<uint32_t> > compact_rs_running;
   scoped_refptr<AtomicGauge<uint32_t> > delta_minor_compact_rs_running;
   scoped_refptr<AtomicGauge<uint32_t> > delta_major_compact_rs_running;
+  scoped_refptr<AtomicGauge<uint32_t> > undo_delta_block_gc_running;
+  scoped_refptr<AtomicGauge<uint32_t> > expired_rowset_gc_running;
 
   scoped_refptr<Histogram> flush_dms_duration;
   scoped_refptr<Histogram> flush_mrs_duration;
   scoped_refptr<Histogram> compact_rs_duration;
   scoped_refptr<Histogram> delta_minor_compact_rs_duration;
   scoped_refptr<Histogram> delta_major_compact_rs_duration;
+  scoped_refptr<Histogram> undo_delta_block_gc_duration;
+  scoped_refptr<Counter> undo_delta_block_gc_bytes_deleted;
+  scoped_refptr<Histogram> expired_rowset_gc_duration;
+  scoped_refptr<Counter> expired_rowset_gc_rows_deleted;
+  scoped_refptr<Counter> expired_rowset_gc_bytes_deleted;
 
   scoped_refptr<Counter> leader_memory_pressure_rejections;
 };
@@ -114,6 +114,53 @@ class MajorDeltaCompactionOp : public MaintenanceOp {
   Tablet* const tablet_;
 };
 
+// MaintenanceOp to delete UNDO delta blocks which only hold history older
+// than the tablet's history retention window (see --tablet_history_max_age_sec).
+//
+// Deleting a block is cheap, so this op is considered low IO. Its perf
+// improvement score grows with the amount of disk space it could reclaim.
+class UndoDeltaBlockGCOp : public MaintenanceOp {
+ public:
+  explicit UndoDeltaBlockGCOp(Tablet* tablet);
+
+  virtual void UpdateStats(MaintenanceOpStats* stats) OVERRIDE;
+
+  virtual bool Prepare() OVERRIDE;
+
+  virtual void Perform() OVERRIDE;
+
+  virtual scoped_refptr<Histogram> DurationHistogram() const OVERRIDE;
+
+  virtual scoped_refptr<AtomicGauge<uint32_t> > RunningGauge() const OVERRIDE;
+
+ private:
+  Tablet* const tablet_;
+};
+
+// MaintenanceOp to delete the rowsets whose rows have all expired according
+// to the table's row TTL, without compacting them.
+//
+// Like UndoDeltaBlockGCOp, deleting whole rowsets is cheap, so this op is
+// considered low IO, and its perf improvement score grows with the amount of
+// disk space it could reclaim.
+class ExpiredRowSetGCOp : public MaintenanceOp {
+ public:
+  explicit ExpiredRowSetGCOp(Tablet* tablet);
+
+  virtual void UpdateStats(MaintenanceOpStats* stats) OVERRIDE;
+
+  virtual bool Prepare() OVERRIDE;
+
+  virtual void Perform() OVERRIDE;
+
+  virtual scoped_refptr<Histogram> DurationHistogram() const OVERRIDE;
+
+  virtual scoped_refptr<AtomicGauge<uint32_t> > RunningGauge() const OVERRIDE;
+
+ private:
+  Tablet* const tablet_;
+};
+
 } // namespace tablet
 } // namespace kudu
 
@@ -39,6 +39,7 @@
 #include "kudu/gutil/sysinfo.h"
 #include "kudu/tablet/transactions/transaction_driver.h"
 #include "kudu/tablet/transactions/alter_schema_transaction.h"
+#include "kudu/tablet/transactions/bulk_ingest_transaction.h"
 #include "kudu/tablet/transactions/write_transaction.h"
 #include "kudu/tablet/tablet_bootstrap.h"
 #include "kudu/tablet/tablet_metrics.h"
@@ -89,6 +90,7 @@ using consensus::RaftConfigPB;
 using consensus::RaftPeerPB;
 using consensus::RaftConsensus;
 using consensus::ALTER_SCHEMA_OP;
+using consensus::BULK_INGEST_OP;
 using consensus::WRITE_OP;
 using log::Log;
 using log::LogAnchorRegistry;
@@ -108,7 +110,7 @@ TabletPeer::TabletPeer(const scoped_refptr<TabletMetadata>& meta,
       local_peer_pb_(local_peer_pb),
       state_(NOT_STARTED),
       status_listener_(new TabletStatusListener(meta)),
-      apply_pool_(apply_pool),
+      apply_queue_(new TransactionApplyQueue(apply_pool)),
       log_anchor_registry_(new LogAnchorRegistry()),
       mark_dirty_clbk_(std::move(mark_dirty_clbk)) {}
 
@@ -347,6 +349,16 @@ Status TabletPeer::SubmitAlterSchema(unique_ptr<AlterSchemaTransactionState> sta
   return driver->ExecuteAsync();
 }
 
+Status TabletPeer::SubmitBulkIngest(unique_ptr<BulkIngestTransactionState> state) {
+  RETURN_NOT_OK(CheckRunning());
+
+  gscoped_ptr<BulkIngestTransaction> transaction(
+      new BulkIngestTransaction(std::move(state), consensus::LEADER));
+  scoped_refptr<TransactionDriver> driver;
+  RETURN_NOT_OK(NewLeaderTransactionDriver(transaction.PassAs<Transaction>(), &driver));
+  return driver->ExecuteAsync();
+}
+
 void TabletPeer::GetTabletStatusPB(TabletStatusPB* status_pb_out) const {
   boost::lock_guard<simple_spinlock> lock(lock_);
   DCHECK(status_pb_out != nullptr);
@@ -410,6 +422,9 @@ void TabletPeer::GetInFlightTransactions(Transaction::TraceType trace_type,
         case Transaction::ALTER_SCHEMA_TXN:
           status_pb.set_tx_type(consensus::ALTER_SCHEMA_OP);
           break;
+        case Transaction::BULK_INGEST_TXN:
+          status_pb.set_tx_type(consensus::BULK_INGEST_OP);
+          break;
       }
       status_pb.set_description(driver->ToString());
       int64_t running_for_micros =
@@ -510,6 +525,17 @@ Status TabletPeer::StartReplicaTransaction(const scoped_refptr<ConsensusRound>&
           new AlterSchemaTransaction(std::move(tx_state), consensus::REPLICA));
       break;
     }
+    case BULK_INGEST_OP:
+    {
+      DCHECK(replicate_msg->has_bulk_ingest_request()) << "BULK_INGEST_OP replica"
+          " transaction must receive a BulkIngestRequestPB";
+      unique_ptr<BulkIngestTransactionState> tx_state(
+          new BulkIngestTransactionState(this, &replicate_msg->bulk_ingest_request(),
+                                         nullptr));
+      transaction.reset(
+          new BulkIngestTransaction(std::move(tx_state), consensus::REPLICA));
+      break;
+    }
     default:
       LOG(FATAL) << "Unsupported Operation Type";
   }
@@ -532,6 +558,50 @@ Status TabletPeer::StartReplicaTransaction(const scoped_refptr<ConsensusRound>&
   return Status::OK();
 }
 
+bool TabletPeer::GetSafeTimestampForFollowers(uint64_t* safe_timestamp) {
+  shared_ptr<Tablet> tablet = shared_tablet();
+  if (PREDICT_FALSE(!tablet)) {
+    return false;
+  }
+  *safe_timestamp = tablet->mvcc_manager()->GetSafeTimeForFollowers().ToUint64();
+  return true;
+}
+
+void TabletPeer::AdvanceSafeTimestampForFollowers() {
+  shared_ptr<Tablet> tablet = shared_tablet();
+  if (PREDICT_TRUE(tablet)) {
+    tablet->mvcc_manager()->AdvanceLeaderSafeTime();
+  }
+}
+
+void TabletPeer::AdvanceFollowerSafeTimestamp(uint64_t safe_timestamp) {
+  Timestamp safe_time(safe_timestamp);
+
+  // Should this replica become leader, it must not assign timestamps at or
+  // below a safe time it may have served snapshots at.
+  Status s = clock_->Update(safe_time);
+  if (PREDICT_FALSE(!s.ok())) {
+    LOG(WARNING) << "T " << tablet_id_ << ": ignoring safe timestamp "
+                 << clock_->Stringify(safe_time) << ": " << s.ToString();
+    return;
+  }
+
+  // The prepare pool has a single thread, so this runs after every
+  // transaction received so far has started, i.e. is known to MVCC.
+  s = prepare_pool_->SubmitClosure(
+      Bind(&TabletPeer::AdvanceFollowerSafeTimeTask, Unretained(this), safe_time));
+  if (PREDICT_FALSE(!s.ok())) {
+    VLOG(1) << "T " << tablet_id_ << ": could not advance the safe time: " << s.ToString();
+  }
+}
+
+void TabletPeer::AdvanceFollowerSafeTimeTask(Timestamp safe_time) {
+  shared_ptr<Tablet> tablet = shared_tablet();
+  if (PREDICT_TRUE(tablet)) {
+    tablet->mvcc_manager()->AdvanceFollowerSafeTime(safe_time);
+  }
+}
+
 Status TabletPeer::NewLeaderTransactionDriver(gscoped_ptr<Transaction> transaction,
                                               scoped_refptr<TransactionDriver>* driver) {
   scoped_refptr<TransactionDriver> tx_driver = new TransactionDriver(
@@ -539,7 +609,7 @@ Status TabletPeer::NewLeaderTransactionDriver(gscoped_ptr<Transaction> transacti
     consensus_.get(),
     log_.get(),
     prepare_pool_.get(),
-    apply_pool_,
+    apply_queue_.get(),
     &txn_order_verifier_);
   RETURN_NOT_OK(tx_driver->Init(std::move(transaction), consensus::LEADER));
   driver->swap(tx_driver);
@@ -554,7 +624,7 @@ Status TabletPeer::NewReplicaTransactionDriver(gscoped_ptr<Transaction> transact
     consensus_.get(),
     log_.get(),
     prepare_pool_.get(),
-    apply_pool_,
+    apply_queue_.get(),
     &txn_order_verifier_);
   RETURN_NOT_OK(tx_driver->Init(std::move(transaction), consensus::REPLICA));
   driver->swap(tx_driver);
@@ -56,6 +56,7 @@ class ReplicaTransactionDriver;
 class TabletPeer;
 class TabletStatusPB;
 class TabletStatusListener;
+class TransactionApplyQueue;
 class TransactionDriver;
 
 // A peer in a tablet consensus configuration, which coordinates writes to tablets.
@@ -115,12 +116,28 @@ class TabletPeer : public RefCountedThreadSafe<TabletPeer>,
   // AlterSchema is in progress.
   Status SubmitAlterSchema(std::unique_ptr<AlterSchemaTransactionState> tx_state);
 
+  // Called by the tablet service to start a bulk ingest transaction. As with
+  // SubmitAlterSchema(), the response is sent asynchronously if the returned
+  // Status is OK.
+  Status SubmitBulkIngest(std::unique_ptr<BulkIngestTransactionState> tx_state);
+
   void GetTabletStatusPB(TabletStatusPB* status_pb_out) const;
 
   // Used by consensus to create and start a new ReplicaTransaction.
   virtual Status StartReplicaTransaction(
       const scoped_refptr<consensus::ConsensusRound>& round) OVERRIDE;
 
+  // Used by consensus, when leader, to compute the safe timestamp sent to
+  // followers.
+  virtual bool GetSafeTimestampForFollowers(uint64_t* safe_timestamp) OVERRIDE;
+
+  // Used by consensus, when leader, to advance the safe timestamp of an idle
+  // tablet.
+  virtual void AdvanceSafeTimestampForFollowers() OVERRIDE;
+
+  // Used by consensus, when follower, to advance the tablet's safe time.
+  virtual void AdvanceFollowerSafeTimestamp(uint64_t safe_timestamp) OVERRIDE;
+
   consensus::Consensus* consensus() {
     boost::lock_guard<simple_spinlock> lock(lock_);
     return consensus_.get();
@@ -263,6 +280,10 @@ class TabletPeer : public RefCountedThreadSafe<TabletPeer>,
   // Wait until the TabletPeer is fully in SHUTDOWN state.
   void WaitUntilShutdown();
 
+  // Advances the tablet's follower safe time, once the transactions received
+  // before it have started. Runs on the prepare pool.
+  void AdvanceFollowerSafeTimeTask(Timestamp safe_time);
+
   // After bootstrap is complete and consensus is setup this initiates the transactions
   // that were not complete on bootstrap.
   // Not implemented yet. See .cc file.
@@ -305,10 +326,10 @@ class TabletPeer : public RefCountedThreadSafe<TabletPeer>,
   // TODO move the prepare pool to TabletServer.
   gscoped_ptr<ThreadPool> prepare_pool_;
 
-  // Pool that executes apply tasks for transactions. This is a multi-threaded
-  // pool, constructor-injected by either the Master (for system tables) or
-  // the Tablet server.
-  ThreadPool* apply_pool_;
+  // Queue of this tablet's transactions which are ready to be applied. It runs
+  // its apply tasks on a multi-threaded pool, constructor-injected by either
+  // the Master (for system tables) or the Tablet server.
+  scoped_refptr<TransactionApplyQueue> apply_queue_;
 
   scoped_refptr<server::Clock> clock_;
 
@@ -65,6 +65,13 @@ class AlterSchemaTransactionState : public TransactionState {
     return request_->has_new_table_name();
   }
 
+  // The time-to-live of the table's rows as of the new schema version. The
+  // master always sends the table's current row TTL, so an unset TTL means
+  // the table has none.
+  const RowTtlPB& row_ttl() const {
+    return request_->row_ttl();
+  }
+
   uint32_t schema_version() const {
     return request_->schema_version();
   }
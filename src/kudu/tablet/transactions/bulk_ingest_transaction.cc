@@ -0,0 +1,213 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/transactions/bulk_ingest_transaction.h"
+
+#include <glog/logging.h>
+
+#include "kudu/common/wire_protocol.h"
+#include "kudu/rpc/rpc_context.h"
+#include "kudu/server/hybrid_clock.h"
+#include "kudu/tablet/mvcc.h"
+#include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet_peer.h"
+#include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/debug/trace_event.h"
+#include "kudu/util/trace.h"
+
+namespace kudu {
+namespace tablet {
+
+using consensus::BULK_INGEST_OP;
+using consensus::CommitMsg;
+using consensus::DriverType;
+using consensus::ReplicateMsg;
+using std::unique_ptr;
+using strings::Substitute;
+using tserver::BulkIngestRequestPB;
+using tserver::BulkIngestResponsePB;
+using tserver::TabletServerErrorPB;
+
+BulkIngestTransactionState::BulkIngestTransactionState(TabletPeer* tablet_peer,
+                                                       const BulkIngestRequestPB* request,
+                                                       BulkIngestResponsePB* response)
+    : TransactionState(tablet_peer),
+      request_(request),
+      response_(response),
+      schema_at_decode_time_(nullptr) {
+}
+
+BulkIngestTransactionState::~BulkIngestTransactionState() {
+  // Like a write, commit if the transaction was never finished. See KUDU-625.
+  CommitOrAbort(Transaction::COMMITTED);
+}
+
+void BulkIngestTransactionState::SetMvccTxAndTimestamp(gscoped_ptr<ScopedTransaction> mvcc_tx) {
+  DCHECK(!mvcc_tx_) << "Mvcc transaction already started/set.";
+  if (has_timestamp()) {
+    DCHECK_EQ(timestamp(), mvcc_tx->timestamp());
+  } else {
+    set_timestamp(mvcc_tx->timestamp());
+  }
+  mvcc_tx_ = std::move(mvcc_tx);
+}
+
+void BulkIngestTransactionState::StartApplying() {
+  CHECK_NOTNULL(mvcc_tx_.get())->StartApplying();
+}
+
+void BulkIngestTransactionState::AcquireSchemaLock(rw_semaphore* schema_lock) {
+  TRACE("Acquiring schema lock in shared mode");
+  shared_lock<rw_semaphore> temp(schema_lock);
+  schema_lock_.swap(temp);
+  TRACE("Acquired schema lock");
+}
+
+void BulkIngestTransactionState::CommitOrAbort(Transaction::TransactionResult result) {
+  if (mvcc_tx_.get() != nullptr) {
+    switch (result) {
+      case Transaction::COMMITTED:
+        mvcc_tx_->Commit();
+        break;
+      case Transaction::ABORTED:
+        mvcc_tx_->Abort();
+        break;
+    }
+  }
+  mvcc_tx_.reset();
+
+  TRACE("Releasing schema lock");
+  shared_lock<rw_semaphore> temp;
+  schema_lock_.swap(temp);
+
+  // The rows point into the request, which may be deleted as soon as the
+  // RPC is responded to.
+  lock_guard<simple_spinlock> l(&txn_state_lock_);
+  request_ = nullptr;
+  response_ = nullptr;
+  rows_.clear();
+}
+
+string BulkIngestTransactionState::ToString() const {
+  return Substitute("BulkIngestTransactionState [timestamp=$0, num_rows=$1]",
+                    has_timestamp() ? timestamp().ToString() : "(none)",
+                    rows_.size());
+}
+
+BulkIngestTransaction::BulkIngestTransaction(unique_ptr<BulkIngestTransactionState> state,
+                                             DriverType type)
+    : Transaction(state.get(), type, Transaction::BULK_INGEST_TXN),
+      state_(std::move(state)) {
+}
+
+void BulkIngestTransaction::NewReplicateMsg(gscoped_ptr<ReplicateMsg>* replicate_msg) {
+  replicate_msg->reset(new ReplicateMsg);
+  (*replicate_msg)->set_op_type(BULK_INGEST_OP);
+  (*replicate_msg)->mutable_bulk_ingest_request()->CopyFrom(*state()->request());
+}
+
+Status BulkIngestTransaction::Prepare() {
+  TRACE_EVENT0("txn", "BulkIngestTransaction::Prepare");
+  TRACE("PREPARE BULK-INGEST: Starting");
+
+  Schema client_schema;
+  Status s = SchemaFromPB(state_->request()->schema(), &client_schema);
+  if (s.ok() && client_schema.has_column_ids()) {
+    s = Status::InvalidArgument("User requests should not have Column IDs");
+  }
+  if (!s.ok()) {
+    state_->completion_callback()->set_error(s, TabletServerErrorPB::INVALID_SCHEMA);
+    return s;
+  }
+
+  Tablet* tablet = state_->tablet_peer()->tablet();
+  s = tablet->DecodeBulkIngestRows(&client_schema, state());
+  if (!s.ok()) {
+    state_->completion_callback()->set_error(s, TabletServerErrorPB::INVALID_ROW_BLOCK);
+    return s;
+  }
+
+  // Reject the request before replicating it if its key range is not empty.
+  // The range is checked again when the operation is applied, since writes
+  // may have landed in it in the meantime.
+  if (type() == consensus::LEADER) {
+    s = tablet->CheckBulkIngestKeyRangeEmpty(state());
+    if (!s.ok()) {
+      state_->completion_callback()->set_error(s, TabletServerErrorPB::KEY_RANGE_NOT_EMPTY);
+      return s;
+    }
+  }
+
+  TRACE("PREPARE BULK-INGEST: finished");
+  return Status::OK();
+}
+
+Status BulkIngestTransaction::Start() {
+  TRACE_EVENT0("txn", "BulkIngestTransaction::Start");
+  state_->tablet_peer()->tablet()->StartTransaction(state_.get());
+  TRACE("START. Timestamp: $0", server::HybridClock::GetPhysicalValueMicros(state_->timestamp()));
+  return Status::OK();
+}
+
+Status BulkIngestTransaction::Apply(gscoped_ptr<CommitMsg>* commit_msg) {
+  TRACE_EVENT0("txn", "BulkIngestTransaction::Apply");
+  TRACE("APPLY BULK-INGEST: Starting");
+
+  commit_msg->reset(new CommitMsg());
+  (*commit_msg)->set_op_type(BULK_INGEST_OP);
+
+  // Whether the key range is empty only depends on the operations applied
+  // before this one, so every replica rejects the same bulk ingests. Any
+  // other error leaves the replica unable to apply the log, as for writes.
+  Tablet* tablet = state_->tablet_peer()->tablet();
+  Status s = tablet->BulkIngest(state());
+  if (s.IsAlreadyPresent()) {
+    TRACE("APPLY BULK-INGEST: rejected: $0", s.ToString());
+    StatusToPB(s, (*commit_msg)->mutable_result()->add_ops()->mutable_failed_status());
+    state_->completion_callback()->set_error(s, TabletServerErrorPB::KEY_RANGE_NOT_EMPTY);
+    return Status::OK();
+  }
+  RETURN_NOT_OK(s);
+
+  if (state_->response() != nullptr) {
+    state_->response()->set_timestamp(state_->timestamp().ToUint64());
+  }
+
+  TRACE("APPLY BULK-INGEST: finished");
+  return Status::OK();
+}
+
+void BulkIngestTransaction::Finish(TransactionResult result) {
+  TRACE_EVENT0("txn", "BulkIngestTransaction::Finish");
+  size_t num_rows = state_->rows().size();
+  state_->CommitOrAbort(result);
+
+  if (PREDICT_FALSE(result == Transaction::ABORTED)) {
+    TRACE("FINISH: transaction aborted");
+    return;
+  }
+  DCHECK_EQ(result, Transaction::COMMITTED);
+  TRACE("FINISH: made $0 bulk ingested rows visible", num_rows);
+}
+
+string BulkIngestTransaction::ToString() const {
+  return Substitute("BulkIngestTransaction [type=$0, state=$1]",
+                    DriverType_Name(type()), state_->ToString());
+}
+
+}  // namespace tablet
+}  // namespace kudu
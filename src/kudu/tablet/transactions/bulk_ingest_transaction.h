@@ -0,0 +1,154 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef KUDU_TABLET_BULK_INGEST_TRANSACTION_H_
+#define KUDU_TABLET_BULK_INGEST_TRANSACTION_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/tablet/transactions/transaction.h"
+#include "kudu/util/locks.h"
+
+namespace kudu {
+
+class Schema;
+
+namespace tserver {
+class BulkIngestRequestPB;
+class BulkIngestResponsePB;
+}
+
+namespace tablet {
+
+// Transaction Context for the BulkIngest operation.
+// Keeps track of the Transaction states (request, decoded rows, ...)
+class BulkIngestTransactionState : public TransactionState {
+ public:
+  BulkIngestTransactionState(TabletPeer* tablet_peer,
+                             const tserver::BulkIngestRequestPB* request,
+                             tserver::BulkIngestResponsePB* response);
+  virtual ~BulkIngestTransactionState();
+
+  const tserver::BulkIngestRequestPB* request() const OVERRIDE { return request_; }
+  tserver::BulkIngestResponsePB* response() OVERRIDE { return response_; }
+
+  // Set the MVCC transaction associated with this operation, and copy its
+  // timestamp into this state.
+  void SetMvccTxAndTimestamp(gscoped_ptr<ScopedTransaction> mvcc_tx);
+
+  ScopedTransaction* mvcc_tx() { return mvcc_tx_.get(); }
+
+  // Notifies the MVCC manager that this operation is about to start writing
+  // its rows.
+  void StartApplying();
+
+  // Take a shared lock on the given schema lock, so that the schema doesn't
+  // change between decoding the rows and writing them.
+  void AcquireSchemaLock(rw_semaphore* schema_lock);
+
+  // The decoded rows, in the tablet's schema, sorted by key. The row data is
+  // allocated from this transaction's arena.
+  const std::vector<const uint8_t*>& rows() const { return rows_; }
+
+  void swap_rows(std::vector<const uint8_t*>* rows) {
+    lock_guard<simple_spinlock> l(&txn_state_lock_);
+    rows_.swap(*rows);
+  }
+
+  void set_schema_at_decode_time(const Schema* schema) {
+    lock_guard<simple_spinlock> l(&txn_state_lock_);
+    schema_at_decode_time_ = schema;
+  }
+
+  const Schema* schema_at_decode_time() const {
+    lock_guard<simple_spinlock> l(&txn_state_lock_);
+    return schema_at_decode_time_;
+  }
+
+  // Commits or aborts the MVCC transaction and releases the schema lock.
+  //
+  // Note: request_ and response_ are set to NULL after this method returns.
+  void CommitOrAbort(Transaction::TransactionResult result);
+
+  virtual std::string ToString() const OVERRIDE;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BulkIngestTransactionState);
+
+  // The original RPC request and response.
+  const tserver::BulkIngestRequestPB* request_;
+  tserver::BulkIngestResponsePB* response_;
+
+  // Protected by superclass's txn_state_lock_.
+  std::vector<const uint8_t*> rows_;
+  const Schema* schema_at_decode_time_;
+
+  gscoped_ptr<ScopedTransaction> mvcc_tx_;
+
+  // A lock held on the tablet's schema. Prevents concurrent schema change
+  // from racing with the ingest.
+  shared_lock<rw_semaphore> schema_lock_;
+};
+
+// Executes the bulk ingest transaction.
+//
+// The rows travel through consensus inside the replicated request, so that
+// each replica can write them into its own DiskRowSets when the operation is
+// applied.
+class BulkIngestTransaction : public Transaction {
+ public:
+  BulkIngestTransaction(std::unique_ptr<BulkIngestTransactionState> tx_state,
+                        consensus::DriverType type);
+
+  virtual BulkIngestTransactionState* state() OVERRIDE { return state_.get(); }
+  virtual const BulkIngestTransactionState* state() const OVERRIDE { return state_.get(); }
+
+  void NewReplicateMsg(gscoped_ptr<consensus::ReplicateMsg>* replicate_msg) OVERRIDE;
+
+  // Decodes and validates the rows of the request. On the leader, also
+  // rejects the request if rows already exist in its key range, before it
+  // is replicated.
+  virtual Status Prepare() OVERRIDE;
+
+  // Starts the BulkIngestTransaction by assigning it a timestamp.
+  virtual Status Start() OVERRIDE;
+
+  // Writes the rows into new DiskRowSets and adds them to the tablet.
+  virtual Status Apply(gscoped_ptr<consensus::CommitMsg>* commit_msg) OVERRIDE;
+
+  // Makes the ingested rows visible to readers.
+  virtual void Finish(TransactionResult result) OVERRIDE;
+
+  virtual ScopedTransaction* mvcc_tx() OVERRIDE {
+    return state_->mvcc_tx();
+  }
+
+  virtual std::string ToString() const OVERRIDE;
+
+ private:
+  std::unique_ptr<BulkIngestTransactionState> state_;
+  DISALLOW_COPY_AND_ASSIGN(BulkIngestTransaction);
+};
+
+}  // namespace tablet
+}  // namespace kudu
+
+#endif /* KUDU_TABLET_BULK_INGEST_TRANSACTION_H_ */
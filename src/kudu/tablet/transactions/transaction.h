@@ -31,6 +31,7 @@
 namespace kudu {
 
 namespace tablet {
+class ScopedTransaction;
 class TabletPeer;
 class TransactionCompletionCallback;
 class TransactionState;
@@ -56,6 +57,7 @@ class Transaction {
   enum TransactionType {
     WRITE_TXN,
     ALTER_SCHEMA_TXN,
+    BULK_INGEST_TXN,
   };
 
   enum TraceType {
@@ -112,6 +114,11 @@ class Transaction {
   // know what was the final status of the transaction.
   virtual void Finish(TransactionResult result) {}
 
+  // Returns the MVCC transaction that Finish(COMMITTED) commits, or NULL if
+  // there is none. The driver may commit it ahead of Finish() together with
+  // those of the transactions applied alongside this one.
+  virtual ScopedTransaction* mvcc_tx() { return nullptr; }
+
   // Each implementation should have its own ToString() method.
   virtual std::string ToString() const = 0;
 
@@ -0,0 +1,237 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <boost/bind.hpp>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "kudu/gutil/bind.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/tablet/transactions/transaction_driver.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/test_util.h"
+#include "kudu/util/threadpool.h"
+
+DECLARE_int32(tablet_apply_max_batch_size);
+
+using std::vector;
+
+namespace kudu {
+namespace tablet {
+
+typedef vector<scoped_refptr<TransactionDriver> > DriverVector;
+
+// Tests for TransactionApplyQueue which, rather than applying transactions,
+// record the runs it hands out.
+class TransactionApplyQueueTest : public KuduTest {
+ public:
+  TransactionApplyQueueTest()
+      : fill_pool_during_first_run_(false) {
+  }
+
+  virtual void TearDown() OVERRIDE {
+    if (pool_) {
+      pool_->Shutdown();
+    }
+    KuduTest::TearDown();
+  }
+
+ protected:
+  // Builds a single threaded apply pool, and a queue which submits to it.
+  void SetUpQueue(int max_queue_size) {
+    ASSERT_OK(ThreadPoolBuilder("apply")
+              .set_max_threads(1)
+              .set_max_queue_size(max_queue_size)
+              .Build(&pool_));
+    queue_ = new TransactionApplyQueue(
+        pool_.get(), Bind(&TransactionApplyQueueTest::ApplyRun, Unretained(this)));
+  }
+
+  static DriverVector NewDrivers(int n) {
+    DriverVector drivers;
+    for (int i = 0; i < n; i++) {
+      drivers.push_back(new TransactionDriver(nullptr, nullptr, nullptr, nullptr, nullptr,
+                                              nullptr));
+    }
+    return drivers;
+  }
+
+  void SubmitAll(const DriverVector& drivers, bool commit_wait = false) {
+    for (const auto& driver : drivers) {
+      ASSERT_OK(queue_->Submit(driver.get(), commit_wait));
+    }
+  }
+
+  // Blocks the pool's only thread until 'latch' is counted down,
+  // so that submitted drivers pile up in the queue.
+  void BlockPool(CountDownLatch* latch) {
+    ASSERT_OK(pool_->SubmitFunc(boost::bind(&CountDownLatch::Wait, latch)));
+  }
+
+  DriverVector AppliedDrivers() const {
+    DriverVector applied;
+    for (const DriverVector& run : runs_) {
+      applied.insert(applied.end(), run.begin(), run.end());
+    }
+    return applied;
+  }
+
+  gscoped_ptr<ThreadPool> pool_;
+  scoped_refptr<TransactionApplyQueue> queue_;
+
+  // Drivers to submit to the queue while it applies its first run.
+  DriverVector submit_during_first_run_;
+
+  // Whether to fill the pool's queue while the first run is applied, so that
+  // the drain task can't resubmit itself.
+  bool fill_pool_during_first_run_;
+
+  // The runs applied so far. Only accessed by the pool's thread, or once
+  // the pool is idle.
+  vector<DriverVector> runs_;
+
+ private:
+  void ApplyRun(const DriverVector& run) {
+    bool first_run = runs_.empty();
+    runs_.push_back(run);
+    if (!first_run) {
+      return;
+    }
+    SubmitAll(submit_during_first_run_);
+    if (fill_pool_during_first_run_) {
+      CHECK_OK(pool_->SubmitFunc([]() {}));
+    }
+  }
+};
+
+// Test that the drivers queued while the pool is busy are applied as a
+// single run, in the order they were submitted.
+TEST_F(TransactionApplyQueueTest, TestAppliesRunInOrder) {
+  NO_FATALS(SetUpQueue(100));
+  CountDownLatch latch(1);
+  NO_FATALS(BlockPool(&latch));
+
+  DriverVector drivers = NewDrivers(10);
+  NO_FATALS(SubmitAll(drivers));
+  latch.CountDown();
+  pool_->Wait();
+
+  ASSERT_EQ(1, runs_.size());
+  ASSERT_EQ(drivers, AppliedDrivers());
+}
+
+// Test that runs are capped at --tablet_apply_max_batch_size, and that the
+// runs are applied in order.
+TEST_F(TransactionApplyQueueTest, TestRespectsMaxBatchSize) {
+  FLAGS_tablet_apply_max_batch_size = 3;
+  NO_FATALS(SetUpQueue(100));
+  CountDownLatch latch(1);
+  NO_FATALS(BlockPool(&latch));
+
+  DriverVector drivers = NewDrivers(10);
+  NO_FATALS(SubmitAll(drivers));
+  latch.CountDown();
+  pool_->Wait();
+
+  ASSERT_EQ(4, runs_.size());
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(3, runs_[i].size());
+  }
+  ASSERT_EQ(1, runs_[3].size());
+  ASSERT_EQ(drivers, AppliedDrivers());
+}
+
+// Test that drivers submitted while a run is being applied are picked up by
+// the drain task, and that the queue starts a new drain task afterwards.
+TEST_F(TransactionApplyQueueTest, TestDrainsDriversQueuedDuringDrain) {
+  NO_FATALS(SetUpQueue(100));
+  DriverVector drivers = NewDrivers(1);
+  submit_during_first_run_ = NewDrivers(5);
+  NO_FATALS(SubmitAll(drivers));
+  pool_->Wait();
+
+  drivers.insert(drivers.end(), submit_during_first_run_.begin(),
+                 submit_during_first_run_.end());
+  ASSERT_EQ(2, runs_.size());
+  ASSERT_EQ(drivers, AppliedDrivers());
+
+  // The queue is idle again, so the next driver submits a new drain task.
+  DriverVector more = NewDrivers(1);
+  NO_FATALS(SubmitAll(more));
+  pool_->Wait();
+  ASSERT_EQ(3, runs_.size());
+  ASSERT_EQ(more, runs_.back());
+}
+
+// Test that COMMIT_WAIT transactions are applied in runs of their own, so that
+// the transactions queued ahead of them don't wait for their commit-wait to be
+// made visible.
+TEST_F(TransactionApplyQueueTest, TestAppliesCommitWaitTransactionsAlone) {
+  NO_FATALS(SetUpQueue(100));
+  CountDownLatch latch(1);
+  NO_FATALS(BlockPool(&latch));
+
+  DriverVector before = NewDrivers(3);
+  DriverVector commit_wait = NewDrivers(2);
+  DriverVector after = NewDrivers(2);
+  NO_FATALS(SubmitAll(before));
+  NO_FATALS(SubmitAll(commit_wait, true));
+  NO_FATALS(SubmitAll(after));
+  latch.CountDown();
+  pool_->Wait();
+
+  ASSERT_EQ(4, runs_.size());
+  ASSERT_EQ(before, runs_[0]);
+  ASSERT_EQ(DriverVector({ commit_wait[0] }), runs_[1]);
+  ASSERT_EQ(DriverVector({ commit_wait[1] }), runs_[2]);
+  ASSERT_EQ(after, runs_[3]);
+}
+
+// Test that if the drain task can't be submitted, the driver is taken back off
+// the queue, so that the next submission tries to submit a drain task again.
+TEST_F(TransactionApplyQueueTest, TestSubmitFailsIfPoolIsShutDown) {
+  NO_FATALS(SetUpQueue(100));
+  pool_->Shutdown();
+
+  DriverVector drivers = NewDrivers(2);
+  for (const auto& driver : drivers) {
+    ASSERT_TRUE(queue_->Submit(driver.get(), false).IsServiceUnavailable());
+  }
+  ASSERT_TRUE(runs_.empty());
+}
+
+// Test that if the drain task can't be resubmitted part-way through draining,
+// because the pool's queue is full, the remaining drivers are still applied,
+// in order.
+TEST_F(TransactionApplyQueueTest, TestDrainsInlineIfResubmitFails) {
+  FLAGS_tablet_apply_max_batch_size = 2;
+  NO_FATALS(SetUpQueue(1));
+  DriverVector drivers = NewDrivers(1);
+  submit_during_first_run_ = NewDrivers(5);
+  fill_pool_during_first_run_ = true;
+  NO_FATALS(SubmitAll(drivers));
+  pool_->Wait();
+
+  drivers.insert(drivers.end(), submit_during_first_run_.begin(),
+                 submit_during_first_run_.end());
+  ASSERT_EQ(4, runs_.size());
+  ASSERT_EQ(drivers, AppliedDrivers());
+}
+
+} // namespace tablet
+} // namespace kudu
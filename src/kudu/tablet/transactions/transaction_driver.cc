@@ -17,16 +17,28 @@
 
 #include "kudu/tablet/transactions/transaction_driver.h"
 
+#include <algorithm>
+#include <gflags/gflags.h>
+
 #include "kudu/consensus/consensus.h"
+#include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/strcat.h"
+#include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/tablet_peer.h"
 #include "kudu/tablet/transactions/transaction_tracker.h"
 #include "kudu/util/debug-util.h"
 #include "kudu/util/debug/trace_event.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/threadpool.h"
 #include "kudu/util/trace.h"
 
+DEFINE_int32(tablet_apply_max_batch_size, 64,
+             "Maximum number of consecutive committed operations of a tablet "
+             "which are applied together, in a single task on the apply pool "
+             "and with a single commit entry in the log.");
+TAG_FLAG(tablet_apply_max_batch_size, advanced);
+
 namespace kudu {
 namespace tablet {
 
@@ -38,6 +50,7 @@ using consensus::CommitMsg;
 using consensus::DriverType;
 using log::Log;
 using std::shared_ptr;
+using std::vector;
 
 static const char* kTimestampFieldName = "timestamp";
 
@@ -50,13 +63,13 @@ TransactionDriver::TransactionDriver(TransactionTracker *txn_tracker,
                                      Consensus* consensus,
                                      Log* log,
                                      ThreadPool* prepare_pool,
-                                     ThreadPool* apply_pool,
+                                     TransactionApplyQueue* apply_queue,
                                      TransactionOrderVerifier* order_verifier)
     : txn_tracker_(txn_tracker),
       consensus_(consensus),
       log_(log),
       prepare_pool_(prepare_pool),
-      apply_pool_(apply_pool),
+      apply_queue_(apply_queue),
       order_verifier_(order_verifier),
       trace_(new Trace()),
       start_time_(MonoTime::Now(MonoTime::FINE)),
@@ -353,10 +366,11 @@ Status TransactionDriver::ApplyAsync() {
   }
 
   TRACE_EVENT_FLOW_BEGIN0("txn", "ApplyTask", this);
-  return apply_pool_->SubmitClosure(Bind(&TransactionDriver::ApplyTask, Unretained(this)));
+  return apply_queue_->Submit(
+      this, transaction_->state()->external_consistency_mode() == COMMIT_WAIT);
 }
 
-void TransactionDriver::ApplyTask() {
+void TransactionDriver::ApplyTransaction(gscoped_ptr<CommitMsg>* commit_msg) {
   TRACE_EVENT_FLOW_END0("txn", "ApplyTask", this);
   ADOPT_TRACE(trace());
 
@@ -366,36 +380,60 @@ void TransactionDriver::ApplyTask() {
     DCHECK_EQ(prepare_state_, PREPARED);
   }
 
-  // We need to ref-count ourself, since Commit() may run very quickly
-  // and end up calling Finalize() while we're still in this code.
-  scoped_refptr<TransactionDriver> ref(this);
+  CHECK_OK(transaction_->Apply(commit_msg));
+  (*commit_msg)->mutable_commited_op_id()->CopyFrom(op_id_copy_);
+  SetResponseTimestamp(transaction_->state(), transaction_->state()->timestamp());
+}
 
-  {
+void TransactionDriver::ApplyRun(const vector<scoped_refptr<TransactionDriver> >& run) {
+  DCHECK(!run.empty());
+  TRACE_EVENT1("txn", "ApplyRun", "num_txns", run.size());
+
+  vector<CommitMsg*> commit_msgs;
+  ElementDeleter deleter(&commit_msgs);
+  commit_msgs.reserve(run.size());
+  for (const scoped_refptr<TransactionDriver>& driver : run) {
     gscoped_ptr<CommitMsg> commit_msg;
-    CHECK_OK(transaction_->Apply(&commit_msg));
-    commit_msg->mutable_commited_op_id()->CopyFrom(op_id_copy_);
-    SetResponseTimestamp(transaction_->state(), transaction_->state()->timestamp());
+    driver->ApplyTransaction(&commit_msg);
+    commit_msgs.push_back(commit_msg.release());
+  }
 
-    {
-      TRACE_EVENT1("txn", "AsyncAppendCommit", "txn", this);
-      CHECK_OK(log_->AsyncAppendCommit(std::move(commit_msg), Bind(DoNothingStatusCB)));
-    }
+  {
+    TRACE_EVENT1("txn", "AsyncAppendCommits", "num_txns", run.size());
+    CHECK_OK(run.front()->log_->AsyncAppendCommits(&commit_msgs, Bind(DoNothingStatusCB)));
+  }
 
+  for (const scoped_refptr<TransactionDriver>& driver : run) {
     // If the client requested COMMIT_WAIT as the external consistency mode
     // calculate the latest that the prepare timestamp could be and wait
     // until now.earliest > prepare_latest. Only after this are the locks
-    // released.
-    if (mutable_state()->external_consistency_mode() == COMMIT_WAIT) {
+    // released. The apply queue applies such transactions on their own, so
+    // that the wait doesn't hold back the visibility of the rest of a run.
+    if (driver->mutable_state()->external_consistency_mode() == COMMIT_WAIT) {
       // TODO: only do this on the leader side
+      ADOPT_TRACE(driver->trace());
       TRACE("APPLY: Commit Wait.");
       // If we can't commit wait and have already applied we might have consistency
       // issues if we still reply to the client that the operation was a success.
       // On the other hand we don't have rollbacks as of yet thus we can't undo the
       // the apply either, so we just CHECK_OK for now.
-      CHECK_OK(CommitWait());
+      CHECK_OK(driver->CommitWait());
     }
+  }
 
-    Finalize();
+  // Make the whole run visible at once, rather than taking the MVCC lock
+  // in each transaction's Finish().
+  vector<ScopedTransaction*> mvcc_txns;
+  for (const scoped_refptr<TransactionDriver>& driver : run) {
+    ScopedTransaction* mvcc_tx = driver->transaction_->mvcc_tx();
+    if (mvcc_tx != nullptr) {
+      mvcc_txns.push_back(mvcc_tx);
+    }
+  }
+  ScopedTransaction::CommitAll(mvcc_txns);
+
+  for (const scoped_refptr<TransactionDriver>& driver : run) {
+    driver->Finalize();
   }
 }
 
@@ -434,6 +472,108 @@ void TransactionDriver::Finalize() {
 }
 
 
+////////////////////////////////////////////////////////////
+// TransactionApplyQueue
+////////////////////////////////////////////////////////////
+
+TransactionApplyQueue::TransactionApplyQueue(ThreadPool* apply_pool)
+    : apply_pool_(apply_pool),
+      apply_run_(Bind(&TransactionDriver::ApplyRun)),
+      draining_(false) {
+}
+
+TransactionApplyQueue::TransactionApplyQueue(ThreadPool* apply_pool, ApplyRunCallback apply_run)
+    : apply_pool_(apply_pool),
+      apply_run_(std::move(apply_run)),
+      draining_(false) {
+}
+
+Status TransactionApplyQueue::Submit(TransactionDriver* driver, bool commit_wait) {
+  {
+    boost::lock_guard<simple_spinlock> lock(lock_);
+    pending_.push_back({ driver, commit_wait });
+    if (draining_) {
+      return Status::OK();
+    }
+    draining_ = true;
+  }
+  // The task holds a reference so that the queue outlives it even if the
+  // tablet is shut down once the last transaction is finalized.
+  Status s = apply_pool_->SubmitClosure(
+      Bind(&TransactionApplyQueue::DrainTask, make_scoped_refptr(this)));
+  if (PREDICT_TRUE(s.ok())) {
+    return s;
+  }
+
+  bool drain_inline;
+  {
+    boost::lock_guard<simple_spinlock> lock(lock_);
+    // Other drivers may have been queued behind this one since the lock was
+    // dropped, so remove this one rather than whichever is last.
+    auto iter = std::find_if(pending_.begin(), pending_.end(),
+                             [driver](const PendingApply& pending) {
+                               return pending.driver.get() == driver;
+                             });
+    DCHECK(iter != pending_.end());
+    pending_.erase(iter);
+    drain_inline = !pending_.empty();
+    draining_ = drain_inline;
+  }
+  // Those drivers' submissions succeeded, since they saw the drain task as
+  // submitted, so they must still be applied.
+  if (drain_inline) {
+    KLOG_EVERY_N_SECS(WARNING, 1) << "Unable to submit the apply drain task, draining "
+                                  << "inline: " << s.ToString();
+    DrainTask();
+  }
+  return s;
+}
+
+void TransactionApplyQueue::DrainTask() {
+  while (true) {
+    vector<scoped_refptr<TransactionDriver> > run;
+    {
+      boost::lock_guard<simple_spinlock> lock(lock_);
+      DCHECK(draining_);
+      int max_txns = std::min<int>(pending_.size(),
+                                   std::max(FLAGS_tablet_apply_max_batch_size, 1));
+      // A commit-wait transaction is applied in a run of its own: the run
+      // ends before it, so that the transactions queued ahead of it aren't
+      // made visible only once its wait is over.
+      int num_txns = 1;
+      if (!pending_.front().commit_wait) {
+        while (num_txns < max_txns && !pending_[num_txns].commit_wait) {
+          num_txns++;
+        }
+      }
+      run.reserve(num_txns);
+      for (int i = 0; i < num_txns; i++) {
+        run.push_back(pending_[i].driver);
+      }
+      pending_.erase(pending_.begin(), pending_.begin() + num_txns);
+    }
+
+    apply_run_.Run(run);
+
+    {
+      boost::lock_guard<simple_spinlock> lock(lock_);
+      if (pending_.empty()) {
+        draining_ = false;
+        return;
+      }
+    }
+    Status s = apply_pool_->SubmitClosure(
+        Bind(&TransactionApplyQueue::DrainTask, make_scoped_refptr(this)));
+    if (PREDICT_TRUE(s.ok())) {
+      return;
+    }
+    // The pool's queue is full or it's shutting down. We can't leave committed
+    // transactions unapplied, so keep draining on this thread.
+    KLOG_EVERY_N_SECS(WARNING, 1) << "Unable to resubmit the apply drain task, draining "
+                                  << "inline: " << s.ToString();
+  }
+}
+
 std::string TransactionDriver::StateString(ReplicationState repl_state,
                                            PrepareState prep_state) {
   string state_str;
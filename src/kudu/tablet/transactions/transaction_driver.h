@@ -18,9 +18,12 @@
 #ifndef KUDU_TABLET_TRANSACTION_DRIVER_H_
 #define KUDU_TABLET_TRANSACTION_DRIVER_H_
 
+#include <deque>
 #include <string>
+#include <vector>
 
 #include "kudu/consensus/consensus.h"
+#include "kudu/gutil/callback.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/walltime.h"
 #include "kudu/tablet/transactions/transaction.h"
@@ -35,6 +38,7 @@ class Log;
 } // namespace log
 
 namespace tablet {
+class TransactionApplyQueue;
 class TransactionOrderVerifier;
 class TransactionTracker;
 
@@ -72,16 +76,18 @@ class TransactionTracker;
 //
 //      If Prepare() has already completed, then we trigger ApplyAsync().
 //
-//  5 - ApplyAsync() submits ApplyTask() to the apply_pool_.
-//      ApplyTask() calls transaction_->Apply().
+//  5 - ApplyAsync() adds the driver to the tablet's TransactionApplyQueue, which
+//      applies runs of consecutive drivers in a single task on the apply pool.
+//      ApplyRun() calls transaction_->Apply() on each driver of the run.
 //
 //      When Apply() is called, changes are made to the in-memory data structures. These
-//      changes are not visible to clients yet. After Apply() completes, a CommitMsg
-//      is enqueued to the WAL in order to store information about the operation result
-//      and provide correct recovery.
+//      changes are not visible to clients yet. After the run is applied, its CommitMsgs
+//      are enqueued to the WAL as a single entry batch in order to store information
+//      about the operations' results and provide correct recovery.
 //
-//      After the commit message has been enqueued in the Log, the driver executes Finalize()
-//      which, in turn, makes transactions make their changes visible to other transactions.
+//      After the commit messages have been enqueued in the Log, the MVCC transactions of
+//      the run are committed at once, which makes their changes visible to other
+//      transactions, and the driver executes Finalize() on each.
 //      After this step the driver replies to the client if needed and the transaction
 //      is completed.
 //      In-mem data structures that contain the changes made by the transaction can now
@@ -99,7 +105,7 @@ class TransactionDriver : public RefCountedThreadSafe<TransactionDriver> {
                     consensus::Consensus* consensus,
                     log::Log* log,
                     ThreadPool* prepare_pool,
-                    ThreadPool* apply_pool,
+                    TransactionApplyQueue* apply_queue,
                     TransactionOrderVerifier* order_verifier);
 
   // Perform any non-constructor initialization. Sets the transaction
@@ -149,6 +155,7 @@ class TransactionDriver : public RefCountedThreadSafe<TransactionDriver> {
 
  private:
   friend class RefCountedThreadSafe<TransactionDriver>;
+  friend class TransactionApplyQueue;
   enum ReplicationState {
     // The operation has not yet been sent to consensus for replication
     NOT_REPLICATING,
@@ -179,12 +186,17 @@ class TransactionDriver : public RefCountedThreadSafe<TransactionDriver> {
   // Actually prepare and start.
   Status PrepareAndStart();
 
-  // Submits ApplyTask to the apply pool.
+  // Adds this driver to the tablet's apply queue.
   Status ApplyAsync();
 
-  // Calls Transaction::Apply() followed by Consensus::Commit() with the
-  // results from the Apply().
-  void ApplyTask();
+  // Applies the transactions of 'run', which were committed by consensus in
+  // this order, appends their commit messages to the log as a single batch,
+  // commits their MVCC transactions at once and finalizes them.
+  static void ApplyRun(const std::vector<scoped_refptr<TransactionDriver> >& run);
+
+  // Calls Transaction::Apply() and sets 'commit_msg' to the resulting
+  // commit message.
+  void ApplyTransaction(gscoped_ptr<consensus::CommitMsg>* commit_msg);
 
   // Sleeps until the transaction is allowed to commit based on the
   // requested consistency mode.
@@ -216,7 +228,7 @@ class TransactionDriver : public RefCountedThreadSafe<TransactionDriver> {
   consensus::Consensus* const consensus_;
   log::Log* const log_;
   ThreadPool* const prepare_pool_;
-  ThreadPool* const apply_pool_;
+  TransactionApplyQueue* const apply_queue_;
   TransactionOrderVerifier* const order_verifier_;
 
   Status transaction_status_;
@@ -255,6 +267,74 @@ class TransactionDriver : public RefCountedThreadSafe<TransactionDriver> {
   DISALLOW_COPY_AND_ASSIGN(TransactionDriver);
 };
 
+// Per-tablet queue of the transactions which are ready to be applied.
+//
+// Drivers are added in the order consensus committed them. Rather than running
+// one task per transaction on the shared apply pool, the queue runs a single
+// drain task at a time which takes every driver queued so far (up to
+// --tablet_apply_max_batch_size) and applies them as a run, amortizing the
+// task, MVCC commit and commit log entry overheads at high op rates. If more
+// drivers were queued meanwhile, the drain task resubmits itself so that the
+// tablets sharing the pool get their turn. If the pool won't take it, the
+// drain task keeps going on its own thread instead, since committed
+// transactions can't be left unapplied.
+//
+// A run becomes visible only once all of its transactions are applied, so
+// COMMIT_WAIT transactions, which wait out the clock error before they're
+// made visible, are applied in runs of their own. The transactions queued
+// behind one still wait for it, as they must be applied in commit order.
+//
+// This class is thread safe.
+class TransactionApplyQueue : public RefCountedThreadSafe<TransactionApplyQueue> {
+ public:
+  typedef Callback<void(const std::vector<scoped_refptr<TransactionDriver> >&)> ApplyRunCallback;
+
+  // 'apply_pool' must outlive this object.
+  explicit TransactionApplyQueue(ThreadPool* apply_pool);
+
+  // Like the above, but applies each run with 'apply_run' rather than
+  // TransactionDriver::ApplyRun(). Used by tests.
+  TransactionApplyQueue(ThreadPool* apply_pool, ApplyRunCallback apply_run);
+
+  // Adds 'driver' to the queue, submitting a drain task to the apply pool
+  // if none is running. 'commit_wait' is whether the driver's transaction
+  // uses the COMMIT_WAIT external consistency mode, in which case it's applied
+  // in a run of its own.
+  //
+  // If the drain task can't be submitted, returns the error and leaves
+  // 'driver' unapplied. Any drivers queued behind it in the meantime are
+  // applied on the calling thread.
+  Status Submit(TransactionDriver* driver, bool commit_wait);
+
+ private:
+  friend class RefCountedThreadSafe<TransactionApplyQueue>;
+  ~TransactionApplyQueue() {}
+
+  // Applies the drivers queued so far, then resubmits itself if more were
+  // queued in the meantime.
+  void DrainTask();
+
+  ThreadPool* const apply_pool_;
+
+  const ApplyRunCallback apply_run_;
+
+  // Protects 'pending_' and 'draining_'.
+  simple_spinlock lock_;
+
+  struct PendingApply {
+    scoped_refptr<TransactionDriver> driver;
+    bool commit_wait;
+  };
+
+  // The drivers waiting to be applied, in commit order.
+  std::deque<PendingApply> pending_;
+
+  // Whether a drain task is submitted or running.
+  bool draining_;
+
+  DISALLOW_COPY_AND_ASSIGN(TransactionApplyQueue);
+};
+
 }  // namespace tablet
 }  // namespace kudu
 
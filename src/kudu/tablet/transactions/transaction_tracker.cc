@@ -52,6 +52,10 @@ METRIC_DEFINE_gauge_uint64(tablet, alter_schema_transactions_inflight,
                            "Alter Schema Transactions In Flight",
                            kudu::MetricUnit::kTransactions,
                            "Number of alter schema transactions currently in-flight");
+METRIC_DEFINE_gauge_uint64(tablet, bulk_ingest_transactions_inflight,
+                           "Bulk Ingest Transactions In Flight",
+                           kudu::MetricUnit::kTransactions,
+                           "Number of bulk ingest transactions currently in-flight");
 
 METRIC_DEFINE_counter(tablet, transaction_memory_pressure_rejections,
                       "Transaction Memory Pressure Rejections",
@@ -73,6 +77,7 @@ TransactionTracker::Metrics::Metrics(const scoped_refptr<MetricEntity>& entity)
     : GINIT(all_transactions_inflight),
       GINIT(write_transactions_inflight),
       GINIT(alter_schema_transactions_inflight),
+      GINIT(bulk_ingest_transactions_inflight),
       MINIT(transaction_memory_pressure_rejections) {
 }
 #undef GINIT
@@ -138,6 +143,9 @@ void TransactionTracker::IncrementCounters(const TransactionDriver& driver) cons
     case Transaction::ALTER_SCHEMA_TXN:
       metrics_->alter_schema_transactions_inflight->Increment();
       break;
+    case Transaction::BULK_INGEST_TXN:
+      metrics_->bulk_ingest_transactions_inflight->Increment();
+      break;
   }
 }
 
@@ -157,6 +165,10 @@ void TransactionTracker::DecrementCounters(const TransactionDriver& driver) cons
       DCHECK_GT(metrics_->alter_schema_transactions_inflight->value(), 0);
       metrics_->alter_schema_transactions_inflight->Decrement();
       break;
+    case Transaction::BULK_INGEST_TXN:
+      DCHECK_GT(metrics_->bulk_ingest_transactions_inflight->value(), 0);
+      metrics_->bulk_ingest_transactions_inflight->Decrement();
+      break;
   }
 }
 
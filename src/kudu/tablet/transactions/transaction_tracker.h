@@ -76,6 +76,7 @@ class TransactionTracker {
     scoped_refptr<AtomicGauge<uint64_t> > all_transactions_inflight;
     scoped_refptr<AtomicGauge<uint64_t> > write_transactions_inflight;
     scoped_refptr<AtomicGauge<uint64_t> > alter_schema_transactions_inflight;
+    scoped_refptr<AtomicGauge<uint64_t> > bulk_ingest_transactions_inflight;
 
     scoped_refptr<Counter> transaction_memory_pressure_rejections;
   };
@@ -104,6 +104,11 @@ class WriteTransactionState : public TransactionState {
   // WriteTransactionState object.
   void SetMvccTxAndTimestamp(gscoped_ptr<ScopedTransaction> mvcc_tx);
 
+  // Returns the MVCC transaction set by SetMvccTxAndTimestamp(), or NULL.
+  ScopedTransaction* mvcc_tx() {
+    return mvcc_tx_.get();
+  }
+
   // Set the Tablet components that this transaction will write into.
   // Called exactly once at the beginning of Apply, before applying its
   // in-memory edits.
@@ -257,6 +262,10 @@ class WriteTransaction : public Transaction {
   // the metrics, if result == ABORTED aborts the mvcc transaction.
   virtual void Finish(TransactionResult result) OVERRIDE;
 
+  virtual ScopedTransaction* mvcc_tx() OVERRIDE {
+    return state_->mvcc_tx();
+  }
+
   virtual std::string ToString() const OVERRIDE;
 
  private:
@@ -310,9 +310,10 @@ class TabletServerTestBase : public KuduTest {
     } while (resp.has_more_results());
   }
 
+  template<class RespType>
   void StringifyRowsFromResponse(const Schema& projection,
                                  const rpc::RpcController& rpc,
-                                 ScanResponsePB& resp,
+                                 RespType& resp,
                                  vector<string>* results) {
     RowwiseRowBlockPB* rrpb = resp.mutable_data();
     Slice direct, indirect; // sidecar data buffers
@@ -23,6 +23,7 @@
 #include "kudu/server/hybrid_clock.h"
 #include "kudu/server/server_base.pb.h"
 #include "kudu/server/server_base.proxy.h"
+#include "kudu/tablet/tablet_metrics.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/curl_util.h"
 #include "kudu/util/url-coding.h"
@@ -51,11 +52,13 @@ DEFINE_int32(single_threaded_insert_latency_bench_insert_rows, 1000,
 DECLARE_int32(scanner_batch_size_rows);
 DECLARE_int32(metrics_retirement_age_ms);
 DECLARE_string(block_manager);
+DECLARE_int32(tablet_history_max_age_sec);
 
 // Declare these metrics prototypes for simpler unit testing of their behavior.
 METRIC_DECLARE_counter(rows_inserted);
 METRIC_DECLARE_counter(rows_updated);
 METRIC_DECLARE_counter(rows_deleted);
+METRIC_DECLARE_counter(rows_bulk_ingested);
 METRIC_DECLARE_gauge_uint64(log_block_manager_blocks_under_management);
 
 namespace kudu {
@@ -172,6 +175,10 @@ TEST_F(TabletServerTest, TestWebPages) {
   ASSERT_STR_CONTAINS(buf.ToString(), "<th>key</th>");
   ASSERT_STR_CONTAINS(buf.ToString(), "<td>string NULLABLE</td>");
 
+  // The block cache warm-up page should show the warm-up state.
+  ASSERT_OK(c.FetchURL(Substitute("http://$0/block-cache-warmup", addr), &buf));
+  ASSERT_STR_CONTAINS(buf.ToString(), "<td>State</td>");
+
   // Test fetching metrics.
   // Fetching metrics has the side effect of retiring metrics, but not in a single pass.
   // So, we check a couple of times in a loop -- thus, if we had a bug where one of these
@@ -616,6 +623,88 @@ TEST_F(TabletServerTest, TestInsertAndMutate) {
   ASSERT_GE(now_after.value(), now_before.value());
 }
 
+TEST_F(TabletServerTest, TestBulkIngest) {
+  scoped_refptr<TabletPeer> tablet;
+  ASSERT_TRUE(mini_server_->server()->tablet_manager()->LookupTablet(kTabletId, &tablet));
+  scoped_refptr<Counter> rows_bulk_ingested =
+    METRIC_rows_bulk_ingested.Instantiate(tablet->tablet()->GetMetricEntity());
+  tablet.reset();
+
+  InsertTestRowsRemote(0, 1, 1);
+
+  // Ingest a sorted batch of rows after the inserted row.
+  {
+    BulkIngestRequestPB req;
+    BulkIngestResponsePB resp;
+    RpcController controller;
+    req.set_tablet_id(kTabletId);
+    ASSERT_OK(SchemaToPB(schema_, req.mutable_schema()));
+    for (int i = 10; i < 20; i++) {
+      AddTestRowToPB(RowOperationsPB::INSERT, schema_, i, i * 2, "bulk ingested",
+                     req.mutable_row_operations());
+    }
+    SCOPED_TRACE(req.DebugString());
+    ASSERT_OK(proxy_->BulkIngest(req, &resp, &controller));
+    SCOPED_TRACE(resp.DebugString());
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_TRUE(resp.has_timestamp());
+    ASSERT_EQ(10, rows_bulk_ingested->value());
+  }
+
+  // A bulk ingest whose key range overlaps existing rows is rejected as a
+  // whole, even if none of its keys are present.
+  {
+    BulkIngestRequestPB req;
+    BulkIngestResponsePB resp;
+    RpcController controller;
+    req.set_tablet_id(kTabletId);
+    ASSERT_OK(SchemaToPB(schema_, req.mutable_schema()));
+    AddTestRowToPB(RowOperationsPB::INSERT, schema_, 5, 5, "overlapping",
+                   req.mutable_row_operations());
+    AddTestRowToPB(RowOperationsPB::INSERT, schema_, 25, 25, "overlapping",
+                   req.mutable_row_operations());
+    ASSERT_OK(proxy_->BulkIngest(req, &resp, &controller));
+    SCOPED_TRACE(resp.DebugString());
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::KEY_RANGE_NOT_EMPTY, resp.error().code());
+    ASSERT_TRUE(StatusFromPB(resp.error().status()).IsAlreadyPresent());
+  }
+
+  // Rows which aren't sorted by key are rejected.
+  {
+    BulkIngestRequestPB req;
+    BulkIngestResponsePB resp;
+    RpcController controller;
+    req.set_tablet_id(kTabletId);
+    ASSERT_OK(SchemaToPB(schema_, req.mutable_schema()));
+    AddTestRowToPB(RowOperationsPB::INSERT, schema_, 31, 31, "unsorted",
+                   req.mutable_row_operations());
+    AddTestRowToPB(RowOperationsPB::INSERT, schema_, 30, 30, "unsorted",
+                   req.mutable_row_operations());
+    ASSERT_OK(proxy_->BulkIngest(req, &resp, &controller));
+    SCOPED_TRACE(resp.DebugString());
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::INVALID_ROW_BLOCK, resp.error().code());
+  }
+  ASSERT_EQ(10, rows_bulk_ingested->value());
+
+  vector<KeyValue> expected = { KeyValue(0, 0) };
+  for (int i = 10; i < 20; i++) {
+    expected.push_back(KeyValue(i, i * 2));
+  }
+  VerifyRows(schema_, expected);
+
+  // The ingested rows can be updated like any others.
+  UpdateTestRowRemote(0, 15, 12345);
+  expected[6] = KeyValue(15, 12345);
+  VerifyRows(schema_, expected);
+
+  // Replaying the log doesn't ingest the rows a second time.
+  rows_bulk_ingested = nullptr;
+  ASSERT_NO_FATAL_FAILURE(ShutdownAndRebuildTablet());
+  VerifyRows(schema_, expected);
+}
+
 // Test that passing a schema with fields not present in the tablet schema
 // throws an exception.
 TEST_F(TabletServerTest, TestInvalidWriteRequest_BadSchema) {
@@ -1380,6 +1469,41 @@ TEST_F(TabletServerTest, TestSnapshotScan__SnapshotInTheFutureBeyondPropagatedTi
   }
 }
 
+// Test that a snapshot scan older than the tablet history retention window
+// fails cleanly instead of returning incomplete history.
+TEST_F(TabletServerTest, TestSnapshotScan__SnapshotBeforeAncientHistoryMarkFails) {
+  FLAGS_tablet_history_max_age_sec = 60;
+  vector<uint64_t> write_timestamps_collector;
+  InsertTestRowsRemote(0, 0, 1, 1, nullptr, kTabletId, &write_timestamps_collector);
+
+  ScanRequestPB req;
+  ScanResponsePB resp;
+  RpcController rpc;
+
+  const Schema& projection = schema_;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(projection, scan->mutable_projected_columns()));
+  req.set_call_seq_id(0);
+  req.set_batch_size_bytes(0);
+  scan->set_read_mode(READ_AT_SNAPSHOT);
+
+  // Read two retention windows before the write.
+  Timestamp read_timestamp(write_timestamps_collector[0]);
+  read_timestamp = HybridClock::TimestampFromMicroseconds(
+      HybridClock::GetPhysicalValueMicros(read_timestamp) - 120000000);
+  scan->set_snap_timestamp(read_timestamp.ToUint64());
+
+  {
+    SCOPED_TRACE(req.DebugString());
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(resp.DebugString());
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::INVALID_SNAPSHOT, resp.error().code());
+    ASSERT_STR_CONTAINS(resp.error().status().message(), "history retention window");
+  }
+}
+
 TEST_F(TabletServerTest, TestScanWithStringPredicates) {
   InsertTestRowsDirect(0, 100);
 
@@ -1511,6 +1635,69 @@ TEST_F(TabletServerTest, TestScanWithEncodedPredicates) {
 
 
 // Test requesting more rows from a scanner which doesn't exist
+// Test looking up rows by primary key with the MultiGet RPC, both from
+// the MemRowSet and from a DiskRowSet with updates and deletes.
+TEST_F(TabletServerTest, TestMultiGet) {
+  InsertTestRowsDirect(0, 100);
+  ASSERT_OK(tablet_peer_->tablet()->Flush());
+  InsertTestRowsDirect(100, 10);
+  ASSERT_NO_FATAL_FAILURE(UpdateTestRowRemote(0, 7, 70));
+  ASSERT_NO_FATAL_FAILURE(DeleteTestRowsRemote(5, 1));
+
+  MultiGetRequestPB req;
+  MultiGetResponsePB resp;
+  rpc::RpcController rpc;
+  req.set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, req.mutable_projected_columns()));
+  for (int key : { 105, 5, 1000, 7, 42 }) {
+    KuduPartialRow row(&schema_);
+    ASSERT_OK(row.SetInt32(0, key));
+    string encoded_key;
+    ASSERT_OK(row.EncodeRowKey(&encoded_key));
+    req.add_encoded_keys(encoded_key);
+  }
+
+  {
+    SCOPED_TRACE(req.DebugString());
+    ASSERT_OK(proxy_->MultiGet(req, &resp, &rpc));
+    SCOPED_TRACE(resp.DebugString());
+    ASSERT_FALSE(resp.has_error());
+  }
+
+  // Deleted and missing keys are omitted from the response.
+  ASSERT_EQ(3, resp.key_indexes_size());
+  ASSERT_EQ(0, resp.key_indexes(0));
+  ASSERT_EQ(3, resp.key_indexes(1));
+  ASSERT_EQ(4, resp.key_indexes(2));
+
+  vector<string> results;
+  ASSERT_NO_FATAL_FAILURE(StringifyRowsFromResponse(schema_, rpc, resp, &results));
+  ASSERT_EQ(3, results.size());
+  KuduPartialRow row(&schema_);
+  BuildTestRow(105, &row);
+  ASSERT_EQ("(" + row.ToString() + ")", results[0]);
+  ASSERT_EQ("(int32 key=7, int32 int_val=70, string string_val=mutated7)", results[1]);
+  BuildTestRow(42, &row);
+  ASSERT_EQ("(" + row.ToString() + ")", results[2]);
+
+  ASSERT_EQ(5, tablet_peer_->tablet()->metrics()->multi_get_keys_requested->value());
+  ASSERT_EQ(3, tablet_peer_->tablet()->metrics()->multi_get_rows_returned->value());
+}
+
+TEST_F(TabletServerTest, TestMultiGet_InvalidKey) {
+  MultiGetRequestPB req;
+  MultiGetResponsePB resp;
+  rpc::RpcController rpc;
+  req.set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, req.mutable_projected_columns()));
+  req.add_encoded_keys("x");
+
+  ASSERT_OK(proxy_->MultiGet(req, &resp, &rpc));
+  ASSERT_TRUE(resp.has_error());
+  ASSERT_EQ(TabletServerErrorPB::INVALID_SCAN_SPEC, resp.error().code());
+  ASSERT_STR_CONTAINS(resp.error().status().message(), "Invalid key at index 0");
+}
+
 TEST_F(TabletServerTest, TestBadScannerID) {
   ScanRequestPB req;
   ScanResponsePB resp;
@@ -2080,7 +2267,7 @@ TEST_F(TabletServerTest, TestWriteOutOfBounds) {
   ASSERT_OK(mini_server_->server()->tablet_manager()->CreateNewTablet(
       "TestWriteOutOfBoundsTable", tabletId,
       partitions[1],
-      tabletId, schema, partition_schema,
+      tabletId, schema, partition_schema, RowTtlPB(),
       mini_server_->CreateLocalConfig(), nullptr));
 
   ASSERT_OK(WaitForTabletRunning(tabletId));
@@ -17,11 +17,13 @@
 
 #include "kudu/tserver/tablet_server.h"
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <list>
 #include <vector>
 
 #include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/block_cache_warmer.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/service_if.h"
@@ -34,10 +36,19 @@
 #include "kudu/tserver/ts_tablet_manager.h"
 #include "kudu/tserver/tserver-path-handlers.h"
 #include "kudu/tserver/remote_bootstrap_service.h"
+#include "kudu/tserver/write_admission_controller.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/status.h"
 
+DEFINE_bool(block_cache_warmup_enabled, true,
+            "Whether to periodically save the locations of the most recently used "
+            "blocks of the block cache, and read them back into the cache in the "
+            "background after the tablet server restarts.");
+TAG_FLAG(block_cache_warmup_enabled, advanced);
+
+using kudu::cfile::BlockCacheWarmer;
 using kudu::rpc::ServiceIf;
 using kudu::tablet::TabletPeer;
 using std::shared_ptr;
@@ -92,12 +103,21 @@ Status TabletServer::Init() {
 
   heartbeater_.reset(new Heartbeater(opts_, this));
 
+  if (FLAGS_block_cache_warmup_enabled) {
+    block_cache_warmer_.reset(new BlockCacheWarmer(fs_manager_->block_manager(),
+                                                   fs_manager_->env(),
+                                                   fs_manager_->GetBlockCacheWarmupPath()));
+  }
+
   RETURN_NOT_OK_PREPEND(tablet_manager_->Init(),
                         "Could not init Tablet Manager");
 
   RETURN_NOT_OK_PREPEND(scanner_manager_->StartRemovalThread(),
                         "Could not start expired Scanner removal thread");
 
+  write_admission_controller_.reset(new WriteAdmissionController(tablet_manager_.get(),
+                                                                 metric_entity()));
+
   initted_ = true;
   return Status::OK();
 }
@@ -124,6 +144,12 @@ Status TabletServer::Start() {
 
   RETURN_NOT_OK(heartbeater_->Start());
   RETURN_NOT_OK(maintenance_manager_->Init());
+  RETURN_NOT_OK_PREPEND(write_admission_controller_->Start(),
+                        "Could not start write admission controller thread");
+  if (block_cache_warmer_) {
+    RETURN_NOT_OK_PREPEND(block_cache_warmer_->Start(),
+                          "Could not start block cache warmer thread");
+  }
 
   google::FlushLogFiles(google::INFO); // Flush the startup messages.
 
@@ -134,7 +160,11 @@ void TabletServer::Shutdown() {
   LOG(INFO) << "TabletServer shutting down...";
 
   if (initted_) {
+    if (block_cache_warmer_) {
+      block_cache_warmer_->Shutdown();
+    }
     maintenance_manager_->Shutdown();
+    write_admission_controller_->Shutdown();
     WARN_NOT_OK(heartbeater_->Stop(), "Failed to stop TS Heartbeat thread");
     ServerBase::Shutdown();
     tablet_manager_->Shutdown();
@@ -37,12 +37,17 @@ namespace kudu {
 
 class MaintenanceManager;
 
+namespace cfile {
+class BlockCacheWarmer;
+} // namespace cfile
+
 namespace tserver {
 
 class Heartbeater;
 class ScannerManager;
 class TabletServerPathHandlers;
 class TSTabletManager;
+class WriteAdmissionController;
 
 class TabletServer : public server::ServerBase {
  public:
@@ -87,6 +92,15 @@ class TabletServer : public server::ServerBase {
     return maintenance_manager_.get();
   }
 
+  WriteAdmissionController* write_admission_controller() {
+    return write_admission_controller_.get();
+  }
+
+  // Returns NULL if the block cache warm-up is disabled.
+  cfile::BlockCacheWarmer* block_cache_warmer() {
+    return block_cache_warmer_.get();
+  }
+
  private:
   friend class TabletServerTestBase;
 
@@ -117,6 +131,13 @@ class TabletServer : public server::ServerBase {
   // The maintenance manager for this tablet server
   std::shared_ptr<MaintenanceManager> maintenance_manager_;
 
+  // Saves the contents of the block cache, and reads them back after a
+  // restart.
+  gscoped_ptr<cfile::BlockCacheWarmer> block_cache_warmer_;
+
+  // Paces writes when the server comes under memory or WAL pressure.
+  gscoped_ptr<WriteAdmissionController> write_admission_controller_;
+
   DISALLOW_COPY_AND_ASSIGN(TabletServer);
 };
 
@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 
+#include "kudu/cfile/block_cache.h"
 #include "kudu/common/iterator.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
@@ -33,20 +34,24 @@
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/escaping.h"
+#include "kudu/rpc/messenger.h"
 #include "kudu/rpc/rpc_context.h"
 #include "kudu/rpc/rpc_sidecar.h"
 #include "kudu/server/hybrid_clock.h"
 #include "kudu/tablet/metadata.pb.h"
+#include "kudu/tablet/rowset.h"
 #include "kudu/tablet/tablet_bootstrap.h"
 #include "kudu/tablet/tablet_metrics.h"
 #include "kudu/tablet/tablet_peer.h"
 #include "kudu/tablet/transactions/alter_schema_transaction.h"
+#include "kudu/tablet/transactions/bulk_ingest_transaction.h"
 #include "kudu/tablet/transactions/write_transaction.h"
 #include "kudu/tserver/remote_bootstrap_service.h"
 #include "kudu/tserver/scanners.h"
 #include "kudu/tserver/tablet_server.h"
 #include "kudu/tserver/ts_tablet_manager.h"
 #include "kudu/tserver/tserver.pb.h"
+#include "kudu/tserver/write_admission_controller.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/faststring.h"
@@ -82,6 +87,8 @@ DEFINE_int32(scanner_inject_latency_on_each_batch_ms, 0,
 TAG_FLAG(scanner_inject_latency_on_each_batch_ms, unsafe);
 
 DECLARE_int32(memory_limit_warn_threshold_percentage);
+DECLARE_bool(write_admission_control_enabled);
+DECLARE_int32(write_admission_max_queue_ms);
 
 namespace kudu {
 namespace tserver {
@@ -113,6 +120,7 @@ using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 using tablet::AlterSchemaTransactionState;
+using tablet::BulkIngestTransactionState;
 using tablet::Tablet;
 using tablet::TabletPeer;
 using tablet::TabletStatusPB;
@@ -614,6 +622,7 @@ void TabletServiceAdminImpl::CreateTablet(const CreateTabletRequestPB* req,
                                                  req->table_name(),
                                                  schema,
                                                  partition_schema,
+                                                 req->row_ttl(),
                                                  req->config(),
                                                  nullptr);
   if (PREDICT_FALSE(!s.ok())) {
@@ -696,6 +705,59 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
     return;
   }
 
+  // Pace the write if the server is under memory or WAL pressure, queueing it
+  // or asking the client to retry later.
+  if (FLAGS_write_admission_control_enabled) {
+    // The controller only samples the memory consumption periodically, so
+    // check the hard limit here too: pacing alone can't keep the server
+    // below it.
+    if (PREDICT_FALSE(tablet->mem_tracker()->AnyLimitExceeded())) {
+      tablet->metrics()->leader_memory_pressure_rejections->Increment();
+      KLOG_EVERY_N_SECS(WARNING, 1) << "Rejecting Write request: hard memory limit exceeded"
+                                    << THROTTLE_MSG;
+      context->RespondServerTooBusy(
+          Status::ServiceUnavailable("Rejecting Write request: hard memory limit exceeded"),
+          MonoDelta::FromMilliseconds(FLAGS_write_admission_max_queue_ms));
+      return;
+    }
+    MonoDelta delay;
+    WriteAdmissionController::Decision decision =
+        server_->write_admission_controller()->Admit(req->tablet_id(), bytes,
+                                                     MonoTime::Now(MonoTime::FINE), &delay);
+    if (decision == WriteAdmissionController::REJECT) {
+      KLOG_EVERY_N_SECS(INFO, 1) << "Rejecting Write request to tablet " << req->tablet_id()
+                                 << ": it exceeded its share of the admitted write rate, or "
+                                 << "the tablet server reached its memory or log cache limit"
+                                 << THROTTLE_MSG;
+      context->RespondServerTooBusy(
+          Status::ServiceUnavailable("Rejecting Write request: tablet server is overloaded"),
+          delay);
+      return;
+    }
+    if (delay.ToMicroseconds() > 0) {
+      TRACE("Queueing write for $0", delay.ToString());
+      server_->messenger()->ScheduleOnReactor(
+          [this, tablet_peer, req, resp, context](const Status& s) {
+            if (PREDICT_FALSE(!s.ok())) {
+              SetupErrorAndRespond(resp->mutable_error(), s,
+                                   TabletServerErrorPB::UNKNOWN_ERROR, context);
+              return;
+            }
+            // Don't apply a write which the client gave up on while it was queued.
+            if (PREDICT_FALSE(context->cancelled())) {
+              TRACE("Dropping queued write: client cancelled it");
+              context->RespondFailure(Status::Aborted("Write request was cancelled"));
+              return;
+            }
+            SubmitWrite(tablet_peer, req, resp, context);
+          },
+          delay);
+      return;
+    }
+    SubmitWrite(tablet_peer, req, resp, context);
+    return;
+  }
+
   // Check for memory pressure; don't bother doing any additional work if we've
   // exceeded the limit.
   double capacity_pct;
@@ -715,6 +777,13 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
     return;
   }
 
+  SubmitWrite(tablet_peer, req, resp, context);
+}
+
+void TabletServiceImpl::SubmitWrite(const scoped_refptr<TabletPeer>& tablet_peer,
+                                    const WriteRequestPB* req,
+                                    WriteResponsePB* resp,
+                                    rpc::RpcContext* context) {
   if (!server_->clock()->SupportsExternalConsistencyMode(req->external_consistency_mode())) {
     Status s = Status::NotSupported("The configured clock does not support the"
         " required consistency mode.");
@@ -730,6 +799,7 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
 
   // If the client sent us a timestamp, decode it and update the clock so that all future
   // timestamps are greater than the passed timestamp.
+  Status s;
   if (req->has_propagated_timestamp()) {
     Timestamp ts(req->propagated_timestamp());
     s = server_->clock()->Update(ts);
@@ -757,6 +827,55 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
   return;
 }
 
+void TabletServiceImpl::BulkIngest(const BulkIngestRequestPB* req,
+                                   BulkIngestResponsePB* resp,
+                                   rpc::RpcContext* context) {
+  TRACE_EVENT1("tserver", "TabletServiceImpl::BulkIngest",
+               "tablet_id", req->tablet_id());
+  DVLOG(3) << "Received BulkIngest RPC for tablet " << req->tablet_id();
+
+  scoped_refptr<TabletPeer> tablet_peer;
+  if (!LookupTabletPeerOrRespond(server_->tablet_manager(), req->tablet_id(), resp, context,
+                                 &tablet_peer)) {
+    return;
+  }
+
+  shared_ptr<Tablet> tablet;
+  TabletServerErrorPB::Code error_code;
+  Status s = GetTabletRef(tablet_peer, &tablet, &error_code);
+  if (PREDICT_FALSE(!s.ok())) {
+    SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
+    return;
+  }
+
+  // The rows bypass the MemRowSet, so unlike writes there is no need to
+  // check for memory pressure.
+  if (req->has_propagated_timestamp()) {
+    Timestamp ts(req->propagated_timestamp());
+    s = server_->clock()->Update(ts);
+  }
+  if (PREDICT_FALSE(!s.ok())) {
+    SetupErrorAndRespond(resp->mutable_error(), s,
+                         TabletServerErrorPB::UNKNOWN_ERROR,
+                         context);
+    return;
+  }
+
+  unique_ptr<BulkIngestTransactionState> tx_state(
+      new BulkIngestTransactionState(tablet_peer.get(), req, resp));
+  tx_state->set_completion_callback(gscoped_ptr<TransactionCompletionCallback>(
+      new RpcTransactionCompletionCallback<BulkIngestResponsePB>(context,
+                                                                 resp)));
+
+  // Submit the bulk ingest. The RPC will be responded to asynchronously.
+  s = tablet_peer->SubmitBulkIngest(std::move(tx_state));
+  if (PREDICT_FALSE(!s.ok())) {
+    SetupErrorAndRespond(resp->mutable_error(), s,
+                         TabletServerErrorPB::UNKNOWN_ERROR,
+                         context);
+  }
+}
+
 ConsensusServiceImpl::ConsensusServiceImpl(const scoped_refptr<MetricEntity>& metric_entity,
                                            TabletPeerLookupIf* tablet_manager)
   : ConsensusServiceIf(metric_entity),
@@ -1002,6 +1121,7 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
                              ScanResponsePB* resp,
                              rpc::RpcContext* context) {
   TRACE_EVENT0("tserver", "TabletServiceImpl::Scan");
+  cfile::ScopedScanDiskReads scan_disk_reads;
   // Validate the request: user must pass a new_scan_request or
   // a scanner ID, but not both.
   if (PREDICT_FALSE(req->has_scanner_id() &&
@@ -1044,7 +1164,8 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
       resp->set_snap_timestamp(scan_timestamp.ToUint64());
     }
   } else if (req->has_scanner_id()) {
-    Status s = HandleContinueScanRequest(req, &collector, &has_more_results, &error_code);
+    Status s = HandleContinueScanRequest(req, context, &collector, &has_more_results,
+                                         &error_code);
     if (PREDICT_FALSE(!s.ok())) {
       SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
       return;
@@ -1086,6 +1207,159 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
   context->RespondSuccess();
 }
 
+void TabletServiceImpl::MultiGet(const MultiGetRequestPB* req,
+                                 MultiGetResponsePB* resp,
+                                 rpc::RpcContext* context) {
+  TRACE_EVENT1("tserver", "TabletServiceImpl::MultiGet",
+               "tablet_id", req->tablet_id());
+  cfile::ScopedScanDiskReads scan_disk_reads;
+
+  scoped_refptr<TabletPeer> tablet_peer;
+  if (!LookupTabletPeerOrRespond(server_->tablet_manager(), req->tablet_id(), resp, context,
+                                 &tablet_peer)) {
+    return;
+  }
+
+  shared_ptr<Tablet> tablet;
+  TabletServerErrorPB::Code error_code;
+  Status s = GetTabletRef(tablet_peer, &tablet, &error_code);
+  if (PREDICT_FALSE(!s.ok())) {
+    SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
+    return;
+  }
+
+  Schema projection;
+  s = ColumnPBsToSchema(req->projected_columns(), &projection);
+  if (PREDICT_FALSE(!s.ok())) {
+    SetupErrorAndRespond(resp->mutable_error(), s,
+                         TabletServerErrorPB::INVALID_SCHEMA, context);
+    return;
+  }
+  if (PREDICT_FALSE(projection.has_column_ids())) {
+    SetupErrorAndRespond(resp->mutable_error(),
+                         Status::InvalidArgument("User requests should not have Column IDs"),
+                         TabletServerErrorPB::INVALID_SCHEMA, context);
+    return;
+  }
+  // The tablet only hides expired rows if the TTL column is read, so add it
+  // to the projection if needed. SerializeRowBlock() only returns the columns
+  // of the client's projection.
+  Schema read_projection = projection;
+  int ttl_col_idx = tablet->GetRowTtlColumnIndex();
+  if (ttl_col_idx != Schema::kColumnNotFound) {
+    const ColumnSchema& ttl_col = tablet->schema()->column(ttl_col_idx);
+    if (projection.find_column(ttl_col.name()) == Schema::kColumnNotFound) {
+      SchemaBuilder builder;
+      for (int i = 0; i < projection.num_columns(); i++) {
+        CHECK_OK(builder.AddColumn(projection.column(i), i < projection.num_key_columns()));
+      }
+      CHECK_OK(builder.AddColumn(ttl_col, false));
+      read_projection = builder.BuildWithoutIds();
+    }
+  }
+  Schema mapped_projection;
+  s = tablet->GetMappedReadProjection(read_projection, &mapped_projection);
+  if (PREDICT_FALSE(!s.ok())) {
+    SetupErrorAndRespond(resp->mutable_error(), s,
+                         TabletServerErrorPB::MISMATCHED_SCHEMA, context);
+    return;
+  }
+
+  // Expired rows are hidden as of the snapshot's timestamp, or as of now when
+  // reading the latest data.
+  tablet::MvccSnapshot snap;
+  Timestamp expiry_time;
+  switch (req->read_mode()) {
+    case READ_LATEST: {
+      snap = tablet::MvccSnapshot(*tablet->mvcc_manager());
+      expiry_time = server_->clock()->Now();
+      break;
+    }
+    case READ_AT_SNAPSHOT: {
+      Timestamp propagated_timestamp(req->propagated_timestamp());
+      Timestamp requested_timestamp(req->snap_timestamp());
+      Timestamp snap_timestamp;
+      s = WaitForReadSnapshot(
+          req->has_propagated_timestamp() ? &propagated_timestamp : nullptr,
+          req->has_snap_timestamp() ? &requested_timestamp : nullptr,
+          context, tablet_peer.get(), tablet, &snap, &snap_timestamp);
+      if (PREDICT_FALSE(!s.ok())) {
+        SetupErrorAndRespond(resp->mutable_error(), s,
+                             TabletServerErrorPB::INVALID_SNAPSHOT, context);
+        return;
+      }
+      resp->set_snap_timestamp(snap_timestamp.ToUint64());
+      expiry_time = snap_timestamp;
+      break;
+    }
+    default: {
+      SetupErrorAndRespond(resp->mutable_error(), Status::NotSupported("Unknown read mode."),
+                           TabletServerErrorPB::INVALID_SCAN_SPEC, context);
+      return;
+    }
+  }
+
+  // Each key is decoded into 'key_buf' and looked up directly in the rowsets
+  // which may contain it. Found rows are serialized as they are read, since
+  // each lookup resets 'block' and its arena.
+  const Schema& key_schema = tablet->key_schema();
+  gscoped_ptr<uint8_t[]> key_buf(new uint8_t[key_schema.key_byte_size()]);
+  Arena key_arena(256, 64 * 1024);
+  Arena block_arena(1024, 1024 * 1024);
+  RowBlock block(mapped_projection, 1, &block_arena);
+
+  gscoped_ptr<faststring> rows_data(new faststring());
+  gscoped_ptr<faststring> indirect_data(new faststring());
+  RowwiseRowBlockPB* data = resp->mutable_data();
+  data->set_num_rows(0);
+
+  TRACE("Looking up $0 keys", req->encoded_keys_size());
+  for (int i = 0; i < req->encoded_keys_size(); i++) {
+    key_arena.Reset();
+    s = key_schema.DecodeRowKey(req->encoded_keys(i), key_buf.get(), &key_arena);
+    if (PREDICT_FALSE(!s.ok())) {
+      SetupErrorAndRespond(resp->mutable_error(),
+                           s.CloneAndPrepend(Substitute("Invalid key at index $0", i)),
+                           TabletServerErrorPB::INVALID_SCAN_SPEC, context);
+      return;
+    }
+    tablet::RowSetKeyProbe probe(ConstContiguousRow(&key_schema, key_buf.get()));
+    bool present;
+    s = tablet->GetRow(probe, snap, expiry_time, &block, &present);
+    if (PREDICT_FALSE(!s.ok())) {
+      SetupErrorAndRespond(resp->mutable_error(), s,
+                           s.IsNotFound() ? TabletServerErrorPB::INVALID_SCAN_SPEC
+                                          : TabletServerErrorPB::UNKNOWN_ERROR,
+                           context);
+      return;
+    }
+    if (present) {
+      SerializeRowBlock(block, data, &projection, rows_data.get(), indirect_data.get());
+      resp->add_key_indexes(i);
+    }
+  }
+  TRACE("Found $0 rows", resp->key_indexes_size());
+
+  tablet->metrics()->multi_get_keys_requested->IncrementBy(req->encoded_keys_size());
+  tablet->metrics()->multi_get_rows_returned->IncrementBy(resp->key_indexes_size());
+
+  if (resp->key_indexes_size() > 0) {
+    int rows_idx;
+    CHECK_OK(context->AddRpcSidecar(make_gscoped_ptr(
+        new rpc::RpcSidecar(std::move(rows_data))), &rows_idx));
+    data->set_rows_sidecar(rows_idx);
+
+    if (indirect_data->size() > 0) {
+      int indirect_idx;
+      CHECK_OK(context->AddRpcSidecar(make_gscoped_ptr(
+          new rpc::RpcSidecar(std::move(indirect_data))), &indirect_idx));
+      data->set_indirect_data_sidecar(indirect_idx);
+    }
+  }
+
+  context->RespondSuccess();
+}
+
 void TabletServiceImpl::ListTablets(const ListTabletsRequestPB* req,
                                     ListTabletsResponsePB* resp,
                                     rpc::RpcContext* context) {
@@ -1106,6 +1380,7 @@ void TabletServiceImpl::Checksum(const ChecksumRequestPB* req,
                                  ChecksumResponsePB* resp,
                                  rpc::RpcContext* context) {
   VLOG(1) << "Full request: " << req->DebugString();
+  cfile::ScopedScanDiskReads scan_disk_reads;
 
   // Validate the request: user must pass a new_scan_request or
   // a scanner ID, but not both.
@@ -1151,7 +1426,8 @@ void TabletServiceImpl::Checksum(const ChecksumRequestPB* req,
     const ContinueChecksumRequestPB& continue_req = req->continue_request();
     collector.set_agg_checksum(continue_req.previous_checksum());
     scan_req.set_scanner_id(continue_req.scanner_id());
-    Status s = HandleContinueScanRequest(&scan_req, &collector, &has_more, &error_code);
+    Status s = HandleContinueScanRequest(&scan_req, context, &collector, &has_more,
+                                         &error_code);
     if (PREDICT_FALSE(!s.ok())) {
       SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
       return;
@@ -1169,7 +1445,9 @@ void TabletServiceImpl::Checksum(const ChecksumRequestPB* req,
 }
 
 bool TabletServiceImpl::SupportsFeature(uint32_t feature) const {
-  return feature == TabletServerFeatures::COLUMN_PREDICATES;
+  return feature == TabletServerFeatures::COLUMN_PREDICATES ||
+      feature == TabletServerFeatures::MULTI_GET ||
+      feature == TabletServerFeatures::BULK_INGEST;
 }
 
 void TabletServiceImpl::Shutdown() {
@@ -1401,6 +1679,21 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletPeer* tablet_peer,
     return s;
   }
 
+  // The tablet hides expired rows with a predicate on the TTL column, so it
+  // must be read even if the client didn't ask for it.
+  RowTtlPB row_ttl = tablet_peer->tablet_metadata()->row_ttl();
+  if (row_ttl.ttl_secs() > 0) {
+    int ttl_col_idx = tablet_schema.find_column_by_id(ColumnId(row_ttl.column_id()));
+    if (ttl_col_idx != Schema::kColumnNotFound) {
+      const ColumnSchema& ttl_col = tablet_schema.column(ttl_col_idx);
+      if (projection.find_column(ttl_col.name()) == Schema::kColumnNotFound &&
+          std::none_of(missing_cols.begin(), missing_cols.end(),
+                       [&](const ColumnSchema& col) { return col.name() == ttl_col.name(); })) {
+        missing_cols.push_back(ttl_col);
+      }
+    }
+  }
+
   VLOG(3) << "Before optimizing scan spec: " << spec->ToString(tablet_schema);
   spec->OptimizeScan(tablet_schema, scanner->arena(), scanner->autorelease_pool(), true);
   VLOG(3) << "After optimizing scan spec: " << spec->ToString(tablet_schema);
@@ -1448,7 +1741,8 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletPeer* tablet_peer,
         break;
       }
       case READ_AT_SNAPSHOT: {
-        s = HandleScanAtSnapshot(scan_pb, rpc_context, projection, tablet, &iter, snap_timestamp);
+        s = HandleScanAtSnapshot(scan_pb, rpc_context, projection, tablet_peer, tablet,
+                                 &iter, snap_timestamp);
         if (!s.ok()) {
           tmp_error_code = TabletServerErrorPB::INVALID_SNAPSHOT;
         }
@@ -1497,8 +1791,8 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletPeer* tablet_peer,
     // and call the second half directly
     ScanRequestPB continue_req(*req);
     continue_req.set_scanner_id(scanner->id());
-    RETURN_NOT_OK(HandleContinueScanRequest(&continue_req, result_collector, has_more_results,
-                                            error_code));
+    RETURN_NOT_OK(HandleContinueScanRequest(&continue_req, rpc_context, result_collector,
+                                            has_more_results, error_code));
   } else {
     // Increment the scanner call sequence ID. HandleContinueScanRequest handles
     // this in the non-empty scan case.
@@ -1509,6 +1803,7 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletPeer* tablet_peer,
 
 // Continue an existing scan request.
 Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
+                                                    const rpc::RpcContext* rpc_context,
                                                     ScanResultCollector* result_collector,
                                                     bool* has_more_results,
                                                     TabletServerErrorPB::Code* error_code) {
@@ -1594,7 +1889,14 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
       TRACE("Copied block (nrows=$0), new size=$1", block.nrows(), response_size);
     }
 
-    // TODO: should check if RPC got cancelled, once we implement RPC cancellation.
+    // The client won't see the response of a cancelled call, so stop
+    // scanning. The rows read so far are skipped over, as for any response
+    // which doesn't reach the client.
+    if (PREDICT_FALSE(rpc_context->cancelled())) {
+      TRACE("Call cancelled - responding early");
+      break;
+    }
+
     MonoTime now = MonoTime::Now(MonoTime::COARSE);
     if (PREDICT_FALSE(!now.ComesBefore(deadline))) {
       TRACE("Deadline expired - responding early");
@@ -1650,52 +1952,54 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
   return Status::OK();
 }
 
-Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
-                                               const RpcContext* rpc_context,
-                                               const Schema& projection,
-                                               const shared_ptr<Tablet>& tablet,
-                                               gscoped_ptr<RowwiseIterator>* iter,
-                                               Timestamp* snap_timestamp) {
-
-  // TODO check against the earliest boundary (i.e. how early can we go) right
-  // now we're keeping all undos/redos forever!
-
+Status TabletServiceImpl::WaitForReadSnapshot(const Timestamp* propagated_timestamp,
+                                              const Timestamp* requested_timestamp,
+                                              const RpcContext* rpc_context,
+                                              TabletPeer* tablet_peer,
+                                              const shared_ptr<Tablet>& tablet,
+                                              tablet::MvccSnapshot* snap,
+                                              Timestamp* snap_timestamp) {
   // If the client sent a timestamp update our clock with it.
-  if (scan_pb.has_propagated_timestamp()) {
-    Timestamp propagated_timestamp(scan_pb.propagated_timestamp());
-
+  if (propagated_timestamp != nullptr) {
     // Update the clock so that we never generate snapshots lower that
     // 'propagated_timestamp'. If 'propagated_timestamp' is lower than
     // 'now' this call has no effect. If 'propagated_timestamp' is too much
     // into the future this will fail and we abort.
-    RETURN_NOT_OK(server_->clock()->Update(propagated_timestamp));
+    RETURN_NOT_OK(server_->clock()->Update(*propagated_timestamp));
   }
 
-  Timestamp tmp_snap_timestamp;
-
   // If the client provided no snapshot timestamp we take the current clock
   // time as the snapshot timestamp.
-  if (!scan_pb.has_snap_timestamp()) {
-    tmp_snap_timestamp = server_->clock()->Now();
+  if (requested_timestamp == nullptr) {
+    *snap_timestamp = server_->clock()->Now();
   // ... else we use the client provided one, but make sure it is not too far
   // in the future as to be invalid.
   } else {
-    tmp_snap_timestamp.FromUint64(scan_pb.snap_timestamp());
+    *snap_timestamp = *requested_timestamp;
     Timestamp max_allowed_ts;
     Status s = server_->clock()->GetGlobalLatest(&max_allowed_ts);
     if (!s.ok()) {
       return Status::NotSupported("Snapshot scans not supported on this server",
                                   s.ToString());
     }
-    if (tmp_snap_timestamp.CompareTo(max_allowed_ts) > 0) {
+    if (snap_timestamp->CompareTo(max_allowed_ts) > 0) {
       return Status::InvalidArgument(
           Substitute("Snapshot time $0 in the future. Max allowed timestamp is $1",
-                     server_->clock()->Stringify(tmp_snap_timestamp),
+                     server_->clock()->Stringify(*snap_timestamp),
                      server_->clock()->Stringify(max_allowed_ts)));
     }
-  }
 
-  tablet::MvccSnapshot snap;
+    // ... and that its history hasn't been garbage collected yet.
+    Timestamp ancient_history_mark;
+    if (tablet->GetTabletAncientHistoryMark(&ancient_history_mark) &&
+        snap_timestamp->CompareTo(ancient_history_mark) < 0) {
+      return Status::InvalidArgument(
+          Substitute("Snapshot time $0 is older than the tablet history retention window. "
+                     "The earliest allowed timestamp is $1",
+                     server_->clock()->Stringify(*snap_timestamp),
+                     server_->clock()->Stringify(ancient_history_mark)));
+    }
+  }
 
   // Wait for the in-flights in the snapshot to be finished.
   // We'll use the client-provided deadline, but not if it's more than 5 seconds from
@@ -1716,16 +2020,51 @@ Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
     deadline = client_deadline;
   }
 
+  // A leader assigns the timestamps, so its clock tells it which operations may
+  // still start below the snapshot. Any other replica relies on the safe time
+  // propagated by the leader instead.
+  Consensus* consensus = tablet_peer->consensus();
+  bool is_leader = consensus == nullptr || consensus->role() == consensus::RaftPeerPB::LEADER;
+
   TRACE("Waiting for operations in snapshot to commit");
   MonoTime before = MonoTime::Now(MonoTime::FINE);
-  RETURN_NOT_OK_PREPEND(
-      tablet->mvcc_manager()->WaitForCleanSnapshotAtTimestamp(
-          tmp_snap_timestamp, &snap, deadline),
-      "could not wait for desired snapshot timestamp to be consistent");
+  if (is_leader) {
+    RETURN_NOT_OK_PREPEND(
+        tablet->mvcc_manager()->WaitForCleanSnapshotAtTimestamp(
+            *snap_timestamp, snap, deadline),
+        "could not wait for desired snapshot timestamp to be consistent");
+  } else {
+    RETURN_NOT_OK_PREPEND(
+        tablet->mvcc_manager()->WaitForFollowerSnapshotAtTimestamp(
+            *snap_timestamp, snap, deadline),
+        "could not wait for the safe time to reach the desired snapshot timestamp");
+  }
 
   uint64_t duration_usec = MonoTime::Now(MonoTime::FINE).GetDeltaSince(before).ToMicroseconds();
   tablet->metrics()->snapshot_read_inflight_wait_duration->Increment(duration_usec);
   TRACE("All operations in snapshot committed. Waited for $0 microseconds", duration_usec);
+  if (!is_leader) {
+    tablet->metrics()->follower_snapshot_scans->Increment();
+  }
+  return Status::OK();
+}
+
+Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
+                                               const RpcContext* rpc_context,
+                                               const Schema& projection,
+                                               TabletPeer* tablet_peer,
+                                               const shared_ptr<Tablet>& tablet,
+                                               gscoped_ptr<RowwiseIterator>* iter,
+                                               Timestamp* snap_timestamp) {
+
+  Timestamp propagated_timestamp(scan_pb.propagated_timestamp());
+  Timestamp requested_timestamp(scan_pb.snap_timestamp());
+  tablet::MvccSnapshot snap;
+  Timestamp tmp_snap_timestamp;
+  RETURN_NOT_OK(WaitForReadSnapshot(
+      scan_pb.has_propagated_timestamp() ? &propagated_timestamp : nullptr,
+      scan_pb.has_snap_timestamp() ? &requested_timestamp : nullptr,
+      rpc_context, tablet_peer, tablet, &snap, &tmp_snap_timestamp));
 
   tablet::Tablet::OrderMode order;
   switch (scan_pb.order_mode()) {
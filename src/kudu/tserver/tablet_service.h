@@ -33,6 +33,7 @@ class Status;
 class Timestamp;
 
 namespace tablet {
+class MvccSnapshot;
 class Tablet;
 class TabletPeer;
 class TransactionState;
@@ -55,6 +56,10 @@ class TabletServiceImpl : public TabletServerServiceIf {
   virtual void Write(const WriteRequestPB* req, WriteResponsePB* resp,
                    rpc::RpcContext* context) OVERRIDE;
 
+  virtual void BulkIngest(const BulkIngestRequestPB* req,
+                          BulkIngestResponsePB* resp,
+                          rpc::RpcContext* context) OVERRIDE;
+
   virtual void Scan(const ScanRequestPB* req,
                     ScanResponsePB* resp,
                     rpc::RpcContext* context) OVERRIDE;
@@ -63,6 +68,10 @@ class TabletServiceImpl : public TabletServerServiceIf {
                                 ScannerKeepAliveResponsePB *resp,
                                 rpc::RpcContext *context) OVERRIDE;
 
+  virtual void MultiGet(const MultiGetRequestPB* req,
+                        MultiGetResponsePB* resp,
+                        rpc::RpcContext* context) OVERRIDE;
+
   virtual void ListTablets(const ListTabletsRequestPB* req,
                            ListTabletsResponsePB* resp,
                            rpc::RpcContext* context) OVERRIDE;
@@ -86,17 +95,38 @@ class TabletServiceImpl : public TabletServerServiceIf {
                               TabletServerErrorPB::Code* error_code);
 
   Status HandleContinueScanRequest(const ScanRequestPB* req,
+                                   const rpc::RpcContext* rpc_context,
                                    ScanResultCollector* result_collector,
                                    bool* has_more_results,
                                    TabletServerErrorPB::Code* error_code);
 
+  // Choose the timestamp of a READ_AT_SNAPSHOT read and wait until all
+  // operations below it have committed, so that the read is repeatable.
+  // 'propagated_timestamp' and 'requested_timestamp' are NULL if the client
+  // did not provide them.
+  Status WaitForReadSnapshot(const Timestamp* propagated_timestamp,
+                             const Timestamp* requested_timestamp,
+                             const rpc::RpcContext* rpc_context,
+                             tablet::TabletPeer* tablet_peer,
+                             const std::shared_ptr<tablet::Tablet>& tablet,
+                             tablet::MvccSnapshot* snap,
+                             Timestamp* snap_timestamp);
+
   Status HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
                               const rpc::RpcContext* rpc_context,
                               const Schema& projection,
+                              tablet::TabletPeer* tablet_peer,
                               const std::shared_ptr<tablet::Tablet>& tablet,
                               gscoped_ptr<RowwiseIterator>* iter,
                               Timestamp* snap_timestamp);
 
+  // Submit an admitted write to 'tablet_peer'. Called from Write(), or from a
+  // reactor thread once a write queued by the admission controller is due.
+  void SubmitWrite(const scoped_refptr<tablet::TabletPeer>& tablet_peer,
+                   const WriteRequestPB* req,
+                   WriteResponsePB* resp,
+                   rpc::RpcContext* context);
+
   TabletServer* server_;
 };
 
@@ -79,6 +79,7 @@ class TsTabletManagerTest : public KuduTest {
     RETURN_NOT_OK(tablet_manager_->CreateNewTablet(tablet_id, tablet_id, partition.second,
                                                    tablet_id,
                                                    full_schema, partition.first,
+                                                   RowTtlPB(),
                                                    config_,
                                                    &tablet_peer));
     if (out_tablet_peer) {
@@ -109,14 +109,14 @@ METRIC_DEFINE_histogram(server, op_apply_queue_time, "Operation Apply Queue Time
                         "Time that operations spent waiting in the apply queue before being "
                         "processed. High queue times indicate that the server is unable to "
                         "process operations as fast as they are being written to the WAL.",
-                        10000000, 2);
+                        10000000, 2, kudu::STRIPED_HISTOGRAM);
 
 METRIC_DEFINE_histogram(server, op_apply_run_time, "Operation Apply Run Time",
                         MetricUnit::kMicroseconds,
                         "Time that operations spent being applied to the tablet. "
                         "High values may indicate that the server is under-provisioned or "
                         "that operations consist of very large batches.",
-                        10000000, 2);
+                        10000000, 2, kudu::STRIPED_HISTOGRAM);
 
 using consensus::ConsensusMetadata;
 using consensus::ConsensusStatePB;
@@ -247,6 +247,7 @@ Status TSTabletManager::CreateNewTablet(const string& table_id,
                                         const string& table_name,
                                         const Schema& schema,
                                         const PartitionSchema& partition_schema,
+                                        const RowTtlPB& row_ttl,
                                         RaftConfigPB config,
                                         scoped_refptr<TabletPeer>* tablet_peer) {
   CHECK_EQ(state(), MANAGER_RUNNING);
@@ -291,6 +292,10 @@ Status TSTabletManager::CreateNewTablet(const string& table_id,
                               TABLET_DATA_READY,
                               &meta),
     "Couldn't create tablet metadata");
+  if (row_ttl.ttl_secs() > 0) {
+    meta->SetRowTtl(row_ttl);
+    RETURN_NOT_OK_PREPEND(meta->Flush(), "Couldn't flush tablet metadata");
+  }
 
   // We must persist the consensus metadata to disk before starting a new
   // tablet's TabletPeer and Consensus implementation.
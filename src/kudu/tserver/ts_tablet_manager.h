@@ -100,6 +100,9 @@ class TSTabletManager : public tserver::TabletPeerLookupIf {
   // Create a new tablet and register it with the tablet manager. The new tablet
   // is persisted on disk and opened before this method returns.
   //
+  // 'row_ttl' is the time-to-live of the table's rows, with 'ttl_secs' 0 if
+  // the table has none.
+  //
   // If tablet_peer is non-NULL, the newly created tablet will be returned.
   //
   // If another tablet already exists with this ID, logs a DFATAL
@@ -110,6 +113,7 @@ class TSTabletManager : public tserver::TabletPeerLookupIf {
                          const std::string& table_name,
                          const Schema& schema,
                          const PartitionSchema& partition_schema,
+                         const RowTtlPB& row_ttl,
                          consensus::RaftConfigPB config,
                          scoped_refptr<tablet::TabletPeer>* tablet_peer);
 
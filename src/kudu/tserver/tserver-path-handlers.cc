@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 
+#include "kudu/cfile/block_cache_warmer.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/consensus/quorum_util.h"
@@ -41,6 +42,7 @@
 #include "kudu/tserver/ts_tablet_manager.h"
 #include "kudu/util/url-coding.h"
 
+using kudu::cfile::BlockCacheWarmer;
 using kudu::consensus::GetConsensusRole;
 using kudu::consensus::CONSENSUS_CONFIG_COMMITTED;
 using kudu::consensus::ConsensusStatePB;
@@ -101,6 +103,10 @@ Status TabletServerPathHandlers::Register(Webserver* server) {
     "/maintenance-manager", "",
     boost::bind(&TabletServerPathHandlers::HandleMaintenanceManagerPage, this, _1, _2),
     true /* styled */, false /* is_on_nav_bar */);
+  server->RegisterPathHandler(
+    "/block-cache-warmup", "",
+    boost::bind(&TabletServerPathHandlers::HandleBlockCacheWarmupPage, this, _1, _2),
+    true /* styled */, false /* is_on_nav_bar */);
 
   return Status::OK();
 }
@@ -503,6 +509,9 @@ void TabletServerPathHandlers::HandleDashboardsPage(const Webserver::WebRequest&
   *output << GetDashboardLine("maintenance-manager", "Maintenance Manager",
                               "List of operations that are currently running and those "
                               "that are registered.");
+  *output << GetDashboardLine("block-cache-warmup", "Block Cache Warm-up",
+                              "Progress of reading the blocks which were cached before the "
+                              "last restart back into the block cache.");
 }
 
 string TabletServerPathHandlers::GetDashboardLine(const std::string& link,
@@ -572,5 +581,34 @@ void TabletServerPathHandlers::HandleMaintenanceManagerPage(const Webserver::Web
   *output << "</table>\n";
 }
 
+void TabletServerPathHandlers::HandleBlockCacheWarmupPage(const Webserver::WebRequest& req,
+                                                          std::stringstream* output) {
+  *output << "<h1>Block Cache Warm-up</h1>\n";
+  BlockCacheWarmer* warmer = tserver_->block_cache_warmer();
+  if (warmer == nullptr) {
+    *output << "<p>Block cache warm-up is disabled.</p>\n";
+    return;
+  }
+  BlockCacheWarmer::Progress progress = warmer->GetProgress();
+  *output << "<table class='table table-striped'>\n";
+  *output << Substitute("  <tr><td>State</td><td>$0</td></tr>\n",
+                        BlockCacheWarmer::StateToString(progress.state));
+  if (progress.state != BlockCacheWarmer::NOT_STARTED) {
+    int64_t blocks_done = progress.blocks_warmed + progress.blocks_skipped;
+    *output << Substitute("  <tr><td>Blocks</td><td>$0 / $1 ($2%)</td></tr>\n",
+                          blocks_done, progress.blocks_total,
+                          progress.blocks_total == 0 ? 100 :
+                              blocks_done * 100 / progress.blocks_total);
+    *output << Substitute("  <tr><td>Blocks skipped</td><td>$0</td></tr>\n",
+                          progress.blocks_skipped);
+    *output << Substitute("  <tr><td>Bytes read</td><td>$0</td></tr>\n",
+                          HumanReadableNumBytes::ToString(progress.bytes_read));
+    *output << Substitute("  <tr><td>Elapsed</td><td>$0</td></tr>\n",
+                          HumanReadableElapsedTime::ToShortString(
+                              progress.elapsed.ToSeconds()));
+  }
+  *output << "</table>\n";
+}
+
 } // namespace tserver
 } // namespace kudu
@@ -0,0 +1,181 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/write_admission_controller.h"
+
+#include <gtest/gtest.h>
+
+#include "kudu/util/monotime.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_int32(write_admission_max_queue_ms);
+DECLARE_int32(write_admission_min_rate_mb);
+
+namespace kudu {
+namespace tserver {
+
+static const int64_t kMB = 1024 * 1024;
+
+class WriteAdmissionControllerTest : public KuduTest {
+ public:
+  WriteAdmissionControllerTest()
+    : controller_(nullptr, nullptr) {
+  }
+
+ protected:
+  // Signals of a server with a 1000MB memory limit and a 600MB soft limit,
+  // which has flushed 'flushed_mb' MB so far.
+  static WriteAdmissionController::Signals MakeSignals(int64_t consumption_mb,
+                                                       int64_t flushed_mb) {
+    WriteAdmissionController::Signals signals;
+    signals.buffered_bytes = 0;
+    signals.flushed_bytes = flushed_mb * kMB;
+    signals.memory_consumption = consumption_mb * kMB;
+    signals.memory_soft_limit = 600 * kMB;
+    signals.memory_limit = 1000 * kMB;
+    signals.wal_backlog_bytes = 0;
+    signals.wal_backlog_limit = 100 * kMB;
+    return signals;
+  }
+
+  WriteAdmissionController controller_;
+};
+
+TEST_F(WriteAdmissionControllerTest, TestNotPacedWithoutPressure) {
+  MonoTime now = MonoTime::Now(MonoTime::FINE);
+  controller_.Update(MakeSignals(100, 0), now);
+  ASSERT_EQ(-1, controller_.admitted_bytes_per_sec());
+
+  MonoDelta delay;
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(WriteAdmissionController::ADMIT,
+              controller_.Admit("tablet", 10 * kMB, now, &delay));
+    ASSERT_EQ(0, delay.ToMicroseconds());
+  }
+}
+
+TEST_F(WriteAdmissionControllerTest, TestPacing) {
+  FLAGS_write_admission_min_rate_mb = 1;
+  FLAGS_write_admission_max_queue_ms = 1000;
+
+  // Take in 10MB/sec while flushing as much, without pressure.
+  MonoTime now = MonoTime::Now(MonoTime::FINE);
+  controller_.Update(MakeSignals(100, 0), now);
+  MonoDelta delay;
+  ASSERT_EQ(WriteAdmissionController::ADMIT,
+            controller_.Admit("tablet-a", 10 * kMB, now, &delay));
+  now.AddDelta(MonoDelta::FromSeconds(1));
+
+  // Once the memory consumption nears the soft limit, pacing starts at the
+  // smoothed incoming rate.
+  controller_.Update(MakeSignals(600, 10), now);
+  int64_t rate = controller_.admitted_bytes_per_sec();
+  ASSERT_NEAR(3 * kMB, rate, kMB / 10);
+
+  // The first write of a tablet goes through, but the next ones are queued
+  // for as long as the previous ones take at the admitted rate.
+  ASSERT_EQ(WriteAdmissionController::ADMIT,
+            controller_.Admit("tablet-a", kMB, now, &delay));
+  ASSERT_EQ(0, delay.ToMicroseconds());
+  ASSERT_EQ(WriteAdmissionController::ADMIT,
+            controller_.Admit("tablet-a", kMB, now, &delay));
+  ASSERT_NEAR(kMB * 1000000.0 / rate, delay.ToMicroseconds(), 1000);
+  ASSERT_EQ(WriteAdmissionController::ADMIT,
+            controller_.Admit("tablet-a", 2 * kMB, now, &delay));
+
+  // Writes which would be queued for too long are rejected, with a hint to
+  // retry once the queue has drained.
+  ASSERT_EQ(WriteAdmissionController::REJECT,
+            controller_.Admit("tablet-a", kMB, now, &delay));
+  ASSERT_GT(delay.ToMilliseconds(), FLAGS_write_admission_max_queue_ms);
+
+  // Other tablets have their own queue.
+  ASSERT_EQ(WriteAdmissionController::ADMIT,
+            controller_.Admit("tablet-b", kMB, now, &delay));
+  ASSERT_EQ(0, delay.ToMicroseconds());
+
+  // As the pressure rises without any flush, the admitted rate goes down to
+  // the minimum.
+  for (int i = 0; i < 100; i++) {
+    now.AddDelta(MonoDelta::FromMilliseconds(100));
+    controller_.Update(MakeSignals(900, 10), now);
+    int64_t new_rate = controller_.admitted_bytes_per_sec();
+    ASSERT_LE(new_rate, rate);
+    rate = new_rate;
+  }
+  ASSERT_EQ(kMB, rate);
+
+  // The pacing stops once the pressure is relieved.
+  now.AddDelta(MonoDelta::FromMilliseconds(100));
+  controller_.Update(MakeSignals(100, 500), now);
+  ASSERT_EQ(-1, controller_.admitted_bytes_per_sec());
+  ASSERT_EQ(WriteAdmissionController::ADMIT,
+            controller_.Admit("tablet-a", 10 * kMB, now, &delay));
+  ASSERT_EQ(0, delay.ToMicroseconds());
+}
+
+TEST_F(WriteAdmissionControllerTest, TestWalBacklogPressure) {
+  MonoTime now = MonoTime::Now(MonoTime::FINE);
+  WriteAdmissionController::Signals signals = MakeSignals(100, 0);
+  signals.wal_backlog_bytes = 80 * kMB;
+  controller_.Update(signals, now);
+  ASSERT_GT(controller_.admitted_bytes_per_sec(), 0);
+  ASSERT_FALSE(controller_.overloaded());
+
+  // A full log cache rejects every write, like the hard memory limit.
+  now.AddDelta(MonoDelta::FromMilliseconds(100));
+  signals.wal_backlog_bytes = 100 * kMB;
+  controller_.Update(signals, now);
+  ASSERT_TRUE(controller_.overloaded());
+  MonoDelta delay;
+  ASSERT_EQ(WriteAdmissionController::REJECT,
+            controller_.Admit("tablet", 1, now, &delay));
+}
+
+// Test that pacing, which never admits less than the minimum rate, gives way
+// to rejecting every write once the hard memory limit is reached.
+TEST_F(WriteAdmissionControllerTest, TestRejectsAtHardLimit) {
+  FLAGS_write_admission_max_queue_ms = 1000;
+  MonoTime now = MonoTime::Now(MonoTime::FINE);
+  controller_.Update(MakeSignals(900, 0), now);
+  ASSERT_FALSE(controller_.overloaded());
+  MonoDelta delay;
+  ASSERT_EQ(WriteAdmissionController::ADMIT,
+            controller_.Admit("tablet", 1, now, &delay));
+
+  for (int consumption_mb : { 1000, 1200 }) {
+    now.AddDelta(MonoDelta::FromMilliseconds(100));
+    controller_.Update(MakeSignals(consumption_mb, 0), now);
+    ASSERT_TRUE(controller_.overloaded());
+    ASSERT_GT(controller_.admitted_bytes_per_sec(), 0);
+    for (const char* tablet : { "tablet", "other-tablet" }) {
+      ASSERT_EQ(WriteAdmissionController::REJECT,
+                controller_.Admit(tablet, 1, now, &delay));
+      ASSERT_EQ(FLAGS_write_admission_max_queue_ms, delay.ToMilliseconds());
+    }
+  }
+
+  // Writes are admitted again, though still paced, once below the limit.
+  now.AddDelta(MonoDelta::FromMilliseconds(100));
+  controller_.Update(MakeSignals(950, 0), now);
+  ASSERT_FALSE(controller_.overloaded());
+  ASSERT_EQ(WriteAdmissionController::ADMIT,
+            controller_.Admit("other-tablet", 1, now, &delay));
+}
+
+} // namespace tserver
+} // namespace kudu
@@ -0,0 +1,359 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/write_admission_controller.h"
+
+#include <algorithm>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <memory>
+#include <vector>
+
+#include "kudu/gutil/bind.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet_metrics.h"
+#include "kudu/tablet/tablet_peer.h"
+#include "kudu/tserver/ts_tablet_manager.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/mem_tracker.h"
+#include "kudu/util/thread.h"
+
+DEFINE_bool(write_admission_control_enabled, true,
+            "Whether to pace writes when the tablet server nears its memory limit "
+            "or its WAL backlog grows, instead of rejecting them outright once the "
+            "soft memory limit is exceeded.");
+TAG_FLAG(write_admission_control_enabled, advanced);
+TAG_FLAG(write_admission_control_enabled, runtime);
+
+DEFINE_int32(write_admission_update_interval_ms, 100,
+             "Interval at which the write admission controller samples memory usage, "
+             "flush throughput and WAL backlog to recompute the admitted write rate.");
+TAG_FLAG(write_admission_update_interval_ms, advanced);
+
+DEFINE_int32(write_admission_pacing_start_pct, 90,
+             "Percentage of the soft memory limit at which writes start being paced.");
+TAG_FLAG(write_admission_pacing_start_pct, advanced);
+TAG_FLAG(write_admission_pacing_start_pct, runtime);
+
+DEFINE_int32(write_admission_wal_backlog_start_pct, 50,
+             "Percentage of the log cache limit at which writes start being paced.");
+TAG_FLAG(write_admission_wal_backlog_start_pct, advanced);
+TAG_FLAG(write_admission_wal_backlog_start_pct, runtime);
+
+DEFINE_int32(write_admission_min_rate_mb, 1,
+             "Minimum rate, in MB per second, at which writes are admitted while they "
+             "are paced, so that writes keep making progress.");
+TAG_FLAG(write_admission_min_rate_mb, advanced);
+TAG_FLAG(write_admission_min_rate_mb, runtime);
+
+DEFINE_int32(write_admission_max_queue_ms, 1000,
+             "Maximum time a paced write is queued before it is applied. Writes which "
+             "would be queued for longer are rejected, with a hint of when to retry.");
+TAG_FLAG(write_admission_max_queue_ms, advanced);
+TAG_FLAG(write_admission_max_queue_ms, runtime);
+
+METRIC_DEFINE_gauge_int64(server, write_admission_rate,
+                          "Write Admission Rate",
+                          kudu::MetricUnit::kBytes,
+                          "Rate, in bytes per second, at which writes are admitted while "
+                          "the tablet server is under memory or WAL pressure, or -1 if "
+                          "writes are not being paced.");
+
+METRIC_DEFINE_counter(server, write_admission_queued_writes,
+                      "Queued Writes",
+                      kudu::MetricUnit::kRequests,
+                      "Number of writes which were queued before being applied, because "
+                      "their tablet exceeded its share of the admitted write rate.");
+
+METRIC_DEFINE_counter(server, write_admission_rejected_writes,
+                      "Rejected Writes",
+                      kudu::MetricUnit::kRequests,
+                      "Number of writes which were rejected because they would have been "
+                      "queued for longer than --write_admission_max_queue_ms, or because "
+                      "the tablet server had reached its memory or log cache limit.");
+
+METRIC_DEFINE_histogram(server, write_admission_queue_time,
+                        "Write Queue Time",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Time writes were queued before being applied, because their "
+                        "tablet exceeded its share of the admitted write rate.",
+                        60000000LU, 2);
+
+using kudu::tablet::Tablet;
+using kudu::tablet::TabletPeer;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tserver {
+
+namespace {
+
+// Weight of the latest sample in the smoothed rates.
+const double kRateSmoothing = 0.3;
+
+// Tablets which received writes within this window share the admitted rate.
+const MonoDelta kActiveTabletWindow = MonoDelta::FromSeconds(1);
+
+// Tablets which received no writes within this window are forgotten.
+const MonoDelta kForgetTabletAfter = MonoDelta::FromSeconds(10);
+
+} // anonymous namespace
+
+WriteAdmissionController::WriteAdmissionController(
+    TSTabletManager* tablet_manager,
+    const scoped_refptr<MetricEntity>& metric_entity)
+  : tablet_manager_(tablet_manager),
+    admitted_bytes_(0),
+    admitted_bytes_per_sec_(-1),
+    overloaded_(false),
+    num_active_tablets_(0),
+    has_last_signals_(false),
+    last_admitted_bytes_(0),
+    flush_bytes_per_sec_(0),
+    incoming_bytes_per_sec_(0),
+    shutdown_cv_(&shutdown_lock_),
+    shutdown_(false) {
+  if (metric_entity) {
+    queued_writes_ = METRIC_write_admission_queued_writes.Instantiate(metric_entity);
+    rejected_writes_ = METRIC_write_admission_rejected_writes.Instantiate(metric_entity);
+    queue_time_ = METRIC_write_admission_queue_time.Instantiate(metric_entity);
+    METRIC_write_admission_rate.InstantiateFunctionGauge(
+        metric_entity, Bind(&WriteAdmissionController::admitted_bytes_per_sec,
+                            Unretained(this)))
+      ->AutoDetach(&metric_detacher_);
+  }
+}
+
+WriteAdmissionController::~WriteAdmissionController() {
+  Shutdown();
+}
+
+Status WriteAdmissionController::Start() {
+  return Thread::Create("tserver", "write-admission", &WriteAdmissionController::RunThread,
+                        this, &thread_);
+}
+
+void WriteAdmissionController::Shutdown() {
+  {
+    MutexLock l(shutdown_lock_);
+    if (shutdown_) {
+      return;
+    }
+    shutdown_ = true;
+    shutdown_cv_.Broadcast();
+  }
+  if (thread_) {
+    CHECK_OK(ThreadJoiner(thread_.get()).Join());
+  }
+}
+
+void WriteAdmissionController::RunThread() {
+  while (true) {
+    {
+      MutexLock l(shutdown_lock_);
+      if (shutdown_) {
+        return;
+      }
+      shutdown_cv_.TimedWait(
+          MonoDelta::FromMilliseconds(FLAGS_write_admission_update_interval_ms));
+    }
+    Signals signals;
+    SampleSignals(&signals);
+    Update(signals, MonoTime::Now(MonoTime::FINE));
+  }
+}
+
+void WriteAdmissionController::SampleSignals(Signals* signals) {
+  signals->buffered_bytes = 0;
+  signals->flushed_bytes = 0;
+  vector<scoped_refptr<TabletPeer> > peers;
+  tablet_manager_->GetTabletPeers(&peers);
+  for (const scoped_refptr<TabletPeer>& peer : peers) {
+    shared_ptr<Tablet> tablet = peer->shared_tablet();
+    if (!tablet) {
+      continue;
+    }
+    signals->buffered_bytes += tablet->MemRowSetSize() + tablet->DeltaMemStoresSize();
+    if (tablet->metrics()) {
+      signals->flushed_bytes += tablet->metrics()->bytes_flushed->value();
+    }
+  }
+
+  shared_ptr<MemTracker> root = MemTracker::GetRootTracker();
+  signals->memory_consumption = root->consumption();
+  signals->memory_soft_limit = root->soft_limit();
+  signals->memory_limit = root->limit();
+
+  // The log cache holds the WAL entries which aren't yet replicated to all
+  // peers. It only exists once a tablet has been opened.
+  shared_ptr<MemTracker> log_cache;
+  if (MemTracker::FindTracker("log_cache", &log_cache, root)) {
+    signals->wal_backlog_bytes = log_cache->consumption();
+    signals->wal_backlog_limit = log_cache->limit();
+  } else {
+    signals->wal_backlog_bytes = 0;
+    signals->wal_backlog_limit = -1;
+  }
+}
+
+double WriteAdmissionController::ComputePressure(const Signals& signals) {
+  double pressure = -1;
+  if (signals.memory_soft_limit > 0 && signals.memory_limit > 0) {
+    double start = signals.memory_soft_limit * FLAGS_write_admission_pacing_start_pct / 100.0;
+    if (signals.memory_consumption >= start) {
+      pressure = (signals.memory_consumption - start) /
+          std::max(1.0, signals.memory_limit - start);
+    }
+  }
+  if (signals.wal_backlog_limit > 0) {
+    double start = signals.wal_backlog_limit * FLAGS_write_admission_wal_backlog_start_pct / 100.0;
+    if (signals.wal_backlog_bytes >= start) {
+      pressure = std::max(pressure, (signals.wal_backlog_bytes - start) /
+                          std::max(1.0, signals.wal_backlog_limit - start));
+    }
+  }
+  return std::min(pressure, 1.0);
+}
+
+void WriteAdmissionController::Update(const Signals& signals, const MonoTime& now) {
+  int64_t admitted_bytes = admitted_bytes_.Load();
+  lock_guard<simple_spinlock> l(&lock_);
+
+  if (has_last_signals_) {
+    double secs = now.GetDeltaSince(last_update_).ToSeconds();
+    if (secs > 0) {
+      // The buffered data is drained by flushes, which both write bytes out
+      // and release the memory they were buffered in. The flushed total may
+      // also go backwards when tablets are deleted.
+      double drained = std::max<int64_t>(
+          0, std::max(signals.flushed_bytes - last_signals_.flushed_bytes,
+                      last_signals_.buffered_bytes - signals.buffered_bytes));
+      flush_bytes_per_sec_ = kRateSmoothing * drained / secs +
+          (1 - kRateSmoothing) * flush_bytes_per_sec_;
+      incoming_bytes_per_sec_ = kRateSmoothing * (admitted_bytes - last_admitted_bytes_) / secs +
+          (1 - kRateSmoothing) * incoming_bytes_per_sec_;
+    }
+  }
+  has_last_signals_ = true;
+  last_signals_ = signals;
+  last_update_ = now;
+  last_admitted_bytes_ = admitted_bytes;
+
+  num_active_tablets_ = 0;
+  for (auto it = tablets_.begin(); it != tablets_.end();) {
+    MonoDelta idle = now.GetDeltaSince(it->second.last_write);
+    if (idle.MoreThan(kForgetTabletAfter)) {
+      it = tablets_.erase(it);
+      continue;
+    }
+    if (!idle.MoreThan(kActiveTabletWindow)) {
+      num_active_tablets_++;
+    }
+    ++it;
+  }
+
+  double pressure = ComputePressure(signals);
+  bool overloaded = pressure >= 1;
+  if (overloaded != overloaded_.Load()) {
+    LOG(INFO) << (overloaded ? "Rejecting all writes" : "Stopped rejecting all writes")
+              << Substitute(": memory consumption $0 (limit $1), WAL backlog $2 (limit $3)",
+                            signals.memory_consumption, signals.memory_limit,
+                            signals.wal_backlog_bytes, signals.wal_backlog_limit);
+    overloaded_.Store(overloaded);
+  }
+  int64_t old_rate = admitted_bytes_per_sec_.Load();
+  if (pressure < 0) {
+    if (old_rate >= 0) {
+      LOG(INFO) << "Stopped pacing writes";
+      tablets_.clear();
+      admitted_bytes_per_sec_.Store(-1);
+    }
+    return;
+  }
+
+  // Admit up to 1.5x the flush throughput as pacing starts, going down to a
+  // quarter of it at the hard limit, so that the buffered data drains.
+  double min_rate = FLAGS_write_admission_min_rate_mb * 1024.0 * 1024.0;
+  double target = flush_bytes_per_sec_ * (1.5 - 1.25 * pressure);
+  double rate;
+  if (old_rate < 0) {
+    // Start from the rate at which writes came in, so that they don't get
+    // throttled abruptly.
+    rate = incoming_bytes_per_sec_;
+    LOG(INFO) << Substitute("Started pacing writes at $0 bytes/sec: memory consumption $1 "
+                            "(soft limit $2), MemRowSets and DeltaMemStores $3, WAL "
+                            "backlog $4, flushing $5 bytes/sec",
+                            static_cast<int64_t>(std::max(min_rate, rate)),
+                            signals.memory_consumption, signals.memory_soft_limit,
+                            signals.buffered_bytes, signals.wal_backlog_bytes,
+                            static_cast<int64_t>(flush_bytes_per_sec_));
+  } else {
+    rate = old_rate + kRateSmoothing * (target - old_rate);
+  }
+  admitted_bytes_per_sec_.Store(static_cast<int64_t>(std::max(min_rate, rate)));
+}
+
+WriteAdmissionController::Decision WriteAdmissionController::Admit(const string& tablet_id,
+                                                                   int64_t bytes,
+                                                                   const MonoTime& now,
+                                                                   MonoDelta* delay) {
+  if (PREDICT_FALSE(overloaded_.Load())) {
+    // Whatever the rate, nothing may be admitted until flushes or
+    // replication have made room again.
+    if (rejected_writes_) rejected_writes_->Increment();
+    *delay = MonoDelta::FromMilliseconds(FLAGS_write_admission_max_queue_ms);
+    return REJECT;
+  }
+
+  int64_t rate = admitted_bytes_per_sec_.Load();
+  if (rate < 0) {
+    admitted_bytes_.IncrementBy(bytes);
+    *delay = MonoDelta::FromMicroseconds(0);
+    return ADMIT;
+  }
+
+  lock_guard<simple_spinlock> l(&lock_);
+  TabletState* state = &tablets_[tablet_id];
+  state->last_write = now;
+  if (!state->next_free.Initialized() || state->next_free.ComesBefore(now)) {
+    state->next_free = now;
+  }
+  MonoDelta wait = state->next_free.GetDeltaSince(now);
+  if (wait.MoreThan(MonoDelta::FromMilliseconds(FLAGS_write_admission_max_queue_ms))) {
+    // Retrying once the tablet's queue has drained gets the write through.
+    if (rejected_writes_) rejected_writes_->Increment();
+    *delay = wait;
+    return REJECT;
+  }
+
+  double share = static_cast<double>(rate) / std::max(1, num_active_tablets_);
+  state->next_free.AddDelta(MonoDelta::FromMicroseconds(bytes * 1000000.0 / share));
+  admitted_bytes_.IncrementBy(bytes);
+  if (wait.ToMicroseconds() > 0) {
+    if (queued_writes_) queued_writes_->Increment();
+    if (queue_time_) queue_time_->Increment(wait.ToMicroseconds());
+  }
+  *delay = wait;
+  return ADMIT;
+}
+
+} // namespace tserver
+} // namespace kudu
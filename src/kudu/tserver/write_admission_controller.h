@@ -0,0 +1,197 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_TSERVER_WRITE_ADMISSION_CONTROLLER_H
+#define KUDU_TSERVER_WRITE_ADMISSION_CONTROLLER_H
+
+#include <string>
+#include <unordered_map>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/atomic.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Thread;
+
+namespace tserver {
+
+class TSTabletManager;
+
+// Paces the writes to the tablets of a tablet server when it comes under
+// memory or WAL pressure.
+//
+// Rather than rejecting writes once the soft memory limit is exceeded, the
+// controller periodically samples the memory buffered in MemRowSets and
+// DeltaMemStores, the rate at which it is flushed to disk, and the backlog of
+// WAL entries in the log cache. Once the server's memory consumption nears
+// the soft limit (or the log cache fills up), writes are admitted at a rate
+// derived from the flush throughput: a little above it while the pressure is
+// low, and well below it as the hard limit gets closer, so that the buffered
+// data can drain. The admitted rate moves gradually, so that write
+// throughput degrades smoothly rather than oscillating.
+//
+// Each tablet which is being written to gets an equal share of the admitted
+// rate. A write which exceeds its tablet's share is queued for as long as the
+// tablet's previous writes take to go through at that share, up to
+// --write_admission_max_queue_ms, beyond which it is rejected with a hint of
+// when to retry.
+//
+// Pacing keeps admitting at least --write_admission_min_rate_mb, so once the
+// hard memory limit or the log cache limit is reached, all writes are
+// rejected until the pressure eases.
+class WriteAdmissionController {
+ public:
+  // The signals which the admitted rate is derived from.
+  struct Signals {
+    // Memory used by the MemRowSets and DeltaMemStores of all tablets.
+    int64_t buffered_bytes;
+
+    // Total number of bytes written by flushes and compactions of all
+    // tablets. Only its changes between samples matter.
+    int64_t flushed_bytes;
+
+    // Memory consumption of the server, and its soft and hard limits. The
+    // limits are -1 if there are none.
+    int64_t memory_consumption;
+    int64_t memory_soft_limit;
+    int64_t memory_limit;
+
+    // Size of the WAL entries held in the log cache until they are
+    // replicated to all peers, and its limit (-1 if none).
+    int64_t wal_backlog_bytes;
+    int64_t wal_backlog_limit;
+  };
+
+  enum Decision {
+    // The write may proceed, possibly after a delay.
+    ADMIT,
+
+    // The write should be retried later.
+    REJECT
+  };
+
+  // 'tablet_manager' is used to sample the signals, and may be NULL if the
+  // controller is not started.
+  WriteAdmissionController(TSTabletManager* tablet_manager,
+                           const scoped_refptr<MetricEntity>& metric_entity);
+  ~WriteAdmissionController();
+
+  // Starts the thread which periodically samples the signals.
+  Status Start();
+
+  void Shutdown();
+
+  // Decide whether a write of 'bytes' bytes to 'tablet_id', received at
+  // 'now', may proceed.
+  //
+  // If the write is admitted, sets 'delay' to how long it must be queued
+  // before it proceeds (zero if it may proceed immediately). If it is
+  // rejected, sets 'delay' to how long the caller should wait before
+  // retrying.
+  Decision Admit(const std::string& tablet_id, int64_t bytes, const MonoTime& now,
+                 MonoDelta* delay);
+
+  // Recompute the admitted rate from 'signals', sampled at 'now'. Called
+  // periodically by the sampling thread, and directly by tests.
+  void Update(const Signals& signals, const MonoTime& now);
+
+  // The rate at which writes are admitted, in bytes per second, or -1 if
+  // writes aren't being paced.
+  int64_t admitted_bytes_per_sec() const {
+    return admitted_bytes_per_sec_.Load();
+  }
+
+  // Whether the hard memory limit or the log cache limit was reached as of
+  // the last Update(), in which case all writes are rejected.
+  bool overloaded() const {
+    return overloaded_.Load();
+  }
+
+ private:
+  struct TabletState {
+    // When the writes admitted so far will have gone through at the
+    // tablet's share of the admitted rate.
+    MonoTime next_free;
+
+    // When the tablet last received a write.
+    MonoTime last_write;
+  };
+
+  void RunThread();
+
+  void SampleSignals(Signals* signals);
+
+  // Returns a value between 0 (pacing starts) and 1 (hard limit reached, or
+  // exceeded) describing how close the server is to running out of memory
+  // or WAL backlog space, or a negative value if writes need not be paced.
+  static double ComputePressure(const Signals& signals);
+
+  TSTabletManager* const tablet_manager_;
+
+  // Total number of bytes admitted, used to seed the admitted rate with the
+  // incoming write rate when pacing starts.
+  AtomicInt<int64_t> admitted_bytes_;
+
+  AtomicInt<int64_t> admitted_bytes_per_sec_;
+
+  AtomicBool overloaded_;
+
+  scoped_refptr<Counter> queued_writes_;
+  scoped_refptr<Counter> rejected_writes_;
+  scoped_refptr<Histogram> queue_time_;
+  FunctionGaugeDetacher metric_detacher_;
+
+  // Protects the fields below.
+  simple_spinlock lock_;
+
+  std::unordered_map<std::string, TabletState> tablets_;
+
+  // Number of tablets which received writes recently, between which the
+  // admitted rate is shared.
+  int num_active_tablets_;
+
+  // State of the previous Update() call.
+  bool has_last_signals_;
+  Signals last_signals_;
+  MonoTime last_update_;
+  int64_t last_admitted_bytes_;
+
+  // Smoothed flush throughput and incoming write rate, in bytes per second.
+  double flush_bytes_per_sec_;
+  double incoming_bytes_per_sec_;
+
+  // Protects 'shutdown_'.
+  Mutex shutdown_lock_;
+  ConditionVariable shutdown_cv_;
+  bool shutdown_;
+
+  scoped_refptr<Thread> thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(WriteAdmissionController);
+};
+
+} // namespace tserver
+} // namespace kudu
+
+#endif
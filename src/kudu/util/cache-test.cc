@@ -6,6 +6,7 @@
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
 #include <memory>
+#include <set>
 
 #include <vector>
 #include "kudu/util/cache.h"
@@ -81,13 +82,14 @@ class CacheTest : public KuduTest,
     return r;
   }
 
-  void Insert(int key, int value, int charge = 1) {
+  void Insert(int key, int value, int charge = 1,
+              Cache::Priority priority = Cache::NORMAL_PRIORITY) {
     string key_str = EncodeInt(key);
     string val_str = EncodeInt(value);
     Cache::PendingHandle* handle = CHECK_NOTNULL(cache_->Allocate(key_str, val_str.size(), charge));
     memcpy(cache_->MutableValue(handle), val_str.data(), val_str.size());
 
-    cache_->Release(cache_->Insert(handle, this));
+    cache_->Release(cache_->Insert(handle, this, priority));
   }
 
   void Erase(int key) {
@@ -222,6 +224,81 @@ TEST_P(CacheTest, HeavyEntries) {
   ASSERT_LE(cached_weight, kCacheSize + kCacheSize/10);
 }
 
+// Test that high-priority entries are not evicted by a flood of normal-priority
+// entries while they fit in the high-priority pool, and that the pool's excess
+// is evicted like normal entries.
+TEST_P(CacheTest, HighPriorityPool) {
+  if (GetParam() != DRAM_CACHE) {
+    LOG(INFO) << "Only the DRAM cache supports priorities";
+    return;
+  }
+  cache_.reset(NewLRUCache(GetParam(), kCacheSize, "cache_test", 0.5));
+
+  // With 16 shards, each element is 1/320th of a shard's capacity. Insert
+  // enough high-priority entries to fill roughly a quarter of the cache.
+  const int kNumElems = 5000;
+  const int kSizePerElem = kCacheSize / kNumElems;
+  const int kNumHighPri = kNumElems / 4;
+  for (int i = 0; i < kNumHighPri; i++) {
+    Insert(i, 1000 + i, kSizePerElem, Cache::HIGH_PRIORITY);
+  }
+
+  // Scan-like load: each normal entry is inserted once and never used again.
+  for (int i = 0; i < 2 * kNumElems; i++) {
+    Insert(100000 + i, i, kSizePerElem);
+  }
+  for (int i = 0; i < kNumHighPri; i++) {
+    ASSERT_EQ(1000 + i, Lookup(i));
+  }
+
+  // Overflow the high-priority pool: the oldest high-priority entries are
+  // moved out of the pool and are evicted by the following normal entries.
+  for (int i = kNumHighPri; i < 3 * kNumHighPri; i++) {
+    Insert(i, 1000 + i, kSizePerElem, Cache::HIGH_PRIORITY);
+  }
+  for (int i = 0; i < 2 * kNumElems; i++) {
+    Insert(200000 + i, i, kSizePerElem);
+  }
+  int num_high_pri_cached = 0;
+  for (int i = 0; i < 3 * kNumHighPri; i++) {
+    if (Lookup(i) != -1) {
+      num_high_pri_cached++;
+    }
+  }
+  ASSERT_LE(num_high_pri_cached, kNumElems / 2 + kNumElems / 10);
+  ASSERT_GE(num_high_pri_cached, kNumElems / 2 - kNumElems / 10);
+  ASSERT_EQ(-1, Lookup(0));
+  ASSERT_EQ(1000 + 3 * kNumHighPri - 1, Lookup(3 * kNumHighPri - 1));
+}
+
+TEST_P(CacheTest, RecentlyUsedEntries) {
+  const int kNumEntries = 100;
+  for (int i = 0; i < kNumEntries; i++) {
+    Insert(i, 1000 + i);
+  }
+  ASSERT_EQ(1042, Lookup(42));
+
+  std::vector<Cache::EntryInfo> entries;
+  cache_->GetRecentlyUsedEntries(kNumEntries * 2, &entries);
+  ASSERT_EQ(kNumEntries, entries.size());
+  std::set<int> keys;
+  for (const Cache::EntryInfo& entry : entries) {
+    ASSERT_EQ(4, entry.value_size);
+    keys.insert(DecodeInt(entry.key));
+  }
+  ASSERT_EQ(kNumEntries, keys.size());
+
+  // The most recently used entry of each shard comes first.
+  entries.clear();
+  cache_->GetRecentlyUsedEntries(16, &entries);
+  ASSERT_EQ(16, entries.size());
+  bool found = false;
+  for (const Cache::EntryInfo& entry : entries) {
+    found |= DecodeInt(entry.key) == 42;
+  }
+  ASSERT_TRUE(found);
+}
+
 TEST_P(CacheTest, NewId) {
   uint64_t a = cache_->NewId();
   uint64_t b = cache_->NewId();
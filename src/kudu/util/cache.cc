@@ -52,6 +52,9 @@ struct LRUHandle {
   uint32_t val_length;
   Atomic32 refs;
   uint32_t hash;      // Hash of key(); used for fast sharding and comparisons
+  Cache::Priority priority;
+  // Whether the entry is currently in the high-priority LRU list.
+  bool in_high_pri_pool;
 
   // The storage for the key/value pair itself. The data is stored as:
   //   [key bytes ...] [padding up to 8-byte boundary] [value bytes ...]
@@ -168,19 +171,31 @@ class LRUCache {
   ~LRUCache();
 
   // Separate from constructor so caller can easily make an array of LRUCache
-  void SetCapacity(size_t capacity) { capacity_ = capacity; }
+  void SetCapacity(size_t capacity, size_t high_pri_capacity) {
+    capacity_ = capacity;
+    high_pri_capacity_ = high_pri_capacity;
+  }
 
   void SetMetrics(CacheMetrics* metrics) { metrics_ = metrics; }
 
-  Cache::Handle* Insert(LRUHandle* handle, Cache::EvictionCallback* eviction_callback);
+  Cache::Handle* Insert(LRUHandle* handle, Cache::EvictionCallback* eviction_callback,
+                        Cache::Priority priority);
   // Like Cache::Lookup, but with an extra "hash" parameter.
   Cache::Handle* Lookup(const Slice& key, uint32_t hash, bool caching);
   void Release(Cache::Handle* handle);
   void Erase(const Slice& key, uint32_t hash);
+  void GetRecentlyUsedEntries(size_t max_entries, vector<Cache::EntryInfo>* entries);
 
  private:
   void LRU_Remove(LRUHandle* e);
+  // Append 'e' as the newest entry of the LRU list of its pool.
   void LRU_Append(LRUHandle* e);
+  // Set whether 'e', which must not be in an LRU list, belongs to the
+  // high-priority pool.
+  void SetInHighPriPool(LRUHandle* e, bool in_high_pri_pool);
+  // Move the oldest entries of the high-priority pool to the normal LRU list
+  // until the pool fits within its capacity.
+  void MaintainHighPriPoolSize();
   // Just reduce the reference count by 1.
   // Return true if last reference
   bool Unref(LRUHandle* e);
@@ -189,15 +204,21 @@ class LRUCache {
 
   // Initialized before use.
   size_t capacity_;
+  size_t high_pri_capacity_;
 
   // mutex_ protects the following state.
   MutexType mutex_;
   size_t usage_;
+  size_t high_pri_usage_;
 
   // Dummy head of LRU list.
   // lru.prev is newest entry, lru.next is oldest entry.
   LRUHandle lru_;
 
+  // Dummy head of the LRU list of the high-priority pool. Entries are evicted
+  // from here only if the normal list is empty.
+  LRUHandle high_pri_lru_;
+
   HandleTable table_;
 
   MemTracker* mem_tracker_;
@@ -206,22 +227,29 @@ class LRUCache {
 };
 
 LRUCache::LRUCache(MemTracker* tracker)
- : usage_(0),
+ : capacity_(0),
+   high_pri_capacity_(0),
+   usage_(0),
+   high_pri_usage_(0),
    mem_tracker_(tracker),
    metrics_(nullptr) {
-  // Make empty circular linked list
+  // Make empty circular linked lists
   lru_.next = &lru_;
   lru_.prev = &lru_;
+  high_pri_lru_.next = &high_pri_lru_;
+  high_pri_lru_.prev = &high_pri_lru_;
 }
 
 LRUCache::~LRUCache() {
-  for (LRUHandle* e = lru_.next; e != &lru_; ) {
-    LRUHandle* next = e->next;
-    DCHECK_EQ(e->refs, 1);  // Error if caller has an unreleased handle
-    if (Unref(e)) {
-      FreeEntry(e);
+  for (LRUHandle* list : { &lru_, &high_pri_lru_ }) {
+    for (LRUHandle* e = list->next; e != list; ) {
+      LRUHandle* next = e->next;
+      DCHECK_EQ(e->refs, 1);  // Error if caller has an unreleased handle
+      if (Unref(e)) {
+        FreeEntry(e);
+      }
+      e = next;
     }
-    e = next;
   }
 }
 
@@ -238,6 +266,11 @@ void LRUCache::FreeEntry(LRUHandle* e) {
   mem_tracker_->Release(e->charge);
   if (PREDICT_TRUE(metrics_)) {
     metrics_->cache_usage->DecrementBy(e->charge);
+    if (e->in_high_pri_pool) {
+      metrics_->cache_usage_high_priority->DecrementBy(e->charge);
+    } else {
+      metrics_->cache_usage_normal_priority->DecrementBy(e->charge);
+    }
     metrics_->evictions->Increment();
   }
   delete [] e;
@@ -247,15 +280,47 @@ void LRUCache::LRU_Remove(LRUHandle* e) {
   e->next->prev = e->prev;
   e->prev->next = e->next;
   usage_ -= e->charge;
+  if (e->in_high_pri_pool) {
+    high_pri_usage_ -= e->charge;
+  }
 }
 
 void LRUCache::LRU_Append(LRUHandle* e) {
-  // Make "e" newest entry by inserting just before lru_
-  e->next = &lru_;
-  e->prev = lru_.prev;
+  // Make "e" newest entry by inserting just before the list head
+  LRUHandle* list = e->in_high_pri_pool ? &high_pri_lru_ : &lru_;
+  e->next = list;
+  e->prev = list->prev;
   e->prev->next = e;
   e->next->prev = e;
   usage_ += e->charge;
+  if (e->in_high_pri_pool) {
+    high_pri_usage_ += e->charge;
+  }
+}
+
+void LRUCache::SetInHighPriPool(LRUHandle* e, bool in_high_pri_pool) {
+  if (e->in_high_pri_pool == in_high_pri_pool) {
+    return;
+  }
+  e->in_high_pri_pool = in_high_pri_pool;
+  if (PREDICT_TRUE(metrics_)) {
+    if (in_high_pri_pool) {
+      metrics_->cache_usage_normal_priority->DecrementBy(e->charge);
+      metrics_->cache_usage_high_priority->IncrementBy(e->charge);
+    } else {
+      metrics_->cache_usage_high_priority->DecrementBy(e->charge);
+      metrics_->cache_usage_normal_priority->IncrementBy(e->charge);
+    }
+  }
+}
+
+void LRUCache::MaintainHighPriPoolSize() {
+  while (high_pri_usage_ > high_pri_capacity_ && high_pri_lru_.next != &high_pri_lru_) {
+    LRUHandle* e = high_pri_lru_.next;
+    LRU_Remove(e);
+    SetInHighPriPool(e, false);
+    LRU_Append(e);
+  }
 }
 
 Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash, bool caching) {
@@ -266,7 +331,13 @@ Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash, bool caching) {
     if (e != nullptr) {
       base::RefCountInc(&e->refs);
       LRU_Remove(e);
+      // A high-priority entry which was moved out of its pool returns to it
+      // when it is used again.
+      if (e->priority == Cache::HIGH_PRIORITY && high_pri_capacity_ > 0) {
+        SetInHighPriPool(e, true);
+      }
       LRU_Append(e);
+      MaintainHighPriPoolSize();
     }
   }
 
@@ -300,15 +371,23 @@ void LRUCache::Release(Cache::Handle* handle) {
   }
 }
 
-Cache::Handle* LRUCache::Insert(LRUHandle* e, Cache::EvictionCallback *eviction_callback) {
+Cache::Handle* LRUCache::Insert(LRUHandle* e, Cache::EvictionCallback *eviction_callback,
+                                Cache::Priority priority) {
 
   // Set the remaining LRUHandle members which were not already allocated during
   // Allocate().
   e->eviction_callback = eviction_callback;
   e->refs = 2;  // One from LRUCache, one for the returned handle
+  e->priority = priority;
+  e->in_high_pri_pool = priority == Cache::HIGH_PRIORITY && high_pri_capacity_ > 0;
   mem_tracker_->Consume(e->charge);
   if (PREDICT_TRUE(metrics_)) {
     metrics_->cache_usage->IncrementBy(e->charge);
+    if (e->in_high_pri_pool) {
+      metrics_->cache_usage_high_priority->IncrementBy(e->charge);
+    } else {
+      metrics_->cache_usage_normal_priority->IncrementBy(e->charge);
+    }
     metrics_->inserts->Increment();
   }
 
@@ -327,8 +406,19 @@ Cache::Handle* LRUCache::Insert(LRUHandle* e, Cache::EvictionCallback *eviction_
       }
     }
 
-    while (usage_ > capacity_ && lru_.next != &lru_) {
-      LRUHandle* old = lru_.next;
+    MaintainHighPriPoolSize();
+
+    // Evict from the normal LRU list first. The high-priority pool is only
+    // evicted from once the normal list is empty.
+    while (usage_ > capacity_) {
+      LRUHandle* old;
+      if (lru_.next != &lru_) {
+        old = lru_.next;
+      } else if (high_pri_lru_.next != &high_pri_lru_) {
+        old = high_pri_lru_.next;
+      } else {
+        break;
+      }
       LRU_Remove(old);
       table_.Remove(old->key(), old->hash);
       if (Unref(old)) {
@@ -367,6 +457,17 @@ void LRUCache::Erase(const Slice& key, uint32_t hash) {
   }
 }
 
+void LRUCache::GetRecentlyUsedEntries(size_t max_entries,
+                                      vector<Cache::EntryInfo>* entries) {
+  lock_guard<MutexType> l(&mutex_);
+  for (LRUHandle* list : { &high_pri_lru_, &lru_ }) {
+    for (LRUHandle* e = list->prev; e != list && max_entries > 0; e = e->prev) {
+      entries->push_back({ e->key().ToString(), e->val_length, e->priority });
+      max_entries--;
+    }
+  }
+}
+
 static const int kNumShardBits = 4;
 static const int kNumShards = 1 << kNumShardBits;
 
@@ -388,8 +489,10 @@ class ShardedLRUCache : public Cache {
   }
 
  public:
-  explicit ShardedLRUCache(size_t capacity, const string& id)
+  ShardedLRUCache(size_t capacity, const string& id, double high_priority_pool_ratio)
       : last_id_(0) {
+    DCHECK_GE(high_priority_pool_ratio, 0);
+    DCHECK_LE(high_priority_pool_ratio, 1);
     // A cache is often a singleton, so:
     // 1. We reuse its MemTracker if one already exists, and
     // 2. It is directly parented to the root MemTracker.
@@ -397,9 +500,10 @@ class ShardedLRUCache : public Cache {
         -1, strings::Substitute("$0-sharded_lru_cache", id));
 
     const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
+    const size_t high_pri_per_shard = per_shard * high_priority_pool_ratio;
     for (int s = 0; s < kNumShards; s++) {
       gscoped_ptr<LRUCache> shard(new LRUCache(mem_tracker_.get()));
-      shard->SetCapacity(per_shard);
+      shard->SetCapacity(per_shard, high_pri_per_shard);
       shards_.push_back(shard.release());
     }
   }
@@ -409,9 +513,10 @@ class ShardedLRUCache : public Cache {
   }
 
   virtual Handle* Insert(PendingHandle* handle,
-                         Cache::EvictionCallback* eviction_callback) OVERRIDE {
+                         Cache::EvictionCallback* eviction_callback,
+                         Cache::Priority priority) OVERRIDE {
     LRUHandle* h = reinterpret_cast<LRUHandle*>(DCHECK_NOTNULL(handle));
-    return shards_[Shard(h->hash)]->Insert(h, eviction_callback);
+    return shards_[Shard(h->hash)]->Insert(h, eviction_callback, priority);
   }
   virtual Handle* Lookup(const Slice& key, CacheBehavior caching) OVERRIDE {
     const uint32_t hash = HashSlice(key);
@@ -440,6 +545,29 @@ class ShardedLRUCache : public Cache {
     }
   }
 
+  virtual void GetRecentlyUsedEntries(size_t max_entries,
+                                      vector<EntryInfo>* entries) OVERRIDE {
+    const size_t per_shard = (max_entries + (kNumShards - 1)) / kNumShards;
+    vector<vector<EntryInfo> > shard_entries(shards_.size());
+    for (int s = 0; s < shards_.size(); s++) {
+      shards_[s]->GetRecentlyUsedEntries(per_shard, &shard_entries[s]);
+    }
+    // Interleave the shards so that each shard's most recently used entries
+    // come before the others.
+    size_t num_added = 0;
+    for (size_t i = 0; i < per_shard; i++) {
+      for (vector<EntryInfo>& shard : shard_entries) {
+        if (num_added == max_entries) {
+          return;
+        }
+        if (i < shard.size()) {
+          entries->push_back(std::move(shard[i]));
+          num_added++;
+        }
+      }
+    }
+  }
+
   virtual PendingHandle* Allocate(Slice key, int val_len, int charge) OVERRIDE {
     int key_len = key.size();
     DCHECK_GE(key_len, 0);
@@ -472,10 +600,11 @@ class ShardedLRUCache : public Cache {
 
 }  // end anonymous namespace
 
-Cache* NewLRUCache(CacheType type, size_t capacity, const string& id) {
+Cache* NewLRUCache(CacheType type, size_t capacity, const string& id,
+                   double high_priority_pool_ratio) {
   switch (type) {
     case DRAM_CACHE:
-      return new ShardedLRUCache(capacity, id);
+      return new ShardedLRUCache(capacity, id, high_priority_pool_ratio);
 #if !defined(__APPLE__)
     case NVM_CACHE:
       return NewLRUNvmCache(capacity, id);
@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
@@ -38,7 +39,12 @@ enum CacheType {
 
 // Create a new cache with a fixed size capacity.  This implementation
 // of Cache uses a least-recently-used eviction policy.
-Cache* NewLRUCache(CacheType type, size_t capacity, const std::string& id);
+//
+// 'high_priority_pool_ratio' is the fraction of the capacity reserved for
+// entries inserted with HIGH_PRIORITY: see Cache::Priority. It is only
+// supported by the DRAM cache.
+Cache* NewLRUCache(CacheType type, size_t capacity, const std::string& id,
+                   double high_priority_pool_ratio = 0);
 
 class Cache {
  public:
@@ -69,6 +75,20 @@ class Cache {
     NO_EXPECT_IN_CACHE
   };
 
+  // The priority class of an entry.
+  //
+  // If the cache was created with a high-priority pool, HIGH_PRIORITY entries
+  // are kept in a separate LRU list which may use up to the pool's share of
+  // the capacity, and are never evicted to make room for NORMAL_PRIORITY
+  // entries while they fit in the pool. When the high-priority entries exceed
+  // the pool, the least recently used of them are moved to the normal LRU list
+  // and may be evicted from there. Without a high-priority pool, all entries
+  // are treated alike.
+  enum Priority {
+    NORMAL_PRIORITY,
+    HIGH_PRIORITY
+  };
+
   // If the cache has no mapping for "key", returns NULL.
   //
   // Else return a handle that corresponds to the mapping.  The caller
@@ -101,6 +121,20 @@ class Cache {
   // Pass a metric entity in order to start recoding metrics.
   virtual void SetMetrics(const scoped_refptr<MetricEntity>& metric_entity) = 0;
 
+  // Description of an entry of the cache. See GetRecentlyUsedEntries().
+  struct EntryInfo {
+    std::string key;
+    size_t value_size;
+    Priority priority;
+  };
+
+  // Appends to 'entries' the descriptions of up to 'max_entries' of the most
+  // recently used entries. High-priority entries of a shard come before its
+  // normal entries, and the entries of the different shards are interleaved
+  // so that the most recently used ones come first.
+  virtual void GetRecentlyUsedEntries(size_t max_entries,
+                                      std::vector<EntryInfo>* entries) = 0;
+
   // ------------------------------------------------------------
   // Insertion path
   // ------------------------------------------------------------
@@ -118,7 +152,7 @@ class Cache {
   //     ... error handling ...
   //     return;
   //   }
-  //   Handle* h = cache_->Insert(ph, my_eviction_callback);
+  //   Handle* h = cache_->Insert(ph, my_eviction_callback, Cache::NORMAL_PRIORITY);
   //   ...
   //   cache_->Release(h);
 
@@ -156,7 +190,11 @@ class Cache {
   //
   // If 'eviction_callback' is non-NULL, then it will be called when the
   // entry is later evicted or when the cache shuts down.
-  virtual Handle* Insert(PendingHandle* pending, EvictionCallback* eviction_callback) = 0;
+  //
+  // 'priority' is the priority class of the entry. Implementations which
+  // don't support priorities ignore it.
+  virtual Handle* Insert(PendingHandle* pending, EvictionCallback* eviction_callback,
+                         Priority priority) = 0;
 
   // Free 'ptr', which must have been previously allocated using 'Allocate'.
   virtual void Free(PendingHandle* ptr) = 0;
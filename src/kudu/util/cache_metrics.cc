@@ -50,6 +50,16 @@ METRIC_DEFINE_gauge_uint64(server, block_cache_usage, "Block Cache Memory Usage"
                            "Memory consumed by the block cache");
 
 namespace kudu {
+METRIC_DEFINE_gauge_uint64(server, block_cache_high_priority_usage,
+                           "Block Cache High-Priority Pool Memory Usage",
+                           kudu::MetricUnit::kBytes,
+                           "Memory consumed by blocks in the block cache's high-priority pool, "
+                           "such as index, bloom filter and dictionary blocks");
+METRIC_DEFINE_gauge_uint64(server, block_cache_normal_priority_usage,
+                           "Block Cache Normal-Priority Memory Usage",
+                           kudu::MetricUnit::kBytes,
+                           "Memory consumed by blocks in the block cache outside of the "
+                           "high-priority pool");
 
 #define MINIT(member, x) member(METRIC_##x.Instantiate(entity))
 #define GINIT(member, x) member(METRIC_##x.Instantiate(entity, 0))
@@ -61,7 +71,9 @@ CacheMetrics::CacheMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(cache_hits_caching, block_cache_hits_caching),
     MINIT(cache_misses, block_cache_misses),
     MINIT(cache_misses_caching, block_cache_misses_caching),
-    GINIT(cache_usage, block_cache_usage) {
+    GINIT(cache_usage, block_cache_usage),
+    GINIT(cache_usage_high_priority, block_cache_high_priority_usage),
+    GINIT(cache_usage_normal_priority, block_cache_normal_priority_usage) {
 }
 #undef MINIT
 #undef GINIT
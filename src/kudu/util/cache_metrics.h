@@ -41,6 +41,8 @@ struct CacheMetrics {
   scoped_refptr<Counter> cache_misses_caching;
 
   scoped_refptr<AtomicGauge<uint64_t> > cache_usage;
+  scoped_refptr<AtomicGauge<uint64_t> > cache_usage_high_priority;
+  scoped_refptr<AtomicGauge<uint64_t> > cache_usage_normal_priority;
 };
 
 } // namespace kudu
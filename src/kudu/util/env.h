@@ -331,9 +331,16 @@ struct WritableFileOptions {
   // See CreateMode for details.
   Env::CreateMode mode;
 
+  // Only meaningful with OPEN_EXISTING. If true, writes start at the
+  // beginning of the file and overwrite its existing contents in place;
+  // Close() truncates the file to the length written. This reuses the
+  // file's blocks instead of freeing and allocating new ones.
+  bool overwrite_existing;
+
   WritableFileOptions()
     : sync_on_close(false),
-      mode(Env::CREATE_IF_NON_EXISTING_TRUNCATE) { }
+      mode(Env::CREATE_IF_NON_EXISTING_TRUNCATE),
+      overwrite_existing(false) { }
 };
 
 // Options specified when a file is opened for random access.
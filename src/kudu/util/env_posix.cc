@@ -314,12 +314,12 @@ class PosixRandomAccessFile: public RandomAccessFile {
 class PosixWritableFile : public WritableFile {
  public:
   PosixWritableFile(std::string fname, int fd, uint64_t file_size,
-                    bool sync_on_close)
+                    uint64_t pre_allocated_size, bool sync_on_close)
       : filename_(std::move(fname)),
         fd_(fd),
         sync_on_close_(sync_on_close),
         filesize_(file_size),
-        pre_allocated_size_(0),
+        pre_allocated_size_(pre_allocated_size),
         pending_sync_(false) {}
 
   ~PosixWritableFile() {
@@ -1159,10 +1159,18 @@ class PosixEnv : public Env {
                                     const WritableFileOptions& opts,
                                     gscoped_ptr<WritableFile>* result) {
     uint64_t file_size = 0;
+    uint64_t pre_allocated_size = 0;
     if (opts.mode == OPEN_EXISTING) {
       RETURN_NOT_OK(GetFileSize(fname, &file_size));
+      if (opts.overwrite_existing) {
+        // Start writing at offset 0. Treating the existing contents as
+        // pre-allocated space makes Close() truncate any stale tail.
+        pre_allocated_size = file_size;
+        file_size = 0;
+      }
     }
-    result->reset(new PosixWritableFile(fname, fd, file_size, opts.sync_on_close));
+    result->reset(new PosixWritableFile(fname, fd, file_size, pre_allocated_size,
+                                        opts.sync_on_close));
     return Status::OK();
   }
 
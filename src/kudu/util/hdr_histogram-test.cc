@@ -110,4 +110,28 @@ TEST_F(HdrHistogramTest, PercentileAndCopyTest) {
   ASSERT_EQ(hist.TotalSum(), copy.TotalSum());
 }
 
+TEST_F(HdrHistogramTest, MergeTest) {
+  uint64_t specified_max = 10000;
+  HdrHistogram a(specified_max, kSigDigits);
+  HdrHistogram b(specified_max, kSigDigits);
+  a.Increment(10);
+  a.Increment(20);
+  b.IncrementBy(5, 2);
+  b.Increment(1000);
+
+  HdrHistogram merged(specified_max, kSigDigits);
+  merged.MergeFrom(a);
+  merged.MergeFrom(b);
+  ASSERT_EQ(5, merged.TotalCount());
+  ASSERT_EQ(10 + 20 + 5 * 2 + 1000, merged.TotalSum());
+  ASSERT_EQ(5, merged.MinValue());
+  ASSERT_EQ(1000, merged.MaxValue());
+  ASSERT_EQ(2, merged.CountInBucketForValue(5));
+
+  // Merging an empty histogram changes nothing.
+  merged.MergeFrom(HdrHistogram(specified_max, kSigDigits));
+  ASSERT_EQ(5, merged.TotalCount());
+  ASSERT_EQ(5, merged.MinValue());
+}
+
 } // namespace kudu
@@ -26,10 +26,12 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <sched.h>
 
 #include "kudu/gutil/atomicops.h"
 #include "kudu/gutil/bits.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/util/status.h"
 
 using base::subtle::Atomic64;
@@ -165,11 +167,15 @@ void HdrHistogram::IncrementBy(int64_t value, int64_t count) {
   NoBarrier_AtomicIncrement(&total_count_, count);
   NoBarrier_AtomicIncrement(&total_sum_, value * count);
 
+  UpdateMinAndMax(value, value);
+}
+
+void HdrHistogram::UpdateMinAndMax(int64_t min, int64_t max) {
   // Update min, if needed.
   {
     Atomic64 min_val;
-    while (PREDICT_FALSE(value < (min_val = MinValue()))) {
-      Atomic64 old_val = NoBarrier_CompareAndSwap(&min_value_, min_val, value);
+    while (PREDICT_FALSE(min < (min_val = MinValue()))) {
+      Atomic64 old_val = NoBarrier_CompareAndSwap(&min_value_, min_val, min);
       if (PREDICT_TRUE(old_val == min_val)) break; // CAS success.
     }
   }
@@ -177,8 +183,8 @@ void HdrHistogram::IncrementBy(int64_t value, int64_t count) {
   // Update max, if needed.
   {
     Atomic64 max_val;
-    while (PREDICT_FALSE(value > (max_val = MaxValue()))) {
-      Atomic64 old_val = NoBarrier_CompareAndSwap(&max_value_, max_val, value);
+    while (PREDICT_FALSE(max > (max_val = MaxValue()))) {
+      Atomic64 old_val = NoBarrier_CompareAndSwap(&max_value_, max_val, max);
       if (PREDICT_TRUE(old_val == max_val)) break; // CAS success.
     }
   }
@@ -197,6 +203,31 @@ void HdrHistogram::IncrementWithExpectedInterval(int64_t value,
   }
 }
 
+void HdrHistogram::MergeFrom(const HdrHistogram& other) {
+  CHECK_EQ(highest_trackable_value_, other.highest_trackable_value_);
+  CHECK_EQ(num_significant_digits_, other.num_significant_digits_);
+
+  // As in the copy constructor, read the sum and min first, and the max
+  // last, and keep the total consistent with the merged counts.
+  Atomic64 other_sum = NoBarrier_Load(&other.total_sum_);
+  Atomic64 other_min = NoBarrier_Load(&other.min_value_);
+  uint64_t total_merged_count = 0;
+  for (int i = 0; i < counts_array_length_; i++) {
+    uint64_t count = NoBarrier_Load(&other.counts_[i]);
+    if (count > 0) {
+      NoBarrier_AtomicIncrement(&counts_[i], count);
+      total_merged_count += count;
+    }
+  }
+  Atomic64 other_max = NoBarrier_Load(&other.max_value_);
+  if (total_merged_count == 0) {
+    return;
+  }
+  NoBarrier_AtomicIncrement(&total_count_, total_merged_count);
+  NoBarrier_AtomicIncrement(&total_sum_, other_sum);
+  UpdateMinAndMax(other_min, other_max);
+}
+
 ////////////////////////////////////
 
 int HdrHistogram::BucketIndex(uint64_t value) const {
@@ -320,6 +351,74 @@ uint64_t HdrHistogram::ValueAtPercentile(double percentile) const {
   return 0;
 }
 
+///////////////////////////////////////////////////////////////////////
+// StripedHdrHistogram
+///////////////////////////////////////////////////////////////////////
+
+StripedHdrHistogram::StripedHdrHistogram(uint64_t highest_trackable_value,
+                                         int num_significant_digits,
+                                         int max_stripes)
+  : highest_trackable_value_(highest_trackable_value),
+    num_significant_digits_(num_significant_digits),
+    num_stripes_(std::max(1, std::min(max_stripes, base::MaxCPUIndex() + 1))),
+    stripes_(new AtomicWord[num_stripes_]()) {  // value-initialized
+  CHECK(HdrHistogram::IsValidHighestTrackableValue(highest_trackable_value_));
+  CHECK(HdrHistogram::IsValidNumSignificantDigits(num_significant_digits_));
+}
+
+StripedHdrHistogram::~StripedHdrHistogram() {
+  for (int i = 0; i < num_stripes_; i++) {
+    delete stripe(i);
+  }
+}
+
+HdrHistogram* StripedHdrHistogram::CurrentStripe() {
+#if defined(__APPLE__)
+  // OSX doesn't have a way to get the CPU, so all threads share one stripe.
+  int idx = 0;
+#else
+  // sched_getcpu() returns -1 if the CPU can't be determined.
+  int cpu = sched_getcpu();
+  int idx = PREDICT_TRUE(cpu >= 0) ? cpu % num_stripes_ : 0;
+#endif  // defined(__APPLE__)
+  HdrHistogram* h = stripe(idx);
+  if (PREDICT_TRUE(h != nullptr)) {
+    return h;
+  }
+
+  lock_guard<simple_spinlock> l(&lock_);
+  h = stripe(idx);
+  if (h == nullptr) {
+    h = new HdrHistogram(highest_trackable_value_, num_significant_digits_);
+    base::subtle::Release_Store(&stripes_[idx], reinterpret_cast<AtomicWord>(h));
+  }
+  return h;
+}
+
+void StripedHdrHistogram::IncrementBy(int64_t value, int64_t count) {
+  CurrentStripe()->IncrementBy(value, count);
+}
+
+uint64_t StripedHdrHistogram::TotalCount() const {
+  uint64_t total = 0;
+  for (int i = 0; i < num_stripes_; i++) {
+    const HdrHistogram* h = stripe(i);
+    if (h != nullptr) {
+      total += h->TotalCount();
+    }
+  }
+  return total;
+}
+
+void StripedHdrHistogram::MergeInto(HdrHistogram* out) const {
+  for (int i = 0; i < num_stripes_; i++) {
+    const HdrHistogram* h = stripe(i);
+    if (h != nullptr) {
+      out->MergeFrom(*h);
+    }
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////
 // AbstractHistogramIterator
 ///////////////////////////////////////////////////////////////////////
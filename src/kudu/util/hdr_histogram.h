@@ -52,6 +52,7 @@
 
 #include "kudu/gutil/atomicops.h"
 #include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/util/locks.h"
 
 namespace kudu {
 
@@ -95,6 +96,12 @@ class HdrHistogram {
   void IncrementWithExpectedInterval(int64_t value,
                                      int64_t expected_interval_between_samples);
 
+  // Add the values recorded in 'other', which must have the same highest
+  // trackable value and number of significant digits. Like the copy
+  // constructor, this is not a consistent snapshot of 'other' if it is
+  // concurrently modified.
+  void MergeFrom(const HdrHistogram& other);
+
   // Fetch configuration params.
   uint64_t highest_trackable_value() const { return highest_trackable_value_; }
   int num_significant_digits() const { return num_significant_digits_; }
@@ -177,6 +184,9 @@ class HdrHistogram {
   void Init();
   int CountsArrayIndex(int bucket_index, int sub_bucket_index) const;
 
+  // Lower the minimum to 'min' and raise the maximum to 'max', if needed.
+  void UpdateMinAndMax(int64_t min, int64_t max);
+
   uint64_t highest_trackable_value_;
   int num_significant_digits_;
   int counts_array_length_;
@@ -198,6 +208,66 @@ class HdrHistogram {
   HdrHistogram& operator=(const HdrHistogram& other); // Disable assignment operator.
 };
 
+// A histogram optimized for high-volume concurrent updates.
+//
+// Updating a single HdrHistogram from many threads bounces the cache lines of
+// its total count, sum and buckets between CPUs. Instead, this class records
+// each value into one of several HdrHistograms (stripes), picked by the CPU
+// which the updating thread runs on. Like LongAdder does for counters, the
+// stripes are only summed up when the histogram is read, which is much less
+// frequent.
+//
+// Each stripe takes as much memory as a regular HdrHistogram, so stripes are
+// only allocated once a value is recorded on one of their CPUs, and there are
+// at most 'max_stripes' of them.
+//
+// This class is thread-safe.
+class StripedHdrHistogram {
+ public:
+  StripedHdrHistogram(uint64_t highest_trackable_value, int num_significant_digits,
+                      int max_stripes);
+  ~StripedHdrHistogram();
+
+  // Record new data.
+  void Increment(int64_t value) { IncrementBy(value, 1); }
+  void IncrementBy(int64_t value, int64_t count);
+
+  // Fetch configuration params.
+  uint64_t highest_trackable_value() const { return highest_trackable_value_; }
+  int num_significant_digits() const { return num_significant_digits_; }
+  int num_stripes() const { return num_stripes_; }
+
+  // Count of all events recorded.
+  uint64_t TotalCount() const;
+
+  // Add a (non-consistent) snapshot of the values recorded in all stripes to
+  // 'out', which must have the same highest trackable value and number of
+  // significant digits.
+  void MergeInto(HdrHistogram* out) const;
+
+ private:
+  // Return the stripe for the current CPU, allocating it if needed.
+  HdrHistogram* CurrentStripe();
+
+  // Return the 'idx'-th stripe, or NULL if it was not allocated yet.
+  HdrHistogram* stripe(int idx) const {
+    return reinterpret_cast<HdrHistogram*>(base::subtle::Acquire_Load(&stripes_[idx]));
+  }
+
+  const uint64_t highest_trackable_value_;
+  const int num_significant_digits_;
+  const int num_stripes_;
+
+  // Pointers to the stripes, which are allocated on first use and never freed
+  // until destruction.
+  gscoped_array<AtomicWord> stripes_;
+
+  // Protects the allocation of stripes.
+  simple_spinlock lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(StripedHdrHistogram);
+};
+
 // Value returned from iterators.
 struct HistogramIterationValue {
   HistogramIterationValue()
@@ -35,14 +35,14 @@ using std::vector;
 
 namespace kudu {
 
-// Adapter to allow RapidJSON to write directly to a stringstream.
+// Adapter to allow RapidJSON to write directly to an output stream.
 // Since Squeasel exposes a stringstream as its interface, this is needed to avoid overcopying.
 class UTF8StringStreamBuffer {
  public:
-  explicit UTF8StringStreamBuffer(std::stringstream* out);
+  explicit UTF8StringStreamBuffer(std::ostream* out);
   void Put(rapidjson::UTF8<>::Ch c);
  private:
-  std::stringstream* out_;
+  std::ostream* out_;
 };
 
 // rapidjson doesn't provide any common interface between the PrettyWriter and
@@ -75,7 +75,7 @@ class JsonWriterIf {
 template<class T>
 class JsonWriterImpl : public JsonWriterIf {
  public:
-  explicit JsonWriterImpl(stringstream* out);
+  explicit JsonWriterImpl(std::ostream* out);
 
   virtual void Null() OVERRIDE;
   virtual void Bool(bool b) OVERRIDE;
@@ -106,7 +106,7 @@ class JsonWriterImpl : public JsonWriterIf {
 typedef rapidjson::PrettyWriter<UTF8StringStreamBuffer> PrettyWriterClass;
 typedef rapidjson::Writer<UTF8StringStreamBuffer> CompactWriterClass;
 
-JsonWriter::JsonWriter(stringstream* out, Mode m) {
+JsonWriter::JsonWriter(std::ostream* out, Mode m) {
   switch (m) {
     case PRETTY:
       impl_.reset(new JsonWriterImpl<PrettyWriterClass>(DCHECK_NOTNULL(out)));
@@ -270,7 +270,7 @@ string JsonWriter::ToJson(const Message& pb, Mode mode) {
 // UTF8StringStreamBuffer
 //
 
-UTF8StringStreamBuffer::UTF8StringStreamBuffer(std::stringstream* out)
+UTF8StringStreamBuffer::UTF8StringStreamBuffer(std::ostream* out)
   : out_(DCHECK_NOTNULL(out)) {
 }
 
@@ -283,7 +283,7 @@ void UTF8StringStreamBuffer::Put(rapidjson::UTF8<>::Ch c) {
 //
 
 template<class T>
-JsonWriterImpl<T>::JsonWriterImpl(stringstream* out)
+JsonWriterImpl<T>::JsonWriterImpl(std::ostream* out)
   : stream_(DCHECK_NOTNULL(out)),
     writer_(stream_) {
 }
@@ -19,6 +19,7 @@
 
 #include <inttypes.h>
 
+#include <iosfwd>
 #include <string>
 
 #include "kudu/gutil/gscoped_ptr.h"
@@ -41,8 +42,9 @@ class JsonWriterIf;
 // This class implements all the methods of rapidjson::JsonWriter, plus an
 // additional convenience method for String(std::string).
 //
-// We take an instance of std::stringstream in the constructor because Mongoose / Squeasel
-// uses std::stringstream for output buffering.
+// We take an output stream in the constructor because Mongoose / Squeasel
+// uses std::stringstream for output buffering, and streaming pages write
+// directly to the connection through a std::ostream.
 class JsonWriter {
  public:
   enum Mode {
@@ -52,7 +54,7 @@ class JsonWriter {
     COMPACT
   };
 
-  JsonWriter(std::stringstream* out, Mode mode);
+  JsonWriter(std::ostream* out, Mode mode);
   ~JsonWriter();
 
   void Null();
@@ -27,10 +27,17 @@
 #include <boost/bind.hpp>
 #include <gperftools/malloc_extension.h>
 
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/test_util.h"
 
 DECLARE_int32(memory_limit_soft_percentage);
 
+DEFINE_int32(mem_tracker_bench_num_ops, 100000,
+             "Number of Consume()/Release() pairs each thread performs in "
+             "the concurrency benchmark");
+
 namespace kudu {
 
 using std::equal_to;
@@ -40,6 +47,7 @@ using std::shared_ptr;
 using std::string;
 using std::unordered_map;
 using std::vector;
+using strings::Substitute;
 
 TEST(MemTrackerTest, SingleTrackerNoLimit) {
   shared_ptr<MemTracker> t = MemTracker::CreateTracker(-1, "t");
@@ -357,4 +365,51 @@ TEST(MemTrackerTest, TestMultiThreadedRegisterAndDestroy) {
   }
 }
 
+// Each thread updates its own tracker, as separate tablets do, so the only
+// shared state on the update path is their common parent and the root.
+// Compares a parent which applies every update exactly with one which
+// buffers them per CPU, as the root does; with buffering, throughput should
+// scale with the thread count.
+TEST(MemTrackerTest, BenchmarkConcurrentConsumeRelease) {
+  OverrideFlagForSlowTests("mem_tracker_bench_num_ops",
+                           Substitute("$0", FLAGS_mem_tracker_bench_num_ops * 10));
+  for (bool batched : { false, true }) {
+    for (int num_threads = 1; num_threads <= base::NumCPUs(); num_threads *= 2) {
+      shared_ptr<MemTracker> parent = MemTracker::CreateTracker(-1, "parent");
+      if (batched) {
+        parent->EnableBatchedUpdates(1024 * 1024);
+      }
+      vector<shared_ptr<MemTracker>> trackers;
+      for (int i = 0; i < num_threads; i++) {
+        trackers.push_back(MemTracker::CreateTracker(-1, Substitute("child-$0", i), parent));
+      }
+      vector<std::thread> threads;
+      MonoTime start = MonoTime::Now(MonoTime::FINE);
+      for (int i = 0; i < num_threads; i++) {
+        MemTracker* t = trackers[i].get();
+        threads.emplace_back([t]{
+            for (int op = 0; op < FLAGS_mem_tracker_bench_num_ops; op++) {
+              t->Consume(1024);
+              t->Release(1024);
+            }
+          });
+      }
+      for (auto& t : threads) {
+        t.join();
+      }
+      MonoDelta elapsed = MonoTime::Now(MonoTime::FINE).GetDeltaSince(start);
+      LOG(INFO) << Substitute("$0, $1 threads: $2 ops/sec",
+                              batched ? "batched" : "unbatched", num_threads,
+                              static_cast<int64_t>(2.0 * num_threads *
+                                                   FLAGS_mem_tracker_bench_num_ops /
+                                                   elapsed.ToSeconds()));
+      for (const auto& t : trackers) {
+        ASSERT_EQ(0, t->consumption());
+      }
+      parent->FlushPendingDeltas();
+      ASSERT_EQ(0, parent->consumption());
+    }
+  }
+}
+
 } // namespace kudu
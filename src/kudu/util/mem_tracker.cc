@@ -18,17 +18,20 @@
 #include "kudu/util/mem_tracker.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <deque>
 #include <gperftools/malloc_extension.h>
 #include <limits>
 #include <list>
 #include <memory>
+#include <sched.h>
 
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/once.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/human_readable.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/util/debug-util.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
@@ -56,6 +59,13 @@ DEFINE_int32(memory_limit_warn_threshold_percentage, 98,
              "consume before WARNING level messages are periodically logged.");
 TAG_FLAG(memory_limit_warn_threshold_percentage, advanced);
 
+DEFINE_int64(memory_tracker_root_batch_bytes, 1024 * 1024,
+             "Amount of consumption, in bytes, that each CPU may buffer before "
+             "applying it to the root memory tracker. Larger values reduce "
+             "contention on the root tracker at the expense of accuracy while "
+             "far from the memory limit. A value of 0 disables buffering.");
+TAG_FLAG(memory_tracker_root_batch_bytes, advanced);
+
 #ifdef TCMALLOC_ENABLED
 DEFINE_int32(tcmalloc_max_free_bytes_percentage, 10,
              "Maximum percentage of the RSS that tcmalloc is allowed to use for "
@@ -133,6 +143,9 @@ void MemTracker::CreateRootTracker() {
 #endif
   root_tracker.reset(new MemTracker(f, limit, "root",
                                     shared_ptr<MemTracker>()));
+  if (FLAGS_memory_tracker_root_batch_bytes > 0) {
+    root_tracker->EnableBatchedUpdates(FLAGS_memory_tracker_root_batch_bytes);
+  }
   root_tracker->Init();
   LOG(INFO) << StringPrintf("MemTracker: hard memory limit is %.6f GB",
                             (static_cast<float>(limit) / (1024.0 * 1024.0 * 1024.0)));
@@ -167,6 +180,10 @@ MemTracker::MemTracker(ConsumptionFunction consumption_func, int64_t byte_limit,
       descr_(Substitute("memory consumption for $0", id)),
       parent_(std::move(parent)),
       consumption_(0),
+      pending_deltas_(nullptr),
+      num_pending_deltas_(0),
+      batch_bytes_(0),
+      max_pending_bytes_(0),
       consumption_func_(std::move(consumption_func)),
       rand_(GetRandomSeed32()),
       enable_logging_(false),
@@ -181,12 +198,16 @@ MemTracker::MemTracker(ConsumptionFunction consumption_func, int64_t byte_limit,
 
 MemTracker::~MemTracker() {
   VLOG(1) << "Destroying tracker " << ToString();
+  if (pending_deltas_) {
+    FlushPendingDeltas();
+  }
   if (parent_) {
     DCHECK(consumption() == 0) << "Memory tracker " << ToString()
         << " has unreleased consumption " << consumption();
     parent_->Release(consumption());
     UnregisterFromParent();
   }
+  free(pending_deltas_);
 }
 
 void MemTracker::UnregisterFromParent() {
@@ -270,9 +291,81 @@ void MemTracker::ListTrackers(vector<shared_ptr<MemTracker>>* trackers) {
 void MemTracker::UpdateConsumption() {
   DCHECK(!consumption_func_.empty());
   DCHECK(parent_.get() == NULL);
+  // The consumption function already reflects any buffered updates.
+  for (int i = 0; i < num_pending_deltas_; i++) {
+    base::subtle::NoBarrier_AtomicExchange(&pending_deltas_[i].consumption, 0);
+  }
   consumption_.set_value(consumption_func_());
 }
 
+void MemTracker::EnableBatchedUpdates(int64_t batch_bytes) {
+  DCHECK_GT(batch_bytes, 0);
+  num_pending_deltas_ = base::MaxCPUIndex() + 1;
+  // new[] only guarantees the alignment of the type's members, which would
+  // let neighbouring slots share a cache line.
+  void* buf;
+  int err = posix_memalign(&buf, CACHELINE_SIZE, sizeof(PendingDelta) * num_pending_deltas_);
+  CHECK_EQ(0, err) << "error calling posix_memalign";
+  pending_deltas_ = new (buf) PendingDelta[num_pending_deltas_]();
+  batch_bytes_ = batch_bytes;
+  max_pending_bytes_ = num_pending_deltas_ * batch_bytes;
+}
+
+MemTracker::PendingDelta* MemTracker::CurrentPendingDelta() {
+#if defined(__APPLE__)
+  // OSX doesn't have a way to get the CPU, so all threads share one slot.
+  int cpu = 0;
+#else
+  int cpu = sched_getcpu();
+  // sched_getcpu() returns -1 if the CPU can't be determined.
+  if (PREDICT_FALSE(cpu < 0 || cpu >= num_pending_deltas_)) {
+    cpu = 0;
+  }
+#endif  // defined(__APPLE__)
+  return &pending_deltas_[cpu];
+}
+
+void MemTracker::IncrementConsumption(int64_t bytes) {
+  if (pending_deltas_ && !NearLimit()) {
+    PendingDelta* slot = CurrentPendingDelta();
+    int64_t pending = base::subtle::NoBarrier_AtomicIncrement(&slot->consumption, bytes);
+    if (std::abs(pending) < batch_bytes_) {
+      return;
+    }
+    // Another thread on this CPU may have added to the slot in the meantime;
+    // the exchange picks up its update too.
+    bytes = base::subtle::NoBarrier_AtomicExchange(&slot->consumption, 0);
+  }
+  consumption_.IncrementBy(bytes);
+}
+
+void MemTracker::FlushPendingDeltas() {
+  for (int i = 0; i < num_pending_deltas_; i++) {
+    Atomic64* pending = &pending_deltas_[i].consumption;
+    if (base::subtle::NoBarrier_Load(pending) != 0) {
+      consumption_.IncrementBy(base::subtle::NoBarrier_AtomicExchange(pending, 0));
+    }
+  }
+}
+
+void MemTracker::RecordReleasedBytes(int64_t bytes) {
+  // Like consumption, the released byte count is buffered in the root's
+  // per-CPU slots, since every Release() in the process would otherwise
+  // update the same counter.
+  MemTracker* root = all_trackers_.back();
+  if (root->pending_deltas_) {
+    PendingDelta* slot = root->CurrentPendingDelta();
+    if (base::subtle::NoBarrier_AtomicIncrement(&slot->released, bytes) < root->batch_bytes_) {
+      return;
+    }
+    bytes = base::subtle::NoBarrier_AtomicExchange(&slot->released, 0);
+  }
+  if (PREDICT_FALSE(base::subtle::Barrier_AtomicIncrement(&released_memory_since_gc, bytes) >
+                    GC_RELEASE_SIZE)) {
+    GcTcmalloc();
+  }
+}
+
 void MemTracker::Consume(int64_t bytes) {
   if (bytes < 0) {
     Release(-bytes);
@@ -290,7 +383,7 @@ void MemTracker::Consume(int64_t bytes) {
     LogUpdate(true, bytes);
   }
   for (auto& tracker : all_trackers_) {
-    tracker->consumption_.IncrementBy(bytes);
+    tracker->IncrementConsumption(bytes);
     if (!tracker->consumption_func_.empty()) {
       DCHECK_GE(tracker->consumption_.current_value(), 0);
     }
@@ -316,6 +409,13 @@ bool MemTracker::TryConsume(int64_t bytes) {
     if (tracker->limit_ < 0) {
       tracker->consumption_.IncrementBy(bytes);
     } else {
+      // The buffered slots could hide the difference between fitting within
+      // the limit and exceeding it, so apply them before checking.
+      if (tracker->pending_deltas_ &&
+          tracker->consumption_.current_value() + tracker->max_pending_bytes_ + bytes >
+          tracker->limit_) {
+        tracker->FlushPendingDeltas();
+      }
       if (!tracker->consumption_.TryIncrementBy(bytes, tracker->limit_)) {
         // One of the trackers failed, attempt to GC memory or expand our limit. If that
         // succeeds, TryUpdate() again. Bail if either fails.
@@ -357,10 +457,7 @@ void MemTracker::Release(int64_t bytes) {
     return;
   }
 
-  if (PREDICT_FALSE(base::subtle::Barrier_AtomicIncrement(&released_memory_since_gc, bytes) >
-                    GC_RELEASE_SIZE)) {
-    GcTcmalloc();
-  }
+  RecordReleasedBytes(bytes);
 
   if (!consumption_func_.empty()) {
     UpdateConsumption();
@@ -375,7 +472,7 @@ void MemTracker::Release(int64_t bytes) {
   }
 
   for (auto& tracker : all_trackers_) {
-    tracker->consumption_.IncrementBy(-bytes);
+    tracker->IncrementConsumption(-bytes);
     // If a UDF calls FunctionContext::TrackAllocation() but allocates less than the
     // reported amount, the subsequent call to FunctionContext::Free() may cause the
     // process mem tracker to go negative until it is synced back to the tcmalloc
@@ -398,6 +495,9 @@ bool MemTracker::AnyLimitExceeded() {
 }
 
 bool MemTracker::LimitExceeded() {
+  if (pending_deltas_ && NearLimit()) {
+    FlushPendingDeltas();
+  }
   if (PREDICT_FALSE(CheckLimitExceeded())) {
     return GcMemory(limit_);
   }
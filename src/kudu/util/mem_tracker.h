@@ -18,12 +18,15 @@
 #define KUDU_UTIL_MEM_TRACKER_H
 
 #include <boost/function.hpp>
+#include <gtest/gtest_prod.h>
 #include <list>
 #include <memory>
 #include <stdint.h>
 #include <string>
 #include <vector>
 
+#include "kudu/gutil/atomicops.h"
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/high_water_mark.h"
 #include "kudu/util/locks.h"
@@ -69,6 +72,13 @@ class MemTracker;
 // this will be called before the process limit is reported as exceeded. GcFunctions are
 // called in the order they are added, so expensive functions should be added last.
 //
+// Every Consume()/Release() in the process also updates the root tracker, so
+// updates to the root are buffered in per-CPU slots and applied in chunks of
+// --memory_tracker_root_batch_bytes. While far from its soft limit, the root's
+// consumption() may therefore lag the true value by up to one chunk per CPU;
+// once within that distance of its soft limit, updates are applied exactly and
+// the limit checks flush any outstanding slots first.
+//
 // This class is thread-safe.
 //
 // NOTE: this class has been partially ported over from Impala with
@@ -196,6 +206,7 @@ class MemTracker : public std::enable_shared_from_this<MemTracker> {
 
 
   int64_t limit() const { return limit_; }
+  int64_t soft_limit() const { return soft_limit_; }
   bool has_limit() const { return limit_ >= 0; }
   const std::string& id() const { return id_; }
 
@@ -233,6 +244,8 @@ class MemTracker : public std::enable_shared_from_this<MemTracker> {
   std::string ToString() const;
 
  private:
+  FRIEND_TEST(MemTrackerTest, BenchmarkConcurrentConsumeRelease);
+
   // Function signatures for gauge-style memory trackers (where consumption is
   // periodically observed rather than explicitly tracked).
   //
@@ -250,6 +263,43 @@ class MemTracker : public std::enable_shared_from_this<MemTracker> {
     return limit_ >= 0 && limit_ < consumption();
   }
 
+  // A per-CPU slot of buffered updates, padded to avoid false sharing. The
+  // slots are allocated cache line aligned.
+  struct PendingDelta {
+    // Net consumption not yet applied to 'consumption_'.
+    Atomic64 consumption;
+
+    // Released bytes not yet added to the process-wide tcmalloc GC counter.
+    Atomic64 released;
+
+    char padding[CACHELINE_SIZE - (2 * sizeof(Atomic64) % CACHELINE_SIZE)];
+  };
+
+  // Enables per-CPU buffering of consumption updates, applying them to
+  // 'consumption_' whenever a slot accumulates 'batch_bytes' or more.
+  //
+  // Must be called before the tracker is visible to other threads.
+  void EnableBatchedUpdates(int64_t batch_bytes);
+
+  // Returns the calling CPU's slot in 'pending_deltas_'.
+  PendingDelta* CurrentPendingDelta();
+
+  // Adds 'bytes' to 'consumption_', possibly via the calling CPU's slot.
+  void IncrementConsumption(int64_t bytes);
+
+  // Applies all buffered slots to 'consumption_'.
+  void FlushPendingDeltas();
+
+  // Returns true if buffered slots may hide the crossing of the soft limit,
+  // in which case updates must be applied exactly.
+  bool NearLimit() const {
+    return has_limit() &&
+        consumption_.current_value() + max_pending_bytes_ > soft_limit_;
+  }
+
+  // Accounts 'bytes' towards the next tcmalloc GC, triggering it if due.
+  void RecordReleasedBytes(int64_t bytes);
+
   // If consumption is higher than max_consumption, attempts to free memory by calling any
   // added GC functions.  Returns true if max_consumption is still exceeded. Takes
   // gc_lock. Updates metrics if initialized.
@@ -311,6 +361,15 @@ class MemTracker : public std::enable_shared_from_this<MemTracker> {
 
   HighWaterMark consumption_;
 
+  // Per-CPU buffered updates; NULL unless EnableBatchedUpdates() was called.
+  PendingDelta* pending_deltas_;
+  int num_pending_deltas_;
+
+  // Slot size at which buffered updates are applied, and the largest total
+  // amount that may be outstanding across all slots.
+  int64_t batch_bytes_;
+  int64_t max_pending_bytes_;
+
   ConsumptionFunction consumption_func_;
 
   // this tracker plus all of its ancestors
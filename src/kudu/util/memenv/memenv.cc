@@ -386,7 +386,16 @@ class InMemoryEnv : public EnvWrapper {
                                  const std::string& fname,
                                  gscoped_ptr<WritableFile>* result) OVERRIDE {
     gscoped_ptr<WritableFileImpl> wf;
-    RETURN_NOT_OK(CreateAndRegisterNewFile(fname, opts.mode, &wf));
+    if (opts.mode == OPEN_EXISTING && opts.overwrite_existing) {
+      // In-memory files can't be rewritten in place, but truncating the file
+      // and writing it from the start is observably equivalent.
+      if (!FileExists(fname)) {
+        return Status::IOError(fname, "File not found");
+      }
+      RETURN_NOT_OK(CreateAndRegisterNewFile(fname, CREATE_IF_NON_EXISTING_TRUNCATE, &wf));
+    } else {
+      RETURN_NOT_OK(CreateAndRegisterNewFile(fname, opts.mode, &wf));
+    }
     result->reset(wf.release());
     return Status::OK();
   }
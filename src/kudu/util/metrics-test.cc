@@ -24,6 +24,7 @@
 
 #include "kudu/gutil/bind.h"
 #include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/util.h"
 #include "kudu/util/hdr_histogram.h"
 #include "kudu/util/jsonreader.h"
 #include "kudu/util/jsonwriter.h"
@@ -166,6 +167,23 @@ TEST_F(MetricsTest, SimpleHistogramTest) {
   // TODO: Test coverage needs to be improved a lot.
 }
 
+METRIC_DEFINE_histogram(test_entity, test_striped_hist, "Test Striped Histogram",
+                        MetricUnit::kMilliseconds, "foo", 1000000, 3,
+                        STRIPED_HISTOGRAM);
+
+TEST_F(MetricsTest, StripedHistogramTest) {
+  scoped_refptr<Histogram> hist = METRIC_test_striped_hist.Instantiate(entity_);
+  ASSERT_TRUE(hist->striped_histogram_);
+  ASSERT_EQ(0, hist->TotalCount());
+  hist->Increment(2);
+  hist->IncrementBy(4, 1);
+  ASSERT_EQ(2, hist->MinValueForTests());
+  ASSERT_EQ(3, hist->MeanValueForTests());
+  ASSERT_EQ(4, hist->MaxValueForTests());
+  ASSERT_EQ(2, hist->TotalCount());
+  ASSERT_EQ(1, hist->CountInBucketForValueForTests(4));
+}
+
 TEST_F(MetricsTest, JsonPrintTest) {
   scoped_refptr<Counter> bytes_seen = METRIC_reqs_pending.Instantiate(entity_);
   bytes_seen->Increment();
@@ -202,6 +220,90 @@ TEST_F(MetricsTest, JsonPrintTest) {
   ASSERT_EQ("", out.str());
 }
 
+static string EntityAsJson(const scoped_refptr<MetricEntity>& entity,
+                           const MetricJsonOptions& opts) {
+  std::stringstream out;
+  JsonWriter writer(&out, JsonWriter::COMPACT);
+  CHECK_OK(entity->WriteAsJson(&writer, { "*" }, opts));
+  return out.str();
+}
+
+TEST_F(MetricsTest, JsonFilterTest) {
+  scoped_refptr<Counter> reqs = METRIC_reqs_pending.Instantiate(entity_);
+  scoped_refptr<AtomicGauge<uint64_t> > mem_usage =
+    METRIC_fake_memory_usage.Instantiate(entity_, 0);
+
+  // Filter by entity type.
+  MetricJsonOptions opts;
+  opts.entity_types = { "server" };
+  ASSERT_EQ("", EntityAsJson(entity_, opts));
+  opts.entity_types = { "server", "test_entity" };
+  string json = EntityAsJson(entity_, opts);
+  ASSERT_STR_CONTAINS(json, "reqs_pending");
+  ASSERT_STR_CONTAINS(json, "fake_memory_usage");
+
+  // Filter by metric name prefix.
+  opts = MetricJsonOptions();
+  opts.metric_name_prefixes = { "reqs_" };
+  json = EntityAsJson(entity_, opts);
+  ASSERT_STR_CONTAINS(json, "reqs_pending");
+  ASSERT_EQ(string::npos, json.find("fake_memory_usage"));
+  opts.metric_name_prefixes = { "pending" };
+  ASSERT_EQ("", EntityAsJson(entity_, opts));
+
+  // Only the metrics modified since the start of a new epoch are written.
+  opts = MetricJsonOptions();
+  opts.only_modified_in_or_after_epoch = Metric::IncrementEpoch() + 1;
+  ASSERT_EQ(opts.only_modified_in_or_after_epoch, Metric::current_epoch());
+  ASSERT_EQ("", EntityAsJson(entity_, opts));
+  reqs->Increment();
+  json = EntityAsJson(entity_, opts);
+  ASSERT_STR_CONTAINS(json, "reqs_pending");
+  ASSERT_EQ(string::npos, json.find("fake_memory_usage"));
+}
+
+TEST_F(MetricsTest, PrometheusPrintTest) {
+  scoped_refptr<Counter> reqs = METRIC_reqs_pending.Instantiate(entity_);
+  reqs->Increment();
+  scoped_refptr<Histogram> hist = METRIC_test_hist.Instantiate(entity_);
+  hist->Increment(2);
+  hist->Increment(4);
+  entity_->SetAttribute("test attr", "a \"quoted\" value");
+  scoped_refptr<MetricEntity> other_entity =
+      METRIC_ENTITY_test_entity.Instantiate(&registry_, "other");
+  METRIC_reqs_pending.Instantiate(other_entity)->IncrementBy(5);
+
+  std::stringstream out;
+  PrometheusWriter writer(&out);
+  ASSERT_OK(registry_.WriteAsPrometheus(&writer, { "*" }, MetricJsonOptions()));
+  string output = out.str();
+
+  // The samples of both entities follow the header of their family.
+  const string kLabels =
+      "entity_type=\"test_entity\",entity_id=\"my-test\",test_attr=\"a \\\"quoted\\\" value\"";
+  ASSERT_STR_CONTAINS(output,
+                      "# HELP kudu_reqs_pending Number of requests pending\n"
+                      "# TYPE kudu_reqs_pending counter\n");
+  ASSERT_STR_CONTAINS(output, "kudu_reqs_pending{" + kLabels + "} 1\n");
+  ASSERT_STR_CONTAINS(output,
+                      "kudu_reqs_pending{entity_type=\"test_entity\",entity_id=\"other\"} 5\n");
+  ASSERT_EQ(1, CountSubstring(output, "# TYPE kudu_reqs_pending"));
+
+  // Histograms are written as summaries.
+  ASSERT_STR_CONTAINS(output, "# TYPE kudu_test_hist summary\n");
+  ASSERT_STR_CONTAINS(output, "kudu_test_hist{" + kLabels + ",quantile=\"0.75\"} 4\n");
+  ASSERT_STR_CONTAINS(output, "kudu_test_hist_sum{" + kLabels + "} 6\n");
+  ASSERT_STR_CONTAINS(output, "kudu_test_hist_count{" + kLabels + "} 2\n");
+
+  // The output is filtered like the JSON one.
+  out.str("");
+  MetricJsonOptions opts;
+  opts.metric_name_prefixes = { "test_" };
+  ASSERT_OK(registry_.WriteAsPrometheus(&writer, { "*" }, opts));
+  ASSERT_EQ(string::npos, out.str().find("kudu_reqs_pending"));
+  ASSERT_STR_CONTAINS(out.str(), "kudu_test_hist_count");
+}
+
 // Test that metrics are retired when they are no longer referenced.
 TEST_F(MetricsTest, RetirementTest) {
   FLAGS_metrics_retirement_age_ms = 100;
@@ -16,6 +16,7 @@
 // under the License.
 #include "kudu/util/metrics.h"
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <set>
@@ -28,11 +29,13 @@
 #include "kudu/gutil/singleton.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/strings/util.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/hdr_histogram.h"
 #include "kudu/util/histogram.pb.h"
 #include "kudu/util/jsonwriter.h"
 #include "kudu/util/locks.h"
+#include "kudu/util/prometheus_writer.h"
 #include "kudu/util/status.h"
 
 DEFINE_int32(metrics_retirement_age_ms, 120 * 1000,
@@ -41,6 +44,13 @@ DEFINE_int32(metrics_retirement_age_ms, 120 * 1000,
 TAG_FLAG(metrics_retirement_age_ms, runtime);
 TAG_FLAG(metrics_retirement_age_ms, advanced);
 
+DEFINE_int32(metrics_histogram_max_stripes, 8,
+             "The maximum number of per-CPU stripes of the histograms which are "
+             "updated on every operation, such as RPC handler latencies. More "
+             "stripes make concurrent updates cheaper, but each stripe takes as "
+             "much memory as a regular histogram.");
+TAG_FLAG(metrics_histogram_max_stripes, advanced);
+
 // Process/server-wide metrics should go into the 'server' entity.
 // More complex applications will define other entities.
 METRIC_DEFINE_entity(server);
@@ -189,35 +199,60 @@ bool MatchMetricInList(const string& metric_name,
   return false;
 }
 
+// Return whether 'name' starts with one of 'prefixes', or 'prefixes' is empty.
+bool MatchPrefixInList(const char* name, const vector<string>& prefixes) {
+  if (prefixes.empty()) return true;
+  for (const string& prefix : prefixes) {
+    if (HasPrefixString(name, prefix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 } // anonymous namespace
 
+bool MetricEntity::GetMetricsAndAttrs(const vector<string>& requested_metrics,
+                                      const MetricJsonOptions& opts,
+                                      OrderedMetricMap* metrics,
+                                      AttributeMap* attrs) const {
+  if (!opts.entity_types.empty() &&
+      std::find(opts.entity_types.begin(), opts.entity_types.end(),
+                prototype_->name()) == opts.entity_types.end()) {
+    return false;
+  }
 
-Status MetricEntity::WriteAsJson(JsonWriter* writer,
-                                 const vector<string>& requested_metrics,
-                                 const MetricJsonOptions& opts) const {
   bool select_all = MatchMetricInList(id(), requested_metrics);
-
-  // We want the keys to be in alphabetical order when printing, so we use an ordered map here.
-  typedef std::map<const char*, scoped_refptr<Metric> > OrderedMetricMap;
-  OrderedMetricMap metrics;
-  AttributeMap attrs;
   {
     // Snapshot the metrics in this registry (not guaranteed to be a consistent snapshot)
     lock_guard<simple_spinlock> l(&lock_);
-    attrs = attributes_;
+    *attrs = attributes_;
     for (const MetricMap::value_type& val : metric_map_) {
       const MetricPrototype* prototype = val.first;
       const scoped_refptr<Metric>& metric = val.second;
 
-      if (select_all || MatchMetricInList(prototype->name(), requested_metrics)) {
-        InsertOrDie(&metrics, prototype->name(), metric);
+      if ((select_all || MatchMetricInList(prototype->name(), requested_metrics)) &&
+          MatchPrefixInList(prototype->name(), opts.metric_name_prefixes) &&
+          metric->ModifiedInOrAfterEpoch(opts.only_modified_in_or_after_epoch)) {
+        InsertOrDie(metrics, prototype->name(), metric);
       }
     }
   }
 
   // If we had a filter, and we didn't either match this entity or any metrics inside
   // it, don't print the entity at all.
-  if (!requested_metrics.empty() && !select_all && metrics.empty()) {
+  bool filtered = (!requested_metrics.empty() && !select_all) ||
+                  !opts.metric_name_prefixes.empty() ||
+                  opts.only_modified_in_or_after_epoch > 0;
+  return !filtered || !metrics->empty();
+}
+
+Status MetricEntity::WriteAsJson(JsonWriter* writer,
+                                 const vector<string>& requested_metrics,
+                                 const MetricJsonOptions& opts) const {
+  OrderedMetricMap metrics;
+  AttributeMap attrs;
+  if (!GetMetricsAndAttrs(requested_metrics, opts, &metrics, &attrs)) {
     return Status::OK();
   }
 
@@ -348,6 +383,83 @@ Status MetricRegistry::WriteAsJson(JsonWriter* writer,
   return Status::OK();
 }
 
+namespace {
+
+const char* PrometheusType(MetricType::Type type) {
+  switch (type) {
+    case MetricType::kGauge: return "gauge";
+    case MetricType::kCounter: return "counter";
+    case MetricType::kHistogram: return "summary";
+  }
+  LOG(FATAL) << "Unknown metric type: " << type;
+  return nullptr;
+}
+
+} // anonymous namespace
+
+Status MetricRegistry::WriteAsPrometheus(PrometheusWriter* writer,
+                                         const vector<string>& requested_metrics,
+                                         const MetricJsonOptions& opts) const {
+  EntityMap entities;
+  {
+    lock_guard<simple_spinlock> l(&lock_);
+    entities = entities_;
+  }
+
+  // Gather the selected metrics of all entities along with the index of the
+  // labels of their entity, and sort them by metric so that the samples of
+  // each metric family are written together.
+  vector<string> entity_labels;
+  vector<std::pair<scoped_refptr<Metric>, int>> metrics;
+  for (const EntityMap::value_type& e : entities) {
+    MetricEntity::OrderedMetricMap entity_metrics;
+    MetricEntity::AttributeMap attrs;
+    if (!e.second->GetMetricsAndAttrs(requested_metrics, opts, &entity_metrics, &attrs)) {
+      continue;
+    }
+
+    string labels;
+    PrometheusWriter::AppendLabel("entity_type", e.second->prototype().name(), &labels);
+    PrometheusWriter::AppendLabel("entity_id", e.second->id(), &labels);
+    std::map<string, string> sorted_attrs(attrs.begin(), attrs.end());
+    for (const auto& attr : sorted_attrs) {
+      PrometheusWriter::AppendLabel(attr.first, attr.second, &labels);
+    }
+    entity_labels.push_back(std::move(labels));
+
+    for (const MetricEntity::OrderedMetricMap::value_type& m : entity_metrics) {
+      metrics.emplace_back(m.second, entity_labels.size() - 1);
+    }
+  }
+  entities.clear();
+
+  std::stable_sort(metrics.begin(), metrics.end(),
+                   [](const std::pair<scoped_refptr<Metric>, int>& a,
+                      const std::pair<scoped_refptr<Metric>, int>& b) {
+                     int cmp = strcmp(a.first->prototype()->name(),
+                                      b.first->prototype()->name());
+                     return cmp < 0 || (cmp == 0 && a.first->prototype() < b.first->prototype());
+                   });
+
+  const MetricPrototype* family = nullptr;
+  string family_name;
+  for (const auto& m : metrics) {
+    const MetricPrototype* prototype = m.first->prototype();
+    if (prototype != family) {
+      family = prototype;
+      family_name = Substitute("kudu_$0", prototype->name());
+      writer->WriteFamilyHeader(family_name, PrometheusType(prototype->type()),
+                                prototype->description());
+    }
+    m.first->WriteAsPrometheus(writer, family_name, entity_labels[m.second]);
+  }
+
+  // See WriteAsJson().
+  metrics.clear();
+  const_cast<MetricRegistry*>(this)->RetireOldMetrics();
+  return Status::OK();
+}
+
 void MetricRegistry::RetireOldMetrics() {
   lock_guard<simple_spinlock> l(&lock_);
   for (auto it = entities_.begin(); it != entities_.end();) {
@@ -480,8 +592,11 @@ scoped_refptr<MetricEntity> MetricRegistry::FindOrCreateEntity(
 //
 // Metric
 //
+AtomicInt<int64_t> Metric::g_epoch_(0);
+
 Metric::Metric(const MetricPrototype* prototype)
-  : prototype_(prototype) {
+  : prototype_(prototype),
+    m_epoch_(current_epoch()) {
 }
 
 Metric::~Metric() {
@@ -518,10 +633,17 @@ std::string StringGauge::value() const {
 }
 
 void StringGauge::set_value(const std::string& value) {
+  UpdateModificationEpoch();
   lock_guard<simple_spinlock> l(&lock_);
   value_ = value;
 }
 
+void StringGauge::WriteAsPrometheus(PrometheusWriter* writer,
+                                    const string& name,
+                                    const string& labels) const {
+  // Prometheus samples are numeric, so there is nothing to write.
+}
+
 void StringGauge::WriteValue(JsonWriter* writer) const {
   writer->String(value());
 }
@@ -547,6 +669,7 @@ void Counter::Increment() {
 }
 
 void Counter::IncrementBy(int64_t amount) {
+  UpdateModificationEpoch();
   value_.IncrementBy(amount);
 }
 
@@ -563,6 +686,12 @@ Status Counter::WriteAsJson(JsonWriter* writer,
   return Status::OK();
 }
 
+void Counter::WriteAsPrometheus(PrometheusWriter* writer,
+                                const string& name,
+                                const string& labels) const {
+  writer->WriteSample(name, labels, value());
+}
+
 /////////////////////////////////////////////////
 // HistogramPrototype
 /////////////////////////////////////////////////
@@ -592,15 +721,41 @@ scoped_refptr<Histogram> HistogramPrototype::Instantiate(
 
 Histogram::Histogram(const HistogramPrototype* proto)
   : Metric(proto),
-    histogram_(new HdrHistogram(proto->max_trackable_value(), proto->num_sig_digits())) {
+    histogram_(proto->striped() ? nullptr :
+               new HdrHistogram(proto->max_trackable_value(), proto->num_sig_digits())),
+    striped_histogram_(!proto->striped() ? nullptr :
+                       new StripedHdrHistogram(proto->max_trackable_value(),
+                                               proto->num_sig_digits(),
+                                               FLAGS_metrics_histogram_max_stripes)) {
 }
 
 void Histogram::Increment(int64_t value) {
-  histogram_->Increment(value);
+  UpdateModificationEpoch();
+  if (striped_histogram_) {
+    striped_histogram_->Increment(value);
+  } else {
+    histogram_->Increment(value);
+  }
 }
 
 void Histogram::IncrementBy(int64_t value, int64_t amount) {
-  histogram_->IncrementBy(value, amount);
+  UpdateModificationEpoch();
+  if (striped_histogram_) {
+    striped_histogram_->IncrementBy(value, amount);
+  } else {
+    histogram_->IncrementBy(value, amount);
+  }
+}
+
+gscoped_ptr<HdrHistogram> Histogram::Snapshot() const {
+  if (!striped_histogram_) {
+    return gscoped_ptr<HdrHistogram>(new HdrHistogram(*histogram_));
+  }
+  gscoped_ptr<HdrHistogram> snapshot(new HdrHistogram(
+      striped_histogram_->highest_trackable_value(),
+      striped_histogram_->num_significant_digits()));
+  striped_histogram_->MergeInto(snapshot.get());
+  return snapshot.Pass();
 }
 
 Status Histogram::WriteAsJson(JsonWriter* writer,
@@ -612,9 +767,34 @@ Status Histogram::WriteAsJson(JsonWriter* writer,
   return Status::OK();
 }
 
+void Histogram::WriteAsPrometheus(PrometheusWriter* writer,
+                                  const string& name,
+                                  const string& labels) const {
+  static const struct {
+    double percentile;
+    const char* quantile;
+  } kQuantiles[] = {
+    { 75, "0.75" },
+    { 95, "0.95" },
+    { 99, "0.99" },
+    { 99.9, "0.999" },
+    { 99.99, "0.9999" },
+  };
+
+  gscoped_ptr<HdrHistogram> snapshot(Snapshot());
+  for (const auto& q : kQuantiles) {
+    string quantile_labels = labels;
+    PrometheusWriter::AppendLabel("quantile", q.quantile, &quantile_labels);
+    writer->WriteSample(name, quantile_labels, snapshot->ValueAtPercentile(q.percentile));
+  }
+  writer->WriteSample(name + "_sum", labels, snapshot->TotalSum());
+  writer->WriteSample(name + "_count", labels, snapshot->TotalCount());
+}
+
 Status Histogram::GetHistogramSnapshotPB(HistogramSnapshotPB* snapshot_pb,
                                          const MetricJsonOptions& opts) const {
-  HdrHistogram snapshot(*histogram_);
+  gscoped_ptr<HdrHistogram> snapshot_ptr(Snapshot());
+  const HdrHistogram& snapshot = *snapshot_ptr;
   snapshot_pb->set_name(prototype_->name());
   if (opts.include_schema_info) {
     snapshot_pb->set_type(MetricType::Name(prototype_->type()));
@@ -648,22 +828,25 @@ Status Histogram::GetHistogramSnapshotPB(HistogramSnapshotPB* snapshot_pb,
 }
 
 uint64_t Histogram::CountInBucketForValueForTests(uint64_t value) const {
-  return histogram_->CountInBucketForValue(value);
+  return Snapshot()->CountInBucketForValue(value);
 }
 
 uint64_t Histogram::TotalCount() const {
+  if (striped_histogram_) {
+    return striped_histogram_->TotalCount();
+  }
   return histogram_->TotalCount();
 }
 
 uint64_t Histogram::MinValueForTests() const {
-  return histogram_->MinValue();
+  return Snapshot()->MinValue();
 }
 
 uint64_t Histogram::MaxValueForTests() const {
-  return histogram_->MaxValue();
+  return Snapshot()->MaxValue();
 }
 double Histogram::MeanValueForTests() const {
-  return histogram_->MeanValue();
+  return Snapshot()->MeanValue();
 }
 
 ScopedLatencyMetric::ScopedLatencyMetric(Histogram* latency_hist)
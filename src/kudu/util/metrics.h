@@ -221,9 +221,38 @@
 //      ...
 // ]
 //
+// =================
+// Prometheus output
+// =================
+//
+// Metrics may also be written in the Prometheus text exposition format. Each
+// metric family is named after its metric, with a "kudu_" prefix, and each
+// sample is labeled with the type, ID and attributes of its entity. Gauges
+// and counters are written as such, and histograms as summaries with the
+// same percentiles as in the JSON output.
+//
+// Example Prometheus output:
+//
+// # HELP kudu_log_reader_bytes_read Number of bytes read since tablet start
+// # TYPE kudu_log_reader_bytes_read counter
+// kudu_log_reader_bytes_read{entity_type="tablet",entity_id="e95e...",table_name="my_table"} 0
+// ...
+//
+// =========================
+// Filtering and scalability
+// =========================
+//
+// A server may host thousands of tablets, each with dozens of metrics, so
+// both outputs may be filtered by entity type and metric name prefix, as
+// well as to the metrics which were modified since a given epoch (see
+// Metric::current_epoch()). The registry and entity locks are only held
+// while taking a snapshot of their maps: the values of the metrics are read
+// as they are written out, so that the output may be streamed.
+//
 /////////////////////////////////////////////////////
 
 #include <algorithm>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -240,6 +269,7 @@
 #include "kudu/util/jsonwriter.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/prometheus_writer.h"
 #include "kudu/util/status.h"
 #include "kudu/util/striped64.h"
 
@@ -278,9 +308,9 @@
   ::kudu::GaugePrototype<double> METRIC_##name(                      \
       ::kudu::MetricPrototype::CtorArgs(#entity, #name, label, unit, desc, ## __VA_ARGS__))
 
-#define METRIC_DEFINE_histogram(entity, name, label, unit, desc, max_val, num_sig_digits) \
+#define METRIC_DEFINE_histogram(entity, name, label, unit, desc, max_val, num_sig_digits, ...) \
   ::kudu::HistogramPrototype METRIC_##name(                                       \
-      ::kudu::MetricPrototype::CtorArgs(#entity, #name, label, unit, desc), \
+      ::kudu::MetricPrototype::CtorArgs(#entity, #name, label, unit, desc, ## __VA_ARGS__), \
     max_val, num_sig_digits)
 
 // The following macros act as forward declarations for entity types and metric prototypes.
@@ -338,6 +368,7 @@ class HdrHistogram;
 class Histogram;
 class HistogramPrototype;
 class HistogramSnapshotPB;
+class StripedHdrHistogram;
 
 class MetricEntity;
 
@@ -392,10 +423,12 @@ class MetricType {
   static const char* const kHistogramType;
 };
 
+// Options for writing metrics, either as JSON or in the Prometheus format.
 struct MetricJsonOptions {
   MetricJsonOptions() :
     include_raw_histograms(false),
-    include_schema_info(false) {
+    include_schema_info(false),
+    only_modified_in_or_after_epoch(0) {
   }
 
   // Include the raw histogram values and counts in the JSON output.
@@ -408,6 +441,20 @@ struct MetricJsonOptions {
   // unit, etc).
   // Default: false
   bool include_schema_info;
+
+  // Only include the entities of these types (e.g. "tablet").
+  // Default: empty, i.e. all entity types.
+  std::vector<std::string> entity_types;
+
+  // Only include the metrics whose name starts with one of these prefixes.
+  // Entities without any such metric are left out.
+  // Default: empty, i.e. all metrics.
+  std::vector<std::string> metric_name_prefixes;
+
+  // Only include the metrics which were modified in or after this epoch. See
+  // Metric::current_epoch(). Entities without any such metric are left out.
+  // Default: 0, i.e. all metrics.
+  int64_t only_modified_in_or_after_epoch;
 };
 
 class MetricEntityPrototype {
@@ -459,6 +506,8 @@ class MetricEntity : public RefCountedThreadSafe<MetricEntity> {
 
   const std::string& id() const { return id_; }
 
+  const MetricEntityPrototype& prototype() const { return *prototype_; }
+
   // See MetricRegistry::WriteAsJson()
   Status WriteAsJson(JsonWriter* writer,
                      const std::vector<std::string>& requested_metrics,
@@ -494,10 +543,22 @@ class MetricEntity : public RefCountedThreadSafe<MetricEntity> {
   friend class MetricRegistry;
   friend class RefCountedThreadSafe<MetricEntity>;
 
+  // We want the keys to be in alphabetical order when printing, so we use an ordered map here.
+  typedef std::map<const char*, scoped_refptr<Metric> > OrderedMetricMap;
+
   MetricEntity(const MetricEntityPrototype* prototype, std::string id,
                AttributeMap attributes);
   ~MetricEntity();
 
+  // Snapshot the metrics of this entity which are selected by
+  // 'requested_metrics' and 'opts' (see MetricRegistry::WriteAsJson()), and
+  // its attributes. Returns false if the entity should be left out of the
+  // output altogether.
+  bool GetMetricsAndAttrs(const std::vector<std::string>& requested_metrics,
+                          const MetricJsonOptions& opts,
+                          OrderedMetricMap* metrics,
+                          AttributeMap* attrs) const;
+
   // Ensure that the given metric prototype is allowed to be instantiated
   // within this entity. This entity's type must match the expected entity
   // type defined within the metric prototype.
@@ -526,12 +587,45 @@ class Metric : public RefCountedThreadSafe<Metric> {
   virtual Status WriteAsJson(JsonWriter* writer,
                              const MetricJsonOptions& opts) const = 0;
 
+  // All metrics must be able to render themselves in the Prometheus format,
+  // as samples of the metric family 'name' with the given labels. The header
+  // of the family is written by the caller.
+  virtual void WriteAsPrometheus(PrometheusWriter* writer,
+                                 const std::string& name,
+                                 const std::string& labels) const = 0;
+
   const MetricPrototype* prototype() const { return prototype_; }
 
+  // Return whether this metric was modified in or after the given epoch.
+  virtual bool ModifiedInOrAfterEpoch(int64_t epoch) const {
+    return m_epoch_.Load() >= epoch;
+  }
+
+  // The metrics subsystem divides time in epochs, which are advanced each
+  // time the metrics are scraped, and each metric records the epoch in which
+  // it was last modified. This lets a scraper fetch only the metrics which
+  // were modified since its previous scrape.
+  static int64_t current_epoch() { return g_epoch_.Load(); }
+
+  // Advance to a new epoch, and return the previous one. A scraper which
+  // increments the epoch before dumping the metrics should ask for the
+  // metrics modified in or after the returned epoch on its next scrape: this
+  // may report some unmodified metrics twice, but never misses an update.
+  static int64_t IncrementEpoch() { return g_epoch_.Increment() - 1; }
+
  protected:
   explicit Metric(const MetricPrototype* prototype);
   virtual ~Metric();
 
+  // Record that this metric was modified in the current epoch. Since the
+  // epoch rarely changes, this is usually only a pair of loads.
+  void UpdateModificationEpoch() {
+    int64_t current = current_epoch();
+    if (PREDICT_FALSE(m_epoch_.Load() < current)) {
+      m_epoch_.StoreMax(current);
+    }
+  }
+
   const MetricPrototype* const prototype_;
 
  private:
@@ -543,6 +637,11 @@ class Metric : public RefCountedThreadSafe<Metric> {
   // uninitialized.
   MonoTime retire_time_;
 
+  // The epoch in which this metric was last modified.
+  AtomicInt<int64_t> m_epoch_;
+
+  static AtomicInt<int64_t> g_epoch_;
+
   DISALLOW_COPY_AND_ASSIGN(Metric);
 };
 
@@ -572,6 +671,16 @@ class MetricRegistry {
                      const std::vector<std::string>& requested_metrics,
                      const MetricJsonOptions& opts) const;
 
+  // Writes metrics in this registry to 'writer', in the Prometheus format.
+  //
+  // The metrics are selected as with WriteAsJson(), whose other options are
+  // ignored. Since the samples of each metric must be written together, this
+  // first takes a snapshot of the selected metrics of all entities, whose
+  // values are then read as they are written.
+  Status WriteAsPrometheus(PrometheusWriter* writer,
+                           const std::vector<std::string>& requested_metrics,
+                           const MetricJsonOptions& opts) const;
+
   // For each registered entity, retires orphaned metrics. If an entity has no more
   // metrics and there are no external references, entities are removed as well.
   //
@@ -636,7 +745,17 @@ class MetricPrototypeRegistry {
 enum PrototypeFlags {
   // Flag which causes a Gauge prototype to expose itself as if it
   // were a counter.
-  EXPOSE_AS_COUNTER = 1 << 0
+  EXPOSE_AS_COUNTER = 1 << 0,
+
+  // Flag which causes a Histogram prototype to record its values in
+  // per-CPU stripes, which are merged when the histogram is read. This
+  // makes concurrent updates much cheaper, at the cost of up to
+  // --metrics_histogram_max_stripes times the memory. Use it for histograms
+  // which are updated by many threads on every operation, such as RPC
+  // handler latencies, and only for those with one instance per server:
+  // the cost of a striped per-tablet histogram grows with the number of
+  // tablets. See StripedHdrHistogram.
+  STRIPED_HISTOGRAM = 1 << 1
 };
 
 class MetricPrototype {
@@ -744,6 +863,9 @@ class StringGauge : public Gauge {
               std::string initial_value);
   std::string value() const;
   void set_value(const std::string& value);
+  virtual void WriteAsPrometheus(PrometheusWriter* writer,
+                                 const std::string& name,
+                                 const std::string& labels) const OVERRIDE;
  protected:
   virtual void WriteValue(JsonWriter* writer) const OVERRIDE;
  private:
@@ -764,12 +886,15 @@ class AtomicGauge : public Gauge {
     return static_cast<T>(value_.Load(kMemOrderRelease));
   }
   virtual void set_value(const T& value) {
+    UpdateModificationEpoch();
     value_.Store(static_cast<int64_t>(value), kMemOrderNoBarrier);
   }
   void Increment() {
+    UpdateModificationEpoch();
     value_.IncrementBy(1, kMemOrderNoBarrier);
   }
   virtual void IncrementBy(int64_t amount) {
+    UpdateModificationEpoch();
     value_.IncrementBy(amount, kMemOrderNoBarrier);
   }
   void Decrement() {
@@ -778,6 +903,11 @@ class AtomicGauge : public Gauge {
   void DecrementBy(int64_t amount) {
     IncrementBy(-amount);
   }
+  virtual void WriteAsPrometheus(PrometheusWriter* writer,
+                                 const std::string& name,
+                                 const std::string& labels) const OVERRIDE {
+    writer->WriteSample(name, labels, value());
+  }
 
  protected:
   virtual void WriteValue(JsonWriter* writer) const OVERRIDE {
@@ -858,6 +988,18 @@ class FunctionGauge : public Gauge {
     writer->Value(value());
   }
 
+  virtual void WriteAsPrometheus(PrometheusWriter* writer,
+                                 const std::string& name,
+                                 const std::string& labels) const OVERRIDE {
+    writer->WriteSample(name, labels, value());
+  }
+
+  // The value of a FunctionGauge is computed when it is read, so it can't
+  // tell whether it was modified.
+  virtual bool ModifiedInOrAfterEpoch(int64_t epoch) const OVERRIDE {
+    return true;
+  }
+
   // Reset this FunctionGauge to return a specific value.
   // This should be used during destruction. If you want a settable
   // Gauge, use a normal Gauge instead of a FunctionGauge.
@@ -936,6 +1078,9 @@ class Counter : public Metric {
   void IncrementBy(int64_t amount);
   virtual Status WriteAsJson(JsonWriter* w,
                              const MetricJsonOptions& opts) const OVERRIDE;
+  virtual void WriteAsPrometheus(PrometheusWriter* writer,
+                                 const std::string& name,
+                                 const std::string& labels) const OVERRIDE;
 
  private:
   FRIEND_TEST(MetricsTest, SimpleCounterTest);
@@ -956,6 +1101,7 @@ class HistogramPrototype : public MetricPrototype {
 
   uint64_t max_trackable_value() const { return max_trackable_value_; }
   int num_sig_digits() const { return num_sig_digits_; }
+  bool striped() const { return args_.flags_ & STRIPED_HISTOGRAM; }
   virtual MetricType::Type type() const OVERRIDE { return MetricType::kHistogram; }
 
  private:
@@ -981,6 +1127,12 @@ class Histogram : public Metric {
   virtual Status WriteAsJson(JsonWriter* w,
                              const MetricJsonOptions& opts) const OVERRIDE;
 
+  // Writes this histogram as a summary, with the same percentiles as the
+  // JSON output.
+  virtual void WriteAsPrometheus(PrometheusWriter* writer,
+                                 const std::string& name,
+                                 const std::string& labels) const OVERRIDE;
+
   // Returns a snapshot of this histogram including the bucketed values and counts.
   Status GetHistogramSnapshotPB(HistogramSnapshotPB* snapshot,
                                 const MetricJsonOptions& opts) const;
@@ -992,10 +1144,17 @@ class Histogram : public Metric {
 
  private:
   FRIEND_TEST(MetricsTest, SimpleHistogramTest);
+  FRIEND_TEST(MetricsTest, StripedHistogramTest);
   friend class MetricEntity;
   explicit Histogram(const HistogramPrototype* proto);
 
+  // Return a (non-consistent) snapshot of the recorded values.
+  gscoped_ptr<HdrHistogram> Snapshot() const;
+
+  // Exactly one of these is set, depending on whether the prototype is
+  // striped.
   const gscoped_ptr<HdrHistogram> histogram_;
+  const gscoped_ptr<StripedHdrHistogram> striped_histogram_;
   DISALLOW_COPY_AND_ASSIGN(Histogram);
 };
 
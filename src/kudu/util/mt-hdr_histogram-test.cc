@@ -23,6 +23,7 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/hdr_histogram.h"
 #include "kudu/util/status.h"
+#include "kudu/util/stopwatch.h"
 #include "kudu/util/test_util.h"
 #include "kudu/util/thread.h"
 
@@ -48,12 +49,26 @@ class MtHdrHistogramTest : public KuduTest {
 };
 
 // Increment a counter a bunch of times in the same bucket
-static void IncrementSameHistValue(HdrHistogram* hist, uint64_t value, uint64_t times) {
+template<class HistogramType>
+static void IncrementSameHistValue(HistogramType* hist, uint64_t value, uint64_t times) {
   for (uint64_t i = 0; i < times; i++) {
     hist->Increment(value);
   }
 }
 
+// Run 'num_threads' threads which each increment 'hist' 'times' times.
+template<class HistogramType>
+static void RunConcurrentIncrements(HistogramType* hist, int num_threads, uint64_t times) {
+  vector<scoped_refptr<kudu::Thread>> threads(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    CHECK_OK(kudu::Thread::Create("test", strings::Substitute("thread-$0", i),
+        IncrementSameHistValue<HistogramType>, hist, 1LU, times, &threads[i]));
+  }
+  for (int i = 0; i < num_threads; i++) {
+    CHECK_OK(ThreadJoiner(threads[i].get()).Join());
+  }
+}
+
 TEST_F(MtHdrHistogramTest, ConcurrentWriteTest) {
   const uint64_t kValue = 1LU;
 
@@ -62,7 +77,7 @@ TEST_F(MtHdrHistogramTest, ConcurrentWriteTest) {
   auto threads = new scoped_refptr<kudu::Thread>[num_threads_];
   for (int i = 0; i < num_threads_; i++) {
     CHECK_OK(kudu::Thread::Create("test", strings::Substitute("thread-$0", i),
-        IncrementSameHistValue, &hist, kValue, num_times_, &threads[i]));
+        IncrementSameHistValue<HdrHistogram>, &hist, kValue, num_times_, &threads[i]));
   }
   for (int i = 0; i < num_threads_; i++) {
     CHECK_OK(ThreadJoiner(threads[i].get()).Join());
@@ -84,7 +99,7 @@ TEST_F(MtHdrHistogramTest, ConcurrentCopyWhileWritingTest) {
   auto threads = new scoped_refptr<kudu::Thread>[num_threads_];
   for (int i = 0; i < num_threads_; i++) {
     CHECK_OK(kudu::Thread::Create("test", strings::Substitute("thread-$0", i),
-        IncrementSameHistValue, &hist, kValue, num_times_, &threads[i]));
+        IncrementSameHistValue<HdrHistogram>, &hist, kValue, num_times_, &threads[i]));
   }
 
   // This is somewhat racy but the goal is to catch this issue at least
@@ -108,4 +123,41 @@ TEST_F(MtHdrHistogramTest, ConcurrentCopyWhileWritingTest) {
   delete[] threads;
 }
 
+TEST_F(MtHdrHistogramTest, ConcurrentStripedWriteTest) {
+  const uint64_t kValue = 1LU;
+
+  StripedHdrHistogram hist(100000LU, 3, 4);
+  RunConcurrentIncrements(&hist, num_threads_, num_times_);
+  ASSERT_EQ(num_threads_ * num_times_, hist.TotalCount());
+
+  HdrHistogram snapshot(100000LU, 3);
+  hist.MergeInto(&snapshot);
+  ASSERT_EQ(num_threads_ * num_times_, snapshot.CountInBucketForValue(kValue));
+  ASSERT_EQ(num_threads_ * num_times_, snapshot.TotalSum());
+  ASSERT_EQ(kValue, snapshot.MinValue());
+  ASSERT_EQ(kValue, snapshot.MaxValue());
+}
+
+// Compare the cost of concurrent updates of a single histogram and of a
+// striped one, with increasing numbers of threads.
+TEST_F(MtHdrHistogramTest, BenchmarkConcurrentIncrements) {
+  for (int num_threads = 1; num_threads <= num_threads_; num_threads *= 2) {
+    {
+      HdrHistogram hist(60000000LU, 2);
+      LOG_TIMING(INFO, strings::Substitute("$0 threads incrementing a histogram",
+                                           num_threads)) {
+        RunConcurrentIncrements(&hist, num_threads, num_times_);
+      }
+    }
+    {
+      StripedHdrHistogram hist(60000000LU, 2, num_threads);
+      LOG_TIMING(INFO, strings::Substitute("$0 threads incrementing a histogram with $1 stripes",
+                                           num_threads, hist.num_stripes())) {
+        RunConcurrentIncrements(&hist, num_threads, num_times_);
+      }
+      ASSERT_EQ(num_threads * num_times_, hist.TotalCount());
+    }
+  }
+}
+
 } // namespace kudu
@@ -202,6 +202,7 @@ class NvmLRUCache {
   Cache::Handle* Lookup(const Slice& key, uint32_t hash, bool caching);
   void Release(Cache::Handle* handle);
   void Erase(const Slice& key, uint32_t hash);
+  void GetRecentlyUsedEntries(size_t max_entries, vector<Cache::EntryInfo>* entries);
   void* AllocateAndRetry(size_t size);
 
  private:
@@ -450,6 +451,15 @@ void NvmLRUCache::Erase(const Slice& key, uint32_t hash) {
     FreeEntry(e);
   }
 }
+void NvmLRUCache::GetRecentlyUsedEntries(size_t max_entries,
+                                         vector<Cache::EntryInfo>* entries) {
+  lock_guard<MutexType> l(&mutex_);
+  for (LRUHandle* e = lru_.prev; e != &lru_ && max_entries > 0; e = e->prev) {
+    entries->push_back({ e->key().ToString(), e->val_length, Cache::NORMAL_PRIORITY });
+    max_entries--;
+  }
+}
+
 static const int kNumShardBits = 4;
 static const int kNumShards = 1 << kNumShardBits;
 
@@ -491,8 +501,11 @@ class ShardedLRUCache : public Cache {
     vmem_delete(vmp_);
   }
 
+  // The NVM cache does not have a high-priority pool: all entries share one
+  // LRU list regardless of 'priority'.
   virtual Handle* Insert(PendingHandle* handle,
-                         Cache::EvictionCallback* eviction_callback) OVERRIDE {
+                         Cache::EvictionCallback* eviction_callback,
+                         Cache::Priority /* priority */) OVERRIDE {
     LRUHandle* h = reinterpret_cast<LRUHandle*>(DCHECK_NOTNULL(handle));
     return shards_[Shard(h->hash)]->Insert(h, eviction_callback);
   }
@@ -525,6 +538,29 @@ class ShardedLRUCache : public Cache {
       cache->SetMetrics(metrics_.get());
     }
   }
+
+  virtual void GetRecentlyUsedEntries(size_t max_entries,
+                                      vector<EntryInfo>* entries) OVERRIDE {
+    const size_t per_shard = (max_entries + (kNumShards - 1)) / kNumShards;
+    vector<vector<EntryInfo> > shard_entries(shards_.size());
+    for (int s = 0; s < shards_.size(); s++) {
+      shards_[s]->GetRecentlyUsedEntries(per_shard, &shard_entries[s]);
+    }
+    // Interleave the shards so that each shard's most recently used entries
+    // come before the others.
+    size_t num_added = 0;
+    for (size_t i = 0; i < per_shard; i++) {
+      for (vector<EntryInfo>& shard : shard_entries) {
+        if (num_added == max_entries) {
+          return;
+        }
+        if (i < shard.size()) {
+          entries->push_back(std::move(shard[i]));
+          num_added++;
+        }
+      }
+    }
+  }
   virtual PendingHandle* Allocate(Slice key, int val_len, int charge) OVERRIDE {
     int key_len = key.size();
     DCHECK_GE(key_len, 0);
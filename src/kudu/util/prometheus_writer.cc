@@ -0,0 +1,98 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#include "kudu/util/prometheus_writer.h"
+
+#include <cmath>
+#include <ostream>
+
+#include <glog/logging.h>
+
+#include "kudu/gutil/strings/ascii_ctype.h"
+#include "kudu/gutil/strings/numbers.h"
+
+using std::string;
+
+namespace kudu {
+
+namespace {
+
+// Escape the backslashes and line feeds of 'str', as well as its double
+// quotes if 'escape_quotes' is set.
+string Escape(const string& str, bool escape_quotes) {
+  string escaped;
+  escaped.reserve(str.size());
+  for (char c : str) {
+    switch (c) {
+      case '\\':
+        escaped.append("\\\\");
+        break;
+      case '\n':
+        escaped.append("\\n");
+        break;
+      case '"':
+        escaped.append(escape_quotes ? "\\\"" : "\"");
+        break;
+      default:
+        escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+} // anonymous namespace
+
+PrometheusWriter::PrometheusWriter(std::ostream* out)
+  : out_(DCHECK_NOTNULL(out)) {
+}
+
+void PrometheusWriter::WriteFamilyHeader(const string& name, const char* type,
+                                         const string& help) {
+  *out_ << "# HELP " << name << " " << Escape(help, false) << "\n";
+  *out_ << "# TYPE " << name << " " << type << "\n";
+}
+
+void PrometheusWriter::WriteSample(const string& name, const string& labels, double value) {
+  *out_ << name;
+  if (!labels.empty()) {
+    *out_ << "{" << labels << "}";
+  }
+  *out_ << " ";
+  if (std::isnan(value)) {
+    *out_ << "NaN";
+  } else if (std::isinf(value)) {
+    *out_ << (value > 0 ? "+Inf" : "-Inf");
+  } else {
+    *out_ << SimpleDtoa(value);
+  }
+  *out_ << "\n";
+}
+
+void PrometheusWriter::AppendLabel(const string& key, const string& value, string* labels) {
+  if (!labels->empty()) {
+    labels->push_back(',');
+  }
+  for (size_t i = 0; i < key.size(); i++) {
+    char c = key[i];
+    bool valid = ascii_isalpha(c) || c == '_' || (i > 0 && ascii_isdigit(c));
+    labels->push_back(valid ? c : '_');
+  }
+  labels->append("=\"");
+  labels->append(Escape(value, true));
+  labels->push_back('"');
+}
+
+} // namespace kudu
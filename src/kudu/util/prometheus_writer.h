@@ -0,0 +1,60 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_UTIL_PROMETHEUS_WRITER_H
+#define KUDU_UTIL_PROMETHEUS_WRITER_H
+
+#include <iosfwd>
+#include <string>
+
+#include "kudu/gutil/macros.h"
+
+namespace kudu {
+
+// Writes metrics in the Prometheus text exposition format (version 0.0.4).
+// See https://prometheus.io/docs/instrumenting/exposition_formats/
+//
+// Each metric family starts with a header describing it, followed by all of
+// its samples: the samples of a family must not be interleaved with those of
+// other families.
+class PrometheusWriter {
+ public:
+  explicit PrometheusWriter(std::ostream* out);
+
+  // Writes the HELP and TYPE lines of the metric family 'name'. 'type' is
+  // one of "counter", "gauge", "summary" or "untyped".
+  void WriteFamilyHeader(const std::string& name, const char* type,
+                         const std::string& help);
+
+  // Writes a sample of the metric 'name'. 'labels' is a comma-separated list
+  // of labels built with AppendLabel(), and may be empty.
+  void WriteSample(const std::string& name, const std::string& labels, double value);
+
+  // Appends the label 'key' with the given value to 'labels'. Characters of
+  // the key which aren't allowed in label names are replaced by underscores,
+  // and the value is escaped.
+  static void AppendLabel(const std::string& key, const std::string& value,
+                          std::string* labels);
+
+ private:
+  std::ostream* const out_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrometheusWriter);
+};
+
+} // namespace kudu
+
+#endif // KUDU_UTIL_PROMETHEUS_WRITER_H
@@ -18,6 +18,7 @@
 #define KUDU_UTIL_WEB_CALLBACK_REGISTRY_H
 
 #include <boost/function.hpp>
+#include <iosfwd>
 #include <map>
 #include <string>
 
@@ -45,6 +46,11 @@ class WebCallbackRegistry {
   typedef boost::function<void (const WebRequest& args, std::stringstream* output)>
       PathHandlerCallback;
 
+  // Callback for pages whose output is sent to the client as it is written,
+  // rather than buffered in its entirety first.
+  typedef boost::function<void (const WebRequest& args, std::ostream* output)>
+      StreamingPathHandlerCallback;
+
   virtual ~WebCallbackRegistry() {}
 
   // Register a callback for a URL path. Path should not include the
@@ -59,6 +65,13 @@ class WebCallbackRegistry {
   virtual void RegisterPathHandler(const std::string& path, const std::string& alias,
                                    const PathHandlerCallback& callback,
                                    bool is_styled = true, bool is_on_nav_bar = true) = 0;
+
+  // Register a callback for a URL path whose output may be too large to be
+  // buffered, such as the metrics of a server with many tablets. The page is
+  // never styled, and there can be only one such callback for a given path.
+  virtual void RegisterStreamingPathHandler(const std::string& path, const std::string& alias,
+                                            const StreamingPathHandlerCallback& callback,
+                                            bool is_on_nav_bar) = 0;
 };
 
 } // namespace kudu